@@ -9,12 +9,23 @@ import json
 import asyncio
 import signal
 import logging
-from typing import Dict, List, Optional, Any
+import errno
+import fcntl
+import inspect
+import mmap
+import select
+import socket
+import struct
+from collections import namedtuple
+from typing import Callable, Dict, List, Optional, Any
 from pathlib import Path
 from datetime import datetime
 import threading
 import time
 
+# Boot-to-usable is measured from here
+_PROCESS_START = time.monotonic()
+
 # Safe imports with graceful fallback
 def safe_import(module_path, component_name):
     """Safely import a module, returning None if it fails"""
@@ -26,24 +37,924 @@ def safe_import(module_path, component_name):
         logging.warning(f"Optional component '{module_path}' not available: {e}")
         return None
 
-# Try to import Aurora OS components (graceful fallback)
-initialize_ai_system = safe_import('ai_assistant.core.local_llm_engine', 'initialize_ai_system')
-get_llm_engine = safe_import('ai_assistant.core.local_llm_engine', 'get_llm_engine')
-get_taskbar_assistant = safe_import('ai_assistant.ui.taskbar_assistant', 'get_taskbar_assistant')
-initialize_voice_system = safe_import('ai_assistant.voice.voice_interface', 'initialize_voice_system')
-TaskAgent = safe_import('ai_assistant.agents.task_agent', 'TaskAgent')
+class LazyImport:
+    """
+    A safe_import() deferred until first use, so importing this file does
+    not pull in model runtimes. resolve() imports once and caches the
+    target, or None; it is safe to call from executor threads.
+    """
+    
+    def __init__(self, module_path, component_name):
+        self.module_path = module_path
+        self.component_name = component_name
+        self._lock = threading.Lock()
+        self._resolved = False
+        self._target = None
+    
+    def resolve(self):
+        with self._lock:
+            if not self._resolved:
+                self._target = safe_import(self.module_path, self.component_name)
+                self._resolved = True
+            return self._target
+    
+    def __call__(self, *args, **kwargs):
+        target = self.resolve()
+        if target is None:
+            raise RuntimeError(f"{self.module_path}.{self.component_name} is not available")
+        return target(*args, **kwargs)
+
+# Aurora OS components, imported on first use (graceful fallback)
+initialize_ai_system = LazyImport('ai_assistant.core.local_llm_engine', 'initialize_ai_system')
+get_llm_engine = LazyImport('ai_assistant.core.local_llm_engine', 'get_llm_engine')
+get_taskbar_assistant = LazyImport('ai_assistant.ui.taskbar_assistant', 'get_taskbar_assistant')
+initialize_voice_system = LazyImport('ai_assistant.voice.voice_interface', 'initialize_voice_system')
+TaskAgent = LazyImport('ai_assistant.agents.task_agent', 'TaskAgent')
+
+initialize_driver_system = LazyImport('system.hardware.driver_manager', 'initialize_driver_system')
+get_driver_manager = LazyImport('system.hardware.driver_manager', 'get_driver_manager')
+get_intent_engine = LazyImport('system.settings.intent_settings', 'get_intent_engine')
+show_settings = LazyImport('system.settings.settings_ui', 'show_settings')
+
+initialize_nix_system = LazyImport('system.advanced.nix_integration', 'initialize_nix_system')
+get_nix_integration = LazyImport('system.advanced.nix_integration', 'get_nix_integration')
+initialize_ebpf_system = LazyImport('system.advanced.ebpf_integration', 'initialize_ebpf_system')
+get_ebpf_integration = LazyImport('system.advanced.ebpf_integration', 'get_ebpf_integration')
+
+launch_browser = LazyImport('applications.aurora_browser.browser', 'launch_browser')
+
+class BootProfile:
+    """
+    Daemon phase marks for tools/boot_profile.py, on when the kernel was
+    booted with aurora.boot_profile. Marks go to /dev/kmsg so they land on
+    the kernel's clock next to the initcall_debug lines; times are
+    CLOCK_MONOTONIC seconds, which printk timestamps track. Once the
+    daemon is usable, dump() copies the profile lines of the kernel log
+    to the console, so the boot itself can run with a quiet console.
+    """
+    
+    PARAM = "aurora.boot_profile"
+    DUMP_BEGIN = "=== aurora boot profile begin ==="
+    DUMP_END = "=== aurora boot profile end ==="
+    # Kernel log lines the profiler reads; the rest would only slow the dump
+    DUMP_PREFIXES = ("initcall ", "Run ", "aurora_boot: ")
+    
+    def __init__(self):
+        try:
+            self.enabled = self.PARAM in Path("/proc/cmdline").read_text().split()
+        except OSError:
+            self.enabled = False
+    
+    @staticmethod
+    def process_start() -> float:
+        """When the kernel started this process, on the monotonic clock"""
+        try:
+            stat = Path("/proc/self/stat").read_text()
+            ticks = int(stat.rsplit(")", 1)[1].split()[19])
+            return ticks / os.sysconf("SC_CLK_TCK")
+        except (OSError, ValueError, IndexError):
+            return _PROCESS_START
+    
+    def mark(self, phase: str, start: float, end: float):
+        if not self.enabled:
+            return
+        try:
+            with open("/dev/kmsg", "w") as kmsg:
+                kmsg.write(f"aurora_boot: phase={phase} start={start:.6f} end={end:.6f}\n")
+        except OSError:
+            pass
+    
+    def dump(self):
+        """Copy the profile lines of the kernel log to the console; blocking"""
+        if not self.enabled:
+            return
+        try:
+            fd = os.open("/dev/kmsg", os.O_RDONLY | os.O_NONBLOCK)
+        except OSError:
+            return
+        lines = [self.DUMP_BEGIN]
+        try:
+            while True:
+                try:
+                    record = os.read(fd, 8192).decode(errors="replace")
+                except BlockingIOError:
+                    break
+                except OSError as e:
+                    # Overwritten records; reading carries on after them
+                    if e.errno == errno.EPIPE:
+                        continue
+                    break
+                header, _, message = record.partition(";")
+                message = message.split("\n", 1)[0]
+                if message.startswith(self.DUMP_PREFIXES):
+                    lines.append(f"{header};{message}")
+        finally:
+            os.close(fd)
+        lines.append(self.DUMP_END)
+        try:
+            with open("/dev/console", "w") as console:
+                console.write("\n".join(lines) + "\n")
+        except OSError:
+            pass
+
+class PerfLab:
+    """
+    Guest side of tools/perf_lab.sh, on when the kernel was booted with
+    aurora.perf_lab. Once the daemon is usable, run() dumps the boot
+    profile and then runs the lab's suites from the host's 9p share; the
+    suites power the VM off when they are done.
+    """
+    
+    PARAM = "aurora.perf_lab"
+    MOUNT_TAG = "aurora_perf_lab"
+    MOUNT_POINT = "/run/aurora-perf-lab"
+    
+    def __init__(self):
+        try:
+            args = Path("/proc/cmdline").read_text().split()
+            self.enabled = any(arg.split("=", 1)[0] == self.PARAM for arg in args)
+        except OSError:
+            self.enabled = False
+    
+    def run(self, boot_profile: BootProfile):
+        """Dump the boot profile, then run the suites; blocking"""
+        import subprocess
+        boot_profile.dump()
+        try:
+            os.makedirs(self.MOUNT_POINT, exist_ok=True)
+            subprocess.run(["mount", "-t", "9p", "-o", "trans=virtio,version=9p2000.L,msize=1048576",
+                            self.MOUNT_TAG, self.MOUNT_POINT], check=True)
+            subprocess.run(["/bin/sh", f"{self.MOUNT_POINT}/perf_lab_guest.sh", self.MOUNT_POINT])
+        except (OSError, subprocess.CalledProcessError):
+            # Nothing to run; the host gives up at its timeout
+            pass
+
+class ComponentSpec:
+    """
+    A daemon component: the entry point that builds it, the attribute of
+    AuroraOS it lands in, the components it needs first, the config switch
+    that enables it, and whether it waits for first use. Entry points that
+    return a tuple put the component first.
+    """
+    
+    def __init__(self, name: str, label: str, entry: LazyImport, depends: tuple = (),
+                 enabled: Optional[tuple] = None, lazy: bool = False):
+        self.name = name
+        self.label = label
+        self.entry = entry
+        self.depends = depends
+        self.enabled = enabled      # (config section, key), or None for always
+        self.lazy = lazy
+
+class ComponentLoader:
+    """
+    Initialises components concurrently, each as soon as its dependencies
+    are up. Eager components are loaded by load_eager(); lazy ones on the
+    first get(), or by prefetch() once the daemon is usable. Imports run in
+    the default executor, so a slow import does not stall the loop. A
+    component that fails to load is logged and left None; its dependents
+    still load without it.
+    """
+    
+    def __init__(self, owner, specs: tuple, config: Dict[str, Any], logger: logging.Logger):
+        self.owner = owner
+        self.specs = {spec.name: spec for spec in specs}
+        self.config = config
+        self.logger = logger
+        self.timings: Dict[str, float] = {}     # Seconds, per loaded component
+        self._tasks: Dict[str, asyncio.Task] = {}
+    
+    def is_enabled(self, name: str) -> bool:
+        spec = self.specs[name]
+        if spec.enabled is None:
+            return True
+        section, key = spec.enabled
+        return bool(self.config.get(section, {}).get(key, False))
+    
+    def _ensure(self, name: str) -> asyncio.Task:
+        task = self._tasks.get(name)
+        if task is None:
+            task = asyncio.get_running_loop().create_task(self._load(self.specs[name]))
+            self._tasks[name] = task
+        return task
+    
+    async def load_eager(self):
+        names = [name for name, spec in self.specs.items()
+                 if not spec.lazy and self.is_enabled(name)]
+        await asyncio.gather(*(self._ensure(name) for name in names))
+    
+    def prefetch(self):
+        """Start loading the lazy components in the background"""
+        for name, spec in self.specs.items():
+            if spec.lazy and self.is_enabled(name):
+                self._ensure(name)
+    
+    async def get(self, name: str):
+        """The component, loading it now if this is its first use"""
+        if not self.is_enabled(name):
+            return None
+        # Shielded: a cancelled caller must not cancel a load others wait on
+        return await asyncio.shield(self._ensure(name))
+    
+    @property
+    def pending(self) -> List[str]:
+        return [name for name in self.specs
+                if self.is_enabled(name) and not (name in self._tasks and self._tasks[name].done())]
+    
+    async def _load(self, spec: ComponentSpec):
+        for dep in spec.depends:
+            if self.is_enabled(dep):
+                await self._ensure(dep)
+        
+        start = time.monotonic()
+        try:
+            factory = await asyncio.get_running_loop().run_in_executor(None, spec.entry.resolve)
+            if factory is None:
+                return None
+            
+            self.logger.info(f"{spec.label}: initializing...")
+            result = factory()
+            if inspect.isawaitable(result):
+                result = await result
+        except Exception as e:
+            self.logger.error(f"❌ {spec.label} failed to initialize: {e}")
+            return None
+        
+        component = result[0] if isinstance(result, tuple) else result
+        setattr(self.owner, spec.name, component)
+        end = time.monotonic()
+        self.timings[spec.name] = end - start
+        self.owner.boot_profile.mark(f"component:{spec.name}", start, end)
+        self.logger.info(f"{spec.label}: ready in {self.timings[spec.name] * 1000:.0f} ms")
+        
+        self.owner._on_component_ready(spec.name, result)
+        return component
+
+TelemetryRecord = namedtuple('TelemetryRecord', 'timestamp_ns type cpu pid arg data')
+
+class KernelEventSource:
+    """
+    Kernel events for the daemon's asyncio loop, gathered in one epoll set:
+    the AI modules' per-CPU telemetry rings (/dev/aurora_telemetry) and PSI
+    pressure triggers, system-wide (/proc/pressure/*) and per cgroup
+    (/sys/fs/cgroup/<path>/*.pressure). The epoll fd itself is watched by
+    the loop, so handlers run the moment the kernel signals and nothing here
+    ever blocks the loop. Either source may be missing; the other still works.
+    """
+    
+    TELEMETRY_DEVICE = "/dev/aurora_telemetry"
+    TELEMETRY_VERSION = 1
+    # struct aurora_telemetry_info, and _IOR(0xA7, 1, struct aurora_telemetry_info)
+    INFO_FORMAT = "=6I2Q"
+    TELEMETRY_IOC_INFO = (2 << 30) | (struct.calcsize("=6I2Q") << 16) | (0xA7 << 8) | 1
+    # struct aurora_telemetry_record
+    RECORD_FORMAT = "=QHHIiI5Q"
+    SCHED_PICK, CONTEXT_LEARN, SECURITY_VERDICT = 1, 2, 3
+    RECORD_TYPES = {SCHED_PICK: "sched_pick", CONTEXT_LEARN: "context_learn",
+                    SECURITY_VERDICT: "security_verdict"}
+    # Records taken from one ring per wakeup; epoll is level-triggered, so the rest follow
+    DRAIN_BUDGET = 4096
+    
+    PSI_RESOURCES = ("cpu", "memory", "io")
+    CGROUP_ROOT = "/sys/fs/cgroup"
+    # Stall shares are in hundredths of a percent, as the kernel control plane takes them
+    PSI_FULL = 10000
+    # A pressured resource is resampled every window until its share drops below this
+    PSI_RELIEF_SHARE = 100
+    
+    def __init__(self, logger: logging.Logger, psi_stall_us: int = 150000,
+                 psi_window_us: int = 1000000, cgroups: Optional[List[str]] = None):
+        self.logger = logger
+        self.psi_stall_us = psi_stall_us
+        self.psi_window_us = psi_window_us
+        # "" is the whole system; other entries are paths below CGROUP_ROOT
+        self.cgroups = cgroups if cgroups is not None else [""]
+        
+        # Called on the loop with a list of TelemetryRecord, and for pressure with
+        # (cgroup, cgroup id, resource, stall share, parsed pressure file)
+        self.on_telemetry: Optional[Callable[[List[TelemetryRecord]], None]] = None
+        self.on_pressure: Optional[Callable[[str, int, str, int, Dict], None]] = None
+        
+        self._loop = None
+        self._epoll = None
+        self._handlers: Dict[int, Callable[[int], None]] = {}
+        self._telemetry_fd = None
+        self._rings = []
+        self._psi_fds: Dict[int, Dict[str, Any]] = {}
+        self._record_size = struct.calcsize(self.RECORD_FORMAT)
+        self._ring_mask = 0
+    
+    def start(self, loop: asyncio.AbstractEventLoop) -> bool:
+        """Arm every available source; returns False if there are none"""
+        self._loop = loop
+        self._epoll = select.epoll()
+        self._open_telemetry()
+        self._open_psi()
+        
+        if not self._handlers:
+            self._epoll.close()
+            self._epoll = None
+            return False
+        
+        loop.add_reader(self._epoll.fileno(), self._dispatch)
+        return True
+    
+    def close(self):
+        if self._epoll is None:
+            return
+        
+        self._loop.remove_reader(self._epoll.fileno())
+        for fd in list(self._handlers):
+            self._unregister(fd)
+        for consumer, data, _ in self._rings:
+            consumer.close()
+            data.close()
+        self._rings = []
+        self._epoll.close()
+        self._epoll = None
+    
+    @property
+    def sources(self) -> List[str]:
+        names = [f"{t['resource']}@{t['cgroup'] or 'system'}" for t in self._psi_fds.values()]
+        if self._telemetry_fd is not None:
+            names.insert(0, "telemetry")
+        return names
+    
+    def _register(self, fd: int, mask: int, handler: Callable[[int], None]):
+        self._epoll.register(fd, mask)
+        self._handlers[fd] = handler
+    
+    def _unregister(self, fd: int):
+        self._handlers.pop(fd, None)
+        trigger = self._psi_fds.pop(fd, None)
+        if trigger and trigger["timer"]:
+            trigger["timer"].cancel()
+        if fd == self._telemetry_fd:
+            self._telemetry_fd = None
+        try:
+            self._epoll.unregister(fd)
+        except OSError:
+            pass
+        os.close(fd)
+    
+    def _dispatch(self):
+        """The epoll fd is readable: run the handlers of the ready sources"""
+        for fd, events in self._epoll.poll(0):
+            handler = self._handlers.get(fd)
+            if handler:
+                handler(events)
+    
+    # Telemetry rings
+    
+    def _open_telemetry(self):
+        try:
+            fd = os.open(self.TELEMETRY_DEVICE, os.O_RDONLY | os.O_NONBLOCK | os.O_CLOEXEC)
+        except OSError as e:
+            self.logger.info(f"Kernel telemetry unavailable: {e}")
+            return
+        
+        try:
+            info = bytearray(struct.calcsize(self.INFO_FORMAT))
+            fcntl.ioctl(fd, self.TELEMETRY_IOC_INFO, info)
+            version, record_size, nr_cpus, nr_records, ring_pages, page_size, _, _ = \
+                struct.unpack(self.INFO_FORMAT, info)
+            if version != self.TELEMETRY_VERSION or record_size != self._record_size:
+                raise OSError(errno.EPROTO, f"telemetry ABI {version}/{record_size} not supported")
+            
+            # Consumer page read-write, producer page and records read-only
+            for cpu in range(nr_cpus):
+                base = cpu * ring_pages * page_size
+                try:
+                    consumer = mmap.mmap(fd, page_size, mmap.MAP_SHARED,
+                                         mmap.PROT_READ | mmap.PROT_WRITE, offset=base)
+                except OSError as e:
+                    if e.errno == errno.ENXIO:
+                        continue    # Not a possible CPU
+                    raise
+                data = mmap.mmap(fd, (ring_pages - 1) * page_size, mmap.MAP_SHARED,
+                                 mmap.PROT_READ, offset=base + page_size)
+                cons, = struct.unpack_from("=Q", consumer, 0)
+                self._rings.append([consumer, data, cons])
+            
+            self._ring_mask = nr_records - 1
+            self._records_offset = page_size
+        except OSError as e:
+            self.logger.warning(f"Kernel telemetry unusable: {e}")
+            for consumer, data, _ in self._rings:
+                consumer.close()
+                data.close()
+            self._rings = []
+            os.close(fd)
+            return
+        
+        self._telemetry_fd = fd
+        self._register(fd, select.EPOLLIN, self._drain_telemetry)
+    
+    def _drain_telemetry(self, events: int):
+        records = []
+        
+        for ring in self._rings:
+            consumer, data, cons = ring
+            prod, = struct.unpack_from("=Q", data, 0)
+            end = min(prod, cons + self.DRAIN_BUDGET)
+            while cons != end:
+                off = self._records_offset + (cons & self._ring_mask) * self._record_size
+                fields = struct.unpack_from(self.RECORD_FORMAT, data, off)
+                records.append(TelemetryRecord(fields[0], fields[1], fields[3], fields[4],
+                                               fields[5], fields[6:]))
+                cons += 1
+            
+            # Hand the slots back to the producer
+            struct.pack_into("=Q", consumer, 0, cons)
+            ring[2] = cons
+        
+        if records and self.on_telemetry:
+            self.on_telemetry(records)
+    
+    def dropped(self) -> int:
+        """Records lost to full rings since the modules loaded"""
+        return sum(struct.unpack_from("=Q", data, 8)[0] for _, data, _ in self._rings)
+    
+    # PSI triggers
+    
+    def _open_psi(self):
+        trigger = f"some {self.psi_stall_us} {self.psi_window_us}".encode() + b"\0"
+        
+        for cgroup in self.cgroups:
+            # The kernel knows a cgroup by the inode number of its directory
+            if cgroup:
+                directory = os.path.join(self.CGROUP_ROOT, cgroup.strip("/"))
+                try:
+                    cgroup_id = os.stat(directory).st_ino
+                except OSError as e:
+                    self.logger.info(f"Cgroup {cgroup} unavailable: {e}")
+                    continue
+            else:
+                cgroup_id = 0
+            
+            for resource in self.PSI_RESOURCES:
+                if cgroup:
+                    path = os.path.join(directory, f"{resource}.pressure")
+                else:
+                    path = f"/proc/pressure/{resource}"
+                try:
+                    fd = os.open(path, os.O_RDWR | os.O_NONBLOCK | os.O_CLOEXEC)
+                except OSError as e:
+                    self.logger.info(f"PSI {resource} unavailable for {cgroup or 'system'}: {e}")
+                    continue
+                
+                try:
+                    os.write(fd, trigger)
+                except OSError as e:
+                    self.logger.warning(f"Cannot arm PSI trigger on {path}: {e}")
+                    os.close(fd)
+                    continue
+                
+                total, _ = self._read_total(fd)
+                self._psi_fds[fd] = {"cgroup": cgroup, "cgroup_id": cgroup_id,
+                                     "resource": resource, "total": total,
+                                     "stamp": time.monotonic_ns(), "share": 0, "timer": None}
+                self._register(fd, select.EPOLLPRI, lambda events, fd=fd: self._psi_event(fd, events))
+    
+    def _psi_event(self, fd: int, events: int):
+        trigger = self._psi_fds.get(fd)
+        
+        # The trigger is gone with its file, as when the cgroup is removed
+        if events & select.EPOLLERR:
+            self.logger.warning(f"PSI {trigger['resource']} trigger lost for "
+                                f"{trigger['cgroup'] or 'system'}")
+            self._unregister(fd)
+            return
+        
+        self._psi_sample(fd, fired=True)
+    
+    def _psi_sample(self, fd: int, fired: bool = False):
+        """
+        Report the stall share since the last sample. A trigger only fires
+        on the way into pressure, so a pressured resource is resampled once
+        per window until it is relieved, and its share reported down to 0.
+        """
+        trigger = self._psi_fds.get(fd)
+        if trigger is None:
+            return
+        if trigger["timer"]:
+            trigger["timer"].cancel()
+            trigger["timer"] = None
+        
+        total, pressure = self._read_total(fd)
+        now = time.monotonic_ns()
+        elapsed_us = max((now - trigger["stamp"]) // 1000, 1)
+        share = min((total - trigger["total"]) * self.PSI_FULL // elapsed_us, self.PSI_FULL)
+        
+        # After a quiet spell the delta is diluted; the trigger vouches for its threshold
+        if fired:
+            share = max(share, self.psi_stall_us * self.PSI_FULL // self.psi_window_us)
+        if share < self.PSI_RELIEF_SHARE:
+            share = 0
+        
+        trigger["total"] = total
+        trigger["stamp"] = now
+        changed = share != trigger["share"]
+        trigger["share"] = share
+        
+        if share:
+            trigger["timer"] = self._loop.call_later(self.psi_window_us / 1e6,
+                                                     self._psi_sample, fd)
+        if (changed or fired) and self.on_pressure:
+            self.on_pressure(trigger["cgroup"], trigger["cgroup_id"], trigger["resource"],
+                             share, pressure)
+    
+    def _read_total(self, fd: int):
+        pressure = self._read_pressure(fd)
+        return int(pressure.get("some", {}).get("total", 0)), pressure
+    
+    @staticmethod
+    def _read_pressure(fd: int) -> Dict[str, Dict[str, float]]:
+        """Parse 'some avg10=0.00 avg60=0.00 avg300=0.00 total=0' lines"""
+        pressure = {}
+        try:
+            text = os.pread(fd, 256, 0).decode()
+        except OSError:
+            return pressure
+        
+        for line in text.splitlines():
+            kind, _, rest = line.partition(" ")
+            pressure[kind] = {key: float(value) for key, _, value in
+                              (field.partition("=") for field in rest.split())}
+        return pressure
+
+class AuroraControlClient:
+    """
+    Minimal client of the kernel's "aurora_ai" generic netlink control
+    plane (kernel/ai_extensions/aurora_core.h). Requests go out without
+    waiting on the kernel; their acks are read from the loop and failures
+    are logged. Needs CAP_NET_ADMIN.
+    """
+    
+    FAMILY_NAME = "aurora_ai"
+    FAMILY_VERSION = 1
+    CMD_APPLY = 1
+    ATTR_SCHED = 2
+    SCHED_PRESSURE = 4
+    PRESSURE_CGROUP, PRESSURE_CPU, PRESSURE_MEMORY, PRESSURE_IO = 1, 2, 3, 4
+    
+    # <linux/netlink.h>, <linux/genetlink.h>
+    NETLINK_GENERIC = 16
+    NLM_F_REQUEST = 0x1
+    NLM_F_ACK = 0x4
+    NLMSG_ERROR = 0x2
+    NLA_F_NESTED = 0x8000
+    GENL_ID_CTRL = 0x10
+    CTRL_CMD_GETFAMILY = 3
+    CTRL_ATTR_FAMILY_ID = 1
+    CTRL_ATTR_FAMILY_NAME = 2
+    
+    def __init__(self, logger: logging.Logger):
+        self.logger = logger
+        self._sock = None
+        self._loop = None
+        self._family = None
+        self._seq = 0
+    
+    @staticmethod
+    def _attr(attr_type: int, payload: bytes) -> bytes:
+        data = struct.pack("=HH", 4 + len(payload), attr_type) + payload
+        return data + b"\0" * (-len(data) % 4)
+    
+    def _nest(self, attr_type: int, attrs: List[bytes]) -> bytes:
+        return self._attr(attr_type | self.NLA_F_NESTED, b"".join(attrs))
+    
+    def _message(self, msg_type: int, cmd: int, version: int, attrs: bytes) -> bytes:
+        self._seq += 1
+        payload = struct.pack("=BBH", cmd, version, 0) + attrs
+        return struct.pack("=IHHII", 16 + len(payload), msg_type,
+                           self.NLM_F_REQUEST | self.NLM_F_ACK, self._seq, 0) + payload
+    
+    @staticmethod
+    def _messages(data: bytes):
+        """Yield (type, payload) for each netlink message in @data"""
+        offset = 0
+        while offset + 16 <= len(data):
+            length, msg_type, _, _, _ = struct.unpack_from("=IHHII", data, offset)
+            if length < 16:
+                break
+            yield msg_type, data[offset + 16:offset + length]
+            offset += (length + 3) & ~3
+    
+    def open(self, loop: asyncio.AbstractEventLoop) -> bool:
+        """Resolve the family; returns False when the modules are not loaded"""
+        try:
+            sock = socket.socket(socket.AF_NETLINK, socket.SOCK_RAW | socket.SOCK_CLOEXEC,
+                                 self.NETLINK_GENERIC)
+            sock.bind((0, 0))
+            
+            # The kernel answers within the send, so this lookup does not wait
+            name = self.FAMILY_NAME.encode() + b"\0"
+            sock.send(self._message(self.GENL_ID_CTRL, self.CTRL_CMD_GETFAMILY, 1,
+                                    self._attr(self.CTRL_ATTR_FAMILY_NAME, name)))
+            sock.setblocking(False)
+            reply = sock.recv(65536)
+        except OSError as e:
+            self.logger.info(f"Aurora control plane unavailable: {e}")
+            return False
+        
+        for msg_type, payload in self._messages(reply):
+            if msg_type == self.NLMSG_ERROR:
+                error, = struct.unpack_from("=i", payload, 0)
+                if error:
+                    self.logger.info(f"Aurora control plane unavailable: "
+                                     f"{os.strerror(-error)}")
+                    sock.close()
+                    return False
+                continue
+            
+            # genlmsghdr, then the family's attributes
+            offset = 4
+            while offset + 4 <= len(payload):
+                length, attr_type = struct.unpack_from("=HH", payload, offset)
+                if length < 4:
+                    break
+                if attr_type == self.CTRL_ATTR_FAMILY_ID:
+                    self._family, = struct.unpack_from("=H", payload, offset + 4)
+                offset += (length + 3) & ~3
+        
+        if self._family is None:
+            sock.close()
+            return False
+        
+        self._sock = sock
+        self._loop = loop
+        loop.add_reader(sock.fileno(), self._read_acks)
+        return True
+    
+    def close(self):
+        if self._sock is None:
+            return
+        self._loop.remove_reader(self._sock.fileno())
+        self._sock.close()
+        self._sock = None
+    
+    def _read_acks(self):
+        while True:
+            try:
+                data = self._sock.recv(65536)
+            except (BlockingIOError, InterruptedError):
+                return
+            except OSError as e:
+                self.logger.warning(f"Aurora control plane error: {e}")
+                return
+            
+            for msg_type, payload in self._messages(data):
+                if msg_type == self.NLMSG_ERROR:
+                    error, = struct.unpack_from("=i", payload, 0)
+                    if error:
+                        self.logger.warning(f"Aurora control plane refused an update: "
+                                            f"{os.strerror(-error)}")
+    
+    def push_pressure(self, entries: List[tuple]) -> bool:
+        """Send (cgroup id, cpu, memory, io) stall shares to the AI scheduler"""
+        if self._sock is None:
+            return False
+        
+        attrs = [self._nest(self.SCHED_PRESSURE, [
+                    self._attr(self.PRESSURE_CGROUP, struct.pack("=Q", cgroup_id)),
+                    self._attr(self.PRESSURE_CPU, struct.pack("=H", cpu)),
+                    self._attr(self.PRESSURE_MEMORY, struct.pack("=H", memory)),
+                    self._attr(self.PRESSURE_IO, struct.pack("=H", io))])
+                 for cgroup_id, cpu, memory, io in entries]
+        try:
+            self._sock.send(self._message(self._family, self.CMD_APPLY, self.FAMILY_VERSION,
+                                          self._nest(self.ATTR_SCHED, attrs)))
+        except OSError as e:
+            self.logger.warning(f"Aurora control plane send failed: {e}")
+            return False
+        return True
+
+ContextSnapshotData = namedtuple('ContextSnapshotData', (
+    'generation updated_ns '
+    'sched_picks sched_avg_score sched_avg_queued sched_avg_runtime_ns sched_avg_wait_ns '
+    'sched_cpu_intensity sched_io_intensity '
+    'context_switches context_dropped context_active context_tracked '
+    'security_verdicts security_alerts security_last_level security_last_alert_pid '
+    'security_last_alert_ns '
+    'pressure_cpu pressure_memory pressure_io cpu_permille memory_permille health_permille '
+    'telemetry_records telemetry_dropped'))
 
-initialize_driver_system = safe_import('system.hardware.driver_manager', 'initialize_driver_system')
-get_driver_manager = safe_import('system.hardware.driver_manager', 'get_driver_manager')
-get_intent_engine = safe_import('system.settings.intent_settings', 'get_intent_engine')
-show_settings = safe_import('system.settings.settings_ui', 'show_settings')
+class ContextSnapshot:
+    """
+    The system context as a fixed binary layout in shared memory, kept
+    current from the kernel telemetry ring, PSI and the health passes, so
+    the LLM engine and agents read it whenever they need it instead of
+    collecting it per request. Readers use ContextSnapshotReader.
+    
+    Layout (native byte order): a header of magic, layout version, body
+    size, sequence, CLOCK_MONOTONIC ns of the update (the telemetry
+    clock) and update generation, then BODY_FORMAT with the fields of
+    ContextSnapshotData after the first two. The sequence is odd while
+    the body is being written; a reader retries until it sees the same
+    even sequence before and after copying. Averages are per telemetry
+    batch, weighted 1/8; intensities are 1024 for 100%, pressure in
+    hundredths of a percent, the rest as named.
+    """
+    
+    PATH = "/dev/shm/aurora_context"
+    MAGIC = 0x58435541      # "AUCX"
+    LAYOUT = 1
+    HEADER_FORMAT = "=IHHQQQ"
+    BODY_FORMAT = "=QIIQQII" "QQII" "QQIiQ" "HHHHHHxxxx" "QQ"
+    SEQ_OFFSET = 8
+    EWMA_SHIFT = 3
+    
+    def __init__(self, path: str = PATH, alert_level: int = 3):
+        self.path = path
+        self.alert_level = alert_level
+        self.header_size = struct.calcsize(self.HEADER_FORMAT)
+        self.body_size = struct.calcsize(self.BODY_FORMAT)
+        self.values = dict.fromkeys(ContextSnapshotData._fields[2:], 0)
+        self.generation = 0
+        self._map = None
+    
+    def open(self) -> bool:
+        try:
+            fd = os.open(self.path, os.O_RDWR | os.O_CREAT | os.O_CLOEXEC, 0o644)
+        except OSError:
+            return False
+        try:
+            os.ftruncate(fd, mmap.PAGESIZE)
+            self._map = mmap.mmap(fd, mmap.PAGESIZE, mmap.MAP_SHARED,
+                                  mmap.PROT_READ | mmap.PROT_WRITE)
+        except OSError:
+            return False
+        finally:
+            os.close(fd)
+        
+        # A previous daemon's sequence carries on, so readers never see it go back
+        magic, layout, _, seq, _, generation = struct.unpack_from(self.HEADER_FORMAT, self._map, 0)
+        if magic != self.MAGIC or layout != self.LAYOUT:
+            seq = generation = 0
+        self._seq = (seq + 1) & ~1
+        self.generation = generation
+        self.publish()
+        return True
+    
+    def close(self):
+        if self._map is None:
+            return
+        self._map.close()
+        self._map = None
+        try:
+            os.unlink(self.path)
+        except OSError:
+            pass
+    
+    def _blend(self, key: str, sample: int):
+        avg = self.values[key]
+        self.values[key] = avg + ((sample - avg) >> self.EWMA_SHIFT) if avg else sample
+    
+    def account(self, records: List[TelemetryRecord]):
+        """Fold a drained batch of telemetry records into the context"""
+        values = self.values
+        values["telemetry_records"] += len(records)
+        
+        picks = [r for r in records if r.type == KernelEventSource.SCHED_PICK]
+        if picks:
+            n = len(picks)
+            values["sched_picks"] += n
+            self._blend("sched_avg_score", sum(r.arg for r in picks) // n)
+            self._blend("sched_avg_runtime_ns", sum(r.data[0] for r in picks) // n)
+            self._blend("sched_avg_wait_ns", sum(r.data[1] for r in picks) // n)
+            self._blend("sched_cpu_intensity", sum(r.data[2] for r in picks) // n)
+            self._blend("sched_io_intensity", sum(r.data[3] for r in picks) // n)
+            self._blend("sched_avg_queued", sum(r.data[4] for r in picks) // n)
+        
+        for r in records:
+            if r.type == KernelEventSource.CONTEXT_LEARN:
+                values["context_switches"] = r.data[0]
+                values["context_dropped"] = r.data[1]
+                values["context_tracked"] = r.data[2]
+                values["context_active"] = r.arg
+            elif r.type == KernelEventSource.SECURITY_VERDICT:
+                values["security_verdicts"] += 1
+                values["security_last_level"] = r.data[1]
+                if r.data[1] >= self.alert_level:
+                    values["security_alerts"] += 1
+                    values["security_last_alert_pid"] = r.pid
+                    values["security_last_alert_ns"] = r.timestamp_ns
+    
+    def update(self, **values):
+        self.values.update(values)
+    
+    def publish(self):
+        """Make the current values visible to readers"""
+        if self._map is None:
+            return
+        
+        self.generation += 1
+        body = struct.pack(self.BODY_FORMAT, *(self.values[f] for f in ContextSnapshotData._fields[2:]))
+        
+        struct.pack_into("=Q", self._map, self.SEQ_OFFSET, self._seq + 1)
+        self._map[self.header_size:self.header_size + self.body_size] = body
+        struct.pack_into(self.HEADER_FORMAT, self._map, 0, self.MAGIC, self.LAYOUT,
+                         self.body_size, self._seq + 1, time.monotonic_ns(), self.generation)
+        self._seq += 2
+        struct.pack_into("=Q", self._map, self.SEQ_OFFSET, self._seq)
 
-initialize_nix_system = safe_import('system.advanced.nix_integration', 'initialize_nix_system')
-get_nix_integration = safe_import('system.advanced.nix_integration', 'get_nix_integration')
-initialize_ebpf_system = safe_import('system.advanced.ebpf_integration', 'initialize_ebpf_system')
-get_ebpf_integration = safe_import('system.advanced.ebpf_integration', 'get_ebpf_integration')
+class ContextSnapshotReader:
+    """
+    Reads the daemon's ContextSnapshot from shared memory; cheap enough to
+    call per request. read() returns a ContextSnapshotData, or None if
+    there is no snapshot of this layout.
+    """
+    
+    def __init__(self, path: str = ContextSnapshot.PATH):
+        fd = os.open(path, os.O_RDONLY | os.O_CLOEXEC)
+        try:
+            self._map = mmap.mmap(fd, mmap.PAGESIZE, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+        self._header_size = struct.calcsize(ContextSnapshot.HEADER_FORMAT)
+    
+    def close(self):
+        self._map.close()
+    
+    def read(self, retries: int = 1000) -> Optional[ContextSnapshotData]:
+        for _ in range(retries):
+            seq, = struct.unpack_from("=Q", self._map, ContextSnapshot.SEQ_OFFSET)
+            if seq & 1:
+                continue
+            magic, layout, body_size, _, updated_ns, generation = \
+                struct.unpack_from(ContextSnapshot.HEADER_FORMAT, self._map, 0)
+            body = struct.unpack_from(ContextSnapshot.BODY_FORMAT, self._map, self._header_size)
+            if struct.unpack_from("=Q", self._map, ContextSnapshot.SEQ_OFFSET)[0] != seq:
+                continue
+            if magic != ContextSnapshot.MAGIC or layout != ContextSnapshot.LAYOUT:
+                return None
+            return ContextSnapshotData(generation, updated_ns, *body)
+        return None
 
-launch_browser = safe_import('applications.aurora_browser.browser', 'launch_browser')
+class InferenceRejected(Exception):
+    """The system stayed too pressured to admit an inference"""
+
+class InferenceAdmission:
+    """
+    Admission control for LLM inference by system pressure, the worst PSI
+    stall share over CPU, memory and IO. Below defer_share all slots are
+    open; up to shed_share one inference runs at a time; beyond it new
+    inferences wait for relief, and are rejected after max_wait seconds.
+    Use as "async with admission:" around each inference.
+    """
+    
+    def __init__(self, slots: int = 2, defer_share: int = 1000, shed_share: int = 4000,
+                 max_wait: float = 10.0):
+        self.slots = max(slots, 1)
+        self.defer_share = defer_share
+        self.shed_share = shed_share
+        self.max_wait = max_wait
+        self.share = 0
+        self.active = 0
+        self.stats = {"admitted": 0, "deferred": 0, "rejected": 0}
+        self._changed = None    # Created on the running loop
+    
+    def limit(self) -> int:
+        if self.share < self.defer_share:
+            return self.slots
+        if self.share < self.shed_share:
+            return 1
+        return 0
+    
+    def update(self, share: int):
+        self.share = share
+        if self._changed:
+            self._changed.set()
+    
+    async def __aenter__(self):
+        if self._changed is None:
+            self._changed = asyncio.Event()
+        
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + self.max_wait
+        if self.active >= self.limit():
+            self.stats["deferred"] += 1
+        
+        while self.active >= self.limit():
+            remaining = deadline - loop.time()
+            if remaining <= 0:
+                self.stats["rejected"] += 1
+                raise InferenceRejected(f"pressure {self.share / 100:.1f}%")
+            self._changed.clear()
+            try:
+                await asyncio.wait_for(self._changed.wait(), timeout=remaining)
+            except asyncio.TimeoutError:
+                pass
+        
+        self.active += 1
+        self.stats["admitted"] += 1
+        return self
+    
+    async def __aexit__(self, exc_type, exc, tb):
+        self.active -= 1
+        self._changed.set()
+        return False
 
 class AuroraOS:
     """
@@ -51,6 +962,26 @@ class AuroraOS:
     Coordinates all revolutionary components into a unified AI-native operating system
     """
     
+    # Dependencies follow the integrations between components; the model and
+    # the wake-word detector are heavyweight and stay off the boot path
+    COMPONENTS = (
+        ComponentSpec("task_agent", "⚡ Task Agent", TaskAgent),
+        ComponentSpec("taskbar_assistant", "🎯 Taskbar Assistant", get_taskbar_assistant,
+                      depends=("task_agent",), enabled=("ai", "taskbar_integration")),
+        ComponentSpec("driver_manager", "🔧 Driver Management", initialize_driver_system,
+                      enabled=("hardware", "auto_driver_install")),
+        ComponentSpec("nix_integration", "🔁 Nix Integration", initialize_nix_system,
+                      enabled=("advanced_features", "nix_integration")),
+        ComponentSpec("intent_engine", "⚙️ Intent Engine", get_intent_engine,
+                      depends=("nix_integration",), enabled=("ai", "intent_settings")),
+        ComponentSpec("ebpf_integration", "📊 eBPF Monitoring", initialize_ebpf_system,
+                      enabled=("advanced_features", "ebpf_monitoring")),
+        ComponentSpec("llm_engine", "🧠 AI Core", initialize_ai_system,
+                      depends=("driver_manager",), lazy=True),
+        ComponentSpec("voice_interface", "🎤 Voice Interface", initialize_voice_system,
+                      enabled=("ai", "voice_enabled"), lazy=True),
+    )
+    
     def __init__(self):
         self.version = "1.0.0"
         self.build_date = datetime.now().isoformat()
@@ -70,14 +1001,47 @@ class AuroraOS:
         self.running = False
         self.shutdown_requested = False
         
+        # Event sources; the asyncio primitives are created on the running loop
+        self.kernel_events = None
+        self._wakeup = None
+        self._maintenance_due = None
+        self._health_timer = None
+        self._last_context_update = 0.0
+        self.kernel_stats = {"records": 0, "pressure_events": 0, "security_alerts": 0}
+        
+        # Stall shares per watched cgroup ("system" for the whole machine), in
+        # hundredths of a percent, and the cgroup ids still to push to the kernel
+        self.pressure: Dict[str, Dict[str, int]] = {}
+        self.control = None
+        self._pressure_dirty: Dict[int, str] = {}
+        self._pressure_flush = None
+        
         # Configuration
         self.config = self._load_config()
         
+        pressure_config = self.config["pressure"]
+        self.inference_admission = InferenceAdmission(
+            slots=pressure_config["inference_slots"],
+            defer_share=int(pressure_config["defer_percent"] * 100),
+            shed_share=int(pressure_config["shed_percent"] * 100),
+            max_wait=pressure_config["max_wait_s"]
+        )
+        
         # Logging
         self.logger = self._setup_logging()
         
-        # Register signal handlers
-        self._setup_signal_handlers()
+        # Shared-memory context for the LLM engine and agents
+        self.context_snapshot = ContextSnapshot(self.config["ai"]["context_snapshot"],
+                                                alert_level=self.SECURITY_ALERT_LEVEL)
+        self._snapshot_timer = None
+        
+        # Component startup
+        self.components = ComponentLoader(self, self.COMPONENTS, self.config, self.logger)
+        self.boot_time = None
+        self.boot_profile = BootProfile()
+        if self.boot_profile.enabled:
+            self.boot_profile.mark("exec", BootProfile.process_start(), _PROCESS_START)
+        self.perf_lab = PerfLab()
         
         self.logger.info("Aurora OS initializing...")
     
@@ -91,7 +1055,8 @@ class AuroraOS:
                 "model_path": "/opt/aurora/models/llama-3.2-3b",
                 "taskbar_integration": True,
                 "voice_enabled": True,
-                "intent_settings": True
+                "intent_settings": True,
+                "context_snapshot": ContextSnapshot.PATH
             },
             "hardware": {
                 "auto_driver_install": True,
@@ -102,6 +1067,10 @@ class AuroraOS:
                 "ebpf_monitoring": True,
                 "declarative_configs": True
             },
+            "startup": {
+                # Load lazy components in the background once the daemon is usable
+                "prefetch_lazy": True
+            },
             "ui": {
                 "theme": "aurora",
                 "animations": True,
@@ -111,6 +1080,17 @@ class AuroraOS:
                 "zero_trust": True,
                 "auto_sandboxing": True,
                 "privacy_by_default": True
+            },
+            "pressure": {
+                # "" is the whole system; others are paths below /sys/fs/cgroup
+                "cgroups": [""],
+                "stall_us": 150000,
+                "window_us": 1000000,
+                # LLM inference admission by system pressure
+                "inference_slots": 2,
+                "defer_percent": 10,
+                "shed_percent": 40,
+                "max_wait_s": 10
             }
         }
         
@@ -151,73 +1131,45 @@ class AuroraOS:
         
         return logger
     
-    def _setup_signal_handlers(self):
-        """Setup signal handlers for graceful shutdown"""
-        signal.signal(signal.SIGINT, self._signal_handler)
-        signal.signal(signal.SIGTERM, self._signal_handler)
-        signal.signal(signal.SIGUSR1, self._signal_handler)
+    def _setup_signal_handlers(self, loop: asyncio.AbstractEventLoop):
+        """Setup signal handlers for graceful shutdown, delivered on the loop"""
+        for signum in (signal.SIGINT, signal.SIGTERM, signal.SIGUSR1):
+            loop.add_signal_handler(signum, self._signal_handler, signum)
     
-    def _signal_handler(self, signum, frame):
+    def _signal_handler(self, signum):
         """Handle system signals"""
         if signum in (signal.SIGINT, signal.SIGTERM):
             self.logger.info(f"Received shutdown signal {signum}")
-            self.shutdown_requested = True
-            asyncio.create_task(self.shutdown())
+            self._request_shutdown()
         elif signum == signal.SIGUSR1:
             self.logger.info("Received status signal")
             asyncio.create_task(self.print_status())
     
+    def _request_shutdown(self):
+        self.shutdown_requested = True
+        if self._wakeup:
+            self._wakeup.set()
+            self._maintenance_due.set()
+    
     async def initialize(self):
         """Initialize all Aurora OS components"""
         self.logger.info("🚀 Initializing Aurora OS v1.0.0...")
         
+        start = time.monotonic()
         try:
-            # Phase 1: Core AI System
-            self.logger.info("🧠 Initializing AI Core...")
-            self.llm_engine = await initialize_ai_system()
-            
-            # Phase 2: User Interface Components
-            if self.config["ai"]["taskbar_integration"]:
-                self.logger.info("🎯 Initializing Taskbar Assistant...")
-                self.taskbar_assistant = get_taskbar_assistant()
-            
-            if self.config["ai"]["voice_enabled"]:
-                self.logger.info("🎤 Initializing Voice Interface...")
-                self.voice_interface, voice_processor = await initialize_voice_system()
-            
-            # Phase 3: Task Execution System
-            self.logger.info("⚡ Initializing Task Agent...")
-            self.task_agent = TaskAgent()
-            
-            # Phase 4: Hardware Management
-            if self.config["hardware"]["auto_driver_install"]:
-                self.logger.info("🔧 Initializing Driver Management...")
-                self.driver_manager, devices = await initialize_driver_system()
-                self.logger.info(f"✅ Detected and configured {len(devices)} hardware devices")
-            
-            # Phase 5: Intent-Based Settings
-            if self.config["ai"]["intent_settings"]:
-                self.logger.info("⚙️ Initializing Intent Engine...")
-                self.intent_engine = get_intent_engine()
-            
-            # Phase 6: Advanced Features
-            if self.config["advanced_features"]["nix_integration"]:
-                self.logger.info("🔁 Initializing Nix Integration...")
-                self.nix_integration = await initialize_nix_system()
-            
-            if self.config["advanced_features"]["ebpf_monitoring"]:
-                self.logger.info("📊 Initializing eBPF Monitoring...")
-                self.ebpf_integration = await initialize_ebpf_system()
+            # Phase 1: Components, concurrently; the AI core and voice wait for first use
+            await self.components.load_eager()
             
-            # Phase 7: System Integration
+            # Phase 2: System Integration
             self.logger.info("🔗 Integrating Components...")
             await self._integrate_components()
             
-            # Phase 8: Final Setup
+            # Phase 3: Final Setup
             self.logger.info("🎨 Applying UI Configuration...")
             await self._apply_ui_configuration()
             
             self.initialized = True
+            self.boot_profile.mark("initialize", start, time.monotonic())
             self.logger.info("✨ Aurora OS initialization complete!")
             
             # Display revolutionary features
@@ -227,6 +1179,30 @@ class AuroraOS:
             self.logger.error(f"❌ Failed to initialize Aurora OS: {e}")
             raise
     
+    def _on_component_ready(self, name: str, result: Any):
+        """Per-component setup once it is loaded; the AI core and voice may arrive late"""
+        try:
+            if name == "driver_manager" and isinstance(result, tuple):
+                devices = result[1]
+                self.logger.info(f"✅ Detected and configured {len(devices)} hardware devices")
+            
+            # Connect driver manager and the shared context to AI
+            elif name == "llm_engine":
+                context = {'context_snapshot': self.context_snapshot.path}
+                if self.driver_manager:
+                    # Share hardware context with AI
+                    context['devices'] = len(self.driver_manager.get_all_devices())
+                    context['drivers_installed'] = len(
+                        self.driver_manager.get_devices_by_status('installed'))
+                self.llm_engine.update_context(context)
+            
+            # Start wake word detection once the detector is loaded
+            elif name == "voice_interface" and self.running:
+                self.voice_interface.start_wake_word_detection()
+        
+        except Exception as e:
+            self.logger.error(f"{name} setup failed: {e}")
+    
     async def _integrate_components(self):
         """Integrate all components together"""
         try:
@@ -235,15 +1211,6 @@ class AuroraOS:
                 # Integration logic here
                 pass
             
-            # Connect driver manager to AI
-            if self.driver_manager and self.llm_engine:
-                # Share hardware context with AI
-                hardware_context = {
-                    'devices': len(self.driver_manager.get_all_devices()),
-                    'drivers_installed': len(self.driver_manager.get_devices_by_status('installed'))
-                }
-                self.llm_engine.update_context(hardware_context)
-            
             # Connect eBPF to AI for anomaly explanation
             if self.ebpf_integration and self.llm_engine:
                 # Integration for kernel behavior explanation
@@ -303,35 +1270,188 @@ class AuroraOS:
         if not self.initialized:
             await self.initialize()
         
+        loop = asyncio.get_running_loop()
+        self._wakeup = asyncio.Event()
+        self._maintenance_due = asyncio.Event()
+        self._setup_signal_handlers(loop)
+        
         self.running = True
         self.logger.info("🌟 Aurora OS starting main loop...")
         
         try:
             # Start background services
+            start = time.monotonic()
             await self._start_background_services()
+            self.boot_profile.mark("background", start, time.monotonic())
             
-            # Run main loop
+            # Usable from here on; anything heavyweight loads behind it
+            self._report_boot_time()
+            if self.perf_lab.enabled:
+                loop.run_in_executor(None, self.perf_lab.run, self.boot_profile)
+            elif self.boot_profile.enabled:
+                loop.run_in_executor(None, self.boot_profile.dump)
+            if self.config["startup"]["prefetch_lazy"]:
+                self.components.prefetch()
+            
+            # Run main loop: a pass per kernel event, or per health interval when idle
+            self._schedule_health_check()
             while not self.shutdown_requested:
+                await self._wakeup.wait()
+                self._wakeup.clear()
+                if self.shutdown_requested:
+                    break
+                
                 try:
                     # Process system events
                     await self._process_system_events()
                     
                     # Monitor system health
                     await self._monitor_system_health()
-                    
-                    # Sleep briefly
-                    await asyncio.sleep(1)
                 
-                except KeyboardInterrupt:
-                    self.logger.info("⏹️ Keyboard interrupt received")
-                    break
                 except Exception as e:
                     self.logger.error(f"Main loop error: {e}")
-                    await asyncio.sleep(5)  # Wait before retrying
         
         finally:
             await self.shutdown()
     
+    def _report_boot_time(self):
+        """Log boot-to-usable time and where it went"""
+        now = time.monotonic()
+        self.boot_time = now - _PROCESS_START
+        self.boot_profile.mark("usable", _PROCESS_START, now)
+        
+        timings = sorted(self.components.timings.items(), key=lambda item: -item[1])
+        breakdown = ", ".join(f"{name} {seconds * 1000:.0f} ms" for name, seconds in timings)
+        deferred = ", ".join(self.components.pending) or "none"
+        self.logger.info(f"⏱️ Aurora OS usable in {self.boot_time:.2f}s "
+                         f"({breakdown or 'no components'}; deferred: {deferred})")
+    
+    # Health pass when nothing happened for this long; events trigger one at once
+    HEALTH_INTERVAL = 30.0
+    # Context updates are rate limited when pressure keeps firing
+    CONTEXT_UPDATE_INTERVAL = 5.0
+    # Threat level of ai_security verdicts worth a health pass (HIGH)
+    SECURITY_ALERT_LEVEL = 3
+    # Telemetry arriving within this many seconds lands in one snapshot update
+    SNAPSHOT_INTERVAL = 0.05
+    
+    def _schedule_snapshot(self):
+        if self._snapshot_timer is None:
+            self._snapshot_timer = asyncio.get_running_loop().call_later(
+                self.SNAPSHOT_INTERVAL, self._publish_snapshot)
+    
+    def _publish_snapshot(self):
+        self._snapshot_timer = None
+        if self.kernel_events:
+            self.context_snapshot.update(telemetry_dropped=self.kernel_events.dropped())
+        self.context_snapshot.publish()
+    
+    def _schedule_health_check(self):
+        """Arm the idle health timer; every pass re-arms it"""
+        if self._health_timer:
+            self._health_timer.cancel()
+        self._health_timer = asyncio.get_running_loop().call_later(
+            self.HEALTH_INTERVAL, self._wake_main_loop)
+    
+    def _wake_main_loop(self):
+        self._wakeup.set()
+    
+    def _start_kernel_events(self):
+        """Watch the kernel telemetry rings and PSI triggers from the loop"""
+        loop = asyncio.get_running_loop()
+        pressure_config = self.config["pressure"]
+        
+        if self.context_snapshot.open():
+            self.logger.info(f"🧩 Context snapshot at {self.context_snapshot.path}")
+        else:
+            self.logger.warning(f"Cannot create context snapshot at {self.context_snapshot.path}")
+        
+        # Pressure goes to the AI scheduler when its control plane is there
+        self.control = AuroraControlClient(self.logger)
+        if not self.control.open(loop):
+            self.control = None
+        
+        self.kernel_events = KernelEventSource(
+            self.logger,
+            psi_stall_us=pressure_config["stall_us"],
+            psi_window_us=pressure_config["window_us"],
+            cgroups=pressure_config["cgroups"]
+        )
+        self.kernel_events.on_telemetry = self._on_kernel_telemetry
+        self.kernel_events.on_pressure = self._on_pressure
+        
+        if self.kernel_events.start(loop):
+            self.logger.info(f"⚡ Kernel events: {', '.join(self.kernel_events.sources)}")
+        else:
+            self.logger.info("Kernel events unavailable, health runs on its timer only")
+            self.kernel_events = None
+    
+    def _on_kernel_telemetry(self, records: List[TelemetryRecord]):
+        """Telemetry records drained from the rings; runs on the loop"""
+        self.kernel_stats["records"] += len(records)
+        
+        self.context_snapshot.account(records)
+        self._schedule_snapshot()
+        
+        alerts = [r for r in records
+                  if r.type == KernelEventSource.SECURITY_VERDICT
+                  and r.data[1] >= self.SECURITY_ALERT_LEVEL]
+        if alerts:
+            self.kernel_stats["security_alerts"] += len(alerts)
+            pids = sorted({r.pid for r in alerts})
+            self.logger.warning(f"🛡️ {len(alerts)} high threat verdicts for pids {pids[:8]}")
+            self._wake_main_loop()
+    
+    def _on_pressure(self, cgroup: str, cgroup_id: int, resource: str, share: int,
+                     pressure: Dict[str, Dict[str, float]]):
+        """
+        A resource's stall share changed: its PSI trigger fired, or a
+        resample while pressured saw it move or clear. Runs on the loop.
+        """
+        self.kernel_stats["pressure_events"] += 1
+        name = cgroup or "system"
+        shares = self.pressure.setdefault(name, {r: 0 for r in KernelEventSource.PSI_RESOURCES})
+        previous = shares[resource]
+        shares[resource] = share
+        
+        if share and not previous:
+            self.logger.warning(f"📈 {resource} pressure on {name}: {share / 100:.1f}% stalled")
+        elif not share:
+            self.logger.info(f"📉 {resource} pressure on {name} relieved")
+        
+        # Inference admission and the shared context follow the system as a whole
+        if not cgroup:
+            self.inference_admission.update(max(shares.values()))
+            self.context_snapshot.update(**{f"pressure_{resource}": share})
+            self._schedule_snapshot()
+        
+        # Coalesce the shares of one loop pass into a single control message
+        self._pressure_dirty[cgroup_id] = name
+        if self.control and self._pressure_flush is None:
+            self._pressure_flush = asyncio.get_running_loop().call_soon(self._push_pressure)
+        
+        if not share:
+            return
+        self._wake_main_loop()
+        
+        # Refresh the AI context while the pressure is current
+        now = time.monotonic()
+        if self.llm_engine and now - self._last_context_update >= self.CONTEXT_UPDATE_INTERVAL:
+            self._last_context_update = now
+            asyncio.create_task(self._update_ai_context())
+    
+    def _push_pressure(self):
+        """Hand the changed stall shares to the AI scheduler's context score"""
+        self._pressure_flush = None
+        entries = []
+        for cgroup_id, name in self._pressure_dirty.items():
+            shares = self.pressure[name]
+            entries.append((cgroup_id, shares["cpu"], shares["memory"], shares["io"]))
+        self._pressure_dirty.clear()
+        
+        if entries and self.control:
+            self.control.push_pressure(entries)
+    
     async def _start_background_services(self):
         """Start background services"""
         try:
@@ -340,11 +1460,18 @@ class AuroraOS:
                 # eBPF runs in background threads
                 pass
             
-            # Start voice assistant if enabled
+            # Start voice assistant if enabled and already loaded
             if self.voice_interface and self.config["ai"]["voice_enabled"]:
                 # Start wake word detection
                 self.voice_interface.start_wake_word_detection()
             
+            # Start kernel event sources
+            self._start_kernel_events()
+            
+            # Prime the CPU counters so later samples need not block
+            import psutil
+            psutil.cpu_percent(interval=None)
+            
             # Start periodic maintenance
             asyncio.create_task(self._maintenance_loop())
             
@@ -372,6 +1499,7 @@ class AuroraOS:
     
     async def _monitor_system_health(self):
         """Monitor overall system health"""
+        self._schedule_health_check()
         try:
             health_score = 0.0
             
@@ -393,13 +1521,22 @@ class AuroraOS:
                 driver_health = 1.0 - (missing_drivers / max(total_devices, 1))
                 health_score += driver_health * 0.2
             
-            # Base system health
-            health_score += 0.2  # Base system health
+            # Base system health, less what current system pressure costs
+            stall = max(self.pressure.get("system", {}).values(), default=0)
+            health_score += 0.2 * (1.0 - stall / KernelEventSource.PSI_FULL)
             
-            if health_score < 0.7:
-                self.logger.warning(f"⚠️ System health degraded: {health_score:.2f}")
-            elif health_score < 0.5:
+            import psutil
+            self.context_snapshot.update(
+                health_permille=int(health_score * 1000),
+                cpu_permille=int(psutil.cpu_percent(interval=None) * 10),
+                memory_permille=int(psutil.virtual_memory().percent * 10)
+            )
+            self._schedule_snapshot()
+            
+            if health_score < 0.5:
                 self.logger.error(f"🚨 System health critical: {health_score:.2f}")
+            elif health_score < 0.7:
+                self.logger.warning(f"⚠️ System health degraded: {health_score:.2f}")
         
         except Exception as e:
             self.logger.error(f"Health monitoring error: {e}")
@@ -408,8 +1545,14 @@ class AuroraOS:
         """Periodic maintenance tasks"""
         while not self.shutdown_requested:
             try:
-                # Run maintenance every hour
-                await asyncio.sleep(3600)
+                # Run maintenance every hour, sooner when asked, never past shutdown
+                try:
+                    await asyncio.wait_for(self._maintenance_due.wait(), timeout=3600)
+                except asyncio.TimeoutError:
+                    pass
+                self._maintenance_due.clear()
+                if self.shutdown_requested:
+                    break
                 
                 self.logger.debug("🔧 Running periodic maintenance...")
                 
@@ -433,10 +1576,14 @@ class AuroraOS:
             log_dir = Path("/var/log/aurora")
             cutoff_days = 7
             
-            for log_file in log_dir.glob("*.log*"):
-                if log_file.stat().st_mtime < time.time() - (cutoff_days * 24 * 3600):
-                    log_file.unlink()
-                    self.logger.debug(f"🗑️ Removed old log: {log_file}")
+            def remove_old_logs():
+                for log_file in log_dir.glob("*.log*"):
+                    if log_file.stat().st_mtime < time.time() - (cutoff_days * 24 * 3600):
+                        log_file.unlink()
+                        self.logger.debug(f"🗑️ Removed old log: {log_file}")
+            
+            # Directory walks can stall on a busy disk; keep them off the loop
+            await asyncio.get_running_loop().run_in_executor(None, remove_old_logs)
         
         except Exception as e:
             self.logger.error(f"Log cleanup error: {e}")
@@ -449,11 +1596,21 @@ class AuroraOS:
             # Add system resources
             import psutil
             context_data['system_resources'] = {
-                'cpu_percent': psutil.cpu_percent(interval=1),
+                'cpu_percent': psutil.cpu_percent(interval=None),
                 'memory_percent': psutil.virtual_memory().percent,
                 'disk_percent': psutil.disk_usage('/').percent
             }
             
+            # Where the continuously updated context lives, for reads between updates
+            context_data['context_snapshot'] = self.context_snapshot.path
+            
+            # Add current pressure stall information, in percent
+            if self.pressure:
+                context_data['pressure'] = {
+                    name: {resource: share / 100 for resource, share in shares.items()}
+                    for name, shares in self.pressure.items()
+                }
+            
             # Add hardware status
             if self.driver_manager:
                 devices = self.driver_manager.get_all_devices()
@@ -487,7 +1644,13 @@ class AuroraOS:
             "version": self.version,
             "initialized": self.initialized,
             "running": self.running,
-            "uptime": "N/A",
+            "uptime": f"{time.monotonic() - _PROCESS_START:.0f}s",
+            "boot": {
+                "usable_s": round(self.boot_time, 3) if self.boot_time is not None else None,
+                "components_ms": {name: round(seconds * 1000) for name, seconds
+                                  in self.components.timings.items()},
+                "pending": self.components.pending
+            },
             "components": {}
         }
         
@@ -519,6 +1682,21 @@ class AuroraOS:
                 "health_score": self.ebpf_integration.get_system_health_score()
             }
         
+        # Kernel event status
+        if self.kernel_events:
+            status["components"]["kernel_events"] = dict(
+                self.kernel_stats,
+                sources=self.kernel_events.sources,
+                dropped=self.kernel_events.dropped(),
+                pressure=self.pressure,
+                control_plane=self.control is not None
+            )
+        status["components"]["inference_admission"] = dict(
+            self.inference_admission.stats,
+            active=self.inference_admission.active,
+            limit=self.inference_admission.limit()
+        )
+        
         # Print status
         self.logger.info(f"📊 Aurora OS Status: {json.dumps(status, indent=2)}")
     
@@ -540,8 +1718,8 @@ class AuroraOS:
                     else:
                         return f"❌ Intent execution failed: {intent}"
             
-            # Fall back to AI assistant
-            if self.llm_engine:
+            # Fall back to AI assistant, loading it if this is its first use
+            if await self.components.get("llm_engine"):
                 from ai_assistant.core.local_llm_engine import AIRequest
                 request = AIRequest(
                     prompt=f"User intent: {intent}. Process this as a system command.",
@@ -549,7 +1727,13 @@ class AuroraOS:
                     temperature=0.3
                 )
                 
-                response = await self.llm_engine.generate_response(request)
+                # Inference competes for the memory and CPU a pressured system lacks
+                try:
+                    async with self.inference_admission:
+                        response = await self.llm_engine.generate_response(request)
+                except InferenceRejected as e:
+                    self.logger.warning(f"⏳ Inference shed under {e}")
+                    return "⏳ System is under heavy load, please try again shortly"
                 return response.text
             
             return "❌ Unable to process intent"
@@ -584,8 +1768,26 @@ class AuroraOS:
         
         self.logger.info("🛑 Shutting down Aurora OS...")
         self.running = False
+        self._request_shutdown()
+        if self._health_timer:
+            self._health_timer.cancel()
         
         try:
+            # Stop kernel event sources
+            if self.kernel_events:
+                self.kernel_events.close()
+                self.kernel_events = None
+            if self._pressure_flush:
+                self._pressure_flush.cancel()
+                self._pressure_flush = None
+            if self._snapshot_timer:
+                self._snapshot_timer.cancel()
+                self._snapshot_timer = None
+            self.context_snapshot.close()
+            if self.control:
+                self.control.close()
+                self.control = None
+            
             # Stop background services
             if self.voice_interface:
                 self.voice_interface.stop_wake_word_detection()
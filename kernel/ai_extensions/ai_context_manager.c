@@ -10,17 +10,32 @@
 #include <linux/init.h>
 #include <linux/sched.h>
 #include <linux/mm.h>
+#include <linux/damon.h>
+#include <linux/iocontext.h>
+#include <linux/ioprio.h>
+#include <linux/khugepaged.h>
 #include <linux/list.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/memcontrol.h>
+#include <linux/percpu.h>
+#include <linux/pid.h>
+#include <linux/rcupdate.h>
+#include <linux/sched/aurora.h>
+#include <linux/sched/task.h>
 #include <linux/spinlock.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/srcu.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
-#include <linux/timer.h>
 #include <linux/workqueue.h>
 #include <linux/jiffies.h>
-#include <linux/random.h>
 #include <linux/vmalloc.h>
+#include <net/netlink.h>
 #include "ai_context_manager.h"
+#include "aurora_core.h"
+#include "aurora_trace.h"
 
 /* Module Information */
 MODULE_LICENSE("GPL v2");
@@ -31,6 +46,21 @@ MODULE_VERSION("1.0.0");
 /* Global Context Manager Instance */
 struct ai_context_manager *ai_ctx_mgr = NULL;
 
+/*
+ * The learning work walks all contexts and must be able to reschedule
+ * midway, so it walks under SRCU. Contexts are freed only after both an
+ * RCU and an SRCU grace period.
+ */
+DEFINE_STATIC_SRCU(ai_context_srcu);
+
+/*
+ * Set once the manager is fully initialised and cleared first thing on
+ * shutdown. The hook wrappers test it inline, so the scheduler and fork
+ * paths pay a patched NOP while the manager is not running.
+ */
+DEFINE_STATIC_KEY_FALSE(ai_context_hooks_enabled);
+EXPORT_SYMBOL(ai_context_hooks_enabled);
+
 /* Module Parameters */
 unsigned int ai_context_max_processes = AI_CONTEXT_MAX_PROCESSES;
 module_param(ai_context_max_processes, uint, 0644);
@@ -48,13 +78,125 @@ bool ai_context_debug_enabled = false;
 module_param(ai_context_debug_enabled, bool, 0644);
 MODULE_PARM_DESC(ai_context_debug_enabled, "Enable debug logging");
 
+unsigned int ai_context_lazy_cpu_ms = 10;
+module_param(ai_context_lazy_cpu_ms, uint, 0644);
+MODULE_PARM_DESC(ai_context_lazy_cpu_ms, "CPU time in ms a task must use before it gets a context");
+
+bool ai_context_io_hints = true;
+module_param(ai_context_io_hints, bool, 0644);
+MODULE_PARM_DESC(ai_context_io_hints, "Hint IO priorities: foreground first, bulk writers last");
+
+bool ai_context_grouping = true;
+module_param(ai_context_grouping, bool, 0644);
+MODULE_PARM_DESC(ai_context_grouping, "Group the foreground application and background batch work");
+
+bool ai_context_lru_hints = true;
+module_param(ai_context_lru_hints, bool, 0644);
+MODULE_PARM_DESC(ai_context_lru_hints, "Hint the multi-gen LRU which memcgs are hot and which are idle");
+
+unsigned int ai_context_hot_ttl_ms = 10000;
+module_param(ai_context_hot_ttl_ms, uint, 0644);
+MODULE_PARM_DESC(ai_context_hot_ttl_ms, "Age in ms below which the foreground memcg's pages are not reclaimed");
+
+bool ai_context_zswap = false;
+module_param(ai_context_zswap, bool, 0644);
+MODULE_PARM_DESC(ai_context_zswap, "Proactively compress idle processes' cold memory into zswap");
+
+unsigned int ai_context_zswap_age_ms = 30000;
+module_param(ai_context_zswap_age_ms, uint, 0644);
+MODULE_PARM_DESC(ai_context_zswap_age_ms, "Time in ms a region must go untouched before it is compressed");
+
+unsigned int ai_context_zswap_cpu_ms = 10;
+module_param(ai_context_zswap_cpu_ms, uint, 0644);
+MODULE_PARM_DESC(ai_context_zswap_cpu_ms, "CPU time in ms per second for proactive compression, 0 for no limit");
+
+unsigned int ai_context_zswap_mb = 64;
+module_param(ai_context_zswap_mb, uint, 0644);
+MODULE_PARM_DESC(ai_context_zswap_mb, "MiB per second proactively compressed, 0 for no limit");
+
+bool ai_context_thp_boost = true;
+module_param(ai_context_thp_boost, bool, 0644);
+MODULE_PARM_DESC(ai_context_thp_boost, "Have khugepaged collapse processes' hot regions first, on their node");
+
+/* Serialises foreground changes */
+static DEFINE_MUTEX(ai_context_foreground_mutex);
+
 /* Helper Functions */
 static inline ktime_t ai_context_get_current_time(void)
 {
     return ktime_get();
 }
 
-static struct ai_process_context *ai_context_create_process_context(struct task_struct *task)
+static void ai_context_free_srcu(struct rcu_head *rcu)
+{
+    struct ai_process_context *ctx = container_of(rcu, struct ai_process_context, rcu);
+
+    aurora_task_features_put(ctx->features);
+    kfree(ctx);
+}
+
+static void ai_context_free_rcu(struct rcu_head *rcu)
+{
+    call_srcu(&ai_context_srcu, rcu, ai_context_free_srcu);
+}
+
+/*
+ * Until a forked task has used ai_context_lazy_cpu_ms of CPU, its task
+ * storage holds at most a seed: the parent's scores packed into the
+ * pointer value, tagged by the low bit. Seeds cost nothing at fork and
+ * have nothing to free, so short-lived processes stay cheap.
+ */
+#define AI_CONTEXT_SEED_TAG     1UL
+#define AI_CONTEXT_SEED_SHIFT   6       /* Q16 scores kept to 11 bits */
+#define AI_CONTEXT_SEED_BITS    11
+
+static inline bool ai_context_is_seed(const void *data)
+{
+    return (unsigned long)data & AI_CONTEXT_SEED_TAG;
+}
+
+static inline void *ai_context_mk_seed(u32 complexity, u32 predictability)
+{
+    unsigned long c = complexity >> AI_CONTEXT_SEED_SHIFT;
+    unsigned long p = predictability >> AI_CONTEXT_SEED_SHIFT;
+    
+    return (void *)((c << 1) | (p << (1 + AI_CONTEXT_SEED_BITS)) | AI_CONTEXT_SEED_TAG);
+}
+
+static inline void ai_context_seed_scores(const void *seed, u32 *complexity, u32 *predictability)
+{
+    unsigned long v = (unsigned long)seed >> 1;
+    unsigned long mask = (1UL << AI_CONTEXT_SEED_BITS) - 1;
+    
+    *complexity = (v & mask) << AI_CONTEXT_SEED_SHIFT;
+    *predictability = ((v >> AI_CONTEXT_SEED_BITS) & mask) << AI_CONTEXT_SEED_SHIFT;
+}
+
+/* The task's own context, if it is tracked. Caller holds rcu_read_lock() */
+static inline struct ai_process_context *ai_context_of(struct task_struct *task)
+{
+    void *data = sched_aurora_task_storage(task, SCHED_AURORA_STORAGE_CONTEXT);
+    struct ai_process_context *ctx;
+
+    if (!data || ai_context_is_seed(data))
+        return NULL;
+
+    ctx = data;
+    if (!READ_ONCE(ctx->active))
+        return NULL;
+
+    return ctx;
+}
+
+/* Whether an untracked task has run long enough to be worth a context */
+static inline bool ai_context_ran_enough(struct task_struct *task)
+{
+    return READ_ONCE(task->se.sum_exec_runtime) >=
+           (u64)ai_context_lazy_cpu_ms * NSEC_PER_MSEC;
+}
+
+static struct ai_process_context *ai_context_create_process_context(struct task_struct *task,
+                                                                    void *seed)
 {
     struct ai_process_context *ctx;
     
@@ -62,26 +204,35 @@ static struct ai_process_context *ai_context_create_process_context(struct task_
     if (!ctx)
         return NULL;
     
+    ctx->features = aurora_task_features_get(task, GFP_ATOMIC);
+    if (!ctx->features) {
+        kfree(ctx);
+        return NULL;
+    }
+    
     /* Initialize basic process information */
+    ctx->task = task;
     ctx->pid = task->pid;
     strncpy(ctx->comm, task->comm, TASK_COMM_LEN - 1);
     ctx->comm[TASK_COMM_LEN - 1] = '\0';
     
     /* Initialize tracking data */
-    ctx->memory_regions = kzalloc(sizeof(unsigned long) * 16, GFP_ATOMIC);
-    if (!ctx->memory_regions) {
-        kfree(ctx);
-        return NULL;
-    }
-    ctx->region_count = 0;
+    ctx->mem.preferred_node = NUMA_NO_NODE;
+    ewma_io_bw_init(&ctx->io_read_bw);
+    ewma_io_bw_init(&ctx->io_write_bw);
     
     /* Initialize timing data */
     ctx->last_cpu_update = ai_context_get_current_time();
     ctx->avg_context_switch_time = ktime_set(0, 0);
     
-    /* Initialize ML scores */
-    ctx->context_complexity_score = 0.5f;  /* Start with neutral complexity */
-    ctx->predictability_score = 0.5f;     /* Start with neutral predictability */
+    /* Initialize ML scores, from the parent's when forked from a tracked task */
+    if (seed) {
+        ai_context_seed_scores(seed, &ctx->context_complexity_score,
+                               &ctx->predictability_score);
+    } else {
+        ctx->context_complexity_score = AI_CONTEXT_FIXED_ONE / 2;  /* Start with neutral complexity */
+        ctx->predictability_score = AI_CONTEXT_FIXED_ONE / 2;     /* Start with neutral predictability */
+    }
     ctx->prediction_accuracy = 0;
     
     /* Initialize security context */
@@ -104,16 +255,17 @@ int ai_context_track_process(struct task_struct *task)
 {
     struct ai_process_context *ctx;
     unsigned long flags;
+    void *seed;
     
     if (!ai_ctx_mgr || !task)
         return -EINVAL;
     
     /* Check if we're already tracking this process */
-    ctx = ai_context_get_process(task->pid);
-    if (ctx) {
-        ctx->active = true;
+    rcu_read_lock();
+    seed = sched_aurora_task_storage(task, SCHED_AURORA_STORAGE_CONTEXT);
+    rcu_read_unlock();
+    if (seed && !ai_context_is_seed(seed))
         return 0;
-    }
     
     /* Check process limit */
     if (ai_ctx_mgr->total_processes_tracked >= ai_context_max_processes) {
@@ -123,13 +275,22 @@ int ai_context_track_process(struct task_struct *task)
     }
     
     /* Create new process context */
-    ctx = ai_context_create_process_context(task);
+    ctx = ai_context_create_process_context(task, seed);
     if (!ctx)
         return -ENOMEM;
     
-    /* Add to tracked processes list */
+    /*
+     * Attach to the task; another CPU may have raced us. Holding the
+     * list lock keeps the free callback out until the context is listed.
+     */
     spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
-    list_add_tail(&ctx->list, &ai_ctx_mgr->process_contexts);
+    if (!sched_aurora_task_storage_set(task, SCHED_AURORA_STORAGE_CONTEXT, seed, ctx)) {
+        spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
+        aurora_task_features_put(ctx->features);
+        kfree(ctx);
+        return 0;
+    }
+    list_add_tail_rcu(&ctx->list, &ai_ctx_mgr->process_contexts);
     ai_ctx_mgr->total_processes_tracked++;
     ai_ctx_mgr->active_processes++;
     spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
@@ -137,25 +298,36 @@ int ai_context_track_process(struct task_struct *task)
     return 0;
 }
 
-int ai_context_untrack_process(pid_t pid)
+/* Stop learning from an exited task; its context goes with the task */
+static bool ai_context_deactivate(struct ai_process_context *ctx)
 {
-    struct ai_process_context *ctx, *tmp;
     unsigned long flags;
+    bool found = false;
+    
+    spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
+    if (ctx->active) {
+        WRITE_ONCE(ctx->active, false);
+        ai_ctx_mgr->active_processes--;
+        found = true;
+    }
+    spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
+    
+    return found;
+}
+
+int ai_context_untrack_process(pid_t pid)
+{
+    struct ai_process_context *ctx;
     int found = 0;
     
     if (!ai_ctx_mgr)
         return -EINVAL;
     
-    spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
-    list_for_each_entry_safe(ctx, tmp, &ai_ctx_mgr->process_contexts, list) {
-        if (ctx->pid == pid) {
-            ctx->active = false;
-            ai_ctx_mgr->active_processes--;
-            found = 1;
-            break;
-        }
-    }
-    spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
+    rcu_read_lock();
+    ctx = ai_context_get_process(pid);
+    if (ctx)
+        found = ai_context_deactivate(ctx);
+    rcu_read_unlock();
     
     if (found && ai_context_debug_enabled)
         pr_info("AI Context: Untracking process %d\n", pid);
@@ -163,26 +335,56 @@ int ai_context_untrack_process(pid_t pid)
     return found ? 0 : -ENOENT;
 }
 
+/*
+ * Lock-free lookup by global pid. The caller must hold rcu_read_lock();
+ * the context stays valid until it leaves the read-side critical section.
+ */
 struct ai_process_context *ai_context_get_process(pid_t pid)
 {
-    struct ai_process_context *ctx, *found = NULL;
-    unsigned long flags;
+    struct task_struct *task;
     
     if (!ai_ctx_mgr)
         return NULL;
     
+    task = pid_task(find_pid_ns(pid, &init_pid_ns), PIDTYPE_PID);
+    if (!task)
+        return NULL;
+    
+    return ai_context_of(task);
+}
+
+/* Resolve a recorded pid; tasks found by pid are RCU protected */
+static struct task_struct *ai_context_record_task(pid_t pid)
+{
+    return pid_task(find_pid_ns(pid, &init_pid_ns), PIDTYPE_PID);
+}
+
+/*
+ * Task storage free callback, run when the tracked task is freed. This
+ * may be RCU callback context.
+ */
+static void ai_context_storage_free(struct task_struct *task, void *data)
+{
+    struct ai_process_context *ctx = data;
+    unsigned long flags;
+    
+    if (ai_context_is_seed(data))
+        return;
+    
     spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
-    list_for_each_entry(ctx, &ai_ctx_mgr->process_contexts, list) {
-        if (ctx->pid == pid && ctx->active) {
-            found = ctx;
-            break;
-        }
-    }
+    list_del_rcu(&ctx->list);
+    if (ctx->active)
+        ai_ctx_mgr->active_processes--;
+    ai_ctx_mgr->total_processes_tracked--;
     spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
     
-    return found;
+    call_rcu(&ctx->rcu, ai_context_free_rcu);
 }
 
+static struct sched_aurora_storage_ops ai_context_storage_ops = {
+    .free = ai_context_storage_free,
+};
+
 /* Context Analysis Functions */
 void ai_context_update_cpu_usage(struct ai_process_context *ctx, struct task_struct *task)
 {
@@ -203,8 +405,13 @@ void ai_context_update_cpu_usage(struct ai_process_context *ctx, struct task_str
         ctx->cpu_time_total = task->utime + task->stime;
         ctx->cpu_time_recent = task->utime + task->stime;
         
-        /* Calculate CPU utilization as percentage */
-        ctx->cpu_utilization = (unsigned int)((ctx->cpu_time_recent * 100) / time_delta);
+        /* Prefer the scheduler's sampled intensity when it tracks the task */
+        if (aurora_task_features_valid(ctx->features, AURORA_FEATURE_SCHED)) {
+            ctx->cpu_utilization = (READ_ONCE(ctx->features->cpu_intensity) * 100) >>
+                                   AURORA_FEATURE_SHIFT;
+        } else {
+            ctx->cpu_utilization = (unsigned int)((ctx->cpu_time_recent * 100) / time_delta);
+        }
         ctx->cpu_utilization = min(ctx->cpu_utilization, 100U);
         
         ctx->last_cpu_update = current_time;
@@ -213,101 +420,1106 @@ void ai_context_update_cpu_usage(struct ai_process_context *ctx, struct task_str
     spin_unlock_irqrestore(&ctx->lock, flags);
 }
 
+/*
+ * Refresh the resident set size. Hot and cold summaries come from the
+ * DAMON aggregation callback below.
+ */
 void ai_context_update_memory_usage(struct ai_process_context *ctx, struct task_struct *task)
 {
-    struct mm_struct *mm;
+    unsigned long rss = 0;
     unsigned long flags;
     
-    if (!ctx || !task || !task->mm)
+    if (!ctx || !task)
         return;
     
-    spin_lock_irqsave(&ctx->lock, flags);
+    /* task->mm is stable under task_lock() */
+    task_lock(task);
+    if (task->mm)
+        rss = get_mm_rss(task->mm);
+    task_unlock(task);
     
-    mm = task->mm;
+    spin_lock_irqsave(&ctx->lock, flags);
     ctx->memory_access_count++;
+    ctx->mem.rss_pages = rss;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+/*
+ * Placement hint for NUMA balancing and THP: the node holding most of
+ * the process's hot memory, and whether a hot region spans a huge page.
+ * Returns -ENODATA until DAMON has summarised the process.
+ */
+int ai_context_memory_hint(pid_t pid, int *preferred_node, bool *thp_candidate)
+{
+    struct ai_process_context *ctx;
+    unsigned long flags;
+    int ret = -ENOENT;
+    
+    rcu_read_lock();
+    ctx = ai_context_get_process(pid);
+    if (ctx) {
+        spin_lock_irqsave(&ctx->lock, flags);
+        if (ctx->mem.updated) {
+            *preferred_node = ctx->mem.preferred_node;
+            *thp_candidate = ctx->mem.thp_candidate;
+            ret = 0;
+        } else {
+            ret = -ENODATA;
+        }
+        spin_unlock_irqrestore(&ctx->lock, flags);
+    }
+    rcu_read_unlock();
+    
+    return ret;
+}
+EXPORT_SYMBOL(ai_context_memory_hint);
+
+#ifdef CONFIG_DAMON_VADDR
+#define AI_CONTEXT_DAMON_MAX_REGIONS    1000
+
+/*
+ * Fold one target's regions into @sum. A region is hot when it was seen
+ * accessed in at least a quarter of the samples of the last aggregation
+ * and cold when it was not seen accessed at all. Its bytes are charged to
+ * the node backing its sampling address, which DAMON already takes as
+ * representative of the region.
+ */
+static void ai_context_summarize_target(struct damon_ctx *dctx, struct damon_target *t,
+                                        struct ai_context_mem_summary *sum)
+{
+    unsigned int max_accesses = damon_max_nr_accesses(&dctx->attrs);
+    int *nids = dctx->callback.private;
+    struct damon_region *r;
+    unsigned long size, best = 0;
+    unsigned int i = 0, nr;
+    int nid;
+    
+    nr = damon_va_sample_nids(t, nids, AI_CONTEXT_DAMON_MAX_REGIONS);
+    
+    damon_for_each_region(r, t) {
+        size = damon_sz_region(r);
+        nid = i < nr ? nids[i] : NUMA_NO_NODE;
+        i++;
+        
+        sum->total_bytes += size;
+        sum->nr_regions++;
+        if (!r->nr_accesses) {
+            sum->cold_bytes += size;
+            continue;
+        }
+        if (r->nr_accesses * 4 < max_accesses)
+            continue;
+        
+        sum->hot_bytes += size;
+        sum->nr_hot_regions++;
+        sum->largest_hot_region = max(sum->largest_hot_region, size);
+        if (nid >= 0 && nid < AI_CONTEXT_MEM_NODES)
+            sum->node_hot_bytes[nid] += size;
+    }
+    
+    sum->preferred_node = NUMA_NO_NODE;
+    for (nid = 0; nid < AI_CONTEXT_MEM_NODES; nid++) {
+        if (sum->node_hot_bytes[nid] > best) {
+            best = sum->node_hot_bytes[nid];
+            sum->preferred_node = nid;
+        }
+    }
+    sum->thp_candidate = sum->largest_hot_region >= PMD_SIZE;
+}
+
+/*
+ * A process whose hot memory just grew into a PMD-sized region, or moved
+ * to another node, gets khugepaged's attention ahead of the round robin.
+ * Repeating this every aggregation would keep khugepaged rescanning the
+ * same mm, so only changes are passed on.
+ */
+static bool ai_context_thp_boost_needed(const struct ai_context_mem_summary *old,
+                                        const struct ai_context_mem_summary *sum)
+{
+    if (!sum->thp_candidate)
+        return false;
+    return !old->thp_candidate || old->preferred_node != sum->preferred_node;
+}
+
+/* Runs in the kdamond thread after every aggregation interval */
+static int ai_context_damon_after_aggregation(struct damon_ctx *dctx)
+{
+    struct ai_context_mem_summary sum;
+    struct ai_process_context *ctx;
+    struct damon_target *t;
+    struct task_struct *task;
+    struct mm_struct *mm;
+    unsigned long flags;
+    bool boost;
+    
+    damon_for_each_target(t, dctx) {
+        memset(&sum, 0, sizeof(sum));
+        ai_context_summarize_target(dctx, t, &sum);
+        sum.updated = ai_context_get_current_time();
+        mm = NULL;
+        
+        rcu_read_lock();
+        task = pid_task(t->pid, PIDTYPE_PID);
+        ctx = task ? ai_context_of(task) : NULL;
+        if (ctx) {
+            spin_lock_irqsave(&ctx->lock, flags);
+            sum.rss_pages = ctx->mem.rss_pages;
+            boost = ai_context_thp_boost_needed(&ctx->mem, &sum);
+            ctx->mem = sum;
+            spin_unlock_irqrestore(&ctx->lock, flags);
+            
+            if (boost && READ_ONCE(ai_context_thp_boost))
+                mm = get_task_mm(task);
+        }
+        rcu_read_unlock();
+        
+        if (mm) {
+            khugepaged_prioritise_mm(mm, sum.preferred_node);
+            mmput(mm);
+        }
+    }
+    
+    return 0;
+}
+
+/* vaddr targets do not drop their pid references themselves */
+static void ai_context_damon_destroy(struct damon_ctx *dctx)
+{
+    struct damon_target *t;
+    
+    damon_for_each_target(t, dctx)
+        put_pid(t->pid);
+    damon_destroy_ctx(dctx);
+}
+
+static void ai_context_damon_stop(void)
+{
+    if (!ai_ctx_mgr->damon)
+        return;
     
-    /* Track memory regions (simplified - real implementation would track more regions) */
-    if (ctx->region_count < 16) {
-        /* Track some memory regions for pattern analysis */
-        if (mm->start_code && mm->end_code) {
-            ctx->memory_regions[ctx->region_count++] = mm->start_code;
+    /* Fails harmlessly if kdamond already quit on dead targets */
+    damon_stop(&ai_ctx_mgr->damon, 1);
+    ai_context_damon_destroy(ai_ctx_mgr->damon);
+    ai_ctx_mgr->damon = NULL;
+}
+
+/*
+ * Point DAMON at the AI_CONTEXT_DAMON_TARGETS busiest user processes.
+ * DAMON cannot change targets of a running context, so this restarts it.
+ */
+static void ai_context_damon_retarget(void)
+{
+    struct damon_attrs attrs = {
+        .sample_interval = 5000,            /* 5 ms */
+        .aggr_interval = 100000,            /* 100 ms */
+        .ops_update_interval = 1000000,     /* 1 s */
+        .min_nr_regions = 10,
+        .max_nr_regions = AI_CONTEXT_DAMON_MAX_REGIONS,
+    };
+    unsigned int util[AI_CONTEXT_DAMON_TARGETS];
+    pid_t pids[AI_CONTEXT_DAMON_TARGETS];
+    struct ai_process_context *ctx;
+    struct damon_target *t;
+    struct damon_ctx *dctx;
+    unsigned int i, slot, nr = 0, added = 0;
+    struct pid *pid;
+    
+    if (!ai_ctx_mgr->damon_nids)
+        return;
+    
+    rcu_read_lock();
+    list_for_each_entry_rcu(ctx, &ai_ctx_mgr->process_contexts, list) {
+        if (!ctx->active || !READ_ONCE(ctx->mem.rss_pages))
+            continue;
+        
+        if (nr < AI_CONTEXT_DAMON_TARGETS) {
+            slot = nr++;
+        } else {
+            for (slot = 0, i = 1; i < nr; i++) {
+                if (util[i] < util[slot])
+                    slot = i;
+            }
+            if (ctx->cpu_utilization <= util[slot])
+                continue;
+        }
+        pids[slot] = ctx->pid;
+        util[slot] = ctx->cpu_utilization;
+    }
+    rcu_read_unlock();
+    
+    ai_context_damon_stop();
+    if (!nr)
+        return;
+    
+    dctx = damon_new_ctx();
+    if (!dctx)
+        return;
+    if (damon_select_ops(dctx, DAMON_OPS_VADDR) || damon_set_attrs(dctx, &attrs))
+        goto destroy;
+    dctx->callback.after_aggregation = ai_context_damon_after_aggregation;
+    dctx->callback.private = ai_ctx_mgr->damon_nids;
+    
+    for (i = 0; i < nr; i++) {
+        rcu_read_lock();
+        pid = get_pid(find_pid_ns(pids[i], &init_pid_ns));
+        rcu_read_unlock();
+        if (!pid)
+            continue;
+        
+        t = damon_new_target();
+        if (!t) {
+            put_pid(pid);
+            break;
+        }
+        t->pid = pid;
+        damon_add_target(dctx, t);
+        added++;
+    }
+    
+    if (!added || damon_start(&dctx, 1, false))
+        goto destroy;
+    
+    ai_ctx_mgr->damon = dctx;
+    return;
+    
+destroy:
+    ai_context_damon_destroy(dctx);
+}
+
+/*
+ * Proactive zswap. A second DAMON context follows the idle background
+ * processes with the largest resident sets and compresses their regions
+ * left untouched for ai_context_zswap_age_ms into zswap with DAMOS_ZSWAP.
+ * The scheme's quota bounds the work overall; each cgroup is further
+ * bounded by its memory.zswap.max and memory.zswap.budget, which the
+ * action checks before every mapping. Regions only age while the context
+ * runs, so unlike the monitoring context it is restarted only when the
+ * set of processes changes. Settings apply from the next restart.
+ */
+static bool ai_context_in_foreground(struct task_struct *task);
+static bool ai_context_mem_idle(struct ai_process_context *ctx);
+
+static int ai_context_zswap_cmp(const void *a, const void *b)
+{
+    return *(const pid_t *)a - *(const pid_t *)b;
+}
+
+static struct damos *ai_context_zswap_scheme(const struct damon_attrs *attrs)
+{
+    struct damos_access_pattern pattern = {
+        .min_sz_region = PAGE_SIZE,
+        .max_sz_region = ULONG_MAX,
+        .min_nr_accesses = 0,
+        .max_nr_accesses = 0,
+        .min_age_region = (u64)READ_ONCE(ai_context_zswap_age_ms) * USEC_PER_MSEC /
+                          attrs->aggr_interval,
+        .max_age_region = UINT_MAX,
+    };
+    struct damos_quota quota = {
+        .ms = READ_ONCE(ai_context_zswap_cpu_ms),
+        .sz = (unsigned long)READ_ONCE(ai_context_zswap_mb) << 20,
+        .reset_interval = 1000,
+        /* Compress the longest untouched regions first */
+        .weight_age = 1,
+    };
+    struct damos_watermarks wmarks = {
+        .metric = DAMOS_WMARK_NONE,
+    };
+    
+    return damon_new_scheme(&pattern, DAMOS_ZSWAP, &quota, &wmarks);
+}
+
+static void ai_context_zswap_stop(void)
+{
+    if (!ai_ctx_mgr->zswap)
+        return;
+    
+    damon_stop(&ai_ctx_mgr->zswap, 1);
+    ai_context_damon_destroy(ai_ctx_mgr->zswap);
+    ai_ctx_mgr->zswap = NULL;
+    ai_ctx_mgr->zswap_nr = 0;
+}
+
+static void ai_context_zswap_retarget(void)
+{
+    struct damon_attrs attrs = {
+        .sample_interval = 20000,           /* 20 ms */
+        .aggr_interval = 1000000,           /* 1 s */
+        .ops_update_interval = 10000000,    /* 10 s */
+        .min_nr_regions = 10,
+        .max_nr_regions = AI_CONTEXT_DAMON_MAX_REGIONS,
+    };
+    unsigned long rss[AI_CONTEXT_ZSWAP_TARGETS], pages;
+    pid_t pids[AI_CONTEXT_ZSWAP_TARGETS];
+    struct ai_process_context *ctx;
+    struct task_struct *task;
+    struct damon_target *t;
+    struct damon_ctx *dctx;
+    struct damos *scheme;
+    unsigned int i, slot, nr = 0;
+    struct pid *pid;
+    
+    if (!READ_ONCE(ai_context_zswap)) {
+        ai_context_zswap_stop();
+        return;
+    }
+    
+    rcu_read_lock();
+    list_for_each_entry_rcu(ctx, &ai_ctx_mgr->process_contexts, list) {
+        pages = READ_ONCE(ctx->mem.rss_pages);
+        if (!ctx->active || !pages || !ai_context_mem_idle(ctx))
+            continue;
+        task = ai_context_record_task(ctx->pid);
+        if (!task || ai_context_in_foreground(task))
+            continue;
+        
+        if (nr < AI_CONTEXT_ZSWAP_TARGETS) {
+            slot = nr++;
+        } else {
+            for (slot = 0, i = 1; i < nr; i++) {
+                if (rss[i] < rss[slot])
+                    slot = i;
+            }
+            if (pages <= rss[slot])
+                continue;
+        }
+        pids[slot] = ctx->pid;
+        rss[slot] = pages;
+    }
+    rcu_read_unlock();
+    
+    sort(pids, nr, sizeof(pids[0]), ai_context_zswap_cmp, NULL);
+    if (ai_ctx_mgr->zswap && nr == ai_ctx_mgr->zswap_nr &&
+        !memcmp(pids, ai_ctx_mgr->zswap_pids, nr * sizeof(pids[0])))
+        return;
+    
+    ai_context_zswap_stop();
+    if (!nr)
+        return;
+    
+    dctx = damon_new_ctx();
+    if (!dctx)
+        return;
+    if (damon_select_ops(dctx, DAMON_OPS_VADDR) || damon_set_attrs(dctx, &attrs))
+        goto destroy;
+    
+    scheme = ai_context_zswap_scheme(&attrs);
+    if (!scheme)
+        goto destroy;
+    damon_set_schemes(dctx, &scheme, 1);
+    
+    for (i = 0; i < nr; i++) {
+        rcu_read_lock();
+        pid = get_pid(find_pid_ns(pids[i], &init_pid_ns));
+        rcu_read_unlock();
+        if (!pid)
+            continue;
+        
+        t = damon_new_target();
+        if (!t) {
+            put_pid(pid);
+            break;
         }
+        t->pid = pid;
+        damon_add_target(dctx, t);
+    }
+    
+    if (damon_targets_empty(dctx) || damon_start(&dctx, 1, false))
+        goto destroy;
+    
+    ai_ctx_mgr->zswap = dctx;
+    memcpy(ai_ctx_mgr->zswap_pids, pids, nr * sizeof(pids[0]));
+    ai_ctx_mgr->zswap_nr = nr;
+    return;
+    
+destroy:
+    ai_context_damon_destroy(dctx);
+}
+
+static int ai_context_damon_init(void)
+{
+    ai_ctx_mgr->damon_nids = kmalloc_array(AI_CONTEXT_DAMON_MAX_REGIONS,
+                                           sizeof(int), GFP_KERNEL);
+    return ai_ctx_mgr->damon_nids ? 0 : -ENOMEM;
+}
+
+static void ai_context_damon_exit(void)
+{
+    ai_context_zswap_stop();
+    ai_context_damon_stop();
+    kfree(ai_ctx_mgr->damon_nids);
+    ai_ctx_mgr->damon_nids = NULL;
+}
+#else
+static inline void ai_context_damon_retarget(void) { }
+static inline void ai_context_zswap_retarget(void) { }
+static inline int ai_context_damon_init(void) { return 0; }
+static inline void ai_context_damon_exit(void) { }
+#endif /* CONFIG_DAMON_VADDR */
+
+/* Storage bytes with CONFIG_TASK_IO_ACCOUNTING, else read()/write() bytes */
+static inline u64 ai_context_ioac_read_bytes(const struct task_io_accounting *ioac)
+{
+#if defined(CONFIG_TASK_IO_ACCOUNTING)
+    return ioac->read_bytes;
+#elif defined(CONFIG_TASK_XACCT)
+    return ioac->rchar;
+#else
+    return 0;
+#endif
+}
+
+static inline u64 ai_context_ioac_write_bytes(const struct task_io_accounting *ioac)
+{
+#if defined(CONFIG_TASK_IO_ACCOUNTING)
+    return ioac->write_bytes;
+#elif defined(CONFIG_TASK_XACCT)
+    return ioac->wchar;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Fold the task's IO counters since the previous learning run into the
+ * bandwidth averages. The counters only grow and are read racily; a torn
+ * read costs one sample.
+ */
+void ai_context_update_io_stats(struct ai_process_context *ctx, struct task_struct *task)
+{
+    struct task_io_accounting ioac;
+    u64 rbytes, wbytes, elapsed;
+    ktime_t now;
+    unsigned long flags;
+    
+    if (!ctx || !task)
+        return;
+    
+    ioac = task->ioac;
+    rbytes = ai_context_ioac_read_bytes(&ioac);
+    wbytes = ai_context_ioac_write_bytes(&ioac);
+    now = ai_context_get_current_time();
+    
+    spin_lock_irqsave(&ctx->lock, flags);
+    
+    elapsed = ktime_to_ms(ktime_sub(now, ctx->last_io_update));
+    if (ctx->last_io_update && elapsed &&
+        rbytes >= ctx->io_bytes_read && wbytes >= ctx->io_bytes_written) {
+        ewma_io_bw_add(&ctx->io_read_bw,
+                       div64_u64((rbytes - ctx->io_bytes_read) * MSEC_PER_SEC, elapsed));
+        ewma_io_bw_add(&ctx->io_write_bw,
+                       div64_u64((wbytes - ctx->io_bytes_written) * MSEC_PER_SEC, elapsed));
     }
     
+    ctx->io_bytes_read = rbytes;
+    ctx->io_bytes_written = wbytes;
+#ifdef CONFIG_TASK_XACCT
+    ctx->io_read_count = ioac.syscr;
+    ctx->io_write_count = ioac.syscw;
+#endif
+    ctx->last_io_update = now;
+    
     spin_unlock_irqrestore(&ctx->lock, flags);
 }
 
+/*
+ * IO priority hints for tasks that never chose an IO priority: the
+ * foreground application gets the lowest real-time level, so its reads
+ * are dispatched ahead of background indexing and updates by mq-deadline
+ * and BFQ, and bulk writers get the lowest best-effort level. A task's
+ * own ioprio_set() overrides the hint and the blk-ioprio policy of its
+ * cgroup bounds it. Caller holds rcu_read_lock().
+ */
+#ifdef CONFIG_BLOCK
+#define AI_CONTEXT_IOPRIO_FOREGROUND    IOPRIO_PRIO_VALUE(IOPRIO_CLASS_RT, IOPRIO_BE_NR - 1)
+#define AI_CONTEXT_IOPRIO_BULK          IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, IOPRIO_BE_NR - 1)
+
+static void ai_context_set_io_hint(struct ai_process_context *ctx, struct task_struct *task,
+                                   u16 prio)
+{
+    if (ctx->io_prio_hint != prio && !set_task_ioprio_hint(task, prio))
+        ctx->io_prio_hint = prio;
+}
+#else
+static inline void ai_context_set_io_hint(struct ai_process_context *ctx,
+                                          struct task_struct *task, u16 prio) { }
+#endif
+
+/*
+ * Pass the bandwidth on: to the shared task features, where the
+ * scheduler picks it up as IO intensity, and to the block layer as an
+ * IO priority hint, see ai_context_set_io_hint().
+ */
+static void ai_context_apply_io_hints(struct ai_process_context *ctx, struct task_struct *task)
+{
+    unsigned long read_bw = ewma_io_bw_read(&ctx->io_read_bw);
+    unsigned long write_bw = ewma_io_bw_read(&ctx->io_write_bw);
+#ifdef CONFIG_BLOCK
+    u16 prio = IOPRIO_DEFAULT;
+#endif
+    
+    WRITE_ONCE(ctx->features->io_bandwidth,
+               min(read_bw + write_bw, AI_CONTEXT_IO_BOUND_BW) * AURORA_FEATURE_ONE /
+               AI_CONTEXT_IO_BOUND_BW);
+    aurora_task_features_publish(ctx->features, AURORA_FEATURE_CONTEXT);
+    
+#ifdef CONFIG_BLOCK
+    if (ai_context_io_hints) {
+        if (ai_context_in_foreground(task))
+            prio = AI_CONTEXT_IOPRIO_FOREGROUND;
+        else if (write_bw >= AI_CONTEXT_IO_BULK_BW && ctx->cpu_utilization < 50)
+            prio = AI_CONTEXT_IOPRIO_BULK;
+    }
+    
+    ai_context_set_io_hint(ctx, task, prio);
+#endif
+}
+
+/* IO sampling for one context on the learning path */
+static void ai_context_sample_io(struct ai_process_context *ctx)
+{
+    struct task_struct *task = ai_context_record_task(ctx->pid);
+    
+    /* The pid may have been reused since the context was listed */
+    if (!task || sched_aurora_task_storage(task, SCHED_AURORA_STORAGE_CONTEXT) != ctx)
+        return;
+    
+    ai_context_update_io_stats(ctx, task);
+    ai_context_apply_io_hints(ctx, task);
+}
+
+/*
+ * Interactive grouping. On a desktop the TTY session autogroups mean
+ * little, so processes are grouped by what the user interacts with: the
+ * owner of the focused window, as reported by the compositor, and its
+ * descendants (helpers it spawned) share one boosted autogroup, while
+ * bulk IO and CPU-bound work elsewhere shares a throttled one. Other
+ * processes keep the autogroup they have until they were moved once.
+ */
+static bool ai_context_batch_like(struct ai_process_context *ctx)
+{
+    unsigned long bw = ewma_io_bw_read(&ctx->io_read_bw) + ewma_io_bw_read(&ctx->io_write_bw);
+    
+    return bw >= AI_CONTEXT_IO_BULK_BW || ctx->cpu_utilization >= AI_CONTEXT_BATCH_CPU;
+}
+
+/* Caller holds rcu_read_lock() */
+static bool ai_context_in_foreground(struct task_struct *task)
+{
+    pid_t tgid = READ_ONCE(ai_ctx_mgr->foreground_tgid);
+    u64 start = READ_ONCE(ai_ctx_mgr->foreground_start);
+    struct task_struct *p;
+    
+    if (!tgid)
+        return false;
+    
+    /* Reparenting only ever moves a process closer to init */
+    for (p = task->group_leader; p->pid > 1; p = rcu_dereference(p->real_parent)->group_leader) {
+        if (p->tgid == tgid)
+            return p->start_time == start;
+    }
+    return false;
+}
+
+static enum sched_aurora_group ai_context_group_of(struct ai_process_context *ctx,
+                                                   struct task_struct *task)
+{
+    if (!ai_context_grouping)
+        return SCHED_AURORA_GROUP_OWN;
+    if (ai_context_in_foreground(task))
+        return SCHED_AURORA_GROUP_FOREGROUND;
+    if (ai_context_batch_like(ctx))
+        return SCHED_AURORA_GROUP_BACKGROUND;
+    return SCHED_AURORA_GROUP_OWN;
+}
+
+/* Move the context's process to @group; may sleep */
+static void ai_context_move_group(struct ai_process_context *ctx, enum sched_aurora_group group)
+{
+    struct task_struct *task;
+    
+    rcu_read_lock();
+    task = ai_context_record_task(ctx->pid);
+    if (!task || sched_aurora_task_storage(task, SCHED_AURORA_STORAGE_CONTEXT) != ctx) {
+        rcu_read_unlock();
+        return;
+    }
+    if (group == SCHED_AURORA_NR_GROUPS)
+        group = ai_context_group_of(ctx, task);
+    if (group == ctx->sched_group) {
+        rcu_read_unlock();
+        return;
+    }
+    get_task_struct(task);
+    rcu_read_unlock();
+    
+    if (!sched_aurora_autogroup_move(task, group)) {
+        ctx->sched_group = group;
+        if (ai_context_debug_enabled)
+            pr_info("AI Context: PID %d moved to group %u\n", ctx->pid, group);
+    }
+    put_task_struct(task);
+}
+
+/* Unlike the learning run, a focus change moves the process right away */
+static int ai_context_set_foreground(pid_t nr)
+{
+    struct task_struct *task = NULL, *prev = NULL;
+    
+    rcu_read_lock();
+    if (nr) {
+        task = pid_task(find_vpid(nr), PIDTYPE_TGID);
+        if (!task) {
+            rcu_read_unlock();
+            return -ESRCH;
+        }
+        get_task_struct(task);
+    }
+    rcu_read_unlock();
+    
+    mutex_lock(&ai_context_foreground_mutex);
+    if (ai_ctx_mgr->foreground_tgid) {
+        rcu_read_lock();
+        prev = pid_task(find_pid_ns(ai_ctx_mgr->foreground_tgid, &init_pid_ns), PIDTYPE_TGID);
+        if (prev && prev->start_time == ai_ctx_mgr->foreground_start && prev != task)
+            get_task_struct(prev);
+        else
+            prev = NULL;
+        rcu_read_unlock();
+    }
+    
+    WRITE_ONCE(ai_ctx_mgr->foreground_tgid, task ? task->tgid : 0);
+    WRITE_ONCE(ai_ctx_mgr->foreground_start, task ? task->start_time : 0);
+    
+    /* Descendants follow on the next learning run */
+    if (prev && sched_aurora_autogroup_of(prev) == SCHED_AURORA_GROUP_FOREGROUND)
+        sched_aurora_autogroup_move(prev, SCHED_AURORA_GROUP_OWN);
+    if (task && READ_ONCE(ai_context_grouping))
+        sched_aurora_autogroup_move(task, SCHED_AURORA_GROUP_FOREGROUND);
+    mutex_unlock(&ai_context_foreground_mutex);
+    
+    if (prev)
+        put_task_struct(prev);
+    if (task)
+        put_task_struct(task);
+    return 0;
+}
+
+/*
+ * Put every process we moved back into an autogroup of its own and drop
+ * the IO priority hints we gave it
+ */
+static void ai_context_ungroup_all(void)
+{
+    struct ai_process_context *ctx;
+    struct task_struct *task;
+    int idx;
+    
+    idx = srcu_read_lock(&ai_context_srcu);
+    list_for_each_entry_srcu(ctx, &ai_ctx_mgr->process_contexts, list,
+                             srcu_read_lock_held(&ai_context_srcu)) {
+        if (ctx->sched_group != SCHED_AURORA_GROUP_OWN)
+            ai_context_move_group(ctx, SCHED_AURORA_GROUP_OWN);
+        
+        rcu_read_lock();
+        task = ai_context_record_task(ctx->pid);
+        if (task && sched_aurora_task_storage(task, SCHED_AURORA_STORAGE_CONTEXT) == ctx)
+            ai_context_set_io_hint(ctx, task, IOPRIO_DEFAULT);
+        rcu_read_unlock();
+        cond_resched();
+    }
+    srcu_read_unlock(&ai_context_srcu, idx);
+}
+
+/*
+ * Working-set hints. Every learning run tells the multi-gen LRU what the
+ * memcgs of tracked processes will do with their memory: one holding the
+ * foreground application is hot and keeps the pages it used within
+ * ai_context_hot_ttl_ms, one whose processes are all idle, on the CPU and
+ * in the DAMON regions, is cold and is reclaimed first. The hints lapse
+ * after AI_CONTEXT_LRU_HINT_RUNS intervals, so memcgs no longer seen, or
+ * all of them once the module is gone, fall back to the global policy.
+ */
+static bool ai_context_mem_idle(struct ai_process_context *ctx)
+{
+    /* Without a DAMON aggregation yet, CPU use alone decides */
+    return !ctx->cpu_utilization && (!ctx->mem.updated || !ctx->mem.hot_bytes);
+}
+
+#ifdef CONFIG_MEMCG
+struct ai_context_lru_memcg {
+    struct mem_cgroup *memcg;
+    bool hot;
+    bool active;
+};
+
+static void ai_context_lru_hint_all(void)
+{
+    struct ai_context_lru_memcg *m, memcgs[AI_CONTEXT_LRU_MEMCGS];
+    unsigned long timeout = msecs_to_jiffies(AI_CONTEXT_LRU_HINT_RUNS *
+                                             READ_ONCE(ai_context_learning_interval));
+    unsigned long ttl = msecs_to_jiffies(READ_ONCE(ai_context_hot_ttl_ms));
+    struct ai_process_context *ctx;
+    struct task_struct *task;
+    struct mem_cgroup *memcg;
+    unsigned int i, nr = 0;
+    int idx;
+    
+    if (!READ_ONCE(ai_context_lru_hints) || mem_cgroup_disabled())
+        return;
+    
+    idx = srcu_read_lock(&ai_context_srcu);
+    list_for_each_entry_srcu(ctx, &ai_ctx_mgr->process_contexts, list,
+                             srcu_read_lock_held(&ai_context_srcu)) {
+        if (!ctx->active)
+            continue;
+        
+        rcu_read_lock();
+        task = ai_context_record_task(ctx->pid);
+        memcg = task ? mem_cgroup_from_task(task) : NULL;
+        if (!memcg || mem_cgroup_is_root(memcg))
+            goto next;
+        
+        for (i = 0; i < nr && memcgs[i].memcg != memcg; i++)
+            ;
+        if (i == nr) {
+            if (nr == AI_CONTEXT_LRU_MEMCGS || !css_tryget_online(&memcg->css))
+                goto next;
+            memcgs[nr++] = (struct ai_context_lru_memcg){ .memcg = memcg };
+        }
+        memcgs[i].hot |= ai_context_in_foreground(task);
+        memcgs[i].active |= !ai_context_mem_idle(ctx);
+next:
+        rcu_read_unlock();
+    }
+    srcu_read_unlock(&ai_context_srcu, idx);
+    
+    for (m = memcgs; m < memcgs + nr; m++) {
+        if (m->hot)
+            lru_gen_set_hint(m->memcg, LRU_GEN_HINT_HOT, ttl, timeout);
+        else if (!m->active)
+            lru_gen_set_hint(m->memcg, LRU_GEN_HINT_COLD, 0, timeout);
+        else
+            lru_gen_set_hint(m->memcg, LRU_GEN_HINT_NONE, 0, timeout);
+        css_put(&m->memcg->css);
+    }
+}
+#else
+static inline void ai_context_lru_hint_all(void) { }
+#endif /* CONFIG_MEMCG */
+
+/*
+ * Feature pipeline. Features of a batch of contexts are gathered into
+ * arrays, scored by straight-line integer loops over those arrays and
+ * scattered back, so scoring is independent of the context layout.
+ */
+struct ai_context_features {
+    unsigned int nr;
+    struct ai_process_context *ctx[AI_CONTEXT_SCORE_BATCH];
+    u32 memory[AI_CONTEXT_SCORE_BATCH];
+    u32 io[AI_CONTEXT_SCORE_BATCH];
+    u32 cpu[AI_CONTEXT_SCORE_BATCH];
+    u32 stability[AI_CONTEXT_SCORE_BATCH];
+    u32 complexity[AI_CONTEXT_SCORE_BATCH];
+    u32 predictability[AI_CONTEXT_SCORE_BATCH];
+};
+
+static void ai_context_gather_features(struct ai_context_features *f,
+                                       struct ai_process_context *ctx)
+{
+    unsigned int i = f->nr++;
+    unsigned long io_ops = ctx->io_read_count + ctx->io_write_count;
+    unsigned int cpu = min(ctx->cpu_utilization, 100U);
+    
+    f->ctx[i] = ctx;
+    
+    /* Higher complexity if: many hot memory regions, high I/O, irregular CPU usage */
+    f->memory[i] = min(ctx->mem.nr_hot_regions, 16U) << (AI_CONTEXT_FIXED_SHIFT - 4);
+    f->io[i] = min(io_ops, 1000UL) * AI_CONTEXT_FIXED_ONE / 1000;
+    f->cpu[i] = abs((int)cpu - 50) * AI_CONTEXT_FIXED_ONE / 50;  /* Distance from 50% */
+    f->stability[i] = ctx->anomaly_count ? AI_CONTEXT_FIXED_ONE / 2 : AI_CONTEXT_FIXED_ONE;
+}
+
+static void ai_context_score_batch(struct ai_context_features *f)
+{
+    unsigned int i;
+    
+    for (i = 0; i < f->nr; i++)
+        f->complexity[i] = (f->memory[i] + f->io[i] + f->cpu[i]) / 3;
+    
+    /* Higher predictability if: regular patterns, low complexity */
+    for (i = 0; i < f->nr; i++)
+        f->predictability[i] = (AI_CONTEXT_FIXED_ONE - f->complexity[i] + f->stability[i]) >> 1;
+}
+
+static void ai_context_scatter_scores(struct ai_context_features *f)
+{
+    struct ai_process_context *ctx;
+    unsigned int i;
+    
+    for (i = 0; i < f->nr; i++) {
+        ctx = f->ctx[i];
+        WRITE_ONCE(ctx->context_complexity_score, f->complexity[i]);
+        WRITE_ONCE(ctx->predictability_score, f->predictability[i]);
+        
+        trace_aurora_context_score(ctx->pid, AI_CONTEXT_FIXED_PCT(f->complexity[i]),
+                                   AI_CONTEXT_FIXED_PCT(f->predictability[i]));
+    }
+}
+
 void ai_context_analyze_patterns(struct ai_process_context *ctx)
 {
+    struct ai_context_features f;
     unsigned long flags;
     
     if (!ctx)
         return;
     
+    f.nr = 0;
     spin_lock_irqsave(&ctx->lock, flags);
+    ai_context_gather_features(&f, ctx);
+    spin_unlock_irqrestore(&ctx->lock, flags);
     
-    /* Calculate context complexity score */
-    /* Higher complexity if: many memory regions, high I/O, irregular CPU usage */
-    float memory_factor = min(ctx->region_count / 16.0f, 1.0f);
-    float io_factor = min((ctx->io_read_count + ctx->io_write_count) / 1000.0f, 1.0f);
-    float cpu_variability = abs(ctx->cpu_utilization - 50) / 50.0f;  /* Distance from 50% */
+    ai_context_score_batch(&f);
+    ai_context_scatter_scores(&f);
+}
+
+/* Score a gathered batch and run security analysis on the fresh scores */
+static void ai_context_flush_batch(struct ai_context_features *f)
+{
+    unsigned int i;
     
-    ctx->context_complexity_score = (memory_factor + io_factor + cpu_variability) / 3.0f;
+    ai_context_score_batch(f);
+    ai_context_scatter_scores(f);
     
-    /* Calculate predictability score */
-    /* Higher predictability if: regular patterns, low complexity */
-    float regularity_factor = 1.0f - ctx->context_complexity_score;
-    float stability_factor = ctx->anomaly_count > 0 ? 0.5f : 1.0f;
+    for (i = 0; i < f->nr; i++)
+        ai_context_security_analyze(f->ctx[i]);
+    f->nr = 0;
+}
+
+/*
+ * Score every active context in batches of AI_CONTEXT_SCORE_BATCH,
+ * yielding the CPU between batches so large hosts do not stall.
+ */
+static void ai_context_analyze_all(void)
+{
+    struct ai_context_prediction pred;
+    struct ai_context_features f;
+    struct ai_process_context *ctx;
+    int idx;
+    
+    f.nr = 0;
+    
+    idx = srcu_read_lock(&ai_context_srcu);
+    list_for_each_entry_srcu(ctx, &ai_ctx_mgr->process_contexts, list,
+                             srcu_read_lock_held(&ai_context_srcu)) {
+        if (!ctx->active)
+            continue;
+        
+        rcu_read_lock();
+        ai_context_sample_io(ctx);
+        rcu_read_unlock();
+        
+        ai_context_move_group(ctx, SCHED_AURORA_NR_GROUPS);
+        
+        /* Keep a prediction outstanding so the model is scored */
+        ai_context_predict_next_switch(ctx, &pred);
+        
+        ai_context_gather_features(&f, ctx);
+        if (f.nr == AI_CONTEXT_SCORE_BATCH) {
+            ai_context_flush_batch(&f);
+            cond_resched();
+        }
+    }
+    if (f.nr)
+        ai_context_flush_batch(&f);
+    srcu_read_unlock(&ai_context_srcu, idx);
+}
+
+/* Prediction Engine */
+
+/*
+ * Inter-switch interval model over the switch history. The intervals
+ * are bucketed by log2; the prediction is the mean of the fullest
+ * bucket and the confidence is the share of intervals that fell in it.
+ * Returns 0 with less than AI_CONTEXT_MIN_INTERVALS intervals. Caller
+ * holds ctx->lock.
+ */
+static u64 ai_context_model_interval(struct ai_process_context *ctx, unsigned int *confidence)
+{
+    u8 count[AI_CONTEXT_INTERVAL_BUCKETS] = { };
+    u64 sum[AI_CONTEXT_INTERVAL_BUCKETS] = { };
+    unsigned int i, cur, prev, bucket, best = 0, n = 0;
+    s64 delta;
+    
+    /* Oldest to newest; switch_history_index is the oldest slot */
+    for (i = 1; i < AI_CONTEXT_HISTORY_SIZE; i++) {
+        cur = (ctx->switch_history_index + i) % AI_CONTEXT_HISTORY_SIZE;
+        prev = (cur + AI_CONTEXT_HISTORY_SIZE - 1) % AI_CONTEXT_HISTORY_SIZE;
+        if (!ctx->context_switch_times[prev] || !ctx->context_switch_times[cur])
+            continue;
+        
+        delta = ktime_to_ns(ktime_sub(ctx->context_switch_times[cur],
+                                      ctx->context_switch_times[prev]));
+        if (delta <= 0)
+            continue;
+        
+        bucket = min_t(unsigned int, ilog2(delta), AI_CONTEXT_INTERVAL_BUCKETS - 1);
+        count[bucket]++;
+        sum[bucket] += delta;
+        n++;
+    }
+    
+    if (n < AI_CONTEXT_MIN_INTERVALS)
+        return 0;
+    
+    for (i = 1; i < AI_CONTEXT_INTERVAL_BUCKETS; i++) {
+        if (count[i] > count[best])
+            best = i;
+    }
+    
+    *confidence = count[best] * 100 / n;
+    return div64_u64(sum[best], count[best]);
+}
+
+/*
+ * Fold one scored prediction into the context's accuracy. Counts are
+ * halved past 256 so the accuracy follows recent behaviour. Caller
+ * holds ctx->lock.
+ */
+static void ai_context_score_prediction(struct ai_process_context *ctx, bool hit)
+{
+    unsigned int total;
+    
+    if (hit) {
+        ctx->prediction_hits++;
+        atomic64_inc(&ai_ctx_mgr->prediction_hits);
+    } else {
+        ctx->prediction_misses++;
+        atomic64_inc(&ai_ctx_mgr->prediction_misses);
+    }
+    
+    total = ctx->prediction_hits + ctx->prediction_misses;
+    if (total > 256) {
+        ctx->prediction_hits >>= 1;
+        ctx->prediction_misses >>= 1;
+        total = ctx->prediction_hits + ctx->prediction_misses;
+    }
+    ctx->prediction_accuracy = ctx->prediction_hits * 100 / total;
+}
+
+/* Confidence of a model prediction, capped by how well the model has done */
+static unsigned int ai_context_prediction_confidence(struct ai_process_context *ctx,
+                                                     unsigned int model_confidence)
+{
+    if (ctx->prediction_hits + ctx->prediction_misses < AI_CONTEXT_MIN_INTERVALS * 2)
+        return model_confidence;
     
-    ctx->predictability_score = (regularity_factor + stability_factor) / 2.0f;
+    return min(model_confidence, ctx->prediction_accuracy);
+}
+
+/*
+ * Predict when @ctx is next switched out. The prediction stays
+ * outstanding and is scored as a hit if the actual interval is within
+ * 25% of the predicted one.
+ */
+int ai_context_predict_next_switch(struct ai_process_context *ctx, struct ai_context_prediction *pred)
+{
+    unsigned int last, confidence = 0;
+    unsigned long flags;
+    u64 interval;
+    
+    if (!ctx || !pred)
+        return -EINVAL;
+    
+    spin_lock_irqsave(&ctx->lock, flags);
+    
+    last = (ctx->switch_history_index + AI_CONTEXT_HISTORY_SIZE - 1) % AI_CONTEXT_HISTORY_SIZE;
+    interval = ai_context_model_interval(ctx, &confidence);
+    if (interval) {
+        ctx->predicted_interval = interval;
+        confidence = ai_context_prediction_confidence(ctx, confidence);
+        pred->predicted_next_switch = ktime_add_ns(ctx->context_switch_times[last], interval);
+    } else {
+        pred->predicted_next_switch = 0;
+    }
+    
+    pred->pid = ctx->pid;
+    pred->confidence = confidence;
+    pred->is_prediction_valid = interval && confidence >= ai_context_prediction_threshold;
+    pred->predicted_memory_usage = ctx->mem.rss_pages << PAGE_SHIFT;
+    pred->predicted_cpu_usage = ctx->cpu_utilization;
+    
+    spin_unlock_irqrestore(&ctx->lock, flags);
+    
+    atomic_inc(&ai_ctx_mgr->predictions_made);
+    
+    return 0;
+}
+
+/* Feedback from a consumer that checked @pred against what happened */
+void ai_context_update_prediction_accuracy(struct ai_context_prediction *pred, bool was_correct)
+{
+    struct ai_process_context *ctx;
+    unsigned long flags;
+    
+    if (!ai_ctx_mgr || !pred)
+        return;
     
-    if (ai_context_debug_enabled && (ctx->predictability_score < 0.3f || ctx->context_complexity_score > 0.7f)) {
-        pr_info("AI Context: PID %d - Complexity: %.2f, Predictability: %.2f\n",
-                ctx->pid, ctx->context_complexity_score, ctx->predictability_score);
+    rcu_read_lock();
+    ctx = ai_context_get_process(pred->pid);
+    if (ctx) {
+        spin_lock_irqsave(&ctx->lock, flags);
+        ai_context_score_prediction(ctx, was_correct);
+        spin_unlock_irqrestore(&ctx->lock, flags);
     }
-    
-    spin_unlock_irqrestore(&ctx->lock, flags);
+    rcu_read_unlock();
 }
 
-/* Prediction Engine */
-int ai_context_predict_next_switch(struct ai_process_context *ctx, struct ai_context_prediction *pred)
+int ai_context_predict_resource_usage(struct ai_process_context *ctx, unsigned long *memory, unsigned int *cpu)
 {
-    ktime_t avg_switch_time;
     unsigned long flags;
-    int confidence;
     
-    if (!ctx || !pred)
+    if (!ctx || !memory || !cpu)
         return -EINVAL;
     
     spin_lock_irqsave(&ctx->lock, flags);
+    *memory = ctx->mem.rss_pages << PAGE_SHIFT;
+    *cpu = ctx->cpu_utilization;
+    spin_unlock_irqrestore(&ctx->lock, flags);
     
-    /* Simple prediction based on average context switch time */
-    avg_switch_time = ctx->avg_context_switch_time;
-    
-    /* Add some randomness for variety */
-    if (avg_switch_time.tv64 > 0) {
-        u64 random_factor = get_random_u32() % 20 - 10;  /* +/- 10% variance */
-        s64 adjusted_time = avg_switch_time.tv64 * (100 + random_factor) / 100;
-        pred->predicted_next_switch = ktime_set(0, adjusted_time);
-    } else {
-        pred->predicted_next_switch = ktime_set(0, 10000000);  /* Default 10ms */
-    }
-    
-    /* Calculate confidence based on predictability score */
-    confidence = (int)(ctx->predictability_score * 100);
-    pred->confidence = confidence;
-    pred->is_prediction_valid = (confidence >= ai_context_prediction_threshold);
-    
-    pred->pid = ctx->pid;
-    pred->predicted_memory_usage = 1024 * 1024;  /* Simple prediction */
-    pred->predicted_cpu_usage = ctx->cpu_utilization;
+    return 0;
+}
+
+/*
+ * Expected run between switch-outs of @pid in ns, or 0 when the model
+ * is not confident enough. Meant for sizing the task's slice.
+ */
+u64 ai_context_predict_interval(pid_t pid)
+{
+    struct ai_process_context *ctx;
+    unsigned int confidence = 0;
+    unsigned long flags;
+    u64 interval = 0;
     
-    spin_unlock_irqrestore(&ctx->lock, flags);
+    if (!ai_ctx_mgr)
+        return 0;
     
-    ai_ctx_mgr->predictions_made++;
+    rcu_read_lock();
+    ctx = ai_context_get_process(pid);
+    if (ctx) {
+        spin_lock_irqsave(&ctx->lock, flags);
+        interval = ai_context_model_interval(ctx, &confidence);
+        if (interval &&
+            ai_context_prediction_confidence(ctx, confidence) < ai_context_prediction_threshold)
+            interval = 0;
+        spin_unlock_irqrestore(&ctx->lock, flags);
+    }
+    rcu_read_unlock();
     
-    return 0;
+    return interval;
 }
+EXPORT_SYMBOL(ai_context_predict_interval);
 
 /* Security Monitoring */
 int ai_context_security_analyze(struct ai_process_context *ctx)
@@ -321,7 +1533,7 @@ int ai_context_security_analyze(struct ai_process_context *ctx)
     spin_lock_irqsave(&ctx->lock, flags);
     
     /* Check for suspicious patterns */
-    if (ctx->context_complexity_score > 0.8f) {
+    if (ctx->context_complexity_score > AI_CONTEXT_FIXED(4, 5)) {
         new_flags |= AI_CONTEXT_SECURITY_SUSPICIOUS;
     }
     
@@ -341,54 +1553,296 @@ int ai_context_security_analyze(struct ai_process_context *ctx)
     return new_flags;
 }
 
-/* Learning System */
-void ai_context_learning_work(struct work_struct *work)
+/* Account one switch-out of @ctx at @switch_time */
+static void ai_context_account_switch(struct ai_process_context *ctx, ktime_t switch_time)
 {
-    struct ai_process_context *ctx, *tmp;
+    unsigned int last;
+    ktime_t duration;
     unsigned long flags;
     
-    if (!ai_ctx_mgr)
-        return;
+    spin_lock_irqsave(&ctx->lock, flags);
     
-    /* Clean up inactive processes */
-    spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
-    list_for_each_entry_safe(ctx, tmp, &ai_ctx_mgr->process_contexts, list) {
-        if (!ctx->active) {
-            list_del(&ctx->list);
-            kfree(ctx->memory_regions);
-            kfree(ctx);
-            ai_ctx_mgr->total_processes_tracked--;
+    /* Calculate context switch duration */
+    last = (ctx->switch_history_index + AI_CONTEXT_HISTORY_SIZE - 1) % AI_CONTEXT_HISTORY_SIZE;
+    if (ctx->context_switch_times[last]) {
+        duration = ktime_sub(switch_time, ctx->context_switch_times[last]);
+        
+        /* Score the outstanding prediction against what happened */
+        if (ctx->predicted_interval) {
+            u64 error = abs(ktime_to_ns(duration) - (s64)ctx->predicted_interval);
+            
+            ai_context_score_prediction(ctx, error * 4 <= ctx->predicted_interval);
+            ctx->predicted_interval = 0;
+        }
+        
+        /* Update average context switch time */
+        if (ctx->avg_context_switch_time == 0)
+            ctx->avg_context_switch_time = duration;
+        else
+            ctx->avg_context_switch_time = (ctx->avg_context_switch_time + duration) / 2;
+        
+        if (ctx->avg_context_switch_time > 0) {
+            WRITE_ONCE(ctx->features->switch_rate,
+                       div64_u64(NSEC_PER_SEC, ktime_to_ns(ctx->avg_context_switch_time)));
+            aurora_task_features_publish(ctx->features, AURORA_FEATURE_CONTEXT);
         }
     }
-    spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
     
-    /* Analyze patterns for all active processes */
-    list_for_each_entry(ctx, &ai_ctx_mgr->process_contexts, list) {
-        if (ctx->active) {
-            ai_context_analyze_patterns(ctx);
-            ai_context_security_analyze(ctx);
+    /* Store switch time */
+    ctx->context_switch_times[ctx->switch_history_index] = switch_time;
+    ctx->switch_history_index = (ctx->switch_history_index + 1) % AI_CONTEXT_HISTORY_SIZE;
+    
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+/*
+ * Consume one CPU's switch records, AI_CONTEXT_DRAIN_BATCH at a time;
+ * returns the number consumed. Records added meanwhile wait for the
+ * next run.
+ */
+static unsigned int ai_context_drain_switch_ring(struct ai_context_switch_ring *ring)
+{
+    struct ai_context_switch_record *rec;
+    struct ai_process_context *ctx;
+    struct task_struct *task;
+    unsigned int head, tail, end, start;
+    
+    head = smp_load_acquire(&ring->head);
+    start = tail = ring->tail;
+    
+next_batch:
+    end = head - tail > AI_CONTEXT_DRAIN_BATCH ? tail + AI_CONTEXT_DRAIN_BATCH : head;
+    
+    rcu_read_lock();
+    for (; tail != end; tail++) {
+        rec = &ring->records[tail & (AI_CONTEXT_SWITCH_RING_SIZE - 1)];
+        
+        /* Track previous process */
+        task = ai_context_record_task(rec->pid);
+        ctx = task ? ai_context_of(task) : NULL;
+        if (ctx) {
+            ai_context_account_switch(ctx, rec->timestamp);
+            
+            /* Update process statistics */
+            ai_context_update_cpu_usage(ctx, task);
+            ai_context_update_memory_usage(ctx, task);
+        } else if (task && ai_context_ran_enough(task)) {
+            ai_context_track_process(task);
         }
+        
+        /* Auto-track new processes once they have run for a while */
+        task = ai_context_record_task(rec->next_pid);
+        if (task && !ai_context_of(task) && ai_context_ran_enough(task))
+            ai_context_track_process(task);
+    }
+    rcu_read_unlock();
+    
+    /* Hand the slots back to the switch hook */
+    smp_store_release(&ring->tail, tail);
+    
+    if (tail != head) {
+        cond_resched();
+        goto next_batch;
+    }
+    
+    return tail - start;
+}
+
+/* Summarise a learning run for the telemetry consumers */
+static void ai_context_emit_learning(u64 switches)
+{
+    struct aurora_telemetry_record *rec;
+    unsigned long flags;
+    
+    rec = aurora_telemetry_reserve(AURORA_TELEMETRY_CONTEXT_LEARN, 0, &flags);
+    if (!rec)
+        return;
+    
+    rec->arg = ai_ctx_mgr->active_processes;
+    rec->data[0] = switches;
+    rec->data[1] = ai_ctx_mgr->switch_records_dropped;
+    rec->data[2] = ai_ctx_mgr->total_processes_tracked;
+    aurora_telemetry_commit(rec, flags);
+}
+
+/*
+ * Learning System. Runs on the manager's unbound workqueue and requeues
+ * itself, so runs never overlap; ai_context_exit() cancels it.
+ */
+void ai_context_learning_work(struct work_struct *work)
+{
+    struct ai_context_switch_ring *ring;
+    u64 switches = 0, dropped = 0;
+    u64 start = ktime_get_ns();
+    int cpu;
+    
+    /* Exited processes are reclaimed when their task is freed */
+    
+    /* Fold in the context switches recorded since the last run */
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(ai_ctx_mgr->switch_rings, cpu);
+        switches += ai_context_drain_switch_ring(ring);
+        dropped += READ_ONCE(ring->dropped);
+    }
+    ai_ctx_mgr->total_context_switches += switches +
+        (dropped - ai_ctx_mgr->switch_records_dropped);
+    ai_ctx_mgr->switch_records_dropped = dropped;
+    
+    /* Analyze patterns for all active processes */
+    ai_context_analyze_all();
+    ai_context_snapshot_publish();
+    ai_context_lru_hint_all();
+    
+    /* Follow the busiest processes with DAMON, and the idle ones for zswap */
+    if (ai_ctx_mgr->damon_runs++ % AI_CONTEXT_DAMON_RETARGET == 0) {
+        ai_context_damon_retarget();
+        ai_context_zswap_retarget();
     }
     
     ai_ctx_mgr->last_learning_update = ai_context_get_current_time();
+    ai_context_emit_learning(switches);
+    trace_aurora_context_learn(switches, dropped, ai_ctx_mgr->active_processes,
+                               ktime_get_ns() - start);
     
     if (ai_context_debug_enabled)
         pr_info("AI Context: Learning update completed\n");
+    
+    queue_delayed_work(ai_ctx_mgr->learning_wq, &ai_ctx_mgr->learning_work,
+                       msecs_to_jiffies(ai_context_learning_interval));
+}
+
+/* Binary Snapshot */
+static int ai_context_snapshot_alloc(void)
+{
+    struct ai_context_snapshot_header *hdr;
+    unsigned int capacity = ai_context_max_processes;
+    size_t size;
+    
+    size = PAGE_ALIGN(sizeof(*hdr) +
+                      (size_t)capacity * sizeof(struct ai_context_snapshot_record));
+    hdr = vmalloc_user(size);
+    if (!hdr)
+        return -ENOMEM;
+    
+    hdr->magic = AI_CONTEXT_SNAPSHOT_MAGIC;
+    hdr->version = AI_CONTEXT_SNAPSHOT_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->record_size = sizeof(struct ai_context_snapshot_record);
+    hdr->capacity = capacity;
+    
+    ai_ctx_mgr->snapshot = hdr;
+    ai_ctx_mgr->snapshot_size = size;
+    return 0;
+}
+
+/*
+ * Pages mapped by readers hold their own references, so existing
+ * mappings stay valid after this; they just stop being updated.
+ */
+static void ai_context_snapshot_free(void)
+{
+    if (!ai_ctx_mgr->snapshot)
+        return;
+    
+    WRITE_ONCE(ai_ctx_mgr->snapshot->flags, AI_CONTEXT_SNAPSHOT_STALE);
+    vfree(ai_ctx_mgr->snapshot);
+    ai_ctx_mgr->snapshot = NULL;
+}
+
+static void ai_context_snapshot_fill(struct ai_context_snapshot_record *rec,
+                                     struct ai_process_context *ctx)
+{
+    unsigned long flags;
+    
+    spin_lock_irqsave(&ctx->lock, flags);
+    rec->pid = ctx->pid;
+    rec->security_flags = ctx->security_flags;
+    memcpy(rec->comm, ctx->comm, TASK_COMM_LEN);
+    rec->cpu_utilization = ctx->cpu_utilization;
+    rec->complexity = ctx->context_complexity_score;
+    rec->predictability = ctx->predictability_score;
+    rec->anomaly_count = ctx->anomaly_count;
+    rec->avg_switch_interval_ns = ktime_to_ns(ctx->avg_context_switch_time);
+    rec->rss_bytes = (u64)ctx->mem.rss_pages << PAGE_SHIFT;
+    rec->hot_bytes = ctx->mem.hot_bytes;
+    rec->cold_bytes = ctx->mem.cold_bytes;
+    rec->preferred_node = ctx->mem.preferred_node;
+    rec->mem_flags = ctx->mem.thp_candidate ? AI_CONTEXT_SNAPSHOT_MEM_THP : 0;
+    rec->io_read_bw = ewma_io_bw_read(&ctx->io_read_bw);
+    rec->io_write_bw = ewma_io_bw_read(&ctx->io_write_bw);
+    rec->io_bytes_read = ctx->io_bytes_read;
+    rec->io_bytes_written = ctx->io_bytes_written;
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+/* Rewrite the snapshot; only the learning work calls this */
+static void ai_context_snapshot_publish(void)
+{
+    struct ai_context_snapshot_header *hdr = ai_ctx_mgr->snapshot;
+    struct ai_context_snapshot_record *recs = (void *)hdr + sizeof(*hdr);
+    struct ai_process_context *ctx;
+    unsigned int nr = 0, skipped = 0;
+    
+    if (!hdr)
+        return;
+    
+    WRITE_ONCE(hdr->seq, hdr->seq + 1);
+    smp_wmb();
+    
+    rcu_read_lock();
+    list_for_each_entry_rcu(ctx, &ai_ctx_mgr->process_contexts, list) {
+        if (!ctx->active)
+            continue;
+        if (nr == hdr->capacity) {
+            skipped++;
+            continue;
+        }
+        ai_context_snapshot_fill(&recs[nr++], ctx);
+    }
+    rcu_read_unlock();
+    
+    hdr->nr_records = nr;
+    hdr->nr_skipped = skipped;
+    hdr->timestamp_ns = ktime_get_ns();
+    hdr->total_context_switches = ai_ctx_mgr->total_context_switches;
+    hdr->switch_records_dropped = ai_ctx_mgr->switch_records_dropped;
+    
+    smp_store_release(&hdr->seq, hdr->seq + 1);
+}
+
+static ssize_t ai_context_snapshot_read(struct file *file, char __user *buf,
+                                        size_t count, loff_t *ppos)
+{
+    if (!ai_ctx_mgr || !ai_ctx_mgr->snapshot)
+        return -ENODEV;
+    
+    return simple_read_from_buffer(buf, count, ppos, ai_ctx_mgr->snapshot,
+                                   ai_ctx_mgr->snapshot_size);
 }
 
-/* Learning Timer Callback */
-static void ai_context_learning_timer_callback(struct timer_list *timer)
+static int ai_context_snapshot_mmap(struct file *file, struct vm_area_struct *vma)
 {
-    static struct work_struct learning_work;
+    if (!ai_ctx_mgr || !ai_ctx_mgr->snapshot)
+        return -ENODEV;
     
-    /* Schedule learning work */
-    INIT_WORK(&learning_work, ai_context_learning_work);
-    schedule_work(&learning_work);
+    /* Readers only; the seq protocol relies on the kernel being the sole writer */
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    vma->vm_flags &= ~VM_MAYWRITE;
+    
+    if (vma->vm_end - vma->vm_start + (vma->vm_pgoff << PAGE_SHIFT) >
+        ai_ctx_mgr->snapshot_size)
+        return -EINVAL;
     
-    /* Reschedule timer */
-    mod_timer(timer, jiffies + msecs_to_jiffies(ai_context_learning_interval));
+    return remap_vmalloc_range(vma, ai_ctx_mgr->snapshot, vma->vm_pgoff);
 }
 
+static const struct proc_ops ai_context_snapshot_proc_ops = {
+    .proc_read = ai_context_snapshot_read,
+    .proc_mmap = ai_context_snapshot_mmap,
+    .proc_lseek = default_llseek,
+};
+
 /* ProcFS Interface */
 static int ai_context_proc_show_stats(struct seq_file *m, void *v)
 {
@@ -400,10 +1854,11 @@ static int ai_context_proc_show_stats(struct seq_file *m, void *v)
     seq_printf(m, "=== AI Context Manager Statistics ===\n");
     seq_printf(m, "Total Processes Tracked: %u\n", ai_ctx_mgr->total_processes_tracked);
     seq_printf(m, "Active Processes: %u\n", ai_ctx_mgr->active_processes);
-    seq_printf(m, "Predictions Made: %u\n", ai_ctx_mgr->predictions_made);
-    seq_printf(m, "Prediction Hits: %llu\n", ai_ctx_mgr->prediction_hits);
-    seq_printf(m, "Prediction Misses: %llu\n", ai_ctx_mgr->prediction_misses);
+    seq_printf(m, "Predictions Made: %u\n", atomic_read(&ai_ctx_mgr->predictions_made));
+    seq_printf(m, "Prediction Hits: %lld\n", atomic64_read(&ai_ctx_mgr->prediction_hits));
+    seq_printf(m, "Prediction Misses: %lld\n", atomic64_read(&ai_ctx_mgr->prediction_misses));
     seq_printf(m, "Total Context Switches: %llu\n", ai_ctx_mgr->total_context_switches);
+    seq_printf(m, "Switch Records Dropped: %llu\n", ai_ctx_mgr->switch_records_dropped);
     seq_printf(m, "Learning Interval: %u ms\n", ai_context_learning_interval);
     seq_printf(m, "Prediction Threshold: %u%%\n", ai_context_prediction_threshold);
     seq_printf(m, "Debug Mode: %s\n", ai_context_debug_enabled ? "Enabled" : "Disabled");
@@ -411,31 +1866,97 @@ static int ai_context_proc_show_stats(struct seq_file *m, void *v)
     return 0;
 }
 
-static int ai_context_proc_show_contexts(struct seq_file *m, void *v)
+/*
+ * One context per seq_file record, streamed rather than rendered whole
+ * into a single_open() buffer; the list head stands for the header.
+ */
+static void *ai_context_contexts_start(struct seq_file *m, loff_t *pos)
+    __acquires(RCU)
+{
+    rcu_read_lock();
+    return seq_list_start_head_rcu(&ai_ctx_mgr->process_contexts, *pos);
+}
+
+static void *ai_context_contexts_next(struct seq_file *m, void *v, loff_t *pos)
+{
+    return seq_list_next_rcu(v, &ai_ctx_mgr->process_contexts, pos);
+}
+
+static void ai_context_contexts_stop(struct seq_file *m, void *v)
+    __releases(RCU)
+{
+    rcu_read_unlock();
+}
+
+static int ai_context_contexts_show(struct seq_file *m, void *v)
 {
     struct ai_process_context *ctx;
     
-    if (!ai_ctx_mgr) {
-        seq_printf(m, "AI Context Manager not initialized\n");
+    if (v == &ai_ctx_mgr->process_contexts) {
+        seq_printf(m, "=== Tracked Process Contexts ===\n");
+        seq_printf(m, "PID\tName\t\tCPU%%\tComplexity\tPredictability\tSecurity\tRSS(KB)\tHot(KB)\tNode\tRd(KB/s)\tWr(KB/s)\n");
+        seq_printf(m, "------------------------------------------------------------------------------------------------------------\n");
         return 0;
     }
     
-    seq_printf(m, "=== Tracked Process Contexts ===\n");
-    seq_printf(m, "PID\tName\t\tCPU%%\tComplexity\tPredictability\tSecurity\n");
-    seq_printf(m, "------------------------------------------------------------\n");
+    ctx = list_entry(v, struct ai_process_context, list);
+    if (!ctx->active)
+        return SEQ_SKIP;
     
-    list_for_each_entry(ctx, &ai_ctx_mgr->process_contexts, list) {
-        if (ctx->active) {
-            seq_printf(m, "%d\t%-15s\t%u%%\t%.2f\t\t%.2f\t\t0x%x\n",
-                      ctx->pid, ctx->comm, ctx->cpu_utilization,
-                      ctx->context_complexity_score, ctx->predictability_score,
-                      ctx->security_flags);
-        }
-    }
+    seq_printf(m, "%d\t%-15s\t%u%%\t%u%%\t\t%u%%\t\t0x%x\t\t%lu\t%lu\t%d\t%lu\t\t%lu\n",
+              ctx->pid, ctx->comm, ctx->cpu_utilization,
+              AI_CONTEXT_FIXED_PCT(ctx->context_complexity_score),
+              AI_CONTEXT_FIXED_PCT(ctx->predictability_score),
+              ctx->security_flags, ctx->mem.rss_pages << (PAGE_SHIFT - 10),
+              ctx->mem.hot_bytes >> 10, ctx->mem.preferred_node,
+              ewma_io_bw_read(&ctx->io_read_bw) >> 10,
+              ewma_io_bw_read(&ctx->io_write_bw) >> 10);
     
     return 0;
 }
 
+static const struct seq_operations ai_context_contexts_seq_ops = {
+    .start  = ai_context_contexts_start,
+    .next   = ai_context_contexts_next,
+    .stop   = ai_context_contexts_stop,
+    .show   = ai_context_contexts_show,
+};
+
+static int ai_context_proc_show_foreground(struct seq_file *m, void *v)
+{
+    seq_printf(m, "%d\n", READ_ONCE(ai_ctx_mgr->foreground_tgid));
+    return 0;
+}
+
+static int ai_context_foreground_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, ai_context_proc_show_foreground, NULL);
+}
+
+/* The compositor writes the pid owning the focused window, 0 for none */
+static ssize_t ai_context_foreground_write(struct file *file, const char __user *ubuf,
+                                           size_t count, loff_t *ppos)
+{
+    int nr, ret;
+    
+    ret = kstrtoint_from_user(ubuf, count, 10, &nr);
+    if (ret)
+        return ret;
+    if (nr < 0)
+        return -EINVAL;
+    
+    ret = ai_context_set_foreground(nr);
+    return ret ? ret : count;
+}
+
+static const struct proc_ops ai_context_foreground_proc_ops = {
+    .proc_open    = ai_context_foreground_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+    .proc_write   = ai_context_foreground_write,
+};
+
 /* ProcFS Initialization */
 int ai_context_proc_init(void)
 {
@@ -451,13 +1972,28 @@ int ai_context_proc_init(void)
     if (!ai_ctx_mgr->proc_stats)
         goto cleanup_stats;
     
-    ai_ctx_mgr->proc_contexts = proc_create_single("contexts", 0444, ai_ctx_mgr->proc_dir,
-                                                  ai_context_proc_show_contexts);
+    ai_ctx_mgr->proc_contexts = proc_create_seq("contexts", 0444, ai_ctx_mgr->proc_dir,
+                                               &ai_context_contexts_seq_ops);
     if (!ai_ctx_mgr->proc_contexts)
         goto cleanup_contexts;
     
+    ai_ctx_mgr->proc_snapshot = proc_create("snapshot", 0444, ai_ctx_mgr->proc_dir,
+                                            &ai_context_snapshot_proc_ops);
+    if (!ai_ctx_mgr->proc_snapshot)
+        goto cleanup_snapshot;
+    proc_set_size(ai_ctx_mgr->proc_snapshot, ai_ctx_mgr->snapshot_size);
+    
+    ai_ctx_mgr->proc_foreground = proc_create("foreground", 0600, ai_ctx_mgr->proc_dir,
+                                              &ai_context_foreground_proc_ops);
+    if (!ai_ctx_mgr->proc_foreground)
+        goto cleanup_foreground;
+    
     return 0;
     
+cleanup_foreground:
+    remove_proc_entry("snapshot", ai_ctx_mgr->proc_dir);
+cleanup_snapshot:
+    remove_proc_entry("contexts", ai_ctx_mgr->proc_dir);
 cleanup_contexts:
     remove_proc_entry("stats", ai_ctx_mgr->proc_dir);
 cleanup_stats:
@@ -470,6 +2006,10 @@ void ai_context_proc_cleanup(void)
     if (!ai_ctx_mgr)
         return;
     
+    if (ai_ctx_mgr->proc_foreground)
+        remove_proc_entry("foreground", ai_ctx_mgr->proc_dir);
+    if (ai_ctx_mgr->proc_snapshot)
+        remove_proc_entry("snapshot", ai_ctx_mgr->proc_dir);
     if (ai_ctx_mgr->proc_contexts)
         remove_proc_entry("contexts", ai_ctx_mgr->proc_dir);
     if (ai_ctx_mgr->proc_stats)
@@ -478,6 +2018,132 @@ void ai_context_proc_cleanup(void)
         remove_proc_entry("ai_context", NULL);
 }
 
+static void ai_context_free_switch_rings(void)
+{
+    int cpu;
+    
+    if (!ai_ctx_mgr->switch_rings)
+        return;
+    
+    for_each_possible_cpu(cpu)
+        kvfree(per_cpu_ptr(ai_ctx_mgr->switch_rings, cpu)->records);
+    free_percpu(ai_ctx_mgr->switch_rings);
+    ai_ctx_mgr->switch_rings = NULL;
+}
+
+static int ai_context_alloc_switch_rings(void)
+{
+    struct ai_context_switch_ring *ring;
+    int cpu;
+    
+    ai_ctx_mgr->switch_rings = alloc_percpu(struct ai_context_switch_ring);
+    if (!ai_ctx_mgr->switch_rings)
+        return -ENOMEM;
+    
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(ai_ctx_mgr->switch_rings, cpu);
+        ring->records = kvzalloc_node(AI_CONTEXT_SWITCH_RING_SIZE * sizeof(*ring->records),
+                                      GFP_KERNEL, cpu_to_node(cpu));
+        if (!ring->records) {
+            ai_context_free_switch_rings();
+            return -ENOMEM;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ * Control plane. Every setting is a word the learning run and the hooks
+ * read afresh each time, so committing is a store per setting present.
+ */
+struct ai_context_control {
+    struct nlattr *tb[AURORA_AI_CONTEXT_MAX + 1];
+};
+
+static const struct nla_policy ai_context_control_policy[AURORA_AI_CONTEXT_MAX + 1] = {
+    [AURORA_AI_CONTEXT_PREDICTION_THRESHOLD] = NLA_POLICY_MAX(NLA_U32, 100),
+    [AURORA_AI_CONTEXT_LEARNING_INTERVAL]    = NLA_POLICY_RANGE(NLA_U32, 10, 60000),
+    [AURORA_AI_CONTEXT_LAZY_CPU]             = { .type = NLA_U32 },
+    [AURORA_AI_CONTEXT_IO_HINTS]             = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_CONTEXT_GROUPING]             = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_CONTEXT_LRU_HINTS]            = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_CONTEXT_HOT_TTL]              = NLA_POLICY_MAX(NLA_U32, 600000),
+    [AURORA_AI_CONTEXT_ZSWAP]                = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_CONTEXT_ZSWAP_AGE]            = NLA_POLICY_RANGE(NLA_U32, 1000, 3600000),
+    [AURORA_AI_CONTEXT_ZSWAP_CPU]            = NLA_POLICY_MAX(NLA_U32, 1000),
+    [AURORA_AI_CONTEXT_ZSWAP_RATE]           = { .type = NLA_U32 },
+    [AURORA_AI_CONTEXT_THP_BOOST]            = NLA_POLICY_MAX(NLA_U8, 1),
+};
+
+static void *ai_context_control_prepare(const struct nlattr *nest,
+                                        struct netlink_ext_ack *extack)
+{
+    struct ai_context_control *ctl;
+    int ret;
+    
+    ctl = kzalloc(sizeof(*ctl), GFP_KERNEL);
+    if (!ctl)
+        return ERR_PTR(-ENOMEM);
+    
+    /* The attributes live in the request, which outlives the commit */
+    ret = nla_parse_nested(ctl->tb, AURORA_AI_CONTEXT_MAX, nest,
+                           ai_context_control_policy, extack);
+    if (ret) {
+        kfree(ctl);
+        return ERR_PTR(ret);
+    }
+    
+    return ctl;
+}
+
+static void ai_context_control_commit(void *staged)
+{
+    struct ai_context_control *ctl = staged;
+    struct nlattr **tb = ctl->tb;
+    
+    if (tb[AURORA_AI_CONTEXT_PREDICTION_THRESHOLD])
+        WRITE_ONCE(ai_context_prediction_threshold,
+                   nla_get_u32(tb[AURORA_AI_CONTEXT_PREDICTION_THRESHOLD]));
+    if (tb[AURORA_AI_CONTEXT_LEARNING_INTERVAL])
+        WRITE_ONCE(ai_context_learning_interval,
+                   nla_get_u32(tb[AURORA_AI_CONTEXT_LEARNING_INTERVAL]));
+    if (tb[AURORA_AI_CONTEXT_LAZY_CPU])
+        WRITE_ONCE(ai_context_lazy_cpu_ms, nla_get_u32(tb[AURORA_AI_CONTEXT_LAZY_CPU]));
+    if (tb[AURORA_AI_CONTEXT_IO_HINTS])
+        WRITE_ONCE(ai_context_io_hints, nla_get_u8(tb[AURORA_AI_CONTEXT_IO_HINTS]));
+    if (tb[AURORA_AI_CONTEXT_GROUPING])
+        WRITE_ONCE(ai_context_grouping, nla_get_u8(tb[AURORA_AI_CONTEXT_GROUPING]));
+    if (tb[AURORA_AI_CONTEXT_LRU_HINTS])
+        WRITE_ONCE(ai_context_lru_hints, nla_get_u8(tb[AURORA_AI_CONTEXT_LRU_HINTS]));
+    if (tb[AURORA_AI_CONTEXT_HOT_TTL])
+        WRITE_ONCE(ai_context_hot_ttl_ms, nla_get_u32(tb[AURORA_AI_CONTEXT_HOT_TTL]));
+    if (tb[AURORA_AI_CONTEXT_ZSWAP])
+        WRITE_ONCE(ai_context_zswap, nla_get_u8(tb[AURORA_AI_CONTEXT_ZSWAP]));
+    if (tb[AURORA_AI_CONTEXT_ZSWAP_AGE])
+        WRITE_ONCE(ai_context_zswap_age_ms, nla_get_u32(tb[AURORA_AI_CONTEXT_ZSWAP_AGE]));
+    if (tb[AURORA_AI_CONTEXT_ZSWAP_CPU])
+        WRITE_ONCE(ai_context_zswap_cpu_ms, nla_get_u32(tb[AURORA_AI_CONTEXT_ZSWAP_CPU]));
+    if (tb[AURORA_AI_CONTEXT_ZSWAP_RATE])
+        WRITE_ONCE(ai_context_zswap_mb, nla_get_u32(tb[AURORA_AI_CONTEXT_ZSWAP_RATE]));
+    if (tb[AURORA_AI_CONTEXT_THP_BOOST])
+        WRITE_ONCE(ai_context_thp_boost, nla_get_u8(tb[AURORA_AI_CONTEXT_THP_BOOST]));
+    
+    kfree(ctl);
+}
+
+static void ai_context_control_abort(void *staged)
+{
+    kfree(staged);
+}
+
+static const struct aurora_ai_control_ops ai_context_control_ops = {
+    .attr = AURORA_AI_ATTR_CONTEXT,
+    .prepare = ai_context_control_prepare,
+    .commit = ai_context_control_commit,
+    .abort = ai_context_control_abort,
+};
+
 /* Module Initialization */
 int ai_context_init(void)
 {
@@ -496,33 +2162,94 @@ int ai_context_init(void)
     INIT_LIST_HEAD(&ai_ctx_mgr->process_contexts);
     spin_lock_init(&ai_ctx_mgr->contexts_lock);
     
+    ret = ai_context_alloc_switch_rings();
+    if (ret) {
+        pr_err("AI Context Manager: Failed to allocate switch rings\n");
+        kfree(ai_ctx_mgr);
+        return ret;
+    }
+    
+    ret = ai_context_damon_init();
+    if (ret) {
+        pr_err("AI Context Manager: Failed to allocate DAMON state\n");
+        ai_context_free_switch_rings();
+        kfree(ai_ctx_mgr);
+        return ret;
+    }
+    
+    ret = sched_aurora_register_storage_ops(SCHED_AURORA_STORAGE_CONTEXT, &ai_context_storage_ops);
+    if (ret) {
+        pr_err("AI Context Manager: Task storage unavailable (%d)\n", ret);
+        ai_context_damon_exit();
+        ai_context_free_switch_rings();
+        kfree(ai_ctx_mgr);
+        return ret;
+    }
+    
     ai_ctx_mgr->total_processes_tracked = 0;
     ai_ctx_mgr->active_processes = 0;
-    ai_ctx_mgr->predictions_made = 0;
+    atomic_set(&ai_ctx_mgr->predictions_made, 0);
     ai_ctx_mgr->predictions_correct = 0;
-    ai_ctx_mgr->prediction_hits = 0;
-    ai_ctx_mgr->prediction_misses = 0;
+    atomic64_set(&ai_ctx_mgr->prediction_hits, 0);
+    atomic64_set(&ai_ctx_mgr->prediction_misses, 0);
     
     ai_ctx_mgr->last_learning_update = ai_context_get_current_time();
     
-    /* Initialize learning timer */
-    timer_setup(&ai_ctx_mgr->learning_timer, ai_context_learning_timer_callback, 0);
-    mod_timer(&ai_ctx_mgr->learning_timer, 
-              jiffies + msecs_to_jiffies(ai_context_learning_interval));
+    ret = ai_context_snapshot_alloc();
+    if (ret) {
+        pr_err("AI Context Manager: Failed to allocate snapshot buffer\n");
+        goto err_storage;
+    }
+    
+    /*
+     * Learning runs off the timer path. There is a single work item, so
+     * leave max_active at the default: max_active 1 would make the queue
+     * implicitly ordered and drop it from the cache affinity scope that
+     * keeps the worker next to the CPU it was queued on.
+     */
+    ai_ctx_mgr->learning_wq = alloc_workqueue("ai_context_learn",
+                                              WQ_UNBOUND | WQ_CPU_INTENSIVE, 0);
+    if (!ai_ctx_mgr->learning_wq) {
+        pr_err("AI Context Manager: Failed to allocate learning workqueue\n");
+        ret = -ENOMEM;
+        goto err_snapshot;
+    }
+    INIT_DELAYED_WORK(&ai_ctx_mgr->learning_work, ai_context_learning_work);
     
     /* Initialize ProcFS interface */
     ret = ai_context_proc_init();
     if (ret) {
         pr_err("AI Context Manager: Failed to initialize ProcFS interface\n");
-        kfree(ai_ctx_mgr);
-        return ret;
+        destroy_workqueue(ai_ctx_mgr->learning_wq);
+        goto err_snapshot;
     }
     
+    /* Start learning once everything it uses is set up */
+    queue_delayed_work(ai_ctx_mgr->learning_wq, &ai_ctx_mgr->learning_work,
+                       msecs_to_jiffies(ai_context_learning_interval));
+    
+    static_branch_enable(&ai_context_hooks_enabled);
+    
+    /* The parameters stay writable without it */
+    ret = aurora_ai_register_control(&ai_context_control_ops);
+    if (ret)
+        pr_warn("AI Context Manager: Control plane unavailable: %d\n", ret);
+    
     pr_info("AI Context Manager: Successfully initialized\n");
     pr_info("AI Context Manager: Max processes: %u, Learning interval: %u ms\n",
             ai_context_max_processes, ai_context_learning_interval);
     
     return 0;
+    
+err_snapshot:
+    ai_context_snapshot_free();
+err_storage:
+    sched_aurora_unregister_storage_ops(SCHED_AURORA_STORAGE_CONTEXT, &ai_context_storage_ops);
+    ai_context_damon_exit();
+    ai_context_free_switch_rings();
+    kfree(ai_ctx_mgr);
+    ai_ctx_mgr = NULL;
+    return ret;
 }
 
 /* Module Cleanup */
@@ -536,20 +2263,56 @@ void ai_context_exit(void)
     
     pr_info("AI Context Manager: Shutting down\n");
     
-    /* Cancel learning timer */
-    del_timer_sync(&ai_ctx_mgr->learning_timer);
+    aurora_ai_unregister_control(&ai_context_control_ops);
+    
+    /* Back to NOPs; hooks run with IRQs off or under RCU */
+    static_branch_disable(&ai_context_hooks_enabled);
+    synchronize_rcu();
+    
+    /* Stop learning; this also waits out a run in progress */
+    cancel_delayed_work_sync(&ai_ctx_mgr->learning_work);
+    destroy_workqueue(ai_ctx_mgr->learning_wq);
+    
+    /* The shared autogroups outlive us; nobody would move processes out */
+    remove_proc_entry("foreground", ai_ctx_mgr->proc_dir);
+    ai_ctx_mgr->proc_foreground = NULL;
+    ai_context_set_foreground(0);
+    ai_context_ungroup_all();
     
-    /* Clean up all process contexts */
+    /* Stop DAMON before the contexts it updates go away */
+    ai_context_damon_exit();
+    
+    /*
+     * Detach contexts from their tasks. A task being freed concurrently
+     * has already taken its context and hands it to the free callback.
+     */
     spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
     list_for_each_entry_safe(ctx, tmp, &ai_ctx_mgr->process_contexts, list) {
-        list_del(&ctx->list);
-        kfree(ctx->memory_regions);
-        kfree(ctx);
+        if (sched_aurora_task_storage_set(ctx->task, SCHED_AURORA_STORAGE_CONTEXT, ctx, NULL)) {
+            list_del_rcu(&ctx->list);
+            call_rcu(&ctx->rcu, ai_context_free_rcu);
+        }
+    }
+    spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
+    
+    /* No free callback runs after this; reclaim what they missed */
+    sched_aurora_unregister_storage_ops(SCHED_AURORA_STORAGE_CONTEXT, &ai_context_storage_ops);
+    
+    spin_lock_irqsave(&ai_ctx_mgr->contexts_lock, flags);
+    list_for_each_entry_safe(ctx, tmp, &ai_ctx_mgr->process_contexts, list) {
+        list_del_rcu(&ctx->list);
+        call_rcu(&ctx->rcu, ai_context_free_rcu);
     }
     spin_unlock_irqrestore(&ai_ctx_mgr->contexts_lock, flags);
     
+    /* Wait for lock-free readers and pending frees */
+    rcu_barrier();
+    srcu_barrier(&ai_context_srcu);
+    ai_context_free_switch_rings();
+    
     /* Clean up ProcFS interface */
     ai_context_proc_cleanup();
+    ai_context_snapshot_free();
     
     /* Free context manager */
     kfree(ai_ctx_mgr);
@@ -558,85 +2321,73 @@ void ai_context_exit(void)
     pr_info("AI Context Manager: Shutdown complete\n");
 }
 
-/* Hook Implementations */
+/* Hook Implementations, reached through the wrappers in ai_context_manager.h */
 #ifdef CONFIG_AURORA_AI_HOOKS
-void ai_context_sched_switch_hook(struct task_struct *prev, struct task_struct *next)
+/*
+ * Called from __schedule() with IRQs off. Only records the switch in
+ * this CPU's ring; it takes no locks and never waits.
+ */
+void __ai_context_sched_switch_hook(struct task_struct *prev, struct task_struct *next)
 {
-    struct ai_process_context *ctx;
-    ktime_t switch_time, duration;
-    
-    if (!ai_ctx_mgr)
+    struct ai_context_switch_ring *ring;
+    struct ai_context_switch_record *rec;
+    unsigned int head;
+    
+    ring = this_cpu_ptr(ai_ctx_mgr->switch_rings);
+    head = ring->head;
+    if (unlikely(head - smp_load_acquire(&ring->tail) >= AI_CONTEXT_SWITCH_RING_SIZE)) {
+        WRITE_ONCE(ring->dropped, ring->dropped + 1);
         return;
-    
-    /* Update statistics */
-    ai_ctx_mgr->total_context_switches++;
-    switch_time = ai_context_get_current_time();
-    
-    /* Track previous process */
-    ctx = ai_context_get_process(prev->pid);
-    if (ctx) {
-        /* Calculate context switch duration */
-        if (ctx->switch_history_index > 0) {
-            duration = ktime_sub(switch_time, 
-                               ctx->context_switch_times[ctx->switch_history_index - 1]);
-            /* Update average context switch time */
-            if (ctx->avg_context_switch_time.tv64 == 0) {
-                ctx->avg_context_switch_time = duration;
-            } else {
-                ctx->avg_context_switch_time = ktime_add(ctx->avg_context_switch_time, duration);
-                ctx->avg_context_switch_time.tv64 /= 2;  /* Simple average */
-            }
-        }
-        
-        /* Store switch time */
-        ctx->context_switch_times[ctx->switch_history_index] = switch_time;
-        ctx->switch_history_index = (ctx->switch_history_index + 1) % AI_CONTEXT_HISTORY_SIZE;
-        
-        /* Update process statistics */
-        ai_context_update_cpu_usage(ctx, prev);
-        ai_context_update_memory_usage(ctx, prev);
     }
     
-    /* Track next process */
-    ctx = ai_context_get_process(next->pid);
-    if (!ctx) {
-        /* Auto-track new processes */
-        ai_context_track_process(next);
-    }
+    rec = &ring->records[head & (AI_CONTEXT_SWITCH_RING_SIZE - 1)];
+    rec->timestamp = ai_context_get_current_time();
+    rec->pid = prev->pid;
+    rec->next_pid = next->pid;
+    rec->prev_state = READ_ONCE(prev->__state);
+    rec->cpu = smp_processor_id();
+    
+    smp_store_release(&ring->head, head + 1);
 }
 
-void ai_context_fork_hook(struct task_struct *parent, struct task_struct *child)
+/*
+ * Hand the child a seed of the parent's scores; the context itself is
+ * created by the learning work once the child has run long enough.
+ */
+void __ai_context_fork_hook(struct task_struct *parent, struct task_struct *child)
 {
-    struct ai_process_context *parent_ctx, *child_ctx;
-    
-    if (!ai_ctx_mgr)
-        return;
-    
-    /* Get parent context */
-    parent_ctx = ai_context_get_process(parent->pid);
-    if (!parent_ctx)
-        return;
-    
-    /* Track child process */
-    ai_context_track_process(child);
-    child_ctx = ai_context_get_process(child->pid);
-    if (!child_ctx)
-        return;
+    struct ai_process_context *parent_ctx;
+    void *seed;
+    
+    rcu_read_lock();
+    
+    /* A seeded parent passes its seed on unchanged */
+    seed = sched_aurora_task_storage(parent, SCHED_AURORA_STORAGE_CONTEXT);
+    if (seed && !ai_context_is_seed(seed)) {
+        parent_ctx = seed;
+        seed = NULL;
+        if (READ_ONCE(parent_ctx->active))
+            seed = ai_context_mk_seed(READ_ONCE(parent_ctx->context_complexity_score),
+                                      READ_ONCE(parent_ctx->predictability_score));
+    }
+    if (seed)
+        sched_aurora_task_storage_set(child, SCHED_AURORA_STORAGE_CONTEXT, NULL, seed);
     
-    /* Inherit some characteristics from parent */
-    child_ctx->context_complexity_score = parent_ctx->context_complexity_score;
-    child_ctx->predictability_score = parent_ctx->predictability_score;
+    rcu_read_unlock();
     
-    if (ai_context_debug_enabled)
+    if (seed && ai_context_debug_enabled)
         pr_info("AI Context: Fork detected - Parent: %d, Child: %d\n", parent->pid, child->pid);
 }
 
-void ai_context_exit_hook(struct task_struct *task)
+void __ai_context_exit_hook(struct task_struct *task)
 {
-    if (!ai_ctx_mgr)
-        return;
+    struct ai_process_context *ctx;
     
-    ai_context_untrack_process(task->pid);
+    rcu_read_lock();
+    ctx = ai_context_of(task);
+    if (ctx)
+        ai_context_deactivate(ctx);
+    rcu_read_unlock();
     
     if (ai_context_debug_enabled)
         pr_info("AI Context: Process exit detected - PID: %d\n", task->pid);
@@ -645,4 +2396,8 @@ void ai_context_exit_hook(struct task_struct *task)
 
 /* Module Registration */
 module_init(ai_context_init);
-module_exit(ai_context_exit);
\ No newline at end of file
+module_exit(ai_context_exit);
+
+#ifdef CONFIG_AURORA_AI_KUNIT_TEST
+#include "tests/ai_context_kunit.c"
+#endif
@@ -17,18 +17,69 @@
 
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/average.h>
 #include <linux/sched.h>
 #include <linux/mm.h>
 #include <linux/list.h>
 #include <linux/spinlock.h>
 #include <linux/ktime.h>
 #include <linux/proc_fs.h>
+#include <linux/workqueue.h>
+#include <linux/jump_label.h>
+
+struct damon_ctx;
+struct aurora_task_features;
 
 /* Context Manager Configuration */
 #define AI_CONTEXT_MAX_PROCESSES    1024
 #define AI_CONTEXT_HISTORY_SIZE     64
 #define AI_CONTEXT_LEARNING_RATE    1000  /* milliseconds */
 #define AI_CONTEXT_PREDICTION_THRESHOLD  75  /* percentage */
+#define AI_CONTEXT_INTERVAL_BUCKETS 40        /* log2(ns) buckets, up to ~18 min */
+#define AI_CONTEXT_MIN_INTERVALS    4         /* history needed to predict */
+#define AI_CONTEXT_SWITCH_RING_SIZE 8192      /* records per CPU, power of two */
+#define AI_CONTEXT_SCORE_BATCH      32        /* contexts scored per batch */
+#define AI_CONTEXT_DRAIN_BATCH      256       /* switch records per RCU section */
+#define AI_CONTEXT_MEM_NODES        8         /* nodes with residency accounting */
+#define AI_CONTEXT_DAMON_TARGETS    16        /* processes monitored by DAMON */
+#define AI_CONTEXT_DAMON_RETARGET   10        /* learning runs between re-targets */
+#define AI_CONTEXT_ZSWAP_TARGETS    8         /* idle processes compressed into zswap */
+#define AI_CONTEXT_IO_BOUND_BW      (64UL << 20)  /* bytes/s treated as fully IO bound */
+#define AI_CONTEXT_IO_BULK_BW       (32UL << 20)  /* write bytes/s of a bulk writer */
+#define AI_CONTEXT_BATCH_CPU        80        /* CPU percent of batch work */
+#define AI_CONTEXT_LRU_MEMCGS       32        /* memcgs hinted per learning run */
+#define AI_CONTEXT_LRU_HINT_RUNS    4         /* learning runs an LRU hint holds */
+
+/* Storage bandwidth averages, in bytes/s, weight 1/4 per learning run */
+DECLARE_EWMA(io_bw, 8, 4)
+
+/*
+ * Scores are Q16.16 fixed point, so no FPU state is needed in kernel
+ * context. AI_CONTEXT_FIXED_ONE is 1.0.
+ */
+#define AI_CONTEXT_FIXED_SHIFT      16
+#define AI_CONTEXT_FIXED_ONE        (1U << AI_CONTEXT_FIXED_SHIFT)
+#define AI_CONTEXT_FIXED(n, d)      ((u32)(((u64)(n) << AI_CONTEXT_FIXED_SHIFT) / (d)))
+#define AI_CONTEXT_FIXED_PCT(x)     ((unsigned int)(((u64)(x) * 100) >> AI_CONTEXT_FIXED_SHIFT))
+
+/*
+ * Memory access summary of one process, built from the DAMON regions of
+ * its address space. Byte counts cover the monitored virtual ranges;
+ * residency is per node of the pages at the regions' sampling addresses.
+ */
+struct ai_context_mem_summary {
+    unsigned long rss_pages;            /* Resident set, from the mm counters */
+    unsigned long total_bytes;          /* Monitored bytes */
+    unsigned long hot_bytes;
+    unsigned long cold_bytes;           /* Not accessed in the last aggregation */
+    unsigned long largest_hot_region;
+    unsigned long node_hot_bytes[AI_CONTEXT_MEM_NODES];
+    unsigned int nr_regions;
+    unsigned int nr_hot_regions;
+    int preferred_node;                 /* Node holding most hot bytes, or NUMA_NO_NODE */
+    bool thp_candidate;                 /* Hot region spanning a PMD */
+    ktime_t updated;                    /* Last DAMON aggregation, 0 if never */
+};
 
 /* Process Context Data Structure */
 struct ai_process_context {
@@ -37,8 +88,7 @@ struct ai_process_context {
     
     /* Memory Access Patterns */
     unsigned long memory_access_count;
-    unsigned long *memory_regions;      /* Tracked memory regions */
-    unsigned int region_count;
+    struct ai_context_mem_summary mem;
     
     /* CPU Usage Patterns */
     u64 cpu_time_total;
@@ -46,39 +96,142 @@ struct ai_process_context {
     ktime_t last_cpu_update;
     unsigned int cpu_utilization;
     
-    /* I/O Patterns */
-    unsigned long io_read_count;
-    unsigned long io_write_count;
-    u64 io_bytes_read;
+    /* I/O Patterns, from task->ioac */
+    unsigned long io_read_count;        /* read syscalls */
+    unsigned long io_write_count;       /* write syscalls */
+    u64 io_bytes_read;                  /* storage bytes */
     u64 io_bytes_written;
+    struct ewma_io_bw io_read_bw;
+    struct ewma_io_bw io_write_bw;
+    ktime_t last_io_update;
+    u16 io_prio_hint;                   /* IO priority hint we gave the task */
+    
+    /* enum sched_aurora_group the process was last moved to */
+    unsigned int sched_group;
     
     /* Context Switch History */
     ktime_t context_switch_times[AI_CONTEXT_HISTORY_SIZE];
     unsigned int switch_history_index;
     ktime_t avg_context_switch_time;
     
+    /* Outstanding next-switch prediction, scored at the next switch */
+    u64 predicted_interval;             /* ns, 0 if none */
+    unsigned int prediction_hits;
+    unsigned int prediction_misses;
+    
     /* ML Features */
-    float context_complexity_score;     /* 0.0 - 1.0 */
-    float predictability_score;         /* 0.0 - 1.0 */
-    unsigned int prediction_accuracy;
+    u32 context_complexity_score;       /* Q16, 0 - AI_CONTEXT_FIXED_ONE */
+    u32 predictability_score;           /* Q16, 0 - AI_CONTEXT_FIXED_ONE */
+    unsigned int prediction_accuracy;   /* percentage of recent predictions hit */
     
     /* Security Context */
     unsigned int security_flags;        /* Security-related behaviors */
     unsigned int anomaly_count;
     
+    /* Shared with the scheduler and security modules; holds a reference */
+    struct aurora_task_features *features;
+    
     /* List Management */
     struct list_head list;
+    struct task_struct *task;           /* Owner, via task storage */
+    struct rcu_head rcu;
     spinlock_t lock;
     bool active;
 };
 
+/*
+ * Context switch record. The switch hook only fills one of these into
+ * its CPU's ring; the learning work does all of the aggregation.
+ */
+struct ai_context_switch_record {
+    ktime_t timestamp;
+    pid_t pid;                          /* Task switched out */
+    pid_t next_pid;                     /* Task switched in */
+    unsigned int prev_state;
+    int cpu;
+};
+
+/*
+ * Per-CPU single-producer, single-consumer ring. The switch hook on the
+ * owning CPU advances head; the learning work advances tail. When the
+ * ring is full new records are counted and dropped, so the producer
+ * never waits.
+ */
+struct ai_context_switch_ring {
+    unsigned int head;
+    unsigned long dropped;
+    struct ai_context_switch_record *records;
+    
+    unsigned int tail ____cacheline_aligned_in_smp;
+};
+
+/*
+ * Binary snapshot exported through /proc/ai_context/snapshot. The file
+ * can be read() or mmap()ed read-only; it holds one header followed by
+ * up to capacity records of record_size bytes, rewritten after every
+ * learning run. Fields are only ever appended, with version bumped, so
+ * a reader that honours header_size and record_size keeps working.
+ *
+ * seq is odd while the kernel rewrites the snapshot. A reader copies
+ * the records between two reads of seq and retries unless both reads
+ * returned the same even value:
+ *
+ *	do {
+ *		seq = load_acquire(&hdr->seq);
+ *		copy nr_records records;
+ *		smp_rmb();
+ *	} while ((seq & 1) || seq != hdr->seq);
+ */
+#define AI_CONTEXT_SNAPSHOT_MAGIC   0x58434941  /* "AICX" */
+#define AI_CONTEXT_SNAPSHOT_VERSION 1
+
+#define AI_CONTEXT_SNAPSHOT_STALE   0x0001  /* Module unloaded, no more updates */
+
+struct ai_context_snapshot_header {
+    __u32 magic;
+    __u16 version;
+    __u16 header_size;
+    __u32 record_size;
+    __u32 capacity;
+    __u32 seq;
+    __u32 nr_records;
+    __u32 nr_skipped;                   /* Active contexts beyond capacity */
+    __u32 flags;
+    __u64 timestamp_ns;                 /* CLOCK_MONOTONIC of the last update */
+    __u64 total_context_switches;
+    __u64 switch_records_dropped;
+    __u64 reserved[2];
+};
+
+struct ai_context_snapshot_record {
+    __s32 pid;
+    __u32 security_flags;
+    char comm[TASK_COMM_LEN];
+    __u32 cpu_utilization;              /* percentage */
+    __u32 complexity;                   /* Q16 */
+    __u32 predictability;               /* Q16 */
+    __u32 anomaly_count;
+    __u64 avg_switch_interval_ns;
+    __u64 rss_bytes;
+    __u64 hot_bytes;
+    __u64 cold_bytes;
+    __s32 preferred_node;               /* -1 if unknown */
+    __u32 mem_flags;                    /* AI_CONTEXT_SNAPSHOT_MEM_* */
+    __u64 io_read_bw;                   /* bytes/s */
+    __u64 io_write_bw;
+    __u64 io_bytes_read;
+    __u64 io_bytes_written;
+};
+
+#define AI_CONTEXT_SNAPSHOT_MEM_THP 0x0001  /* Hot region spans a huge page */
+
 /* Context Prediction Data */
 struct ai_context_prediction {
     pid_t pid;
     ktime_t predicted_next_switch;
     unsigned long predicted_memory_usage;
     unsigned int predicted_cpu_usage;
-    float confidence;
+    unsigned int confidence;            /* percentage */
     bool is_prediction_valid;
 };
 
@@ -90,23 +243,48 @@ struct ai_context_manager {
     /* Statistics */
     unsigned int total_processes_tracked;
     unsigned int active_processes;
-    unsigned int predictions_made;
+    atomic_t predictions_made;
     unsigned int predictions_correct;
     
     /* Learning State */
     ktime_t last_learning_update;
-    struct timer_list learning_timer;
+    struct workqueue_struct *learning_wq;
+    struct delayed_work learning_work;
     
     /* ProcFS Interface */
     struct proc_dir_entry *proc_dir;
     struct proc_dir_entry *proc_stats;
     struct proc_dir_entry *proc_contexts;
+    struct proc_dir_entry *proc_snapshot;
+    struct proc_dir_entry *proc_foreground;
+    
+    /* Owner of the focused window, from /proc/ai_context/foreground */
+    pid_t foreground_tgid;              /* 0 if none */
+    u64 foreground_start;               /* start_time, against pid reuse */
+    
+    /* Binary snapshot, vmalloc_user() so it can be mapped */
+    struct ai_context_snapshot_header *snapshot;
+    size_t snapshot_size;
+    
+    /* Context switch records, drained by the learning work */
+    struct ai_context_switch_ring __percpu *switch_rings;
+    u64 switch_records_dropped;
+    
+    /* Memory access monitoring of the busiest contexts */
+    struct damon_ctx *damon;
+    int *damon_nids;
+    unsigned int damon_runs;
+    
+    /* Proactive zswap of idle processes, sorted by pid */
+    struct damon_ctx *zswap;
+    pid_t zswap_pids[AI_CONTEXT_ZSWAP_TARGETS];
+    unsigned int zswap_nr;
     
     /* Performance Metrics */
     u64 total_context_switches;
     ktime_t total_context_switch_time;
-    u64 prediction_hits;
-    u64 prediction_misses;
+    atomic64_t prediction_hits;
+    atomic64_t prediction_misses;
 };
 
 /* Security Context Flags */
@@ -130,11 +308,13 @@ void ai_context_update_cpu_usage(struct ai_process_context *ctx, struct task_str
 void ai_context_update_memory_usage(struct ai_process_context *ctx, struct task_struct *task);
 void ai_context_update_io_stats(struct ai_process_context *ctx, struct task_struct *task);
 void ai_context_analyze_patterns(struct ai_process_context *ctx);
+int ai_context_memory_hint(pid_t pid, int *preferred_node, bool *thp_candidate);
 
 /* Prediction Engine */
 int ai_context_predict_next_switch(struct ai_process_context *ctx, struct ai_context_prediction *pred);
 int ai_context_predict_resource_usage(struct ai_process_context *ctx, unsigned long *memory, unsigned int *cpu);
 void ai_context_update_prediction_accuracy(struct ai_context_prediction *pred, bool was_correct);
+u64 ai_context_predict_interval(pid_t pid);
 
 /* Security Monitoring */
 int ai_context_security_analyze(struct ai_process_context *ctx);
@@ -154,15 +334,35 @@ int ai_context_proc_read_contexts(char *buffer, char **start, off_t offset, int
 
 /* Utility Functions */
 ktime_t ai_context_get_current_time(void);
-float ai_context_calculate_complexity(struct ai_process_context *ctx);
-float ai_context_calculate_predictability(struct ai_process_context *ctx);
+u32 ai_context_calculate_complexity(struct ai_process_context *ctx);
+u32 ai_context_calculate_predictability(struct ai_process_context *ctx);
 void ai_context_dump_process_info(struct ai_process_context *ctx);
 
 /* Hooks Integration */
+DECLARE_STATIC_KEY_FALSE(ai_context_hooks_enabled);
+
 #ifdef CONFIG_AURORA_AI_HOOKS
-void ai_context_sched_switch_hook(struct task_struct *prev, struct task_struct *next);
-void ai_context_fork_hook(struct task_struct *parent, struct task_struct *child);
-void ai_context_exit_hook(struct task_struct *task);
+void __ai_context_sched_switch_hook(struct task_struct *prev, struct task_struct *next);
+void __ai_context_fork_hook(struct task_struct *parent, struct task_struct *child);
+void __ai_context_exit_hook(struct task_struct *task);
+
+static inline void ai_context_sched_switch_hook(struct task_struct *prev, struct task_struct *next)
+{
+    if (static_branch_unlikely(&ai_context_hooks_enabled))
+        __ai_context_sched_switch_hook(prev, next);
+}
+
+static inline void ai_context_fork_hook(struct task_struct *parent, struct task_struct *child)
+{
+    if (static_branch_unlikely(&ai_context_hooks_enabled))
+        __ai_context_fork_hook(parent, child);
+}
+
+static inline void ai_context_exit_hook(struct task_struct *task)
+{
+    if (static_branch_unlikely(&ai_context_hooks_enabled))
+        __ai_context_exit_hook(task);
+}
 #endif
 
 /* Global Variables */
@@ -173,5 +373,15 @@ extern unsigned int ai_context_max_processes;
 extern unsigned int ai_context_learning_interval;
 extern unsigned int ai_context_prediction_threshold;
 extern bool ai_context_debug_enabled;
+extern bool ai_context_io_hints;
+extern bool ai_context_grouping;
+extern bool ai_context_lru_hints;
+extern unsigned int ai_context_hot_ttl_ms;
+extern bool ai_context_zswap;
+extern unsigned int ai_context_zswap_age_ms;
+extern unsigned int ai_context_zswap_cpu_ms;
+extern unsigned int ai_context_zswap_mb;
+extern bool ai_context_thp_boost;
+extern unsigned int ai_context_lazy_cpu_ms;
 
 #endif /* AI_CONTEXT_MANAGER_H */
\ No newline at end of file
@@ -15,35 +15,328 @@
 #include <linux/init.h>
 #include <linux/sched.h>
 #include <linux/sched/clock.h>
+#include <linux/sched/signal.h>
+#include <linux/sched/aurora.h>
+#include <linux/pid.h>
+#include <linux/pid_namespace.h>
+#include <linux/topology.h>
 #include <linux/cpumask.h>
+#include <linux/percpu.h>
 #include <linux/rbtree.h>
+#include <linux/rculist.h>
+#include <linux/hash.h>
+#include <linux/hashtable.h>
+#include <linux/log2.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/irq_work.h>
+#include <linux/jump_label.h>
 #include <linux/time.h>
 #include <linux/jiffies.h>
+#include <linux/math64.h>
+#include <linux/cgroup.h>
+#include <linux/file.h>
+#include <linux/mutex.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
 #include <linux/ai_scheduler.h>
 #include <linux/context_manager.h>
+#include <net/netlink.h>
+#include "aurora_core.h"
+#include "aurora_trace.h"
 
 /* Aurora AI Scheduler Constants */
 #define AI_SCHEDULER_VERSION "1.0.0"
 #define MAX_PATTERN_HISTORY 100
-#define PREDICTION_CONFIDENCE_THRESHOLD 0.7
-#define CONTEXT_WEIGHT 0.3
-#define PREDICTION_WEIGHT 0.4
-#define BASE_WEIGHT 0.3
+#define PREDICTION_CONFIDENCE_THRESHOLD 70 /* percent */
+#define PATTERN_HASH_BITS 6
+#define PATTERN_MERGE_INTERVAL HZ
+#define CLASS_HASH_BITS 8
+#define PRESSURE_HASH_BITS 6
+#define AURORA_PRESSURE_MAX_ADJ 20 /* Context points at a full stall */
+#define AURORA_SHORT_RUNTIME_NS 1000000
+#define AURORA_CPU_BOUND_INTENSITY 768 /* 75% in AURORA_FIXED_SHIFT */
+#define AURORA_SAMPLE_RING 64 /* power of two */
+#define AURORA_SAMPLE_BATCH 16
+/* Predicted bursts of 2^22 ns (~4 ms) or more ask schedutil for full capacity */
+#define AURORA_FREQ_BURST_SHIFT 22
+#define AURORA_FREQ_MIN_BURST_NS 100000
+
+/*
+ * Fixed-point scoring. All averages are exponentially weighted with the
+ * same geometric series PELT uses: y^AURORA_DECAY_PERIOD == 1/2, one
+ * period per jiffy. Intensities are kept in AURORA_FIXED_SHIFT fixed
+ * point (1024 == 100%), the format of the shared task features.
+ */
+#define AURORA_FIXED_SHIFT AURORA_FEATURE_SHIFT
+#define AURORA_FIXED_ONE (1U << AURORA_FIXED_SHIFT)
+#define AURORA_DECAY_PERIOD 32
+
+/* y^n * 2^32 for n < AURORA_DECAY_PERIOD, as runnable_avg_yN_inv[] */
+static const u32 aurora_decay_yN_inv[AURORA_DECAY_PERIOD] = {
+    0xffffffff, 0xfa83b2da, 0xf5257d14, 0xefe4b99a, 0xeac0c6e6, 0xe5b906e6,
+    0xe0ccdeeb, 0xdbfbb796, 0xd744fcc9, 0xd2a81d91, 0xce248c14, 0xc9b9bd85,
+    0xc5672a10, 0xc12c4cc9, 0xbd08a39e, 0xb8fbaf46, 0xb504f333, 0xb123f581,
+    0xad583ee9, 0xa9a15ab4, 0xa5fed6a9, 0xa2704302, 0x9ef5325f, 0x9b8d39b9,
+    0x9837f050, 0x94f4efa8, 0x91c3d373, 0x8ea4398a, 0x8b95c1e3, 0x88980e80,
+    0x85aac367, 0x82cd8698,
+};
+
+/* Score component weights in fixed point; they must sum to 1.0 */
+enum aurora_score_component {
+    AURORA_SCORE_BASE,
+    AURORA_SCORE_CONTEXT,
+    AURORA_SCORE_PREDICTION,
+    AURORA_NR_SCORE_COMPONENTS
+};
+
+static const u32 aurora_default_weights[AURORA_NR_SCORE_COMPONENTS] = {
+    [AURORA_SCORE_BASE]       = 307,    /* 0.3 */
+    [AURORA_SCORE_CONTEXT]    = 307,    /* 0.3 */
+    [AURORA_SCORE_PREDICTION] = 410,    /* 0.4 */
+};
+
+/* Resources whose pressure userspace reports, as the PSI files */
+enum aurora_pressure_resource {
+    AURORA_PRESSURE_CPU,
+    AURORA_PRESSURE_MEMORY,
+    AURORA_PRESSURE_IO,
+    AURORA_NR_PRESSURE
+};
+
+/*
+ * The live table, replaceable through the control plane. Scoring reads
+ * whichever of the two buffers is published; a new table is written to
+ * the other one and swapped in, and a grace period passes before that
+ * buffer is written again.
+ */
+static u32 aurora_weight_tables[2][AURORA_NR_SCORE_COMPONENTS];
+static u32 __rcu *aurora_score_weights;
+
+/* Decay @val by y^n in constant time, as decay_load() in pelt.c */
+static inline u64 aurora_decay(u64 val, unsigned long n)
+{
+    if (unlikely(n > AURORA_DECAY_PERIOD * 63))
+        return 0;
+
+    if (unlikely(n >= AURORA_DECAY_PERIOD)) {
+        val >>= n / AURORA_DECAY_PERIOD;
+        n %= AURORA_DECAY_PERIOD;
+    }
+
+    return mul_u64_u32_shr(val, aurora_decay_yN_inv[n], 32);
+}
+
+/*
+ * Move @avg towards @sample over @periods: avg' = sample + (avg - sample) * y^n.
+ * This is an EWMA whose weight depends on the time since the last sample,
+ * so irregular sampling does not bias the average.
+ */
+static inline u64 aurora_ewma(u64 avg, u64 sample, unsigned long periods)
+{
+    if (!periods)
+        periods = 1;
+
+    if (avg >= sample)
+        return sample + aurora_decay(avg - sample, periods);
+    return sample - aurora_decay(sample - avg, periods);
+}
 
 /* Usage pattern structure */
 struct usage_pattern {
     pid_t pid;
     char comm[TASK_COMM_LEN];
-    u64 avg_runtime;
-    u64 avg_wait_time;
-    u64 io_intensity;
-    u64 cpu_intensity;
     u64 last_access;
     u64 access_count;
-    struct rb_node node;
+
+    /* Workload identity, resolved against the class table */
+    u64 cgroup_id;
+    unsigned long exe_ino;
+    int class_boost;
+    u16 stall[AURORA_NR_PRESSURE];
+    unsigned int class_gen;
+
+    /* Raw counters at the previous sample, for EWMA deltas */
+    u64 last_sum_exec;
+    u64 last_wait_sum;
+    unsigned long last_sample;
+
+    /* Runtime, wait and intensity averages, shared with the other modules */
+    struct aurora_task_features *features;
+
+    struct hlist_node node;
+    struct rcu_head rcu;
+
+    /* Runqueue linkage, ordered by the cached AI score */
+    struct task_struct *task;
+    struct rb_node run_node;
+    int score;
+    int cpu;
+    bool on_rq;
+    bool dying;     /* task is dead, never queue it again */
+
+    /* LLC load counter this task is accounted to while CPU-bound */
+    atomic_t *llc_load;
+
+    /* Burst prediction: CPU time from wakeup until the task blocks */
+    u64 avg_burst;
+    u64 predicted_burst;
+    u64 burst_start;
+    u8 pred_class;
+    bool burst_valid;
+};
+
+/*
+ * Per-runqueue AI ordering. Runnable tasks are kept sorted by their cached
+ * score (highest leftmost), so picking the next task is a leftmost lookup
+ * and the score is only recomputed on enqueue, put_prev and tick.
+ */
+struct aurora_rq {
+    raw_spinlock_t lock;
+    struct rb_root_cached tasks_timeline;
+    unsigned int nr_queued;
+
+    /* Runnable CPU-bound tasks in this LLC; used on the LLC's first CPU */
+    atomic_t llc_cpu_bound;
+    struct aurora_rq *llc;
+    int llc_cpu;
+
+    /* Frequency hints for schedutil, read locklessly by aurora_freq_util_hint() */
+    unsigned long freq_boost;   /* capacity scale */
+    u64 freq_boost_until;       /* local_clock() */
+    bool freq_idle;
+};
+
+static DEFINE_PER_CPU(struct aurora_rq, aurora_runqueues);
+static struct cpumask aurora_llc_leaders;
+
+/*
+ * Sharded pattern store. Patterns are spread over one shard per possible
+ * CPU by pid hash; lookups walk the shard's hash chain under RCU and only
+ * insertion and removal take the shard lock. Pattern statistics take no
+ * lock at all: the enqueue path updates them from whichever CPU wakes the
+ * task, under the target runqueue's lock, and the tick's sample batch
+ * from the CPU that ran it, so after a migration the two can overlap.
+ * That is tolerated: the stale-sample check drops what a concurrent
+ * update overtook, a lost update costs one sample, and the averages read
+ * by other CPUs and modules are written with WRITE_ONCE().
+ */
+struct pattern_shard {
+    spinlock_t lock;
+    unsigned int nr_patterns;
+    struct hlist_head hash[1 << PATTERN_HASH_BITS];
+} ____cacheline_aligned_in_smp;
+
+/*
+ * Workload classification table. Userspace assigns a prediction boost to
+ * a cgroup id or an executable inode through /proc/aurora_sched/classes,
+ * or in batches through the aurora_ai control plane.
+ * Each pattern caches its resolved boost together with the table
+ * generation, so scoring only re-resolves after the table changes.
+ */
+enum aurora_class_type {
+    AURORA_CLASS_CGROUP,
+    AURORA_CLASS_EXE,
+};
+
+struct aurora_class {
+    u64 id;
+    enum aurora_class_type type;
+    int boost;
+    struct hlist_node node;
+    struct rcu_head rcu;
+};
+
+/*
+ * Resource pressure per cgroup, pushed by the userspace agent from its
+ * PSI triggers; cgroup 0 is the whole system. It shares the class
+ * table's mutex and generation, so patterns pick it up as they resolve
+ * their class.
+ */
+struct aurora_pressure {
+    u64 cgroup_id;
+    u16 stall[AURORA_NR_PRESSURE];      /* AURORA_AI_PRESSURE_FULL is 100% */
+    struct hlist_node node;
+    struct rcu_head rcu;
 };
 
+static DEFINE_HASHTABLE(aurora_class_table, CLASS_HASH_BITS);
+static DEFINE_HASHTABLE(aurora_pressure_table, PRESSURE_HASH_BITS);
+static DEFINE_MUTEX(aurora_class_mutex);
+static unsigned int aurora_class_gen;
+static struct proc_dir_entry *aurora_proc_dir;
+
+/* Per-CPU counters, folded into perf_metrics by the merge work */
+struct aurora_cpu_stats {
+    u64 tasks_scheduled;
+    u64 context_switches;
+    u64 runtime_sum;
+    u64 samples;
+    u64 samples_dropped;
+};
+
+static DEFINE_PER_CPU(struct aurora_cpu_stats, aurora_cpu_stats);
+
+/*
+ * Tick samples. The tick only snapshots the running task's counters into
+ * a per-CPU ring; a lazy irq_work drains the ring once a batch has built
+ * up and folds the samples into the patterns. The ring has a single
+ * producer and a single consumer, both on the owning CPU.
+ */
+struct aurora_sample {
+    pid_t pid;
+    bool iowait;
+    unsigned long stamp;
+    u64 sum_exec;
+    u64 wait_sum;
+};
+
+struct aurora_sample_ring {
+    unsigned int head;
+    unsigned int tail;
+    struct irq_work work;
+    struct aurora_sample buf[AURORA_SAMPLE_RING];
+};
+
+static DEFINE_PER_CPU(struct aurora_sample_ring, aurora_sample_rings);
+
+/*
+ * Prediction accuracy. Each wakeup predicts the CPU burst the task will
+ * run before blocking again; the observed burst is compared when it
+ * blocks. Relative errors are binned per behaviour class in per-CPU
+ * histograms. A prediction within 25% of the observed burst is a hit.
+ */
+enum aurora_pred_class {
+    AURORA_PRED_INTERACTIVE,
+    AURORA_PRED_CPU_BOUND,
+    AURORA_PRED_IO_BOUND,
+    AURORA_PRED_MIXED,
+    AURORA_NR_PRED_CLASSES
+};
+
+static const char * const aurora_pred_class_names[AURORA_NR_PRED_CLASSES] = {
+    [AURORA_PRED_INTERACTIVE] = "interactive",
+    [AURORA_PRED_CPU_BOUND]   = "cpu_bound",
+    [AURORA_PRED_IO_BOUND]    = "io_bound",
+    [AURORA_PRED_MIXED]       = "mixed",
+};
+
+/* Upper bounds of the relative error buckets, in percent */
+static const unsigned int aurora_pred_buckets[] = { 10, 25, 50, 100, UINT_MAX };
+#define AURORA_NR_PRED_BUCKETS ARRAY_SIZE(aurora_pred_buckets)
+#define AURORA_PRED_HIT_BUCKETS 2 /* buckets up to 25% count as hits */
+#define AURORA_BURST_PERIODS 8    /* each burst moves avg_burst by ~16% */
+
+struct aurora_pred_stats {
+    u64 hist[AURORA_NR_PRED_CLASSES][AURORA_NR_PRED_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct aurora_pred_stats, aurora_pred_stats);
+
+/* Totals at the previous accuracy update, to compute per-interval accuracy */
+static u64 aurora_pred_last_total, aurora_pred_last_hits;
+
 /* Prediction context */
 struct prediction_context {
     u64 timestamp;
@@ -55,30 +348,69 @@ struct prediction_context {
 /* Aurora AI Scheduler main structure */
 struct aurora_ai_sched {
     struct prediction_context *pred_ctx;
-    struct rb_root pattern_tree;
+    struct pattern_shard *shards;
+    unsigned int shard_mask;
+    struct kmem_cache *pattern_cache;
     struct task_struct *current_task;
     struct performance_metrics *perf_metrics;
-    spinlock_t pattern_lock;
-    bool enabled;
+    struct delayed_work merge_work;
 };
 
 static struct aurora_ai_sched *aurora_sched;
 
+/*
+ * Every hook site tests this first, so a disabled scheduler costs a
+ * patched NOP. Only set while aurora_sched is fully set up.
+ */
+DEFINE_STATIC_KEY_FALSE(aurora_ai_sched_enabled);
+static DEFINE_MUTEX(aurora_enable_lock);
+
+static int calculate_context_score(struct task_struct *task,
+                                   struct usage_pattern *pattern);
+static int calculate_prediction_score(struct task_struct *task,
+                                      struct usage_pattern *pattern);
+static void update_prediction_accuracy(void);
+static int calculate_current_accuracy(void);
+
 /* Performance metrics tracking */
 struct performance_metrics {
     u64 total_tasks_scheduled;
     u64 prediction_accuracy;
     u64 context_switches;
     u64 avg_response_time;
+    u64 avg_task_runtime;
+    u64 samples_dropped;
     u64 last_update;
 };
 
+static void aurora_merge_work_fn(struct work_struct *work);
+static void aurora_sample_batch_fn(struct irq_work *work);
+static void aurora_seed_existing_tasks(void);
+static const struct proc_ops aurora_classes_proc_ops;
+static const struct proc_ops aurora_enabled_proc_ops;
+static const struct aurora_ai_control_ops aurora_sched_control_ops;
+static int aurora_accuracy_show(struct seq_file *m, void *v);
+#ifdef CONFIG_SCHED_AURORA
+static struct sched_aurora_wake_ops aurora_wake_ops;
+#endif
+
 /* Initialize Aurora AI Scheduler */
 static int __init aurora_ai_scheduler_init(void)
 {
+    unsigned int nr_shards, i;
+    int cpu, ret;
+
     printk(KERN_INFO "Aurora OS AI Scheduler v%s initializing...\n", 
            AI_SCHEDULER_VERSION);
 
+    BUILD_BUG_ON(aurora_default_weights[AURORA_SCORE_BASE] +
+                 aurora_default_weights[AURORA_SCORE_CONTEXT] +
+                 aurora_default_weights[AURORA_SCORE_PREDICTION] !=
+                 AURORA_FIXED_ONE);
+    memcpy(aurora_weight_tables[0], aurora_default_weights,
+           sizeof(aurora_default_weights));
+    RCU_INIT_POINTER(aurora_score_weights, aurora_weight_tables[0]);
+
     /* Allocate scheduler structure */
     aurora_sched = kzalloc(sizeof(struct aurora_ai_sched), GFP_KERNEL);
     if (!aurora_sched) {
@@ -86,132 +418,1130 @@ static int __init aurora_ai_scheduler_init(void)
         return -ENOMEM;
     }
 
-    /* Initialize pattern tree */
-    aurora_sched->pattern_tree = RB_ROOT;
-    spin_lock_init(&aurora_sched->pattern_lock);
+    /* Patterns are allocated at fork, never from scheduling context */
+    aurora_sched->pattern_cache = KMEM_CACHE(usage_pattern, SLAB_ACCOUNT);
+    if (!aurora_sched->pattern_cache) {
+        kfree(aurora_sched);
+        printk(KERN_ERR "Failed to create usage pattern cache\n");
+        return -ENOMEM;
+    }
+
+    /* Initialize sharded pattern store, one shard per possible CPU */
+    nr_shards = roundup_pow_of_two(num_possible_cpus());
+    aurora_sched->shards = kvcalloc(nr_shards, sizeof(struct pattern_shard),
+                                    GFP_KERNEL);
+    if (!aurora_sched->shards) {
+        kmem_cache_destroy(aurora_sched->pattern_cache);
+        kfree(aurora_sched);
+        printk(KERN_ERR "Failed to allocate pattern shards\n");
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < nr_shards; i++) {
+        spin_lock_init(&aurora_sched->shards[i].lock);
+        __hash_init(aurora_sched->shards[i].hash,
+                    ARRAY_SIZE(aurora_sched->shards[i].hash));
+    }
+    aurora_sched->shard_mask = nr_shards - 1;
 
     /* Initialize prediction context */
     aurora_sched->pred_ctx = kzalloc(sizeof(struct prediction_context), 
                                     GFP_KERNEL);
     if (!aurora_sched->pred_ctx) {
+        kvfree(aurora_sched->shards);
+        kmem_cache_destroy(aurora_sched->pattern_cache);
         kfree(aurora_sched);
         printk(KERN_ERR "Failed to allocate prediction context\n");
         return -ENOMEM;
     }
 
-    spin_lock_init(&aurora_sched->pred_ctx->lock);
-    INIT_LIST_HEAD(&aurora_sched->pred_ctx->tasks);
+    spin_lock_init(&aurora_sched->pred_ctx->lock);
+    INIT_LIST_HEAD(&aurora_sched->pred_ctx->tasks);
+
+    /* Initialize performance metrics */
+    aurora_sched->perf_metrics = kzalloc(sizeof(struct performance_metrics), 
+                                         GFP_KERNEL);
+    if (!aurora_sched->perf_metrics) {
+        kfree(aurora_sched->pred_ctx);
+        kvfree(aurora_sched->shards);
+        kmem_cache_destroy(aurora_sched->pattern_cache);
+        kfree(aurora_sched);
+        printk(KERN_ERR "Failed to allocate performance metrics\n");
+        return -ENOMEM;
+    }
+
+    /* Initialize per-CPU AI runqueues */
+    for_each_possible_cpu(cpu) {
+        struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+
+        raw_spin_lock_init(&arq->lock);
+        arq->tasks_timeline = RB_ROOT_CACHED;
+        arq->nr_queued = 0;
+        atomic_set(&arq->llc_cpu_bound, 0);
+
+        arq->llc_cpu = cpumask_first(cpu_coregroup_mask(cpu));
+        if (arq->llc_cpu >= nr_cpu_ids)
+            arq->llc_cpu = cpu;
+        arq->llc = per_cpu_ptr(&aurora_runqueues, arq->llc_cpu);
+        cpumask_set_cpu(arq->llc_cpu, &aurora_llc_leaders);
+
+        per_cpu(aurora_sample_rings, cpu).work =
+            IRQ_WORK_INIT_LAZY(aurora_sample_batch_fn);
+    }
+
+    /* Userspace workload classification interface */
+    aurora_proc_dir = proc_mkdir("aurora_sched", NULL);
+    if (aurora_proc_dir) {
+        proc_create("classes", 0644, aurora_proc_dir, &aurora_classes_proc_ops);
+        proc_create("enabled", 0644, aurora_proc_dir, &aurora_enabled_proc_ops);
+        proc_create_single("accuracy", 0444, aurora_proc_dir, aurora_accuracy_show);
+    }
+
+    /* Seed patterns for tasks that predate the module */
+    aurora_seed_existing_tasks();
+
+    aurora_ai_scheduler_enable(true);
+
+    /* Weights and classes can still be set through /proc without it */
+    ret = aurora_ai_register_control(&aurora_sched_control_ops);
+    if (ret)
+        printk(KERN_WARNING "Aurora AI Scheduler control plane unavailable: %d\n", ret);
+
+    /* Start background merge of per-CPU aggregates */
+    INIT_DELAYED_WORK(&aurora_sched->merge_work, aurora_merge_work_fn);
+    schedule_delayed_work(&aurora_sched->merge_work, PATTERN_MERGE_INTERVAL);
+    
+    printk(KERN_INFO "Aurora OS AI Scheduler initialized successfully\n");
+    return 0;
+}
+
+static inline u64 aurora_class_key(enum aurora_class_type type, u64 id)
+{
+    return id ^ ((u64)type << 63);
+}
+
+/* Caller must hold rcu_read_lock() or aurora_class_mutex */
+static struct aurora_class *aurora_class_find(enum aurora_class_type type, u64 id)
+{
+    struct aurora_class *class;
+
+    hash_for_each_possible_rcu(aurora_class_table, class, node,
+                               aurora_class_key(type, id)) {
+        if (class->type == type && class->id == id)
+            return class;
+    }
+
+    return NULL;
+}
+
+/* Caller must hold rcu_read_lock() or aurora_class_mutex */
+static struct aurora_pressure *aurora_pressure_find(u64 cgroup_id)
+{
+    struct aurora_pressure *pressure;
+
+    hash_for_each_possible_rcu(aurora_pressure_table, pressure, node, cgroup_id) {
+        if (pressure->cgroup_id == cgroup_id)
+            return pressure;
+    }
+
+    return NULL;
+}
+
+/*
+ * Resolve a pattern's boost, an executable match overriding its cgroup,
+ * and its cgroup's pressure, the system's standing in for a cgroup
+ * without an entry.
+ */
+static void aurora_resolve_class(struct usage_pattern *pattern)
+{
+    struct aurora_pressure *pressure;
+    struct aurora_class *class;
+    int boost = 0;
+
+    pattern->class_gen = READ_ONCE(aurora_class_gen);
+    smp_rmb();
+
+    rcu_read_lock();
+    class = aurora_class_find(AURORA_CLASS_EXE, pattern->exe_ino);
+    if (!class)
+        class = aurora_class_find(AURORA_CLASS_CGROUP, pattern->cgroup_id);
+    if (class)
+        boost = class->boost;
+
+    pressure = aurora_pressure_find(pattern->cgroup_id);
+    if (!pressure)
+        pressure = aurora_pressure_find(0);
+    if (pressure)
+        memcpy(pattern->stall, pressure->stall, sizeof(pattern->stall));
+    else
+        memset(pattern->stall, 0, sizeof(pattern->stall));
+    rcu_read_unlock();
+
+    pattern->class_boost = boost;
+}
+
+/* Re-resolve after the class or pressure tables changed */
+static inline void aurora_refresh_class(struct usage_pattern *pattern)
+{
+    if (unlikely(pattern->class_gen != READ_ONCE(aurora_class_gen)))
+        aurora_resolve_class(pattern);
+}
+
+/* Record the task's cgroup and executable; needs process context */
+static void aurora_pattern_set_identity(struct usage_pattern *pattern,
+                                        struct task_struct *task)
+{
+    struct file *exe_file;
+
+#ifdef CONFIG_CGROUPS
+    rcu_read_lock();
+    pattern->cgroup_id = cgroup_id(task_dfl_cgroup(task));
+    rcu_read_unlock();
+#endif
+
+    pattern->exe_ino = 0;
+    exe_file = get_task_exe_file(task);
+    if (exe_file) {
+        pattern->exe_ino = file_inode(exe_file)->i_ino;
+        fput(exe_file);
+    }
+
+    aurora_resolve_class(pattern);
+}
+
+/*
+ * Put @class in place of any entry with its type and id; a zero boost
+ * only removes. Caller holds aurora_class_mutex and bumps the generation.
+ */
+static void __aurora_class_replace(struct aurora_class *class)
+{
+    struct aurora_class *old;
+
+    old = aurora_class_find(class->type, class->id);
+    if (old) {
+        hash_del_rcu(&old->node);
+        kfree_rcu(old, rcu);
+    }
+
+    if (class->boost)
+        hash_add_rcu(aurora_class_table, &class->node,
+                     aurora_class_key(class->type, class->id));
+    else
+        kfree(class);
+}
+
+/* Publish the table before patterns see the new generation */
+static void __aurora_class_publish(void)
+{
+    smp_wmb();
+    WRITE_ONCE(aurora_class_gen, aurora_class_gen + 1);
+}
+
+static void __aurora_class_flush(void)
+{
+    struct aurora_class *class;
+    struct hlist_node *tmp;
+    int bkt;
+
+    hash_for_each_safe(aurora_class_table, bkt, tmp, class, node) {
+        hash_del_rcu(&class->node);
+        kfree_rcu(class, rcu);
+    }
+}
+
+/*
+ * Put @pressure in place of its cgroup's entry; an entry without any
+ * stall only removes. Caller holds aurora_class_mutex and bumps the
+ * generation.
+ */
+static void __aurora_pressure_replace(struct aurora_pressure *pressure)
+{
+    struct aurora_pressure *old;
+
+    old = aurora_pressure_find(pressure->cgroup_id);
+    if (old) {
+        hash_del_rcu(&old->node);
+        kfree_rcu(old, rcu);
+    }
+
+    if (memchr_inv(pressure->stall, 0, sizeof(pressure->stall)))
+        hash_add_rcu(aurora_pressure_table, &pressure->node, pressure->cgroup_id);
+    else
+        kfree(pressure);
+}
+
+static void __aurora_pressure_flush(void)
+{
+    struct aurora_pressure *pressure;
+    struct hlist_node *tmp;
+    int bkt;
+
+    hash_for_each_safe(aurora_pressure_table, bkt, tmp, pressure, node) {
+        hash_del_rcu(&pressure->node);
+        kfree_rcu(pressure, rcu);
+    }
+}
+
+static int aurora_class_update(enum aurora_class_type type, u64 id, int boost)
+{
+    struct aurora_class *class;
+
+    class = kzalloc(sizeof(*class), GFP_KERNEL);
+    if (!class)
+        return -ENOMEM;
+    class->id = id;
+    class->type = type;
+    class->boost = boost;
+
+    mutex_lock(&aurora_class_mutex);
+    __aurora_class_replace(class);
+    __aurora_class_publish();
+    mutex_unlock(&aurora_class_mutex);
+
+    return 0;
+}
+
+static void aurora_class_clear(void)
+{
+    mutex_lock(&aurora_class_mutex);
+    __aurora_class_flush();
+    __aurora_class_publish();
+    mutex_unlock(&aurora_class_mutex);
+}
+
+static int aurora_classes_show(struct seq_file *m, void *v)
+{
+    struct aurora_pressure *pressure;
+    struct aurora_class *class;
+    int bkt;
+
+    mutex_lock(&aurora_class_mutex);
+    hash_for_each(aurora_class_table, bkt, class, node) {
+        seq_printf(m, "%s %llu %d\n",
+                   class->type == AURORA_CLASS_EXE ? "exe" : "cgroup",
+                   class->id, class->boost);
+    }
+
+    /* Pressure is only set through the control plane; shown for reference */
+    hash_for_each(aurora_pressure_table, bkt, pressure, node) {
+        seq_printf(m, "pressure %llu cpu=%u memory=%u io=%u\n", pressure->cgroup_id,
+                   pressure->stall[AURORA_PRESSURE_CPU],
+                   pressure->stall[AURORA_PRESSURE_MEMORY],
+                   pressure->stall[AURORA_PRESSURE_IO]);
+    }
+    mutex_unlock(&aurora_class_mutex);
+
+    return 0;
+}
+
+static int aurora_classes_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, aurora_classes_show, NULL);
+}
+
+/*
+ * Accepts "cgroup <id> <boost>", "exe <inode> <boost>" or "clear".
+ * A boost of 0 removes the entry.
+ */
+static ssize_t aurora_classes_write(struct file *file, const char __user *ubuf,
+                                    size_t count, loff_t *ppos)
+{
+    char buf[64], kind[8];
+    enum aurora_class_type type;
+    u64 id;
+    int boost, ret;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sysfs_streq(buf, "clear")) {
+        aurora_class_clear();
+        return count;
+    }
+
+    if (sscanf(buf, "%7s %llu %d", kind, &id, &boost) != 3)
+        return -EINVAL;
+
+    if (!strcmp(kind, "cgroup"))
+        type = AURORA_CLASS_CGROUP;
+    else if (!strcmp(kind, "exe"))
+        type = AURORA_CLASS_EXE;
+    else
+        return -EINVAL;
+
+    ret = aurora_class_update(type, id, clamp(boost, -100, 100));
+    return ret ? ret : count;
+}
+
+static const struct proc_ops aurora_classes_proc_ops = {
+    .proc_open    = aurora_classes_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+    .proc_write   = aurora_classes_write,
+};
+
+/*
+ * Control plane. A staged configuration holds a validated weight table
+ * and the class and pressure entries, already allocated, so committing
+ * only swaps pointers and links entries in. The whole batch lands under
+ * one table generation, so no pattern resolves against half of it.
+ */
+struct aurora_sched_control {
+    u32 weights[AURORA_NR_SCORE_COMPONENTS];
+    bool has_weights;
+    bool flush;
+    struct hlist_head classes;
+    struct hlist_head pressure;
+};
+
+static const struct nla_policy aurora_class_policy[AURORA_AI_CLASS_MAX + 1] = {
+    [AURORA_AI_CLASS_TYPE]  = NLA_POLICY_MAX(NLA_U8, AURORA_CLASS_EXE),
+    [AURORA_AI_CLASS_ID]    = { .type = NLA_U64 },
+    [AURORA_AI_CLASS_BOOST] = NLA_POLICY_RANGE(NLA_S32, -100, 100),
+};
+
+static const struct nla_policy aurora_pressure_policy[AURORA_AI_PRESSURE_MAX + 1] = {
+    [AURORA_AI_PRESSURE_CGROUP] = { .type = NLA_U64 },
+    [AURORA_AI_PRESSURE_CPU]    = NLA_POLICY_MAX(NLA_U16, AURORA_AI_PRESSURE_FULL),
+    [AURORA_AI_PRESSURE_MEMORY] = NLA_POLICY_MAX(NLA_U16, AURORA_AI_PRESSURE_FULL),
+    [AURORA_AI_PRESSURE_IO]     = NLA_POLICY_MAX(NLA_U16, AURORA_AI_PRESSURE_FULL),
+};
+
+static const struct nla_policy aurora_sched_control_policy[AURORA_AI_SCHED_MAX + 1] = {
+    [AURORA_AI_SCHED_WEIGHTS]     = NLA_POLICY_EXACT_LEN(sizeof(u32) * AURORA_NR_SCORE_COMPONENTS),
+    [AURORA_AI_SCHED_CLASS_FLUSH] = { .type = NLA_FLAG },
+    [AURORA_AI_SCHED_CLASS]       = NLA_POLICY_NESTED(aurora_class_policy),
+    [AURORA_AI_SCHED_PRESSURE]    = NLA_POLICY_NESTED(aurora_pressure_policy),
+};
+
+static void aurora_sched_control_abort(void *staged)
+{
+    struct aurora_sched_control *ctl = staged;
+    struct aurora_pressure *pressure;
+    struct aurora_class *class;
+    struct hlist_node *tmp;
+
+    hlist_for_each_entry_safe(class, tmp, &ctl->classes, node)
+        kfree(class);
+    hlist_for_each_entry_safe(pressure, tmp, &ctl->pressure, node)
+        kfree(pressure);
+    kfree(ctl);
+}
+
+static int aurora_sched_control_class(struct aurora_sched_control *ctl,
+                                      const struct nlattr *attr,
+                                      struct netlink_ext_ack *extack)
+{
+    struct nlattr *tb[AURORA_AI_CLASS_MAX + 1];
+    struct aurora_class *class;
+    int ret;
+
+    ret = nla_parse_nested(tb, AURORA_AI_CLASS_MAX, attr, aurora_class_policy, extack);
+    if (ret)
+        return ret;
+
+    if (!tb[AURORA_AI_CLASS_TYPE] || !tb[AURORA_AI_CLASS_ID]) {
+        NL_SET_ERR_MSG_ATTR(extack, attr, "Class needs a type and an id");
+        return -EINVAL;
+    }
+
+    class = kzalloc(sizeof(*class), GFP_KERNEL);
+    if (!class)
+        return -ENOMEM;
+    class->type = nla_get_u8(tb[AURORA_AI_CLASS_TYPE]);
+    class->id = nla_get_u64(tb[AURORA_AI_CLASS_ID]);
+    if (tb[AURORA_AI_CLASS_BOOST])
+        class->boost = nla_get_s32(tb[AURORA_AI_CLASS_BOOST]);
+
+    /* Applied in message order, so a later entry for the same key wins */
+    hlist_add_head(&class->node, &ctl->classes);
+    return 0;
+}
+
+static int aurora_sched_control_pressure(struct aurora_sched_control *ctl,
+                                         const struct nlattr *attr,
+                                         struct netlink_ext_ack *extack)
+{
+    static const int resource_attrs[AURORA_NR_PRESSURE] = {
+        [AURORA_PRESSURE_CPU]    = AURORA_AI_PRESSURE_CPU,
+        [AURORA_PRESSURE_MEMORY] = AURORA_AI_PRESSURE_MEMORY,
+        [AURORA_PRESSURE_IO]     = AURORA_AI_PRESSURE_IO,
+    };
+    struct nlattr *tb[AURORA_AI_PRESSURE_MAX + 1];
+    struct aurora_pressure *pressure;
+    int i, ret;
+
+    ret = nla_parse_nested(tb, AURORA_AI_PRESSURE_MAX, attr, aurora_pressure_policy, extack);
+    if (ret)
+        return ret;
+
+    if (!tb[AURORA_AI_PRESSURE_CGROUP]) {
+        NL_SET_ERR_MSG_ATTR(extack, attr, "Pressure needs a cgroup");
+        return -EINVAL;
+    }
+
+    pressure = kzalloc(sizeof(*pressure), GFP_KERNEL);
+    if (!pressure)
+        return -ENOMEM;
+    pressure->cgroup_id = nla_get_u64(tb[AURORA_AI_PRESSURE_CGROUP]);
+    for (i = 0; i < AURORA_NR_PRESSURE; i++) {
+        if (tb[resource_attrs[i]])
+            pressure->stall[i] = nla_get_u16(tb[resource_attrs[i]]);
+    }
+
+    /* Applied in message order, as classes are */
+    hlist_add_head(&pressure->node, &ctl->pressure);
+    return 0;
+}
+
+static void *aurora_sched_control_prepare(const struct nlattr *nest,
+                                          struct netlink_ext_ack *extack)
+{
+    struct nlattr *tb[AURORA_AI_SCHED_MAX + 1];
+    struct aurora_sched_control *ctl;
+    const struct nlattr *attr;
+    int rem, ret;
+    u32 sum = 0;
+    int i;
+
+    ret = nla_parse_nested(tb, AURORA_AI_SCHED_MAX, nest,
+                           aurora_sched_control_policy, extack);
+    if (ret)
+        return ERR_PTR(ret);
+
+    ctl = kzalloc(sizeof(*ctl), GFP_KERNEL);
+    if (!ctl)
+        return ERR_PTR(-ENOMEM);
+    INIT_HLIST_HEAD(&ctl->classes);
+    INIT_HLIST_HEAD(&ctl->pressure);
+
+    if (tb[AURORA_AI_SCHED_WEIGHTS]) {
+        nla_memcpy(ctl->weights, tb[AURORA_AI_SCHED_WEIGHTS], sizeof(ctl->weights));
+        for (i = 0; i < AURORA_NR_SCORE_COMPONENTS; i++)
+            sum += min_t(u32, ctl->weights[i], AURORA_FIXED_ONE + 1);
+        if (sum != AURORA_FIXED_ONE) {
+            NL_SET_ERR_MSG_ATTR(extack, tb[AURORA_AI_SCHED_WEIGHTS],
+                                "Score weights must sum to 1024");
+            ret = -EINVAL;
+            goto err;
+        }
+        ctl->has_weights = true;
+    }
+
+    ctl->flush = nla_get_flag(tb[AURORA_AI_SCHED_CLASS_FLUSH]);
+
+    /* The tail of the list is the first entry in the message */
+    nla_for_each_nested(attr, nest, rem) {
+        if (nla_type(attr) == AURORA_AI_SCHED_CLASS)
+            ret = aurora_sched_control_class(ctl, attr, extack);
+        else if (nla_type(attr) == AURORA_AI_SCHED_PRESSURE)
+            ret = aurora_sched_control_pressure(ctl, attr, extack);
+        else
+            continue;
+        if (ret)
+            goto err;
+    }
+
+    return ctl;
+
+err:
+    aurora_sched_control_abort(ctl);
+    return ERR_PTR(ret);
+}
+
+static void aurora_sched_control_commit(void *staged)
+{
+    struct aurora_sched_control *ctl = staged;
+    struct aurora_pressure *pressure;
+    struct aurora_class *class;
+    struct hlist_node *tmp;
+    HLIST_HEAD(ordered);
+    HLIST_HEAD(ordered_pressure);
+    u32 *next;
+
+    if (ctl->has_weights) {
+        next = aurora_weight_tables[rcu_access_pointer(aurora_score_weights) ==
+                                    aurora_weight_tables[0]];
+        memcpy(next, ctl->weights, sizeof(ctl->weights));
+        rcu_assign_pointer(aurora_score_weights, next);
+
+        /* Nobody scores with the old buffer once this returns */
+        synchronize_rcu();
+    }
+
+    if (ctl->flush || !hlist_empty(&ctl->classes) || !hlist_empty(&ctl->pressure)) {
+        /* Reverse the staging lists back into message order */
+        hlist_for_each_entry_safe(class, tmp, &ctl->classes, node) {
+            hlist_del(&class->node);
+            hlist_add_head(&class->node, &ordered);
+        }
+        hlist_for_each_entry_safe(pressure, tmp, &ctl->pressure, node) {
+            hlist_del(&pressure->node);
+            hlist_add_head(&pressure->node, &ordered_pressure);
+        }
+
+        mutex_lock(&aurora_class_mutex);
+        if (ctl->flush)
+            __aurora_class_flush();
+        hlist_for_each_entry_safe(class, tmp, &ordered, node) {
+            hlist_del(&class->node);
+            __aurora_class_replace(class);
+        }
+        hlist_for_each_entry_safe(pressure, tmp, &ordered_pressure, node) {
+            hlist_del(&pressure->node);
+            __aurora_pressure_replace(pressure);
+        }
+        __aurora_class_publish();
+        mutex_unlock(&aurora_class_mutex);
+    }
+
+    kfree(ctl);
+}
+
+static const struct aurora_ai_control_ops aurora_sched_control_ops = {
+    .attr = AURORA_AI_ATTR_SCHED,
+    .prepare = aurora_sched_control_prepare,
+    .commit = aurora_sched_control_commit,
+    .abort = aurora_sched_control_abort,
+};
+
+static int aurora_enabled_show(struct seq_file *m, void *v)
+{
+    seq_printf(m, "%d\n", static_key_enabled(&aurora_ai_sched_enabled));
+    return 0;
+}
+
+static int aurora_enabled_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, aurora_enabled_show, NULL);
+}
+
+/* Lets benchmarks flip between the AI policy and stock CFS between runs */
+static ssize_t aurora_enabled_write(struct file *file, const char __user *ubuf,
+                                    size_t count, loff_t *ppos)
+{
+    bool enable;
+    int ret;
+
+    ret = kstrtobool_from_user(ubuf, count, &enable);
+    if (ret)
+        return ret;
+
+    aurora_ai_scheduler_enable(enable);
+    return count;
+}
+
+static const struct proc_ops aurora_enabled_proc_ops = {
+    .proc_open    = aurora_enabled_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+    .proc_write   = aurora_enabled_write,
+};
+
+static enum aurora_pred_class aurora_pred_class_of(struct usage_pattern *pattern)
+{
+    if (pattern->avg_burst < AURORA_SHORT_RUNTIME_NS)
+        return AURORA_PRED_INTERACTIVE;
+    if (pattern->features->cpu_intensity >= AURORA_CPU_BOUND_INTENSITY)
+        return AURORA_PRED_CPU_BOUND;
+    if (pattern->features->io_intensity > pattern->features->cpu_intensity)
+        return AURORA_PRED_IO_BOUND;
+    return AURORA_PRED_MIXED;
+}
+
+/* A task became runnable: predict the burst it will run */
+static void aurora_predict_burst(struct usage_pattern *pattern,
+                                 struct task_struct *task)
+{
+    pattern->predicted_burst = pattern->avg_burst;
+    pattern->pred_class = aurora_pred_class_of(pattern);
+    pattern->burst_start = task->se.sum_exec_runtime;
+    pattern->burst_valid = pattern->access_count > 1;
+}
+
+/* The task blocked: score the prediction and learn the observed burst */
+static void aurora_observe_burst(struct usage_pattern *pattern,
+                                 struct task_struct *task)
+{
+    u64 observed = task->se.sum_exec_runtime - pattern->burst_start;
+    u64 error, pct;
+    unsigned int b;
+
+    if (pattern->burst_valid) {
+        error = observed > pattern->predicted_burst ?
+                observed - pattern->predicted_burst :
+                pattern->predicted_burst - observed;
+        pct = div64_u64(error * 100, max_t(u64, observed, 1));
+
+        for (b = 0; b < AURORA_NR_PRED_BUCKETS - 1; b++) {
+            if (pct <= aurora_pred_buckets[b])
+                break;
+        }
+        this_cpu_inc(aurora_pred_stats.hist[pattern->pred_class][b]);
+    }
+
+    pattern->avg_burst = pattern->avg_burst ?
+                         aurora_ewma(pattern->avg_burst, observed,
+                                     AURORA_BURST_PERIODS) : observed;
+    pattern->burst_valid = false;
+}
+
+/* Capacity a predicted burst asks for: proportional up to the full window */
+static inline unsigned long aurora_freq_boost(u64 burst)
+{
+    if (burst < AURORA_FREQ_MIN_BURST_NS)
+        return 0;
+    return min_t(u64, burst, 1ULL << AURORA_FREQ_BURST_SHIFT) >>
+           (AURORA_FREQ_BURST_SHIFT - SCHED_CAPACITY_SHIFT);
+}
+
+/*
+ * A task woke on @arq: hold its burst's capacity for as long as the
+ * burst is predicted to last, so schedutil ramps before PELT catches up.
+ * The larger of overlapping boosts wins. Called under arq->lock.
+ */
+static void aurora_freq_wake(struct aurora_rq *arq, struct usage_pattern *pattern)
+{
+    unsigned long boost = pattern->burst_valid ?
+                          aurora_freq_boost(pattern->predicted_burst) : 0;
+    u64 now, until;
+
+    if (!boost)
+        return;
+
+    now = local_clock();
+    until = now + pattern->predicted_burst;
+    if (now >= arq->freq_boost_until || boost > arq->freq_boost)
+        WRITE_ONCE(arq->freq_boost, boost);
+    if (until > arq->freq_boost_until)
+        WRITE_ONCE(arq->freq_boost_until, until);
+}
+
+/*
+ * A task blocked on @arq. With nothing left on the timeline the CPU is
+ * about to idle, so let the frequency drop now instead of riding the
+ * PELT decay. Called under arq->lock.
+ */
+static void aurora_freq_sleep(struct aurora_rq *arq)
+{
+    if (arq->nr_queued)
+        return;
+
+    WRITE_ONCE(arq->freq_boost_until, 0);
+    WRITE_ONCE(arq->freq_idle, true);
+}
+
+#ifdef CONFIG_SCHED_AURORA
+static unsigned long aurora_freq_util_hint(int cpu, unsigned long util, unsigned long max)
+{
+    struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+
+    if (READ_ONCE(arq->freq_idle))
+        return 0;
+    if (local_clock() < READ_ONCE(arq->freq_boost_until))
+        return max(util, (READ_ONCE(arq->freq_boost) * max) >> SCHED_CAPACITY_SHIFT);
+    return util;
+}
+
+static struct sched_aurora_freq_ops aurora_freq_ops = {
+    .util_hint = aurora_freq_util_hint,
+};
+#endif
+
+static void aurora_pred_totals(u64 *total, u64 *hits)
+{
+    unsigned int c, b;
+    int cpu;
+
+    *total = 0;
+    *hits = 0;
+    for_each_possible_cpu(cpu) {
+        struct aurora_pred_stats *ps = per_cpu_ptr(&aurora_pred_stats, cpu);
+
+        for (c = 0; c < AURORA_NR_PRED_CLASSES; c++) {
+            for (b = 0; b < AURORA_NR_PRED_BUCKETS; b++) {
+                u64 n = READ_ONCE(ps->hist[c][b]);
+
+                *total += n;
+                if (b < AURORA_PRED_HIT_BUCKETS)
+                    *hits += n;
+            }
+        }
+    }
+}
+
+static int aurora_accuracy_show(struct seq_file *m, void *v)
+{
+    u64 hist[AURORA_NR_PRED_BUCKETS];
+    unsigned int c, b;
+    int cpu;
+
+    seq_puts(m, "class        <=10%   <=25%   <=50%   <=100%  >100%\n");
+    for (c = 0; c < AURORA_NR_PRED_CLASSES; c++) {
+        memset(hist, 0, sizeof(hist));
+        for_each_possible_cpu(cpu) {
+            struct aurora_pred_stats *ps = per_cpu_ptr(&aurora_pred_stats, cpu);
+
+            for (b = 0; b < AURORA_NR_PRED_BUCKETS; b++)
+                hist[b] += READ_ONCE(ps->hist[c][b]);
+        }
+
+        seq_printf(m, "%-12s", aurora_pred_class_names[c]);
+        for (b = 0; b < AURORA_NR_PRED_BUCKETS; b++)
+            seq_printf(m, " %-7llu", hist[b]);
+        seq_putc(m, '\n');
+    }
+
+    return 0;
+}
+
+static inline struct pattern_shard *pattern_shard_of(pid_t pid)
+{
+    return &aurora_sched->shards[hash_32(pid, 32) & aurora_sched->shard_mask];
+}
+
+/* Find usage pattern for a task. Caller must hold rcu_read_lock(). */
+static struct usage_pattern *find_pattern_pid(pid_t pid)
+{
+    struct pattern_shard *shard = pattern_shard_of(pid);
+    struct usage_pattern *pattern;
+
+    hlist_for_each_entry_rcu(pattern,
+                             &shard->hash[hash_32(pid, PATTERN_HASH_BITS)],
+                             node) {
+        if (pattern->pid == pid)
+            return pattern;
+    }
+
+    return NULL;
+}
+
+static inline struct usage_pattern *find_pattern(struct task_struct *task)
+{
+    return find_pattern_pid(task->pid);
+}
+
+/* Insert a new pattern, or return the one another CPU raced in first */
+static struct usage_pattern *insert_pattern(struct usage_pattern *new)
+{
+    struct pattern_shard *shard = pattern_shard_of(new->pid);
+    struct hlist_head *head = &shard->hash[hash_32(new->pid, PATTERN_HASH_BITS)];
+    struct usage_pattern *pattern;
+    unsigned long flags;
+
+    spin_lock_irqsave(&shard->lock, flags);
+    hlist_for_each_entry(pattern, head, node) {
+        if (pattern->pid == new->pid) {
+            spin_unlock_irqrestore(&shard->lock, flags);
+            aurora_task_features_put(new->features);
+            kmem_cache_free(aurora_sched->pattern_cache, new);
+            return pattern;
+        }
+    }
+    hlist_add_head_rcu(&new->node, head);
+    shard->nr_patterns++;
+    spin_unlock_irqrestore(&shard->lock, flags);
+
+    return new;
+}
+
+static void free_pattern_rcu(struct rcu_head *rcu)
+{
+    struct usage_pattern *pattern = container_of(rcu, struct usage_pattern, rcu);
+
+    aurora_task_features_put(pattern->features);
+    kmem_cache_free(aurora_sched->pattern_cache, pattern);
+}
+
+static struct usage_pattern *alloc_pattern(struct task_struct *task, gfp_t gfp)
+{
+    struct usage_pattern *pattern;
+
+    pattern = kmem_cache_zalloc(aurora_sched->pattern_cache, gfp);
+    if (!pattern)
+        return NULL;
 
-    /* Initialize performance metrics */
-    aurora_sched->perf_metrics = kzalloc(sizeof(struct performance_metrics), 
-                                         GFP_KERNEL);
-    if (!aurora_sched->perf_metrics) {
-        kfree(aurora_sched->pred_ctx);
-        kfree(aurora_sched);
-        printk(KERN_ERR "Failed to allocate performance metrics\n");
-        return -ENOMEM;
+    /* The pattern holds a reference, so samples can outlive the task */
+    pattern->features = aurora_task_features_get(task, gfp);
+    if (!pattern->features) {
+        kmem_cache_free(aurora_sched->pattern_cache, pattern);
+        return NULL;
     }
 
-    aurora_sched->enabled = true;
-    
-    printk(KERN_INFO "Aurora OS AI Scheduler initialized successfully\n");
-    return 0;
+    pattern->pid = task->pid;
+    strncpy(pattern->comm, task->comm, TASK_COMM_LEN - 1);
+    pattern->access_count = 1;
+    pattern->last_access = jiffies;
+    pattern->last_sum_exec = task->se.sum_exec_runtime;
+    pattern->last_wait_sum = task->stats.wait_sum;
+    pattern->last_sample = jiffies;
+    RB_CLEAR_NODE(&pattern->run_node);
+
+    if (gfpflags_allow_blocking(gfp))
+        aurora_pattern_set_identity(pattern, task);
+    else
+        aurora_resolve_class(pattern);
+
+    return insert_pattern(pattern);
 }
 
-/* Find usage pattern for a task */
-static struct usage_pattern *find_pattern(struct task_struct *task)
+/* Unhash a pattern and free it once concurrent RCU readers are done */
+static void remove_pattern(struct usage_pattern *pattern)
 {
-    struct rb_node *node = aurora_sched->pattern_tree.rb_node;
-    struct usage_pattern *pattern = NULL;
+    struct pattern_shard *shard = pattern_shard_of(pattern->pid);
+    unsigned long flags;
 
-    while (node) {
-        pattern = rb_entry(node, struct usage_pattern, node);
+    spin_lock_irqsave(&shard->lock, flags);
+    hlist_del_rcu(&pattern->node);
+    shard->nr_patterns--;
+    spin_unlock_irqrestore(&shard->lock, flags);
 
-        if (task->pid < pattern->pid)
-            node = node->rb_left;
-        else if (task->pid > pattern->pid)
-            node = node->rb_right;
-        else
-            return pattern;
+    call_rcu_lazy(&pattern->rcu, free_pattern_rcu);
+}
+
+/*
+ * Reclaim the patterns of tasks that died while the scheduler was off,
+ * when no death hook was registered to do it. Disabling drained the
+ * timelines, so none of them is queued.
+ */
+static void aurora_prune_dead_patterns(void)
+{
+    struct usage_pattern *pattern;
+    struct pattern_shard *shard;
+    struct hlist_node *tmp;
+    unsigned int i, b;
+    unsigned long flags;
+
+    for (i = 0; i <= aurora_sched->shard_mask; i++) {
+        shard = &aurora_sched->shards[i];
+        spin_lock_irqsave(&shard->lock, flags);
+        rcu_read_lock();
+        for (b = 0; b < ARRAY_SIZE(shard->hash); b++) {
+            hlist_for_each_entry_safe(pattern, tmp, &shard->hash[b], node) {
+                if (pid_task(find_pid_ns(pattern->pid, &init_pid_ns),
+                             PIDTYPE_PID))
+                    continue;
+                hlist_del_rcu(&pattern->node);
+                shard->nr_patterns--;
+                call_rcu_lazy(&pattern->rcu, free_pattern_rcu);
+            }
+        }
+        rcu_read_unlock();
+        spin_unlock_irqrestore(&shard->lock, flags);
     }
+}
 
-    return NULL;
+static void aurora_seed_existing_tasks(void)
+{
+    struct task_struct *g, *t;
+
+    rcu_read_lock();
+    for_each_process_thread(g, t)
+        alloc_pattern(t, GFP_ATOMIC);
+    rcu_read_unlock();
+}
+
+/* Fold one snapshot of a task's counters into its pattern */
+static void aurora_apply_sample(struct usage_pattern *pattern,
+                                const struct aurora_sample *sample)
+{
+    struct aurora_task_features *features;
+    struct aurora_cpu_stats *stats;
+    unsigned long periods;
+    u64 runtime, wait, elapsed;
+
+    /* Samples queued before a newer enqueue-time update are stale */
+    if (time_before(sample->stamp, pattern->last_sample) ||
+        sample->sum_exec < pattern->last_sum_exec)
+        return;
+
+    pattern->access_count++;
+    pattern->last_access = sample->stamp;
+
+    /* Update averages with the deltas since the previous sample */
+    periods = sample->stamp - pattern->last_sample;
+    runtime = sample->sum_exec - pattern->last_sum_exec;
+    wait = sample->wait_sum - pattern->last_wait_sum;
+    elapsed = jiffies_to_nsecs(max(periods, 1UL));
+
+    features = pattern->features;
+    WRITE_ONCE(features->avg_runtime,
+               aurora_ewma(features->avg_runtime, runtime, periods));
+    WRITE_ONCE(features->avg_wait,
+               aurora_ewma(features->avg_wait, wait, periods));
+    WRITE_ONCE(features->cpu_intensity, aurora_ewma(features->cpu_intensity,
+            min_t(u64, div64_u64(runtime << AURORA_FIXED_SHIFT, elapsed),
+                  AURORA_FIXED_ONE), periods));
+    WRITE_ONCE(features->io_intensity, aurora_ewma(features->io_intensity,
+            sample->iowait ? AURORA_FIXED_ONE : READ_ONCE(features->io_bandwidth),
+            periods));
+    aurora_task_features_publish(features, AURORA_FEATURE_SCHED);
+
+    pattern->last_sum_exec = sample->sum_exec;
+    pattern->last_wait_sum = sample->wait_sum;
+    pattern->last_sample = sample->stamp;
+
+    /* Feed the cross-CPU aggregates */
+    stats = this_cpu_ptr(&aurora_cpu_stats);
+    stats->runtime_sum += features->avg_runtime;
+    stats->samples++;
+}
+
+static inline void aurora_fill_sample(struct aurora_sample *sample,
+                                      struct task_struct *task)
+{
+    sample->pid = task->pid;
+    sample->iowait = task->in_iowait;
+    sample->stamp = jiffies;
+    sample->sum_exec = task->se.sum_exec_runtime;
+    sample->wait_sum = task->stats.wait_sum;
 }
 
-/* Create or update usage pattern */
 static struct usage_pattern *update_pattern(struct task_struct *task)
 {
     struct usage_pattern *pattern;
-    unsigned long flags;
-
-    spin_lock_irqsave(&aurora_sched->pattern_lock, flags);
+    struct aurora_sample sample;
 
+    rcu_read_lock();
     pattern = find_pattern(task);
-    if (!pattern) {
-        /* Create new pattern */
-        pattern = kzalloc(sizeof(struct usage_pattern), GFP_ATOMIC);
-        if (!pattern) {
-            spin_unlock_irqrestore(&aurora_sched->pattern_lock, flags);
-            return NULL;
-        }
+    rcu_read_unlock();
 
-        pattern->pid = task->pid;
-        strncpy(pattern->comm, task->comm, TASK_COMM_LEN - 1);
-        pattern->access_count = 1;
-        pattern->last_access = jiffies;
+    if (!pattern)
+        return NULL;
 
-        /* Insert into pattern tree */
-        rb_link_node(&pattern->node, &aurora_sched->pattern_tree.rb_node, NULL);
-        rb_insert_color(&pattern->node, &aurora_sched->pattern_tree);
-    } else {
-        /* Update existing pattern */
-        pattern->access_count++;
-        pattern->last_access = jiffies;
-        
-        /* Update averages with new data */
-        u64 current_runtime = task->se.sum_exec_runtime;
-        u64 current_wait = task->se.statistics.wait_sum;
-        
-        if (pattern->access_count > 1) {
-            pattern->avg_runtime = (pattern->avg_runtime + current_runtime) / 2;
-            pattern->avg_wait_time = (pattern->avg_wait_time + current_wait) / 2;
-        } else {
-            pattern->avg_runtime = current_runtime;
-            pattern->avg_wait_time = current_wait;
-        }
-    }
+    aurora_fill_sample(&sample, task);
+    aurora_apply_sample(pattern, &sample);
 
-    spin_unlock_irqrestore(&aurora_sched->pattern_lock, flags);
     return pattern;
 }
 
-/* Calculate AI score for task scheduling */
-static int calculate_ai_score(struct task_struct *task)
+/*
+ * Drain this CPU's tick samples. Scores are not refreshed here: the
+ * sampled task may already be back on a timeline, and it is re-scored
+ * by aurora_put_prev_task() anyway.
+ */
+static void aurora_sample_batch_fn(struct irq_work *work)
 {
+    struct aurora_sample_ring *ring =
+        container_of(work, struct aurora_sample_ring, work);
+    unsigned int head = smp_load_acquire(&ring->head);
+    unsigned int tail = ring->tail;
     struct usage_pattern *pattern;
-    int base_score, context_score, prediction_score;
-    int total_score = 0;
 
-    if (!aurora_sched->enabled)
-        return task->se.load.weight;
+    rcu_read_lock();
+    for (; tail != head; tail++) {
+        struct aurora_sample *sample = &ring->buf[tail & (AURORA_SAMPLE_RING - 1)];
 
-    /* Get or create usage pattern */
-    pattern = update_pattern(task);
-    if (!pattern)
+        pattern = find_pattern_pid(sample->pid);
+        if (pattern)
+            aurora_apply_sample(pattern, sample);
+    }
+    rcu_read_unlock();
+
+    smp_store_release(&ring->tail, tail);
+}
+
+/*
+ * Background merge of per-CPU aggregates. Folds each CPU's counters into
+ * the global performance metrics so that readers never touch remote
+ * per-CPU data and the hot paths never write shared cache lines.
+ */
+static void aurora_merge_work_fn(struct work_struct *work)
+{
+    struct performance_metrics *metrics = aurora_sched->perf_metrics;
+    u64 scheduled = 0, switches = 0, runtime = 0, samples = 0, dropped = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct aurora_cpu_stats *stats = per_cpu_ptr(&aurora_cpu_stats, cpu);
+
+        scheduled += READ_ONCE(stats->tasks_scheduled);
+        switches += READ_ONCE(stats->context_switches);
+        runtime += READ_ONCE(stats->runtime_sum);
+        samples += READ_ONCE(stats->samples);
+        dropped += READ_ONCE(stats->samples_dropped);
+    }
+
+    metrics->total_tasks_scheduled = scheduled;
+    metrics->context_switches = switches;
+    if (samples)
+        metrics->avg_task_runtime = div64_u64(runtime, samples);
+    metrics->samples_dropped = dropped;
+    metrics->last_update = jiffies;
+
+    update_prediction_accuracy();
+
+    schedule_delayed_work(&aurora_sched->merge_work, PATTERN_MERGE_INTERVAL);
+}
+
+/*
+ * Calculate AI score for task scheduling. The caller supplies the task's
+ * pattern, so this takes no locks and never allocates. Components are
+ * blended with the fixed-point weight table; no floating point is used.
+ * Class boosts and pressure can make the context and prediction points
+ * negative, so the blend is signed and only clamped once complete.
+ */
+static int calculate_ai_score(struct task_struct *task,
+                              struct usage_pattern *pattern)
+{
+    s64 base_score, context_score, prediction_score;
+    int context, prediction, score;
+    const u32 *weights;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled) || !pattern)
         return task->se.load.weight;
 
+    context = calculate_context_score(task, pattern);
+    prediction = calculate_prediction_score(task, pattern);
+
+    rcu_read_lock();
+    weights = rcu_dereference(aurora_score_weights);
+
     /* Base score from CFS */
-    base_score = task->se.load.weight * BASE_WEIGHT;
+    base_score = (s64)task->se.load.weight * weights[AURORA_SCORE_BASE];
 
     /* Context-aware scoring */
-    context_score = calculate_context_score(task, pattern) * CONTEXT_WEIGHT;
+    context_score = (s64)context * weights[AURORA_SCORE_CONTEXT];
 
     /* Predictive scoring */
-    prediction_score = calculate_prediction_score(task, pattern) * PREDICTION_WEIGHT;
+    prediction_score = (s64)prediction * weights[AURORA_SCORE_PREDICTION];
+    rcu_read_unlock();
+
+    /* Ensure minimum score */
+    score = clamp_t(s64, (base_score + context_score + prediction_score) >>
+                    AURORA_FIXED_SHIFT, 1, INT_MAX);
+
+    trace_aurora_sched_score(task, task->se.load.weight, context, prediction,
+                             pattern->class_boost, score);
+    return score;
+}
+
+/*
+ * Context points from the pressure reported for the task's cgroup. A CPU
+ * stall raises its tasks, runnable and starved as they are; memory and
+ * IO stalls lower the tasks bound on that same resource, since running
+ * them sooner only adds to the stall. Each is worth up to
+ * AURORA_PRESSURE_MAX_ADJ at a full stall.
+ */
+static inline int aurora_pressure_adjust(struct usage_pattern *pattern)
+{
+    u32 cpu = pattern->stall[AURORA_PRESSURE_CPU];
+    u32 mem = pattern->stall[AURORA_PRESSURE_MEMORY];
+    u32 io = pattern->stall[AURORA_PRESSURE_IO];
+
+    if (likely(!(cpu | mem | io)))
+        return 0;
 
-    total_score = base_score + context_score + prediction_score;
+    mem = (mem * pattern->features->cpu_intensity) >> AURORA_FIXED_SHIFT;
+    io = (io * pattern->features->io_intensity) >> AURORA_FIXED_SHIFT;
 
-    return max(total_score, 1); /* Ensure minimum score */
+    return ((int)cpu - (int)mem - (int)io) * AURORA_PRESSURE_MAX_ADJ /
+           AURORA_AI_PRESSURE_FULL;
 }
 
 /* Calculate context score based on current system context */
@@ -222,6 +1552,8 @@ static int calculate_context_score(struct task_struct *task,
     
     /* Time-based context */
     u64 current_time = jiffies;
+
+    aurora_refresh_class(pattern);
     
     /* Boost tasks that are frequently accessed recently */
     if (current_time - pattern->last_access < HZ) {
@@ -231,13 +1563,13 @@ static int calculate_context_score(struct task_struct *task,
     }
 
     /* I/O intensity consideration */
-    if (pattern->io_intensity > pattern->cpu_intensity) {
+    if (pattern->features->io_intensity > pattern->features->cpu_intensity) {
         /* I/O bound tasks get priority during I/O intensive periods */
         context_score += 30;
     }
 
     /* CPU-bound tasks during CPU-intensive periods */
-    if (pattern->cpu_intensity > pattern->io_intensity) {
+    if (pattern->features->cpu_intensity > pattern->features->io_intensity) {
         context_score += 20;
     }
 
@@ -246,6 +1578,9 @@ static int calculate_context_score(struct task_struct *task,
         context_score += 15;
     }
 
+    /* Resource pressure on the task's cgroup */
+    context_score += aurora_pressure_adjust(pattern);
+
     return context_score;
 }
 
@@ -261,110 +1596,595 @@ static int calculate_prediction_score(struct task_struct *task,
         prediction_score += min(pattern->access_count, 40);
     }
 
-    /* Predict based on task name patterns */
-    if (strstr(pattern->comm, "chrome") || strstr(pattern->comm, "firefox")) {
-        /* Browser tasks get priority for user experience */
-        prediction_score += 35;
-    } else if (strstr(pattern->comm, "systemd") || strstr(pattern->comm, "kernel")) {
-        /* System tasks get moderate priority */
-        prediction_score += 20;
-    } else if (strstr(pattern->comm, "aurora")) {
-        /* Aurora OS components get high priority */
-        prediction_score += 50;
-    }
+    /* Predict based on the workload class configured by userspace */
+    aurora_refresh_class(pattern);
+    prediction_score += pattern->class_boost;
 
     /* Predict based on runtime patterns */
-    if (pattern->avg_runtime < 1000000) { /* Short-running tasks */
+    if (pattern->features->avg_runtime < AURORA_SHORT_RUNTIME_NS) { /* Short-running tasks */
         prediction_score += 25; /* Boost for responsiveness */
     }
 
     return prediction_score;
 }
 
-/* Enhanced pick next task function */
-static struct task_struct *aurora_pick_next_task(struct rq *rq)
+/*
+ * Final ordering score. An attached sched_aurora_ops policy sees the
+ * built-in score and may replace it.
+ */
+static int aurora_task_score(struct task_struct *p, struct usage_pattern *pattern)
+{
+    struct sched_aurora_ops *ops;
+    s64 score = calculate_ai_score(p, pattern);
+
+    rcu_read_lock();
+    ops = sched_aurora_ops();
+    if (ops && ops->score)
+        score = ops->score(p, score);
+    rcu_read_unlock();
+
+    return clamp_t(s64, score, 1, INT_MAX);
+}
+
+/* Least loaded AI runqueue that shares a last-level cache with @cpu */
+static int aurora_llc_idlest_cpu(struct task_struct *p, int cpu)
 {
-    struct task_struct *next = NULL;
-    struct task_struct *p;
-    struct list_head *pos;
-    int best_score = -1;
+    unsigned int nr, min_nr = UINT_MAX;
+    int i, best = -1;
+
+    for_each_cpu_and(i, cpu_coregroup_mask(cpu), p->cpus_ptr) {
+        nr = READ_ONCE(per_cpu_ptr(&aurora_runqueues, i)->nr_queued);
+        if (nr < min_nr) {
+            min_nr = nr;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Wakeup placement. The attached policy may choose a CPU directly; tasks
+ * it assigns to the LLC dispatch queue land on the least loaded runqueue
+ * of @prev_cpu's LLC. Returns -1 to keep the built-in placement.
+ */
+static int aurora_select_task_rq(struct task_struct *p, int prev_cpu,
+                                 int wake_flags)
+{
+    struct sched_aurora_ops *ops;
+    int cpu = -1;
+
+    rcu_read_lock();
+    ops = sched_aurora_ops();
+    if (!ops)
+        goto out;
+
+    if (ops->select_cpu) {
+        cpu = ops->select_cpu(p, prev_cpu, wake_flags);
+        if (cpu >= 0 && cpu < nr_cpu_ids && cpumask_test_cpu(cpu, p->cpus_ptr))
+            goto out;
+        cpu = -1;
+    }
+
+    if (ops->dsq && ops->dsq(p) == SCHED_AURORA_DSQ_LLC)
+        cpu = aurora_llc_idlest_cpu(p, prev_cpu);
+out:
+    rcu_read_unlock();
+    return cpu;
+}
+
+/* Notify the attached policy that @p starts or stops running */
+static void aurora_ops_running(struct task_struct *p)
+{
+    struct sched_aurora_ops *ops;
+
+    rcu_read_lock();
+    ops = sched_aurora_ops();
+    if (ops && ops->running)
+        ops->running(p);
+    rcu_read_unlock();
+}
+
+static void aurora_ops_stopping(struct task_struct *p, bool runnable)
+{
+    struct sched_aurora_ops *ops;
+
+    rcu_read_lock();
+    ops = sched_aurora_ops();
+    if (ops && ops->stopping)
+        ops->stopping(p, runnable);
+    rcu_read_unlock();
+}
+
+/* Higher cached score sorts leftmost */
+static inline bool aurora_entity_before(struct rb_node *a,
+                                        const struct rb_node *b)
+{
+    return rb_entry(a, struct usage_pattern, run_node)->score >
+           rb_entry(b, struct usage_pattern, run_node)->score;
+}
+
+static void __aurora_enqueue(struct aurora_rq *arq,
+                             struct usage_pattern *pattern)
+{
+    rb_add_cached(&pattern->run_node, &arq->tasks_timeline,
+                  aurora_entity_before);
+    pattern->on_rq = true;
+    arq->nr_queued++;
+}
+
+static void __aurora_dequeue(struct aurora_rq *arq,
+                             struct usage_pattern *pattern)
+{
+    rb_erase_cached(&pattern->run_node, &arq->tasks_timeline);
+    RB_CLEAR_NODE(&pattern->run_node);
+    pattern->on_rq = false;
+    arq->nr_queued--;
+}
+
+/* Account a runnable task to its LLC's CPU-bound load if it is CPU-bound */
+static void aurora_account_llc(struct usage_pattern *pattern, int cpu)
+{
+    atomic_t *load;
+
+    if (pattern->llc_load || pattern->features->cpu_intensity < AURORA_CPU_BOUND_INTENSITY)
+        return;
+
+    load = &per_cpu_ptr(&aurora_runqueues, cpu)->llc->llc_cpu_bound;
+    atomic_inc(load);
+    pattern->llc_load = load;
+}
+
+static void aurora_unaccount_llc(struct usage_pattern *pattern)
+{
+    if (!pattern->llc_load)
+        return;
+
+    atomic_dec(pattern->llc_load);
+    pattern->llc_load = NULL;
+}
+
+/* Score a task once and queue it on its runqueue's AI timeline */
+static void aurora_enqueue_task(int cpu, struct task_struct *p, bool wakeup)
+{
+    struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+    struct usage_pattern *pattern;
+    unsigned long flags;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return;
+
+    pattern = update_pattern(p);
+    if (!pattern)
+        return;
+
+    raw_spin_lock_irqsave(&arq->lock, flags);
+    if (!pattern->on_rq && !pattern->dying) {
+        pattern->task = p;
+        pattern->cpu = cpu;
+        pattern->score = aurora_task_score(p, pattern);
+        __aurora_enqueue(arq, pattern);
+        aurora_account_llc(pattern, cpu);
+    }
+    /* Something to run again, however it arrived */
+    WRITE_ONCE(arq->freq_idle, false);
+    if (wakeup) {
+        aurora_predict_burst(pattern, p);
+        aurora_freq_wake(arq, pattern);
+    }
+    raw_spin_unlock_irqrestore(&arq->lock, flags);
+}
+
+static void aurora_dequeue_task(int cpu, struct task_struct *p, bool sleep)
+{
+    struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+    struct usage_pattern *pattern;
+    unsigned long flags;
+
+    if (!aurora_sched)
+        return;
 
-    if (!aurora_sched || !aurora_sched->enabled) {
-        /* Fall back to CFS if AI scheduler is disabled */
-        return pick_next_task_fair(rq, NULL, NULL);
+    rcu_read_lock();
+    pattern = find_pattern(p);
+    if (pattern) {
+        raw_spin_lock_irqsave(&arq->lock, flags);
+        if (pattern->on_rq && pattern->cpu == cpu)
+            __aurora_dequeue(arq, pattern);
+        aurora_unaccount_llc(pattern);
+        if (sleep) {
+            aurora_observe_burst(pattern, p);
+            aurora_freq_sleep(arq);
+        }
+        raw_spin_unlock_irqrestore(&arq->lock, flags);
     }
+    rcu_read_unlock();
+}
+
+/* Pick a CPU in the least CPU-bound LLC of @target's node, or -1 */
+static int aurora_spread_cpu(struct task_struct *p, int target)
+{
+    struct aurora_rq *target_llc = per_cpu_ptr(&aurora_runqueues, target)->llc;
+    int min_load = atomic_read(&target_llc->llc_cpu_bound);
+    int leader, cpu, load, best = -1;
 
-    /* Iterate through tasks and find best candidate */
-    list_for_each(pos, &rq->cfs.tasks) {
-        p = list_entry(pos, struct task_struct, run_list);
-        
-        if (task_running(rq, p))
+    for_each_cpu_and(leader, &aurora_llc_leaders, cpumask_of_node(cpu_to_node(target))) {
+        load = atomic_read(&per_cpu_ptr(&aurora_runqueues, leader)->llc_cpu_bound);
+        if (load >= min_load)
             continue;
 
-        /* Calculate AI-enhanced score */
-        int score = calculate_ai_score(p);
-        
-        if (score > best_score) {
-            best_score = score;
-            next = p;
+        cpu = cpumask_any_and(cpu_coregroup_mask(leader), p->cpus_ptr);
+        if (cpu < nr_cpu_ids) {
+            min_load = load;
+            best = cpu;
         }
     }
 
-    if (next) {
-        /* Update performance metrics */
-        aurora_sched->perf_metrics->total_tasks_scheduled++;
-        aurora_sched->perf_metrics->last_update = jiffies;
+    return best;
+}
+
+/*
+ * Wake hint for select_idle_sibling(). An attached BPF policy decides
+ * first. Otherwise short-running tasks stay on their cache-warm previous
+ * CPU, and CPU-bound tasks are steered to the least loaded LLC.
+ */
+static int aurora_select_idle_hint(struct task_struct *p, int prev, int target)
+{
+    struct usage_pattern *pattern;
+    int cpu = -1;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return -1;
+
+    cpu = aurora_select_task_rq(p, prev, 0);
+    if (cpu >= 0)
+        return cpu;
+
+    rcu_read_lock();
+    pattern = find_pattern(p);
+    if (pattern) {
+        if (pattern->features->avg_runtime < AURORA_SHORT_RUNTIME_NS &&
+            pattern->features->cpu_intensity < AURORA_CPU_BOUND_INTENSITY)
+            cpu = prev;
+        else if (pattern->features->cpu_intensity >= AURORA_CPU_BOUND_INTENSITY)
+            cpu = aurora_spread_cpu(p, target);
+    }
+    rcu_read_unlock();
+
+    return cpu;
+}
+
+#ifdef CONFIG_SCHED_AURORA
+static struct sched_aurora_wake_ops aurora_wake_ops = {
+    .select_idle_hint = aurora_select_idle_hint,
+};
+#endif
+
+/* Re-score the outgoing task and return it to the timeline */
+static void aurora_put_prev_task(int cpu, struct task_struct *prev, bool queued)
+{
+    aurora_ops_stopping(prev, queued);
+
+    if (queued)
+        aurora_enqueue_task(cpu, prev, false);
+}
+
+/* @p got the CPU: it leaves the timeline until aurora_put_prev_task() */
+static void aurora_set_next_task(int cpu, struct task_struct *p)
+{
+    struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+    struct usage_pattern *pattern;
+    unsigned long flags;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return;
+
+    rcu_read_lock();
+    pattern = find_pattern(p);
+    if (pattern) {
+        raw_spin_lock_irqsave(&arq->lock, flags);
+        if (pattern->on_rq && pattern->cpu == cpu)
+            __aurora_dequeue(arq, pattern);
+        raw_spin_unlock_irqrestore(&arq->lock, flags);
+    }
+    rcu_read_unlock();
+
+    aurora_ops_running(p);
+
+    /* Update performance metrics */
+    this_cpu_inc(aurora_cpu_stats.tasks_scheduled);
+}
+
+/*
+ * The task CFS would run from this queue: the lowest vruntime, ignoring
+ * group scheduling. Only looked up for the pick tracepoint, since it walks
+ * the whole timeline. Called under arq->lock.
+ */
+static struct usage_pattern *aurora_cfs_candidate(struct aurora_rq *arq)
+{
+    struct usage_pattern *pattern, *best = NULL;
+    struct rb_node *node;
+
+    for (node = rb_first_cached(&arq->tasks_timeline); node; node = rb_next(node)) {
+        pattern = rb_entry(node, struct usage_pattern, run_node);
+        if (!best ||
+            (s64)(pattern->task->se.vruntime - best->task->se.vruntime) < 0)
+            best = pattern;
+    }
+
+    return best;
+}
+
+/*
+ * Pick hint for the fair class: the leftmost node of the per-CPU
+ * timeline, the highest score. It stays queued until it actually gets
+ * the CPU, see aurora_set_next_task(), since CFS may still run another
+ * task to keep fairness.
+ */
+static struct task_struct *aurora_pick_next_task(int cpu)
+{
+    struct aurora_rq *arq = per_cpu_ptr(&aurora_runqueues, cpu);
+    struct aurora_telemetry_record *rec;
+    struct usage_pattern *pattern, *cfs = NULL;
+    struct rb_node *leftmost;
+    struct task_struct *next = NULL;
+    unsigned long flags, tflags;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return NULL;
+
+    raw_spin_lock_irqsave(&arq->lock, flags);
+    leftmost = rb_first_cached(&arq->tasks_timeline);
+    if (leftmost) {
+        pattern = rb_entry(leftmost, struct usage_pattern, run_node);
+        if (trace_aurora_sched_pick_enabled())
+            cfs = aurora_cfs_candidate(arq);
+        next = pattern->task;
+
+        rec = aurora_telemetry_reserve(AURORA_TELEMETRY_SCHED_PICK, next->pid, &tflags);
+        if (rec) {
+            rec->arg = pattern->score;
+            rec->data[0] = pattern->features->avg_runtime;
+            rec->data[1] = pattern->features->avg_wait;
+            rec->data[2] = pattern->features->cpu_intensity;
+            rec->data[3] = pattern->features->io_intensity;
+            rec->data[4] = arq->nr_queued;
+            aurora_telemetry_commit(rec, tflags);
+        }
+        trace_aurora_sched_pick(cpu, next, pattern->score, arq->nr_queued,
+                                pattern->pred_class, cfs ? cfs->task : NULL,
+                                cfs ? cfs->pred_class : 0);
     }
+    raw_spin_unlock_irqrestore(&arq->lock, flags);
 
     return next;
 }
 
-/* Scheduler tick function for AI learning */
-static void aurora_scheduler_tick(void)
+/* Scheduler tick of a fair task, on @cpu under its rq lock */
+static void aurora_scheduler_tick(int cpu, struct task_struct *curr)
 {
-    struct task_struct *current = current_task();
-    
-    if (!aurora_sched || !aurora_sched->enabled)
+    struct aurora_sample_ring *ring;
+    unsigned int head, queued;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
         return;
 
-    /* Update current task pattern */
-    update_pattern(current);
+    /* Snapshot the running task; learning happens in the batch */
+    ring = this_cpu_ptr(&aurora_sample_rings);
+    head = ring->head;
+    queued = head - smp_load_acquire(&ring->tail);
+    if (unlikely(queued >= AURORA_SAMPLE_RING)) {
+        this_cpu_inc(aurora_cpu_stats.samples_dropped);
+        return;
+    }
+
+    aurora_fill_sample(&ring->buf[head & (AURORA_SAMPLE_RING - 1)], curr);
+    smp_store_release(&ring->head, head + 1);
+
+    if (queued + 1 >= AURORA_SAMPLE_BATCH)
+        irq_work_queue(&ring->work);
 
     /* Update context switches counter */
-    aurora_sched->perf_metrics->context_switches++;
+    this_cpu_inc(aurora_cpu_stats.context_switches);
+}
+
+/*
+ * Fork hook, called once the child is fully set up. It must not sleep,
+ * so the pattern is allocated without blocking; a child missed here or
+ * forked while the scheduler was off gets its pattern on first enqueue.
+ */
+static void aurora_task_fork(struct task_struct *p)
+{
+    struct usage_pattern *pattern;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return;
+
+    pattern = alloc_pattern(p, GFP_NOWAIT | __GFP_NOWARN);
+    if (pattern)
+        aurora_pattern_set_identity(pattern, p);
+}
+
+/* Exec hook: the executable changed, so refresh the workload identity */
+static void aurora_task_exec(struct task_struct *p)
+{
+    struct usage_pattern *pattern;
+
+    if (!static_branch_unlikely(&aurora_ai_sched_enabled))
+        return;
+
+    rcu_read_lock();
+    pattern = find_pattern(p);
+    if (pattern) {
+        strncpy(pattern->comm, p->comm, TASK_COMM_LEN - 1);
+        aurora_pattern_set_identity(pattern, p);
+    }
+    rcu_read_unlock();
+}
+
+/*
+ * Death hook, after the task's final context switch: reclaim the pattern
+ * so the store only tracks live tasks. It is marked dying and taken off
+ * the timeline under the runqueue lock first, so that an enqueue racing
+ * with us cannot put it back once it is unhashed.
+ */
+static void aurora_task_dead(struct task_struct *p)
+{
+    struct usage_pattern *pattern;
+    struct aurora_rq *arq;
+    unsigned long flags;
 
-    /* Periodic prediction accuracy update */
-    if (jiffies % HZ == 0) { /* Every second */
-        update_prediction_accuracy();
+    if (!aurora_sched)
+        return;
+
+    rcu_read_lock();
+    pattern = find_pattern(p);
+    if (pattern) {
+        arq = per_cpu_ptr(&aurora_runqueues, pattern->cpu);
+        raw_spin_lock_irqsave(&arq->lock, flags);
+        pattern->dying = true;
+        if (pattern->on_rq)
+            __aurora_dequeue(arq, pattern);
+        aurora_unaccount_llc(pattern);
+        raw_spin_unlock_irqrestore(&arq->lock, flags);
+
+        remove_pattern(pattern);
     }
+    rcu_read_unlock();
 }
 
+#ifdef CONFIG_SCHED_AURORA
+static struct sched_aurora_rq_ops aurora_rq_ops = {
+    .enqueue   = aurora_enqueue_task,
+    .dequeue   = aurora_dequeue_task,
+    .pick_hint = aurora_pick_next_task,
+    .set_next  = aurora_set_next_task,
+    .put_prev  = aurora_put_prev_task,
+    .tick      = aurora_scheduler_tick,
+    .fork      = aurora_task_fork,
+    .exec      = aurora_task_exec,
+    .dead      = aurora_task_dead,
+};
+#endif
+
 /* Update prediction accuracy metrics */
 static void update_prediction_accuracy(void)
 {
-    /* Implementation for tracking prediction accuracy */
-    /* This would compare predicted vs actual task performance */
+    int accuracy = calculate_current_accuracy();
+
+    /* Keep the previous value over intervals without predictions */
+    if (accuracy < 0)
+        return;
+
     aurora_sched->perf_metrics->prediction_accuracy = 
-        (aurora_sched->perf_metrics->prediction_accuracy * 9 + 
-         calculate_current_accuracy()) / 10;
+        (aurora_sched->perf_metrics->prediction_accuracy * 9 + accuracy) / 10;
 }
 
-/* Calculate current prediction accuracy */
+/*
+ * Percentage of burst predictions since the previous call that were hits,
+ * or -1 if none were scored. Only called from the merge work.
+ */
 static int calculate_current_accuracy(void)
 {
-    /* Simplified accuracy calculation */
-    /* In real implementation, this would be more sophisticated */
-    return 75; /* Placeholder: 75% accuracy */
+    u64 total, hits, d_total, d_hits;
+
+    aurora_pred_totals(&total, &hits);
+    d_total = total - aurora_pred_last_total;
+    d_hits = hits - aurora_pred_last_hits;
+    aurora_pred_last_total = total;
+    aurora_pred_last_hits = hits;
+
+    if (!d_total)
+        return -1;
+
+    return div64_u64(d_hits * 100, d_total);
+}
+
+/*
+ * Forget all runqueue state once the hooks are gone and their grace
+ * period is over: nothing keeps the timelines, LLC loads or frequency
+ * hints current while the scheduler is off, and a pattern's task may
+ * exit in the meantime.
+ */
+static void aurora_drain_runqueues(void)
+{
+    struct usage_pattern *pattern;
+    struct pattern_shard *shard;
+    struct aurora_rq *arq;
+    struct rb_node *node;
+    unsigned int i, b;
+    unsigned long flags;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        arq = per_cpu_ptr(&aurora_runqueues, cpu);
+        raw_spin_lock_irqsave(&arq->lock, flags);
+        while ((node = rb_first_cached(&arq->tasks_timeline))) {
+            pattern = rb_entry(node, struct usage_pattern, run_node);
+            __aurora_dequeue(arq, pattern);
+            pattern->task = NULL;
+        }
+        atomic_set(&arq->llc_cpu_bound, 0);
+        WRITE_ONCE(arq->freq_boost, 0);
+        WRITE_ONCE(arq->freq_boost_until, 0);
+        WRITE_ONCE(arq->freq_idle, false);
+        raw_spin_unlock_irqrestore(&arq->lock, flags);
+    }
+
+    /* Running tasks are accounted to their LLC without being queued */
+    for (i = 0; i <= aurora_sched->shard_mask; i++) {
+        shard = &aurora_sched->shards[i];
+        spin_lock_irqsave(&shard->lock, flags);
+        for (b = 0; b < ARRAY_SIZE(shard->hash); b++)
+            hlist_for_each_entry(pattern, &shard->hash[b], node)
+                pattern->llc_load = NULL;
+        spin_unlock_irqrestore(&shard->lock, flags);
+    }
 }
 
-/* Enable/disable AI scheduler */
+/*
+ * Enable/disable AI scheduler. Flips the hook static key and, with it,
+ * the runqueue, wake and frequency hints, so that the fair class,
+ * select_idle_sibling() and schedutil are back to their own decisions
+ * as well. Might sleep.
+ */
 void aurora_ai_scheduler_enable(bool enable)
 {
-    if (aurora_sched) {
-        aurora_sched->enabled = enable;
-        printk(KERN_INFO "Aurora AI scheduler %s\n", 
-               enable ? "enabled" : "disabled");
+    if (!aurora_sched)
+        return;
+
+    mutex_lock(&aurora_enable_lock);
+    if (enable == static_key_enabled(&aurora_ai_sched_enabled)) {
+        mutex_unlock(&aurora_enable_lock);
+        return;
+    }
+
+    if (enable) {
+        aurora_prune_dead_patterns();
+        static_branch_enable(&aurora_ai_sched_enabled);
+#ifdef CONFIG_SCHED_AURORA
+        /* Timeline upkeep and pick hints from the fair class */
+        if (sched_aurora_register_rq_ops(&aurora_rq_ops))
+            printk(KERN_WARNING "Aurora AI scheduler: runqueue hooks already registered\n");
+        /* Learned wakeup placement hints for select_idle_sibling() */
+        if (sched_aurora_register_wake_ops(&aurora_wake_ops))
+            printk(KERN_WARNING "Aurora AI scheduler: wake hints already registered\n");
+        /* Burst and idle predictions for schedutil */
+        if (sched_aurora_register_freq_ops(&aurora_freq_ops))
+            printk(KERN_INFO "Aurora AI scheduler: frequency hints unavailable\n");
+#endif
+    } else {
+#ifdef CONFIG_SCHED_AURORA
+        sched_aurora_unregister_freq_ops(&aurora_freq_ops);
+        sched_aurora_unregister_wake_ops(&aurora_wake_ops);
+        sched_aurora_unregister_rq_ops(&aurora_rq_ops);
+#endif
+        static_branch_disable(&aurora_ai_sched_enabled);
+        aurora_drain_runqueues();
     }
+    mutex_unlock(&aurora_enable_lock);
+
+    printk(KERN_INFO "Aurora AI scheduler %s\n",
+           enable ? "enabled" : "disabled");
 }
 
 /* Get scheduler statistics */
@@ -376,26 +2196,51 @@ void aurora_ai_scheduler_stats(struct ai_scheduler_stats *stats)
     stats->total_tasks = aurora_sched->perf_metrics->total_tasks_scheduled;
     stats->context_switches = aurora_sched->perf_metrics->context_switches;
     stats->prediction_accuracy = aurora_sched->perf_metrics->prediction_accuracy;
-    stats->enabled = aurora_sched->enabled;
+    aurora_pred_totals(&stats->predictions, &stats->prediction_hits);
+    stats->samples_dropped = aurora_sched->perf_metrics->samples_dropped;
+    stats->enabled = static_key_enabled(&aurora_ai_sched_enabled);
 }
 
 /* Cleanup function */
 static void __exit aurora_ai_scheduler_exit(void)
 {
-    struct rb_node *node;
     struct usage_pattern *pattern;
+    struct hlist_node *tmp;
+    unsigned int i, bkt;
+    int cpu;
 
     printk(KERN_INFO "Aurora OS AI Scheduler shutting down...\n");
 
     if (aurora_sched) {
-        /* Clean up pattern tree */
-        while ((node = rb_first(&aurora_sched->pattern_tree))) {
-            pattern = rb_entry(node, struct usage_pattern, node);
-            rb_erase(node, &aurora_sched->pattern_tree);
-            kfree(pattern);
+        aurora_ai_unregister_control(&aurora_sched_control_ops);
+
+        /* Turn the hooks back into NOPs and wait out those in flight */
+        aurora_ai_scheduler_enable(false);
+        synchronize_rcu();
+
+        cancel_delayed_work_sync(&aurora_sched->merge_work);
+        for_each_possible_cpu(cpu)
+            irq_work_sync(&per_cpu(aurora_sample_rings, cpu).work);
+        proc_remove(aurora_proc_dir);
+        aurora_class_clear();
+        mutex_lock(&aurora_class_mutex);
+        __aurora_pressure_flush();
+        mutex_unlock(&aurora_class_mutex);
+
+        /* Clean up pattern shards */
+        for (i = 0; i <= aurora_sched->shard_mask; i++) {
+            struct pattern_shard *shard = &aurora_sched->shards[i];
+
+            for (bkt = 0; bkt < ARRAY_SIZE(shard->hash); bkt++) {
+                hlist_for_each_entry_safe(pattern, tmp, &shard->hash[bkt], node)
+                    remove_pattern(pattern);
+            }
         }
+        rcu_barrier();
 
         /* Free allocated memory */
+        kmem_cache_destroy(aurora_sched->pattern_cache);
+        kvfree(aurora_sched->shards);
         kfree(aurora_sched->perf_metrics);
         kfree(aurora_sched->pred_ctx);
         kfree(aurora_sched);
@@ -415,5 +2260,10 @@ MODULE_DESCRIPTION("Aurora OS AI-Enhanced Scheduler");
 MODULE_VERSION(AI_SCHEDULER_VERSION);
 
 /* Exported functions for other kernel modules */
+EXPORT_SYMBOL(aurora_ai_sched_enabled);
 EXPORT_SYMBOL(aurora_ai_scheduler_enable);
-EXPORT_SYMBOL(aurora_ai_scheduler_stats);
\ No newline at end of file
+EXPORT_SYMBOL(aurora_ai_scheduler_stats);
+
+#ifdef CONFIG_AURORA_AI_KUNIT_TEST
+#include "tests/ai_scheduler_kunit.c"
+#endif
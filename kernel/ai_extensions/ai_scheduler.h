@@ -8,15 +8,22 @@
 
 #include <linux/types.h>
 #include <linux/sched.h>
+#include <linux/jump_label.h>
 
 /* AI Scheduler Statistics Structure */
 struct ai_scheduler_stats {
     u64 total_tasks;
     u64 context_switches;
     u64 prediction_accuracy;
+    u64 predictions;        /* burst predictions scored */
+    u64 prediction_hits;    /* within 25% of the observed burst */
+    u64 samples_dropped;    /* tick samples lost to a full ring */
     bool enabled;
 };
 
+/* Set while the AI scheduler is enabled; hook sites test it inline */
+DECLARE_STATIC_KEY_FALSE(aurora_ai_sched_enabled);
+
 /* AI Scheduler Control Functions */
 void aurora_ai_scheduler_enable(bool enable);
 void aurora_ai_scheduler_stats(struct ai_scheduler_stats *stats);
@@ -9,7 +9,9 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/fs.h>
+#include <linux/dcache.h>
 #include <linux/mm.h>
+#include <linux/mman.h>
 #include <linux/sched.h>
 #include <linux/cred.h>
 #include <linux/security.h>
@@ -29,8 +31,25 @@
 #include <linux/jiffies.h>
 #include <linux/timekeeping.h>
 #include <linux/delay.h>
+#include <linux/percpu.h>
+#include <linux/jump_label.h>
+#include <linux/srcu.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/aurora.h>
+#include <linux/jhash.h>
+#include <linux/sort.h>
+#include <linux/inet.h>
+#include <linux/in.h>
+#include <linux/uaccess.h>
+#include <linux/btf.h>
+#include <linux/btf_ids.h>
 #include <crypto/hash.h>
+#include <net/netlink.h>
 #include "ai_security.h"
+#include "aurora_core.h"
+#include "aurora_trace.h"
 
 /* Module Information */
 MODULE_LICENSE("GPL v2");
@@ -41,23 +60,96 @@ MODULE_VERSION("1.0.0");
 /* Global Security Manager Instance */
 struct ai_security_manager *ai_sec_mgr = NULL;
 
+/*
+ * Global policy generation. Combined with each profile's generation to
+ * key cached verdicts, so a threshold change invalidates all of them.
+ */
+static atomic_t ai_security_policy_gen = ATOMIC_INIT(0);
+
+static int ai_security_set_threshold(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_uint(val, kp);
+    
+    if (!ret)
+        atomic_inc(&ai_security_policy_gen);
+    return ret;
+}
+
+static int ai_security_set_auto_response(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_bool(val, kp);
+    
+    if (!ret)
+        atomic_inc(&ai_security_policy_gen);
+    return ret;
+}
+
+/*
+ * Hot paths test static keys rather than the flags. The learning key is
+ * only flipped once init is running; before that the flag is all there
+ * is, and init sets the key from it.
+ */
+static DEFINE_STATIC_KEY_FALSE(ai_security_hooks_active);
+static DEFINE_STATIC_KEY_FALSE(ai_security_learning_key);
+
+static int ai_security_set_learning(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_bool(val, kp);
+    
+    if (ret || !ai_sec_mgr)
+        return ret;
+    
+    if (ai_security_learning_enabled)
+        static_branch_enable(&ai_security_learning_key);
+    else
+        static_branch_disable(&ai_security_learning_key);
+    return 0;
+}
+
+static const struct kernel_param_ops ai_security_threshold_ops = {
+    .set = ai_security_set_threshold,
+    .get = param_get_uint,
+};
+
+static const struct kernel_param_ops ai_security_auto_response_ops = {
+    .set = ai_security_set_auto_response,
+    .get = param_get_bool,
+};
+
+static const struct kernel_param_ops ai_security_learning_ops = {
+    .set = ai_security_set_learning,
+    .get = param_get_bool,
+};
+
 /* Module Parameters */
 u32 ai_security_threat_threshold = AI_SECURITY_THREAT_SCORE_THRESHOLD;
-module_param(ai_security_threat_threshold, uint, 0644);
+module_param_cb(ai_security_threat_threshold, &ai_security_threshold_ops,
+                &ai_security_threat_threshold, 0644);
 MODULE_PARM_DESC(ai_security_threat_threshold, "Threat score threshold for automatic action");
 
 bool ai_security_auto_response = true;
-module_param(ai_security_auto_response, bool, 0644);
+module_param_cb(ai_security_auto_response, &ai_security_auto_response_ops,
+                &ai_security_auto_response, 0644);
 MODULE_PARM_DESC(ai_security_auto_response, "Enable automatic security responses");
 
 bool ai_security_learning_enabled = true;
-module_param(ai_security_learning_enabled, bool, 0644);
+module_param_cb(ai_security_learning_enabled, &ai_security_learning_ops,
+                &ai_security_learning_enabled, 0644);
 MODULE_PARM_DESC(ai_security_learning_enabled, "Enable security learning and adaptation");
 
 bool ai_security_debug_enabled = false;
 module_param(ai_security_debug_enabled, bool, 0644);
 MODULE_PARM_DESC(ai_security_debug_enabled, "Enable debug logging");
 
+bool ai_security_offload = false;
+module_param(ai_security_offload, bool, 0444);
+MODULE_PARM_DESC(ai_security_offload, "Leave hook decisions to attached BPF LSM programs");
+
+u32 ai_security_core_isolate_trust = AI_SECURITY_CORE_ISOLATE_TRUST;
+module_param(ai_security_core_isolate_trust, uint, 0644);
+MODULE_PARM_DESC(ai_security_core_isolate_trust,
+                 "Trust percentage below which a task gets an SMT core of its own (0 disables)");
+
 u32 ai_security_max_events_per_process = AI_SECURITY_MAX_EVENTS_PER_PROCESS;
 module_param(ai_security_max_events_per_process, uint, 0644);
 MODULE_PARM_DESC(ai_security_max_events_per_process, "Maximum events to store per process");
@@ -65,6 +157,40 @@ MODULE_PARM_DESC(ai_security_max_events_per_process, "Maximum events to store pe
 /* Static event ID counter */
 static atomic64_t event_id_counter = ATOMIC64_INIT(1);
 
+/* Statistics */
+static inline void ai_security_stat_inc(enum ai_security_stat stat)
+{
+    this_cpu_inc(ai_sec_mgr->stats->count[stat]);
+}
+
+static u64 ai_security_stat_sum(enum ai_security_stat stat)
+{
+    u64 sum = 0;
+    int cpu;
+    
+    for_each_possible_cpu(cpu)
+        sum += per_cpu_ptr(ai_sec_mgr->stats, cpu)->count[stat];
+    return sum;
+}
+
+/* Account one hook invocation that started at @start (local_clock) */
+static inline void ai_security_hook_done(enum ai_security_hook hook, u64 start)
+{
+    u64 ns = local_clock() - start;
+    unsigned int b = 0;
+    
+    if (unlikely(!ai_sec_mgr))
+        return;
+    
+    if (ns >> AI_SECURITY_LAT_MIN_SHIFT)
+        b = min_t(unsigned int, ilog2(ns) - AI_SECURITY_LAT_MIN_SHIFT + 1,
+                  AI_SECURITY_LAT_BUCKETS - 1);
+    
+    this_cpu_inc(ai_sec_mgr->stats->hook_calls[hook]);
+    this_cpu_add(ai_sec_mgr->stats->hook_ns[hook], ns);
+    this_cpu_inc(ai_sec_mgr->stats->hook_lat[hook][b]);
+}
+
 /* Utility Functions */
 static inline u32 ai_security_hash_string(const char *str)
 {
@@ -92,35 +218,76 @@ static char *ai_security_strdup(const char *s)
     return dup;
 }
 
-static char *ai_security_get_executable_path(struct task_struct *task)
+/* Return a referenced interned copy of @name, creating it if needed */
+static struct ai_security_path *ai_security_intern_path(const char *name)
+{
+    struct ai_security_path *path, *new;
+    size_t len = strlen(name);
+    u32 hash = full_name_hash(NULL, name, len);
+    struct hlist_head *head = &ai_sec_mgr->path_hash[hash_32(hash, AI_SECURITY_PATH_HASH_BITS)];
+    
+    new = kzalloc(struct_size(new, name, len + 1), GFP_KERNEL);
+    
+    spin_lock(&ai_sec_mgr->paths_lock);
+    hlist_for_each_entry(path, head, node) {
+        if (path->hash == hash && !strcmp(path->name, name)) {
+            refcount_inc(&path->ref);
+            spin_unlock(&ai_sec_mgr->paths_lock);
+            kfree(new);
+            return path;
+        }
+    }
+    
+    if (new) {
+        refcount_set(&new->ref, 1);
+        new->hash = hash;
+        INIT_LIST_HEAD(&new->baseline_node);
+        spin_lock_init(&new->baseline.lock);
+        seqcount_spinlock_init(&new->baseline.seq, &new->baseline.lock);
+        memcpy(new->name, name, len + 1);
+        hlist_add_head(&new->node, head);
+    }
+    spin_unlock(&ai_sec_mgr->paths_lock);
+    
+    return new;
+}
+
+static void ai_security_put_path(struct ai_security_path *path)
+{
+    if (!path || !refcount_dec_and_lock(&path->ref, &ai_sec_mgr->paths_lock))
+        return;
+    
+    hlist_del(&path->node);
+    spin_unlock(&ai_sec_mgr->paths_lock);
+    kfree(path);
+}
+
+/*
+ * The path is resolved into a names_cache buffer that is returned right
+ * away; profiles keep only a reference to the interned string.
+ */
+static struct ai_security_path *ai_security_get_executable_path(struct task_struct *task)
 {
-    char *path = NULL;
-    struct mm_struct *mm;
+    struct ai_security_path *path = NULL;
     struct file *exe_file;
+    char *buf, *name;
     
     if (!task || !task->mm)
         return NULL;
     
-    mm = get_task_mm(task);
-    if (!mm)
+    exe_file = get_task_exe_file(task);
+    if (!exe_file)
         return NULL;
     
-    exe_file = mm->exe_file;
-    if (exe_file) {
-        path = kmalloc(PATH_MAX, GFP_KERNEL);
-        if (path) {
-            char *tmp = dentry_path_raw(exe_file->f_path.dentry, path, PATH_MAX);
-            if (IS_ERR(tmp)) {
-                kfree(path);
-                path = NULL;
-            } else {
-                /* Move the string to the beginning of the buffer */
-                memmove(path, tmp, strlen(tmp) + 1);
-            }
-        }
+    buf = __getname();
+    if (buf) {
+        name = dentry_path_raw(exe_file->f_path.dentry, buf, PATH_MAX);
+        if (!IS_ERR(name))
+            path = ai_security_intern_path(name);
+        __putname(buf);
     }
     
-    mmput(mm);
+    fput(exe_file);
     return path;
 }
 
@@ -130,14 +297,18 @@ static inline bool ai_security_is_system_process(pid_t pid)
 }
 
 /* Hash Table Functions */
+/*
+ * Both tables are read under RCU; writers take the bucket's entry in
+ * hash_locks[]. Retired profiles stay hashed until the reaper runs but
+ * are never found, so a reused pid gets a fresh profile.
+ */
 static struct ai_security_profile *ai_security_profile_lookup(pid_t pid)
 {
     struct ai_security_profile *profile;
-    struct hlist_node *node;
-    u32 hash = hash_32(pid, AI_SECURITY_HASH_SIZE);
+    u32 hash = hash_32(pid, AI_SECURITY_HASH_BITS);
     
-    hlist_for_each_entry_rcu(profile, node, &ai_sec_mgr->profile_hash[hash], hash) {
-        if (profile->pid == pid)
+    hlist_for_each_entry_rcu(profile, &ai_sec_mgr->profile_hash[hash], hash) {
+        if (profile->pid == pid && !READ_ONCE(profile->retired))
             return profile;
     }
     
@@ -146,17 +317,28 @@ static struct ai_security_profile *ai_security_profile_lookup(pid_t pid)
 
 static void ai_security_profile_add_to_hash(struct ai_security_profile *profile)
 {
-    u32 hash = hash_32(profile->pid, AI_SECURITY_HASH_SIZE);
+    u32 hash = hash_32(profile->pid, AI_SECURITY_HASH_BITS);
+    
+    spin_lock(&ai_sec_mgr->hash_locks[hash]);
     hlist_add_head_rcu(&profile->hash, &ai_sec_mgr->profile_hash[hash]);
+    spin_unlock(&ai_sec_mgr->hash_locks[hash]);
+}
+
+static void ai_security_profile_remove_from_hash(struct ai_security_profile *profile)
+{
+    u32 hash = hash_32(profile->pid, AI_SECURITY_HASH_BITS);
+    
+    spin_lock(&ai_sec_mgr->hash_locks[hash]);
+    hlist_del_rcu(&profile->hash);
+    spin_unlock(&ai_sec_mgr->hash_locks[hash]);
 }
 
 static struct ai_security_event *ai_security_event_lookup(u64 event_id)
 {
     struct ai_security_event *event;
-    struct hlist_node *node;
-    u32 hash = hash_64(event_id, AI_SECURITY_HASH_SIZE);
+    u32 hash = hash_64(event_id, AI_SECURITY_HASH_BITS);
     
-    hlist_for_each_entry_rcu(event, node, &ai_sec_mgr->event_hash[hash], hash) {
+    hlist_for_each_entry_rcu(event, &ai_sec_mgr->event_hash[hash], hash) {
         if (event->event_id == event_id)
             return event;
     }
@@ -166,251 +348,1965 @@ static struct ai_security_event *ai_security_event_lookup(u64 event_id)
 
 static void ai_security_event_add_to_hash(struct ai_security_event *event)
 {
-    u32 hash = hash_64(event->event_id, AI_SECURITY_HASH_SIZE);
+    u32 hash = hash_64(event->event_id, AI_SECURITY_HASH_BITS);
+    
+    spin_lock(&ai_sec_mgr->hash_locks[hash]);
     hlist_add_head_rcu(&event->hash, &ai_sec_mgr->event_hash[hash]);
+    spin_unlock(&ai_sec_mgr->hash_locks[hash]);
 }
 
-/* Profile Management */
-struct ai_security_profile *ai_security_get_profile(pid_t pid)
+static void ai_security_event_remove_from_hash(struct ai_security_event *event)
 {
-    struct ai_security_profile *profile;
-    unsigned long flags;
+    u32 hash = hash_64(event->event_id, AI_SECURITY_HASH_BITS);
     
-    if (!ai_sec_mgr)
-        return NULL;
-    
-    rcu_read_lock();
-    profile = ai_security_profile_lookup(pid);
-    rcu_read_unlock();
+    spin_lock(&ai_sec_mgr->hash_locks[hash]);
+    hlist_del_rcu(&event->hash);
+    spin_unlock(&ai_sec_mgr->hash_locks[hash]);
+}
+
+/* Retained Event Store */
+static inline u64 ai_security_event_minute(ktime_t t)
+{
+    return div_u64(ktime_to_ms(t), AI_SECURITY_EVENT_BUCKET_MS);
+}
+
+static void ai_security_free_event_rcu(struct rcu_head *head)
+{
+    ai_security_free_event(container_of(head, struct ai_security_event, rcu));
+}
+
+/* Unhash and free events spliced off the store */
+static void ai_security_release_events(struct list_head *expired)
+{
+    struct ai_security_event *event, *tmp;
     
-    return profile;
+    list_for_each_entry_safe(event, tmp, expired, list) {
+        list_del(&event->list);
+        ai_security_event_remove_from_hash(event);
+        /* Nothing waits on expiry; let idle CPUs batch the frees */
+        call_rcu_lazy(&event->rcu, ai_security_free_event_rcu);
+    }
 }
 
-static int ai_security_create_profile(struct task_struct *task)
+/*
+ * Keep a retained event. Only this CPU's store lock is taken; a bucket
+ * still holding a minute from an hour ago is emptied before reuse.
+ */
+static void ai_security_store_event(struct ai_security_event *event)
 {
-    struct ai_security_profile *profile;
-    char *exe_path;
+    struct ai_security_event_store *store;
+    u64 minute = ai_security_event_minute(event->timestamp);
+    unsigned int slot;
     unsigned long flags;
+    LIST_HEAD(expired);
     
-    if (!ai_sec_mgr || !task)
-        return -EINVAL;
-    
-    /* Check if profile already exists */
-    profile = ai_security_get_profile(task->pid);
-    if (profile)
-        return 0;
-    
-    /* Allocate new profile */
-    profile = kzalloc(sizeof(*profile), GFP_KERNEL);
-    if (!profile)
-        return -ENOMEM;
+    div_u64_rem(minute, AI_SECURITY_EVENT_BUCKETS, &slot);
     
-    /* Initialize profile */
-    profile->pid = task->pid;
-    strncpy(profile->comm, task->comm, TASK_COMM_LEN - 1);
-    profile->comm[TASK_COMM_LEN - 1] = '\0';
+    /* Hashed first, so everything in the store is on the hash */
+    ai_security_event_add_to_hash(event);
     
-    /* Get executable path and hash */
-    exe_path = ai_security_get_executable_path(task);
-    if (exe_path) {
-        profile->executable_path = exe_path;
-        profile->executable_hash = ai_security_hash_string(exe_path);
+    store = raw_cpu_ptr(ai_sec_mgr->event_stores);
+    spin_lock_irqsave(&store->lock, flags);
+    if (store->epoch[slot] < minute) {
+        list_splice_init(&store->buckets[slot], &expired);
+        store->epoch[slot] = minute;
     }
+    list_add_tail(&event->list, &store->buckets[slot]);
+    spin_unlock_irqrestore(&store->lock, flags);
     
-    /* Initialize security metrics */
-    profile->threat_score = 0;
-    profile->current_threat = AI_SECURITY_THREAT_NONE;
-    profile->behavior_score = 0.8f;  /* Start with moderate trust */
-    profile->risk_score = 0.2f;
-    profile->trust_score = 0.7f;
-    
-    /* Initialize timing */
-    profile->creation_time = ai_security_get_current_time();
-    profile->last_activity = profile->creation_time;
-    
-    /* Initialize lists and lock */
-    INIT_LIST_HEAD(&profile->list);
-    spin_lock_init(&profile->lock);
+    ai_security_release_events(&expired);
+}
+
+/* Drop every bucket whose minute is at least an hour old (all if @all) */
+static void ai_security_expire_events(ktime_t now, bool all)
+{
+    struct ai_security_event_store *store;
+    u64 minute = ai_security_event_minute(now);
+    unsigned long flags;
+    LIST_HEAD(expired);
+    int cpu, slot;
+    
+    for_each_possible_cpu(cpu) {
+        store = per_cpu_ptr(ai_sec_mgr->event_stores, cpu);
+        spin_lock_irqsave(&store->lock, flags);
+        for (slot = 0; slot < AI_SECURITY_EVENT_BUCKETS; slot++) {
+            if (all || store->epoch[slot] + AI_SECURITY_EVENT_BUCKETS <= minute)
+                list_splice_init(&store->buckets[slot], &expired);
+        }
+        spin_unlock_irqrestore(&store->lock, flags);
+    }
     
-    /* Add to global list and hash table */
-    spin_lock_irqsave(&ai_sec_mgr->profiles_lock, flags);
-    list_add_tail(&profile->list, &ai_sec_mgr->process_profiles);
-    ai_sec_mgr->processes_monitored++;
-    spin_unlock_irqrestore(&ai_sec_mgr->profiles_lock, flags);
+    ai_security_release_events(&expired);
+}
+
+static int ai_security_alloc_event_stores(void)
+{
+    struct ai_security_event_store *store;
+    int cpu, slot;
     
-    ai_security_profile_add_to_hash(profile);
+    ai_sec_mgr->event_stores = alloc_percpu(struct ai_security_event_store);
+    if (!ai_sec_mgr->event_stores)
+        return -ENOMEM;
     
-    if (ai_security_debug_enabled)
-        pr_info("AI Security: Created profile for PID %d (%s)\n", profile->pid, profile->comm);
+    for_each_possible_cpu(cpu) {
+        store = per_cpu_ptr(ai_sec_mgr->event_stores, cpu);
+        spin_lock_init(&store->lock);
+        for (slot = 0; slot < AI_SECURITY_EVENT_BUCKETS; slot++)
+            INIT_LIST_HEAD(&store->buckets[slot]);
+    }
     
     return 0;
 }
 
-/* Event Management */
-static int ai_security_create_event(struct ai_security_event **event, enum ai_security_event_type type)
+/* Event History */
+static struct ai_security_record_chunk *ai_security_chunk_alloc(int cpu, gfp_t gfp)
 {
-    struct ai_security_event *new_event;
-    
-    new_event = kzalloc(sizeof(*new_event), GFP_KERNEL);
-    if (!new_event)
-        return -ENOMEM;
-    
-    /* Initialize event */
-    new_event->event_id = atomic64_inc_return(&event_id_counter);
-    new_event->type = type;
-    new_event->timestamp = ai_security_get_current_time();
-    new_event->threat_level = AI_SECURITY_THREAT_NONE;
-    new_event->threat_score = 0;
-    new_event->recommended_action = AI_SECURITY_ACTION_ALLOW;
-    new_event->confidence = 50;  /* Default confidence */
-    new_event->false_positive_flag = false;
-    new_event->escalated = false;
+    struct ai_security_record_chunk *chunk;
     
-    /* Initialize lists */
-    INIT_LIST_HEAD(&new_event->related_events);
-    INIT_LIST_HEAD(&new_event->list);
-    INIT_HLIST_NODE(&new_event->hash);
+    chunk = kmalloc(struct_size(chunk, records, AI_SECURITY_CHUNK_RECORDS), gfp);
+    if (chunk)
+        chunk->cpu = cpu;
     
-    *event = new_event;
-    return 0;
+    return chunk;
 }
 
-static int ai_security_analyze_event(struct ai_security_event *event)
+/*
+ * Append @event to this CPU's history. Hooks may run in atomic context,
+ * so a new chunk is only allocated with GFP_NOWAIT; at the cap, or if
+ * that fails, the oldest chunk is recycled.
+ */
+static void ai_security_history_append(const struct ai_security_event *event, int decision)
 {
+    struct ai_security_record_chunk *chunk;
     struct ai_security_profile *profile;
+    struct ai_security_history *hist;
+    struct ai_security_record *rec;
+    u64 now = ktime_to_ns(event->timestamp);
+    u32 exe_id = 0, object_id = 0;
     unsigned long flags;
-    int ret = 0;
+    int cpu;
     
-    if (!event || !ai_sec_mgr)
-        return -EINVAL;
+    rcu_read_lock();
+    profile = ai_security_profile_lookup(event->pid);
+    if (profile && profile->exe)
+        exe_id = profile->exe->hash;
+    rcu_read_unlock();
     
-    /* Get process profile */
-    profile = ai_security_get_profile(event->pid);
-    if (!profile) {
-        /* This shouldn't happen in normal operation */
-        event->threat_level = AI_SECURITY_THREAT_LOW;
-        event->threat_score = 25;
-        event->recommended_action = AI_SECURITY_ACTION_WARN;
-        return 0;
-    }
+    if (event->event_data && event->data_size)
+        object_id = jhash(event->event_data, event->data_size, 0);
     
-    spin_lock_irqsave(&profile->lock, flags);
+    cpu = raw_smp_processor_id();
+    hist = per_cpu_ptr(ai_sec_mgr->history, cpu);
+    spin_lock_irqsave(&hist->lock, flags);
     
-    /* Update profile statistics */
-    profile->event_count++;
+    /* A chunk spans at most U32_MAX microseconds */
+    chunk = hist->cur;
+    if (chunk && (chunk->nr == AI_SECURITY_CHUNK_RECORDS ||
+                  (now > chunk->base && now - chunk->base > (u64)U32_MAX * NSEC_PER_USEC))) {
+        list_add_tail(&chunk->list, &hist->chunks);
+        hist->cur = chunk = NULL;
+    }
     
-    /* Calculate threat score based on event type and profile */
-    switch (event->type) {
-    case AI_SECURITY_EVENT_FILE_ACCESS:
-        /* Check if file access is suspicious */
-        if (event->event_data && strstr(event->description, "sensitive")) {
-            event->threat_score += 30;
-        }
-        break;
-        
-    case AI_SECURITY_EVENT_NETWORK_CONNECT:
-        /* Check network connections */
-        if (profile->network_connection_count > 100) {
-            event->threat_score += 25;  /* Excessive connections */
-        }
-        break;
-        
-    case AI_SECURITY_EVENT_PRIVILEGE_ESCALATION:
-        /* Privilege escalation is inherently suspicious */
-        event->threat_score += 60;
-        profile->privilege_escalation_count++;
-        break;
-        
-    case AI_SECURITY_EVENT_PROCESS_EXEC:
-        /* Check if executing suspicious executables */
-        if (event->event_data) {
-            char *exe_path = (char *)event->event_data;
-            if (strstr(exe_path, "/tmp/") || strstr(exe_path, "/var/tmp/")) {
-                event->threat_score += 40;  /* Executing from temp directory */
+    if (!chunk) {
+        if (hist->nr_chunks < AI_SECURITY_HISTORY_CHUNKS)
+            chunk = ai_security_chunk_alloc(cpu, GFP_NOWAIT | __GFP_NOWARN);
+        if (chunk) {
+            hist->nr_chunks++;
+        } else {
+            chunk = list_first_entry_or_null(&hist->chunks, struct ai_security_record_chunk, list);
+            if (!chunk) {
+                spin_unlock_irqrestore(&hist->lock, flags);
+                return;
             }
+            list_del(&chunk->list);
         }
-        break;
-        
-    default:
-        break;
+        chunk->nr = 0;
+        chunk->base = now;
+        hist->cur = chunk;
     }
     
-    /* Apply profile-based adjustments */
-    if (profile->trust_score < 0.3f) {
-        event->threat_score += 20;  /* Low trust process */
-    }
+    rec = &chunk->records[chunk->nr++];
+    rec->time_delta = now > chunk->base ? div_u64(now - chunk->base, NSEC_PER_USEC) : 0;
+    rec->seq = (u32)event->event_id;
+    rec->pid = event->pid;
+    rec->ppid = event->ppid;
+    rec->uid = event->uid;
+    rec->exe_id = exe_id;
+    rec->object_id = object_id;
+    rec->type = event->type;
+    rec->threat_level = event->threat_level;
+    rec->action = event->recommended_action;
+    rec->confidence = event->confidence;
+    rec->threat_score = min(event->threat_score, 255U);
+    rec->file_label = event->file_label;
+    rec->flags = decision ? AI_SECURITY_RECORD_DENIED : 0;
+    rec->nr_reasons = event->nr_reasons;
+    memcpy(rec->reasons, event->reasons, sizeof(rec->reasons));
+    memcpy(rec->comm, event->comm, TASK_COMM_LEN);
+    
+    spin_unlock_irqrestore(&hist->lock, flags);
+}
+
+/* The @idx-th chunk of @hist, oldest first; called with hist->lock held */
+static struct ai_security_record_chunk *ai_security_history_chunk(struct ai_security_history *hist,
+                                                                  loff_t idx)
+{
+    struct ai_security_record_chunk *chunk;
     
-    if (profile->anomaly_count > 5) {
-        event->threat_score += 15;  /* History of anomalies */
+    list_for_each_entry(chunk, &hist->chunks, list) {
+        if (!idx--)
+            return chunk;
     }
     
-    /* Cap threat score */
-    event->threat_score = min(event->threat_score, 100U);
-    
-    /* Determine threat level */
-    event->threat_level = ai_security_classify_threat(event->threat_score);
+    return hist->cur;
+}
+
+static loff_t ai_security_history_total(void)
+{
+    loff_t total = 0;
+    int cpu;
     
-    /* Calculate confidence */
-    event->confidence = (u32)(profile->behavior_score * 100);
-    event->confidence = min(event->confidence, 100U);
+    for_each_possible_cpu(cpu)
+        total += READ_ONCE(per_cpu_ptr(ai_sec_mgr->history, cpu)->nr_chunks);
     
-    /* Determine recommended action */
-    if (event->threat_score >= ai_security_threat_threshold) {
-        if (event->threat_score >= 90) {
-            event->recommended_action = AI_SECURITY_ACTION_TERMINATE;
-        } else if (event->threat_score >= 80) {
-            event->recommended_action = AI_SECURITY_ACTION_BLOCK;
-        } else {
-            event->recommended_action = AI_SECURITY_ACTION_QUARANTINE;
-        }
-    } else if (event->threat_score >= 50) {
-        event->recommended_action = AI_SECURITY_ACTION_WARN;
-    } else {
-        event->recommended_action = AI_SECURITY_ACTION_ALLOW;
-    }
+    return total;
+}
+
+static int ai_security_alloc_history(void)
+{
+    struct ai_security_history *hist;
+    int cpu;
     
-    /* Update profile metrics */
-    profile->threat_score = max(profile->threat_score, event->threat_score);
-    profile->current_threat = max(profile->current_threat, event->threat_level);
+    ai_sec_mgr->history = alloc_percpu(struct ai_security_history);
+    if (!ai_sec_mgr->history)
+        return -ENOMEM;
     
-    if (event->threat_score > 30) {
-        profile->anomaly_count++;
+    for_each_possible_cpu(cpu) {
+        hist = per_cpu_ptr(ai_sec_mgr->history, cpu);
+        spin_lock_init(&hist->lock);
+        INIT_LIST_HEAD(&hist->chunks);
     }
     
-    /* Update ML scores */
-    profile->risk_score = min(1.0f, profile->risk_score + (event->threat_score / 1000.0f));
-    profile->trust_score = max(0.0f, profile->trust_score - (event->threat_score / 500.0f));
-    profile->behavior_score = max(0.0f, profile->behavior_score - (event->threat_score / 200.0f));
+    return 0;
+}
+
+static void ai_security_free_history(void)
+{
+    struct ai_security_record_chunk *chunk, *tmp;
+    struct ai_security_history *hist;
+    int cpu;
     
-    spin_unlock_irqrestore(&profile->lock, flags);
+    if (!ai_sec_mgr->history)
+        return;
     
-    if (ai_security_debug_enabled && event->threat_score > 40) {
-        pr_info("AI Security: Event %llu - PID %d - Score: %u - Action: %d\n",
-                event->event_id, event->pid, event->threat_score, event->recommended_action);
+    for_each_possible_cpu(cpu) {
+        hist = per_cpu_ptr(ai_sec_mgr->history, cpu);
+        list_for_each_entry_safe(chunk, tmp, &hist->chunks, list)
+            kfree(chunk);
+        kfree(hist->cur);
     }
     
-    return ret;
-}
-
-static enum ai_security_threat_level ai_security_classify_threat(u32 score)
-{
-    if (score >= 90)
-        return AI_SECURITY_THREAT_CRITICAL;
-    else if (score >= 70)
-        return AI_SECURITY_THREAT_HIGH;
-    else if (score >= 50)
-        return AI_SECURITY_THREAT_MEDIUM;
-    else if (score >= 25)
-        return AI_SECURITY_THREAT_LOW;
-    else
-        return AI_SECURITY_THREAT_NONE;
+    free_percpu(ai_sec_mgr->history);
+    ai_sec_mgr->history = NULL;
 }
 
-static int ai_security_make_decision(struct ai_security_event *event)
+/* Profile Management */
+/*
+ * Profile lifetime. The list and the hash hold one reference; hooks
+ * hold another while they use a profile, since they may sleep. A
+ * profile is retired when its task is freed or when it is evicted to
+ * keep within AI_SECURITY_MAX_PROCESSES: it leaves the list at once,
+ * under profiles_lock, and lookups stop finding it. The reaper unhashes
+ * it from process context, and once the last reference is gone and a
+ * grace period has passed, folds it into its executable's baseline and
+ * frees it.
+ */
+struct ai_security_profile *ai_security_get_profile(pid_t pid)
 {
-    int decision = 0;  /* 0 = allow, 1 = deny */
+    struct ai_security_profile *profile;
     
-    if (!event)
+    if (!ai_sec_mgr)
+        return NULL;
+    
+    rcu_read_lock();
+    profile = ai_security_profile_lookup(pid);
+    if (profile && !refcount_inc_not_zero(&profile->ref))
+        profile = NULL;
+    rcu_read_unlock();
+    
+    return profile;
+}
+
+void ai_security_put_profile(struct ai_security_profile *profile)
+{
+    if (!profile || !refcount_dec_and_test(&profile->ref))
+        return;
+    
+    llist_add(&profile->free_node, &ai_sec_mgr->dead_profiles);
+    queue_work(ai_sec_mgr->deep_wq, &ai_sec_mgr->reap_work);
+}
+
+/* Caller holds profiles_lock; safe from any context */
+static void __ai_security_retire_profile(struct ai_security_profile *profile)
+{
+    if (profile->retired)
+        return;
+    
+    WRITE_ONCE(profile->retired, true);
+    list_del_rcu(&profile->list);
+    ai_sec_mgr->processes_monitored--;
+    
+    llist_add(&profile->retire_node, &ai_sec_mgr->retired_profiles);
+    queue_work(ai_sec_mgr->deep_wq, &ai_sec_mgr->reap_work);
+}
+
+static void ai_security_retire_profile(struct ai_security_profile *profile)
+{
+    unsigned long flags;
+    
+    spin_lock_irqsave(&ai_sec_mgr->profiles_lock, flags);
+    __ai_security_retire_profile(profile);
+    spin_unlock_irqrestore(&ai_sec_mgr->profiles_lock, flags);
+}
+
+/*
+ * Second chance: evict the oldest profile not used since the last scan,
+ * clearing the mark of those passed over. If every scanned profile was
+ * in use, the oldest goes. Caller holds profiles_lock.
+ */
+static void ai_security_evict_profile(void)
+{
+    struct ai_security_profile *profile, *victim = NULL;
+    int scanned = 0;
+    
+    list_for_each_entry(profile, &ai_sec_mgr->process_profiles, list) {
+        if (!victim)
+            victim = profile;
+        if (!READ_ONCE(profile->referenced)) {
+            victim = profile;
+            break;
+        }
+        WRITE_ONCE(profile->referenced, false);
+        if (++scanned == AI_SECURITY_EVICT_SCAN)
+            break;
+    }
+    
+    if (victim) {
+        __ai_security_retire_profile(victim);
+        ai_security_stat_inc(AI_SECURITY_STAT_PROFILES_EVICTED);
+    }
+}
+
+/*
+ * Find @key in a sorted endpoint set. On a miss *@pos is where it
+ * would be inserted.
+ */
+static bool ai_security_endpoint_search(const u64 *set, u32 nr, u64 key, u32 *pos)
+{
+    u32 lo = 0, hi = nr, mid;
+    
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (set[mid] == key) {
+            *pos = mid;
+            return true;
+        }
+        if (set[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    
+    *pos = lo;
+    return false;
+}
+
+static void ai_security_endpoint_insert(u64 *set, u32 *nr, u64 key)
+{
+    u32 pos;
+    
+    if (*nr >= AI_SECURITY_MAX_ENDPOINTS || ai_security_endpoint_search(set, *nr, key, &pos))
+        return;
+    
+    memmove(&set[pos + 1], &set[pos], (*nr - pos) * sizeof(set[0]));
+    set[pos] = key;
+    (*nr)++;
+}
+
+/*
+ * Fold a dead profile into its executable's baseline, so the next
+ * process of the same binary starts from its predecessors' history.
+ * Baselines with history are pinned, least recently folded dropped
+ * first.
+ */
+static void ai_security_fold_profile(struct ai_security_profile *profile)
+{
+    struct ai_security_path *exe = profile->exe, *unpin = NULL;
+    struct ai_security_baseline *b;
+    
+    if (!exe || !profile->event_count)
+        return;
+    
+    b = &exe->baseline;
+    spin_lock(&b->lock);
+    if (b->profiles)
+        b->trust_score = (7 * b->trust_score + profile->trust_score) / 8;
+    else
+        b->trust_score = profile->trust_score;
+    b->profiles++;
+    b->events += profile->event_count;
+    b->anomalies += profile->anomaly_count;
+    spin_unlock(&b->lock);
+    
+    spin_lock(&ai_sec_mgr->paths_lock);
+    if (list_empty(&exe->baseline_node)) {
+        refcount_inc(&exe->ref);
+        list_add_tail(&exe->baseline_node, &ai_sec_mgr->baselines);
+        if (++ai_sec_mgr->nr_baselines > AI_SECURITY_MAX_BASELINES) {
+            unpin = list_first_entry(&ai_sec_mgr->baselines, struct ai_security_path,
+                                     baseline_node);
+            list_del_init(&unpin->baseline_node);
+            ai_sec_mgr->nr_baselines--;
+        }
+    } else {
+        list_move_tail(&exe->baseline_node, &ai_sec_mgr->baselines);
+    }
+    spin_unlock(&ai_sec_mgr->paths_lock);
+    
+    ai_security_put_path(unpin);
+}
+
+/*
+ * Join the executable's baseline: the first process opens its baseline
+ * period, later ones start with the trust and anomaly history of those
+ * before them instead of the defaults.
+ */
+static void ai_security_seed_profile(struct ai_security_profile *profile)
+{
+    struct ai_security_baseline *b;
+    
+    if (!profile->exe)
+        return;
+    
+    b = &profile->exe->baseline;
+    spin_lock(&b->lock);
+    if (!b->started)
+        WRITE_ONCE(b->started, profile->creation_time);
+    if (b->profiles) {
+        profile->trust_score = b->trust_score;
+        profile->anomaly_count = b->anomalies / b->profiles;
+    }
+    spin_unlock(&b->lock);
+}
+
+static void ai_security_reap_profiles(void)
+{
+    struct ai_security_profile *profile, *tmp;
+    struct llist_node *list;
+    
+    list = llist_del_all(&ai_sec_mgr->retired_profiles);
+    llist_for_each_entry_safe(profile, tmp, list, retire_node) {
+        ai_security_profile_remove_from_hash(profile);
+        if (refcount_dec_and_test(&profile->ref))
+            llist_add(&profile->free_node, &ai_sec_mgr->dead_profiles);
+    }
+    
+    list = llist_del_all(&ai_sec_mgr->dead_profiles);
+    if (!list)
+        return;
+    
+    /* Lockless readers may still hold the pointer */
+    synchronize_rcu();
+    
+    llist_for_each_entry_safe(profile, tmp, list, free_node) {
+        ai_security_fold_profile(profile);
+        ai_security_free_profile(profile);
+    }
+}
+
+static void ai_security_reap_work(struct work_struct *work)
+{
+    ai_security_reap_profiles();
+}
+
+/* Queue @profile for the next learning pass; safe from any context */
+static void ai_security_mark_dirty(struct ai_security_profile *profile)
+{
+    if (!static_branch_unlikely(&ai_security_learning_key) ||
+        test_and_set_bit(AI_SECURITY_PROFILE_DIRTY, &profile->flags))
+        return;
+    
+    if (!refcount_inc_not_zero(&profile->ref)) {
+        clear_bit(AI_SECURITY_PROFILE_DIRTY, &profile->flags);
+        return;
+    }
+    
+    llist_add(&profile->dirty_node, raw_cpu_ptr(ai_sec_mgr->dirty_profiles));
+}
+
+static int ai_security_alloc_dirty_lists(void)
+{
+    int cpu;
+    
+    ai_sec_mgr->dirty_profiles = alloc_percpu(struct llist_head);
+    if (!ai_sec_mgr->dirty_profiles)
+        return -ENOMEM;
+    
+    for_each_possible_cpu(cpu)
+        init_llist_head(per_cpu_ptr(ai_sec_mgr->dirty_profiles, cpu));
+    
+    return 0;
+}
+
+/* Drop the queued references; the reaper frees what they kept alive */
+static void ai_security_free_dirty_lists(void)
+{
+    struct ai_security_profile *profile, *tmp;
+    struct llist_node *list;
+    int cpu;
+    
+    for_each_possible_cpu(cpu) {
+        list = llist_del_all(per_cpu_ptr(ai_sec_mgr->dirty_profiles, cpu));
+        llist_for_each_entry_safe(profile, tmp, list, dirty_node) {
+            if (refcount_dec_and_test(&profile->ref))
+                llist_add(&profile->free_node, &ai_sec_mgr->dead_profiles);
+        }
+    }
+    
+    free_percpu(ai_sec_mgr->dirty_profiles);
+    ai_sec_mgr->dirty_profiles = NULL;
+}
+
+static int ai_security_create_profile(struct task_struct *task)
+{
+    struct ai_security_profile *profile;
+    unsigned long flags;
+    
+    if (!ai_sec_mgr || !task)
+        return -EINVAL;
+    
+    /* Check if profile already exists; one left by an exited task is retired */
+    profile = ai_security_get_profile(task->pid);
+    if (profile) {
+        if (profile->start_time == task->start_time) {
+            ai_security_put_profile(profile);
+            return 0;
+        }
+        ai_security_retire_profile(profile);
+        ai_security_put_profile(profile);
+    }
+    
+    /* Allocate new profile */
+    profile = kmem_cache_zalloc(ai_sec_mgr->profile_cache, GFP_KERNEL);
+    if (!profile)
+        return -ENOMEM;
+    
+    /* Initialize profile */
+    profile->pid = task->pid;
+    profile->start_time = task->start_time;
+    strncpy(profile->comm, task->comm, TASK_COMM_LEN - 1);
+    profile->comm[TASK_COMM_LEN - 1] = '\0';
+    
+    /* Shared task features; the profile still works without them */
+    profile->features = aurora_task_features_get(task, GFP_KERNEL);
+    
+    /* Get executable path and hash */
+    profile->exe = ai_security_get_executable_path(task);
+    if (profile->exe)
+        profile->executable_hash = profile->exe->hash;
+    
+    /* Initialize security metrics */
+    profile->threat_score = 0;
+    profile->current_threat = AI_SECURITY_THREAT_NONE;
+    profile->behavior_score = AI_SECURITY_SCORE(80);  /* Start with moderate trust */
+    profile->risk_score = AI_SECURITY_SCORE(20);
+    profile->trust_score = AI_SECURITY_SCORE(70);
+    
+    /* Initialize timing */
+    profile->creation_time = ai_security_get_current_time();
+    profile->last_activity = profile->creation_time;
+    ai_security_seed_profile(profile);
+    
+    /* Initialize lists and lock */
+    INIT_LIST_HEAD(&profile->list);
+    spin_lock_init(&profile->lock);
+    refcount_set(&profile->ref, 1);
+    
+    /* Add to global list and hash table, making room within the budget */
+    spin_lock_irqsave(&ai_sec_mgr->profiles_lock, flags);
+    if (ai_sec_mgr->processes_monitored >= AI_SECURITY_MAX_PROCESSES)
+        ai_security_evict_profile();
+    list_add_tail_rcu(&profile->list, &ai_sec_mgr->process_profiles);
+    ai_sec_mgr->processes_monitored++;
+    spin_unlock_irqrestore(&ai_sec_mgr->profiles_lock, flags);
+    
+    ai_security_profile_add_to_hash(profile);
+    
+    /* New profiles start below full trust */
+    ai_security_mark_dirty(profile);
+    
+    if (ai_security_debug_enabled)
+        pr_info("AI Security: Created profile for PID %d (%s)\n", profile->pid, profile->comm);
+    
+    return 0;
+}
+
+/* Event Management */
+
+/*
+ * Initialize an event in caller-provided storage. Scratch events on the
+ * stack get no id; one is assigned if the event is retained.
+ */
+static void ai_security_init_event(struct ai_security_event *event, enum ai_security_event_type type)
+{
+    memset(event, 0, sizeof(*event));
+    
+    event->type = type;
+    event->timestamp = ai_security_get_current_time();
+    event->threat_level = AI_SECURITY_THREAT_NONE;
+    event->threat_score = 0;
+    event->recommended_action = AI_SECURITY_ACTION_ALLOW;
+    event->confidence = 50;  /* Default confidence */
+    event->false_positive_flag = false;
+    event->escalated = false;
+    
+    /* Initialize lists */
+    INIT_LIST_HEAD(&event->related_events);
+    INIT_LIST_HEAD(&event->list);
+    INIT_HLIST_NODE(&event->hash);
+}
+
+static int ai_security_create_event(struct ai_security_event **event, enum ai_security_event_type type)
+{
+    struct ai_security_event *new_event;
+    
+    new_event = kmem_cache_alloc(ai_sec_mgr->event_cache, GFP_KERNEL);
+    if (!new_event)
+        return -ENOMEM;
+    
+    ai_security_init_event(new_event, type);
+    new_event->event_id = atomic64_inc_return(&event_id_counter);
+    
+    *event = new_event;
+    return 0;
+}
+
+/*
+ * Point event_data at a private copy of @data: the inline buffer when it
+ * fits, otherwise an allocation.
+ */
+static void ai_security_set_event_data(struct ai_security_event *event,
+                                       const void *data, size_t size)
+{
+    if (size <= AI_SECURITY_DATA_LEN) {
+        memcpy(event->data, data, size);
+        event->event_data = event->data;
+    } else {
+        event->event_data = kmemdup(data, size, GFP_KERNEL);
+    }
+    event->data_size = event->event_data ? size : 0;
+}
+
+/*
+ * Copy a scratch event worth keeping to the event cache. The scratch
+ * event's event_data is borrowed, so it is duplicated here, and the
+ * description that the fast path skipped is formatted now.
+ */
+static struct ai_security_event *ai_security_retain_event(const struct ai_security_event *scratch)
+{
+    struct ai_security_event *event;
+    
+    event = kmem_cache_alloc(ai_sec_mgr->event_cache, GFP_KERNEL);
+    if (!event)
+        return NULL;
+    
+    memcpy(event, scratch, sizeof(*scratch));
+    INIT_LIST_HEAD(&event->related_events);
+    INIT_LIST_HEAD(&event->list);
+    INIT_HLIST_NODE(&event->hash);
+    event->event_id = atomic64_inc_return(&event_id_counter);
+    event->event_data = NULL;
+    event->data_size = 0;
+    
+    if (scratch->event_data)
+        ai_security_set_event_data(event, scratch->event_data, scratch->data_size);
+    
+    if (!event->description[0] && event->type == AI_SECURITY_EVENT_FILE_ACCESS &&
+        event->event_data)
+        snprintf(event->description, AI_SECURITY_DESC_LEN, "File access: %s",
+                 (char *)event->event_data);
+    else if (!event->description[0] && event->type == AI_SECURITY_EVENT_NETWORK_CONNECT &&
+             event->event_data)
+        snprintf(event->description, AI_SECURITY_DESC_LEN, "Network connect: %pI6c",
+                 event->event_data);
+    
+    return event;
+}
+
+/*
+ * Deep tier. Records queued by the hooks are scored here in batches, off
+ * the syscall path; this is where profile trust, risk and the anomaly
+ * history are updated.
+ */
+static void ai_security_deep_analyze(const struct ai_security_deep_record *rec)
+{
+    struct ai_security_profile *profile;
+    unsigned long flags;
+    
+    profile = ai_security_profile_lookup(rec->pid);
+    if (!profile)
+        return;
+    
+    spin_lock_irqsave(&profile->lock, flags);
+    
+    /* Update profile statistics */
+    profile->event_count++;
+    profile->last_activity = ai_security_get_current_time();
+    if (rec->type == AI_SECURITY_EVENT_PRIVILEGE_ESCALATION)
+        profile->privilege_escalation_count++;
+    
+    /* Update profile metrics */
+    profile->threat_score = max_t(u32, profile->threat_score, rec->threat_score);
+    profile->current_threat = max_t(enum ai_security_threat_level, profile->current_threat,
+                                     rec->threat_level);
+    
+    if (rec->threat_score > 30) {
+        profile->anomaly_count++;
+    }
+    
+    /* Update ML scores */
+    profile->risk_score = min(AI_SECURITY_SCORE_ONE, profile->risk_score +
+                              rec->threat_score * AI_SECURITY_SCORE_ONE / 1000);
+    profile->trust_score -= min(profile->trust_score,
+                                rec->threat_score * AI_SECURITY_SCORE_ONE / 500);
+    profile->behavior_score -= min(profile->behavior_score,
+                                   rec->threat_score * AI_SECURITY_SCORE_ONE / 200);
+    
+    /* Any nonzero score moved trust and risk; drop cached verdicts */
+    if (rec->threat_score)
+        WRITE_ONCE(profile->policy_gen, profile->policy_gen + 1);
+    
+    spin_unlock_irqrestore(&profile->lock, flags);
+    
+    ai_security_mark_dirty(profile);
+}
+
+/*
+ * Consume one CPU's deep-analysis records, AI_SECURITY_DEEP_BATCH at a
+ * time. Returns true if the ring was seen non-empty after catching up.
+ */
+static bool ai_security_drain_deep_ring(struct ai_security_deep_ring *ring)
+{
+    unsigned int head, tail, end, done = 0;
+    
+    head = smp_load_acquire(&ring->head);
+    tail = ring->tail;
+    
+    while (tail != head) {
+        end = head - tail > AI_SECURITY_DEEP_BATCH ? tail + AI_SECURITY_DEEP_BATCH : head;
+        
+        rcu_read_lock();
+        for (; tail != end; tail++, done++)
+            ai_security_deep_analyze(&ring->records[tail & (AI_SECURITY_DEEP_RING_SIZE - 1)]);
+        rcu_read_unlock();
+        
+        /* Hand the slots back to the hooks */
+        smp_store_release(&ring->tail, tail);
+        cond_resched();
+    }
+    
+    if (done)
+        this_cpu_add(ai_sec_mgr->stats->count[AI_SECURITY_STAT_DEEP_ANALYSED], done);
+    
+    /* Pairs with the barrier in ai_security_queue_deep() */
+    smp_mb();
+    return READ_ONCE(ring->head) != tail;
+}
+
+static void ai_security_deep_work(struct work_struct *work)
+{
+    bool again;
+    int cpu;
+    
+    do {
+        again = false;
+        for_each_possible_cpu(cpu)
+            again |= ai_security_drain_deep_ring(per_cpu_ptr(ai_sec_mgr->deep_rings, cpu));
+    } while (again);
+}
+
+/*
+ * Leave a fast-tier result for the deep worker. The worker is kicked
+ * only when the ring was empty, i.e. when it may have gone idle.
+ */
+static void ai_security_queue_deep(const struct ai_security_event *event)
+{
+    struct ai_security_deep_ring *ring;
+    struct ai_security_deep_record *rec;
+    unsigned int head;
+    bool kick;
+    
+    ring = get_cpu_ptr(ai_sec_mgr->deep_rings);
+    head = ring->head;
+    if (unlikely(head - smp_load_acquire(&ring->tail) >= AI_SECURITY_DEEP_RING_SIZE)) {
+        put_cpu_ptr(ai_sec_mgr->deep_rings);
+        ai_security_stat_inc(AI_SECURITY_STAT_DEEP_DROPPED);
+        return;
+    }
+    
+    rec = &ring->records[head & (AI_SECURITY_DEEP_RING_SIZE - 1)];
+    rec->pid = event->pid;
+    rec->type = event->type;
+    rec->threat_level = event->threat_level;
+    rec->threat_score = event->threat_score;
+    smp_store_release(&ring->head, head + 1);
+    
+    /* Pairs with the barrier in ai_security_drain_deep_ring() */
+    smp_mb();
+    kick = READ_ONCE(ring->tail) == head;
+    put_cpu_ptr(ai_sec_mgr->deep_rings);
+    
+    if (kick)
+        queue_work(ai_sec_mgr->deep_wq, &ai_sec_mgr->deep_work);
+}
+
+static void ai_security_free_deep_rings(void)
+{
+    int cpu;
+    
+    if (!ai_sec_mgr->deep_rings)
+        return;
+    
+    for_each_possible_cpu(cpu)
+        kvfree(per_cpu_ptr(ai_sec_mgr->deep_rings, cpu)->records);
+    free_percpu(ai_sec_mgr->deep_rings);
+    ai_sec_mgr->deep_rings = NULL;
+}
+
+static int ai_security_alloc_deep_rings(void)
+{
+    struct ai_security_deep_ring *ring;
+    int cpu;
+    
+    ai_sec_mgr->deep_rings = alloc_percpu(struct ai_security_deep_ring);
+    if (!ai_sec_mgr->deep_rings)
+        return -ENOMEM;
+    
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(ai_sec_mgr->deep_rings, cpu);
+        ring->records = kvzalloc_node(AI_SECURITY_DEEP_RING_SIZE * sizeof(*ring->records),
+                                      GFP_KERNEL, cpu_to_node(cpu));
+        if (!ring->records) {
+            ai_security_free_deep_rings();
+            return -ENOMEM;
+        }
+    }
+    
+    return 0;
+}
+
+/* Pattern Matching */
+
+/* Built-in rules; threat intelligence patterns are added to these */
+static const struct ai_security_pattern ai_security_builtin_patterns[] = {
+    { "sensitive",  AI_SECURITY_MATCH_SENSITIVE },
+    { "/tmp/",      AI_SECURITY_MATCH_TEMP_EXEC },
+    { "/var/tmp/",  AI_SECURITY_MATCH_TEMP_EXEC },
+};
+
+static void ai_security_matcher_free(struct ai_security_matcher *m)
+{
+    if (!m)
+        return;
+    
+    kvfree(m->next);
+    kvfree(m->out);
+    kfree(m);
+}
+
+/*
+ * Build the trie, then fill in the failure transitions breadth first so
+ * that every (state, class) pair has a direct successor.
+ */
+static struct ai_security_matcher *ai_security_matcher_build(const struct ai_security_pattern *pats,
+                                                             unsigned int nr)
+{
+    struct ai_security_matcher *m;
+    u32 max_states = 1, *fail = NULL, *queue = NULL;
+    u32 head = 0, tail = 0, s, u, c;
+    unsigned int i;
+    const u8 *p;
+    
+    m = kzalloc(sizeof(*m), GFP_KERNEL);
+    if (!m)
+        return NULL;
+    
+    /* Alphabet compression: one class per byte used by any pattern */
+    m->nr_classes = 1;
+    for (i = 0; i < nr; i++) {
+        for (p = (const u8 *)pats[i].str; *p; p++, max_states++) {
+            if (!m->byte_class[*p])
+                m->byte_class[*p] = m->nr_classes++;
+        }
+    }
+    
+    m->next = kvcalloc(array_size(max_states, m->nr_classes), sizeof(*m->next), GFP_KERNEL);
+    m->out = kvzalloc(max_states, GFP_KERNEL);
+    fail = kvmalloc_array(max_states, sizeof(*fail), GFP_KERNEL);
+    queue = kvmalloc_array(max_states, sizeof(*queue), GFP_KERNEL);
+    if (!m->next || !m->out || !fail || !queue)
+        goto err;
+    
+    /* Trie; state 0 is the root and is never a child, so 0 means none */
+    m->nr_states = 1;
+    for (i = 0; i < nr; i++) {
+        s = 0;
+        for (p = (const u8 *)pats[i].str; *p; p++) {
+            u32 *slot = &m->next[s * m->nr_classes + m->byte_class[*p]];
+            
+            if (!*slot)
+                *slot = m->nr_states++;
+            s = *slot;
+        }
+        if (s) {
+            m->out[s] |= BIT(pats[i].class);
+            m->nr_patterns++;
+        }
+    }
+    
+    /* Root transitions that are missing stay at the root */
+    for (c = 0; c < m->nr_classes; c++) {
+        u = m->next[c];
+        if (u) {
+            fail[u] = 0;
+            queue[tail++] = u;
+        }
+    }
+    
+    while (head != tail) {
+        s = queue[head++];
+        for (c = 0; c < m->nr_classes; c++) {
+            u32 *slot = &m->next[s * m->nr_classes + c];
+            u32 via_fail = m->next[fail[s] * m->nr_classes + c];
+            
+            if (*slot) {
+                u = *slot;
+                fail[u] = via_fail;
+                m->out[u] |= m->out[via_fail];
+                queue[tail++] = u;
+            } else {
+                *slot = via_fail;
+            }
+        }
+    }
+    
+    kvfree(queue);
+    kvfree(fail);
+    return m;
+    
+err:
+    kvfree(queue);
+    kvfree(fail);
+    ai_security_matcher_free(m);
+    return NULL;
+}
+
+/* One pass over @s; returns the mask of every pattern class found */
+static unsigned int ai_security_match(const struct ai_security_matcher *m, const char *s)
+{
+    const u8 *p = (const u8 *)s;
+    unsigned int mask = 0;
+    u32 state = 0;
+    
+    for (; *p; p++) {
+        state = m->next[state * m->nr_classes + m->byte_class[*p]];
+        mask |= m->out[state];
+    }
+    
+    return mask;
+}
+
+static unsigned int ai_security_match_string(const char *s)
+{
+    const struct ai_security_intel *intel;
+    unsigned int mask = 0;
+    
+    if (!s)
+        return 0;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    if (intel)
+        mask = ai_security_match(intel->matcher, s);
+    rcu_read_unlock();
+    
+    return mask;
+}
+
+static const char * const ai_security_system_dirs[] = {
+    "/bin/", "/sbin/", "/lib/", "/usr/bin/", "/usr/sbin/", "/usr/lib/",
+};
+
+static u8 ai_security_label_match(unsigned int match)
+{
+    u8 label = AI_SECURITY_LABEL_VALID;
+    
+    if (match & BIT(AI_SECURITY_MATCH_SENSITIVE))
+        label |= AI_SECURITY_LABEL_SENSITIVE;
+    if (match & BIT(AI_SECURITY_MATCH_TEMP_EXEC))
+        label |= AI_SECURITY_LABEL_TEMP;
+    if (match & (BIT(AI_SECURITY_MATCH_INTEL_PATH) | BIT(AI_SECURITY_MATCH_INTEL_COMMAND)))
+        label |= AI_SECURITY_LABEL_INTEL;
+    
+    return label;
+}
+
+/*
+ * Label a full path against the published intelligence. @gen gets the
+ * generation the label was computed from; a label is stale once the
+ * generation moves.
+ */
+static u8 ai_security_label_path(const char *path, u32 *gen)
+{
+    const struct ai_security_intel *intel;
+    unsigned int match = 0;
+    u8 label;
+    int i;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    *gen = intel ? intel->generation : 0;
+    if (intel)
+        match = ai_security_match(intel->matcher, path);
+    rcu_read_unlock();
+    
+    label = ai_security_label_match(match);
+    for (i = 0; i < ARRAY_SIZE(ai_security_system_dirs); i++) {
+        if (str_has_prefix(path, ai_security_system_dirs[i])) {
+            label |= AI_SECURITY_LABEL_SYSTEM_BIN;
+            break;
+        }
+    }
+    
+    return label;
+}
+
+static u32 ai_security_intel_gen(void)
+{
+    const struct ai_security_intel *intel;
+    u32 gen;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    gen = intel ? intel->generation : 0;
+    rcu_read_unlock();
+    
+    return gen;
+}
+
+/* Compile the built-in rules plus the feed's paths and commands */
+static struct ai_security_matcher *ai_security_build_matcher(const struct ai_threat_intelligence *ti)
+{
+    struct ai_security_matcher *m;
+    struct ai_security_pattern *pats;
+    unsigned int nr = 0, i;
+    
+    pats = kvmalloc_array(ARRAY_SIZE(ai_security_builtin_patterns) +
+                          ti->suspicious_path_count + ti->suspicious_command_count,
+                          sizeof(*pats), GFP_KERNEL);
+    if (!pats)
+        return NULL;
+    
+    for (i = 0; i < ARRAY_SIZE(ai_security_builtin_patterns); i++)
+        pats[nr++] = ai_security_builtin_patterns[i];
+    for (i = 0; i < ti->suspicious_path_count; i++)
+        pats[nr++] = (struct ai_security_pattern){ ti->suspicious_paths[i],
+                                                   AI_SECURITY_MATCH_INTEL_PATH };
+    for (i = 0; i < ti->suspicious_command_count; i++)
+        pats[nr++] = (struct ai_security_pattern){ ti->suspicious_commands[i],
+                                                   AI_SECURITY_MATCH_INTEL_COMMAND };
+    
+    m = ai_security_matcher_build(pats, nr);
+    kvfree(pats);
+    
+    return m;
+}
+
+/* Threat Intelligence Sets */
+
+static void ai_security_ioc_free(struct ai_security_ioc_set *set)
+{
+    if (!set)
+        return;
+    
+    kvfree(set->blocks);
+    kvfree(set->keys);
+    kfree(set);
+}
+
+/*
+ * Keys are u32 multiples, so jhash2 is used as in the BPF bloom filter
+ * map. The first hash picks the block, the second drives the probes.
+ */
+static inline void ai_security_ioc_hash(const struct ai_security_ioc_set *set, const u32 *key,
+                                        u32 *block, u32 *h2)
+{
+    u32 h1 = jhash2(key, set->key_words, set->hash_seed);
+    
+    *block = h1 & set->block_mask;
+    *h2 = jhash2(key, set->key_words, h1) | 1;
+}
+
+static inline u32 ai_security_ioc_bit(u32 h2, unsigned int i)
+{
+    return (h2 * (i + 1) + (h2 >> 23) * i) & 511;
+}
+
+static int ai_security_ioc_cmp(const void *a, const void *b, const void *priv)
+{
+    return memcmp(a, b, *(const size_t *)priv);
+}
+
+/* Build a set over @nr keys of @key_words u32s each; @keys is consumed */
+static struct ai_security_ioc_set *ai_security_ioc_build(u32 *keys, u32 nr, u32 key_words)
+{
+    struct ai_security_ioc_set *set;
+    u32 i, j, block, h2, nr_blocks;
+    size_t key_size = key_words * sizeof(u32);
+    
+    set = kzalloc(sizeof(*set), GFP_KERNEL);
+    if (!set) {
+        kvfree(keys);
+        return NULL;
+    }
+    
+    nr_blocks = roundup_pow_of_two(max_t(u32, 1, DIV_ROUND_UP(nr * AI_SECURITY_BLOOM_BITS_PER_KEY, 512)));
+    set->blocks = kvcalloc(nr_blocks, sizeof(*set->blocks), GFP_KERNEL);
+    if (!set->blocks) {
+        kvfree(keys);
+        kfree(set);
+        return NULL;
+    }
+    
+    set->nr = nr;
+    set->key_words = key_words;
+    set->block_mask = nr_blocks - 1;
+    set->hash_seed = get_random_u32();
+    set->keys = keys;
+    
+    for (i = 0; i < nr; i++) {
+        ai_security_ioc_hash(set, &keys[i * key_words], &block, &h2);
+        for (j = 0; j < AI_SECURITY_BLOOM_HASHES; j++)
+            __set_bit(ai_security_ioc_bit(h2, j), (unsigned long *)set->blocks[block]);
+    }
+    
+    sort_r(keys, nr, key_size, ai_security_ioc_cmp, NULL, &key_size);
+    
+    return set;
+}
+
+static bool ai_security_ioc_contains(const struct ai_security_ioc_set *set, const u32 *key)
+{
+    size_t key_size = set->key_words * sizeof(u32);
+    u32 block, h2, i;
+    const u32 *k;
+    
+    if (!set->nr)
+        return false;
+    
+    ai_security_ioc_hash(set, key, &block, &h2);
+    for (i = 0; i < AI_SECURITY_BLOOM_HASHES; i++) {
+        if (!test_bit(ai_security_ioc_bit(h2, i), (unsigned long *)set->blocks[block]))
+            return false;
+    }
+    
+    /* Possible hit: confirm against the table */
+    for (k = set->keys, i = set->nr; i; ) {
+        const u32 *mid = k + (i / 2) * set->key_words;
+        int cmp = memcmp(key, mid, key_size);
+        
+        if (!cmp)
+            return true;
+        if (cmp > 0) {
+            k = mid + set->key_words;
+            i -= i / 2 + 1;
+        } else {
+            i /= 2;
+        }
+    }
+    
+    return false;
+}
+
+bool ai_security_is_malware_hash(u32 hash)
+{
+    const struct ai_security_intel *intel;
+    bool found = false;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    if (intel)
+        found = ai_security_ioc_contains(intel->malware_set, &hash);
+    rcu_read_unlock();
+    
+    return found;
+}
+
+bool ai_security_is_malicious_ip(const struct in6_addr *addr)
+{
+    const struct ai_security_intel *intel;
+    bool found = false;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    if (intel)
+        found = ai_security_ioc_contains(intel->ip_set, addr->s6_addr32);
+    rcu_read_unlock();
+    
+    return found;
+}
+
+static inline void ai_security_v4_mapped(struct in6_addr *addr, __be32 v4)
+{
+    addr->s6_addr32[0] = 0;
+    addr->s6_addr32[1] = 0;
+    addr->s6_addr32[2] = htonl(0xffff);
+    addr->s6_addr32[3] = v4;
+}
+
+static inline bool ai_security_is_v4_mapped(const struct in6_addr *addr)
+{
+    return !addr->s6_addr32[0] && !addr->s6_addr32[1] &&
+           addr->s6_addr32[2] == htonl(0xffff);
+}
+
+/* Parse an IPv4 or IPv6 address; IPv4 is stored v4-mapped */
+static bool ai_security_parse_ip(const char *str, struct in6_addr *addr)
+{
+    __be32 v4;
+    
+    if (in4_pton(str, -1, (u8 *)&v4, -1, NULL)) {
+        ai_security_v4_mapped(addr, v4);
+        return true;
+    }
+    
+    return in6_pton(str, -1, addr->s6_addr, -1, NULL);
+}
+
+/* Build both IOC sets of @intel from the feed */
+static int ai_security_build_ioc_sets(const struct ai_threat_intelligence *ti,
+                                      struct ai_security_intel *intel)
+{
+    struct in6_addr *ips;
+    u32 *hashes, i, nr = 0;
+    
+    hashes = kvmalloc_array(max_t(u32, 1, ti->malware_count), sizeof(u32), GFP_KERNEL);
+    if (!hashes)
+        return -ENOMEM;
+    if (ti->malware_count)
+        memcpy(hashes, ti->malware_hashes, ti->malware_count * sizeof(u32));
+    
+    intel->malware_set = ai_security_ioc_build(hashes, ti->malware_count, 1);
+    if (!intel->malware_set)
+        return -ENOMEM;
+    
+    ips = kvmalloc_array(max_t(u32, 1, ti->malicious_ip_count), sizeof(*ips), GFP_KERNEL);
+    if (!ips)
+        return -ENOMEM;
+    for (i = 0; i < ti->malicious_ip_count; i++) {
+        if (ai_security_parse_ip(ti->malicious_ips[i], &ips[nr]))
+            nr++;
+        else
+            pr_warn("AI Security: Ignoring malformed IP \"%s\"\n", ti->malicious_ips[i]);
+    }
+    
+    intel->ip_set = ai_security_ioc_build(ips->s6_addr32, nr, sizeof(*ips) / sizeof(u32));
+    if (!intel->ip_set)
+        return -ENOMEM;
+    
+    return 0;
+}
+
+/* Threat Intelligence Generations */
+
+static void ai_security_intel_free(struct ai_security_intel *intel)
+{
+    if (!intel)
+        return;
+    
+    ai_security_matcher_free(intel->matcher);
+    ai_security_ioc_free(intel->malware_set);
+    ai_security_ioc_free(intel->ip_set);
+    kfree(intel);
+}
+
+static void ai_security_intel_free_rcu(struct rcu_head *head)
+{
+    ai_security_intel_free(container_of(head, struct ai_security_intel, rcu));
+}
+
+/*
+ * Compile the staging feed into a new generation and publish it. Hooks
+ * keep using the old generation until the pointer swap and are never
+ * blocked; a failed build leaves the old one in place. Called with
+ * intel_lock held.
+ */
+static int ai_security_intel_commit(void)
+{
+    struct ai_threat_intelligence *ti = &ai_sec_mgr->threat_intel;
+    struct ai_security_intel *intel, *old;
+    int ret;
+    
+    lockdep_assert_held(&ai_sec_mgr->intel_lock);
+    
+    intel = kzalloc(sizeof(*intel), GFP_KERNEL);
+    if (!intel)
+        return -ENOMEM;
+    
+    intel->matcher = ai_security_build_matcher(ti);
+    if (!intel->matcher) {
+        ai_security_intel_free(intel);
+        return -ENOMEM;
+    }
+    
+    ret = ai_security_build_ioc_sets(ti, intel);
+    if (ret) {
+        ai_security_intel_free(intel);
+        return ret;
+    }
+    
+    old = rcu_dereference_protected(ai_sec_mgr->intel, lockdep_is_held(&ai_sec_mgr->intel_lock));
+    intel->generation = old ? old->generation + 1 : 1;
+    intel->published = ai_security_get_current_time();
+    ti->last_update = intel->published;
+    
+    rcu_assign_pointer(ai_sec_mgr->intel, intel);
+    atomic_inc(&ai_security_policy_gen);
+    if (old)
+        call_rcu(&old->rcu, ai_security_intel_free_rcu);
+    
+    if (ai_security_debug_enabled)
+        pr_info("AI Security: Threat intelligence generation %llu: %u patterns, "
+                "%u hashes, %u IPs\n", intel->generation, intel->matcher->nr_patterns,
+                intel->malware_set->nr, intel->ip_set->nr);
+    
+    return 0;
+}
+
+/* Grow a staging array to hold one more element */
+static int ai_security_feed_reserve(void **array, u32 *capacity, u32 count, size_t size)
+{
+    u32 new_capacity;
+    void *p;
+    
+    if (count < *capacity)
+        return 0;
+    
+    new_capacity = max_t(u32, 64, *capacity * 2);
+    p = kvrealloc(*array, *capacity * size, new_capacity * size, GFP_KERNEL);
+    if (!p)
+        return -ENOMEM;
+    
+    *array = p;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static int ai_security_feed_add_string(char ***array, u32 *count, u32 *capacity, const char *str)
+{
+    char *dup;
+    int ret;
+    
+    ret = ai_security_feed_reserve((void **)array, capacity, *count, sizeof(char *));
+    if (ret)
+        return ret;
+    
+    dup = kstrdup(str, GFP_KERNEL);
+    if (!dup)
+        return -ENOMEM;
+    
+    (*array)[(*count)++] = dup;
+    return 0;
+}
+
+static void ai_security_feed_free_strings(char **array, u32 count)
+{
+    u32 i;
+    
+    for (i = 0; i < count; i++)
+        kfree(array[i]);
+    kvfree(array);
+}
+
+/* Empty the staging feed; the published generation is unaffected */
+static void ai_security_feed_reset(struct ai_threat_intelligence *ti)
+{
+    kvfree(ti->malware_hashes);
+    ai_security_feed_free_strings(ti->suspicious_paths, ti->suspicious_path_count);
+    ai_security_feed_free_strings(ti->malicious_ips, ti->malicious_ip_count);
+    ai_security_feed_free_strings(ti->suspicious_commands, ti->suspicious_command_count);
+    
+    ti->malware_hashes = NULL;
+    ti->malware_count = ti->malware_capacity = 0;
+    ti->suspicious_paths = NULL;
+    ti->suspicious_path_count = ti->suspicious_path_capacity = 0;
+    ti->malicious_ips = NULL;
+    ti->malicious_ip_count = ti->malicious_ip_capacity = 0;
+    ti->suspicious_commands = NULL;
+    ti->suspicious_command_count = ti->suspicious_command_capacity = 0;
+}
+
+/*
+ * Apply one feed line: "hash <hex>", "ip <addr>", "path <pattern>",
+ * "command <pattern>", "reset" or "commit". Called with intel_lock held.
+ */
+static int ai_security_feed_line(char *line)
+{
+    struct ai_threat_intelligence *ti = &ai_sec_mgr->threat_intel;
+    char *arg;
+    u32 hash;
+    int ret;
+    
+    line = strim(line);
+    if (!*line || *line == '#')
+        return 0;
+    
+    if (!strcmp(line, "commit"))
+        return ai_security_intel_commit();
+    if (!strcmp(line, "reset")) {
+        ai_security_feed_reset(ti);
+        return 0;
+    }
+    
+    arg = strchr(line, ' ');
+    if (!arg)
+        return -EINVAL;
+    *arg++ = '\0';
+    arg = skip_spaces(arg);
+    if (!*arg)
+        return -EINVAL;
+    
+    if (!strcmp(line, "hash")) {
+        if (kstrtou32(arg, 16, &hash))
+            return -EINVAL;
+        ret = ai_security_feed_reserve((void **)&ti->malware_hashes, &ti->malware_capacity,
+                                       ti->malware_count, sizeof(u32));
+        if (!ret)
+            ti->malware_hashes[ti->malware_count++] = hash;
+        return ret;
+    }
+    if (!strcmp(line, "ip"))
+        return ai_security_feed_add_string(&ti->malicious_ips, &ti->malicious_ip_count,
+                                           &ti->malicious_ip_capacity, arg);
+    if (!strcmp(line, "path"))
+        return ai_security_feed_add_string(&ti->suspicious_paths, &ti->suspicious_path_count,
+                                           &ti->suspicious_path_capacity, arg);
+    if (!strcmp(line, "command"))
+        return ai_security_feed_add_string(&ti->suspicious_commands,
+                                           &ti->suspicious_command_count,
+                                           &ti->suspicious_command_capacity, arg);
+    
+    return -EINVAL;
+}
+
+/* Network Connect Policy */
+
+static inline int ai_security_lpm_bit(const struct in6_addr *addr, u32 index)
+{
+    return !!(addr->s6_addr[index / 8] & (1 << (7 - (index % 8))));
+}
+
+/* Number of leading bits @node shares with @addr, capped at both prefixes */
+static u32 ai_security_lpm_match(const struct ai_security_lpm_node *node,
+                                 const struct in6_addr *addr, u32 prefixlen)
+{
+    u32 limit = min(node->prefixlen, prefixlen), len = 0;
+    int i;
+    
+    for (i = 0; i < 4; i++) {
+        u32 diff = ntohl(node->addr.s6_addr32[i] ^ addr->s6_addr32[i]);
+        
+        len += 32 - fls(diff);
+        if (len >= limit)
+            return limit;
+        if (diff)
+            return len;
+    }
+    
+    return len;
+}
+
+/* Longest-prefix action for @addr, or -1; under rcu_read_lock() */
+static int ai_security_net_lookup(const struct in6_addr *addr)
+{
+    struct ai_security_lpm_node *node, *found = NULL;
+    u32 len;
+    
+    for (node = rcu_dereference(ai_sec_mgr->net_root); node;) {
+        len = ai_security_lpm_match(node, addr, 128);
+        if (len == 128) {
+            found = node;
+            break;
+        }
+        
+        if (len < node->prefixlen)
+            break;
+        
+        if (!(node->flags & AI_SECURITY_LPM_FLAG_IM))
+            found = node;
+        
+        node = rcu_dereference(node->child[ai_security_lpm_bit(addr, node->prefixlen)]);
+    }
+    
+    return found ? found->action : -1;
+}
+
+static struct ai_security_lpm_node *ai_security_lpm_node_alloc(const struct in6_addr *addr,
+                                                               u32 prefixlen, u8 flags, u8 action)
+{
+    struct ai_security_lpm_node *node = kzalloc(sizeof(*node), GFP_KERNEL);
+    
+    if (node) {
+        node->addr = *addr;
+        node->prefixlen = prefixlen;
+        node->flags = flags;
+        node->action = action;
+    }
+    return node;
+}
+
+/* Insert or replace a rule; the trie_update_elem() algorithm */
+static int ai_security_net_insert(const struct in6_addr *prefix, u32 prefixlen, u8 action)
+{
+    struct ai_security_lpm_node *node, *new_node, *im_node;
+    struct ai_security_lpm_node __rcu **slot;
+    struct in6_addr addr = *prefix;
+    u32 len = 0, i;
+    
+    /* Clear host bits so rules print as written */
+    for (i = prefixlen; i < 128; i++)
+        addr.s6_addr[i / 8] &= ~(1 << (7 - (i % 8)));
+    
+    new_node = ai_security_lpm_node_alloc(&addr, prefixlen, 0, action);
+    im_node = kzalloc(sizeof(*im_node), GFP_KERNEL);
+    if (!new_node || !im_node) {
+        kfree(new_node);
+        kfree(im_node);
+        return -ENOMEM;
+    }
+    
+    mutex_lock(&ai_sec_mgr->net_lock);
+    
+    slot = &ai_sec_mgr->net_root;
+    while ((node = rcu_dereference_protected(*slot, lockdep_is_held(&ai_sec_mgr->net_lock)))) {
+        len = ai_security_lpm_match(node, &addr, prefixlen);
+        
+        if (node->prefixlen != len || node->prefixlen == prefixlen || node->prefixlen == 128)
+            break;
+        
+        slot = &node->child[ai_security_lpm_bit(&addr, node->prefixlen)];
+    }
+    
+    if (!node) {
+        /* Empty slot */
+        rcu_assign_pointer(*slot, new_node);
+        ai_sec_mgr->net_rules++;
+    } else if (node->prefixlen == len) {
+        /* Same prefix: replace it, keeping its children */
+        new_node->child[0] = node->child[0];
+        new_node->child[1] = node->child[1];
+        if (!(node->flags & AI_SECURITY_LPM_FLAG_IM))
+            ai_sec_mgr->net_rules--;
+        ai_sec_mgr->net_rules++;
+        rcu_assign_pointer(*slot, new_node);
+        kfree_rcu(node, rcu);
+    } else if (len == prefixlen) {
+        /* New rule covers @node: insert it as the parent */
+        rcu_assign_pointer(new_node->child[ai_security_lpm_bit(&node->addr, len)], node);
+        rcu_assign_pointer(*slot, new_node);
+        ai_sec_mgr->net_rules++;
+    } else {
+        /* Diverging prefixes: join them under an intermediate node */
+        im_node->addr = node->addr;
+        im_node->prefixlen = len;
+        im_node->flags = AI_SECURITY_LPM_FLAG_IM;
+        if (ai_security_lpm_bit(&addr, len)) {
+            rcu_assign_pointer(im_node->child[0], node);
+            rcu_assign_pointer(im_node->child[1], new_node);
+        } else {
+            rcu_assign_pointer(im_node->child[0], new_node);
+            rcu_assign_pointer(im_node->child[1], node);
+        }
+        rcu_assign_pointer(*slot, im_node);
+        im_node = NULL;
+        ai_sec_mgr->net_rules++;
+    }
+    
+    mutex_unlock(&ai_sec_mgr->net_lock);
+    
+    kfree(im_node);
+    return 0;
+}
+
+static void ai_security_lpm_free(struct ai_security_lpm_node *node)
+{
+    if (!node)
+        return;
+    
+    ai_security_lpm_free(rcu_dereference_protected(node->child[0], true));
+    ai_security_lpm_free(rcu_dereference_protected(node->child[1], true));
+    kfree(node);
+}
+
+/* Drop every rule; sleeps until no connect can still see them */
+static void ai_security_net_clear(void)
+{
+    struct ai_security_lpm_node *root;
+    
+    mutex_lock(&ai_sec_mgr->net_lock);
+    root = rcu_replace_pointer(ai_sec_mgr->net_root, NULL,
+                               lockdep_is_held(&ai_sec_mgr->net_lock));
+    ai_sec_mgr->net_rules = 0;
+    mutex_unlock(&ai_sec_mgr->net_lock);
+    
+    synchronize_rcu();
+    ai_security_lpm_free(root);
+}
+
+/* Baseline key: the IPv4 /24 or IPv6 /63, with the low bit telling them apart */
+static inline u64 ai_security_endpoint_key(const struct in6_addr *addr)
+{
+    if (ai_security_is_v4_mapped(addr))
+        return ((u64)(ntohl(addr->s6_addr32[3]) >> 8) << 1) | 1;
+    
+    return (((u64)ntohl(addr->s6_addr32[0]) << 32) | ntohl(addr->s6_addr32[1])) & ~1ULL;
+}
+
+static bool ai_security_baseline_has(struct ai_security_baseline *b, u64 key)
+{
+    unsigned int seq;
+    bool found;
+    u32 pos;
+    
+    do {
+        seq = read_seqcount_begin(&b->seq);
+        found = ai_security_endpoint_search(b->endpoints,
+                                            min_t(u32, READ_ONCE(b->nr_endpoints),
+                                                  AI_SECURITY_MAX_ENDPOINTS),
+                                            key, &pos);
+    } while (read_seqcount_retry(&b->seq, seq));
+    
+    return found;
+}
+
+/* Merge a CPU's learnt endpoints into their baselines; caller holds batch->lock */
+static void ai_security_baseline_flush_batch(struct ai_security_baseline_batch *batch)
+{
+    struct ai_security_baseline *b;
+    u32 i;
+    
+    for (i = 0; i < batch->nr; i++) {
+        b = &batch->entries[i].exe->baseline;
+        spin_lock(&b->lock);
+        write_seqcount_begin(&b->seq);
+        ai_security_endpoint_insert(b->endpoints, &b->nr_endpoints, batch->entries[i].key);
+        write_seqcount_end(&b->seq);
+        spin_unlock(&b->lock);
+        ai_security_put_path(batch->entries[i].exe);
+    }
+    batch->nr = 0;
+}
+
+static void ai_security_baseline_flush(void)
+{
+    struct ai_security_baseline_batch *batch;
+    int cpu;
+    
+    for_each_possible_cpu(cpu) {
+        batch = per_cpu_ptr(ai_sec_mgr->baseline_batches, cpu);
+        spin_lock(&batch->lock);
+        ai_security_baseline_flush_batch(batch);
+        spin_unlock(&batch->lock);
+    }
+}
+
+/*
+ * Queue @key for @exe's baseline. Processes of one binary tend to learn
+ * the same networks at once, so duplicates are dropped here and the
+ * shared baseline is only written when a batch fills or the learning
+ * worker runs.
+ */
+static void ai_security_baseline_learn(struct ai_security_path *exe, u64 key)
+{
+    struct ai_security_baseline_batch *batch;
+    u32 i;
+    
+    batch = raw_cpu_ptr(ai_sec_mgr->baseline_batches);
+    spin_lock(&batch->lock);
+    for (i = 0; i < batch->nr; i++) {
+        if (batch->entries[i].exe == exe && batch->entries[i].key == key)
+            goto out;
+    }
+    
+    if (batch->nr == AI_SECURITY_BASELINE_BATCH)
+        ai_security_baseline_flush_batch(batch);
+    
+    refcount_inc(&exe->ref);
+    batch->entries[batch->nr].exe = exe;
+    batch->entries[batch->nr].key = key;
+    batch->nr++;
+out:
+    spin_unlock(&batch->lock);
+}
+
+static int ai_security_alloc_baseline_batches(void)
+{
+    int cpu;
+    
+    ai_sec_mgr->baseline_batches = alloc_percpu(struct ai_security_baseline_batch);
+    if (!ai_sec_mgr->baseline_batches)
+        return -ENOMEM;
+    
+    for_each_possible_cpu(cpu)
+        spin_lock_init(&per_cpu_ptr(ai_sec_mgr->baseline_batches, cpu)->lock);
+    
+    return 0;
+}
+
+static void ai_security_free_baseline_batches(void)
+{
+    ai_security_baseline_flush();
+    free_percpu(ai_sec_mgr->baseline_batches);
+    ai_sec_mgr->baseline_batches = NULL;
+}
+
+/*
+ * Look @addr up in the executable's baseline, learning it while the
+ * baseline period lasts. Returns true for a network no process of the
+ * binary has used before, once the baseline is closed.
+ */
+static bool ai_security_endpoint_novel(struct ai_security_profile *profile,
+                                       const struct in6_addr *addr)
+{
+    struct ai_security_path *exe = profile->exe;
+    u64 key = ai_security_endpoint_key(addr);
+    
+    /* No executable, no baseline to leave */
+    if (!exe)
+        return false;
+    
+    if (ai_security_baseline_has(&exe->baseline, key))
+        return false;
+    
+    if (ktime_to_ms(ktime_sub(ai_security_get_current_time(), READ_ONCE(exe->baseline.started))) >=
+        AI_SECURITY_BASELINE_PERIOD)
+        return true;
+    
+    ai_security_baseline_learn(exe, key);
+    return false;
+}
+
+static bool ai_security_sockaddr_to_in6(const struct sockaddr *address, int addrlen,
+                                         struct in6_addr *addr)
+{
+    if (addrlen < (int)offsetofend(struct sockaddr, sa_family))
+        return false;
+    
+    switch (address->sa_family) {
+    case AF_INET:
+        if (addrlen < (int)sizeof(struct sockaddr_in))
+            return false;
+        ai_security_v4_mapped(addr, ((const struct sockaddr_in *)address)->sin_addr.s_addr);
+        return true;
+    case AF_INET6:
+        if (addrlen < SIN6_LEN_RFC2133)
+            return false;
+        *addr = ((const struct sockaddr_in6 *)address)->sin6_addr;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Score @points for @rule; the first AI_SECURITY_MAX_REASONS are kept */
+static inline void ai_security_add_reason(struct ai_security_event *event,
+                                          enum ai_security_reason rule, u32 points)
+{
+    event->threat_score += points;
+    if (event->nr_reasons < AI_SECURITY_MAX_REASONS) {
+        event->reasons[event->nr_reasons].rule = rule;
+        event->reasons[event->nr_reasons].points = min(points, 255U);
+        event->nr_reasons++;
+    }
+}
+
+/* Stream a verdict to the telemetry consumers, if there are any */
+static void ai_security_emit_verdict(const struct ai_security_event *event)
+{
+    struct aurora_telemetry_record *rec;
+    unsigned long flags;
+    u64 rules = 0;
+    int i;
+    
+    rec = aurora_telemetry_reserve(AURORA_TELEMETRY_SECURITY_VERDICT, event->pid, &flags);
+    if (!rec)
+        return;
+    
+    for (i = 0; i < event->nr_reasons; i++)
+        rules |= (u64)event->reasons[i].rule << (i * 8);
+    
+    rec->arg = event->type;
+    rec->data[0] = event->threat_score;
+    rec->data[1] = event->threat_level;
+    rec->data[2] = event->recommended_action;
+    rec->data[3] = event->confidence;
+    rec->data[4] = rules;
+    aurora_telemetry_commit(rec, flags);
+}
+
+/*
+ * Fast tier: static rules against an unlocked read of the profile. Runs
+ * inline in the hook and never writes the profile; the result is queued
+ * for the deep tier.
+ */
+static int ai_security_analyze_event(struct ai_security_event *event)
+{
+    struct ai_security_profile *profile;
+    unsigned int match;
+    u32 score;
+    u8 label;
+    
+    if (!event || !ai_sec_mgr)
+        return -EINVAL;
+    
+    /* Get process profile */
+    profile = ai_security_get_profile(event->pid);
+    if (!profile) {
+        /* This shouldn't happen in normal operation */
+        event->threat_level = AI_SECURITY_THREAT_LOW;
+        event->threat_score = 0;
+        event->nr_reasons = 0;
+        ai_security_add_reason(event, AI_SECURITY_REASON_NO_PROFILE, 25);
+        event->recommended_action = AI_SECURITY_ACTION_WARN;
+        return 0;
+    }
+    
+    /* Calculate threat score based on event type and profile */
+    switch (event->type) {
+    case AI_SECURITY_EVENT_FILE_ACCESS:
+        /* Check if file access is suspicious; unlabelled files go by name */
+        label = event->file_label;
+        if (!(label & AI_SECURITY_LABEL_VALID))
+            label = ai_security_label_match(ai_security_match_string(event->event_data));
+        if (label & AI_SECURITY_LABEL_SENSITIVE) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_SENSITIVE_PATH, 30);
+        }
+        if (label & AI_SECURITY_LABEL_INTEL) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_INTEL_PATH, 40);
+        }
+        break;
+        
+    case AI_SECURITY_EVENT_NETWORK_CONNECT:
+        /* Check network connections; event_data is the in6_addr */
+        if (READ_ONCE(profile->network_connection_count) > 100) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_EXCESSIVE_CONNECTS, 25);
+        }
+        if (event->event_data && ai_security_is_malicious_ip(event->event_data)) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_MALICIOUS_IP, 60);
+        }
+        break;
+        
+    case AI_SECURITY_EVENT_PRIVILEGE_ESCALATION:
+        /* Privilege escalation is inherently suspicious */
+        ai_security_add_reason(event, AI_SECURITY_REASON_PRIVILEGE_ESCALATION, 60);
+        break;
+        
+    case AI_SECURITY_EVENT_PROCESS_EXEC:
+        /* Check if executing suspicious executables */
+        match = ai_security_match_string(event->event_data);
+        if (match & BIT(AI_SECURITY_MATCH_TEMP_EXEC)) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_TEMP_EXEC, 40);
+        }
+        if (match & (BIT(AI_SECURITY_MATCH_INTEL_PATH) | BIT(AI_SECURITY_MATCH_INTEL_COMMAND))) {
+            ai_security_add_reason(event, AI_SECURITY_REASON_INTEL_EXEC, 50);
+        }
+        break;
+        
+    default:
+        break;
+    }
+    
+    /* Known malware binary; a bloom miss costs one cache line */
+    if (profile->executable_hash && ai_security_is_malware_hash(profile->executable_hash)) {
+        ai_security_add_reason(event, AI_SECURITY_REASON_MALWARE_HASH, 50);
+    }
+    
+    /* Apply profile-based adjustments */
+    if (READ_ONCE(profile->trust_score) < AI_SECURITY_SCORE(30)) {
+        ai_security_add_reason(event, AI_SECURITY_REASON_LOW_TRUST, 20);
+    }
+    
+    if (READ_ONCE(profile->anomaly_count) > 5) {
+        ai_security_add_reason(event, AI_SECURITY_REASON_ANOMALY_HISTORY, 15);
+    }
+    
+    /* Cap threat score */
+    event->threat_score = min(event->threat_score, 100U);
+    
+    /* Determine threat level */
+    event->threat_level = ai_security_classify_threat(event->threat_score);
+    
+    /* Calculate confidence */
+    event->confidence = (READ_ONCE(profile->behavior_score) * 100) >> AI_SECURITY_SCORE_SHIFT;
+    event->confidence = min(event->confidence, 100U);
+    
+    /* Determine recommended action */
+    score = event->threat_score;
+    if (score >= ai_security_threat_threshold) {
+        if (score >= 90) {
+            event->recommended_action = AI_SECURITY_ACTION_TERMINATE;
+        } else if (score >= 80) {
+            event->recommended_action = AI_SECURITY_ACTION_BLOCK;
+        } else {
+            event->recommended_action = AI_SECURITY_ACTION_QUARANTINE;
+        }
+    } else if (score >= 50) {
+        event->recommended_action = AI_SECURITY_ACTION_WARN;
+    } else {
+        event->recommended_action = AI_SECURITY_ACTION_ALLOW;
+    }
+    ai_security_put_profile(profile);
+    
+    ai_security_emit_verdict(event);
+    trace_aurora_security_verdict(event->pid, event->type, event->threat_score,
+                                  event->threat_level, event->recommended_action,
+                                  event->confidence);
+    
+    /* Profile updates happen in the deep tier */
+    ai_security_queue_deep(event);
+    
+    return 0;
+}
+
+static enum ai_security_threat_level ai_security_classify_threat(u32 score)
+{
+    if (score >= 90)
+        return AI_SECURITY_THREAT_CRITICAL;
+    else if (score >= 70)
+        return AI_SECURITY_THREAT_HIGH;
+    else if (score >= 50)
+        return AI_SECURITY_THREAT_MEDIUM;
+    else if (score >= 25)
+        return AI_SECURITY_THREAT_LOW;
+    else
+        return AI_SECURITY_THREAT_NONE;
+}
+
+static int ai_security_make_decision(struct ai_security_event *event)
+{
+    int decision = 0;  /* 0 = allow, 1 = deny */
+    
+    if (!event)
         return 0;
     
     /* Analyze the event first */
@@ -439,27 +2335,49 @@ static int ai_security_make_decision(struct ai_security_event *event)
     
     /* Log the decision */
     ai_security_log_threat(event);
+    ai_security_history_append(event, decision);
     
     /* Update statistics */
-    ai_sec_mgr->total_events_processed++;
+    ai_security_stat_inc(AI_SECURITY_STAT_EVENTS);
     if (event->threat_score > 30)
-        ai_sec_mgr->threats_detected++;
+        ai_security_stat_inc(AI_SECURITY_STAT_THREATS_DETECTED);
     
     if (decision && event->recommended_action != AI_SECURITY_ACTION_WARN) {
-        ai_sec_mgr->threats_blocked++;
+        ai_security_stat_inc(AI_SECURITY_STAT_THREATS_BLOCKED);
     }
     
     return decision;
 }
 
-static char *ai_security_explain_decision(struct ai_security_event *event)
+static const char * const ai_security_reason_names[AI_SECURITY_REASON_MAX] = {
+    [AI_SECURITY_REASON_NONE]                   = "none",
+    [AI_SECURITY_REASON_NO_PROFILE]             = "no profile",
+    [AI_SECURITY_REASON_SENSITIVE_PATH]         = "sensitive path",
+    [AI_SECURITY_REASON_INTEL_PATH]             = "known suspicious path",
+    [AI_SECURITY_REASON_EXCESSIVE_CONNECTS]     = "excessive connections",
+    [AI_SECURITY_REASON_MALICIOUS_IP]           = "known malicious endpoint",
+    [AI_SECURITY_REASON_PRIVILEGE_ESCALATION]   = "privilege escalation",
+    [AI_SECURITY_REASON_TEMP_EXEC]              = "executing from temp directory",
+    [AI_SECURITY_REASON_INTEL_EXEC]             = "known suspicious executable",
+    [AI_SECURITY_REASON_MALWARE_HASH]           = "known malware binary",
+    [AI_SECURITY_REASON_LOW_TRUST]              = "low trust process",
+    [AI_SECURITY_REASON_ANOMALY_HISTORY]        = "history of anomalies",
+    [AI_SECURITY_REASON_NET_WATCH]              = "watched network",
+    [AI_SECURITY_REASON_NET_NOVEL]              = "outside network baseline",
+    [AI_SECURITY_REASON_BPF_RULES]              = "BPF rules",
+};
+
+/*
+ * Render @event's explanation into @buf. Events only carry reason codes;
+ * this runs when an alert is emitted or /proc/ai_security/events is read.
+ */
+static size_t ai_security_render_explanation(const struct ai_security_event *event,
+                                             char *buf, size_t size)
 {
-    char *explanation;
     const char *threat_desc;
     const char *action_desc;
-    
-    if (!event)
-        return ai_security_strdup("Invalid event");
+    size_t len;
+    int i;
     
     switch (event->threat_level) {
     case AI_SECURITY_THREAT_CRITICAL:
@@ -497,175 +2415,765 @@ static char *ai_security_explain_decision(struct ai_security_event *event)
         break;
     }
     
-    explanation = kmalloc(256, GFP_KERNEL);
-    if (explanation) {
-        snprintf(explanation, 256, "%s (score: %u, confidence: %u%%). %s. %s.",
-                threat_desc, event->threat_score, event->confidence,
-                event->description ? event->description : "No description available",
-                action_desc);
+    /* Scratch file events carry only the file name */
+    if (!event->description[0] && event->type == AI_SECURITY_EVENT_FILE_ACCESS &&
+        event->event_data) {
+        len = scnprintf(buf, size, "%s (score: %u, confidence: %u%%). File access: %s. %s.",
+                        threat_desc, event->threat_score, event->confidence,
+                        (char *)event->event_data, action_desc);
+    } else {
+        len = scnprintf(buf, size, "%s (score: %u, confidence: %u%%). %s. %s.",
+                        threat_desc, event->threat_score, event->confidence,
+                        event->description[0] ? event->description : "No description available",
+                        action_desc);
+    }
+    
+    for (i = 0; i < event->nr_reasons; i++) {
+        len += scnprintf(buf + len, size - len, "%s%s +%u", i ? ", " : " Reasons: ",
+                         event->reasons[i].rule < AI_SECURITY_REASON_MAX ?
+                         ai_security_reason_names[event->reasons[i].rule] : "unknown",
+                         event->reasons[i].points);
     }
     
+    return len;
+}
+
+static char *ai_security_explain_decision(struct ai_security_event *event)
+{
+    char *explanation;
+    
+    if (!event)
+        return ai_security_strdup("Invalid event");
+    
+    explanation = kmalloc(256, GFP_KERNEL);
+    if (!explanation)
+        return NULL;
+    
+    ai_security_render_explanation(event, explanation, 256);
     return explanation;
 }
 
-static void ai_security_log_threat(struct ai_security_event *event)
+/*
+ * Alerts
+ *
+ * Hooks only reserve a ring slot and copy the event into it; formatting,
+ * printk and audit happen in alert_work. Each profile may emit
+ * AI_SECURITY_ALERT_BURST alerts at once and one per
+ * AI_SECURITY_ALERT_RATE_MS after that. An alert identical to the
+ * profile's last one within AI_SECURITY_ALERT_COALESCE_MS is folded, and
+ * the next alert that goes out reports how many were folded or dropped.
+ */
+static u32 ai_security_alert_sig(const struct ai_security_event *event)
+{
+    u32 sig = jhash_3words(event->type, event->threat_score, event->recommended_action, 0);
+    
+    if (event->event_data)
+        sig = jhash(event->event_data, min_t(size_t, event->data_size, AI_SECURITY_DATA_LEN), sig);
+    
+    return sig;
+}
+
+/* Rate limit and coalesce against the profile; false if not emitted */
+static bool ai_security_alert_admit(const struct ai_security_event *event,
+                                    u32 *repeats, u32 *suppressed)
+{
+    struct ai_security_profile *profile;
+    ktime_t now = ai_security_get_current_time();
+    u32 sig = ai_security_alert_sig(event);
+    unsigned long flags;
+    bool admit = false;
+    u64 refill;
+    
+    *repeats = 0;
+    *suppressed = 0;
+    
+    rcu_read_lock();
+    profile = ai_security_profile_lookup(event->pid);
+    if (!profile) {
+        rcu_read_unlock();
+        return true;
+    }
+    
+    spin_lock_irqsave(&profile->lock, flags);
+    
+    if (profile->alert_sig == sig &&
+        ktime_ms_delta(now, profile->alert_last) < AI_SECURITY_ALERT_COALESCE_MS) {
+        profile->alert_repeats++;
+        ai_security_stat_inc(AI_SECURITY_STAT_ALERTS_COALESCED);
+        goto out;
+    }
+    
+    /* A fresh profile refills to a full bucket */
+    refill = div_u64(ktime_ms_delta(now, profile->alert_refill), AI_SECURITY_ALERT_RATE_MS);
+    if (refill) {
+        profile->alert_tokens = min_t(u64, AI_SECURITY_ALERT_BURST,
+                                      profile->alert_tokens + refill);
+        profile->alert_refill = now;
+    }
+    
+    if (!profile->alert_tokens) {
+        profile->alert_suppressed++;
+        ai_security_stat_inc(AI_SECURITY_STAT_ALERTS_SUPPRESSED);
+        goto out;
+    }
+    
+    profile->alert_tokens--;
+    profile->alert_sig = sig;
+    profile->alert_last = now;
+    *repeats = profile->alert_repeats;
+    *suppressed = profile->alert_suppressed;
+    profile->alert_repeats = 0;
+    profile->alert_suppressed = 0;
+    admit = true;
+out:
+    spin_unlock_irqrestore(&profile->lock, flags);
+    rcu_read_unlock();
+    
+    return admit;
+}
+
+static void ai_security_emit_alert(const struct ai_security_event *event)
+{
+    struct ai_security_alert_ring *ring = &ai_sec_mgr->alerts;
+    struct ai_security_alert *rec;
+    u32 repeats, suppressed;
+    unsigned long flags, pos;
+    
+    if (!ai_security_alert_admit(event, &repeats, &suppressed))
+        return;
+    
+    spin_lock_irqsave(&ring->lock, flags);
+    pos = ring->producer_pos;
+    if (unlikely(pos - smp_load_acquire(&ring->consumer_pos) >= AI_SECURITY_ALERT_RING_SIZE)) {
+        spin_unlock_irqrestore(&ring->lock, flags);
+        ai_security_stat_inc(AI_SECURITY_STAT_ALERTS_DROPPED);
+        return;
+    }
+    rec = &ring->records[pos & (AI_SECURITY_ALERT_RING_SIZE - 1)];
+    WRITE_ONCE(rec->busy, 1);
+    /* The consumer sees the slot busy before it sees the new position */
+    smp_store_release(&ring->producer_pos, pos + 1);
+    spin_unlock_irqrestore(&ring->lock, flags);
+    
+    rec->timestamp = ktime_to_ns(event->timestamp);
+    rec->pid = event->pid;
+    rec->uid = event->uid;
+    rec->repeats = repeats;
+    rec->suppressed = suppressed;
+    rec->threat_score = event->threat_score;
+    rec->type = event->type;
+    rec->threat_level = event->threat_level;
+    rec->action = event->recommended_action;
+    rec->confidence = event->confidence;
+    memcpy(rec->comm, event->comm, TASK_COMM_LEN);
+    memcpy(rec->description, event->description, AI_SECURITY_DESC_LEN);
+    rec->nr_reasons = event->nr_reasons;
+    memcpy(rec->reasons, event->reasons, sizeof(rec->reasons));
+    rec->data_len = event->event_data ? min_t(size_t, event->data_size, AI_SECURITY_DATA_LEN) : 0;
+    memcpy(rec->data, event->event_data, rec->data_len);
+    if (rec->data_len && event->type == AI_SECURITY_EVENT_FILE_ACCESS)
+        rec->data[rec->data_len - 1] = '\0';
+    
+    /* Commit; pairs with the acquire in ai_security_alert_work() */
+    smp_store_release(&rec->busy, 0);
+    ai_security_stat_inc(AI_SECURITY_STAT_ALERTS);
+    
+    queue_work(ai_sec_mgr->deep_wq, &ai_sec_mgr->alert_work);
+}
+
+/* Rebuild enough of the event for ai_security_explain_decision() */
+static void ai_security_alert_event(const struct ai_security_alert *rec,
+                                    struct ai_security_event *event)
+{
+    ai_security_init_event(event, rec->type);
+    event->timestamp = ns_to_ktime(rec->timestamp);
+    event->pid = rec->pid;
+    event->uid = rec->uid;
+    event->threat_score = rec->threat_score;
+    event->threat_level = rec->threat_level;
+    event->recommended_action = rec->action;
+    event->confidence = rec->confidence;
+    memcpy(event->comm, rec->comm, TASK_COMM_LEN);
+    memcpy(event->description, rec->description, AI_SECURITY_DESC_LEN);
+    event->nr_reasons = rec->nr_reasons;
+    memcpy(event->reasons, rec->reasons, sizeof(event->reasons));
+    if (rec->data_len) {
+        event->event_data = (void *)rec->data;
+        event->data_size = rec->data_len;
+    }
+    
+    if (!event->description[0] && rec->type == AI_SECURITY_EVENT_NETWORK_CONNECT &&
+        rec->data_len == sizeof(struct in6_addr))
+        snprintf(event->description, AI_SECURITY_DESC_LEN, "Network connect: %pI6c",
+                 rec->data);
+}
+
+/*
+ * The single consumer. It stops at a slot that is still being filled;
+ * its producer queues the work again on commit.
+ */
+static void ai_security_alert_work(struct work_struct *work)
 {
+    struct ai_security_alert_ring *ring = &ai_sec_mgr->alerts;
+    struct ai_security_event event;
+    struct ai_security_alert *rec;
+    unsigned long cons = ring->consumer_pos;
+    unsigned int done = 0;
     char *explanation;
     
+    while (cons != smp_load_acquire(&ring->producer_pos)) {
+        rec = &ring->records[cons & (AI_SECURITY_ALERT_RING_SIZE - 1)];
+        if (smp_load_acquire(&rec->busy))
+            break;
+        
+        ai_security_alert_event(rec, &event);
+        explanation = ai_security_explain_decision(&event);
+        if (explanation) {
+            if (rec->repeats || rec->suppressed)
+                pr_warn("AI Security Alert: %s (%u repeats, %u rate limited)\n",
+                        explanation, rec->repeats, rec->suppressed);
+            else
+                pr_warn("AI Security Alert: %s\n", explanation);
+            kfree(explanation);
+        }
+        
+        /* Send to audit system */
+        if (rec->threat_level >= AI_SECURITY_THREAT_HIGH) {
+            audit_log(NULL, GFP_KERNEL, AUDIT_KERNEL,
+                      "ai_security Threat: pid=%d uid=%d score=%u action=%d repeats=%u suppressed=%u",
+                      rec->pid, rec->uid, rec->threat_score, rec->action,
+                      rec->repeats, rec->suppressed);
+        }
+        
+        /* Hand the slot back to the producers */
+        smp_store_release(&ring->consumer_pos, ++cons);
+        
+        if (++done % AI_SECURITY_DEEP_BATCH == 0)
+            cond_resched();
+    }
+}
+
+static int ai_security_alloc_alert_ring(void)
+{
+    struct ai_security_alert_ring *ring = &ai_sec_mgr->alerts;
+    
+    spin_lock_init(&ring->lock);
+    ring->records = kvcalloc(AI_SECURITY_ALERT_RING_SIZE, sizeof(*ring->records), GFP_KERNEL);
+    if (!ring->records)
+        return -ENOMEM;
+    
+    INIT_WORK(&ai_sec_mgr->alert_work, ai_security_alert_work);
+    return 0;
+}
+
+static void ai_security_log_threat(struct ai_security_event *event)
+{
     if (!event || !ai_sec_mgr)
         return;
     
-    if (event->threat_level >= AI_SECURITY_THREAT_MEDIUM) {
-        explanation = ai_security_explain_decision(event);
-        if (explanation) {
-            pr_warn("AI Security Alert: %s\n", explanation);
-            kfree(explanation);
-        }
-        
-        /* Send to audit system */
-        if (event->threat_level >= AI_SECURITY_THREAT_HIGH) {
-            audit_log(NULL, GFP_KERNEL, AUDIT_KERNEL, 
-                     "ai_security Threat: pid=%d uid=%d score=%u action=%d",
-                     event->pid, event->uid, event->threat_score, event->recommended_action);
+    if (event->threat_level >= AI_SECURITY_THREAT_MEDIUM)
+        ai_security_emit_alert(event);
+}
+
+/* Learning System */
+/*
+ * Exchange features with the other modules: publish the trust level and
+ * take the CPU usage from the scheduler's samples. Caller holds the
+ * profile lock.
+ */
+static void ai_security_sync_features(struct ai_security_profile *profile)
+{
+    struct aurora_task_features *features = profile->features;
+    
+    if (!features)
+        return;
+    
+    BUILD_BUG_ON(AI_SECURITY_SCORE_SHIFT != AURORA_FEATURE_SHIFT);
+    WRITE_ONCE(features->trust, profile->trust_score);
+    aurora_task_features_publish(features, AURORA_FEATURE_SECURITY);
+    
+    if (aurora_task_features_valid(features, AURORA_FEATURE_SCHED)) {
+        profile->avg_cpu_usage = (READ_ONCE(features->cpu_intensity) * 100) >>
+                                 AURORA_FEATURE_SHIFT;
+        profile->max_cpu_usage = max(profile->max_cpu_usage, profile->avg_cpu_usage);
+    }
+}
+
+/* Trust as a percentage, rounded, for the core tiers and /proc */
+static inline u32 ai_security_trust_pct(const struct ai_security_profile *profile)
+{
+    return (READ_ONCE(profile->trust_score) * 100 + AI_SECURITY_SCORE_ONE / 2) >>
+           AI_SECURITY_SCORE_SHIFT;
+}
+
+/*
+ * Core scheduling tiers. Below the trust bar a task gets a core-sched
+ * cookie of its own, inherited by what it forks, so SMT siblings never
+ * run it next to other workloads; trusted tasks keep the default cookie
+ * and share cores freely. The hysteresis keeps a task regaining trust a
+ * step at a time from flapping across the bar.
+ */
+static bool ai_security_core_want_isolation(struct ai_security_profile *profile)
+{
+    u32 bar = READ_ONCE(ai_security_core_isolate_trust);
+    u32 trust = ai_security_trust_pct(profile);
+    
+    if (!bar)
+        return false;
+    if (profile->core_isolated)
+        return trust < bar + AI_SECURITY_CORE_HYSTERESIS;
+    return trust < bar;
+}
+
+/* Move the profiled task to its tier; may sleep */
+static void ai_security_core_apply(struct ai_security_profile *profile, bool isolate)
+{
+    struct task_struct *task;
+    
+    rcu_read_lock();
+    task = pid_task(find_pid_ns(profile->pid, &init_pid_ns), PIDTYPE_PID);
+    if (task && task->start_time == profile->start_time)
+        get_task_struct(task);
+    else
+        task = NULL;
+    rcu_read_unlock();
+    if (!task)
+        return;
+    
+    /* Without SMT or core scheduling there is nothing to isolate from */
+    if (!sched_aurora_core_isolate(task, isolate)) {
+        WRITE_ONCE(profile->core_isolated, isolate);
+        if (ai_security_debug_enabled)
+            pr_info("AI Security: PID %d %s\n", profile->pid,
+                    isolate ? "isolated on its own core" : "shares cores again");
+    }
+    put_task_struct(task);
+}
+
+/*
+ * Visit the profiles touched since the last pass. Those still regaining
+ * trust are queued again, so a profile back at full trust costs nothing
+ * until it next has an event. With @learn clear the queued references
+ * are only released. Returns the number of profiles learnt from.
+ */
+static unsigned int ai_security_learn_dirty(bool learn)
+{
+    struct ai_security_profile *profile, *tmp;
+    struct llist_node *list;
+    unsigned int learned = 0;
+    LLIST_HEAD(again);
+    unsigned long flags;
+    bool recovering, isolate;
+    int cpu;
+    
+    for_each_possible_cpu(cpu) {
+        list = llist_del_all(per_cpu_ptr(ai_sec_mgr->dirty_profiles, cpu));
+        llist_for_each_entry_safe(profile, tmp, list, dirty_node) {
+            /* Touches from here on queue the profile again */
+            clear_bit(AI_SECURITY_PROFILE_DIRTY, &profile->flags);
+            smp_mb__after_atomic();
+            
+            recovering = false;
+            if (learn && !READ_ONCE(profile->retired)) {
+                spin_lock_irqsave(&profile->lock, flags);
+                
+                /* Gradually restore trust for well-behaved processes */
+                if (profile->anomaly_count == 0 &&
+                    profile->trust_score < AI_SECURITY_SCORE(80)) {
+                    profile->trust_score += AI_SECURITY_SCORE(1);
+                    profile->risk_score -= min(profile->risk_score, AI_SECURITY_SCORE_ONE / 200);
+                    WRITE_ONCE(profile->policy_gen, profile->policy_gen + 1);
+                    recovering = profile->trust_score < AI_SECURITY_SCORE(80);
+                }
+                ai_security_sync_features(profile);
+                isolate = ai_security_core_want_isolation(profile);
+                
+                spin_unlock_irqrestore(&profile->lock, flags);
+                learned++;
+                
+                if (isolate != profile->core_isolated)
+                    ai_security_core_apply(profile, isolate);
+            }
+            
+            /* Keep the reference for the next pass, unless already requeued */
+            if (recovering && !test_and_set_bit(AI_SECURITY_PROFILE_DIRTY, &profile->flags))
+                llist_add(&profile->dirty_node, &again);
+            else
+                ai_security_put_profile(profile);
+        }
+        cond_resched();
+    }
+    
+    list = llist_del_all(&again);
+    llist_for_each_entry_safe(profile, tmp, list, dirty_node)
+        llist_add(&profile->dirty_node, raw_cpu_ptr(ai_sec_mgr->dirty_profiles));
+    
+    return learned;
+}
+
+static void ai_security_learning_work(struct work_struct *work)
+{
+    const struct ai_security_intel *intel;
+    unsigned int learned;
+    ktime_t current_time;
+    
+    if (!ai_sec_mgr)
+        return;
+    
+    if (!ai_security_learning_enabled) {
+        ai_security_learn_dirty(false);
+        return;
+    }
+    
+    current_time = ai_security_get_current_time();
+    
+    /* Drop event buckets older than 1 hour */
+    ai_security_expire_events(current_time, false);
+    
+    /* Publish what was learnt since the last pass */
+    ai_security_baseline_flush();
+    
+    /* Update the profiles that changed */
+    learned = ai_security_learn_dirty(true);
+    
+    /* Feeds are pushed from user space; flag a generation over a day old */
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    if (intel && ktime_to_ms(ktime_sub(current_time, intel->published)) > 86400000 &&
+        ktime_to_ms(ktime_sub(current_time, ai_sec_mgr->threat_intel.next_update)) > 0) {
+        pr_warn("AI Security: Threat intelligence generation %llu is over a day old\n",
+                intel->generation);
+        ai_sec_mgr->threat_intel.next_update = ktime_add_ms(current_time, 86400000);
+    }
+    rcu_read_unlock();
+    
+    ai_sec_mgr->last_learning_update = current_time;
+    trace_aurora_security_learn(learned, READ_ONCE(ai_sec_mgr->processes_monitored),
+                                ktime_to_ns(ktime_sub(ai_security_get_current_time(),
+                                                      current_time)));
+    
+    if (ai_security_debug_enabled)
+        pr_info("AI Security: Learning update completed\n");
+}
+
+static void ai_security_learning_timer_callback(struct timer_list *timer)
+{
+    /* Schedule learning work */
+    schedule_work(&ai_sec_mgr->learning_work);
+    
+    /* Reschedule timer */
+    mod_timer(timer, jiffies + msecs_to_jiffies(AI_SECURITY_LEARNING_INTERVAL));
+}
+
+/*
+ * File verdict cache. Only the profiled task reads and writes its
+ * entries; other updaters just bump policy_gen, so no lock is needed.
+ */
+static inline u32 ai_security_verdict_gen(const struct ai_security_profile *profile)
+{
+    return READ_ONCE(profile->policy_gen) + atomic_read(&ai_security_policy_gen);
+}
+
+static inline struct ai_security_verdict *
+ai_security_verdict_slot(struct ai_security_profile *profile, const struct inode *inode)
+{
+    return &profile->verdicts[hash_ptr(inode, AI_SECURITY_VERDICT_BITS)];
+}
+
+static bool ai_security_verdict_lookup(struct ai_security_profile *profile,
+                                       const struct dentry *dentry, int mask, bool *deny)
+{
+    struct ai_security_verdict *v = ai_security_verdict_slot(profile, d_inode(dentry));
+    
+    /* A verdict covers any access within the mask it was made for */
+    if (v->inode != d_inode(dentry) || (mask & ~v->mask) ||
+        v->name_hash_len != READ_ONCE(dentry->d_name.hash_len) ||
+        v->gen != ai_security_verdict_gen(profile))
+        return false;
+    
+    *deny = v->deny;
+    return true;
+}
+
+static void ai_security_verdict_store(struct ai_security_profile *profile,
+                                      const struct dentry *dentry, int mask,
+                                      u64 name_hash_len, u32 gen, bool deny)
+{
+    struct ai_security_verdict *v = ai_security_verdict_slot(profile, d_inode(dentry));
+    
+    /* A label belongs to the inode that was opened */
+    if (v->inode != d_inode(dentry))
+        v->label = 0;
+    v->inode = d_inode(dentry);
+    v->name_hash_len = name_hash_len;
+    v->gen = gen;
+    v->mask = mask;
+    v->deny = deny;
+}
+
+/* Label left by file_open for @dentry's inode, if still current */
+static u8 ai_security_verdict_label(struct ai_security_profile *profile,
+                                    const struct dentry *dentry)
+{
+    struct ai_security_verdict *v = ai_security_verdict_slot(profile, d_inode(dentry));
+    
+    if (v->inode != d_inode(dentry) || v->label_gen != ai_security_intel_gen())
+        return 0;
+    
+    return v->label;
+}
+
+/*
+ * Referenced profile of the current task, created on first sight or
+ * when the one found was left by an earlier task with the same pid.
+ */
+static struct ai_security_profile *ai_security_current_profile(void)
+{
+    struct ai_security_profile *profile;
+    
+    if (!ai_sec_mgr || ai_security_is_system_process(current->pid))
+        return NULL;
+    
+    profile = ai_security_get_profile(current->pid);
+    if (!profile || profile->start_time != current->start_time) {
+        ai_security_put_profile(profile);
+        ai_security_create_profile(current);
+        profile = ai_security_get_profile(current->pid);
+        if (!profile)
+            return NULL;
+    }
+    
+    if (!READ_ONCE(profile->referenced))
+        WRITE_ONCE(profile->referenced, true);
+    
+    return profile;
+}
+
+/*
+ * Decide @mask access to @file and cache the verdict. The event lives
+ * on the stack and uses the label left by file_open; a name snapshot is
+ * only taken for unlabelled files and for events that are retained.
+ */
+static int ai_security_file_decide(struct ai_security_profile *profile,
+                                   struct file *file, int mask)
+{
+    struct ai_security_event scratch, *event;
+    struct task_struct *task = current;
+    struct name_snapshot name;
+    bool named = false;
+    int decision = 0;
+    bool deny;
+    u32 gen;
+    
+    /* Steady-state IO stops here */
+    if (ai_security_verdict_lookup(profile, file->f_path.dentry, mask, &deny)) {
+        ai_security_stat_inc(AI_SECURITY_STAT_VERDICT_HITS);
+        return deny ? -EACCES : 0;
+    }
+    
+    /*
+     * Sample the generation before analysing: if the analysis itself
+     * moves trust, the stored verdict is stale on arrival.
+     */
+    gen = ai_security_verdict_gen(profile);
+    
+    /* Fill event details */
+    ai_security_init_event(&scratch, AI_SECURITY_EVENT_FILE_ACCESS);
+    scratch.pid = task->pid;
+    scratch.ppid = task_ppid_nr(task);
+    scratch.uid = current_uid().val;
+    scratch.gid = current_gid().val;
+    memcpy(scratch.comm, task->comm, TASK_COMM_LEN);
+    scratch.comm[TASK_COMM_LEN - 1] = '\0';
+    
+    /* Labelled at open: no name is needed unless the event is kept */
+    if (d_inode(file->f_path.dentry))
+        scratch.file_label = ai_security_verdict_label(profile, file->f_path.dentry);
+    if (!scratch.file_label) {
+        /* A stable copy of the name; only long names take a reference */
+        take_dentry_name_snapshot(&name, file->f_path.dentry);
+        scratch.event_data = (void *)name.name.name;
+        scratch.data_size = name.name.len + 1;
+        named = true;
+    }
+    
+    /* Make security decision */
+    decision = ai_security_make_decision(&scratch);
+    
+    if (d_inode(file->f_path.dentry))
+        ai_security_verdict_store(profile, file->f_path.dentry, mask,
+                                  named ? name.name.hash_len :
+                                  READ_ONCE(file->f_path.dentry->d_name.hash_len),
+                                  gen, decision);
+    
+    /* Add to recent events */
+    if (scratch.threat_score > 20) {
+        if (!named) {
+            take_dentry_name_snapshot(&name, file->f_path.dentry);
+            scratch.event_data = (void *)name.name.name;
+            scratch.data_size = name.name.len + 1;
+            named = true;
         }
+        event = ai_security_retain_event(&scratch);
+        if (event)
+            ai_security_store_event(event);
     }
+    
+    if (named)
+        release_dentry_name_snapshot(&name);
+    
+    return decision ? -EACCES : 0;
 }
 
-/* Learning System */
-static void ai_security_learning_work(struct work_struct *work)
+/* Every access the open file mode allows */
+static int ai_security_open_mask(const struct file *file)
 {
-    struct ai_security_profile *profile, *tmp;
-    struct ai_security_event *event, *event_tmp;
-    unsigned long flags;
-    ktime_t current_time;
+    int mask = 0;
+    
+    if (file->f_mode & FMODE_READ)
+        mask |= MAY_READ;
+    if (file->f_mode & FMODE_WRITE)
+        mask |= MAY_WRITE;
+    if (file->f_mode & FMODE_EXEC)
+        mask |= MAY_EXEC;
+    if (file->f_flags & O_APPEND)
+        mask |= MAY_APPEND;
+    
+    return mask;
+}
+
+/*
+ * LSM Hook Implementations
+ *
+ * The decision is made when a file is opened or mapped: file_open
+ * labels the inode from its full path and decides every access the
+ * open mode allows. file_permission, which runs on every read and
+ * write, then hits that verdict until the profile's policy generation
+ * moves.
+ */
+static int __ai_security_file_open(struct file *file)
+{
+    struct ai_security_profile *profile;
+    struct ai_security_verdict *v;
+    struct inode *inode = file_inode(file);
+    char *buf, *path;
+    u32 gen;
+    u8 label;
+    int ret;
     
-    if (!ai_sec_mgr || !ai_security_learning_enabled)
-        return;
+    if (!ai_sec_mgr || ai_security_is_system_process(current->pid))
+        return 0;
     
-    current_time = ai_security_get_current_time();
+    buf = __getname();
+    if (!buf)
+        return 0;
     
-    /* Clean up old events and update profiles */
-    spin_lock_irqsave(&ai_sec_mgr->events_lock, flags);
-    list_for_each_entry_safe(event, event_tmp, &ai_sec_mgr->recent_events, list) {
-        /* Remove events older than 1 hour */
-        if (ktime_to_ms(ktime_sub(current_time, event->timestamp)) > 3600000) {
-            list_del(&event->list);
-            hlist_del_rcu(&event->hash);
-            ai_security_free_event(event);
-        }
+    path = d_path(&file->f_path, buf, PATH_MAX);
+    if (IS_ERR(path)) {
+        __putname(buf);
+        return 0;
     }
-    spin_unlock_irqrestore(&ai_sec_mgr->events_lock, flags);
+    label = ai_security_label_path(path, &gen);
+    __putname(buf);
     
-    /* Update process profiles */
-    list_for_each_entry_safe(profile, tmp, &ai_sec_mgr->process_profiles, list) {
-        spin_lock_irqsave(&profile->lock, flags);
-        
-        /* Gradually restore trust for well-behaved processes */
-        if (profile->anomaly_count == 0 && profile->trust_score < 0.8f) {
-            profile->trust_score += 0.01f;
-            profile->risk_score = max(0.0f, profile->risk_score - 0.005f);
-        }
-        
-        /* Update baseline patterns */
-        profile->last_activity = current_time;
-        
-        spin_unlock_irqrestore(&profile->lock, flags);
-    }
+    profile = ai_security_current_profile();
+    if (!profile)
+        return 0;
     
-    /* Update threat intelligence */
-    if (ktime_to_ms(ktime_sub(current_time, ai_sec_mgr->threat_intel.last_update)) > 86400000) {
-        /* Daily update of threat intelligence */
-        ai_sec_mgr->threat_intel.last_update = current_time;
-        if (ai_security_debug_enabled)
-            pr_info("AI Security: Daily threat intelligence update\n");
+    /* Claim the slot; any verdict cached in it was for another inode */
+    v = ai_security_verdict_slot(profile, inode);
+    if (v->inode != inode) {
+        v->inode = inode;
+        v->mask = 0;
     }
+    v->label = label;
+    v->label_gen = gen;
     
-    ai_sec_mgr->last_learning_update = current_time;
+    ret = ai_security_file_decide(profile, file, ai_security_open_mask(file));
+    ai_security_put_profile(profile);
+    return ret;
+}
+
+static int __ai_security_mmap_file(struct file *file, unsigned long reqprot,
+                                   unsigned long prot, unsigned long flags)
+{
+    struct ai_security_profile *profile;
+    int mask = MAY_READ;
+    int ret;
     
-    if (ai_security_debug_enabled)
-        pr_info("AI Security: Learning update completed\n");
+    if (!file)
+        return 0;
+    
+    profile = ai_security_current_profile();
+    if (!profile)
+        return 0;
+    
+    if (prot & PROT_EXEC)
+        mask |= MAY_EXEC;
+    if ((prot & PROT_WRITE) && (flags & MAP_TYPE) == MAP_SHARED)
+        mask |= MAY_WRITE;
+    
+    ret = ai_security_file_decide(profile, file, mask);
+    ai_security_put_profile(profile);
+    return ret;
 }
 
-static void ai_security_learning_timer_callback(struct timer_list *timer)
+static int __ai_security_file_permission(struct file *file, int mask)
 {
-    static struct work_struct learning_work;
+    struct ai_security_profile *profile;
+    int ret;
     
-    /* Schedule learning work */
-    INIT_WORK(&learning_work, ai_security_learning_work);
-    schedule_work(&learning_work);
+    if (!file)
+        return 0;
     
-    /* Reschedule timer */
-    mod_timer(timer, jiffies + msecs_to_jiffies(AI_SECURITY_LEARNING_INTERVAL));
+    profile = ai_security_current_profile();
+    if (!profile)
+        return 0;
+    
+    ret = ai_security_file_decide(profile, file, mask);
+    ai_security_put_profile(profile);
+    return ret;
 }
 
-/* LSM Hook Implementations */
-static int ai_security_file_permission(struct file *file, int mask)
+static int __ai_security_task_create(unsigned long clone_flags)
 {
     struct ai_security_event *event = NULL;
     struct ai_security_profile *profile;
     struct task_struct *task = current;
-    int decision = 0;
     int ret;
     
-    if (!ai_sec_mgr || !file || !task)
+    if (!ai_sec_mgr || !task)
         return 0;
     
     /* Skip system processes */
     if (ai_security_is_system_process(task->pid))
         return 0;
     
-    /* Get or create profile */
+    /* Get profile */
     profile = ai_security_get_profile(task->pid);
-    if (!profile) {
-        ai_security_create_profile(task);
-        profile = ai_security_get_profile(task->pid);
-        if (!profile)
-            return 0;
-    }
+    if (!profile)
+        return 0;
+    ai_security_put_profile(profile);
     
     /* Create security event */
-    ret = ai_security_create_event(&event, AI_SECURITY_EVENT_FILE_ACCESS);
-    if (ret) {
-        return 0;  /* Allow on error */
-    }
+    ret = ai_security_create_event(&event, AI_SECURITY_EVENT_PROCESS_EXEC);
+    if (ret)
+        return 0;
     
     /* Fill event details */
     event->pid = task->pid;
-    event->ppid = task->real_parent->pid;
     event->uid = task->cred->uid.val;
-    event->gid = task->cred->gid.val;
     strncpy(event->comm, task->comm, TASK_COMM_LEN - 1);
-    event->comm[TASK_COMM_LEN - 1] = '\0';
+    strscpy(event->description, "Process creation/fork", AI_SECURITY_DESC_LEN);
     
-    /* Create description */
-    if (file->f_path.dentry && file->f_path.dentry->d_name.name) {
-        char *path = kmalloc(256, GFP_KERNEL);
-        if (path) {
-            snprintf(path, 256, "File access: %s", file->f_path.dentry->d_name.name);
-            event->description = path;
-            event->event_data = ai_security_strdup(file->f_path.dentry->d_name.name);
-            event->data_size = strlen(file->f_path.dentry->d_name.name) + 1;
-        }
-    }
-    
-    /* Make security decision */
-    decision = ai_security_make_decision(event);
-    
-    /* Add to recent events */
-    if (event->threat_score > 20) {
-        unsigned long flags;
-        spin_lock_irqsave(&ai_sec_mgr->events_lock, flags);
-        list_add_tail(&event->list, &ai_sec_mgr->recent_events);
-        ai_security_event_add_to_hash(event);
-        spin_unlock_irqrestore(&ai_sec_mgr->events_lock, flags);
-    } else {
-        ai_security_free_event(event);
-    }
+    /* Analyze */
+    ai_security_analyze_event(event);
+    ai_security_free_event(event);
     
-    return decision ? -EACCES : 0;
+    return 0;
 }
 
-static int ai_security_task_create(unsigned long clone_flags)
+static int __ai_security_task_fix_setuid(struct cred *new, const struct cred *old, int flags)
 {
     struct ai_security_event *event = NULL;
     struct ai_security_profile *profile;
@@ -679,94 +3187,482 @@ static int ai_security_task_create(unsigned long clone_flags)
     if (ai_security_is_system_process(task->pid))
         return 0;
     
+    /* Check if this is actual privilege escalation */
+    if (new->uid.val == old->uid.val)
+        return 0;  /* No actual change */
+    
     /* Get profile */
     profile = ai_security_get_profile(task->pid);
     if (!profile)
         return 0;
+    ai_security_put_profile(profile);
     
     /* Create security event */
-    ret = ai_security_create_event(&event, AI_SECURITY_EVENT_PROCESS_EXEC);
+    ret = ai_security_create_event(&event, AI_SECURITY_EVENT_PRIVILEGE_ESCALATION);
     if (ret)
         return 0;
     
     /* Fill event details */
     event->pid = task->pid;
-    event->uid = task->cred->uid.val;
+    event->uid = new->uid.val;
     strncpy(event->comm, task->comm, TASK_COMM_LEN - 1);
-    event->description = ai_security_strdup("Process creation/fork");
     
-    /* Analyze */
-    ai_security_analyze_event(event);
-    ai_security_free_event(event);
+    /* Create description */
+    snprintf(event->description, AI_SECURITY_DESC_LEN, "Privilege escalation: uid %d -> %d",
+            old->uid.val, new->uid.val);
+    
+    /* Make security decision */
+    ret = ai_security_make_decision(event);
+    
+    /* Add to recent events */
+    if (event->threat_score > 30) {
+        ai_security_store_event(event);
+    } else {
+        ai_security_free_event(event);
+    }
+    
+    return ret ? -EPERM : 0;
+}
+
+/*
+ * Connect checks cost a policy trie walk, one bloom probe and a search
+ * of the profile's baseline; an event is only built when one of them
+ * finds something.
+ */
+static int __ai_security_socket_connect(struct socket *sock, struct sockaddr *address, int addrlen)
+{
+    struct ai_security_event scratch, *event;
+    struct ai_security_profile *profile;
+    struct task_struct *task = current;
+    struct in6_addr addr;
+    bool watch = false, novel;
+    int action, decision;
+    
+    if (!ai_sec_mgr || !address)
+        return 0;
+    
+    /* Skip system processes */
+    if (ai_security_is_system_process(task->pid))
+        return 0;
+    
+    /* Only IP endpoints are policed */
+    if (!ai_security_sockaddr_to_in6(address, addrlen, &addr))
+        return 0;
+    
+    /* Get or create profile */
+    profile = ai_security_current_profile();
+    if (!profile)
+        return 0;
+    
+    WRITE_ONCE(profile->network_connection_count, profile->network_connection_count + 1);
+    
+    rcu_read_lock();
+    action = ai_security_net_lookup(&addr);
+    rcu_read_unlock();
+    
+    switch (action) {
+    case AI_SECURITY_NET_ALLOW:
+        ai_security_put_profile(profile);
+        return 0;
+    case AI_SECURITY_NET_DENY:
+        ai_security_put_profile(profile);
+        ai_security_stat_inc(AI_SECURITY_STAT_NET_DENIED);
+        return -EACCES;
+    case AI_SECURITY_NET_WATCH:
+        watch = true;
+        break;
+    default:
+        break;
+    }
+    
+    /* Outside the learnt baseline */
+    novel = ai_security_endpoint_novel(profile, &addr);
+    ai_security_put_profile(profile);
+    
+    if (!watch && !novel && !ai_security_is_malicious_ip(&addr))
+        return 0;
+    
+    /* Fill event details */
+    ai_security_init_event(&scratch, AI_SECURITY_EVENT_NETWORK_CONNECT);
+    scratch.pid = task->pid;
+    scratch.ppid = task_ppid_nr(task);
+    scratch.uid = current_uid().val;
+    scratch.gid = current_gid().val;
+    memcpy(scratch.comm, task->comm, TASK_COMM_LEN);
+    scratch.comm[TASK_COMM_LEN - 1] = '\0';
+    if (watch)
+        ai_security_add_reason(&scratch, AI_SECURITY_REASON_NET_WATCH, 30);
+    if (novel)
+        ai_security_add_reason(&scratch, AI_SECURITY_REASON_NET_NOVEL, 15);
+    scratch.event_data = &addr;
+    scratch.data_size = sizeof(addr);
+    
+    /* Make security decision */
+    decision = ai_security_make_decision(&scratch);
+    
+    /* Add to recent events */
+    if (scratch.threat_score > 20) {
+        event = ai_security_retain_event(&scratch);
+        if (event)
+            ai_security_store_event(event);
+    }
+    
+    return decision ? -EACCES : 0;
+}
+
+/*
+ * The last reference to a task can be dropped from an RCU callback, so
+ * this only takes profiles_lock; the reaper does the rest. The pid may
+ * already belong to a new task, hence the start time check.
+ */
+static void __ai_security_task_free(struct task_struct *task)
+{
+    struct ai_security_profile *profile;
+    
+    if (!ai_sec_mgr)
+        return;
+    
+    rcu_read_lock();
+    profile = ai_security_profile_lookup(task->pid);
+    if (profile && profile->start_time == task->start_time) {
+        ai_security_retire_profile(profile);
+        ai_security_stat_inc(AI_SECURITY_STAT_PROFILES_RETIRED);
+    }
+    rcu_read_unlock();
+}
+
+/*
+ * Timed hook entry points. Hooks stay registered for the life of the
+ * kernel, so until the module is up and again once it starts shutting
+ * down each one costs a patched NOP.
+ *
+ * Hook bodies run in an SRCU read section, entered only while the hooks
+ * are active, so that the exit path can wait for the ones still running
+ * (file_open sleeps in d_path) before it frees the profiles under them.
+ * The key is tested again inside the section: a hook that passed the
+ * first test just before the key flipped and entered the section after
+ * the grace period started must not go on.
+ */
+DEFINE_STATIC_SRCU(ai_security_hooks_srcu);
+
+static __always_inline bool ai_security_hook_enter(int *idx)
+{
+    if (!static_branch_unlikely(&ai_security_hooks_active))
+        return false;
+    
+    *idx = srcu_read_lock(&ai_security_hooks_srcu);
+    if (likely(static_branch_unlikely(&ai_security_hooks_active)))
+        return true;
+    
+    srcu_read_unlock(&ai_security_hooks_srcu, *idx);
+    return false;
+}
+
+static __always_inline void ai_security_hook_exit(int idx)
+{
+    srcu_read_unlock(&ai_security_hooks_srcu, idx);
+}
+
+static int ai_security_file_open(struct file *file)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_file_open(file);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_FILE_OPEN, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static int ai_security_mmap_file(struct file *file, unsigned long reqprot,
+                                 unsigned long prot, unsigned long flags)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_mmap_file(file, reqprot, prot, flags);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_MMAP_FILE, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static int ai_security_file_permission(struct file *file, int mask)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_file_permission(file, mask);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_FILE_PERMISSION, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static int ai_security_task_create(unsigned long clone_flags)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_task_create(clone_flags);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_TASK_CREATE, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static int ai_security_task_fix_setuid(struct cred *new, const struct cred *old, int flags)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_task_fix_setuid(new, old, flags);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_TASK_FIX_SETUID, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static int ai_security_socket_connect(struct socket *sock, struct sockaddr *address, int addrlen)
+{
+    u64 start;
+    int ret, idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return 0;
+    
+    start = local_clock();
+    ret = __ai_security_socket_connect(sock, address, addrlen);
+    
+    ai_security_hook_done(AI_SECURITY_HOOK_SOCKET_CONNECT, start);
+    ai_security_hook_exit(idx);
+    return ret;
+}
+
+static void ai_security_task_free(struct task_struct *task)
+{
+    u64 start;
+    int idx;
+    
+    if (!ai_security_hook_enter(&idx))
+        return;
+    
+    start = local_clock();
+    __ai_security_task_free(task);
+    ai_security_hook_done(AI_SECURITY_HOOK_TASK_FREE, start);
+    ai_security_hook_exit(idx);
+}
+
+#if IS_ENABLED(CONFIG_BPF_LSM) && IS_ENABLED(CONFIG_DEBUG_INFO_BTF_MODULES)
+/*
+ * BPF LSM Offload
+ *
+ * With ai_security_offload set the module registers no hooks of its own.
+ * BPF LSM programs (bpf/ai_security.bpf.c) make the fast-path decision,
+ * caching verdicts in task and inode local storage keyed on
+ * bpf_ai_security_gen(), and call in here for the intelligence sets and
+ * the final policy decision. The module stays the slow-path analyst:
+ * decided events feed the deep tier exactly as the built-in hooks do.
+ */
+__diag_push();
+__diag_ignore_all("-Wmissing-prototypes",
+                  "kfuncs called from BPF programs");
+
+/* Verdict generation; cached decisions are stale once this moves */
+u32 bpf_ai_security_gen(struct task_struct *task)
+{
+    struct ai_security_profile *profile;
+    u32 gen;
+    
+    rcu_read_lock();
+    profile = ai_security_profile_lookup(task->pid);
+    gen = profile ? ai_security_verdict_gen(profile) : atomic_read(&ai_security_policy_gen);
+    rcu_read_unlock();
+    
+    return gen;
+}
+
+/* Match-class mask of the first @str__sz bytes of @str */
+u32 bpf_ai_security_match(const char *str, u32 str__sz)
+{
+    if (!str__sz || strnlen(str, str__sz) == str__sz)
+        return 0;
     
-    return 0;
+    return ai_security_match_string(str);
 }
 
-static int ai_security_task_fix_setuid(struct cred *new, const struct cred *old, int flags)
+/* AI_SECURITY_LABEL_* of a full path; valid until bpf_ai_security_intel_gen() moves */
+u32 bpf_ai_security_label(const char *path, u32 path__sz)
 {
-    struct ai_security_event *event = NULL;
-    struct ai_security_profile *profile;
-    struct task_struct *task = current;
-    int ret;
+    u32 gen;
     
-    if (!ai_sec_mgr || !task)
+    if (!path__sz || strnlen(path, path__sz) == path__sz)
         return 0;
     
-    /* Skip system processes */
+    return ai_security_label_path(path, &gen);
+}
+
+u32 bpf_ai_security_intel_gen(void)
+{
+    return ai_security_intel_gen();
+}
+
+bool bpf_ai_security_malicious_ip(const u32 *addr, u32 addr__sz)
+{
+    if (addr__sz != sizeof(struct in6_addr))
+        return false;
+    
+    return ai_security_is_malicious_ip((const struct in6_addr *)addr);
+}
+
+/* Start profiling @task; from sleepable programs such as bprm_committed_creds */
+int bpf_ai_security_track(struct task_struct *task)
+{
     if (ai_security_is_system_process(task->pid))
         return 0;
     
-    /* Check if this is actual privilege escalation */
-    if (new->uid.val == old->uid.val)
-        return 0;  /* No actual change */
-    
-    /* Get profile */
-    profile = ai_security_get_profile(task->pid);
-    if (!profile)
-        return 0;
+    return ai_security_create_profile(task);
+}
+
+/* Retire @task's profile; from the task_free program */
+void bpf_ai_security_untrack(struct task_struct *task)
+{
+    __ai_security_task_free(task);
+}
+
+/*
+ * Final decision for an event the program has already scored against
+ * the static rules. The profile adjustments and the threshold and
+ * auto-response policy are applied here, and the event is queued for
+ * the deep tier. Returns 1 to deny.
+ */
+int bpf_ai_security_decide(struct task_struct *task, u32 type, u32 score)
+{
+    struct ai_security_event scratch;
     
-    /* Create security event */
-    ret = ai_security_create_event(&event, AI_SECURITY_EVENT_PRIVILEGE_ESCALATION);
-    if (ret)
+    if (type >= AI_SECURITY_EVENT_MAX)
         return 0;
     
-    /* Fill event details */
-    event->pid = task->pid;
-    event->uid = new->uid.val;
-    strncpy(event->comm, task->comm, TASK_COMM_LEN - 1);
-    
-    /* Create description */
-    event->description = kmalloc(128, GFP_KERNEL);
-    if (event->description) {
-        snprintf(event->description, 128, "Privilege escalation: uid %d -> %d",
-                old->uid.val, new->uid.val);
-    }
-    
-    /* Make security decision */
-    ret = ai_security_make_decision(event);
-    
-    /* Add to recent events */
-    if (event->threat_score > 30) {
-        unsigned long flags;
-        spin_lock_irqsave(&ai_sec_mgr->events_lock, flags);
-        list_add_tail(&event->list, &ai_sec_mgr->recent_events);
-        ai_security_event_add_to_hash(event);
-        spin_unlock_irqrestore(&ai_sec_mgr->events_lock, flags);
-    } else {
-        ai_security_free_event(event);
-    }
-    
-    return ret ? -EPERM : 0;
+    ai_security_init_event(&scratch, type);
+    scratch.pid = task->pid;
+    scratch.ppid = task_ppid_nr(task);
+    scratch.uid = task_uid(task).val;
+    scratch.gid = task_cred_xxx(task, gid).val;
+    memcpy(scratch.comm, task->comm, TASK_COMM_LEN);
+    scratch.comm[TASK_COMM_LEN - 1] = '\0';
+    if (score)
+        ai_security_add_reason(&scratch, AI_SECURITY_REASON_BPF_RULES, min(score, 100U));
+    
+    return ai_security_make_decision(&scratch);
+}
+
+__diag_pop();
+
+BTF_SET8_START(ai_security_kfunc_ids)
+BTF_ID_FLAGS(func, bpf_ai_security_gen, KF_TRUSTED_ARGS)
+BTF_ID_FLAGS(func, bpf_ai_security_match)
+BTF_ID_FLAGS(func, bpf_ai_security_label)
+BTF_ID_FLAGS(func, bpf_ai_security_intel_gen)
+BTF_ID_FLAGS(func, bpf_ai_security_malicious_ip)
+BTF_ID_FLAGS(func, bpf_ai_security_track, KF_TRUSTED_ARGS | KF_SLEEPABLE)
+BTF_ID_FLAGS(func, bpf_ai_security_untrack, KF_TRUSTED_ARGS)
+BTF_ID_FLAGS(func, bpf_ai_security_decide, KF_TRUSTED_ARGS)
+BTF_SET8_END(ai_security_kfunc_ids)
+
+static const struct btf_kfunc_id_set ai_security_kfunc_set = {
+    .owner = THIS_MODULE,
+    .set   = &ai_security_kfunc_ids,
+};
+
+static int ai_security_register_kfuncs(void)
+{
+    return register_btf_kfunc_id_set(BPF_PROG_TYPE_LSM, &ai_security_kfunc_set);
+}
+#else
+static int ai_security_register_kfuncs(void)
+{
+    return ai_security_offload ? -EOPNOTSUPP : 0;
 }
+#endif
 
 /* LSM Hooks Structure */
 static struct security_hook_list ai_security_hooks[] = {
     LSM_HOOK_INIT(file_permission, ai_security_file_permission),
+    LSM_HOOK_INIT(file_open, ai_security_file_open),
+    LSM_HOOK_INIT(mmap_file, ai_security_mmap_file),
     LSM_HOOK_INIT(task_create, ai_security_task_create),
     LSM_HOOK_INIT(task_fix_setuid, ai_security_task_fix_setuid),
+    LSM_HOOK_INIT(socket_connect, ai_security_socket_connect),
+    LSM_HOOK_INIT(task_free, ai_security_task_free),
 };
 
 /* ProcFS Interface */
+static const char * const ai_security_hook_names[AI_SECURITY_HOOK_MAX] = {
+    [AI_SECURITY_HOOK_FILE_PERMISSION]  = "file_permission",
+    [AI_SECURITY_HOOK_FILE_OPEN]        = "file_open",
+    [AI_SECURITY_HOOK_MMAP_FILE]        = "mmap_file",
+    [AI_SECURITY_HOOK_TASK_CREATE]      = "task_create",
+    [AI_SECURITY_HOOK_TASK_FIX_SETUID]  = "task_fix_setuid",
+    [AI_SECURITY_HOOK_SOCKET_CONNECT]   = "socket_connect",
+    [AI_SECURITY_HOOK_TASK_FREE]        = "task_free",
+};
+
+static void ai_security_proc_show_latency(struct seq_file *m)
+{
+    u64 hist[AI_SECURITY_LAT_BUCKETS];
+    u64 calls, ns;
+    int hook, cpu, b;
+    
+    seq_printf(m, "\n=== Hook Latency (ns, bucket lower bounds) ===\n");
+    seq_printf(m, "%-16s %10s %8s", "Hook", "Calls", "Avg");
+    seq_printf(m, " %8s", "0");
+    for (b = 1; b < AI_SECURITY_LAT_BUCKETS; b++)
+        seq_printf(m, " %8llu", 1ULL << (AI_SECURITY_LAT_MIN_SHIFT + b - 1));
+    seq_putc(m, '\n');
+    
+    for (hook = 0; hook < AI_SECURITY_HOOK_MAX; hook++) {
+        memset(hist, 0, sizeof(hist));
+        calls = 0;
+        ns = 0;
+        
+        for_each_possible_cpu(cpu) {
+            struct ai_security_cpu_stats *s = per_cpu_ptr(ai_sec_mgr->stats, cpu);
+            
+            calls += s->hook_calls[hook];
+            ns += s->hook_ns[hook];
+            for (b = 0; b < AI_SECURITY_LAT_BUCKETS; b++)
+                hist[b] += s->hook_lat[hook][b];
+        }
+        
+        seq_printf(m, "%-16s %10llu %8llu", ai_security_hook_names[hook], calls,
+                   calls ? div64_u64(ns, calls) : 0);
+        for (b = 0; b < AI_SECURITY_LAT_BUCKETS; b++)
+            seq_printf(m, " %8llu", hist[b]);
+        seq_putc(m, '\n');
+    }
+}
+
 static int ai_security_proc_show_stats(struct seq_file *m, void *v)
 {
     if (!ai_sec_mgr) {
@@ -776,42 +3672,345 @@ static int ai_security_proc_show_stats(struct seq_file *m, void *v)
     
     seq_printf(m, "=== AI Security Manager Statistics ===\n");
     seq_printf(m, "Processes Monitored: %llu\n", ai_sec_mgr->processes_monitored);
-    seq_printf(m, "Total Events Processed: %llu\n", ai_sec_mgr->total_events_processed);
-    seq_printf(m, "Threats Detected: %llu\n", ai_sec_mgr->threats_detected);
-    seq_printf(m, "Threats Blocked: %llu\n", ai_sec_mgr->threats_blocked);
-    seq_printf(m, "False Positives: %llu\n", ai_sec_mgr->false_positives);
+    seq_printf(m, "Total Events Processed: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_EVENTS));
+    seq_printf(m, "Threats Detected: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_THREATS_DETECTED));
+    seq_printf(m, "Threats Blocked: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_THREATS_BLOCKED));
+    seq_printf(m, "False Positives: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_FALSE_POSITIVES));
+    seq_printf(m, "Verdict Cache Hits: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_VERDICT_HITS));
+    seq_printf(m, "Deep Analysed: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_DEEP_ANALYSED));
+    seq_printf(m, "Deep Dropped: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_DEEP_DROPPED));
+    seq_printf(m, "Connects Denied: %llu\n", ai_security_stat_sum(AI_SECURITY_STAT_NET_DENIED));
+    seq_printf(m, "Alerts: %llu (coalesced %llu, rate limited %llu, dropped %llu)\n",
+               ai_security_stat_sum(AI_SECURITY_STAT_ALERTS),
+               ai_security_stat_sum(AI_SECURITY_STAT_ALERTS_COALESCED),
+               ai_security_stat_sum(AI_SECURITY_STAT_ALERTS_SUPPRESSED),
+               ai_security_stat_sum(AI_SECURITY_STAT_ALERTS_DROPPED));
+    seq_printf(m, "Profiles Retired: %llu, Evicted: %llu\n",
+               ai_security_stat_sum(AI_SECURITY_STAT_PROFILES_RETIRED),
+               ai_security_stat_sum(AI_SECURITY_STAT_PROFILES_EVICTED));
     seq_printf(m, "Threat Threshold: %u\n", ai_security_threat_threshold);
     seq_printf(m, "Auto Response: %s\n", ai_security_auto_response ? "Enabled" : "Disabled");
     seq_printf(m, "Learning Mode: %s\n", ai_security_learning_enabled ? "Enabled" : "Disabled");
     seq_printf(m, "Debug Mode: %s\n", ai_security_debug_enabled ? "Enabled" : "Disabled");
     
+    ai_security_proc_show_latency(m);
+    
+    return 0;
+}
+
+/*
+ * Binary history export: one chunk per seq_file record, each copied
+ * whole under its CPU's lock so it is self-consistent.
+ */
+static void *ai_security_history_start(struct seq_file *m, loff_t *pos)
+{
+    return *pos < ai_security_history_total() ? pos : NULL;
+}
+
+static void *ai_security_history_next(struct seq_file *m, void *v, loff_t *pos)
+{
+    ++*pos;
+    return ai_security_history_start(m, pos);
+}
+
+static void ai_security_history_stop(struct seq_file *m, void *v)
+{
+}
+
+static int ai_security_history_show(struct seq_file *m, void *v)
+{
+    struct ai_security_history_header hdr = {
+        .magic          = AI_SECURITY_HISTORY_MAGIC,
+        .version        = AI_SECURITY_HISTORY_VERSION,
+        .record_size    = sizeof(struct ai_security_record),
+    };
+    struct ai_security_record_chunk *chunk;
+    struct ai_security_history *hist;
+    loff_t idx = *(loff_t *)v;
+    unsigned long flags;
+    int cpu;
+    
+    for_each_possible_cpu(cpu) {
+        hist = per_cpu_ptr(ai_sec_mgr->history, cpu);
+        spin_lock_irqsave(&hist->lock, flags);
+        if (idx < hist->nr_chunks) {
+            chunk = ai_security_history_chunk(hist, idx);
+            if (chunk && chunk->nr) {
+                hdr.cpu = chunk->cpu;
+                hdr.nr = chunk->nr;
+                hdr.base = chunk->base;
+                seq_write(m, &hdr, sizeof(hdr));
+                seq_write(m, chunk->records, chunk->nr * sizeof(*chunk->records));
+            }
+            spin_unlock_irqrestore(&hist->lock, flags);
+            return 0;
+        }
+        idx -= hist->nr_chunks;
+        spin_unlock_irqrestore(&hist->lock, flags);
+    }
+    
+    return 0;
+}
+
+static const struct seq_operations ai_security_history_seq_ops = {
+    .start  = ai_security_history_start,
+    .next   = ai_security_history_next,
+    .stop   = ai_security_history_stop,
+    .show   = ai_security_history_show,
+};
+
+/* Retained events; explanations are rendered here, not when recorded */
+static int ai_security_proc_show_events(struct seq_file *m, void *v)
+{
+    struct ai_security_event_store *store;
+    struct ai_security_event *event;
+    unsigned long flags;
+    char buf[256];
+    int cpu, slot;
+    
+    seq_printf(m, "%-10s %-8s %-16s %-4s %-5s %s\n",
+               "ID", "PID", "Comm", "Type", "Score", "Explanation");
+    
+    for_each_possible_cpu(cpu) {
+        store = per_cpu_ptr(ai_sec_mgr->event_stores, cpu);
+        spin_lock_irqsave(&store->lock, flags);
+        for (slot = 0; slot < AI_SECURITY_EVENT_BUCKETS; slot++) {
+            list_for_each_entry(event, &store->buckets[slot], list) {
+                ai_security_render_explanation(event, buf, sizeof(buf));
+                seq_printf(m, "%-10llu %-8d %-16s %-4d %-5u %s\n",
+                           event->event_id, event->pid, event->comm, event->type,
+                           event->threat_score, buf);
+            }
+        }
+        spin_unlock_irqrestore(&store->lock, flags);
+    }
+    
     return 0;
 }
 
-static int ai_security_proc_show_profiles(struct seq_file *m, void *v)
+/*
+ * One profile per seq_file record, so a large table streams through the
+ * read buffer instead of being re-rendered into doubling single_open()
+ * buffers until it fits. The list head stands for the header lines.
+ */
+static void *ai_security_profiles_start(struct seq_file *m, loff_t *pos)
+    __acquires(RCU)
+{
+    rcu_read_lock();
+    return seq_list_start_head_rcu(&ai_sec_mgr->process_profiles, *pos);
+}
+
+static void *ai_security_profiles_next(struct seq_file *m, void *v, loff_t *pos)
+{
+    return seq_list_next_rcu(v, &ai_sec_mgr->process_profiles, pos);
+}
+
+static void ai_security_profiles_stop(struct seq_file *m, void *v)
+    __releases(RCU)
+{
+    rcu_read_unlock();
+}
+
+static int ai_security_profiles_show(struct seq_file *m, void *v)
 {
     struct ai_security_profile *profile;
+    u32 trust;
     
-    if (!ai_sec_mgr) {
-        seq_printf(m, "AI Security Manager not initialized\n");
+    if (v == &ai_sec_mgr->process_profiles) {
+        seq_printf(m, "=== Security Profiles ===\n");
+        seq_printf(m, "PID\tName\t\tThreat\tTrust\tAnomalies\tStatus\n");
+        seq_printf(m, "--------------------------------------------------------\n");
         return 0;
     }
     
-    seq_printf(m, "=== Security Profiles ===\n");
-    seq_printf(m, "PID\tName\t\tThreat\tTrust\tAnomalies\tStatus\n");
-    seq_printf(m, "--------------------------------------------------------\n");
+    profile = list_entry(v, struct ai_security_profile, list);
+    trust = ai_security_trust_pct(profile);
+    /* No float conversions in the kernel's printf; "0.70" by hand */
+    seq_printf(m, "%d\t%-15s\t%u\t%u.%02u\t%u\t\t%s\n",
+              profile->pid, profile->comm, profile->threat_score,
+              trust / 100, trust % 100, profile->anomaly_count,
+              profile->quarantined ? "Quarantined" : 
+              profile->under_observation ? "Observed" : "Normal");
     
-    list_for_each_entry(profile, &ai_sec_mgr->process_profiles, list) {
-        seq_printf(m, "%d\t%-15s\t%u\t%.2f\t%u\t\t%s\n",
-                  profile->pid, profile->comm, profile->threat_score,
-                  profile->trust_score, profile->anomaly_count,
-                  profile->quarantined ? "Quarantined" : 
-                  profile->under_observation ? "Observed" : "Normal");
+    return 0;
+}
+
+static const struct seq_operations ai_security_profiles_seq_ops = {
+    .start  = ai_security_profiles_start,
+    .next   = ai_security_profiles_next,
+    .stop   = ai_security_profiles_stop,
+    .show   = ai_security_profiles_show,
+};
+
+static const char * const ai_security_net_action_names[AI_SECURITY_NET_MAX] = {
+    [AI_SECURITY_NET_ALLOW] = "allow",
+    [AI_SECURITY_NET_DENY]  = "deny",
+    [AI_SECURITY_NET_WATCH] = "watch",
+};
+
+static void ai_security_netpolicy_show_node(struct seq_file *m, struct ai_security_lpm_node *node)
+{
+    if (!node)
+        return;
+    
+    if (!(node->flags & AI_SECURITY_LPM_FLAG_IM)) {
+        if (ai_security_is_v4_mapped(&node->addr) && node->prefixlen >= 96)
+            seq_printf(m, "%s %pI4/%u\n", ai_security_net_action_names[node->action],
+                       &node->addr.s6_addr32[3], node->prefixlen - 96);
+        else
+            seq_printf(m, "%s %pI6c/%u\n", ai_security_net_action_names[node->action],
+                       &node->addr, node->prefixlen);
+    }
+    
+    ai_security_netpolicy_show_node(m, rcu_dereference_protected(node->child[0],
+                                        lockdep_is_held(&ai_sec_mgr->net_lock)));
+    ai_security_netpolicy_show_node(m, rcu_dereference_protected(node->child[1],
+                                        lockdep_is_held(&ai_sec_mgr->net_lock)));
+}
+
+static int ai_security_proc_show_netpolicy(struct seq_file *m, void *v)
+{
+    mutex_lock(&ai_sec_mgr->net_lock);
+    seq_printf(m, "# %u rules; write \"allow|deny|watch <addr>[/len]\" or \"clear\"\n",
+               ai_sec_mgr->net_rules);
+    ai_security_netpolicy_show_node(m, rcu_dereference_protected(ai_sec_mgr->net_root,
+                                        lockdep_is_held(&ai_sec_mgr->net_lock)));
+    mutex_unlock(&ai_sec_mgr->net_lock);
+    
+    return 0;
+}
+
+static int ai_security_proc_open_netpolicy(struct inode *inode, struct file *file)
+{
+    return single_open(file, ai_security_proc_show_netpolicy, NULL);
+}
+
+static ssize_t ai_security_proc_write_netpolicy(struct file *file, const char __user *ubuf,
+                                                size_t count, loff_t *ppos)
+{
+    char buf[INET6_ADDRSTRLEN + 16], *cmd, *arg, *slash;
+    struct in6_addr addr;
+    u32 len, max_len;
+    bool v4;
+    int action, ret;
+    
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+    
+    cmd = strim(buf);
+    if (!strcmp(cmd, "clear")) {
+        ai_security_net_clear();
+        return count;
+    }
+    
+    arg = strchr(cmd, ' ');
+    if (!arg)
+        return -EINVAL;
+    *arg++ = '\0';
+    arg = skip_spaces(arg);
+    
+    action = match_string(ai_security_net_action_names, AI_SECURITY_NET_MAX, cmd);
+    if (action < 0)
+        return -EINVAL;
+    
+    slash = strchr(arg, '/');
+    if (slash)
+        *slash++ = '\0';
+    
+    v4 = !strchr(arg, ':');
+    if (!ai_security_parse_ip(arg, &addr))
+        return -EINVAL;
+    
+    max_len = v4 ? 32 : 128;
+    len = max_len;
+    if (slash && (kstrtou32(slash, 10, &len) || len > max_len))
+        return -EINVAL;
+    
+    ret = ai_security_net_insert(&addr, v4 ? 96 + len : len, action);
+    return ret ? ret : count;
+}
+
+static int ai_security_proc_show_intel(struct seq_file *m, void *v)
+{
+    struct ai_threat_intelligence *ti = &ai_sec_mgr->threat_intel;
+    const struct ai_security_intel *intel;
+    
+    rcu_read_lock();
+    intel = rcu_dereference(ai_sec_mgr->intel);
+    if (intel) {
+        seq_printf(m, "Generation: %llu\n", intel->generation);
+        seq_printf(m, "Published: %lld ms ago\n",
+                   ktime_to_ms(ktime_sub(ai_security_get_current_time(), intel->published)));
+        seq_printf(m, "Patterns: %u (%u states)\n", intel->matcher->nr_patterns,
+                   intel->matcher->nr_states);
+        seq_printf(m, "Malware Hashes: %u\n", intel->malware_set->nr);
+        seq_printf(m, "Malicious IPs: %u\n", intel->ip_set->nr);
     }
+    rcu_read_unlock();
+    
+    mutex_lock(&ai_sec_mgr->intel_lock);
+    seq_printf(m, "Staged: %u hashes, %u IPs, %u paths, %u commands\n",
+               ti->malware_count, ti->malicious_ip_count,
+               ti->suspicious_path_count, ti->suspicious_command_count);
+    mutex_unlock(&ai_sec_mgr->intel_lock);
     
     return 0;
 }
 
+static int ai_security_proc_open_intel(struct inode *inode, struct file *file)
+{
+    return single_open(file, ai_security_proc_show_intel, NULL);
+}
+
+/* Lines are staged as they arrive; "commit" publishes the next generation */
+static ssize_t ai_security_proc_write_intel(struct file *file, const char __user *ubuf,
+                                            size_t count, loff_t *ppos)
+{
+    char *buf, *line, *next;
+    int ret = 0;
+    
+    if (count > PAGE_SIZE)
+        count = PAGE_SIZE;
+    
+    buf = memdup_user_nul(ubuf, count);
+    if (IS_ERR(buf))
+        return PTR_ERR(buf);
+    
+    /* Only whole lines are consumed; a partial tail is written again */
+    next = strrchr(buf, '\n');
+    if (next)
+        count = next - buf + 1;
+    next = buf;
+    buf[count] = '\0';
+    
+    mutex_lock(&ai_sec_mgr->intel_lock);
+    while ((line = strsep(&next, "\n")) && !ret)
+        ret = ai_security_feed_line(line);
+    mutex_unlock(&ai_sec_mgr->intel_lock);
+    
+    kfree(buf);
+    return ret ? ret : count;
+}
+
+static const struct proc_ops ai_security_intel_ops = {
+    .proc_open      = ai_security_proc_open_intel,
+    .proc_read      = seq_read,
+    .proc_write     = ai_security_proc_write_intel,
+    .proc_lseek     = seq_lseek,
+    .proc_release   = single_release,
+};
+
+static const struct proc_ops ai_security_netpolicy_ops = {
+    .proc_open      = ai_security_proc_open_netpolicy,
+    .proc_read      = seq_read,
+    .proc_write     = ai_security_proc_write_netpolicy,
+    .proc_lseek     = seq_lseek,
+    .proc_release   = single_release,
+};
+
 static int ai_security_proc_init(void)
 {
     if (!ai_sec_mgr)
@@ -826,13 +4025,41 @@ static int ai_security_proc_init(void)
     if (!ai_sec_mgr->proc_stats)
         goto cleanup_stats;
     
-    ai_sec_mgr->proc_profiles = proc_create_single("profiles", 0444, ai_sec_mgr->proc_dir,
-                                                  ai_security_proc_show_profiles);
+    ai_sec_mgr->proc_profiles = proc_create_seq("profiles", 0444, ai_sec_mgr->proc_dir,
+                                               &ai_security_profiles_seq_ops);
     if (!ai_sec_mgr->proc_profiles)
         goto cleanup_profiles;
     
+    ai_sec_mgr->proc_netpolicy = proc_create("netpolicy", 0600, ai_sec_mgr->proc_dir,
+                                             &ai_security_netpolicy_ops);
+    if (!ai_sec_mgr->proc_netpolicy)
+        goto cleanup_netpolicy;
+    
+    ai_sec_mgr->proc_intel = proc_create("intel", 0600, ai_sec_mgr->proc_dir,
+                                         &ai_security_intel_ops);
+    if (!ai_sec_mgr->proc_intel)
+        goto cleanup_intel;
+    
+    ai_sec_mgr->proc_events = proc_create_single("events", 0400, ai_sec_mgr->proc_dir,
+                                                ai_security_proc_show_events);
+    if (!ai_sec_mgr->proc_events)
+        goto cleanup_events;
+    
+    ai_sec_mgr->proc_history = proc_create_seq("history", 0400, ai_sec_mgr->proc_dir,
+                                               &ai_security_history_seq_ops);
+    if (!ai_sec_mgr->proc_history)
+        goto cleanup_history;
+    
     return 0;
     
+cleanup_history:
+    remove_proc_entry("events", ai_sec_mgr->proc_dir);
+cleanup_events:
+    remove_proc_entry("intel", ai_sec_mgr->proc_dir);
+cleanup_intel:
+    remove_proc_entry("netpolicy", ai_sec_mgr->proc_dir);
+cleanup_netpolicy:
+    remove_proc_entry("profiles", ai_sec_mgr->proc_dir);
 cleanup_profiles:
     remove_proc_entry("stats", ai_sec_mgr->proc_dir);
 cleanup_stats:
@@ -845,6 +4072,14 @@ static void ai_security_proc_cleanup(void)
     if (!ai_sec_mgr)
         return;
     
+    if (ai_sec_mgr->proc_history)
+        remove_proc_entry("history", ai_sec_mgr->proc_dir);
+    if (ai_sec_mgr->proc_events)
+        remove_proc_entry("events", ai_sec_mgr->proc_dir);
+    if (ai_sec_mgr->proc_intel)
+        remove_proc_entry("intel", ai_sec_mgr->proc_dir);
+    if (ai_sec_mgr->proc_netpolicy)
+        remove_proc_entry("netpolicy", ai_sec_mgr->proc_dir);
     if (ai_sec_mgr->proc_profiles)
         remove_proc_entry("profiles", ai_sec_mgr->proc_dir);
     if (ai_sec_mgr->proc_stats)
@@ -859,34 +4094,119 @@ static void ai_security_free_event(struct ai_security_event *event)
     if (!event)
         return;
     
-    kfree(event->description);
-    kfree(event->explanation);
-    kfree(event->executable_path);
-    kfree(event->related_processes);
-    kfree(event->event_data);
-    kfree(event);
+    if (event->event_data != event->data)
+        kfree(event->event_data);
+    kmem_cache_free(ai_sec_mgr->event_cache, event);
 }
 
 static void ai_security_free_profile(struct ai_security_profile *profile)
 {
-    int i;
-    
     if (!profile)
         return;
     
-    kfree(profile->executable_path);
+    ai_security_put_path(profile->exe);
+    if (profile->features)
+        aurora_task_features_put(profile->features);
+    kmem_cache_free(ai_sec_mgr->profile_cache, profile);
+}
+
+/*
+ * Control plane. The policy is a few words, so a staged configuration
+ * is just their new values; commit moves the policy generation once for
+ * the lot, like a write to either parameter.
+ */
+struct ai_security_control {
+    u32 threat_threshold;
+    u32 core_isolate_trust;
+    bool auto_response;
+    bool learning;
+    bool has_threshold;
+    bool has_auto_response;
+    bool has_learning;
+    bool has_core_isolate_trust;
+};
+
+static const struct nla_policy ai_security_control_policy[AURORA_AI_SECURITY_MAX + 1] = {
+    [AURORA_AI_SECURITY_THREAT_THRESHOLD] = NLA_POLICY_MAX(NLA_U32, 100),
+    [AURORA_AI_SECURITY_AUTO_RESPONSE]    = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_SECURITY_LEARNING]         = NLA_POLICY_MAX(NLA_U8, 1),
+    [AURORA_AI_SECURITY_CORE_ISOLATE_TRUST] = NLA_POLICY_MAX(NLA_U32, 100),
+};
+
+static void *ai_security_control_prepare(const struct nlattr *nest,
+                                         struct netlink_ext_ack *extack)
+{
+    struct nlattr *tb[AURORA_AI_SECURITY_MAX + 1];
+    struct ai_security_control *ctl;
+    int ret;
+    
+    ret = nla_parse_nested(tb, AURORA_AI_SECURITY_MAX, nest,
+                           ai_security_control_policy, extack);
+    if (ret)
+        return ERR_PTR(ret);
+    
+    ctl = kzalloc(sizeof(*ctl), GFP_KERNEL);
+    if (!ctl)
+        return ERR_PTR(-ENOMEM);
     
-    for (i = 0; i < profile->allowed_path_count; i++) {
-        kfree(profile->allowed_paths[i]);
+    if (tb[AURORA_AI_SECURITY_THREAT_THRESHOLD]) {
+        ctl->threat_threshold = nla_get_u32(tb[AURORA_AI_SECURITY_THREAT_THRESHOLD]);
+        ctl->has_threshold = true;
+    }
+    if (tb[AURORA_AI_SECURITY_AUTO_RESPONSE]) {
+        ctl->auto_response = nla_get_u8(tb[AURORA_AI_SECURITY_AUTO_RESPONSE]);
+        ctl->has_auto_response = true;
+    }
+    if (tb[AURORA_AI_SECURITY_LEARNING]) {
+        ctl->learning = nla_get_u8(tb[AURORA_AI_SECURITY_LEARNING]);
+        ctl->has_learning = true;
+    }
+    if (tb[AURORA_AI_SECURITY_CORE_ISOLATE_TRUST]) {
+        ctl->core_isolate_trust = nla_get_u32(tb[AURORA_AI_SECURITY_CORE_ISOLATE_TRUST]);
+        ctl->has_core_isolate_trust = true;
     }
     
-    for (i = 0; i < profile->network_endpoint_count; i++) {
-        kfree(profile->network_endpoints[i]);
+    return ctl;
+}
+
+static void ai_security_control_commit(void *staged)
+{
+    struct ai_security_control *ctl = staged;
+    
+    if (ctl->has_threshold)
+        WRITE_ONCE(ai_security_threat_threshold, ctl->threat_threshold);
+    if (ctl->has_auto_response)
+        WRITE_ONCE(ai_security_auto_response, ctl->auto_response);
+    if (ctl->has_threshold || ctl->has_auto_response)
+        atomic_inc(&ai_security_policy_gen);
+    
+    /* Tiers follow as the learning pass visits each profile */
+    if (ctl->has_core_isolate_trust)
+        WRITE_ONCE(ai_security_core_isolate_trust, ctl->core_isolate_trust);
+    
+    if (ctl->has_learning) {
+        WRITE_ONCE(ai_security_learning_enabled, ctl->learning);
+        if (ctl->learning)
+            static_branch_enable(&ai_security_learning_key);
+        else
+            static_branch_disable(&ai_security_learning_key);
     }
     
-    kfree(profile);
+    kfree(ctl);
+}
+
+static void ai_security_control_abort(void *staged)
+{
+    kfree(staged);
 }
 
+static const struct aurora_ai_control_ops ai_security_control_ops = {
+    .attr = AURORA_AI_ATTR_SECURITY,
+    .prepare = ai_security_control_prepare,
+    .commit = ai_security_control_commit,
+    .abort = ai_security_control_abort,
+};
+
 /* Module Initialization */
 static int __init ai_security_init(void)
 {
@@ -903,9 +4223,26 @@ static int __init ai_security_init(void)
     
     /* Initialize security manager */
     INIT_LIST_HEAD(&ai_sec_mgr->process_profiles);
-    INIT_LIST_HEAD(&ai_sec_mgr->recent_events);
     spin_lock_init(&ai_sec_mgr->profiles_lock);
-    spin_lock_init(&ai_sec_mgr->events_lock);
+    init_llist_head(&ai_sec_mgr->retired_profiles);
+    init_llist_head(&ai_sec_mgr->dead_profiles);
+    INIT_WORK(&ai_sec_mgr->reap_work, ai_security_reap_work);
+    mutex_init(&ai_sec_mgr->net_lock);
+    mutex_init(&ai_sec_mgr->intel_lock);
+    
+    /* Initialize object caches */
+    ai_sec_mgr->event_cache = KMEM_CACHE(ai_security_event, 0);
+    ai_sec_mgr->profile_cache = KMEM_CACHE(ai_security_profile, SLAB_HWCACHE_ALIGN | SLAB_ACCOUNT);
+    if (!ai_sec_mgr->event_cache || !ai_sec_mgr->profile_cache) {
+        pr_err("AI Security: Failed to create object caches\n");
+        ret = -ENOMEM;
+        goto err_caches;
+    }
+    
+    spin_lock_init(&ai_sec_mgr->paths_lock);
+    INIT_LIST_HEAD(&ai_sec_mgr->baselines);
+    for (i = 0; i < ARRAY_SIZE(ai_sec_mgr->path_hash); i++)
+        INIT_HLIST_HEAD(&ai_sec_mgr->path_hash[i]);
     
     /* Initialize hash tables */
     for (i = 0; i < AI_SECURITY_HASH_SIZE; i++) {
@@ -915,44 +4252,135 @@ static int __init ai_security_init(void)
     }
     
     /* Initialize statistics */
-    ai_sec_mgr->total_events_processed = 0;
-    ai_sec_mgr->threats_detected = 0;
-    ai_sec_mgr->false_positives = 0;
-    ai_sec_mgr->threats_blocked = 0;
+    ai_sec_mgr->stats = alloc_percpu(struct ai_security_cpu_stats);
+    if (!ai_sec_mgr->stats) {
+        pr_err("AI Security: Failed to allocate statistics\n");
+        ret = -ENOMEM;
+        goto err_caches;
+    }
     ai_sec_mgr->processes_monitored = 0;
     
-    /* Initialize learning timer */
-    timer_setup(&ai_sec_mgr->learning_timer, ai_security_learning_timer_callback, 0);
-    if (ai_security_learning_enabled) {
-        mod_timer(&ai_sec_mgr->learning_timer, 
-                  jiffies + msecs_to_jiffies(AI_SECURITY_LEARNING_INTERVAL));
+    /* Initialize the retained-event store and the compact history */
+    ret = ai_security_alloc_event_stores();
+    if (ret)
+        goto err_stats;
+    
+    BUILD_BUG_ON(sizeof(struct ai_security_record) != 64);
+    BUILD_BUG_ON(sizeof(struct ai_security_history_header) != sizeof(struct ai_security_record));
+    ret = ai_security_alloc_history();
+    if (ret)
+        goto err_stores;
+    
+    ret = ai_security_alloc_baseline_batches();
+    if (ret)
+        goto err_history;
+    
+    ret = ai_security_alloc_dirty_lists();
+    if (ret)
+        goto err_batches;
+    
+    /* Compile the path and command patterns */
+    mutex_lock(&ai_sec_mgr->intel_lock);
+    ret = ai_security_intel_commit();
+    mutex_unlock(&ai_sec_mgr->intel_lock);
+    if (ret)
+        goto err_matcher;
+    
+    /* Initialize the deep-analysis queue and the alert ring */
+    ret = ai_security_alloc_deep_rings();
+    if (ret)
+        goto err_matcher;
+    
+    ret = ai_security_alloc_alert_ring();
+    if (ret)
+        goto err_rings;
+    
+    ai_sec_mgr->deep_wq = alloc_workqueue("ai_security_deep", WQ_UNBOUND, 0);
+    if (!ai_sec_mgr->deep_wq) {
+        ret = -ENOMEM;
+        goto err_rings;
     }
+    INIT_WORK(&ai_sec_mgr->deep_work, ai_security_deep_work);
+    
+    /*
+     * Initialize learning timer. It runs even with learning off, to
+     * release the dirty profiles queued while learning was on.
+     */
+    INIT_WORK(&ai_sec_mgr->learning_work, ai_security_learning_work);
+    timer_setup(&ai_sec_mgr->learning_timer, ai_security_learning_timer_callback, 0);
+    mod_timer(&ai_sec_mgr->learning_timer,
+              jiffies + msecs_to_jiffies(AI_SECURITY_LEARNING_INTERVAL));
     
     /* Initialize ProcFS interface */
     ret = ai_security_proc_init();
     if (ret) {
         pr_err("AI Security: Failed to initialize ProcFS interface\n");
-        kfree(ai_sec_mgr);
-        return ret;
+        del_timer_sync(&ai_sec_mgr->learning_timer);
+        cancel_work_sync(&ai_sec_mgr->learning_work);
+        goto err_wq;
+    }
+    
+    /* Expose the decision path to BPF LSM programs */
+    ret = ai_security_register_kfuncs();
+    if (ret) {
+        pr_err("AI Security: Failed to register BPF kfuncs: %d\n", ret);
+        ai_security_proc_cleanup();
+        del_timer_sync(&ai_sec_mgr->learning_timer);
+        cancel_work_sync(&ai_sec_mgr->learning_work);
+        goto err_wq;
     }
     
-    /* Register LSM hooks */
-    security_add_hooks(ai_security_hooks, ARRAY_SIZE(ai_security_hooks), "ai_security");
+    /* Register LSM hooks, unless BPF programs make the decisions */
+    if (ai_security_learning_enabled)
+        static_branch_enable(&ai_security_learning_key);
+    if (!ai_security_offload) {
+        security_add_hooks(ai_security_hooks, ARRAY_SIZE(ai_security_hooks), "ai_security");
+        static_branch_enable(&ai_security_hooks_active);
+    }
+    
+    /* The parameters stay writable without it */
+    ret = aurora_ai_register_control(&ai_security_control_ops);
+    if (ret)
+        pr_warn("AI Security: Control plane unavailable: %d\n", ret);
     
     pr_info("AI Security: Successfully initialized\n");
-    pr_info("AI Security: Threat threshold: %u, Auto response: %s, Learning: %s\n",
+    pr_info("AI Security: Threat threshold: %u, Auto response: %s, Learning: %s, Hooks: %s\n",
             ai_security_threat_threshold,
             ai_security_auto_response ? "Enabled" : "Disabled",
-            ai_security_learning_enabled ? "Enabled" : "Disabled");
+            ai_security_learning_enabled ? "Enabled" : "Disabled",
+            ai_security_offload ? "BPF" : "Built-in");
     
     return 0;
+    
+err_wq:
+    destroy_workqueue(ai_sec_mgr->deep_wq);
+err_rings:
+    kvfree(ai_sec_mgr->alerts.records);
+    ai_security_free_deep_rings();
+err_matcher:
+    ai_security_intel_free(rcu_dereference_protected(ai_sec_mgr->intel, true));
+    ai_security_free_dirty_lists();
+err_batches:
+    ai_security_free_baseline_batches();
+err_history:
+    ai_security_free_history();
+err_stores:
+    free_percpu(ai_sec_mgr->event_stores);
+err_stats:
+    free_percpu(ai_sec_mgr->stats);
+err_caches:
+    kmem_cache_destroy(ai_sec_mgr->profile_cache);
+    kmem_cache_destroy(ai_sec_mgr->event_cache);
+    kfree(ai_sec_mgr);
+    ai_sec_mgr = NULL;
+    return ret;
 }
 
 /* Module Cleanup */
 static void __exit ai_security_exit(void)
 {
     struct ai_security_profile *profile, *tmp;
-    struct ai_security_event *event, *event_tmp;
+    struct ai_security_path *path, *next;
     unsigned long flags;
     int i;
     
@@ -961,27 +4389,61 @@ static void __exit ai_security_exit(void)
     
     pr_info("AI Security: Shutting down\n");
     
-    /* Cancel learning timer */
+    aurora_ai_unregister_control(&ai_security_control_ops);
+    
+    /* New hook calls return at once from here; wait out the running ones */
+    static_branch_disable(&ai_security_hooks_active);
+    synchronize_srcu(&ai_security_hooks_srcu);
+    
+    /* Cancel learning timer, then the pass it may have queued */
     del_timer_sync(&ai_sec_mgr->learning_timer);
+    cancel_work_sync(&ai_sec_mgr->learning_work);
+    
+    /* Clean up ProcFS interface first; no readers or feed writes after this */
+    ai_security_proc_cleanup();
+    
+    /* Finish queued deep analysis and alerts before profiles go away */
+    flush_workqueue(ai_sec_mgr->deep_wq);
+    destroy_workqueue(ai_sec_mgr->deep_wq);
+    ai_security_free_deep_rings();
+    kvfree(ai_sec_mgr->alerts.records);
     
-    /* Clean up all profiles */
+    /* Clean up all profiles, retired ones first */
+    ai_security_free_baseline_batches();
+    ai_security_free_dirty_lists();
+    ai_security_reap_profiles();
     list_for_each_entry_safe(profile, tmp, &ai_sec_mgr->process_profiles, list) {
+        /* Isolation is policy of this module; it goes with it */
+        if (profile->core_isolated)
+            ai_security_core_apply(profile, false);
         list_del(&profile->list);
         hlist_del_rcu(&profile->hash);
         ai_security_free_profile(profile);
     }
     
-    /* Clean up all events */
-    list_for_each_entry_safe(event, event_tmp, &ai_sec_mgr->recent_events, list) {
-        list_del(&event->list);
-        hlist_del_rcu(&event->hash);
-        ai_security_free_event(event);
+    /* Unpin the executable baselines */
+    list_for_each_entry_safe(path, next, &ai_sec_mgr->baselines, baseline_node) {
+        list_del_init(&path->baseline_node);
+        ai_security_put_path(path);
     }
     
-    /* Clean up ProcFS interface */
-    ai_security_proc_cleanup();
+    /* Clean up all events */
+    ai_security_expire_events(ai_security_get_current_time(), true);
+    free_percpu(ai_sec_mgr->event_stores);
+    ai_security_free_history();
+    
+    /* Retired intelligence generations are freed by the barrier below */
+    ai_security_intel_free(rcu_dereference_protected(ai_sec_mgr->intel, true));
+    ai_security_feed_reset(&ai_sec_mgr->threat_intel);
+    rcu_barrier();
+    
+    /* Drop the connect policy */
+    ai_security_net_clear();
     
     /* Free security manager */
+    free_percpu(ai_sec_mgr->stats);
+    kmem_cache_destroy(ai_sec_mgr->profile_cache);
+    kmem_cache_destroy(ai_sec_mgr->event_cache);
     kfree(ai_sec_mgr);
     ai_sec_mgr = NULL;
     
@@ -994,4 +4456,8 @@ module_exit(ai_security_exit);
 
 /* Module Information */
 MODULE_ALIAS("ai_security");
-MODULE_ALIAS("aurora-ai-security");
\ No newline at end of file
+MODULE_ALIAS("aurora-ai-security");
+
+#ifdef CONFIG_AURORA_AI_KUNIT_TEST
+#include "tests/ai_security_kunit.c"
+#endif
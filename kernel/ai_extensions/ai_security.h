@@ -26,15 +26,25 @@
 #include <linux/lsm_hooks.h>
 #include <linux/audit.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/spinlock.h>
+#include <linux/seqlock.h>
 #include <linux/rbtree.h>
 #include <linux/hash.h>
+#include <linux/refcount.h>
+#include <linux/slab.h>
+#include <linux/in6.h>
+#include <linux/mutex.h>
+#include <linux/net.h>
 #include <linux/random.h>
 #include <crypto/hash.h>
 #include <linux/timekeeping.h>
 #include <linux/jiffies.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
+#include <linux/workqueue.h>
+
+struct aurora_task_features;
 
 /* Security Module Configuration */
 #define AI_SECURITY_MAX_PROFILES        256
@@ -42,9 +52,39 @@
 #define AI_SECURITY_THREAT_SCORE_THRESHOLD    75
 #define AI_SECURITY_LEARNING_INTERVAL  5000   /* milliseconds */
 #define AI_SECURITY_BASELINE_PERIOD     300000 /* milliseconds (5 minutes) */
-#define AI_SECURITY_MAX_PROCESSES       2048
+#define AI_SECURITY_MAX_PROCESSES       2048   /* profile budget; least recently used are evicted */
+#define AI_SECURITY_EVICT_SCAN          32     /* profiles scanned for an eviction victim */
+#define AI_SECURITY_MAX_BASELINES       256    /* executables whose baseline outlives their processes */
 #define AI_SECURITY_MAX_EVENTS_PER_PROCESS   100
-#define AI_SECURITY_HASH_SIZE           256
+#define AI_SECURITY_HASH_BITS           8
+#define AI_SECURITY_HASH_SIZE           (1 << AI_SECURITY_HASH_BITS)
+#define AI_SECURITY_EVENT_BUCKETS       60     /* retained-event buckets per CPU */
+#define AI_SECURITY_EVENT_BUCKET_MS     60000  /* one bucket per minute: one hour kept */
+#define AI_SECURITY_VERDICT_BITS        3      /* 8 cached file verdicts per profile */
+#define AI_SECURITY_DEEP_RING_SIZE      1024   /* deep-analysis records per CPU, power of two */
+#define AI_SECURITY_DEEP_BATCH          64     /* records per deep-analysis batch */
+#define AI_SECURITY_DESC_LEN            64     /* inline event description */
+#define AI_SECURITY_DATA_LEN            48     /* inline event data; longer data is allocated */
+#define AI_SECURITY_PATH_HASH_BITS      6
+#define AI_SECURITY_BLOOM_HASHES        5      /* probes per bloom lookup */
+#define AI_SECURITY_BLOOM_BITS_PER_KEY  10     /* ~1% false positives */
+#define AI_SECURITY_MAX_ENDPOINTS       32     /* baseline networks per executable */
+#define AI_SECURITY_BASELINE_BATCH      16     /* learnt endpoints batched per CPU */
+#define AI_SECURITY_ALERT_RING_SIZE     256    /* pending alerts, power of two */
+#define AI_SECURITY_ALERT_BURST         10     /* alerts a profile may emit at once */
+#define AI_SECURITY_ALERT_RATE_MS       1000   /* one token back per interval */
+#define AI_SECURITY_ALERT_COALESCE_MS   5000   /* identical alerts folded within */
+#define AI_SECURITY_CHUNK_RECORDS       255    /* history records per 16 KiB chunk */
+#define AI_SECURITY_HISTORY_CHUNKS      64     /* chunks kept per CPU */
+#define AI_SECURITY_HISTORY_MAGIC       0x48454941 /* "AIEH" */
+#define AI_SECURITY_HISTORY_VERSION     1
+
+/* Trust, risk and behavior scores are fixed point, 1.0 being ONE */
+#define AI_SECURITY_SCORE_SHIFT         10     /* as AURORA_FEATURE_SHIFT */
+#define AI_SECURITY_SCORE_ONE           (1U << AI_SECURITY_SCORE_SHIFT)
+#define AI_SECURITY_SCORE(pct)          ((pct) * AI_SECURITY_SCORE_ONE / 100)
+#define AI_SECURITY_CORE_ISOLATE_TRUST  30     /* percent trust below which a task gets its own core */
+#define AI_SECURITY_CORE_HYSTERESIS     10     /* percent trust above the bar to share again */
 
 /* Security Event Types */
 enum ai_security_event_type {
@@ -67,6 +107,36 @@ enum ai_security_threat_level {
     AI_SECURITY_THREAT_CRITICAL
 };
 
+/*
+ * Rules that contribute to a threat score. Events carry these codes
+ * with their points; text is rendered only when someone reads it.
+ */
+enum ai_security_reason {
+    AI_SECURITY_REASON_NONE = 0,
+    AI_SECURITY_REASON_NO_PROFILE,
+    AI_SECURITY_REASON_SENSITIVE_PATH,
+    AI_SECURITY_REASON_INTEL_PATH,
+    AI_SECURITY_REASON_EXCESSIVE_CONNECTS,
+    AI_SECURITY_REASON_MALICIOUS_IP,
+    AI_SECURITY_REASON_PRIVILEGE_ESCALATION,
+    AI_SECURITY_REASON_TEMP_EXEC,
+    AI_SECURITY_REASON_INTEL_EXEC,
+    AI_SECURITY_REASON_MALWARE_HASH,
+    AI_SECURITY_REASON_LOW_TRUST,
+    AI_SECURITY_REASON_ANOMALY_HISTORY,
+    AI_SECURITY_REASON_NET_WATCH,
+    AI_SECURITY_REASON_NET_NOVEL,
+    AI_SECURITY_REASON_BPF_RULES,
+    AI_SECURITY_REASON_MAX
+};
+
+#define AI_SECURITY_MAX_REASONS         6
+
+struct ai_security_reason_code {
+    u8 rule;                           /* enum ai_security_reason */
+    u8 points;                         /* Contribution to threat_score */
+};
+
 /* Security Action Types */
 enum ai_security_action {
     AI_SECURITY_ACTION_ALLOW = 0,
@@ -90,21 +160,22 @@ struct ai_security_event {
     uid_t uid;                         /* User ID */
     gid_t gid;                         /* Group ID */
     char comm[TASK_COMM_LEN];          /* Process name */
-    char *executable_path;             /* Path to executable */
     
     /* Event Details */
-    char *description;                 /* Human-readable description */
+    char description[AI_SECURITY_DESC_LEN]; /* Human-readable description */
     void *event_data;                  /* Type-specific event data */
+    u8 file_label;                     /* AI_SECURITY_LABEL_* of the file, if known */
     size_t data_size;                  /* Size of event data */
+    char data[AI_SECURITY_DATA_LEN];   /* Inline storage for short event_data */
     
     /* Security Assessment */
     enum ai_security_threat_level threat_level;
     u32 threat_score;                  /* 0-100 threat score */
     enum ai_security_action recommended_action;
-    char *explanation;                 /* AI-generated explanation */
+    u8 nr_reasons;
+    struct ai_security_reason_code reasons[AI_SECURITY_MAX_REASONS];
     
     /* Context Information */
-    char *related_processes;           /* Related process information */
     struct list_head related_events;   /* Linked related events */
     
     /* Metadata */
@@ -113,41 +184,116 @@ struct ai_security_event {
     bool escalated;                    /* Escalated to human analyst */
     
     /* List Management */
-    struct list_head list;
+    struct list_head list;             /* Time bucket linkage */
     struct hlist_node hash;            /* Hash table linkage */
+    struct rcu_head rcu;               /* Deferred free; lookups are lockless */
+};
+
+/*
+ * Cached file_permission verdict. The name hash is part of the key
+ * because the analysis looks at the name, not just the inode.
+ */
+struct ai_security_verdict {
+    const struct inode *inode;
+    u64 name_hash_len;                 /* d_name.hash_len at analysis time */
+    u32 gen;                           /* Policy generation of the verdict */
+    int mask;
+    bool deny;
+    u8 label;                          /* AI_SECURITY_LABEL_*, set at open */
+    u32 label_gen;                     /* Intelligence generation of label */
+};
+
+/*
+ * File labels. Computed once per open from the full path, so a name is
+ * never ambiguous across directories, and read by file_permission
+ * instead of copying the dentry name.
+ */
+#define AI_SECURITY_LABEL_SENSITIVE      BIT(0)
+#define AI_SECURITY_LABEL_TEMP           BIT(1)
+#define AI_SECURITY_LABEL_SYSTEM_BIN     BIT(2)
+#define AI_SECURITY_LABEL_INTEL          BIT(3)
+#define AI_SECURITY_LABEL_VALID          BIT(7)
+
+/*
+ * Behavioural baseline of one executable, shared by all its processes.
+ * The baseline period starts with the first of them, and what any of
+ * them learns is batched per CPU and merged here, so later processes
+ * are judged against the converged baseline from their first event.
+ * Hooks read the endpoint set under the seqcount; everything else is
+ * under the lock.
+ */
+struct ai_security_baseline {
+    spinlock_t lock;
+    seqcount_spinlock_t seq;
+    ktime_t started;                   /* First process of the binary */
+    
+    /* Network Baseline: sorted endpoint keys (an IPv4 /24 or IPv6 /63) */
+    u64 endpoints[AI_SECURITY_MAX_ENDPOINTS];
+    u32 nr_endpoints;
+    
+    /* History of the retired processes */
+    u32 profiles;                      /* Profiles folded in */
+    u32 anomalies;
+    u64 events;
+    u32 trust_score;                   /* Moving average of their trust */
+};
+
+/*
+ * Interned executable path, shared by every profile of the same binary
+ * and freed with its last reference. While on the baselines list the
+ * path holds a reference to itself, so its baseline outlives its
+ * processes.
+ */
+struct ai_security_path {
+    struct hlist_node node;
+    refcount_t ref;
+    u32 hash;
+    struct list_head baseline_node;    /* Under paths_lock */
+    struct ai_security_baseline baseline;
+    char name[];
 };
 
+/* Endpoints learnt on one CPU, not yet merged into their baselines */
+struct ai_security_baseline_batch {
+    spinlock_t lock;
+    u32 nr;
+    struct {
+        struct ai_security_path *exe;  /* Referenced */
+        u64 key;
+    } entries[AI_SECURITY_BASELINE_BATCH];
+};
+
+/* Profile flags */
+#define AI_SECURITY_PROFILE_DIRTY       0      /* Queued for the learning worker */
+
 /* Process Security Profile */
 struct ai_security_profile {
     /* Process Identification */
     pid_t pid;
+    u64 start_time;                    /* task->start_time, tells pid reuse apart */
     char comm[TASK_COMM_LEN];
-    char *executable_path;
+    struct ai_security_path *exe;      /* Interned executable path */
+    struct aurora_task_features *features; /* Shared per-task features, referenced */
     u32 executable_hash;               /* Hash of executable */
     
     /* Behavioral Baseline */
     u64 file_access_count;             /* Normal file access patterns */
-    u64 network_connection_count;
+    u64 network_connection_count;      /* Written only by the profiled task */
     u64 system_call_count;
     u64 privilege_escalation_count;
     
     /* Resource Usage Patterns */
     unsigned long avg_memory_usage;
     unsigned long max_memory_usage;
-    unsigned int avg_cpu_usage;
+    unsigned int avg_cpu_usage;        /* percent, from the shared features */
     unsigned int max_cpu_usage;
     
-    /* Access Patterns */
-    char *allowed_paths[32];           /* Normal file access paths */
-    u32 allowed_path_count;
-    char *network_endpoints[16];       /* Normal network endpoints */
-    u32 network_endpoint_count;
+    /* Network Baseline lives in exe->baseline */
     
     /* Time-based Patterns */
     ktime_t last_activity;
     ktime_t creation_time;
     u64 total_runtime;
-    u32 active_hours[24];              /* Activity by hour of day */
     
     /* Security Metrics */
     u32 anomaly_count;                 /* Number of anomalies detected */
@@ -156,73 +302,382 @@ struct ai_security_profile {
     u32 false_positive_count;          /* False positive history */
     
     /* ML Features */
-    float behavior_score;              /* 0.0-1.0 behavior normalcy score */
-    float risk_score;                  /* 0.0-1.0 risk assessment */
-    float trust_score;                 /* 0.0-1.0 trust level */
+    u32 behavior_score;                /* 0-ONE behavior normalcy score */
+    u32 risk_score;                    /* 0-ONE risk assessment */
+    u32 trust_score;                   /* 0-ONE trust level */
     
     /* Learning Data */
-    struct ai_security_event *recent_events[AI_SECURITY_MAX_EVENTS_PER_PROCESS];
     u32 event_count;
-    u32 event_index;
+    
+    /* Alert Rate Limiting (under lock) */
+    u32 alert_tokens;                  /* Token bucket, AI_SECURITY_ALERT_BURST deep */
+    ktime_t alert_refill;              /* Last token refill */
+    u32 alert_sig;                     /* Signature of the last emitted alert */
+    ktime_t alert_last;
+    u32 alert_repeats;                 /* Identical alerts folded since */
+    u32 alert_suppressed;              /* Alerts over the rate since */
+    
+    /* Verdict Cache (written only by the profiled task) */
+    u32 policy_gen;                    /* Bumped when trust/risk change */
+    struct ai_security_verdict verdicts[1 << AI_SECURITY_VERDICT_BITS];
     
     /* Security State */
     bool under_observation;            /* Under increased monitoring */
     bool quarantined;                  /* Process is quarantined */
     bool terminated;                   /* Process was terminated */
+    bool core_isolated;                /* Holds a core-scheduling cookie of its own */
+    
+    /* Lifetime */
+    refcount_t ref;                    /* One for the tables, one per user */
+    bool retired;                      /* Off the list, unhashed by the reaper */
+    bool referenced;                   /* Used since the last eviction scan */
+    struct llist_node retire_node;
+    struct llist_node free_node;
+    
+    /* Learning */
+    unsigned long flags;               /* AI_SECURITY_PROFILE_* bits */
+    struct llist_node dirty_node;      /* Holds a reference while queued */
     
     /* List and Lock Management */
-    struct list_head list;
+    struct list_head list;             /* RCU; writers take profiles_lock */
     struct hlist_node hash;
     spinlock_t lock;
 };
 
-/* Threat Intelligence Data */
+/*
+ * Threat Intelligence Feed. This is the staging copy written through
+ * /proc/ai_security/intel under intel_lock; hooks only ever read the
+ * compiled generation (struct ai_security_intel).
+ */
 struct ai_threat_intelligence {
     /* Known Malware Signatures */
     u32 *malware_hashes;               /* Hashes of known malware */
     u32 malware_count;
+    u32 malware_capacity;
     
     /* Suspicious Patterns */
-    char *suspious_paths[64];          /* Known suspicious file paths */
+    char **suspicious_paths;           /* Known suspicious file paths */
     u32 suspicious_path_count;
+    u32 suspicious_path_capacity;
     
     /* Network Threats */
-    char *malicious_ips[128];          /* Known malicious IP addresses */
+    char **malicious_ips;              /* Known malicious IP addresses */
     u32 malicious_ip_count;
+    u32 malicious_ip_capacity;
     
     /* Behavior Patterns */
-    char *suspicious_commands[32];     /* Suspicious command patterns */
+    char **suspicious_commands;        /* Suspicious command patterns */
     u32 suspicious_command_count;
+    u32 suspicious_command_capacity;
     
     /* Update Timestamps */
-    ktime_t last_update;
+    ktime_t last_update;               /* Last committed generation */
     ktime_t next_update;
 };
 
+/* Pattern classes reported by the matcher, one bit each */
+enum ai_security_match_class {
+    AI_SECURITY_MATCH_SENSITIVE = 0,   /* Sensitive file name */
+    AI_SECURITY_MATCH_TEMP_EXEC,       /* Temporary directory */
+    AI_SECURITY_MATCH_INTEL_PATH,      /* Threat intelligence: suspicious path */
+    AI_SECURITY_MATCH_INTEL_COMMAND,   /* Threat intelligence: suspicious command */
+    AI_SECURITY_MATCH_MAX
+};
+
+struct ai_security_pattern {
+    const char *str;
+    enum ai_security_match_class class;
+};
+
+/*
+ * Aho-Corasick automaton over every path and command pattern, compiled
+ * to a dense DFA. Bytes that occur in no pattern share class 0, so the
+ * table is nr_states x nr_classes and matching costs one load per input
+ * byte however many patterns there are. out[] holds the class mask of
+ * each state with the matches of its suffix states folded in.
+ */
+struct ai_security_matcher {
+    u32 nr_states;
+    u32 nr_classes;
+    u32 nr_patterns;
+    u16 byte_class[256];
+    u32 *next;                         /* nr_states * nr_classes */
+    u8 *out;                           /* Match-class mask per state */
+};
+
+/*
+ * Indicator-of-compromise set: malware hashes or IP addresses. A blocked
+ * bloom filter, where all probes of a key land in one 64-byte block,
+ * sits in front of a sorted key table. A negative lookup, the common
+ * case, touches a single cache line; only filter hits binary-search the
+ * table.
+ */
+struct ai_security_ioc_set {
+    u32 nr;                            /* Keys in the table */
+    u32 key_words;                     /* Key size in u32s */
+    u32 block_mask;                    /* Bloom blocks - 1, power of two */
+    u32 hash_seed;
+    u64 (*blocks)[8];                  /* 512-bit bloom blocks */
+    u32 *keys;                         /* nr keys, sorted */
+};
+
+/*
+ * One compiled generation of threat intelligence. Everything a hook
+ * consults is built off to the side and published with a single RCU
+ * pointer swap, so readers see either the old set or the new one, never
+ * a mix. The previous generation is freed with call_rcu.
+ */
+struct ai_security_intel {
+    u64 generation;
+    ktime_t published;
+    struct ai_security_matcher *matcher;   /* Paths and commands */
+    struct ai_security_ioc_set *malware_set; /* Malware hashes */
+    struct ai_security_ioc_set *ip_set;    /* Malicious IPs, IPv4 v4-mapped */
+    struct rcu_head rcu;
+};
+
+/* Network policy actions */
+enum ai_security_net_action {
+    AI_SECURITY_NET_ALLOW = 0,         /* Connect without analysis */
+    AI_SECURITY_NET_DENY,              /* Refuse the connect */
+    AI_SECURITY_NET_WATCH,             /* Analyse with a raised score */
+    AI_SECURITY_NET_MAX
+};
+
+/*
+ * Longest-prefix-match trie node for the connect policy, after
+ * kernel/bpf/lpm_trie.c. Keys are in6_addr; IPv4 is v4-mapped, so an
+ * IPv4 /n is stored as /96+n.
+ */
+#define AI_SECURITY_LPM_FLAG_IM         BIT(0) /* Intermediate node */
+
+struct ai_security_lpm_node {
+    struct rcu_head rcu;
+    struct ai_security_lpm_node __rcu *child[2];
+    u32 prefixlen;
+    u8 flags;
+    u8 action;                         /* enum ai_security_net_action */
+    struct in6_addr addr;
+};
+
+/* Per-CPU Statistics */
+enum ai_security_stat {
+    AI_SECURITY_STAT_EVENTS = 0,       /* Events analysed */
+    AI_SECURITY_STAT_THREATS_DETECTED,
+    AI_SECURITY_STAT_THREATS_BLOCKED,
+    AI_SECURITY_STAT_FALSE_POSITIVES,
+    AI_SECURITY_STAT_VERDICT_HITS,     /* file_permission cache hits */
+    AI_SECURITY_STAT_DEEP_ANALYSED,    /* Events scored by the deep tier */
+    AI_SECURITY_STAT_DEEP_DROPPED,     /* Deep-analysis ring was full */
+    AI_SECURITY_STAT_NET_DENIED,       /* Connects refused by policy */
+    AI_SECURITY_STAT_ALERTS,           /* Alerts emitted */
+    AI_SECURITY_STAT_ALERTS_COALESCED, /* Folded into an identical alert */
+    AI_SECURITY_STAT_ALERTS_SUPPRESSED, /* Over the per-profile rate */
+    AI_SECURITY_STAT_ALERTS_DROPPED,   /* Alert ring was full */
+    AI_SECURITY_STAT_PROFILES_RETIRED, /* Task exited */
+    AI_SECURITY_STAT_PROFILES_EVICTED, /* Over AI_SECURITY_MAX_PROCESSES */
+    AI_SECURITY_STAT_MAX
+};
+
+/* Hooks with latency histograms */
+enum ai_security_hook {
+    AI_SECURITY_HOOK_FILE_PERMISSION = 0,
+    AI_SECURITY_HOOK_FILE_OPEN,
+    AI_SECURITY_HOOK_MMAP_FILE,
+    AI_SECURITY_HOOK_TASK_CREATE,
+    AI_SECURITY_HOOK_TASK_FIX_SETUID,
+    AI_SECURITY_HOOK_SOCKET_CONNECT,
+    AI_SECURITY_HOOK_TASK_FREE,
+    AI_SECURITY_HOOK_MAX
+};
+
+/* Latency buckets are powers of two from 128ns; the last is open-ended */
+#define AI_SECURITY_LAT_MIN_SHIFT       7
+#define AI_SECURITY_LAT_BUCKETS         16
+
+struct ai_security_cpu_stats {
+    u64 count[AI_SECURITY_STAT_MAX];
+    u64 hook_calls[AI_SECURITY_HOOK_MAX];
+    u64 hook_ns[AI_SECURITY_HOOK_MAX];
+    u64 hook_lat[AI_SECURITY_HOOK_MAX][AI_SECURITY_LAT_BUCKETS];
+};
+
+/*
+ * Deep-analysis queue. Hooks only run the fast tier inline and leave a
+ * record here; the deep worker scores records in batches and updates
+ * profile trust. One producer (this CPU, preemption off), one consumer
+ * (the worker).
+ */
+struct ai_security_deep_record {
+    pid_t pid;
+    u8 type;                           /* enum ai_security_event_type */
+    u8 threat_level;                   /* Fast-tier classification */
+    u16 threat_score;                  /* Fast-tier score */
+};
+
+struct ai_security_deep_ring {
+    unsigned int head;
+    struct ai_security_deep_record *records;
+    
+    unsigned int tail ____cacheline_aligned_in_smp;
+};
+
+/*
+ * Alert ring. Multiple producers reserve a slot under the lock and fill
+ * it outside it; a slot is readable once its busy flag clears, and the
+ * single consumer stops at the first busy slot. These are the semantics
+ * of the BPF ring buffer, with fixed-size records.
+ */
+struct ai_security_alert {
+    u64 timestamp;                     /* ktime, ns */
+    pid_t pid;
+    uid_t uid;
+    u32 repeats;                       /* Identical alerts folded in before */
+    u32 suppressed;                    /* Alerts dropped by the rate limit before */
+    u16 threat_score;
+    u8 type;                           /* enum ai_security_event_type */
+    u8 threat_level;
+    u8 action;                         /* enum ai_security_action */
+    u8 confidence;
+    u8 data_len;
+    u8 busy;                           /* Set from reserve until commit */
+    u8 nr_reasons;
+    struct ai_security_reason_code reasons[AI_SECURITY_MAX_REASONS];
+    char comm[TASK_COMM_LEN];
+    char description[AI_SECURITY_DESC_LEN];
+    u8 data[AI_SECURITY_DATA_LEN];     /* Leading bytes of event_data */
+};
+
+struct ai_security_alert_ring {
+    spinlock_t lock;                   /* Serialises producers */
+    unsigned long producer_pos;
+    struct ai_security_alert *records;
+    
+    unsigned long consumer_pos ____cacheline_aligned_in_smp;
+};
+
+/*
+ * Event history. Every decided event is appended as one fixed-width
+ * 64-byte record to a per-CPU chunk; full chunks are kept on a per-CPU
+ * list and the oldest is recycled once AI_SECURITY_HISTORY_CHUNKS are
+ * in use. Times are microseconds from the chunk's base, file and
+ * network objects are hashed and executables are referred to by their
+ * interned path hash.
+ */
+#define AI_SECURITY_RECORD_DENIED        BIT(0)
+
+struct ai_security_record {
+    u32 time_delta;                    /* us since chunk base */
+    u32 seq;                           /* Low bits of the event id */
+    s32 pid;
+    s32 ppid;
+    u32 uid;
+    u32 exe_id;                        /* Interned executable path hash */
+    u32 object_id;                     /* jhash of the event data */
+    u8 type;                           /* enum ai_security_event_type */
+    u8 threat_level;
+    u8 action;                         /* enum ai_security_action */
+    u8 confidence;
+    u8 threat_score;
+    u8 file_label;                     /* AI_SECURITY_LABEL_* */
+    u8 flags;                          /* AI_SECURITY_RECORD_* */
+    u8 nr_reasons;
+    struct ai_security_reason_code reasons[AI_SECURITY_MAX_REASONS];
+    char comm[TASK_COMM_LEN];
+};
+
+struct ai_security_record_chunk {
+    struct list_head list;
+    u64 base;                          /* ktime ns of the first record */
+    u32 nr;
+    u32 cpu;
+    struct ai_security_record records[] ____cacheline_aligned;
+};
+
+struct ai_security_history {
+    spinlock_t lock;
+    struct ai_security_record_chunk *cur;  /* Being filled */
+    struct list_head chunks;           /* Full chunks, oldest first */
+    unsigned int nr_chunks;            /* Including cur */
+};
+
+/*
+ * /proc/ai_security/history is a stream of chunks, each this header
+ * followed by nr records; everything is 64-byte aligned.
+ */
+struct ai_security_history_header {
+    u32 magic;                         /* AI_SECURITY_HISTORY_MAGIC */
+    u16 version;                       /* AI_SECURITY_HISTORY_VERSION */
+    u16 record_size;
+    u32 cpu;
+    u32 nr;
+    u64 base;
+    u8 reserved[40];
+};
+
+/*
+ * Per-CPU store of retained events, one bucket per minute. A bucket is
+ * emptied as a whole when it expires or is reused for a new minute, so
+ * expiry never walks individual events.
+ */
+struct ai_security_event_store {
+    spinlock_t lock;
+    u64 epoch[AI_SECURITY_EVENT_BUCKETS]; /* Minute each bucket holds */
+    struct list_head buckets[AI_SECURITY_EVENT_BUCKETS];
+};
+
 /* AI Security Manager */
 struct ai_security_manager {
     /* Process Profiles */
-    struct list_head process_profiles; /* List of all process profiles */
+    struct list_head process_profiles; /* Oldest first, read under RCU */
     spinlock_t profiles_lock;          /* Protect profiles list */
+    struct llist_head retired_profiles; /* Waiting to be unhashed */
+    struct llist_head dead_profiles;   /* Last reference gone */
+    struct llist_head __percpu *dirty_profiles; /* Touched since the last learning pass */
+    struct work_struct reap_work;
     
     /* Event Management */
-    struct list_head recent_events;    /* Recent security events */
-    spinlock_t events_lock;            /* Protect events list */
+    struct ai_security_event_store __percpu *event_stores; /* Retained events */
+    struct ai_security_history __percpu *history;          /* Compact records */
+    
+    /* Object Caches */
+    struct kmem_cache *event_cache;
+    struct kmem_cache *profile_cache;
+    
+    /* Interned Executable Paths */
+    struct hlist_head path_hash[1 << AI_SECURITY_PATH_HASH_BITS];
+    spinlock_t paths_lock;
+    struct list_head baselines;        /* Paths pinned for their baseline, LRU */
+    u32 nr_baselines;
+    struct ai_security_baseline_batch __percpu *baseline_batches;
     
     /* Hash Tables */
     struct hlist_head profile_hash[AI_SECURITY_HASH_SIZE];
     struct hlist_head event_hash[AI_SECURITY_HASH_SIZE];
-    spinlock_t hash_locks[AI_SECURITY_HASH_SIZE];
+    spinlock_t hash_locks[AI_SECURITY_HASH_SIZE]; /* Writers of either table, per bucket */
     
     /* Threat Intelligence */
-    struct ai_threat_intelligence threat_intel;
+    struct ai_threat_intelligence threat_intel; /* Staging feed */
+    struct ai_security_intel __rcu *intel;      /* Published generation */
+    struct mutex intel_lock;           /* Feed updates and publishing */
+    
+    /* Network Connect Policy */
+    struct ai_security_lpm_node __rcu *net_root;
+    struct mutex net_lock;             /* Serialises policy updates */
+    u32 net_rules;
+    
+    /* Deep Analysis */
+    struct ai_security_deep_ring __percpu *deep_rings;
+    struct workqueue_struct *deep_wq;
+    struct work_struct deep_work;
+    
+    /* Alerts, drained into printk and audit by alert_work */
+    struct ai_security_alert_ring alerts;
+    struct work_struct alert_work;
     
     /* Statistics */
-    u64 total_events_processed;
-    u64 threats_detected;
-    u64 false_positives;
-    u64 threats_blocked;
-    u64 processes_monitored;
+    struct ai_security_cpu_stats __percpu *stats;
+    u64 processes_monitored;           /* Under profiles_lock */
     
     /* Performance Metrics */
     ktime_t avg_processing_time;
@@ -232,6 +687,7 @@ struct ai_security_manager {
     /* Learning System */
     ktime_t last_learning_update;
     struct timer_list learning_timer;
+    struct work_struct learning_work;
     
     /* Policy Management */
     u32 global_threat_threshold;
@@ -245,6 +701,9 @@ struct ai_security_manager {
     struct proc_dir_entry *proc_events;
     struct proc_dir_entry *proc_profiles;
     struct proc_dir_entry *proc_threats;
+    struct proc_dir_entry *proc_netpolicy;
+    struct proc_dir_entry *proc_intel;
+    struct proc_dir_entry *proc_history;
 };
 
 /* LSM Hook Integration */
@@ -252,7 +711,6 @@ struct ai_security_lsm_data {
     struct ai_security_event *event;
     struct ai_security_profile *profile;
     int decision;
-    char *explanation;
 };
 
 /* Function Prototypes */
@@ -271,6 +729,7 @@ void ai_security_free_event(struct ai_security_event *event);
 
 /* Profile Management */
 struct ai_security_profile *ai_security_get_profile(pid_t pid);
+void ai_security_put_profile(struct ai_security_profile *profile);
 int ai_security_create_profile(struct task_struct *task);
 void ai_security_update_profile(struct ai_security_profile *profile, struct ai_security_event *event);
 void ai_security_free_profile(struct ai_security_profile *profile);
@@ -280,6 +739,8 @@ int ai_security_detect_anomaly(struct ai_security_profile *profile, struct ai_se
 int ai_security_calculate_threat_score(struct ai_security_event *event);
 enum ai_security_threat_level ai_security_classify_threat(u32 score);
 bool ai_security_is_known_threat(struct ai_security_event *event);
+bool ai_security_is_malware_hash(u32 hash);
+bool ai_security_is_malicious_ip(const struct in6_addr *addr);
 
 /* Decision Making */
 int ai_security_make_decision(struct ai_security_event *event);
@@ -303,7 +764,8 @@ int ai_security_sb_mount(const char *dev_name, const struct path *path,
 /* Utility Functions */
 u32 ai_security_hash_string(const char *str);
 ktime_t ai_security_get_current_time(void);
-char *ai_security_get_executable_path(struct task_struct *task);
+struct ai_security_path *ai_security_get_executable_path(struct task_struct *task);
+void ai_security_put_path(struct ai_security_path *path);
 bool ai_security_is_system_process(pid_t pid);
 void ai_security_log_threat(struct ai_security_event *event);
 void ai_security_send_alert(struct ai_security_event *event);
@@ -321,7 +783,6 @@ int ai_security_proc_init(void);
 void ai_security_proc_cleanup(void);
 int ai_security_proc_show_stats(struct seq_file *m, void *v);
 int ai_security_proc_show_events(struct seq_file *m, void *v);
-int ai_security_proc_show_profiles(struct seq_file *m, void *v);
 int ai_security_proc_show_threats(struct seq_file *m, void *v);
 
 /* Memory Management */
@@ -341,6 +802,7 @@ extern struct ai_security_manager *ai_sec_mgr;
 extern u32 ai_security_threat_threshold;
 extern bool ai_security_auto_response;
 extern bool ai_security_learning_enabled;
+extern u32 ai_security_core_isolate_trust;
 extern bool ai_security_debug_enabled;
 extern u32 ai_security_max_events_per_process;
 
@@ -0,0 +1,642 @@
+/*
+ * Aurora OS - AI Core Module
+ *
+ * Owns the per-task feature blocks described in aurora_core.h. Blocks
+ * live in the task's SCHED_AURORA_STORAGE_FEATURES slot, so finding a
+ * task's features is one pointer load from the task. They are created
+ * on demand by whichever module first needs one and go away with the
+ * task, once the last module holding a reference has dropped it.
+ *
+ * It also owns the telemetry rings behind /dev/aurora_telemetry, which
+ * the modules append typed records to for the userspace agents, and the
+ * "aurora_ai" generic netlink family they take their parameters from.
+ * The "aurora" tracepoints of all modules are defined here as well.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/irq_work.h>
+#include <linux/list.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/rcupdate.h>
+#include <linux/refcount.h>
+#include <linux/sched.h>
+#include <linux/sched/aurora.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/timekeeping.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
+#include <net/genetlink.h>
+#include "aurora_core.h"
+
+#define CREATE_TRACE_POINTS
+#include "aurora_trace.h"
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_sched_pick);
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_sched_score);
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_security_verdict);
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_security_learn);
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_context_score);
+EXPORT_TRACEPOINT_SYMBOL_GPL(aurora_context_learn);
+
+/* Module Information */
+MODULE_LICENSE("GPL v2");
+MODULE_AUTHOR("Aurora OS Development Team");
+MODULE_DESCRIPTION("Shared per-task features, telemetry and control for the Aurora OS AI modules");
+MODULE_VERSION("1.0.0");
+
+/* Module Parameters */
+static unsigned int aurora_telemetry_records = 4096;
+module_param(aurora_telemetry_records, uint, 0444);
+MODULE_PARM_DESC(aurora_telemetry_records, "Telemetry records per CPU, rounded up to a power of two");
+
+/*
+ * Feature block and its bookkeeping. The features come first and fill
+ * the first cache line on their own; the rest is only touched when the
+ * block is created and freed.
+ */
+struct aurora_task {
+    struct aurora_task_features features;
+    refcount_t ref;                     /* One for the task, one per holder */
+    struct task_struct *task;           /* Owner, while attached */
+    struct list_head list;              /* Attached blocks, under aurora_core_lock */
+    struct rcu_head rcu;
+};
+
+static_assert(offsetof(struct aurora_task, features) == 0);
+
+static struct kmem_cache *aurora_task_cache;
+static LIST_HEAD(aurora_core_tasks);
+static DEFINE_SPINLOCK(aurora_core_lock);
+
+static inline struct aurora_task *to_aurora_task(struct aurora_task_features *features)
+{
+    return container_of(features, struct aurora_task, features);
+}
+
+static void aurora_task_free_rcu(struct rcu_head *rcu)
+{
+    kmem_cache_free(aurora_task_cache, container_of(rcu, struct aurora_task, rcu));
+}
+
+void aurora_task_features_put(struct aurora_task_features *features)
+{
+    struct aurora_task *at = to_aurora_task(features);
+
+    /* Lock-free readers may still be looking at it through the task */
+    if (refcount_dec_and_test(&at->ref))
+        call_rcu(&at->rcu, aurora_task_free_rcu);
+}
+EXPORT_SYMBOL(aurora_task_features_put);
+
+struct aurora_task_features *aurora_task_features_get(struct task_struct *p, gfp_t gfp)
+{
+    struct aurora_task_features *features;
+    struct aurora_task *at;
+    unsigned long flags;
+
+    rcu_read_lock();
+    features = aurora_task_features(p);
+    if (features && refcount_inc_not_zero(&to_aurora_task(features)->ref)) {
+        rcu_read_unlock();
+        return features;
+    }
+    rcu_read_unlock();
+
+    /* Exiting tasks may already have been handed to the free callback */
+    if (p->flags & PF_EXITING)
+        return NULL;
+
+    at = kmem_cache_zalloc(aurora_task_cache, gfp);
+    if (!at)
+        return NULL;
+
+    refcount_set(&at->ref, 2);
+    at->task = p;
+
+    /*
+     * Attach to the task; another module may have raced us. Holding the
+     * lock keeps the free callback out until the block is listed.
+     */
+    spin_lock_irqsave(&aurora_core_lock, flags);
+    if (!sched_aurora_task_storage_set(p, SCHED_AURORA_STORAGE_FEATURES, NULL, at)) {
+        spin_unlock_irqrestore(&aurora_core_lock, flags);
+        kmem_cache_free(aurora_task_cache, at);
+        return aurora_task_features_get(p, gfp);
+    }
+    list_add_tail(&at->list, &aurora_core_tasks);
+    spin_unlock_irqrestore(&aurora_core_lock, flags);
+
+    return &at->features;
+}
+EXPORT_SYMBOL(aurora_task_features_get);
+
+/*
+ * Task storage free callback, run when the task is freed. This may be
+ * RCU callback context.
+ */
+static void aurora_core_storage_free(struct task_struct *p, void *data)
+{
+    struct aurora_task *at = data;
+    unsigned long flags;
+
+    spin_lock_irqsave(&aurora_core_lock, flags);
+    list_del(&at->list);
+    spin_unlock_irqrestore(&aurora_core_lock, flags);
+
+    aurora_task_features_put(&at->features);
+}
+
+static struct sched_aurora_storage_ops aurora_core_storage_ops = {
+    .free = aurora_core_storage_free,
+};
+
+/*
+ * Telemetry rings. Each CPU's ring is one vmalloc_user() area holding
+ * the consumer page, the producer page and the records, in the layout
+ * userspace maps. Only the owning CPU produces, with interrupts off, so
+ * reserving a record is a bounds check against the consumer position.
+ */
+struct aurora_telemetry_ring {
+    struct aurora_telemetry_consumer *consumer;
+    struct aurora_telemetry_producer *producer;
+    struct aurora_telemetry_record *records;
+    void *base;
+    struct irq_work wakeup;
+};
+
+#define AURORA_TELEMETRY_CTRL_PAGES     2
+
+DEFINE_STATIC_KEY_FALSE(aurora_telemetry_enabled);
+EXPORT_SYMBOL(aurora_telemetry_enabled);
+
+static DEFINE_PER_CPU(struct aurora_telemetry_ring, aurora_telemetry_rings);
+static DECLARE_WAIT_QUEUE_HEAD(aurora_telemetry_wait);
+static unsigned int aurora_telemetry_pages;     /* Per ring, control pages included */
+
+struct aurora_telemetry_record *__aurora_telemetry_reserve(u16 type, pid_t pid,
+                                                           unsigned long *flags)
+{
+    struct aurora_telemetry_ring *ring;
+    struct aurora_telemetry_record *rec;
+    u64 prod, cons;
+
+    local_irq_save(*flags);
+    ring = this_cpu_ptr(&aurora_telemetry_rings);
+
+    /* Userspace owns consumer_pos; a bogus value only makes the ring look full */
+    prod = ring->producer->producer_pos;
+    cons = smp_load_acquire(&ring->consumer->consumer_pos);
+    if (unlikely(prod - cons >= aurora_telemetry_records)) {
+        WRITE_ONCE(ring->producer->dropped, ring->producer->dropped + 1);
+        local_irq_restore(*flags);
+        return NULL;
+    }
+
+    rec = &ring->records[prod & (aurora_telemetry_records - 1)];
+    rec->timestamp_ns = ktime_get_mono_fast_ns();
+    rec->type = type;
+    rec->reserved = 0;
+    rec->cpu = smp_processor_id();
+    rec->pid = pid;
+    rec->arg = 0;
+    memset(rec->data, 0, sizeof(rec->data));
+
+    return rec;
+}
+EXPORT_SYMBOL(__aurora_telemetry_reserve);
+
+void __aurora_telemetry_commit(struct aurora_telemetry_record *rec, unsigned long flags)
+{
+    struct aurora_telemetry_ring *ring = this_cpu_ptr(&aurora_telemetry_rings);
+    u64 prod = ring->producer->producer_pos;
+
+    smp_store_release(&ring->producer->producer_pos, prod + 1);
+
+    /* Wake sleepers only when the ring goes from empty to non-empty */
+    if (smp_load_acquire(&ring->consumer->consumer_pos) == prod)
+        irq_work_queue(&ring->wakeup);
+
+    local_irq_restore(flags);
+}
+EXPORT_SYMBOL(__aurora_telemetry_commit);
+
+/* Producers may hold the runqueue lock, so wake up from irq_work */
+static void aurora_telemetry_wakeup(struct irq_work *work)
+{
+    wake_up_all(&aurora_telemetry_wait);
+}
+
+static int aurora_telemetry_open(struct inode *inode, struct file *file)
+{
+    static_branch_inc(&aurora_telemetry_enabled);
+    return 0;
+}
+
+static int aurora_telemetry_release(struct inode *inode, struct file *file)
+{
+    static_branch_dec(&aurora_telemetry_enabled);
+    return 0;
+}
+
+static __poll_t aurora_telemetry_poll(struct file *file, poll_table *wait)
+{
+    struct aurora_telemetry_ring *ring;
+    int cpu;
+
+    poll_wait(file, &aurora_telemetry_wait, wait);
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&aurora_telemetry_rings, cpu);
+        if (smp_load_acquire(&ring->producer->producer_pos) !=
+            READ_ONCE(ring->consumer->consumer_pos))
+            return EPOLLIN | EPOLLRDNORM;
+    }
+
+    return 0;
+}
+
+static long aurora_telemetry_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct aurora_telemetry_info info = {
+        .version = AURORA_TELEMETRY_VERSION,
+        .record_size = sizeof(struct aurora_telemetry_record),
+        .nr_cpus = nr_cpu_ids,
+        .nr_records = aurora_telemetry_records,
+        .ring_pages = aurora_telemetry_pages,
+        .page_size = PAGE_SIZE,
+    };
+
+    if (cmd != AURORA_TELEMETRY_IOC_INFO)
+        return -ENOTTY;
+
+    return copy_to_user((void __user *)arg, &info, sizeof(info)) ? -EFAULT : 0;
+}
+
+/*
+ * Map part of one CPU's ring. Only the consumer page may be mapped
+ * writable, and only on its own; everything else is read-only.
+ */
+static int aurora_telemetry_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    unsigned long pages = vma_pages(vma);
+    unsigned long cpu = vma->vm_pgoff / aurora_telemetry_pages;
+    unsigned long off = vma->vm_pgoff % aurora_telemetry_pages;
+
+    if (cpu >= nr_cpu_ids || !cpu_possible(cpu))
+        return -ENXIO;
+    if (off + pages > aurora_telemetry_pages)
+        return -EINVAL;
+
+    if (vma->vm_flags & VM_WRITE) {
+        if (off != 0 || pages != 1)
+            return -EPERM;
+    } else {
+        vma->vm_flags &= ~VM_MAYWRITE;
+    }
+
+    return remap_vmalloc_range(vma, per_cpu_ptr(&aurora_telemetry_rings, cpu)->base, off);
+}
+
+static const struct file_operations aurora_telemetry_fops = {
+    .owner = THIS_MODULE,
+    .open = aurora_telemetry_open,
+    .release = aurora_telemetry_release,
+    .poll = aurora_telemetry_poll,
+    .unlocked_ioctl = aurora_telemetry_ioctl,
+    .mmap = aurora_telemetry_mmap,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice aurora_telemetry_dev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = "aurora_telemetry",
+    .fops = &aurora_telemetry_fops,
+    .mode = 0600,
+};
+
+static void aurora_telemetry_free(void)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct aurora_telemetry_ring *ring = per_cpu_ptr(&aurora_telemetry_rings, cpu);
+
+        irq_work_sync(&ring->wakeup);
+        vfree(ring->base);
+        ring->base = NULL;
+    }
+}
+
+static int aurora_telemetry_init(void)
+{
+    size_t size;
+    int cpu, ret;
+
+    aurora_telemetry_records = roundup_pow_of_two(clamp(aurora_telemetry_records, 64U, 1U << 20));
+    size = PAGE_ALIGN((size_t)aurora_telemetry_records * sizeof(struct aurora_telemetry_record));
+    aurora_telemetry_pages = AURORA_TELEMETRY_CTRL_PAGES + (size >> PAGE_SHIFT);
+
+    for_each_possible_cpu(cpu) {
+        struct aurora_telemetry_ring *ring = per_cpu_ptr(&aurora_telemetry_rings, cpu);
+
+        ring->base = vmalloc_user((size_t)aurora_telemetry_pages << PAGE_SHIFT);
+        if (!ring->base) {
+            aurora_telemetry_free();
+            return -ENOMEM;
+        }
+        ring->consumer = ring->base;
+        ring->producer = ring->base + PAGE_SIZE;
+        ring->records = ring->base + AURORA_TELEMETRY_CTRL_PAGES * PAGE_SIZE;
+        init_irq_work(&ring->wakeup, aurora_telemetry_wakeup);
+    }
+
+    ret = misc_register(&aurora_telemetry_dev);
+    if (ret)
+        aurora_telemetry_free();
+    return ret;
+}
+
+static void aurora_telemetry_exit(void)
+{
+    /* The device holds a module reference while open, so nobody produces */
+    misc_deregister(&aurora_telemetry_dev);
+    aurora_telemetry_free();
+}
+
+/*
+ * Control plane. Modules register the nest they own; an APPLY message
+ * stages every nest it carries and then commits all of them, or aborts
+ * all of them if any one fails. The mutex serialises messages with each
+ * other and with registration, so ops never go away mid-message.
+ */
+static DEFINE_MUTEX(aurora_control_lock);
+static const struct aurora_ai_control_ops *aurora_controls[AURORA_AI_ATTR_MAX + 1];
+static u64 aurora_control_gen;
+
+static const struct nla_policy aurora_ai_policy[AURORA_AI_ATTR_MAX + 1] = {
+    [AURORA_AI_ATTR_GENERATION] = { .type = NLA_U64 },
+    [AURORA_AI_ATTR_SCHED]      = { .type = NLA_NESTED },
+    [AURORA_AI_ATTR_CONTEXT]    = { .type = NLA_NESTED },
+    [AURORA_AI_ATTR_SECURITY]   = { .type = NLA_NESTED },
+};
+
+static struct genl_family aurora_ai_family;
+
+int aurora_ai_register_control(const struct aurora_ai_control_ops *ops)
+{
+    int ret = 0;
+
+    if (ops->attr <= AURORA_AI_ATTR_GENERATION || ops->attr >= AURORA_AI_ATTR_PAD)
+        return -EINVAL;
+
+    mutex_lock(&aurora_control_lock);
+    if (aurora_controls[ops->attr])
+        ret = -EBUSY;
+    else
+        aurora_controls[ops->attr] = ops;
+    mutex_unlock(&aurora_control_lock);
+
+    return ret;
+}
+EXPORT_SYMBOL(aurora_ai_register_control);
+
+/* After this returns no callback of @ops is running */
+void aurora_ai_unregister_control(const struct aurora_ai_control_ops *ops)
+{
+    mutex_lock(&aurora_control_lock);
+    if (aurora_controls[ops->attr] == ops)
+        aurora_controls[ops->attr] = NULL;
+    mutex_unlock(&aurora_control_lock);
+}
+EXPORT_SYMBOL(aurora_ai_unregister_control);
+
+/* Start a reply carrying the control generation; caller holds the lock */
+static struct sk_buff *aurora_ai_reply(struct genl_info *info, void **hdr)
+{
+    struct sk_buff *msg;
+
+    msg = genlmsg_new(nla_total_size_64bit(sizeof(u64)), GFP_KERNEL);
+    if (!msg)
+        return NULL;
+
+    *hdr = genlmsg_put_reply(msg, info, &aurora_ai_family, 0, info->genlhdr->cmd);
+    if (!*hdr) {
+        nlmsg_free(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
+static int aurora_ai_send_reply(struct sk_buff *msg, void *hdr, struct genl_info *info)
+{
+    if (nla_put_u64_64bit(msg, AURORA_AI_ATTR_GENERATION, aurora_control_gen,
+                          AURORA_AI_ATTR_PAD)) {
+        nlmsg_free(msg);
+        return -EMSGSIZE;
+    }
+
+    genlmsg_end(msg, hdr);
+    return genlmsg_reply(msg, info);
+}
+
+static int aurora_ai_apply(struct sk_buff *skb, struct genl_info *info)
+{
+    void *staged[AURORA_AI_ATTR_MAX + 1] = {};
+    const struct aurora_ai_control_ops *ops;
+    unsigned long prepared = 0;
+    struct sk_buff *msg;
+    int attr, ret = 0;
+    void *hdr;
+
+    mutex_lock(&aurora_control_lock);
+
+    /* Allocate the reply first, so nothing can fail after committing */
+    msg = aurora_ai_reply(info, &hdr);
+    if (!msg) {
+        ret = -ENOMEM;
+        goto unlock;
+    }
+
+    if (info->attrs[AURORA_AI_ATTR_GENERATION] &&
+        nla_get_u64(info->attrs[AURORA_AI_ATTR_GENERATION]) != aurora_control_gen) {
+        NL_SET_ERR_MSG(info->extack, "Configuration changed since it was read");
+        ret = -ESTALE;
+        goto free;
+    }
+
+    for (attr = AURORA_AI_ATTR_GENERATION + 1; attr < AURORA_AI_ATTR_PAD; attr++) {
+        if (!info->attrs[attr])
+            continue;
+
+        ops = aurora_controls[attr];
+        if (!ops) {
+            NL_SET_ERR_MSG_ATTR(info->extack, info->attrs[attr], "Module not loaded");
+            ret = -EOPNOTSUPP;
+            break;
+        }
+
+        staged[attr] = ops->prepare(info->attrs[attr], info->extack);
+        if (IS_ERR(staged[attr])) {
+            ret = PTR_ERR(staged[attr]);
+            break;
+        }
+        __set_bit(attr, &prepared);
+    }
+
+    for_each_set_bit(attr, &prepared, AURORA_AI_ATTR_MAX + 1) {
+        if (ret)
+            aurora_controls[attr]->abort(staged[attr]);
+        else
+            aurora_controls[attr]->commit(staged[attr]);
+    }
+
+    if (ret)
+        goto free;
+
+    if (prepared)
+        aurora_control_gen++;
+    ret = aurora_ai_send_reply(msg, hdr, info);
+    goto unlock;
+
+free:
+    nlmsg_free(msg);
+unlock:
+    mutex_unlock(&aurora_control_lock);
+    return ret;
+}
+
+static int aurora_ai_get(struct sk_buff *skb, struct genl_info *info)
+{
+    struct sk_buff *msg;
+    void *hdr;
+    int ret;
+
+    mutex_lock(&aurora_control_lock);
+    msg = aurora_ai_reply(info, &hdr);
+    ret = msg ? aurora_ai_send_reply(msg, hdr, info) : -ENOMEM;
+    mutex_unlock(&aurora_control_lock);
+
+    return ret;
+}
+
+static const struct genl_small_ops aurora_ai_ops[] = {
+    {
+        .cmd = AURORA_AI_CMD_APPLY,
+        .flags = GENL_ADMIN_PERM,
+        .doit = aurora_ai_apply,
+    },
+    {
+        .cmd = AURORA_AI_CMD_GET,
+        .flags = GENL_ADMIN_PERM,
+        .doit = aurora_ai_get,
+    },
+};
+
+static struct genl_family aurora_ai_family __ro_after_init = {
+    .name = AURORA_AI_GENL_NAME,
+    .version = AURORA_AI_GENL_VERSION,
+    .maxattr = AURORA_AI_ATTR_MAX,
+    .policy = aurora_ai_policy,
+    .module = THIS_MODULE,
+    .small_ops = aurora_ai_ops,
+    .n_small_ops = ARRAY_SIZE(aurora_ai_ops),
+};
+
+static int __init aurora_core_init(void)
+{
+    int ret;
+
+    aurora_task_cache = KMEM_CACHE(aurora_task, SLAB_HWCACHE_ALIGN | SLAB_ACCOUNT);
+    if (!aurora_task_cache) {
+        pr_err("Aurora Core: Failed to create feature cache\n");
+        return -ENOMEM;
+    }
+
+    ret = sched_aurora_register_storage_ops(SCHED_AURORA_STORAGE_FEATURES,
+                                            &aurora_core_storage_ops);
+    if (ret) {
+        pr_err("Aurora Core: Task storage unavailable (%d)\n", ret);
+        goto err_cache;
+    }
+
+    ret = aurora_telemetry_init();
+    if (ret) {
+        pr_err("Aurora Core: Failed to set up telemetry (%d)\n", ret);
+        goto err_storage;
+    }
+
+    ret = genl_register_family(&aurora_ai_family);
+    if (ret) {
+        pr_err("Aurora Core: Failed to register the %s family (%d)\n",
+               AURORA_AI_GENL_NAME, ret);
+        goto err_telemetry;
+    }
+
+    pr_info("Aurora Core: Initialized, %zu-byte feature blocks, %u telemetry records per CPU\n",
+            sizeof(struct aurora_task_features), aurora_telemetry_records);
+    return 0;
+
+err_telemetry:
+    aurora_telemetry_exit();
+err_storage:
+    sched_aurora_unregister_storage_ops(SCHED_AURORA_STORAGE_FEATURES,
+                                        &aurora_core_storage_ops);
+err_cache:
+    kmem_cache_destroy(aurora_task_cache);
+    return ret;
+}
+
+/*
+ * The modules using the blocks hold a reference on this one, so by now
+ * only the tasks' own references are left.
+ */
+static void __exit aurora_core_exit(void)
+{
+    struct aurora_task *at, *tmp;
+    unsigned long flags;
+
+    genl_unregister_family(&aurora_ai_family);
+    aurora_telemetry_exit();
+
+    /*
+     * Detach blocks from their tasks. A task being freed concurrently
+     * has already taken its block and hands it to the free callback.
+     */
+    spin_lock_irqsave(&aurora_core_lock, flags);
+    list_for_each_entry_safe(at, tmp, &aurora_core_tasks, list) {
+        if (sched_aurora_task_storage_set(at->task, SCHED_AURORA_STORAGE_FEATURES,
+                                          at, NULL)) {
+            list_del(&at->list);
+            aurora_task_features_put(&at->features);
+        }
+    }
+    spin_unlock_irqrestore(&aurora_core_lock, flags);
+
+    /* No free callback runs after this; reclaim what they missed */
+    sched_aurora_unregister_storage_ops(SCHED_AURORA_STORAGE_FEATURES,
+                                        &aurora_core_storage_ops);
+
+    spin_lock_irqsave(&aurora_core_lock, flags);
+    list_for_each_entry_safe(at, tmp, &aurora_core_tasks, list) {
+        list_del(&at->list);
+        aurora_task_features_put(&at->features);
+    }
+    spin_unlock_irqrestore(&aurora_core_lock, flags);
+
+    rcu_barrier();
+    kmem_cache_destroy(aurora_task_cache);
+
+    pr_info("Aurora Core: Shutdown complete\n");
+}
+
+module_init(aurora_core_init);
+module_exit(aurora_core_exit);
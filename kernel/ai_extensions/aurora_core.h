@@ -0,0 +1,307 @@
+/*
+ * Aurora OS - AI Core Header File
+ *
+ * Per-task feature vector shared by the Aurora AI modules. Each task
+ * gets one cache-line-aligned block, attached to the task itself, which
+ * the scheduler, context manager and security modules all update and
+ * read instead of keeping their own copies keyed by pid.
+ *
+ * Every field has exactly one writer, named next to it; everyone else
+ * only reads. Fields are plain words read with READ_ONCE(), so a reader
+ * may see one feature older than another but never a torn value. A
+ * producer sets its AURORA_FEATURE_* bit in valid once its fields hold
+ * real data, so consumers can tell "zero" from "not measured".
+ *
+ * The core module also carries the modules' common telemetry stream to
+ * userspace; see the second half of this file.
+ */
+
+#ifndef _AURORA_CORE_H
+#define _AURORA_CORE_H
+
+#include <linux/types.h>
+#include <linux/bitops.h>
+#include <linux/cache.h>
+#include <linux/gfp.h>
+#include <linux/ioctl.h>
+#include <linux/jump_label.h>
+#include <linux/sched.h>
+#include <linux/sched/aurora.h>
+
+/* Intensities and shares are fixed point; AURORA_FEATURE_ONE is 1.0 */
+#define AURORA_FEATURE_SHIFT    10
+#define AURORA_FEATURE_ONE      (1U << AURORA_FEATURE_SHIFT)
+
+/* Producers, as bits of aurora_task_features::valid */
+enum aurora_feature_source {
+    AURORA_FEATURE_SCHED,       /* ai_scheduler tick samples */
+    AURORA_FEATURE_CONTEXT,     /* ai_context_manager learning runs */
+    AURORA_FEATURE_SECURITY,    /* ai_security learning runs */
+};
+
+struct aurora_task_features {
+    /* ai_scheduler: per-sample EWMAs of the task's CPU use */
+    u64 avg_runtime;            /* ns of CPU per sample */
+    u64 avg_wait;               /* ns runnable but not running per sample */
+    u32 cpu_intensity;          /* AURORA_FEATURE_ONE is a full CPU */
+    u32 io_intensity;           /* AURORA_FEATURE_ONE is always in IO */
+
+    /* ai_context_manager: storage and switching behaviour */
+    u32 io_bandwidth;           /* AURORA_FEATURE_ONE is fully IO bound */
+    u32 switch_rate;            /* switch-outs per second */
+
+    /* ai_security: behavioural trust */
+    u32 trust;                  /* AURORA_FEATURE_ONE is fully trusted */
+
+    unsigned long valid;        /* AURORA_FEATURE_* bits */
+} ____cacheline_aligned;
+
+/*
+ * The task's feature block, or NULL if no module has created one yet.
+ * Caller must hold rcu_read_lock(); the block stays valid until it
+ * leaves the read-side critical section.
+ */
+static inline struct aurora_task_features *aurora_task_features(struct task_struct *p)
+{
+    return sched_aurora_task_storage(p, SCHED_AURORA_STORAGE_FEATURES);
+}
+
+/*
+ * Find or create the task's feature block and take a reference on it,
+ * which keeps the block valid after the task is gone. Returns NULL when
+ * allocation fails. Safe from atomic context with GFP_ATOMIC.
+ */
+struct aurora_task_features *aurora_task_features_get(struct task_struct *p, gfp_t gfp);
+void aurora_task_features_put(struct aurora_task_features *features);
+
+/* Mark @src's fields as holding data; cheap once set */
+static inline void aurora_task_features_publish(struct aurora_task_features *features,
+                                                enum aurora_feature_source src)
+{
+    if (!test_bit(src, &features->valid))
+        set_bit(src, &features->valid);
+}
+
+static inline bool aurora_task_features_valid(const struct aurora_task_features *features,
+                                              enum aurora_feature_source src)
+{
+    return test_bit(src, &features->valid);
+}
+
+/*
+ * Telemetry stream, /dev/aurora_telemetry. Every CPU has a ring of
+ * fixed-size records that the modules append to and that userspace
+ * maps and drains without a syscall per record, as with a BPF ring
+ * buffer. AURORA_TELEMETRY_IOC_INFO describes the layout. The rings of
+ * all possible CPUs are laid out back to back, ring_pages pages each,
+ * so CPU n's ring starts at mmap offset n * ring_pages * page size:
+ *
+ *	page 0		struct aurora_telemetry_consumer, mapped read-write
+ *	page 1		struct aurora_telemetry_producer, read-only
+ *	page 2...	nr_records records, read-only
+ *
+ * Positions are free-running record counts; the record at position
+ * pos is records[pos & (nr_records - 1)]. A consumer drains a ring by
+ *
+ *	prod = load_acquire(&producer->producer_pos);
+ *	while (cons != prod)
+ *		handle(&records[cons++ & (nr_records - 1)]);
+ *	store_release(&consumer->consumer_pos, cons);
+ *
+ * and poll()s the device to sleep until any ring has records. When a
+ * ring is full new records are counted in dropped and discarded, so
+ * producers never wait. Records are only produced while the device is
+ * open.
+ */
+#define AURORA_TELEMETRY_VERSION        1
+
+enum aurora_telemetry_type {
+    AURORA_TELEMETRY_SCHED_PICK = 1,    /* arg: score; data: avg_runtime, avg_wait,
+                                           cpu_intensity, io_intensity, nr_queued */
+    AURORA_TELEMETRY_CONTEXT_LEARN,     /* arg: active processes; data: switches,
+                                           switch records dropped, tracked */
+    AURORA_TELEMETRY_SECURITY_VERDICT,  /* arg: event type; data: threat score,
+                                           threat level, action, confidence,
+                                           reason rules, one per byte */
+};
+
+struct aurora_telemetry_record {
+    __u64 timestamp_ns;                 /* CLOCK_MONOTONIC */
+    __u16 type;                         /* enum aurora_telemetry_type */
+    __u16 reserved;
+    __u32 cpu;
+    __s32 pid;                          /* 0 for system-wide records */
+    __u32 arg;
+    __u64 data[5];
+};
+
+struct aurora_telemetry_consumer {
+    __u64 consumer_pos;
+};
+
+struct aurora_telemetry_producer {
+    __u64 producer_pos;
+    __u64 dropped;                      /* Records lost to a full ring */
+};
+
+struct aurora_telemetry_info {
+    __u32 version;
+    __u32 record_size;
+    __u32 nr_cpus;                      /* Rings, one per possible CPU id */
+    __u32 nr_records;                   /* Per ring, a power of two */
+    __u32 ring_pages;                   /* Pages per ring, control pages included */
+    __u32 page_size;
+    __u64 reserved[2];
+};
+
+#define AURORA_TELEMETRY_IOC_MAGIC      0xA7
+#define AURORA_TELEMETRY_IOC_INFO       _IOR(AURORA_TELEMETRY_IOC_MAGIC, 1, \
+                                             struct aurora_telemetry_info)
+
+/* Set while a consumer has the device open; producers test it inline */
+DECLARE_STATIC_KEY_FALSE(aurora_telemetry_enabled);
+
+struct aurora_telemetry_record *__aurora_telemetry_reserve(u16 type, pid_t pid,
+                                                           unsigned long *flags);
+void __aurora_telemetry_commit(struct aurora_telemetry_record *rec, unsigned long flags);
+
+/*
+ * Reserve a record on this CPU's ring, with its header filled in and
+ * data zeroed. Returns NULL, at the cost of a patched NOP, when nobody
+ * is listening, and NULL when the ring is full. Interrupts stay off
+ * until the record is committed, so fill it in quickly. Not for NMI
+ * context.
+ */
+static inline struct aurora_telemetry_record *
+aurora_telemetry_reserve(u16 type, pid_t pid, unsigned long *flags)
+{
+    if (!static_branch_unlikely(&aurora_telemetry_enabled))
+        return NULL;
+    return __aurora_telemetry_reserve(type, pid, flags);
+}
+
+static inline void aurora_telemetry_commit(struct aurora_telemetry_record *rec,
+                                           unsigned long flags)
+{
+    __aurora_telemetry_commit(rec, flags);
+}
+
+/*
+ * Control plane, generic netlink family "aurora_ai". One
+ * AURORA_AI_CMD_APPLY message carries a nest per module, each holding
+ * that module's new parameters: weight tables, classification maps,
+ * thresholds. The message applies as a whole or not at all: every
+ * module first validates and stages its nest, and only when all of them
+ * accept is each staged configuration made live. The reply carries the
+ * new control generation; a request that includes
+ * AURORA_AI_ATTR_GENERATION is refused with -ESTALE unless it matches
+ * the current one, so a trainer never overwrites a configuration it has
+ * not seen. AURORA_AI_CMD_GET returns the generation alone.
+ */
+#define AURORA_AI_GENL_NAME             "aurora_ai"
+#define AURORA_AI_GENL_VERSION          1
+
+enum aurora_ai_cmd {
+    AURORA_AI_CMD_UNSPEC,
+    AURORA_AI_CMD_APPLY,
+    AURORA_AI_CMD_GET,
+    __AURORA_AI_CMD_MAX,
+};
+
+enum aurora_ai_attr {
+    AURORA_AI_ATTR_UNSPEC,
+    AURORA_AI_ATTR_GENERATION,          /* u64 */
+    AURORA_AI_ATTR_SCHED,               /* nest, enum aurora_ai_sched_attr */
+    AURORA_AI_ATTR_CONTEXT,             /* nest, enum aurora_ai_context_attr */
+    AURORA_AI_ATTR_SECURITY,            /* nest, enum aurora_ai_security_attr */
+    AURORA_AI_ATTR_PAD,
+    __AURORA_AI_ATTR_MAX,
+};
+#define AURORA_AI_ATTR_MAX              (__AURORA_AI_ATTR_MAX - 1)
+
+enum aurora_ai_sched_attr {
+    AURORA_AI_SCHED_UNSPEC,
+    AURORA_AI_SCHED_WEIGHTS,            /* u32[3]: base, context, prediction; sum 1024 */
+    AURORA_AI_SCHED_CLASS_FLUSH,        /* flag: drop all classes first */
+    AURORA_AI_SCHED_CLASS,              /* nest, repeated, enum aurora_ai_class_attr */
+    AURORA_AI_SCHED_PRESSURE,           /* nest, repeated, enum aurora_ai_pressure_attr */
+    __AURORA_AI_SCHED_MAX,
+};
+#define AURORA_AI_SCHED_MAX             (__AURORA_AI_SCHED_MAX - 1)
+
+enum aurora_ai_class_attr {
+    AURORA_AI_CLASS_UNSPEC,
+    AURORA_AI_CLASS_TYPE,               /* u8: 0 cgroup id, 1 executable inode */
+    AURORA_AI_CLASS_ID,                 /* u64 */
+    AURORA_AI_CLASS_BOOST,              /* s32, -100..100; 0 removes the entry */
+    __AURORA_AI_CLASS_MAX,
+};
+#define AURORA_AI_CLASS_MAX             (__AURORA_AI_CLASS_MAX - 1)
+
+/*
+ * Resource pressure of a cgroup, as its PSI "some" stall share over the
+ * agent's trigger window, in hundredths of a percent. Cgroup 0 stands
+ * for the whole system and covers cgroups without an entry of their own.
+ */
+#define AURORA_AI_PRESSURE_FULL         10000
+
+enum aurora_ai_pressure_attr {
+    AURORA_AI_PRESSURE_UNSPEC,
+    AURORA_AI_PRESSURE_CGROUP,          /* u64 cgroup id */
+    AURORA_AI_PRESSURE_CPU,             /* u16, 0..AURORA_AI_PRESSURE_FULL */
+    AURORA_AI_PRESSURE_MEMORY,          /* u16, 0..AURORA_AI_PRESSURE_FULL */
+    AURORA_AI_PRESSURE_IO,              /* u16, 0..AURORA_AI_PRESSURE_FULL; all 0 removes */
+    __AURORA_AI_PRESSURE_MAX,
+};
+#define AURORA_AI_PRESSURE_MAX          (__AURORA_AI_PRESSURE_MAX - 1)
+
+enum aurora_ai_context_attr {
+    AURORA_AI_CONTEXT_UNSPEC,
+    AURORA_AI_CONTEXT_PREDICTION_THRESHOLD, /* u32, percent */
+    AURORA_AI_CONTEXT_LEARNING_INTERVAL,    /* u32, ms */
+    AURORA_AI_CONTEXT_LAZY_CPU,             /* u32, ms */
+    AURORA_AI_CONTEXT_IO_HINTS,             /* u8, bool */
+    AURORA_AI_CONTEXT_GROUPING,             /* u8, bool */
+    AURORA_AI_CONTEXT_LRU_HINTS,            /* u8, bool */
+    AURORA_AI_CONTEXT_HOT_TTL,              /* u32, ms */
+    AURORA_AI_CONTEXT_ZSWAP,                /* u8, bool */
+    AURORA_AI_CONTEXT_ZSWAP_AGE,            /* u32, ms */
+    AURORA_AI_CONTEXT_ZSWAP_CPU,            /* u32, ms per second */
+    AURORA_AI_CONTEXT_ZSWAP_RATE,           /* u32, MiB per second */
+    AURORA_AI_CONTEXT_THP_BOOST,            /* u8, bool */
+    __AURORA_AI_CONTEXT_MAX,
+};
+#define AURORA_AI_CONTEXT_MAX           (__AURORA_AI_CONTEXT_MAX - 1)
+
+enum aurora_ai_security_attr {
+    AURORA_AI_SECURITY_UNSPEC,
+    AURORA_AI_SECURITY_THREAT_THRESHOLD,    /* u32, 0..100 */
+    AURORA_AI_SECURITY_AUTO_RESPONSE,       /* u8, bool */
+    AURORA_AI_SECURITY_LEARNING,            /* u8, bool */
+    AURORA_AI_SECURITY_CORE_ISOLATE_TRUST,  /* u32, 0..100, 0 disables */
+    __AURORA_AI_SECURITY_MAX,
+};
+#define AURORA_AI_SECURITY_MAX          (__AURORA_AI_SECURITY_MAX - 1)
+
+struct nlattr;
+struct netlink_ext_ack;
+
+/*
+ * A module's part of the control plane, owning one top-level nest.
+ * prepare() parses and validates the nest into a staged configuration
+ * without side effects, returning it or an ERR_PTR(). commit() makes a
+ * staged configuration live and must not fail; abort() discards one.
+ * Both consume the staged configuration. All three run in process
+ * context under the control plane's mutex, so they may sleep.
+ */
+struct aurora_ai_control_ops {
+    int attr;                           /* enum aurora_ai_attr */
+    void *(*prepare)(const struct nlattr *nest, struct netlink_ext_ack *extack);
+    void (*commit)(void *staged);
+    void (*abort)(void *staged);
+};
+
+int aurora_ai_register_control(const struct aurora_ai_control_ops *ops);
+void aurora_ai_unregister_control(const struct aurora_ai_control_ops *ops);
+
+#endif /* _AURORA_CORE_H */
@@ -0,0 +1,207 @@
+/*
+ * Aurora OS - AI Module Tracepoints
+ *
+ * The "aurora" trace system: scheduling picks and their score
+ * components, security verdicts, and the learning passes of the context
+ * manager and security module. The events are defined once, in
+ * aurora_core.ko, and exported to the other modules; like every
+ * tracepoint they cost a patched NOP until enabled, for instance with
+ * "perf record -e aurora:*". All fields but comm are numeric, so they
+ * can key and sum histogram triggers:
+ *
+ *	echo 'hist:keys=pid:vals=hitcount,score' > \
+ *		/sys/kernel/tracing/events/aurora/aurora_sched_pick/trigger
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM aurora
+
+#if !defined(_AURORA_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _AURORA_TRACE_H
+
+#include <linux/sched.h>
+#include <linux/tracepoint.h>
+
+/*
+ * ai_scheduler picked @p to run next on @cpu. @cfs is the task CFS would
+ * have picked from the same queue, lowest vruntime first, and the classes
+ * are the burst prediction classes of both; "perf sched aurora" joins
+ * them with sched_switch to report what the AI ordering changes.
+ */
+TRACE_EVENT(aurora_sched_pick,
+
+    TP_PROTO(int cpu, struct task_struct *p, int score, unsigned int nr_queued,
+             int class, struct task_struct *cfs, int cfs_class),
+
+    TP_ARGS(cpu, p, score, nr_queued, class, cfs, cfs_class),
+
+    TP_STRUCT__entry(
+        __field(int, cpu)
+        __field(pid_t, pid)
+        __array(char, comm, TASK_COMM_LEN)
+        __field(int, score)
+        __field(unsigned int, nr_queued)
+        __field(int, class)
+        __field(pid_t, cfs_pid)
+        __field(int, cfs_class)
+    ),
+
+    TP_fast_assign(
+        __entry->cpu = cpu;
+        __entry->pid = p->pid;
+        memcpy(__entry->comm, p->comm, TASK_COMM_LEN);
+        __entry->score = score;
+        __entry->nr_queued = nr_queued;
+        __entry->class = class;
+        __entry->cfs_pid = cfs ? cfs->pid : p->pid;
+        __entry->cfs_class = cfs ? cfs_class : class;
+    ),
+
+    TP_printk("cpu=%d comm=%s pid=%d score=%d nr_queued=%u class=%d cfs_pid=%d cfs_class=%d",
+              __entry->cpu, __entry->comm, __entry->pid, __entry->score,
+              __entry->nr_queued, __entry->class, __entry->cfs_pid,
+              __entry->cfs_class)
+);
+
+/* ai_scheduler scored @p; components are before weighting */
+TRACE_EVENT(aurora_sched_score,
+
+    TP_PROTO(struct task_struct *p, unsigned long base, int context,
+             int prediction, int boost, int score),
+
+    TP_ARGS(p, base, context, prediction, boost, score),
+
+    TP_STRUCT__entry(
+        __field(pid_t, pid)
+        __field(unsigned long, base)
+        __field(int, context)
+        __field(int, prediction)
+        __field(int, boost)
+        __field(int, score)
+    ),
+
+    TP_fast_assign(
+        __entry->pid = p->pid;
+        __entry->base = base;
+        __entry->context = context;
+        __entry->prediction = prediction;
+        __entry->boost = boost;
+        __entry->score = score;
+    ),
+
+    TP_printk("pid=%d base=%lu context=%d prediction=%d boost=%d score=%d",
+              __entry->pid, __entry->base, __entry->context,
+              __entry->prediction, __entry->boost, __entry->score)
+);
+
+/* ai_security decided on an event; type, level and action are the module's enums */
+TRACE_EVENT(aurora_security_verdict,
+
+    TP_PROTO(pid_t pid, unsigned int type, u32 score, unsigned int level,
+             unsigned int action, unsigned int confidence),
+
+    TP_ARGS(pid, type, score, level, action, confidence),
+
+    TP_STRUCT__entry(
+        __field(pid_t, pid)
+        __field(unsigned int, type)
+        __field(u32, score)
+        __field(unsigned int, level)
+        __field(unsigned int, action)
+        __field(unsigned int, confidence)
+    ),
+
+    TP_fast_assign(
+        __entry->pid = pid;
+        __entry->type = type;
+        __entry->score = score;
+        __entry->level = level;
+        __entry->action = action;
+        __entry->confidence = confidence;
+    ),
+
+    TP_printk("pid=%d type=%u score=%u level=%u action=%u confidence=%u",
+              __entry->pid, __entry->type, __entry->score, __entry->level,
+              __entry->action, __entry->confidence)
+);
+
+/* ai_security finished a learning pass over the profiles that changed */
+TRACE_EVENT(aurora_security_learn,
+
+    TP_PROTO(unsigned int learned, unsigned int monitored, u64 duration_ns),
+
+    TP_ARGS(learned, monitored, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, learned)
+        __field(unsigned int, monitored)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->learned = learned;
+        __entry->monitored = monitored;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("learned=%u monitored=%u duration_ns=%llu",
+              __entry->learned, __entry->monitored, __entry->duration_ns)
+);
+
+/* ai_context_manager rescored a context; scores in percent */
+TRACE_EVENT(aurora_context_score,
+
+    TP_PROTO(pid_t pid, unsigned int complexity, unsigned int predictability),
+
+    TP_ARGS(pid, complexity, predictability),
+
+    TP_STRUCT__entry(
+        __field(pid_t, pid)
+        __field(unsigned int, complexity)
+        __field(unsigned int, predictability)
+    ),
+
+    TP_fast_assign(
+        __entry->pid = pid;
+        __entry->complexity = complexity;
+        __entry->predictability = predictability;
+    ),
+
+    TP_printk("pid=%d complexity=%u%% predictability=%u%%",
+              __entry->pid, __entry->complexity, __entry->predictability)
+);
+
+/* ai_context_manager finished a learning run */
+TRACE_EVENT(aurora_context_learn,
+
+    TP_PROTO(u64 switches, u64 dropped, unsigned int active, u64 duration_ns),
+
+    TP_ARGS(switches, dropped, active, duration_ns),
+
+    TP_STRUCT__entry(
+        __field(u64, switches)
+        __field(u64, dropped)
+        __field(unsigned int, active)
+        __field(u64, duration_ns)
+    ),
+
+    TP_fast_assign(
+        __entry->switches = switches;
+        __entry->dropped = dropped;
+        __entry->active = active;
+        __entry->duration_ns = duration_ns;
+    ),
+
+    TP_printk("switches=%llu dropped=%llu active=%u duration_ns=%llu",
+              __entry->switches, __entry->dropped, __entry->active,
+              __entry->duration_ns)
+);
+
+#endif /* _AURORA_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE aurora_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS Hook Overhead Benchmark
+ * Cost the AI modules add to the system calls they hook
+ *
+ * Three microbenchmarks, each timing one operation in a tight loop:
+ * - syscall:  open/read/write/close of a small file, the path the
+ *             ai_security.ko file hooks sit on
+ * - ctxsw:    a token ping-ponged between two processes over a pair of
+ *             pipes, two context switches per round trip, which is what
+ *             ai_context_manager.ko's switch tracking costs
+ * - forkexec: fork, exec of /bin/true and wait, hitting the exec and
+ *             task lifetime hooks of both
+ *
+ * Every benchmark runs --runs times; the fastest run is reported along
+ * with the median, so a single noisy run does not move the number. The
+ * result is one JSON object on stdout that records which Aurora modules
+ * were loaded, so a CI job can run it before and after loading the
+ * modules, or on every module change, and diff the ns/op values.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC 1000000000ULL
+
+#define BENCH_MAX_RUNS 32
+#define BENCH_FILE_SIZE 4096
+
+enum hook_bench {
+    BENCH_SYSCALL,
+    BENCH_CTXSW,
+    BENCH_FORKEXEC,
+    BENCH_NR
+};
+
+static const char * const bench_names[BENCH_NR] = {
+    [BENCH_SYSCALL]  = "syscall",
+    [BENCH_CTXSW]    = "ctxsw",
+    [BENCH_FORKEXEC] = "forkexec",
+};
+
+/* Operations timed per run; one op is a whole open..close, round trip or fork..wait */
+static const unsigned int bench_default_loops[BENCH_NR] = {
+    [BENCH_SYSCALL]  = 100000,
+    [BENCH_CTXSW]    = 100000,
+    [BENCH_FORKEXEC] = 1000,
+};
+
+static const char * const aurora_modules[] = {
+    "aurora_core", "ai_security", "ai_context_manager", "ai_scheduler",
+};
+
+struct bench_result {
+    unsigned int loops;
+    unsigned int runs;
+    uint64_t run_ns[BENCH_MAX_RUNS];
+};
+
+/* Tunables */
+static unsigned int opt_runs = 5;
+static unsigned int opt_scale = 100;     /* percent of the default loops */
+static unsigned int opt_benches = (1U << BENCH_NR) - 1;
+static const char *opt_dir = "/tmp";
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void die(const char *msg)
+{
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+static uint64_t bench_syscall(unsigned int loops)
+{
+    char path[4096], buf[BENCH_FILE_SIZE];
+    uint64_t start, end;
+    unsigned int i;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/aurora_hooks_bench.%d", opt_dir, getpid());
+    memset(buf, 'a', sizeof(buf));
+
+    fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    if (fd < 0)
+        die(path);
+    if (write(fd, buf, sizeof(buf)) != sizeof(buf))
+        die("write");
+    close(fd);
+
+    start = now_ns();
+    for (i = 0; i < loops; i++) {
+        fd = open(path, O_RDWR);
+        if (fd < 0)
+            die("open");
+        if (read(fd, buf, sizeof(buf)) != sizeof(buf))
+            die("read");
+        if (pwrite(fd, buf, 64, 0) != 64)
+            die("pwrite");
+        close(fd);
+    }
+    end = now_ns();
+
+    unlink(path);
+    return end - start;
+}
+
+static uint64_t bench_ctxsw(unsigned int loops)
+{
+    int ping[2], pong[2];
+    uint64_t start, end;
+    unsigned int i;
+    char token = 0;
+    pid_t pid;
+
+    if (pipe(ping) || pipe(pong))
+        die("pipe");
+
+    pid = fork();
+    if (pid < 0)
+        die("fork");
+    if (!pid) {
+        for (i = 0; i < loops; i++) {
+            if (read(ping[0], &token, 1) != 1 ||
+                write(pong[1], &token, 1) != 1)
+                _exit(EXIT_FAILURE);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    start = now_ns();
+    for (i = 0; i < loops; i++) {
+        if (write(ping[1], &token, 1) != 1 ||
+            read(pong[0], &token, 1) != 1)
+            die("ping-pong");
+    }
+    end = now_ns();
+
+    waitpid(pid, NULL, 0);
+    close(ping[0]);
+    close(ping[1]);
+    close(pong[0]);
+    close(pong[1]);
+    return end - start;
+}
+
+static uint64_t bench_forkexec(unsigned int loops)
+{
+    char *const args[] = { "true", NULL };
+    uint64_t start, end;
+    unsigned int i;
+    int status;
+    pid_t pid;
+
+    start = now_ns();
+    for (i = 0; i < loops; i++) {
+        pid = fork();
+        if (pid < 0)
+            die("fork");
+        if (!pid) {
+            execv("/bin/true", args);
+            _exit(127);
+        }
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status))
+            die("exec /bin/true");
+    }
+    end = now_ns();
+    return end - start;
+}
+
+static uint64_t (* const bench_fns[BENCH_NR])(unsigned int) = {
+    [BENCH_SYSCALL]  = bench_syscall,
+    [BENCH_CTXSW]    = bench_ctxsw,
+    [BENCH_FORKEXEC] = bench_forkexec,
+};
+
+static bool module_loaded(const char *name)
+{
+    char line[256];
+    size_t len = strlen(name);
+    bool loaded = false;
+    FILE *f;
+
+    f = fopen("/proc/modules", "r");
+    if (!f)
+        return false;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, name, len) && line[len] == ' ') {
+            loaded = true;
+            break;
+        }
+    }
+    fclose(f);
+    return loaded;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void print_json(const struct bench_result *results)
+{
+    struct utsname uts;
+    const char *sep = "";
+    unsigned int b, i;
+
+    uname(&uts);
+
+    printf("{\n  \"kernel\": \"%s\",\n  \"modules\": {", uts.release);
+    for (i = 0; i < sizeof(aurora_modules) / sizeof(aurora_modules[0]); i++)
+        printf("%s\"%s\": %s", i ? ", " : " ", aurora_modules[i],
+               module_loaded(aurora_modules[i]) ? "true" : "false");
+    printf(" },\n  \"benchmarks\": {");
+
+    for (b = 0; b < BENCH_NR; b++) {
+        const struct bench_result *res = &results[b];
+        uint64_t sorted[BENCH_MAX_RUNS];
+
+        if (!(opt_benches & (1U << b)))
+            continue;
+
+        memcpy(sorted, res->run_ns, res->runs * sizeof(sorted[0]));
+        qsort(sorted, res->runs, sizeof(sorted[0]), cmp_u64);
+
+        printf("%s\n    \"%s\": { \"loops\": %u, \"runs\": %u, "
+               "\"best_ns_per_op\": %.1f, \"median_ns_per_op\": %.1f, "
+               "\"runs_ns\": [",
+               sep, bench_names[b], res->loops, res->runs,
+               (double)sorted[0] / res->loops,
+               (double)sorted[res->runs / 2] / res->loops);
+        for (i = 0; i < res->runs; i++)
+            printf("%s%" PRIu64, i ? ", " : "", res->run_ns[i]);
+        printf("] }");
+        sep = ",";
+    }
+    printf("\n  }\n}\n");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -b, --bench=LIST      syscall,ctxsw,forkexec (default: all)\n"
+            "  -r, --runs=N          runs per benchmark, at most %u (default: %u)\n"
+            "  -s, --scale=PERCENT   loops per run, percent of the defaults (default: %u)\n"
+            "  -D, --dir=PATH        directory for the syscall benchmark file (default: %s)\n",
+            prog, BENCH_MAX_RUNS, opt_runs, opt_scale, opt_dir);
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int parse_benches(char *list, const char *prog)
+{
+    unsigned int mask = 0;
+    char *tok, *save;
+    int b;
+
+    for (tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        for (b = 0; b < BENCH_NR; b++) {
+            if (!strcmp(tok, bench_names[b]))
+                break;
+        }
+        if (b == BENCH_NR)
+            usage(prog);
+        mask |= 1U << b;
+    }
+    return mask;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        { "bench", required_argument, NULL, 'b' },
+        { "runs",  required_argument, NULL, 'r' },
+        { "scale", required_argument, NULL, 's' },
+        { "dir",   required_argument, NULL, 'D' },
+        { NULL, 0, NULL, 0 }
+    };
+    struct bench_result results[BENCH_NR] = {};
+    unsigned int b, r;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "b:r:s:D:", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'b': opt_benches = parse_benches(optarg, argv[0]); break;
+        case 'r': opt_runs = strtoul(optarg, NULL, 0); break;
+        case 's': opt_scale = strtoul(optarg, NULL, 0); break;
+        case 'D': opt_dir = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if (!opt_runs || opt_runs > BENCH_MAX_RUNS || !opt_scale)
+        usage(argv[0]);
+
+    for (b = 0; b < BENCH_NR; b++) {
+        struct bench_result *res = &results[b];
+
+        if (!(opt_benches & (1U << b)))
+            continue;
+
+        res->loops = (uint64_t)bench_default_loops[b] * opt_scale / 100;
+        if (!res->loops)
+            res->loops = 1;
+        res->runs = opt_runs;
+
+        /* warm up the caches and page tables once */
+        bench_fns[b](res->loops / 10 + 1);
+        for (r = 0; r < opt_runs; r++)
+            res->run_ns[r] = bench_fns[b](res->loops);
+    }
+
+    print_json(results);
+    return 0;
+}
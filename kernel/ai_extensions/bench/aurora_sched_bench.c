@@ -0,0 +1,772 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS Scheduler Latency Benchmark
+ * Compares the Aurora AI scheduling policy against stock CFS
+ *
+ * Replays three workload shapes, once per policy:
+ * - hackbench: groups of senders and receivers exchanging messages over pipes
+ * - schbench:  message threads waking pools of workers through futexes
+ * - pipe:      threads ping-ponging a token over a pair of pipes
+ *
+ * Every message carries its send timestamp, so the receiver measures the
+ * delay from wakeup to running. The policy is switched by writing to
+ * /proc/aurora_sched/enabled, which calls aurora_ai_scheduler_enable().
+ * Results are printed in the "perf sched latency" table format followed
+ * by p50/p99/p99.9 latency, context-switch rate and throughput, so runs
+ * can be diffed across releases.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define AURORA_ENABLE_PATH "/proc/aurora_sched/enabled"
+#define NSEC_PER_USEC 1000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC 1000000000ULL
+
+#define HACKBENCH_MSG_SIZE 100
+
+/*
+ * Latency histogram with 64 linear sub-buckets per power of two, so
+ * percentiles are exact below 128ns and within 1.6% above.
+ */
+#define HIST_SUB_BITS 6
+#define HIST_SUB (1U << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB)
+
+struct lat_stats {
+    uint64_t hist[HIST_BUCKETS];
+    uint64_t nr;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t max_start;
+    uint64_t max_end;
+};
+
+enum bench_workload {
+    BENCH_HACKBENCH,
+    BENCH_SCHBENCH,
+    BENCH_PIPE,
+    BENCH_NR_WORKLOADS
+};
+
+static const char * const bench_names[BENCH_NR_WORKLOADS] = {
+    [BENCH_HACKBENCH] = "hackbench",
+    [BENCH_SCHBENCH]  = "schbench",
+    [BENCH_PIPE]      = "pipe",
+};
+
+struct bench_result {
+    const char *name;
+    const char *policy;
+    unsigned int nr_threads;
+    uint64_t runtime_ns;
+    uint64_t switches;
+    uint64_t elapsed_ns;
+    uint64_t ops;
+    struct lat_stats lat;
+};
+
+/* Tunables */
+static unsigned int opt_groups = 4;
+static unsigned int opt_fds = 10;
+static unsigned int opt_loops = 1000;
+static unsigned int opt_workers = 4;
+static unsigned int opt_think_us = 30;
+static unsigned int opt_pairs = 1;
+static unsigned int opt_duration = 5;
+static unsigned int opt_workloads = (1U << BENCH_NR_WORKLOADS) - 1;
+static bool opt_compare = true;
+
+static uint64_t bench_epoch;
+static atomic_bool bench_stop;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void die(const char *msg)
+{
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int hist_index(uint64_t v)
+{
+    unsigned int shift;
+
+    if (v < 2 * HIST_SUB)
+        return v;
+
+    shift = 63 - __builtin_clzll(v) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB + (unsigned int)((v >> shift) - HIST_SUB);
+}
+
+static uint64_t hist_value(unsigned int idx)
+{
+    unsigned int shift;
+
+    if (idx < 2 * HIST_SUB)
+        return idx;
+
+    shift = idx / HIST_SUB - 1;
+    return (uint64_t)(idx % HIST_SUB + HIST_SUB) << shift;
+}
+
+static void lat_record(struct lat_stats *st, uint64_t start, uint64_t end)
+{
+    uint64_t lat = end > start ? end - start : 0;
+
+    st->hist[hist_index(lat)]++;
+    st->nr++;
+    st->sum += lat;
+    if (lat > st->max) {
+        st->max = lat;
+        st->max_start = start;
+        st->max_end = end;
+    }
+}
+
+static void lat_merge(struct lat_stats *dst, const struct lat_stats *src)
+{
+    unsigned int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++)
+        dst->hist[i] += src->hist[i];
+    dst->nr += src->nr;
+    dst->sum += src->sum;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+        dst->max_start = src->max_start;
+        dst->max_end = src->max_end;
+    }
+}
+
+/* Smallest recorded latency that covers @permille of the samples */
+static uint64_t lat_percentile(const struct lat_stats *st, unsigned int permille)
+{
+    uint64_t target, seen = 0;
+    unsigned int i;
+
+    if (!st->nr)
+        return 0;
+
+    target = (st->nr * permille + 999) / 1000;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += st->hist[i];
+        if (seen >= target)
+            return hist_value(i);
+    }
+    return st->max;
+}
+
+/* System-wide context switches, as accounted in /proc/stat */
+static uint64_t read_ctxt(void)
+{
+    char line[256];
+    uint64_t ctxt = 0;
+    FILE *f;
+
+    f = fopen("/proc/stat", "r");
+    if (!f)
+        return 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "ctxt %" SCNu64, &ctxt) == 1)
+            break;
+    }
+    fclose(f);
+    return ctxt;
+}
+
+static uint64_t read_runtime(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * NSEC_PER_SEC +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * NSEC_PER_USEC;
+}
+
+static int set_aurora_policy(bool enable)
+{
+    FILE *f;
+
+    f = fopen(AURORA_ENABLE_PATH, "w");
+    if (!f)
+        return -errno;
+
+    fputs(enable ? "1\n" : "0\n", f);
+    if (fclose(f))
+        return -errno;
+    return 0;
+}
+
+static void xwrite(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+
+    while (len) {
+        ssize_t ret = write(fd, p, len);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            die("write");
+        }
+        p += ret;
+        len -= ret;
+    }
+}
+
+static bool xread(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+
+    while (len) {
+        ssize_t ret = read(fd, p, len);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            die("read");
+        }
+        if (!ret)
+            return false;
+        p += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+static void spawn(pthread_t *thread, void *(*fn)(void *), void *arg)
+{
+    int ret = pthread_create(thread, NULL, fn, arg);
+
+    if (ret) {
+        errno = ret;
+        die("pthread_create");
+    }
+}
+
+/* hackbench: every sender writes opt_loops messages to each receiver */
+struct hb_msg {
+    uint64_t ts;
+    char pad[HACKBENCH_MSG_SIZE - sizeof(uint64_t)];
+};
+
+struct hb_thread {
+    pthread_t thread;
+    int *fds;
+    int fd;
+    uint64_t ops;
+    struct lat_stats lat;
+};
+
+static void *hb_sender(void *arg)
+{
+    struct hb_thread *t = arg;
+    struct hb_msg msg;
+    unsigned int i, j;
+
+    memset(&msg, 0, sizeof(msg));
+    for (i = 0; i < opt_loops; i++) {
+        for (j = 0; j < opt_fds; j++) {
+            msg.ts = now_ns();
+            xwrite(t->fds[j], &msg, sizeof(msg));
+        }
+    }
+    return NULL;
+}
+
+static void *hb_receiver(void *arg)
+{
+    struct hb_thread *t = arg;
+    struct hb_msg msg;
+    uint64_t i;
+
+    for (i = 0; i < (uint64_t)opt_loops * opt_fds; i++) {
+        if (!xread(t->fd, &msg, sizeof(msg)))
+            break;
+        lat_record(&t->lat, msg.ts, now_ns());
+        t->ops++;
+    }
+    return NULL;
+}
+
+static unsigned int run_hackbench(struct bench_result *res)
+{
+    unsigned int nr = opt_groups * opt_fds;
+    struct hb_thread *senders, *receivers;
+    int *wfds;
+    unsigned int g, i;
+
+    senders = calloc(nr, sizeof(*senders));
+    receivers = calloc(nr, sizeof(*receivers));
+    wfds = calloc(nr, sizeof(*wfds));
+    if (!senders || !receivers || !wfds)
+        die("calloc");
+
+    for (i = 0; i < nr; i++) {
+        int fds[2];
+
+        if (pipe(fds))
+            die("pipe");
+        receivers[i].fd = fds[0];
+        wfds[i] = fds[1];
+    }
+
+    for (g = 0; g < opt_groups; g++) {
+        for (i = 0; i < opt_fds; i++) {
+            senders[g * opt_fds + i].fds = &wfds[g * opt_fds];
+            spawn(&receivers[g * opt_fds + i].thread, hb_receiver,
+                  &receivers[g * opt_fds + i]);
+        }
+    }
+    for (i = 0; i < nr; i++)
+        spawn(&senders[i].thread, hb_sender, &senders[i]);
+
+    for (i = 0; i < nr; i++)
+        pthread_join(senders[i].thread, NULL);
+    for (i = 0; i < nr; i++) {
+        pthread_join(receivers[i].thread, NULL);
+        lat_merge(&res->lat, &receivers[i].lat);
+        res->ops += receivers[i].ops;
+        close(receivers[i].fd);
+        close(wfds[i]);
+    }
+
+    free(wfds);
+    free(receivers);
+    free(senders);
+    return 2 * nr;
+}
+
+/* schbench: a message thread wakes its workers, which think and report back */
+struct sb_group;
+
+struct sb_worker {
+    pthread_t thread;
+    struct sb_group *group;
+    _Atomic uint32_t futex;
+    uint64_t ops;
+    struct lat_stats lat;
+};
+
+struct sb_group {
+    pthread_t thread;
+    struct sb_worker *workers;
+    _Atomic uint32_t pending;
+    _Atomic uint64_t wake_ts;
+};
+
+static long futex(_Atomic uint32_t *uaddr, int op, uint32_t val)
+{
+    return syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+}
+
+static void futex_wait_while(_Atomic uint32_t *uaddr, uint32_t val)
+{
+    while (atomic_load(uaddr) == val)
+        futex(uaddr, FUTEX_WAIT_PRIVATE, val);
+}
+
+static void think(unsigned int usec)
+{
+    uint64_t end = now_ns() + usec * NSEC_PER_USEC;
+
+    while (now_ns() < end)
+        ;
+}
+
+static void *sb_worker_fn(void *arg)
+{
+    struct sb_worker *w = arg;
+    struct sb_group *g = w->group;
+    bool stop;
+
+    do {
+        futex_wait_while(&w->futex, 0);
+        atomic_store(&w->futex, 0);
+
+        /* Still report back when stopping, the message thread may be waiting */
+        stop = atomic_load(&bench_stop);
+        if (!stop) {
+            lat_record(&w->lat, atomic_load(&g->wake_ts), now_ns());
+            think(opt_think_us);
+            w->ops++;
+        }
+
+        if (atomic_fetch_sub(&g->pending, 1) == 1)
+            futex(&g->pending, FUTEX_WAKE_PRIVATE, 1);
+    } while (!stop);
+
+    return NULL;
+}
+
+static void *sb_message_fn(void *arg)
+{
+    struct sb_group *g = arg;
+    unsigned int i;
+
+    while (!atomic_load(&bench_stop)) {
+        atomic_store(&g->pending, opt_workers);
+        atomic_store(&g->wake_ts, now_ns());
+        for (i = 0; i < opt_workers; i++) {
+            atomic_store(&g->workers[i].futex, 1);
+            futex(&g->workers[i].futex, FUTEX_WAKE_PRIVATE, 1);
+        }
+
+        for (;;) {
+            uint32_t pending = atomic_load(&g->pending);
+
+            if (!pending)
+                break;
+            futex(&g->pending, FUTEX_WAIT_PRIVATE, pending);
+        }
+    }
+    return NULL;
+}
+
+static unsigned int run_schbench(struct bench_result *res)
+{
+    struct sb_group *groups;
+    unsigned int g, i;
+
+    groups = calloc(opt_groups, sizeof(*groups));
+    if (!groups)
+        die("calloc");
+
+    for (g = 0; g < opt_groups; g++) {
+        groups[g].workers = calloc(opt_workers, sizeof(struct sb_worker));
+        if (!groups[g].workers)
+            die("calloc");
+        for (i = 0; i < opt_workers; i++) {
+            groups[g].workers[i].group = &groups[g];
+            spawn(&groups[g].workers[i].thread, sb_worker_fn,
+                  &groups[g].workers[i]);
+        }
+        spawn(&groups[g].thread, sb_message_fn, &groups[g]);
+    }
+
+    sleep(opt_duration);
+    atomic_store(&bench_stop, true);
+
+    for (g = 0; g < opt_groups; g++) {
+        pthread_join(groups[g].thread, NULL);
+        for (i = 0; i < opt_workers; i++) {
+            struct sb_worker *w = &groups[g].workers[i];
+
+            atomic_store(&w->futex, 1);
+            futex(&w->futex, FUTEX_WAKE_PRIVATE, 1);
+            pthread_join(w->thread, NULL);
+            lat_merge(&res->lat, &w->lat);
+            res->ops += w->ops;
+        }
+        free(groups[g].workers);
+    }
+
+    free(groups);
+    return opt_groups * (opt_workers + 1);
+}
+
+/* pipe: two threads bounce a timestamped token until the run ends */
+struct pp_thread {
+    pthread_t thread;
+    int rfd, wfd;
+    bool initiator;
+    uint64_t ops;
+    struct lat_stats lat;
+};
+
+static void *pp_thread_fn(void *arg)
+{
+    struct pp_thread *t = arg;
+    uint64_t ts;
+
+    if (t->initiator) {
+        ts = now_ns();
+        xwrite(t->wfd, &ts, sizeof(ts));
+    }
+
+    for (;;) {
+        if (!xread(t->rfd, &ts, sizeof(ts)))
+            break;
+        lat_record(&t->lat, ts, now_ns());
+        t->ops++;
+        if (atomic_load(&bench_stop))
+            break;
+        ts = now_ns();
+        xwrite(t->wfd, &ts, sizeof(ts));
+    }
+
+    /* Closing our write end unblocks the peer */
+    close(t->wfd);
+    return NULL;
+}
+
+static unsigned int run_pipe(struct bench_result *res)
+{
+    struct pp_thread *threads;
+    unsigned int i;
+
+    threads = calloc(2 * opt_pairs, sizeof(*threads));
+    if (!threads)
+        die("calloc");
+
+    for (i = 0; i < opt_pairs; i++) {
+        struct pp_thread *a = &threads[2 * i], *b = &threads[2 * i + 1];
+        int ab[2], ba[2];
+
+        if (pipe(ab) || pipe(ba))
+            die("pipe");
+        a->wfd = ab[1];
+        b->rfd = ab[0];
+        b->wfd = ba[1];
+        a->rfd = ba[0];
+        a->initiator = true;
+    }
+    for (i = 0; i < 2 * opt_pairs; i++)
+        spawn(&threads[i].thread, pp_thread_fn, &threads[i]);
+
+    sleep(opt_duration);
+    atomic_store(&bench_stop, true);
+
+    for (i = 0; i < 2 * opt_pairs; i++) {
+        pthread_join(threads[i].thread, NULL);
+        close(threads[i].rfd);
+        lat_merge(&res->lat, &threads[i].lat);
+    }
+    /* Each round trip is two hand-offs */
+    for (i = 0; i < 2 * opt_pairs; i++)
+        res->ops += threads[i].ops;
+    res->ops /= 2;
+
+    free(threads);
+    return 2 * opt_pairs;
+}
+
+static unsigned int (* const bench_fns[BENCH_NR_WORKLOADS])(struct bench_result *) = {
+    [BENCH_HACKBENCH] = run_hackbench,
+    [BENCH_SCHBENCH]  = run_schbench,
+    [BENCH_PIPE]      = run_pipe,
+};
+
+static void run_bench(enum bench_workload w, const char *policy,
+                      struct bench_result *res)
+{
+    uint64_t start, ctxt, runtime;
+
+    memset(res, 0, sizeof(*res));
+    res->name = bench_names[w];
+    res->policy = policy;
+    atomic_store(&bench_stop, false);
+
+    ctxt = read_ctxt();
+    runtime = read_runtime();
+    start = now_ns();
+
+    res->nr_threads = bench_fns[w](res);
+
+    res->elapsed_ns = now_ns() - start;
+    res->runtime_ns = read_runtime() - runtime;
+    res->switches = read_ctxt() - ctxt;
+}
+
+static void format_ts(uint64_t ts, char *buf, size_t len)
+{
+    ts = ts > bench_epoch ? ts - bench_epoch : 0;
+    snprintf(buf, len, "%" PRIu64 ".%06" PRIu64,
+             (uint64_t)(ts / NSEC_PER_SEC),
+             (uint64_t)(ts % NSEC_PER_SEC / NSEC_PER_USEC));
+}
+
+/* One row in the layout of output_lat_thread() in tools/perf/builtin-sched.c */
+static void print_lat_row(const struct bench_result *res)
+{
+    char task[64], max_start[32], max_end[32];
+    uint64_t avg = res->lat.nr ? res->lat.sum / res->lat.nr : 0;
+    int i, ret;
+
+    snprintf(task, sizeof(task), "%s-%s:(%u)", res->name, res->policy,
+             res->nr_threads);
+    ret = printf("  %s ", task);
+    for (i = 0; i < 24 - ret; i++)
+        printf(" ");
+
+    format_ts(res->lat.max_start, max_start, sizeof(max_start));
+    format_ts(res->lat.max_end, max_end, sizeof(max_end));
+
+    printf("|%11.3f ms |%9" PRIu64 " | avg:%8.3f ms | max:%8.3f ms | max start: %12s s | max end: %12s s\n",
+           (double)res->runtime_ns / NSEC_PER_MSEC, res->switches,
+           (double)avg / NSEC_PER_MSEC, (double)res->lat.max / NSEC_PER_MSEC,
+           max_start, max_end);
+}
+
+static void print_results(const struct bench_result *results, unsigned int nr)
+{
+    uint64_t all_runtime = 0, all_count = 0;
+    unsigned int i;
+
+    printf("\n -------------------------------------------------------------------------------------------------------------------------------------------\n");
+    printf("  Task                  |   Runtime ms  | Switches | Avg delay ms    | Max delay ms    | Max delay start           | Max delay end          |\n");
+    printf(" -------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+    for (i = 0; i < nr; i++) {
+        print_lat_row(&results[i]);
+        all_runtime += results[i].runtime_ns;
+        all_count += results[i].switches;
+    }
+
+    printf(" -----------------------------------------------------------------------------------------------------------------\n");
+    printf("  TOTAL:                |%11.3f ms |%9" PRIu64 " |\n",
+           (double)all_runtime / NSEC_PER_MSEC, all_count);
+    printf(" ---------------------------------------------------\n");
+
+    printf("\n ---------------------------------------------------------------------------------------------\n");
+    printf("  Task                  |    p50 usec |    p99 usec |  p99.9 usec |   Switches/s |       Ops/s |\n");
+    printf(" ---------------------------------------------------------------------------------------------\n");
+
+    for (i = 0; i < nr; i++) {
+        const struct bench_result *res = &results[i];
+        double secs = (double)res->elapsed_ns / NSEC_PER_SEC;
+        char task[64];
+        int j, ret;
+
+        snprintf(task, sizeof(task), "%s-%s:(%u)", res->name, res->policy,
+                 res->nr_threads);
+        ret = printf("  %s ", task);
+        for (j = 0; j < 24 - ret; j++)
+            printf(" ");
+
+        printf("|%12.3f |%12.3f |%12.3f |%13.0f |%12.0f |\n",
+               (double)lat_percentile(&res->lat, 500) / NSEC_PER_USEC,
+               (double)lat_percentile(&res->lat, 990) / NSEC_PER_USEC,
+               (double)lat_percentile(&res->lat, 999) / NSEC_PER_USEC,
+               secs > 0 ? res->switches / secs : 0,
+               secs > 0 ? res->ops / secs : 0);
+    }
+    printf(" ---------------------------------------------------------------------------------------------\n\n");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -w, --workload=LIST   hackbench,schbench,pipe (default: all)\n"
+            "  -g, --groups=N        hackbench/schbench groups (default: %u)\n"
+            "  -f, --fds=N           hackbench senders/receivers per group (default: %u)\n"
+            "  -l, --loops=N         hackbench messages per sender and receiver (default: %u)\n"
+            "  -m, --workers=N       schbench workers per message thread (default: %u)\n"
+            "  -t, --think=USEC      schbench worker think time (default: %u)\n"
+            "  -p, --pairs=N         pipe ping-pong pairs (default: %u)\n"
+            "  -d, --duration=SEC    schbench/pipe run time (default: %u)\n"
+            "  -n, --no-compare      run under the current policy only\n",
+            prog, opt_groups, opt_fds, opt_loops, opt_workers, opt_think_us,
+            opt_pairs, opt_duration);
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int parse_workloads(char *list, const char *prog)
+{
+    unsigned int mask = 0;
+    char *tok, *save;
+    int w;
+
+    for (tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        for (w = 0; w < BENCH_NR_WORKLOADS; w++) {
+            if (!strcmp(tok, bench_names[w]))
+                break;
+        }
+        if (w == BENCH_NR_WORKLOADS)
+            usage(prog);
+        mask |= 1U << w;
+    }
+    return mask;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option longopts[] = {
+        { "workload",   required_argument, NULL, 'w' },
+        { "groups",     required_argument, NULL, 'g' },
+        { "fds",        required_argument, NULL, 'f' },
+        { "loops",      required_argument, NULL, 'l' },
+        { "workers",    required_argument, NULL, 'm' },
+        { "think",      required_argument, NULL, 't' },
+        { "pairs",      required_argument, NULL, 'p' },
+        { "duration",   required_argument, NULL, 'd' },
+        { "no-compare", no_argument,       NULL, 'n' },
+        { NULL, 0, NULL, 0 }
+    };
+    static const char * const policies[] = { "cfs", "aurora" };
+    struct bench_result results[2 * BENCH_NR_WORKLOADS];
+    unsigned int nr_results = 0, nr_policies = 2, p;
+    int opt, w;
+
+    while ((opt = getopt_long(argc, argv, "w:g:f:l:m:t:p:d:n", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'w': opt_workloads = parse_workloads(optarg, argv[0]); break;
+        case 'g': opt_groups = strtoul(optarg, NULL, 0); break;
+        case 'f': opt_fds = strtoul(optarg, NULL, 0); break;
+        case 'l': opt_loops = strtoul(optarg, NULL, 0); break;
+        case 'm': opt_workers = strtoul(optarg, NULL, 0); break;
+        case 't': opt_think_us = strtoul(optarg, NULL, 0); break;
+        case 'p': opt_pairs = strtoul(optarg, NULL, 0); break;
+        case 'd': opt_duration = strtoul(optarg, NULL, 0); break;
+        case 'n': opt_compare = false; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if (!opt_groups || !opt_fds || !opt_workers || !opt_pairs || !opt_duration)
+        usage(argv[0]);
+
+    if (opt_compare && set_aurora_policy(false)) {
+        fprintf(stderr, "%s: cannot write %s, is ai_scheduler.ko loaded? "
+                "Running under the current policy only.\n",
+                argv[0], AURORA_ENABLE_PATH);
+        opt_compare = false;
+    }
+    if (!opt_compare)
+        nr_policies = 1;
+
+    bench_epoch = now_ns();
+
+    for (p = 0; p < nr_policies; p++) {
+        const char *policy = opt_compare ? policies[p] : "current";
+
+        if (opt_compare && set_aurora_policy(p == 1))
+            die("set_aurora_policy");
+
+        for (w = 0; w < BENCH_NR_WORKLOADS; w++) {
+            if (!(opt_workloads & (1U << w)))
+                continue;
+            run_bench(w, policy, &results[nr_results++]);
+        }
+    }
+
+    if (opt_compare)
+        set_aurora_policy(false);
+
+    print_results(results, nr_results);
+    return 0;
+}
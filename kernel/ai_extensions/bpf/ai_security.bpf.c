@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS - AI Security BPF LSM Fast Path
+ *
+ * Load with ai_security.ko in offload mode (ai_security_offload=1). These
+ * programs take over the hook decisions of the built-in LSM hooks: the
+ * static rules run here, verdicts are cached in inode local storage
+ * keyed on the module's verdict generation, and the module is called
+ * for the intelligence sets and the final, policy-driven decision.
+ *
+ * Each inode is labelled once at open from its full path, and the open
+ * or mmap decides every access the file mode allows; file_permission
+ * hits that verdict until the generation moves.
+ *
+ * Policy changes (threshold, auto response, new intelligence) move the
+ * generation, so cached verdicts expire without reloading anything.
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_endian.h>
+
+#define EACCES      13
+#define AF_INET     2
+#define AF_INET6    10
+
+/* Macros that vmlinux.h does not carry */
+#define FMODE_READ  0x1
+#define FMODE_WRITE 0x2
+#define FMODE_EXEC  0x20
+#define O_APPEND    00002000
+#define MAY_EXEC    0x1
+#define MAY_WRITE   0x2
+#define MAY_READ    0x4
+#define MAY_APPEND  0x8
+#define PROT_WRITE  0x2
+#define PROT_EXEC   0x4
+#define MAP_SHARED  0x01
+#define MAP_TYPE    0x0f
+
+/* Mirrors enum ai_security_event_type */
+#define AI_SECURITY_EVENT_FILE_ACCESS       0
+#define AI_SECURITY_EVENT_NETWORK_CONNECT   1
+#define AI_SECURITY_EVENT_PROCESS_EXEC      2
+
+/* Mirrors enum ai_security_match_class */
+#define AI_SECURITY_MATCH_SENSITIVE         (1U << 0)
+#define AI_SECURITY_MATCH_TEMP_EXEC         (1U << 1)
+#define AI_SECURITY_MATCH_INTEL_PATH        (1U << 2)
+#define AI_SECURITY_MATCH_INTEL_COMMAND     (1U << 3)
+
+/* Mirrors AI_SECURITY_LABEL_* */
+#define AI_SECURITY_LABEL_SENSITIVE         (1U << 0)
+#define AI_SECURITY_LABEL_INTEL             (1U << 3)
+#define AI_SECURITY_LABEL_VALID             (1U << 7)
+
+#define AI_SECURITY_NAME_LEN                64
+#define AI_SECURITY_PATH_LEN                256
+
+/* Provided by ai_security.ko */
+extern u32 bpf_ai_security_gen(struct task_struct *task) __ksym;
+extern u32 bpf_ai_security_match(const char *str, u32 str__sz) __ksym;
+extern u32 bpf_ai_security_label(const char *path, u32 path__sz) __ksym;
+extern u32 bpf_ai_security_intel_gen(void) __ksym;
+extern bool bpf_ai_security_malicious_ip(const u32 *addr, u32 addr__sz) __ksym;
+extern int bpf_ai_security_track(struct task_struct *task) __ksym;
+extern void bpf_ai_security_untrack(struct task_struct *task) __ksym;
+extern int bpf_ai_security_decide(struct task_struct *task, u32 type, u32 score) __ksym;
+
+/* Per-task profile state; the profile itself lives in the module */
+struct ai_security_task_state {
+    u32 tracked;
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_TASK_STORAGE);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+    __type(key, int);
+    __type(value, struct ai_security_task_state);
+} ai_security_tasks SEC(".maps");
+
+/*
+ * Label and last verdict for an inode. The label holds for everyone
+ * until the intelligence generation moves; like the module's per-profile
+ * cache, the verdict is valid for one task, one access mask and one
+ * verdict generation.
+ */
+struct ai_security_inode_verdict {
+    u32 gen;
+    pid_t pid;
+    int mask;
+    u32 deny;
+    u32 label;
+    u32 label_gen;
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_INODE_STORAGE);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+    __type(key, int);
+    __type(value, struct ai_security_inode_verdict);
+} ai_security_inodes SEC(".maps");
+
+/* Create the module profile the first time a task is seen sleepable */
+static void ai_security_track(struct task_struct *task)
+{
+    struct ai_security_task_state *state;
+
+    state = bpf_task_storage_get(&ai_security_tasks, task, NULL,
+                                 BPF_LOCAL_STORAGE_GET_F_CREATE);
+    if (!state || state->tracked)
+        return;
+
+    if (!bpf_ai_security_track(task))
+        state->tracked = 1;
+}
+
+SEC("lsm.s/bprm_check_security")
+int BPF_PROG(ai_security_bprm_check, struct linux_binprm *bprm)
+{
+    struct task_struct *task = bpf_get_current_task_btf();
+    char path[AI_SECURITY_PATH_LEN];
+    u32 match, score = 0;
+
+    ai_security_track(task);
+
+    if (bpf_probe_read_kernel_str(path, sizeof(path), bprm->filename) < 0)
+        return 0;
+
+    match = bpf_ai_security_match(path, sizeof(path));
+    if (match & AI_SECURITY_MATCH_TEMP_EXEC)
+        score += 40;    /* Executing from temp directory */
+    if (match & (AI_SECURITY_MATCH_INTEL_PATH | AI_SECURITY_MATCH_INTEL_COMMAND))
+        score += 50;    /* Known suspicious executable */
+
+    return bpf_ai_security_decide(task, AI_SECURITY_EVENT_PROCESS_EXEC, score) ? -EACCES : 0;
+}
+
+/*
+ * Decide @mask access to @file and cache the verdict on the inode. The
+ * verdict covers any access within the mask it was made for.
+ */
+static __always_inline int ai_security_file_decide(struct task_struct *task,
+                                                   struct file *file, int mask)
+{
+    struct ai_security_inode_verdict *v;
+    char name[AI_SECURITY_NAME_LEN];
+    u32 match, label = 0, score = 0, gen;
+    pid_t pid = task->pid;
+    int deny;
+
+    /* Skip system processes */
+    if (pid <= 1)
+        return 0;
+
+    v = bpf_inode_storage_get(&ai_security_inodes, file->f_inode, NULL,
+                              BPF_LOCAL_STORAGE_GET_F_CREATE);
+
+    /* Steady-state IO stops here */
+    gen = bpf_ai_security_gen(task);
+    if (v && v->gen == gen && v->pid == pid && !(mask & ~v->mask))
+        return v->deny ? -EACCES : 0;
+
+    if (v && (v->label & AI_SECURITY_LABEL_VALID) &&
+        v->label_gen == bpf_ai_security_intel_gen()) {
+        label = v->label;
+    } else {
+        if (bpf_probe_read_kernel_str(name, sizeof(name),
+                                      file->f_path.dentry->d_name.name) < 0)
+            return 0;
+
+        match = bpf_ai_security_match(name, sizeof(name));
+        if (match & AI_SECURITY_MATCH_SENSITIVE)
+            label |= AI_SECURITY_LABEL_SENSITIVE;
+        if (match & AI_SECURITY_MATCH_INTEL_PATH)
+            label |= AI_SECURITY_LABEL_INTEL;
+    }
+
+    if (label & AI_SECURITY_LABEL_SENSITIVE)
+        score += 30;
+    if (label & AI_SECURITY_LABEL_INTEL)
+        score += 40;    /* Known suspicious path */
+
+    deny = bpf_ai_security_decide(task, AI_SECURITY_EVENT_FILE_ACCESS, score);
+    if (v) {
+        v->gen = gen;
+        v->pid = pid;
+        v->mask = mask;
+        v->deny = deny;
+    }
+
+    return deny ? -EACCES : 0;
+}
+
+/*
+ * The decision is made at open: label the inode from its full path,
+ * then decide every access the open mode allows. Processes that predate
+ * the programs are also picked up here, on their next open.
+ */
+SEC("lsm.s/file_open")
+int BPF_PROG(ai_security_file_open, struct file *file)
+{
+    struct task_struct *task = bpf_get_current_task_btf();
+    struct ai_security_inode_verdict *v;
+    char path[AI_SECURITY_PATH_LEN];
+    int mask = 0;
+    u32 gen;
+
+    ai_security_track(task);
+
+    v = bpf_inode_storage_get(&ai_security_inodes, file->f_inode, NULL,
+                              BPF_LOCAL_STORAGE_GET_F_CREATE);
+    gen = bpf_ai_security_intel_gen();
+    if (v && !((v->label & AI_SECURITY_LABEL_VALID) && v->label_gen == gen) &&
+        bpf_d_path(&file->f_path, path, sizeof(path)) >= 0) {
+        v->label = bpf_ai_security_label(path, sizeof(path));
+        v->label_gen = gen;
+    }
+
+    if (file->f_mode & FMODE_READ)
+        mask |= MAY_READ;
+    if (file->f_mode & FMODE_WRITE)
+        mask |= MAY_WRITE;
+    if (file->f_mode & FMODE_EXEC)
+        mask |= MAY_EXEC;
+    if (file->f_flags & O_APPEND)
+        mask |= MAY_APPEND;
+
+    return ai_security_file_decide(task, file, mask);
+}
+
+SEC("lsm.s/mmap_file")
+int BPF_PROG(ai_security_mmap_file, struct file *file, unsigned long reqprot,
+             unsigned long prot, unsigned long flags)
+{
+    int mask = MAY_READ;
+
+    if (!file)
+        return 0;
+
+    if (prot & PROT_EXEC)
+        mask |= MAY_EXEC;
+    if ((prot & PROT_WRITE) && (flags & MAP_TYPE) == MAP_SHARED)
+        mask |= MAY_WRITE;
+
+    return ai_security_file_decide(bpf_get_current_task_btf(), file, mask);
+}
+
+/* Re-decided only once the verdict generation moves */
+SEC("lsm/file_permission")
+int BPF_PROG(ai_security_file_permission, struct file *file, int mask)
+{
+    return ai_security_file_decide(bpf_get_current_task_btf(), file, mask);
+}
+
+SEC("lsm/socket_connect")
+int BPF_PROG(ai_security_socket_connect, struct socket *sock, struct sockaddr *address,
+             int addrlen)
+{
+    struct task_struct *task = bpf_get_current_task_btf();
+    struct sockaddr_in6 *sin6;
+    struct sockaddr_in *sin;
+    u32 addr[4] = {};
+    u32 score = 0;
+
+    if (task->pid <= 1)
+        return 0;
+
+    /* IPv4 is looked up v4-mapped, as the module stores it */
+    if (address->sa_family == AF_INET && addrlen >= sizeof(*sin)) {
+        sin = (struct sockaddr_in *)address;
+        addr[2] = bpf_htonl(0xffff);
+        addr[3] = BPF_CORE_READ(sin, sin_addr.s_addr);
+    } else if (address->sa_family == AF_INET6 && addrlen >= sizeof(*sin6)) {
+        sin6 = (struct sockaddr_in6 *)address;
+        if (bpf_probe_read_kernel(addr, sizeof(addr), &sin6->sin6_addr))
+            return 0;
+    } else {
+        return 0;
+    }
+
+    if (bpf_ai_security_malicious_ip(addr, sizeof(addr)))
+        score += 60;    /* Known malicious endpoint */
+
+    /* Clean connects are not events, as in the built-in hook */
+    if (!score)
+        return 0;
+
+    return bpf_ai_security_decide(task, AI_SECURITY_EVENT_NETWORK_CONNECT, score) ? -EACCES : 0;
+}
+
+/* Profiles go with their task; task storage is freed by the kernel */
+SEC("lsm/task_free")
+void BPF_PROG(ai_security_task_free, struct task_struct *task)
+{
+    bpf_ai_security_untrack(task);
+}
+
+char LICENSE[] SEC("license") = "GPL";
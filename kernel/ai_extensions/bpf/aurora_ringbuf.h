@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Aurora OS - Per-CPU sharded BPF ring buffers
+ *
+ * A BPF_MAP_TYPE_RINGBUF has one reserve spinlock that every producing
+ * CPU takes, and with the tracing programs on 100+ CPUs that lock is
+ * where the time goes. The kernel already handles the sharded variant:
+ * ring buffers can be the inner maps of a BPF_MAP_TYPE_ARRAY_OF_MAPS,
+ * and libbpf's ring_buffer__add() puts any number of them behind the
+ * epoll fd of one struct ring_buffer. This header declares such an
+ * array with one slot per CPU and reserves from the slot of the CPU the
+ * program runs on, so producers never share a lock or a cache line.
+ *
+ *   AURORA_RINGBUF_SHARDED(events, 256 * 1024);
+ *
+ *   e = aurora_ringbuf_reserve(&events, sizeof(*e));
+ *   if (!e)
+ *       return 0;
+ *   ...
+ *   aurora_ringbuf_submit(&events, e);
+ *
+ * Userspace sizes the outer map to the number of possible CPUs before
+ * loading (bpf_map__set_max_entries()). After loading it creates one
+ * BPF_MAP_TYPE_RINGBUF per CPU with bpf_map_create(), stores its fd in
+ * slot <cpu> and hands it to ring_buffer__new() or ring_buffer__add().
+ * A CPU without a shard drops its records and counts them.
+ *
+ * Wakeups are coalesced. A submit only wakes the consumer once a shard
+ * holds aurora_ringbuf_wakeup_bytes of unread data. Below that, records
+ * wait for the consumer's epoll_wait() timeout, which sets the worst
+ * case latency. A watermark of 0 keeps the stock behaviour of the
+ * kernel: wake when the consumer has caught up.
+ */
+
+#ifndef _AURORA_RINGBUF_H
+#define _AURORA_RINGBUF_H
+
+#include <bpf/bpf_helpers.h>
+
+/* Set before loading; 0 wakes the consumer as the kernel does by default */
+const volatile u64 aurora_ringbuf_wakeup_bytes = 64 * 1024;
+
+enum aurora_ringbuf_stat {
+    AURORA_RINGBUF_STAT_SUBMITTED,  /* records handed to the consumer */
+    AURORA_RINGBUF_STAT_DROPPED,    /* shard full or missing */
+    AURORA_RINGBUF_STAT_WAKEUPS,    /* forced consumer wakeups */
+    AURORA_RINGBUF_NR_STATS,
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, AURORA_RINGBUF_NR_STATS);
+    __type(key, u32);
+    __type(value, u64);
+} aurora_ringbuf_stats SEC(".maps");
+
+/*
+ * One ring buffer of @size bytes (a power of 2 multiple of the page size)
+ * per CPU. max_entries is only the default for the outer map; userspace
+ * resizes it to the number of possible CPUs.
+ */
+#define AURORA_RINGBUF_SHARDED(name, size)                      \
+    struct {                                                    \
+        __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);               \
+        __uint(max_entries, 1);                                 \
+        __type(key, u32);                                       \
+        __array(values, struct {                                \
+            __uint(type, BPF_MAP_TYPE_RINGBUF);                 \
+            __uint(max_entries, size);                          \
+        });                                                     \
+    } name SEC(".maps")
+
+static __always_inline void aurora_ringbuf_count(u32 stat)
+{
+    u64 *count = bpf_map_lookup_elem(&aurora_ringbuf_stats, &stat);
+
+    if (count)
+        (*count)++;
+}
+
+static __always_inline void *aurora_ringbuf_shard(void *outer)
+{
+    u32 cpu = bpf_get_smp_processor_id();
+
+    return bpf_map_lookup_elem(outer, &cpu);
+}
+
+static __always_inline void *aurora_ringbuf_reserve(void *outer, u64 size)
+{
+    void *shard = aurora_ringbuf_shard(outer);
+    void *rec = NULL;
+
+    if (shard)
+        rec = bpf_ringbuf_reserve(shard, size, 0);
+    if (!rec)
+        aurora_ringbuf_count(AURORA_RINGBUF_STAT_DROPPED);
+    return rec;
+}
+
+/*
+ * Must run on the CPU that reserved @rec, which holds for any program
+ * that does not sleep between the two calls.
+ */
+static __always_inline void aurora_ringbuf_submit(void *outer, void *rec)
+{
+    void *shard = aurora_ringbuf_shard(outer);
+    u64 flags = 0;
+
+    if (aurora_ringbuf_wakeup_bytes && shard) {
+        if (bpf_ringbuf_query(shard, BPF_RB_AVAIL_DATA) >=
+            aurora_ringbuf_wakeup_bytes) {
+            flags = BPF_RB_FORCE_WAKEUP;
+            aurora_ringbuf_count(AURORA_RINGBUF_STAT_WAKEUPS);
+        } else {
+            flags = BPF_RB_NO_WAKEUP;
+        }
+    }
+
+    bpf_ringbuf_submit(rec, flags);
+    aurora_ringbuf_count(AURORA_RINGBUF_STAT_SUBMITTED);
+}
+
+#endif /* _AURORA_RINGBUF_H */
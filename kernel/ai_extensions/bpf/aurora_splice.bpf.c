@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS - Loopback socket splicing for local services
+ *
+ * MCP servers and the other local services talk over loopback TCP, so each
+ * message goes down one full stack and back up another. These programs
+ * short cut that with a sockmap: once both ends of a loopback connection
+ * to a registered endpoint are established, data sent on one socket is
+ * queued straight onto the receive queue of its peer, skipping TCP/IP and
+ * the loopback device altogether.
+ *
+ * aurora_splice_endpoints is the policy: a connection is spliced only when
+ * its server side port is in it. Everything else, and any message whose
+ * peer is not (or no longer) in aurora_splice_socks, goes through the
+ * stack as usual, so unloading the programs never breaks a connection.
+ *
+ *   bpftool prog loadall bpf/aurora_splice.bpf.o /sys/fs/bpf/aurora_splice
+ *   bpftool cgroup attach /sys/fs/cgroup sock_ops \
+ *           pinned /sys/fs/bpf/aurora_splice/aurora_splice_sockops
+ *   bpftool prog attach pinned /sys/fs/bpf/aurora_splice/aurora_splice_msg \
+ *           msg_verdict pinned <aurora_splice_socks map>
+ *   bpftool map update pinned <aurora_splice_endpoints map> \
+ *           key <port, host order, 4 bytes> value 1 0 0 0
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_endian.h>
+
+#define AF_INET     2
+#define AF_INET6    10
+
+#define AURORA_SPLICE_MAX_SOCKS     65536
+#define AURORA_SPLICE_MAX_ENDPOINTS 1024
+
+/* Both directions of a connection, as seen from one of its sockets */
+struct aurora_splice_key {
+    u32 family;
+    u32 local_ip[4];
+    u32 remote_ip[4];
+    u32 local_port;     /* host byte order */
+    u32 remote_port;    /* host byte order */
+};
+
+/* Established loopback sockets, keyed by their own view of the tuple */
+struct {
+    __uint(type, BPF_MAP_TYPE_SOCKHASH);
+    __uint(max_entries, AURORA_SPLICE_MAX_SOCKS);
+    __type(key, struct aurora_splice_key);
+    __type(value, u64);
+} aurora_splice_socks SEC(".maps");
+
+/* Registered endpoints: server port (host byte order) -> enabled */
+struct {
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, AURORA_SPLICE_MAX_ENDPOINTS);
+    __type(key, u32);
+    __type(value, u32);
+} aurora_splice_endpoints SEC(".maps");
+
+enum aurora_splice_stat {
+    AURORA_SPLICE_STAT_SOCKS,       /* sockets added to the sockhash */
+    AURORA_SPLICE_STAT_REDIRECTED,  /* messages handed to the peer */
+    AURORA_SPLICE_STAT_FALLBACK,    /* messages left to the stack */
+    AURORA_SPLICE_NR_STATS,
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, AURORA_SPLICE_NR_STATS);
+    __type(key, u32);
+    __type(value, u64);
+} aurora_splice_stats SEC(".maps");
+
+static void aurora_splice_count(u32 stat)
+{
+    u64 *count = bpf_map_lookup_elem(&aurora_splice_stats, &stat);
+
+    if (count)
+        (*count)++;
+}
+
+static bool aurora_splice_loopback(u32 family, const u32 *ip)
+{
+    if (family == AF_INET)
+        return (bpf_ntohl(ip[0]) >> 24) == 127;
+
+    return family == AF_INET6 && !ip[0] && !ip[1] && !ip[2] &&
+           ip[3] == bpf_htonl(1);
+}
+
+static bool aurora_splice_registered(u32 port)
+{
+    u32 *enabled = bpf_map_lookup_elem(&aurora_splice_endpoints, &port);
+
+    return enabled && *enabled;
+}
+
+SEC("sockops")
+int aurora_splice_sockops(struct bpf_sock_ops *skops)
+{
+    struct aurora_splice_key key = {};
+    u32 server_port;
+
+    switch (skops->op) {
+    case BPF_SOCK_OPS_ACTIVE_ESTABLISHED_CB:
+        server_port = bpf_ntohl(skops->remote_port);
+        break;
+    case BPF_SOCK_OPS_PASSIVE_ESTABLISHED_CB:
+        server_port = skops->local_port;
+        break;
+    default:
+        return 1;
+    }
+
+    key.family = skops->family;
+    if (key.family == AF_INET) {
+        key.local_ip[0] = skops->local_ip4;
+        key.remote_ip[0] = skops->remote_ip4;
+    } else if (key.family == AF_INET6) {
+        key.local_ip[0] = skops->local_ip6[0];
+        key.local_ip[1] = skops->local_ip6[1];
+        key.local_ip[2] = skops->local_ip6[2];
+        key.local_ip[3] = skops->local_ip6[3];
+        key.remote_ip[0] = skops->remote_ip6[0];
+        key.remote_ip[1] = skops->remote_ip6[1];
+        key.remote_ip[2] = skops->remote_ip6[2];
+        key.remote_ip[3] = skops->remote_ip6[3];
+    } else {
+        return 1;
+    }
+    key.local_port = skops->local_port;
+    key.remote_port = bpf_ntohl(skops->remote_port);
+
+    if (!aurora_splice_loopback(key.family, key.local_ip) ||
+        !aurora_splice_loopback(key.family, key.remote_ip) ||
+        !aurora_splice_registered(server_port))
+        return 1;
+
+    if (!bpf_sock_hash_update(skops, &aurora_splice_socks, &key, BPF_NOEXIST))
+        aurora_splice_count(AURORA_SPLICE_STAT_SOCKS);
+
+    return 1;
+}
+
+/* Runs on sendmsg() of a socket in aurora_splice_socks */
+SEC("sk_msg")
+int aurora_splice_msg(struct sk_msg_md *msg)
+{
+    struct aurora_splice_key peer = {};
+
+    peer.family = msg->family;
+    if (peer.family == AF_INET) {
+        peer.local_ip[0] = msg->remote_ip4;
+        peer.remote_ip[0] = msg->local_ip4;
+    } else {
+        peer.local_ip[0] = msg->remote_ip6[0];
+        peer.local_ip[1] = msg->remote_ip6[1];
+        peer.local_ip[2] = msg->remote_ip6[2];
+        peer.local_ip[3] = msg->remote_ip6[3];
+        peer.remote_ip[0] = msg->local_ip6[0];
+        peer.remote_ip[1] = msg->local_ip6[1];
+        peer.remote_ip[2] = msg->local_ip6[2];
+        peer.remote_ip[3] = msg->local_ip6[3];
+    }
+    peer.local_port = bpf_ntohl(msg->remote_port);
+    peer.remote_port = msg->local_port;
+
+    /* A missing peer leaves the message to the stack */
+    if (bpf_msg_redirect_hash(msg, &aurora_splice_socks, &peer,
+                              BPF_F_INGRESS) == SK_PASS)
+        aurora_splice_count(AURORA_SPLICE_STAT_REDIRECTED);
+    else
+        aurora_splice_count(AURORA_SPLICE_STAT_FALLBACK);
+
+    return SK_PASS;
+}
+
+char LICENSE[] SEC("license") = "GPL";
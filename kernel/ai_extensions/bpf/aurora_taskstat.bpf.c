@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS - Bulk task statistics
+ *
+ * The monitoring agent and the context manager's userspace side used to
+ * read /proc/<pid>/{stat,status,io} for every process every second: three
+ * opens, three seq_file formatting passes and three parses per task. This
+ * task iterator returns the same numbers for every task as fixed-size
+ * binary records, so one read() of the pinned iterator replaces all of
+ * them.
+ *
+ *   bpftool iter pin bpf/aurora_taskstat.bpf.o /sys/fs/bpf/aurora_taskstat
+ *   cat /sys/fs/bpf/aurora_taskstat > snapshot
+ *
+ * Each read of the pinned file walks the tasks afresh and yields one
+ * struct aurora_taskstat per thread, in the same units as the kernel keeps
+ * them (ns, pages, bytes), so no conversion happens on either side. The
+ * layout is versioned by AURORA_TASKSTAT_VERSION in every record. To walk
+ * one process only, attach through libbpf with the pid in
+ * bpf_iter_link_info.task.pid, or pid_fd for a pidfd, instead of pinning.
+ *
+ * As in /proc/<pid>/task/<tid>/, the numbers are per thread. Summing the
+ * records of a tgid gives the live part of the /proc/<pid> totals; what
+ * threads that already exited used is in the leader's exited_* fields.
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_core_read.h>
+
+#define AURORA_TASKSTAT_VERSION 1
+
+/* Macros that vmlinux.h does not carry */
+#define PF_KTHREAD      0x00200000
+
+/* Mirrors enum in mm_types_task.h */
+#define MM_FILEPAGES    0
+#define MM_ANONPAGES    1
+#define MM_SHMEMPAGES   3
+
+enum aurora_taskstat_flags {
+    AURORA_TASKSTAT_KTHREAD = 1 << 0,   /* kernel thread, no mm */
+    AURORA_TASKSTAT_LEADER  = 1 << 1,   /* thread group leader */
+};
+
+struct aurora_taskstat {
+    u16 version;
+    u16 size;               /* sizeof(struct aurora_taskstat) */
+    u32 flags;              /* enum aurora_taskstat_flags */
+
+    s32 pid;                /* thread id */
+    s32 tgid;
+    s32 ppid;
+    u32 uid;                /* real uid, init namespace */
+
+    u32 state;              /* task->__state */
+    u32 task_flags;         /* PF_* */
+    s32 prio;
+    s32 nice;
+    u32 policy;
+    u32 cpu;                /* last CPU the task ran on */
+    u32 nr_threads;
+
+    char comm[16];
+
+    u64 start_time;         /* ns since boot, CLOCK_MONOTONIC */
+    u64 sum_exec_runtime;   /* ns on CPU */
+    u64 utime;              /* ns */
+    u64 stime;              /* ns */
+    u64 nvcsw;
+    u64 nivcsw;
+    u64 min_flt;
+    u64 maj_flt;
+
+    u64 vm_pages;           /* mm->total_vm */
+    u64 rss_file_pages;
+    u64 rss_anon_pages;
+    u64 rss_shmem_pages;
+
+    u64 rchar;
+    u64 wchar;
+    u64 syscr;
+    u64 syscw;
+    u64 read_bytes;
+    u64 write_bytes;
+    u64 cancelled_write_bytes;
+
+    /* Leader only: totals of threads of the group that have exited */
+    u64 exited_sum_exec_runtime;
+    u64 exited_utime;
+    u64 exited_stime;
+    u64 exited_read_bytes;
+    u64 exited_write_bytes;
+};
+
+/* Per read counters of the iterator, for the agent's own accounting */
+enum aurora_taskstat_stat {
+    AURORA_TASKSTAT_STAT_RECORDS,       /* records written */
+    AURORA_TASKSTAT_STAT_OVERFLOW,      /* records left for the next read() */
+    AURORA_TASKSTAT_NR_STATS,
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, AURORA_TASKSTAT_NR_STATS);
+    __type(key, u32);
+    __type(value, u64);
+} aurora_taskstat_stats SEC(".maps");
+
+/* Set before loading to leave kernel threads out */
+const volatile bool skip_kthreads = false;
+
+static void aurora_taskstat_count(u32 stat)
+{
+    u64 *count = bpf_map_lookup_elem(&aurora_taskstat_stats, &stat);
+
+    if (count)
+        (*count)++;
+}
+
+static void aurora_taskstat_fill_mm(struct aurora_taskstat *rec,
+                                    struct mm_struct *mm)
+{
+    rec->vm_pages = mm->total_vm;
+    rec->rss_file_pages = mm->rss_stat.count[MM_FILEPAGES].counter;
+    rec->rss_anon_pages = mm->rss_stat.count[MM_ANONPAGES].counter;
+    rec->rss_shmem_pages = mm->rss_stat.count[MM_SHMEMPAGES].counter;
+}
+
+static void aurora_taskstat_fill_exited(struct aurora_taskstat *rec,
+                                        struct signal_struct *sig)
+{
+    rec->exited_sum_exec_runtime = sig->sum_sched_runtime;
+    rec->exited_utime = sig->utime;
+    rec->exited_stime = sig->stime;
+    rec->exited_read_bytes = sig->ioac.read_bytes;
+    rec->exited_write_bytes = sig->ioac.write_bytes;
+}
+
+SEC("iter/task")
+int aurora_taskstat(struct bpf_iter__task *ctx)
+{
+    struct task_struct *task = ctx->task;
+    struct aurora_taskstat rec = {};
+    struct mm_struct *mm;
+
+    /* Called once more with a NULL task at the end of the walk */
+    if (!task)
+        return 0;
+
+    if (skip_kthreads && (task->flags & PF_KTHREAD))
+        return 0;
+
+    rec.version = AURORA_TASKSTAT_VERSION;
+    rec.size = sizeof(rec);
+
+    rec.pid = task->pid;
+    rec.tgid = task->tgid;
+    rec.ppid = BPF_CORE_READ(task, real_parent, tgid);
+    rec.uid = BPF_CORE_READ(task, real_cred, uid.val);
+
+    rec.state = task->__state;
+    rec.task_flags = task->flags;
+    rec.prio = task->prio;
+    rec.nice = task->static_prio - 120;
+    rec.policy = task->policy;
+    if (bpf_core_field_exists(task->thread_info.cpu))
+        rec.cpu = BPF_CORE_READ(task, thread_info.cpu);
+    else
+        rec.cpu = BPF_CORE_READ(task, wake_cpu);
+    rec.nr_threads = BPF_CORE_READ(task, signal, nr_threads);
+    bpf_probe_read_kernel_str(rec.comm, sizeof(rec.comm), task->comm);
+
+    rec.start_time = task->start_time;
+    rec.sum_exec_runtime = task->se.sum_exec_runtime;
+    rec.utime = task->utime;
+    rec.stime = task->stime;
+    rec.nvcsw = task->nvcsw;
+    rec.nivcsw = task->nivcsw;
+    rec.min_flt = task->min_flt;
+    rec.maj_flt = task->maj_flt;
+
+    rec.rchar = task->ioac.rchar;
+    rec.wchar = task->ioac.wchar;
+    rec.syscr = task->ioac.syscr;
+    rec.syscw = task->ioac.syscw;
+    rec.read_bytes = task->ioac.read_bytes;
+    rec.write_bytes = task->ioac.write_bytes;
+    rec.cancelled_write_bytes = task->ioac.cancelled_write_bytes;
+
+    mm = task->mm;
+    if (mm)
+        aurora_taskstat_fill_mm(&rec, mm);
+    else
+        rec.flags |= AURORA_TASKSTAT_KTHREAD;
+
+    if (task->pid == task->tgid) {
+        rec.flags |= AURORA_TASKSTAT_LEADER;
+        aurora_taskstat_fill_exited(&rec, task->signal);
+    }
+
+    /* A full buffer ends this read; the next read() resumes at this task */
+    if (bpf_seq_write(ctx->meta->seq, &rec, sizeof(rec)))
+        aurora_taskstat_count(AURORA_TASKSTAT_STAT_OVERFLOW);
+    else
+        aurora_taskstat_count(AURORA_TASKSTAT_STAT_RECORDS);
+
+    return 0;
+}
+
+char LICENSE[] SEC("license") = "GPL";
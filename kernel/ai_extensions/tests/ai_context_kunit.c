@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS AI Context Manager KUnit Tests
+ *
+ * Included at the end of ai_context_manager.c when built with KUNIT=1,
+ * so the static prediction code is reachable; the suites run when the
+ * module loads. The prediction tests use contexts that are never
+ * tracked, so the manager's lists and counters are left alone.
+ */
+
+#include <kunit/test.h>
+#include <net/netlink.h>
+#include "aurora_bench.h"
+
+#define AI_CONTEXT_TEST_BASE    NSEC_PER_SEC
+
+static struct ai_process_context *ai_context_test_ctx(struct kunit *test)
+{
+    struct ai_process_context *ctx;
+
+    ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, ctx);
+    spin_lock_init(&ctx->lock);
+
+    return ctx;
+}
+
+static void ai_context_interval_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+    unsigned int i, confidence = 0;
+
+    /* A full history of 1 ms intervals predicts 1 ms with certainty */
+    for (i = 0; i < AI_CONTEXT_HISTORY_SIZE; i++)
+        ctx->context_switch_times[i] = AI_CONTEXT_TEST_BASE + i * NSEC_PER_MSEC;
+
+    KUNIT_EXPECT_EQ(test, ai_context_model_interval(ctx, &confidence), (u64)NSEC_PER_MSEC);
+    KUNIT_EXPECT_EQ(test, confidence, 100U);
+}
+
+static void ai_context_interval_mixed_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+    unsigned int i, confidence = 0;
+    ktime_t t = AI_CONTEXT_TEST_BASE;
+
+    /* 48 intervals of 1 ms, then 15 of 4 ms: the mode wins */
+    for (i = 0; i < AI_CONTEXT_HISTORY_SIZE; i++) {
+        ctx->context_switch_times[i] = t;
+        t += (i < 48 ? 1 : 4) * NSEC_PER_MSEC;
+    }
+
+    KUNIT_EXPECT_EQ(test, ai_context_model_interval(ctx, &confidence), (u64)NSEC_PER_MSEC);
+    KUNIT_EXPECT_EQ(test, confidence, 48U * 100 / (AI_CONTEXT_HISTORY_SIZE - 1));
+}
+
+static void ai_context_interval_short_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+    unsigned int i, confidence = 0;
+
+    /* Too little history to predict anything */
+    for (i = 0; i < AI_CONTEXT_MIN_INTERVALS; i++)
+        ctx->context_switch_times[i] = AI_CONTEXT_TEST_BASE + i * NSEC_PER_MSEC;
+
+    KUNIT_EXPECT_EQ(test, ai_context_model_interval(ctx, &confidence), 0ULL);
+
+    /* Clock steps backwards are ignored rather than counted */
+    ctx->context_switch_times[AI_CONTEXT_MIN_INTERVALS] = AI_CONTEXT_TEST_BASE / 2;
+    KUNIT_EXPECT_EQ(test, ai_context_model_interval(ctx, &confidence), 0ULL);
+}
+
+static void ai_context_confidence_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+
+    /* The model is trusted until enough of its predictions are scored */
+    ctx->prediction_hits = 1;
+    ctx->prediction_misses = 2;
+    ctx->prediction_accuracy = 33;
+    KUNIT_EXPECT_EQ(test, ai_context_prediction_confidence(ctx, 90), 90U);
+
+    /* Then it is capped by its record */
+    ctx->prediction_hits = 10;
+    ctx->prediction_misses = 20;
+    KUNIT_EXPECT_EQ(test, ai_context_prediction_confidence(ctx, 90), 33U);
+    KUNIT_EXPECT_EQ(test, ai_context_prediction_confidence(ctx, 20), 20U);
+}
+
+static void ai_context_batch_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+
+    ewma_io_bw_init(&ctx->io_read_bw);
+    ewma_io_bw_init(&ctx->io_write_bw);
+    ctx->cpu_utilization = AI_CONTEXT_BATCH_CPU - 1;
+    KUNIT_EXPECT_FALSE(test, ai_context_batch_like(ctx));
+
+    /* CPU-bound work */
+    ctx->cpu_utilization = AI_CONTEXT_BATCH_CPU;
+    KUNIT_EXPECT_TRUE(test, ai_context_batch_like(ctx));
+
+    /* Bulk IO, reads and writes together, such as an indexer */
+    ctx->cpu_utilization = 5;
+    ewma_io_bw_add(&ctx->io_read_bw, AI_CONTEXT_IO_BULK_BW / 2);
+    ewma_io_bw_add(&ctx->io_write_bw, AI_CONTEXT_IO_BULK_BW / 2);
+    KUNIT_EXPECT_TRUE(test, ai_context_batch_like(ctx));
+}
+
+static void ai_context_mem_idle_test(struct kunit *test)
+{
+    struct ai_process_context *ctx = ai_context_test_ctx(test);
+
+    /* No DAMON aggregation yet */
+    KUNIT_EXPECT_TRUE(test, ai_context_mem_idle(ctx));
+    ctx->cpu_utilization = 1;
+    KUNIT_EXPECT_FALSE(test, ai_context_mem_idle(ctx));
+
+    /* Off the CPU but touching its memory, such as a paused player */
+    ctx->cpu_utilization = 0;
+    ctx->mem.updated = ktime_get();
+    ctx->mem.hot_bytes = PAGE_SIZE;
+    KUNIT_EXPECT_FALSE(test, ai_context_mem_idle(ctx));
+
+    ctx->mem.hot_bytes = 0;
+    KUNIT_EXPECT_TRUE(test, ai_context_mem_idle(ctx));
+}
+
+#ifdef CONFIG_DAMON_VADDR
+static void ai_context_thp_boost_test(struct kunit *test)
+{
+    struct ai_context_mem_summary old = { .preferred_node = NUMA_NO_NODE };
+    struct ai_context_mem_summary sum = { .preferred_node = 0 };
+
+    /* Nothing to collapse */
+    KUNIT_EXPECT_FALSE(test, ai_context_thp_boost_needed(&old, &sum));
+
+    /* A hot region spans a PMD for the first time */
+    sum.thp_candidate = true;
+    KUNIT_EXPECT_TRUE(test, ai_context_thp_boost_needed(&old, &sum));
+
+    /* Already passed on */
+    old = sum;
+    KUNIT_EXPECT_FALSE(test, ai_context_thp_boost_needed(&old, &sum));
+
+    /* The hot memory moved to another node */
+    sum.preferred_node = 1;
+    KUNIT_EXPECT_TRUE(test, ai_context_thp_boost_needed(&old, &sum));
+}
+#endif
+
+/* Stage a context nest with one u32 setting; the caller frees the skb */
+static void *ai_context_test_stage(struct kunit *test, struct sk_buff **skb,
+                                   int attr, u32 val)
+{
+    struct nlattr *nest;
+
+    *skb = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, *skb);
+
+    nest = nla_nest_start(*skb, AURORA_AI_ATTR_CONTEXT);
+    KUNIT_ASSERT_NOT_NULL(test, nest);
+    KUNIT_ASSERT_EQ(test, nla_put_u32(*skb, attr, val), 0);
+    nla_nest_end(*skb, nest);
+
+    return ai_context_control_prepare(nest, NULL);
+}
+
+static void ai_context_control_test(struct kunit *test)
+{
+    struct sk_buff *skb;
+    void *staged;
+
+    staged = ai_context_test_stage(test, &skb, AURORA_AI_CONTEXT_PREDICTION_THRESHOLD, 80);
+    KUNIT_EXPECT_FALSE(test, IS_ERR(staged));
+    if (!IS_ERR(staged))
+        ai_context_control_abort(staged);
+    kfree_skb(skb);
+
+    /* Percentages stop at 100 */
+    staged = ai_context_test_stage(test, &skb, AURORA_AI_CONTEXT_PREDICTION_THRESHOLD, 101);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+
+    /* Learning more often than every 10 ms is refused */
+    staged = ai_context_test_stage(test, &skb, AURORA_AI_CONTEXT_LEARNING_INTERVAL, 5);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+}
+
+static struct kunit_case ai_context_test_cases[] = {
+    KUNIT_CASE(ai_context_interval_test),
+    KUNIT_CASE(ai_context_interval_mixed_test),
+    KUNIT_CASE(ai_context_interval_short_test),
+    KUNIT_CASE(ai_context_confidence_test),
+    KUNIT_CASE(ai_context_batch_test),
+    KUNIT_CASE(ai_context_mem_idle_test),
+#ifdef CONFIG_DAMON_VADDR
+    KUNIT_CASE(ai_context_thp_boost_test),
+#endif
+    KUNIT_CASE(ai_context_control_test),
+    {}
+};
+
+static struct kunit_suite ai_context_test_suite = {
+    .name = "ai_context",
+    .test_cases = ai_context_test_cases,
+};
+
+#ifdef CONFIG_AURORA_AI_HOOKS
+/* Throw away this CPU's switch records; interrupts are off */
+static void ai_context_bench_discard(void)
+{
+    struct ai_context_switch_ring *ring = this_cpu_ptr(ai_ctx_mgr->switch_rings);
+
+    smp_store_release(&ring->tail, ring->head);
+}
+
+/*
+ * One context switch as the manager pays for it: the switch hook from
+ * __schedule(), plus the accounting the learning run later does for the
+ * record, against a working set of contexts. The learning work is held
+ * off so the benchmark owns the rings; real switches recorded meanwhile
+ * are dropped.
+ */
+static void ai_context_bench_switch(struct kunit *test)
+{
+    const unsigned int nr = *(const unsigned int *)test->param_value;
+    struct aurora_task_features *features;
+    struct ai_process_context *ctxs;
+    ktime_t now = ai_context_get_current_time();
+    unsigned int i;
+    u64 ns;
+
+    if (!static_key_enabled(&ai_context_hooks_enabled))
+        kunit_skip(test, "Context hooks are disabled");
+
+    ctxs = kvcalloc(nr, sizeof(*ctxs), GFP_KERNEL);
+    features = kvcalloc(nr, sizeof(*features), GFP_KERNEL);
+    if (!ctxs || !features) {
+        kvfree(ctxs);
+        kvfree(features);
+        KUNIT_FAIL(test, "No memory for %u contexts", nr);
+        return;
+    }
+
+    for (i = 0; i < nr; i++) {
+        spin_lock_init(&ctxs[i].lock);
+        ctxs[i].features = &features[i];
+        ctxs[i].context_switch_times[AI_CONTEXT_HISTORY_SIZE - 1] = now;
+    }
+
+    cancel_delayed_work_sync(&ai_ctx_mgr->learning_work);
+
+    AURORA_BENCH_LOOP(ns, i, true,
+                      ({
+                          ai_context_sched_switch_hook(current, current);
+                          ai_context_account_switch(&ctxs[aurora_bench_index(i, nr)],
+                                                    now + i * NSEC_PER_USEC);
+                      }),
+                      ai_context_bench_discard());
+
+    queue_delayed_work(ai_ctx_mgr->learning_wq, &ai_ctx_mgr->learning_work,
+                       msecs_to_jiffies(ai_context_learning_interval));
+
+    aurora_bench_report(test, "ai_context_sched_switch_hook", nr, ns);
+
+    kvfree(features);
+    kvfree(ctxs);
+}
+
+static struct kunit_case ai_context_bench_cases[] = {
+    KUNIT_CASE_PARAM(ai_context_bench_switch, aurora_bench_tasks_gen_params),
+    {}
+};
+
+static struct kunit_suite ai_context_bench_suite = {
+    .name = "ai_context_bench",
+    .test_cases = ai_context_bench_cases,
+};
+
+kunit_test_suites(&ai_context_test_suite, &ai_context_bench_suite);
+#else
+kunit_test_suites(&ai_context_test_suite);
+#endif
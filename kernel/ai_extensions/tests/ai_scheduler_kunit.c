@@ -0,0 +1,507 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS AI Scheduler KUnit Tests
+ *
+ * Included at the end of ai_scheduler.c when built with KUNIT=1, so the
+ * static scoring code is reachable; the suites run when the module loads.
+ * Scores are checked on a stand-in task and patterns that are never
+ * queued, so the live runqueues are not touched.
+ */
+
+#include <kunit/test.h>
+#include <net/netlink.h>
+#include "aurora_bench.h"
+
+static struct task_struct *aurora_test_task(struct kunit *test)
+{
+    struct task_struct *task;
+
+    task = kunit_kzalloc(test, sizeof(*task), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_ERR_OR_NULL(test, task);
+    task->policy = SCHED_NORMAL;
+    task->se.load.weight = 1024;
+
+    return task;
+}
+
+/* A recently used pattern with no history and no class */
+static void aurora_test_pattern(struct usage_pattern *pattern,
+                                struct aurora_task_features *features)
+{
+    memset(pattern, 0, sizeof(*pattern));
+    memset(features, 0, sizeof(*features));
+    pattern->features = features;
+    pattern->last_access = jiffies;
+    pattern->class_gen = READ_ONCE(aurora_class_gen);
+}
+
+static void aurora_decay_test(struct kunit *test)
+{
+    /* y^0 is 1 less the rounding of the table */
+    KUNIT_EXPECT_EQ(test, aurora_decay(1 << 20, 0), (1ULL << 20) - 1);
+
+    /* y^32 is one half, and every further period of 32 halves again */
+    KUNIT_EXPECT_EQ(test, aurora_decay(1 << 20, AURORA_DECAY_PERIOD), (1ULL << 19) - 1);
+    KUNIT_EXPECT_EQ(test, aurora_decay(1 << 20, AURORA_DECAY_PERIOD * 3), (1ULL << 17) - 1);
+
+    /* Long gone */
+    KUNIT_EXPECT_EQ(test, aurora_decay(U64_MAX, AURORA_DECAY_PERIOD * 64), 0ULL);
+}
+
+static void aurora_ewma_test(struct kunit *test)
+{
+    u64 avg;
+
+    /* Half way to the sample after one half-life, from either side */
+    avg = aurora_ewma(0, 1 << 20, AURORA_DECAY_PERIOD);
+    KUNIT_EXPECT_EQ(test, avg, (1ULL << 19) + 1);
+    avg = aurora_ewma(1 << 20, 0, AURORA_DECAY_PERIOD);
+    KUNIT_EXPECT_EQ(test, avg, (1ULL << 19) - 1);
+
+    /* No time passed counts as one period */
+    KUNIT_EXPECT_EQ(test, aurora_ewma(0, 1 << 20, 0), aurora_ewma(0, 1 << 20, 1));
+
+    /* A steady input is a fixed point */
+    KUNIT_EXPECT_EQ(test, aurora_ewma(4096, 4096, 7), 4096ULL);
+}
+
+static void aurora_score_disabled_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+
+    /* Without a pattern the task just keeps its CFS weight */
+    KUNIT_EXPECT_EQ(test, calculate_ai_score(task, NULL), 1024);
+}
+
+static void aurora_score_blend_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    const u32 *weights;
+    u32 expected;
+
+    if (!static_key_enabled(&aurora_ai_sched_enabled))
+        kunit_skip(test, "AI scheduling is disabled");
+
+    aurora_test_pattern(&pattern, &features);
+
+    /* Recent (50) and interactive (15); short running (25) */
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern), 65);
+    KUNIT_EXPECT_EQ(test, calculate_prediction_score(task, &pattern), 25);
+
+    rcu_read_lock();
+    weights = rcu_dereference(aurora_score_weights);
+    expected = (1024 * weights[AURORA_SCORE_BASE] +
+                65 * weights[AURORA_SCORE_CONTEXT] +
+                25 * weights[AURORA_SCORE_PREDICTION]) >> AURORA_FIXED_SHIFT;
+    rcu_read_unlock();
+
+    KUNIT_EXPECT_EQ(test, calculate_ai_score(task, &pattern), (int)expected);
+}
+
+static void aurora_score_negative_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    int unboosted;
+
+    if (!static_key_enabled(&aurora_ai_sched_enabled))
+        kunit_skip(test, "AI scheduling is disabled");
+
+    /* A nice 19, long idle, CPU-bound task */
+    aurora_test_pattern(&pattern, &features);
+    task->se.load.weight = 15;
+    pattern.last_access = jiffies - 20 * HZ;
+    features.avg_runtime = AURORA_SHORT_RUNTIME_NS;
+    features.cpu_intensity = AURORA_FIXED_ONE;
+    unboosted = calculate_ai_score(task, &pattern);
+
+    /* Penalized below zero it sits at the floor, not at the top */
+    pattern.class_boost = -100;
+    KUNIT_EXPECT_LT(test, calculate_prediction_score(task, &pattern), 0);
+    KUNIT_EXPECT_EQ(test, calculate_ai_score(task, &pattern), 1);
+    KUNIT_EXPECT_LE(test, calculate_ai_score(task, &pattern), unboosted);
+}
+
+static void aurora_score_intensity_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    int io_score, cpu_score;
+
+    aurora_test_pattern(&pattern, &features);
+
+    features.io_intensity = AURORA_FIXED_ONE;
+    io_score = calculate_context_score(task, &pattern);
+
+    features.io_intensity = 0;
+    features.cpu_intensity = AURORA_FIXED_ONE;
+    cpu_score = calculate_context_score(task, &pattern);
+
+    /* IO-bound work is favoured over CPU-bound work */
+    KUNIT_EXPECT_GT(test, io_score, cpu_score);
+    KUNIT_EXPECT_EQ(test, io_score - cpu_score, 10);
+
+    /* Long bursts lose the responsiveness boost */
+    features.avg_runtime = AURORA_SHORT_RUNTIME_NS;
+    KUNIT_EXPECT_EQ(test, calculate_prediction_score(task, &pattern), 0);
+}
+
+static void aurora_score_history_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+
+    aurora_test_pattern(&pattern, &features);
+    features.avg_runtime = AURORA_SHORT_RUNTIME_NS;
+
+    /* Access history counts past 10 accesses, up to 40 */
+    pattern.access_count = 10;
+    KUNIT_EXPECT_EQ(test, calculate_prediction_score(task, &pattern), 0);
+    pattern.access_count = 11;
+    KUNIT_EXPECT_EQ(test, calculate_prediction_score(task, &pattern), 11);
+    pattern.access_count = 1000;
+    KUNIT_EXPECT_EQ(test, calculate_prediction_score(task, &pattern), 40);
+
+    /* Idle for a while, then for long */
+    pattern.last_access = jiffies - 2 * HZ;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern), 40);
+    pattern.last_access = jiffies - 20 * HZ;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern), 15);
+}
+
+static void aurora_score_pressure_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    int idle, stalled, unstalled = 0;
+
+    aurora_test_pattern(&pattern, &features);
+    features.cpu_intensity = AURORA_FIXED_ONE;
+    idle = calculate_context_score(task, &pattern);
+
+    /* A starved cgroup gains, up to the full adjustment */
+    pattern.stall[AURORA_PRESSURE_CPU] = AURORA_AI_PRESSURE_FULL / 2;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern),
+                    idle + AURORA_PRESSURE_MAX_ADJ / 2);
+
+    /* Memory stall weighs on CPU-bound tasks; IO stall spares them */
+    pattern.stall[AURORA_PRESSURE_CPU] = 0;
+    pattern.stall[AURORA_PRESSURE_MEMORY] = AURORA_AI_PRESSURE_FULL;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern),
+                    idle - AURORA_PRESSURE_MAX_ADJ);
+    pattern.stall[AURORA_PRESSURE_MEMORY] = 0;
+    pattern.stall[AURORA_PRESSURE_IO] = AURORA_AI_PRESSURE_FULL;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern), idle);
+
+    /*
+     * Both stalls take the context of a long idle task below zero; for
+     * a nice 19 one without prediction points, the whole blend as well
+     */
+    task->se.load.weight = 15;
+    features.avg_runtime = AURORA_SHORT_RUNTIME_NS;
+    features.io_intensity = AURORA_FIXED_ONE;
+    pattern.last_access = jiffies - 20 * HZ;
+    pattern.stall[AURORA_PRESSURE_IO] = 0;
+    if (static_key_enabled(&aurora_ai_sched_enabled))
+        unstalled = calculate_ai_score(task, &pattern);
+    pattern.stall[AURORA_PRESSURE_MEMORY] = AURORA_AI_PRESSURE_FULL;
+    pattern.stall[AURORA_PRESSURE_IO] = AURORA_AI_PRESSURE_FULL;
+    KUNIT_EXPECT_EQ(test, calculate_context_score(task, &pattern),
+                    15 - 2 * AURORA_PRESSURE_MAX_ADJ);
+
+    /* ... which lowers its score rather than wrapping it to the top */
+    if (static_key_enabled(&aurora_ai_sched_enabled)) {
+        stalled = calculate_ai_score(task, &pattern);
+        KUNIT_EXPECT_LT(test, stalled, unstalled);
+        KUNIT_EXPECT_EQ(test, stalled, 1);
+    }
+}
+
+static void aurora_freq_boost_test(struct kunit *test)
+{
+    /* Too short to be worth a frequency change */
+    KUNIT_EXPECT_EQ(test, aurora_freq_boost(0), 0UL);
+    KUNIT_EXPECT_EQ(test, aurora_freq_boost(AURORA_FREQ_MIN_BURST_NS - 1), 0UL);
+
+    /* Proportional up to the window, then full capacity */
+    KUNIT_EXPECT_EQ(test, aurora_freq_boost(1ULL << (AURORA_FREQ_BURST_SHIFT - 1)),
+                    (unsigned long)SCHED_CAPACITY_SCALE / 2);
+    KUNIT_EXPECT_EQ(test, aurora_freq_boost(1ULL << AURORA_FREQ_BURST_SHIFT),
+                    (unsigned long)SCHED_CAPACITY_SCALE);
+    KUNIT_EXPECT_EQ(test, aurora_freq_boost(U64_MAX), (unsigned long)SCHED_CAPACITY_SCALE);
+}
+
+static void aurora_freq_wake_sleep_test(struct kunit *test)
+{
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    struct aurora_rq arq = {};
+
+    aurora_test_pattern(&pattern, &features);
+
+    /* A burst predicted without history asks for nothing */
+    pattern.predicted_burst = 1ULL << (AURORA_FREQ_BURST_SHIFT - 1);
+    aurora_freq_wake(&arq, &pattern);
+    KUNIT_EXPECT_EQ(test, arq.freq_boost, 0UL);
+
+    /* A scored one holds its capacity for as long as it should run */
+    pattern.burst_valid = true;
+    aurora_freq_wake(&arq, &pattern);
+    KUNIT_EXPECT_EQ(test, arq.freq_boost, (unsigned long)SCHED_CAPACITY_SCALE / 2);
+    KUNIT_EXPECT_GT(test, arq.freq_boost_until, local_clock());
+
+    /* A smaller overlapping burst does not lower it */
+    pattern.predicted_burst = AURORA_FREQ_MIN_BURST_NS;
+    aurora_freq_wake(&arq, &pattern);
+    KUNIT_EXPECT_EQ(test, arq.freq_boost, (unsigned long)SCHED_CAPACITY_SCALE / 2);
+
+    /* Blocking with work still queued keeps the boost */
+    arq.nr_queued = 1;
+    aurora_freq_sleep(&arq);
+    KUNIT_EXPECT_FALSE(test, arq.freq_idle);
+    KUNIT_EXPECT_NE(test, arq.freq_boost_until, 0ULL);
+
+    /* The last one out predicts idle and ends the boost */
+    arq.nr_queued = 0;
+    aurora_freq_sleep(&arq);
+    KUNIT_EXPECT_TRUE(test, arq.freq_idle);
+    KUNIT_EXPECT_EQ(test, arq.freq_boost_until, 0ULL);
+}
+
+/* This CPU's predictions so far, and how many of them hit */
+static void aurora_test_pred_count(u64 *total, u64 *hits)
+{
+    struct aurora_pred_stats *ps = this_cpu_ptr(&aurora_pred_stats);
+    unsigned int c, b;
+
+    *total = 0;
+    *hits = 0;
+    for (c = 0; c < AURORA_NR_PRED_CLASSES; c++) {
+        for (b = 0; b < AURORA_NR_PRED_BUCKETS; b++) {
+            *total += ps->hist[c][b];
+            if (b < AURORA_PRED_HIT_BUCKETS)
+                *hits += ps->hist[c][b];
+        }
+    }
+}
+
+static void aurora_burst_prediction_test(struct kunit *test)
+{
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features features;
+    struct usage_pattern pattern;
+    u64 total0, hits0, total, hits;
+    unsigned long flags;
+
+    aurora_test_pattern(&pattern, &features);
+    task->se.sum_exec_runtime = 5 * NSEC_PER_MSEC;
+
+    /*
+     * Real wakeups and sleeps only score on their own CPU, so with
+     * interrupts off nothing but this test moves this CPU's histogram.
+     */
+    local_irq_save(flags);
+
+    /* Without history the first burst is only learned, not scored */
+    pattern.access_count = 1;
+    aurora_predict_burst(&pattern, task);
+    aurora_test_pred_count(&total0, &hits0);
+    task->se.sum_exec_runtime += NSEC_PER_MSEC;
+    aurora_observe_burst(&pattern, task);
+    aurora_test_pred_count(&total, &hits);
+    KUNIT_EXPECT_EQ(test, total, total0);
+    KUNIT_EXPECT_EQ(test, pattern.avg_burst, (u64)NSEC_PER_MSEC);
+
+    /* Within 10% of the prediction is a hit */
+    pattern.access_count = 2;
+    aurora_predict_burst(&pattern, task);
+    KUNIT_EXPECT_EQ(test, pattern.predicted_burst, (u64)NSEC_PER_MSEC);
+    task->se.sum_exec_runtime += NSEC_PER_MSEC + NSEC_PER_MSEC / 20;
+    aurora_observe_burst(&pattern, task);
+    aurora_test_pred_count(&total, &hits);
+    KUNIT_EXPECT_EQ(test, total, total0 + 1);
+    KUNIT_EXPECT_EQ(test, hits, hits0 + 1);
+
+    /* Three times as long is a miss, and pulls the average up */
+    aurora_predict_burst(&pattern, task);
+    task->se.sum_exec_runtime += 3 * pattern.predicted_burst;
+    aurora_observe_burst(&pattern, task);
+    aurora_test_pred_count(&total, &hits);
+    KUNIT_EXPECT_EQ(test, total, total0 + 2);
+    KUNIT_EXPECT_EQ(test, hits, hits0 + 1);
+    KUNIT_EXPECT_GT(test, pattern.avg_burst, pattern.predicted_burst);
+    KUNIT_EXPECT_FALSE(test, pattern.burst_valid);
+
+    local_irq_restore(flags);
+}
+
+/* Stage a sched nest carrying @weights; the caller frees the skb */
+static void *aurora_test_stage_weights(struct kunit *test, struct sk_buff **skb,
+                                       const u32 *weights)
+{
+    struct nlattr *nest;
+
+    *skb = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, *skb);
+
+    nest = nla_nest_start(*skb, AURORA_AI_ATTR_SCHED);
+    KUNIT_ASSERT_NOT_NULL(test, nest);
+    KUNIT_ASSERT_EQ(test, nla_put(*skb, AURORA_AI_SCHED_WEIGHTS,
+                                  sizeof(u32) * AURORA_NR_SCORE_COMPONENTS, weights), 0);
+    nla_nest_end(*skb, nest);
+
+    return aurora_sched_control_prepare(nest, NULL);
+}
+
+static void aurora_control_weights_test(struct kunit *test)
+{
+    static const u32 good[AURORA_NR_SCORE_COMPONENTS] = { 512, 256, 256 };
+    static const u32 short_sum[AURORA_NR_SCORE_COMPONENTS] = { 512, 256, 255 };
+    static const u32 wrapped[AURORA_NR_SCORE_COMPONENTS] = { U32_MAX, 1025, 0 };
+    struct sk_buff *skb;
+    void *staged;
+
+    staged = aurora_test_stage_weights(test, &skb, good);
+    KUNIT_EXPECT_FALSE(test, IS_ERR(staged));
+    if (!IS_ERR(staged))
+        aurora_sched_control_abort(staged);
+    kfree_skb(skb);
+
+    staged = aurora_test_stage_weights(test, &skb, short_sum);
+    KUNIT_EXPECT_EQ(test, PTR_ERR_OR_ZERO(staged), -EINVAL);
+    kfree_skb(skb);
+
+    /* Weights that only sum to 1.0 modulo 2^32 are refused too */
+    staged = aurora_test_stage_weights(test, &skb, wrapped);
+    KUNIT_EXPECT_EQ(test, PTR_ERR_OR_ZERO(staged), -EINVAL);
+    kfree_skb(skb);
+}
+
+/* Stage a sched nest with one pressure entry; the caller frees the skb */
+static void *aurora_test_stage_pressure(struct kunit *test, struct sk_buff **skb,
+                                        bool with_cgroup, u16 cpu)
+{
+    struct nlattr *nest, *entry;
+    u64 system = 0;
+
+    *skb = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, *skb);
+
+    nest = nla_nest_start(*skb, AURORA_AI_ATTR_SCHED);
+    KUNIT_ASSERT_NOT_NULL(test, nest);
+    entry = nla_nest_start(*skb, AURORA_AI_SCHED_PRESSURE);
+    KUNIT_ASSERT_NOT_NULL(test, entry);
+    if (with_cgroup)
+        KUNIT_ASSERT_EQ(test, nla_put(*skb, AURORA_AI_PRESSURE_CGROUP,
+                                      sizeof(system), &system), 0);
+    KUNIT_ASSERT_EQ(test, nla_put_u16(*skb, AURORA_AI_PRESSURE_CPU, cpu), 0);
+    nla_nest_end(*skb, entry);
+    nla_nest_end(*skb, nest);
+
+    return aurora_sched_control_prepare(nest, NULL);
+}
+
+static void aurora_control_pressure_test(struct kunit *test)
+{
+    struct sk_buff *skb;
+    void *staged;
+
+    staged = aurora_test_stage_pressure(test, &skb, true, AURORA_AI_PRESSURE_FULL);
+    KUNIT_EXPECT_FALSE(test, IS_ERR(staged));
+    if (!IS_ERR(staged))
+        aurora_sched_control_abort(staged);
+    kfree_skb(skb);
+
+    /* Past a full stall */
+    staged = aurora_test_stage_pressure(test, &skb, true, AURORA_AI_PRESSURE_FULL + 1);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+
+    staged = aurora_test_stage_pressure(test, &skb, false, 100);
+    KUNIT_EXPECT_EQ(test, PTR_ERR_OR_ZERO(staged), -EINVAL);
+    kfree_skb(skb);
+}
+
+static struct kunit_case aurora_sched_test_cases[] = {
+    KUNIT_CASE(aurora_decay_test),
+    KUNIT_CASE(aurora_ewma_test),
+    KUNIT_CASE(aurora_score_disabled_test),
+    KUNIT_CASE(aurora_score_blend_test),
+    KUNIT_CASE(aurora_score_negative_test),
+    KUNIT_CASE(aurora_score_intensity_test),
+    KUNIT_CASE(aurora_score_history_test),
+    KUNIT_CASE(aurora_score_pressure_test),
+    KUNIT_CASE(aurora_freq_boost_test),
+    KUNIT_CASE(aurora_freq_wake_sleep_test),
+    KUNIT_CASE(aurora_burst_prediction_test),
+    KUNIT_CASE(aurora_control_weights_test),
+    KUNIT_CASE(aurora_control_pressure_test),
+    {}
+};
+
+static struct kunit_suite aurora_sched_test_suite = {
+    .name = "aurora_sched",
+    .test_cases = aurora_sched_test_cases,
+};
+
+/*
+ * calculate_ai_score() over a working set of patterns with varied
+ * features, as the runqueue rescoring path sees them.
+ */
+static void aurora_bench_score(struct kunit *test)
+{
+    const unsigned int nr = *(const unsigned int *)test->param_value;
+    struct task_struct *task = aurora_test_task(test);
+    struct aurora_task_features *features;
+    struct usage_pattern *patterns;
+    unsigned int i;
+    u64 ns;
+
+    if (!static_key_enabled(&aurora_ai_sched_enabled))
+        kunit_skip(test, "AI scheduling is disabled");
+
+    patterns = kvcalloc(nr, sizeof(*patterns), GFP_KERNEL);
+    features = kvcalloc(nr, sizeof(*features), GFP_KERNEL);
+    if (!patterns || !features) {
+        kvfree(patterns);
+        kvfree(features);
+        KUNIT_FAIL(test, "No memory for %u patterns", nr);
+        return;
+    }
+
+    for (i = 0; i < nr; i++) {
+        aurora_test_pattern(&patterns[i], &features[i]);
+        patterns[i].access_count = i % 64;
+        patterns[i].last_access = jiffies - (i % 16) * HZ;
+        features[i].avg_runtime = (i % 4) * AURORA_SHORT_RUNTIME_NS / 2;
+        features[i].cpu_intensity = (i * 37) & (AURORA_FIXED_ONE - 1);
+        features[i].io_intensity = (i * 91) & (AURORA_FIXED_ONE - 1);
+    }
+
+    AURORA_BENCH_LOOP(ns, i, true,
+                      aurora_bench_sink += calculate_ai_score(task,
+                                                &patterns[aurora_bench_index(i, nr)]),
+                      );
+    aurora_bench_report(test, "calculate_ai_score", nr, ns);
+
+    kvfree(features);
+    kvfree(patterns);
+}
+
+static struct kunit_case aurora_sched_bench_cases[] = {
+    KUNIT_CASE_PARAM(aurora_bench_score, aurora_bench_tasks_gen_params),
+    {}
+};
+
+static struct kunit_suite aurora_sched_bench_suite = {
+    .name = "aurora_sched_bench",
+    .test_cases = aurora_sched_bench_cases,
+};
+
+kunit_test_suites(&aurora_sched_test_suite, &aurora_sched_bench_suite);
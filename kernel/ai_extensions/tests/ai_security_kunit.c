@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Aurora OS AI Security KUnit Tests
+ *
+ * Included at the end of ai_security.c when built with KUNIT=1, so the
+ * static scoring and matching code is reachable; the suites run when
+ * the module loads, against the live policy and intelligence.
+ */
+
+#include <kunit/test.h>
+#include <linux/fs.h>
+#include <linux/threads.h>
+#include <net/netlink.h>
+#include "aurora_bench.h"
+
+static void ai_security_classify_test(struct kunit *test)
+{
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(0), AI_SECURITY_THREAT_NONE);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(24), AI_SECURITY_THREAT_NONE);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(25), AI_SECURITY_THREAT_LOW);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(49), AI_SECURITY_THREAT_LOW);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(50), AI_SECURITY_THREAT_MEDIUM);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(70), AI_SECURITY_THREAT_HIGH);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(89), AI_SECURITY_THREAT_HIGH);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(90), AI_SECURITY_THREAT_CRITICAL);
+    KUNIT_EXPECT_EQ(test, ai_security_classify_threat(U32_MAX), AI_SECURITY_THREAT_CRITICAL);
+}
+
+static void ai_security_match_test(struct kunit *test)
+{
+    /* The built-in patterns are always compiled in */
+    KUNIT_EXPECT_TRUE(test, ai_security_match_string("/home/a/sensitive.db") &
+                            BIT(AI_SECURITY_MATCH_SENSITIVE));
+    KUNIT_EXPECT_TRUE(test, ai_security_match_string("/tmp/payload") &
+                            BIT(AI_SECURITY_MATCH_TEMP_EXEC));
+    KUNIT_EXPECT_TRUE(test, ai_security_match_string("/var/tmp/sensitive") &
+                            BIT(AI_SECURITY_MATCH_TEMP_EXEC));
+    KUNIT_EXPECT_TRUE(test, ai_security_match_string("/var/tmp/sensitive") &
+                            BIT(AI_SECURITY_MATCH_SENSITIVE));
+
+    /* Near misses */
+    KUNIT_EXPECT_FALSE(test, ai_security_match_string("/tmpfs/file") &
+                             BIT(AI_SECURITY_MATCH_TEMP_EXEC));
+    KUNIT_EXPECT_FALSE(test, ai_security_match_string("/home/a/sensitiv") &
+                             BIT(AI_SECURITY_MATCH_SENSITIVE));
+    KUNIT_EXPECT_EQ(test, ai_security_match_string(NULL), 0U);
+}
+
+static void ai_security_label_test(struct kunit *test)
+{
+    u8 label;
+
+    label = ai_security_label_match(BIT(AI_SECURITY_MATCH_SENSITIVE));
+    KUNIT_EXPECT_TRUE(test, label & AI_SECURITY_LABEL_VALID);
+    KUNIT_EXPECT_TRUE(test, label & AI_SECURITY_LABEL_SENSITIVE);
+    KUNIT_EXPECT_FALSE(test, label & AI_SECURITY_LABEL_TEMP);
+
+    /* No match is still a label, telling clean files from unlabelled ones */
+    KUNIT_EXPECT_EQ(test, ai_security_label_match(0), (u8)AI_SECURITY_LABEL_VALID);
+}
+
+/* Stage a security nest with one setting; the caller frees the skb */
+static void *ai_security_test_stage(struct kunit *test, struct sk_buff **skb,
+                                    int attr, u32 val)
+{
+    struct nlattr *nest;
+
+    *skb = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, *skb);
+
+    nest = nla_nest_start(*skb, AURORA_AI_ATTR_SECURITY);
+    KUNIT_ASSERT_NOT_NULL(test, nest);
+    if (attr == AURORA_AI_SECURITY_THREAT_THRESHOLD ||
+        attr == AURORA_AI_SECURITY_CORE_ISOLATE_TRUST)
+        KUNIT_ASSERT_EQ(test, nla_put_u32(*skb, attr, val), 0);
+    else
+        KUNIT_ASSERT_EQ(test, nla_put_u8(*skb, attr, val), 0);
+    nla_nest_end(*skb, nest);
+
+    return ai_security_control_prepare(nest, NULL);
+}
+
+static void ai_security_control_test(struct kunit *test)
+{
+    struct sk_buff *skb;
+    void *staged;
+
+    staged = ai_security_test_stage(test, &skb, AURORA_AI_SECURITY_THREAT_THRESHOLD, 60);
+    KUNIT_EXPECT_FALSE(test, IS_ERR(staged));
+    if (!IS_ERR(staged))
+        ai_security_control_abort(staged);
+    kfree_skb(skb);
+
+    staged = ai_security_test_stage(test, &skb, AURORA_AI_SECURITY_THREAT_THRESHOLD, 101);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+
+    staged = ai_security_test_stage(test, &skb, AURORA_AI_SECURITY_AUTO_RESPONSE, 2);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+
+    staged = ai_security_test_stage(test, &skb, AURORA_AI_SECURITY_CORE_ISOLATE_TRUST, 101);
+    KUNIT_EXPECT_TRUE(test, IS_ERR(staged));
+    kfree_skb(skb);
+}
+
+static void ai_security_core_tier_test(struct kunit *test)
+{
+    struct ai_security_profile *profile;
+    u32 bar = READ_ONCE(ai_security_core_isolate_trust);
+
+    if (!bar || bar + AI_SECURITY_CORE_HYSTERESIS > 100)
+        kunit_skip(test, "Core isolation bar is %u", bar);
+
+    profile = kunit_kzalloc(test, sizeof(*profile), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, profile);
+
+    /* Below the bar a shared task is isolated; at it, it stays shared */
+    profile->trust_score = AI_SECURITY_SCORE(bar - 1);
+    KUNIT_EXPECT_TRUE(test, ai_security_core_want_isolation(profile));
+    profile->trust_score = AI_SECURITY_SCORE(bar + 1);
+    KUNIT_EXPECT_FALSE(test, ai_security_core_want_isolation(profile));
+
+    /* An isolated task shares again only past the hysteresis */
+    profile->core_isolated = true;
+    KUNIT_EXPECT_TRUE(test, ai_security_core_want_isolation(profile));
+    profile->trust_score = AI_SECURITY_SCORE(bar + AI_SECURITY_CORE_HYSTERESIS + 1);
+    KUNIT_EXPECT_FALSE(test, ai_security_core_want_isolation(profile));
+}
+
+static struct kunit_case ai_security_test_cases[] = {
+    KUNIT_CASE(ai_security_classify_test),
+    KUNIT_CASE(ai_security_match_test),
+    KUNIT_CASE(ai_security_label_test),
+    KUNIT_CASE(ai_security_control_test),
+    KUNIT_CASE(ai_security_core_tier_test),
+    {}
+};
+
+static struct kunit_suite ai_security_test_suite = {
+    .name = "ai_security",
+    .test_cases = ai_security_test_cases,
+};
+
+/*
+ * Stand-in profiles, hashed but not listed: lookups walk past them, but
+ * they take no part in eviction, learning or /proc. Their pids are above
+ * any real pid, so nothing else ever finds them.
+ */
+static struct ai_security_profile **ai_security_bench_ghosts(unsigned int nr)
+{
+    struct ai_security_profile **ghosts;
+    unsigned int i;
+
+    ghosts = kvcalloc(nr, sizeof(*ghosts), GFP_KERNEL);
+    if (!ghosts)
+        return NULL;
+
+    for (i = 0; i < nr; i++) {
+        ghosts[i] = kmem_cache_zalloc(ai_sec_mgr->profile_cache, GFP_KERNEL);
+        if (!ghosts[i])
+            break;
+        ghosts[i]->pid = PID_MAX_LIMIT + 1 + i;
+        INIT_LIST_HEAD(&ghosts[i]->list);
+        spin_lock_init(&ghosts[i]->lock);
+        refcount_set(&ghosts[i]->ref, 1);
+        ai_security_profile_add_to_hash(ghosts[i]);
+    }
+
+    return ghosts;
+}
+
+static void ai_security_bench_unghost(struct ai_security_profile **ghosts, unsigned int nr)
+{
+    unsigned int i;
+
+    for (i = 0; i < nr && ghosts[i]; i++)
+        ai_security_profile_remove_from_hash(ghosts[i]);
+    synchronize_rcu();
+
+    for (i = 0; i < nr && ghosts[i]; i++)
+        kmem_cache_free(ai_sec_mgr->profile_cache, ghosts[i]);
+    kvfree(ghosts);
+}
+
+/*
+ * The file_permission hook on steady-state IO: the caller's profile is
+ * looked up among nr others and the cached verdict answers. The one
+ * tracked task making the calls is the test itself; the others are
+ * stand-ins that load the profile table.
+ */
+static void ai_security_bench_file_permission(struct kunit *test)
+{
+    const unsigned int nr = *(const unsigned int *)test->param_value;
+    struct ai_security_profile **ghosts = NULL;
+    struct file *file;
+    unsigned int i;
+    u64 ns;
+
+    if (!static_key_enabled(&ai_security_hooks_active))
+        kunit_skip(test, "Built-in hooks are off (BPF offload)");
+
+    file = filp_open("/dev/null", O_RDONLY, 0);
+    if (IS_ERR(file))
+        kunit_skip(test, "Cannot open /dev/null: %ld", PTR_ERR(file));
+
+    if (nr > 1) {
+        ghosts = ai_security_bench_ghosts(nr - 1);
+        if (!ghosts) {
+            fput(file);
+            KUNIT_FAIL(test, "No memory for %u profiles", nr);
+            return;
+        }
+    }
+
+    /* Create the caller's profile and cache its verdict */
+    aurora_bench_sink += ai_security_file_permission(file, MAY_READ);
+
+    AURORA_BENCH_LOOP(ns, i, false,
+                      aurora_bench_sink += ai_security_file_permission(file, MAY_READ),
+                      );
+    aurora_bench_report(test, "ai_security_file_permission", nr, ns);
+
+    if (ghosts)
+        ai_security_bench_unghost(ghosts, nr - 1);
+    fput(file);
+}
+
+static struct kunit_case ai_security_bench_cases[] = {
+    KUNIT_CASE_PARAM(ai_security_bench_file_permission, aurora_bench_tasks_gen_params),
+    {}
+};
+
+static struct kunit_suite ai_security_bench_suite = {
+    .name = "ai_security_bench",
+    .test_cases = ai_security_bench_cases,
+};
+
+kunit_test_suites(&ai_security_test_suite, &ai_security_bench_suite);
@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Aurora OS - AI Extensions Microbenchmark Helpers
+ *
+ * Shared by the *_bench KUnit suites in this directory. A benchmark case
+ * runs one hot-path operation AURORA_BENCH_OPS times over a working set
+ * of 1, 64, 1024 or 16384 tracked tasks, visited in an order the
+ * prefetchers cannot follow, and reports ns/op. Loading a module with
+ * bench_budget_ns=<ns> turns the report into a check, so a CI run fails
+ * when a hot path gets slower than its budget.
+ */
+
+#ifndef _AURORA_BENCH_H
+#define _AURORA_BENCH_H
+
+#include <kunit/test.h>
+#include <linux/irqflags.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+
+#define AURORA_BENCH_OPS        (1U << 16)
+#define AURORA_BENCH_BATCH      256     /* Ops timed per stretch */
+
+static const unsigned int aurora_bench_tasks[] = { 1, 64, 1024, 16384 };
+
+static void aurora_bench_tasks_desc(const unsigned int *nr, char *desc)
+{
+    snprintf(desc, KUNIT_PARAM_DESC_SIZE, "%u tasks", *nr);
+}
+
+KUNIT_ARRAY_PARAM(aurora_bench_tasks, aurora_bench_tasks, aurora_bench_tasks_desc);
+
+static unsigned int bench_budget_ns;
+module_param(bench_budget_ns, uint, 0644);
+MODULE_PARM_DESC(bench_budget_ns, "Fail benchmarks slower than this many ns/op (0 only reports)");
+
+/* Results land here so the compiler cannot drop the measured calls */
+static u64 aurora_bench_sink;
+
+/* The @i-th element to visit of a working set of @nr, a power of two */
+static inline unsigned int aurora_bench_index(unsigned int i, unsigned int nr)
+{
+    return (i * 2654435761U) & (nr - 1);
+}
+
+/*
+ * Time @op, which may use @i, AURORA_BENCH_OPS times into @ns. Ops run
+ * in stretches of AURORA_BENCH_BATCH. With @irqoff, for the hooks that
+ * run that way, interrupts are off for a stretch and @post runs after
+ * it, untimed and still on the same CPU; otherwise ops may sleep.
+ */
+#define AURORA_BENCH_LOOP(ns, i, irqoff, op, post)                      \
+do {                                                                    \
+    unsigned long __flags = 0;                                          \
+    u64 __start;                                                        \
+                                                                        \
+    (ns) = 0;                                                           \
+    for ((i) = 0; (i) < AURORA_BENCH_OPS; ) {                           \
+        if (irqoff)                                                     \
+            local_irq_save(__flags);                                    \
+        __start = local_clock();                                        \
+        do {                                                            \
+            op;                                                         \
+        } while (++(i) % AURORA_BENCH_BATCH);                           \
+        (ns) += local_clock() - __start;                                \
+        post;                                                           \
+        if (irqoff)                                                     \
+            local_irq_restore(__flags);                                 \
+        cond_resched();                                                 \
+    }                                                                   \
+} while (0)
+
+static inline void aurora_bench_report(struct kunit *test, const char *op,
+                                       unsigned int nr, u64 ns)
+{
+    u64 per_op = div_u64(ns, AURORA_BENCH_OPS);
+
+    kunit_info(test, "%s: %u tasks: %llu ns/op\n", op, nr, per_op);
+    if (bench_budget_ns)
+        KUNIT_EXPECT_LE_MSG(test, per_op, (u64)bench_budget_ns,
+                            "%s is over its budget", op);
+}
+
+#endif /* _AURORA_BENCH_H */
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Multi-buffer CRC32c for x86_64: three buffers per pass
+ *
+ * The SSE4.2 crc32 instruction has a latency of three cycles but can
+ * issue every cycle, so a single stream leaves two thirds of it idle.
+ * crc_pcl() fills the gap by splitting one large buffer in three and
+ * recombining the parts with PCLMULQDQ; independent buffers need no
+ * recombination, so they are simply interleaved. That also keeps this
+ * path out of the FPU, which matters for buffers the size of a block.
+ */
+
+#include <linux/crc32c.h>
+#include <linux/jump_label.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/types.h>
+
+#include <asm/cpufeature.h>
+#include <asm/unaligned.h>
+
+#define CRC32C_MB_LANES	3
+
+static __ro_after_init DEFINE_STATIC_KEY_FALSE(crc32c_mb_use_sse42);
+
+static void crc32c_mb_3way(u32 crc[CRC32C_MB_LANES],
+			   const u8 *const data[CRC32C_MB_LANES],
+			   unsigned int len)
+{
+	const u8 *p0 = data[0], *p1 = data[1], *p2 = data[2];
+	u32 c0 = crc[0], c1 = crc[1], c2 = crc[2];
+	unsigned int i;
+
+	for (i = len / 8; i; i--) {
+		asm("crc32q %1, %q0" : "+r" (c0) : "rm" (get_unaligned((u64 *)p0)));
+		asm("crc32q %1, %q0" : "+r" (c1) : "rm" (get_unaligned((u64 *)p1)));
+		asm("crc32q %1, %q0" : "+r" (c2) : "rm" (get_unaligned((u64 *)p2)));
+		p0 += 8;
+		p1 += 8;
+		p2 += 8;
+	}
+
+	for (i = len % 8; i; i--) {
+		asm("crc32b %1, %0" : "+r" (c0) : "rm" (*p0++));
+		asm("crc32b %1, %0" : "+r" (c1) : "rm" (*p1++));
+		asm("crc32b %1, %0" : "+r" (c2) : "rm" (*p2++));
+	}
+
+	crc[0] = c0;
+	crc[1] = c1;
+	crc[2] = c2;
+}
+
+unsigned int crc32c_mb_arch(u32 crc[], const u8 *const data[],
+			    unsigned int length, unsigned int nr)
+{
+	unsigned int i;
+
+	if (!static_branch_likely(&crc32c_mb_use_sse42))
+		return 0;
+
+	for (i = 0; i + CRC32C_MB_LANES <= nr; i += CRC32C_MB_LANES)
+		crc32c_mb_3way(&crc[i], &data[i], length);
+
+	return i;
+}
+EXPORT_SYMBOL(crc32c_mb_arch);
+
+static int __init crc32c_mb_mod_init(void)
+{
+	if (boot_cpu_has(X86_FEATURE_XMM4_2))
+		static_branch_enable(&crc32c_mb_use_sse42);
+
+	return 0;
+}
+
+module_init(crc32c_mb_mod_init);
+
+MODULE_LICENSE("GPL");
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Multi-buffer SHA-256 for x86_64: eight messages per AVX2 call
+ */
+
+#include <crypto/sha2.h>
+
+#include <linux/types.h>
+#include <linux/jump_label.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <asm/simd.h>
+#include <asm/unaligned.h>
+
+#define SHA256_MB_LANES	8
+
+asmlinkage void sha256_transform_8way_avx2(u32 state[8][SHA256_MB_LANES],
+					   const u8 *const data[SHA256_MB_LANES],
+					   size_t nblocks);
+
+static __ro_after_init DEFINE_STATIC_KEY_FALSE(sha256_mb_use_avx2);
+
+static void sha256_mb_8way(const u8 *const data[SHA256_MB_LANES],
+			   unsigned int len, u8 *const out[SHA256_MB_LANES])
+{
+	static const u32 iv[8] = {
+		SHA256_H0, SHA256_H1, SHA256_H2, SHA256_H3,
+		SHA256_H4, SHA256_H5, SHA256_H6, SHA256_H7,
+	};
+	u8 tail[SHA256_MB_LANES][2 * SHA256_BLOCK_SIZE];
+	u32 state[8][SHA256_MB_LANES];
+	const u8 *in[SHA256_MB_LANES];
+	unsigned int nblocks = len / SHA256_BLOCK_SIZE;
+	unsigned int partial = len % SHA256_BLOCK_SIZE;
+	unsigned int tail_len, i, l;
+
+	for (i = 0; i < 8; i++)
+		for (l = 0; l < SHA256_MB_LANES; l++)
+			state[i][l] = iv[i];
+
+	/* The messages have the same length, so their padding does too. */
+	tail_len = partial < SHA256_BLOCK_SIZE - 8 ? SHA256_BLOCK_SIZE :
+						     2 * SHA256_BLOCK_SIZE;
+	for (l = 0; l < SHA256_MB_LANES; l++) {
+		memcpy(tail[l], data[l] + len - partial, partial);
+		tail[l][partial] = 0x80;
+		memset(tail[l] + partial + 1, 0, tail_len - partial - 9);
+		put_unaligned_be64((u64)len << 3, tail[l] + tail_len - 8);
+		in[l] = data[l];
+	}
+
+	/* SIMD disables preemption, so relax after a page of each message. */
+	while (nblocks) {
+		const size_t blocks = min_t(size_t, nblocks,
+					    SZ_4K / SHA256_BLOCK_SIZE);
+
+		kernel_fpu_begin();
+		sha256_transform_8way_avx2(state, in, blocks);
+		kernel_fpu_end();
+
+		for (l = 0; l < SHA256_MB_LANES; l++)
+			in[l] += blocks * SHA256_BLOCK_SIZE;
+		nblocks -= blocks;
+	}
+
+	for (l = 0; l < SHA256_MB_LANES; l++)
+		in[l] = tail[l];
+	kernel_fpu_begin();
+	sha256_transform_8way_avx2(state, in, tail_len / SHA256_BLOCK_SIZE);
+	kernel_fpu_end();
+
+	for (l = 0; l < SHA256_MB_LANES; l++)
+		for (i = 0; i < 8; i++)
+			put_unaligned_be32(state[i][l], out[l] + 4 * i);
+
+	memzero_explicit(state, sizeof(state));
+	memzero_explicit(tail, sizeof(tail));
+}
+
+unsigned int sha256_mb_arch(const u8 *const data[], unsigned int len,
+			    u8 *const out[], unsigned int nr)
+{
+	unsigned int i;
+
+	if (!static_branch_likely(&sha256_mb_use_avx2) || !may_use_simd())
+		return 0;
+
+	for (i = 0; i + SHA256_MB_LANES <= nr; i += SHA256_MB_LANES)
+		sha256_mb_8way(&data[i], len, &out[i]);
+
+	return i;
+}
+EXPORT_SYMBOL(sha256_mb_arch);
+
+static int __init sha256_mb_mod_init(void)
+{
+	if (boot_cpu_has(X86_FEATURE_AVX) &&
+	    boot_cpu_has(X86_FEATURE_AVX2) &&
+	    cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM, NULL))
+		static_branch_enable(&sha256_mb_use_avx2);
+
+	return 0;
+}
+
+module_init(sha256_mb_mod_init);
+
+MODULE_LICENSE("GPL");
@@ -949,6 +949,9 @@ void __init alternative_instructions(void)
 	 * Doing paravirt patching after alternative patching would clobber
 	 * the optimization of the custom code with a function call again.
 	 */
+#if defined(CONFIG_NUMA_AWARE_SPINLOCKS)
+	cna_configure_spin_lock_slowpath();
+#endif
 	paravirt_set_cap();
 
 	/*
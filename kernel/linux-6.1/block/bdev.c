@@ -487,8 +487,9 @@ struct block_device *bdev_alloc(struct gendisk *disk, u8 partno)
 		return NULL;
 	inode->i_mode = S_IFBLK;
 	inode->i_rdev = 0;
-	inode->i_data.a_ops = &def_blk_aops;
+	inode->i_data.a_ops = &blkdev_iomap_aops;
 	mapping_set_gfp_mask(&inode->i_data, GFP_USER);
+	mapping_set_large_folios(&inode->i_data);
 
 	bdev = I_BDEV(inode);
 	mutex_init(&bdev->bd_fsfreeze_mutex);
@@ -657,6 +658,38 @@ void bd_abort_claiming(struct block_device *bdev, void *holder)
 }
 EXPORT_SYMBOL(bd_abort_claiming);
 
+/*
+ * Holders of a block device, filesystems above all, may use buffer heads
+ * on its page cache, which needs the buffer head address_space operations
+ * and single page folios. Switch the page cache to them on the first
+ * claim and back to iomap and large folios when the last claim is
+ * released. The cache is written back and dropped on the way; the inode
+ * lock keeps buffered writes out, and the invalidate lock page cache
+ * fills.
+ */
+static void bdev_set_aops(struct block_device *bdev)
+{
+	struct inode *inode = bdev->bd_inode;
+	struct address_space *mapping = inode->i_mapping;
+	const struct address_space_operations *aops;
+
+	inode_lock(inode);
+	aops = READ_ONCE(bdev->bd_holders) ? &def_blk_aops : &blkdev_iomap_aops;
+	if (mapping->a_ops != aops) {
+		filemap_invalidate_lock(mapping);
+		sync_blockdev(bdev);
+		invalidate_bh_lrus();
+		truncate_inode_pages(mapping, 0);
+		if (aops == &def_blk_aops)
+			clear_bit(AS_LARGE_FOLIO_SUPPORT, &mapping->flags);
+		else
+			set_bit(AS_LARGE_FOLIO_SUPPORT, &mapping->flags);
+		WRITE_ONCE(mapping->a_ops, aops);
+		filemap_invalidate_unlock(mapping);
+	}
+	inode_unlock(inode);
+}
+
 static void blkdev_flush_mapping(struct block_device *bdev)
 {
 	WARN_ON_ONCE(bdev->bd_holders);
@@ -842,6 +875,8 @@ struct block_device *blkdev_get_by_dev(dev_t dev, fmode_t mode, void *holder)
 	}
 	mutex_unlock(&disk->open_mutex);
 
+	if (mode & FMODE_EXCL)
+		bdev_set_aops(bdev);
 	if (unblock_events)
 		disk_unblock_events(disk);
 	return bdev;
@@ -955,6 +990,8 @@ void blkdev_put(struct block_device *bdev, fmode_t mode)
 		blkdev_put_whole(bdev, mode);
 	mutex_unlock(&disk->open_mutex);
 
+	if (mode & FMODE_EXCL)
+		bdev_set_aops(bdev);
 	module_put(disk->fops->owner);
 	blkdev_put_no_open(bdev);
 }
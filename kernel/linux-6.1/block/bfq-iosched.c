@@ -5482,7 +5482,7 @@ static void bfq_check_ioprio_change(struct bfq_io_cq *bic, struct bio *bio)
 {
 	struct bfq_data *bfqd = bic_to_bfqd(bic);
 	struct bfq_queue *bfqq;
-	int ioprio = bic->icq.ioc->ioprio;
+	int ioprio = ioc_ioprio(bic->icq.ioc);
 
 	/*
 	 * This condition may trigger on a newly created bic, be sure to
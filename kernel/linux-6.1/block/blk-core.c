@@ -1071,7 +1071,7 @@ void blk_start_plug_nr_ios(struct blk_plug *plug, unsigned short nr_ios)
 
 	plug->mq_list = NULL;
 	plug->cached_rq = NULL;
-	plug->nr_ios = min_t(unsigned short, nr_ios, BLK_MAX_REQUEST_COUNT);
+	plug->nr_ios = min_t(unsigned short, nr_ios, BLK_MAX_TAG_BATCH);
 	plug->rq_count = 0;
 	plug->multiple_queues = false;
 	plug->has_elevator = false;
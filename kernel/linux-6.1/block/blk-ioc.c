@@ -248,32 +248,21 @@ static struct io_context *alloc_io_context(gfp_t gfp_flags, int node)
 	INIT_WORK(&ioc->release_work, ioc_release_fn);
 #endif
 	ioc->ioprio = IOPRIO_DEFAULT;
+	ioc->ioprio_hint = IOPRIO_DEFAULT;
 
 	return ioc;
 }
 
-int set_task_ioprio(struct task_struct *task, int ioprio)
+static int __set_task_ioprio(struct task_struct *task, int ioprio, bool hint)
 {
-	int err;
-	const struct cred *cred = current_cred(), *tcred;
-
-	rcu_read_lock();
-	tcred = __task_cred(task);
-	if (!uid_eq(tcred->uid, cred->euid) &&
-	    !uid_eq(tcred->uid, cred->uid) && !capable(CAP_SYS_NICE)) {
-		rcu_read_unlock();
-		return -EPERM;
-	}
-	rcu_read_unlock();
-
-	err = security_task_setioprio(task, ioprio);
-	if (err)
-		return err;
-
 	task_lock(task);
 	if (unlikely(!task->io_context)) {
 		struct io_context *ioc;
 
+		/* No io context means no hint to clear */
+		if (hint && ioprio == IOPRIO_DEFAULT)
+			goto out;
+
 		task_unlock(task);
 
 		ioc = alloc_io_context(GFP_ATOMIC, NUMA_NO_NODE);
@@ -290,13 +279,57 @@ int set_task_ioprio(struct task_struct *task, int ioprio)
 		else
 			task->io_context = ioc;
 	}
-	task->io_context->ioprio = ioprio;
+	if (hint)
+		task->io_context->ioprio_hint = ioprio;
+	else
+		task->io_context->ioprio = ioprio;
 out:
 	task_unlock(task);
 	return 0;
 }
+
+int set_task_ioprio(struct task_struct *task, int ioprio)
+{
+	int err;
+	const struct cred *cred = current_cred(), *tcred;
+
+	rcu_read_lock();
+	tcred = __task_cred(task);
+	if (!uid_eq(tcred->uid, cred->euid) &&
+	    !uid_eq(tcred->uid, cred->uid) && !capable(CAP_SYS_NICE)) {
+		rcu_read_unlock();
+		return -EPERM;
+	}
+	rcu_read_unlock();
+
+	err = security_task_setioprio(task, ioprio);
+	if (err)
+		return err;
+
+	return __set_task_ioprio(task, ioprio, false);
+}
 EXPORT_SYMBOL_GPL(set_task_ioprio);
 
+/**
+ * set_task_ioprio_hint - suggest an I/O priority for a task
+ * @task: task to set the hint for
+ * @ioprio: the hinted priority, or IOPRIO_DEFAULT to clear the hint
+ *
+ * For in-kernel policy, such as a context manager that knows which tasks
+ * the user is waiting on. The hint is used only while the task has no
+ * priority of its own from ioprio_set(), so unlike set_task_ioprio() it
+ * needs no permission checks, and the result is still subject to the
+ * blk-ioprio policy of the task's cgroup. It does not survive fork.
+ */
+int set_task_ioprio_hint(struct task_struct *task, int ioprio)
+{
+	if (ioprio != IOPRIO_DEFAULT && !ioprio_valid(ioprio))
+		return -EINVAL;
+
+	return __set_task_ioprio(task, ioprio, true);
+}
+EXPORT_SYMBOL_GPL(set_task_ioprio_hint);
+
 int __copy_io(unsigned long clone_flags, struct task_struct *tsk)
 {
 	struct io_context *ioc = current->io_context;
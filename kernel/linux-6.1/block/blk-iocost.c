@@ -227,6 +227,13 @@ enum {
 
 	INUSE_ADJ_STEP_PCT	= 25,
 
+	/*
+	 * With pcpu=1, each CPU reserves vtime from an iocg 1% of a period
+	 * at a time and issues from the reservation without touching the
+	 * iocg's shared vtime, see iocg_charge_pcpu_budget().
+	 */
+	PCPU_BUDGET_PCT		= 1,
+
 	/* Have some play in timer operations */
 	TIMER_SLACK_PCT		= 1,
 
@@ -324,6 +331,7 @@ enum ioc_running {
 enum {
 	QOS_ENABLE,
 	QOS_CTRL,
+	QOS_PCPU,
 	NR_QOS_CTRL_PARAMS,
 };
 
@@ -386,6 +394,7 @@ struct ioc_margins {
 	s64				min;
 	s64				low;
 	s64				target;
+	s64				pcpu_budget;
 };
 
 struct ioc_missed {
@@ -407,6 +416,7 @@ struct ioc {
 	struct rq_qos			rqos;
 
 	bool				enabled;
+	bool				pcpu_budget;	/* pcpu=1 */
 
 	struct ioc_params		params;
 	struct ioc_margins		margins;
@@ -449,6 +459,10 @@ struct ioc {
 
 struct iocg_pcpu_stat {
 	local64_t			abs_vusage;
+
+	/* vtime reserved by this CPU in pcpu mode and the period it's for */
+	u64				vbudget;
+	u64				vbudget_period;
 };
 
 struct iocg_stat {
@@ -728,6 +742,57 @@ static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
 	put_cpu_ptr(gcs);
 }
 
+/*
+ * Charge @bio against this CPU's reservation of @iocg's vtime, topping it up
+ * with a chunk of PCPU_BUDGET_PCT of a period when it runs short. Only the
+ * top-up touches iocg->vtime; it advances ->done_vtime along with it, and
+ * the bio is issued with no cost to complete so that iocg_is_idle() still
+ * sees matching cursors. Whatever a CPU has left when the period ends stays
+ * charged, which bounds the error by one chunk per issuing CPU and period.
+ *
+ * Returns false, leaving @bio to the regular path, when the top-up would
+ * outrun the device vtime or others are already waiting or in debt.
+ */
+static bool iocg_charge_pcpu_budget(struct ioc_gq *iocg, struct bio *bio,
+				    u64 abs_cost, u64 cost, struct ioc_now *now)
+{
+	struct ioc *ioc = iocg->ioc;
+	u64 period = atomic64_read(&ioc->cur_period);
+	struct iocg_pcpu_stat *gcs;
+	unsigned long flags;
+	bool charged = true;
+
+	local_irq_save(flags);
+	gcs = this_cpu_ptr(iocg->pcpu_stat);
+
+	if (gcs->vbudget_period != period) {
+		gcs->vbudget_period = period;
+		gcs->vbudget = 0;
+	}
+
+	if (gcs->vbudget < cost) {
+		u64 chunk = max_t(u64, cost, ioc->margins.pcpu_budget);
+		u64 vtime = atomic64_read(&iocg->vtime);
+
+		if (waitqueue_active(&iocg->waitq) || iocg->abs_vdebt ||
+		    !time_before_eq64(vtime + chunk, now->vnow)) {
+			charged = false;
+			goto out;
+		}
+
+		atomic64_add(chunk, &iocg->vtime);
+		atomic64_add(chunk, &iocg->done_vtime);
+		gcs->vbudget += chunk;
+	}
+
+	gcs->vbudget -= cost;
+	local64_add(abs_cost, &gcs->abs_vusage);
+	bio->bi_iocost_cost = 0;
+out:
+	local_irq_restore(flags);
+	return charged;
+}
+
 static void iocg_lock(struct ioc_gq *iocg, bool lock_ioc, unsigned long *flags)
 {
 	if (lock_ioc) {
@@ -760,6 +825,7 @@ static void ioc_refresh_margins(struct ioc *ioc)
 	margins->min = (period_us * MARGIN_MIN_PCT / 100) * vrate;
 	margins->low = (period_us * MARGIN_LOW_PCT / 100) * vrate;
 	margins->target = (period_us * MARGIN_TARGET_PCT / 100) * vrate;
+	margins->pcpu_budget = (period_us * PCPU_BUDGET_PCT / 100) * vrate;
 }
 
 /* latency Qos params changed, update period_us and all the dependent params */
@@ -2600,6 +2666,10 @@ static void ioc_rqos_throttle(struct rq_qos *rqos, struct bio *bio)
 	vtime = atomic64_read(&iocg->vtime);
 	cost = adjust_inuse_and_calc_cost(iocg, vtime, abs_cost, &now);
 
+	if (ioc->pcpu_budget &&
+	    iocg_charge_pcpu_budget(iocg, bio, abs_cost, cost, &now))
+		return;
+
 	/*
 	 * If no one's waiting and within budget, issue right away.  The
 	 * tests are racy but the races aren't systemic - we only miss once
@@ -3143,7 +3213,7 @@ static u64 ioc_qos_prfill(struct seq_file *sf, struct blkg_policy_data *pd,
 	if (!dname)
 		return 0;
 
-	seq_printf(sf, "%s enable=%d ctrl=%s rpct=%u.%02u rlat=%u wpct=%u.%02u wlat=%u min=%u.%02u max=%u.%02u\n",
+	seq_printf(sf, "%s enable=%d ctrl=%s rpct=%u.%02u rlat=%u wpct=%u.%02u wlat=%u min=%u.%02u max=%u.%02u pcpu=%d\n",
 		   dname, ioc->enabled, ioc->user_qos_params ? "user" : "auto",
 		   ioc->params.qos[QOS_RPPM] / 10000,
 		   ioc->params.qos[QOS_RPPM] % 10000 / 100,
@@ -3154,7 +3224,8 @@ static u64 ioc_qos_prfill(struct seq_file *sf, struct blkg_policy_data *pd,
 		   ioc->params.qos[QOS_MIN] / 10000,
 		   ioc->params.qos[QOS_MIN] % 10000 / 100,
 		   ioc->params.qos[QOS_MAX] / 10000,
-		   ioc->params.qos[QOS_MAX] % 10000 / 100);
+		   ioc->params.qos[QOS_MAX] % 10000 / 100,
+		   ioc->pcpu_budget);
 	return 0;
 }
 
@@ -3170,6 +3241,7 @@ static int ioc_qos_show(struct seq_file *sf, void *v)
 static const match_table_t qos_ctrl_tokens = {
 	{ QOS_ENABLE,		"enable=%u"	},
 	{ QOS_CTRL,		"ctrl=%s"	},
+	{ QOS_PCPU,		"pcpu=%u"	},
 	{ NR_QOS_CTRL_PARAMS,	NULL		},
 };
 
@@ -3190,7 +3262,7 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 	struct gendisk *disk;
 	struct ioc *ioc;
 	u32 qos[NR_QOS_PARAMS];
-	bool enable, user;
+	bool enable, user, pcpu;
 	char *p;
 	int ret;
 
@@ -3211,6 +3283,7 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 	memcpy(qos, ioc->params.qos, sizeof(qos));
 	enable = ioc->enabled;
 	user = ioc->user_qos_params;
+	pcpu = ioc->pcpu_budget;
 	spin_unlock_irq(&ioc->lock);
 
 	while ((p = strsep(&input, " \t\n"))) {
@@ -3236,6 +3309,10 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 			else
 				goto einval;
 			continue;
+		case QOS_PCPU:
+			match_u64(&args[0], &v);
+			pcpu = v;
+			continue;
 		}
 
 		tok = match_token(p, qos_tokens, args);
@@ -3296,6 +3373,8 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 		ioc->user_qos_params = false;
 	}
 
+	ioc->pcpu_budget = pcpu;
+
 	ioc_refresh_params(ioc, true);
 	spin_unlock_irq(&ioc->lock);
 
@@ -194,7 +194,9 @@ void blkcg_set_ioprio(struct bio *bio)
 	 * correspond to a lower priority. Hence, the max_t() below selects
 	 * the lower priority of bi_ioprio and the cgroup I/O priority class.
 	 * If the bio I/O priority equals IOPRIO_CLASS_NONE, the cgroup I/O
-	 * priority is assigned to the bio.
+	 * priority is assigned to the bio. A priority hinted with
+	 * set_task_ioprio_hint() is already in bi_ioprio, so the cgroup
+	 * policy bounds it like one set with ioprio_set().
 	 */
 	prio = max_t(u16, bio->bi_ioprio,
 			IOPRIO_PRIO_VALUE(blkcg->prio_policy, 0));
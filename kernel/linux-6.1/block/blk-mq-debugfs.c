@@ -539,6 +539,17 @@ static int hctx_dispatch_busy_show(void *data, struct seq_file *m)
 	return 0;
 }
 
+static int hctx_poll_hybrid_show(void *data, struct seq_file *m)
+{
+	struct blk_mq_hw_ctx *hctx = data;
+
+	seq_printf(m, "read_lat=%lu write_lat=%lu sleep=%u/1024\n",
+		   READ_ONCE(hctx->poll_lat[READ]),
+		   READ_ONCE(hctx->poll_lat[WRITE]),
+		   READ_ONCE(hctx->poll_sleep));
+	return 0;
+}
+
 #define CTX_RQ_SEQ_OPS(name, type)					\
 static void *ctx_##name##_rq_list_start(struct seq_file *m, loff_t *pos) \
 	__acquires(&ctx->lock)						\
@@ -654,6 +665,7 @@ static const struct blk_mq_debugfs_attr blk_mq_debugfs_hctx_attrs[] = {
 	{"run", 0600, hctx_run_show, hctx_run_write},
 	{"active", 0400, hctx_active_show},
 	{"dispatch_busy", 0400, hctx_dispatch_busy_show},
+	{"poll_hybrid", 0400, hctx_poll_hybrid_show},
 	{"type", 0400, hctx_type_show},
 	{},
 };
@@ -125,9 +125,23 @@ unsigned long blk_mq_get_tags(struct blk_mq_alloc_data *data, int nr_tags,
 	struct sbitmap_queue *bt = &tags->bitmap_tags;
 	unsigned long ret;
 
-	if (data->shallow_depth ||data->flags & BLK_MQ_REQ_RESERVED ||
-	    data->hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED)
+	if (data->shallow_depth ||data->flags & BLK_MQ_REQ_RESERVED)
 		return 0;
+
+	/*
+	 * Namespaces or LUNs of one controller share its tags. Batch no
+	 * more than what is left of this queue's fair share, the limit
+	 * __blk_mq_get_tag() applies to single tags.
+	 */
+	if (data->hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED) {
+		if (data->rq_flags & RQF_ELV)
+			return 0;
+		nr_tags = min_t(unsigned int, nr_tags,
+				hctx_tags_left(data->hctx, bt));
+		if (nr_tags < 2)
+			return 0;
+	}
+
 	ret = __sbitmap_queue_get_batch(bt, nr_tags, offset);
 	*offset += tags->nr_reserved_tags;
 	return ret;
@@ -47,6 +47,7 @@ static DEFINE_PER_CPU(struct llist_head, blk_cpu_done);
 
 static void blk_mq_poll_stats_start(struct request_queue *q);
 static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb);
+static void blk_mq_poll_lat_add(struct request *rq, u64 now);
 
 static int blk_mq_poll_stats_bkt(const struct request *rq)
 {
@@ -68,6 +69,18 @@ static int blk_mq_poll_stats_bkt(const struct request *rq)
 #define BLK_QC_T_SHIFT		16
 #define BLK_QC_T_INTERNAL	(1U << 31)
 
+/*
+ * Adaptive hybrid polling, per hardware queue: sleep for poll_sleep/1024
+ * of the average completion time, starting from half of it, then spin.
+ */
+#define BLK_MQ_POLL_SLEEP_SHIFT	10
+#define BLK_MQ_POLL_SLEEP_INIT	(1U << (BLK_MQ_POLL_SLEEP_SHIFT - 1))
+#define BLK_MQ_POLL_SLEEP_MIN	(1U << (BLK_MQ_POLL_SLEEP_SHIFT - 4))
+#define BLK_MQ_POLL_SLEEP_MAX	((1U << BLK_MQ_POLL_SLEEP_SHIFT) - BLK_MQ_POLL_SLEEP_MIN)
+#define BLK_MQ_POLL_SLEEP_INC	(1U << (BLK_MQ_POLL_SLEEP_SHIFT - 6))
+#define BLK_MQ_POLL_SLEEP_DEC	8
+#define BLK_MQ_POLL_LAT_WEIGHT	8
+
 static inline struct blk_mq_hw_ctx *blk_qc_to_hctx(struct request_queue *q,
 		blk_qc_t qc)
 {
@@ -1022,6 +1035,8 @@ static inline void __blk_mq_end_request_acct(struct request *rq, u64 now)
 	if (rq->rq_flags & RQF_STATS) {
 		blk_mq_poll_stats_start(rq->q);
 		blk_stat_add(rq, now);
+		if (rq->cmd_flags & REQ_POLLED)
+			blk_mq_poll_lat_add(rq, now);
 	}
 
 	blk_mq_sched_completed_request(rq, now);
@@ -3720,6 +3735,7 @@ blk_mq_alloc_hctx(struct request_queue *q, struct blk_mq_tag_set *set,
 	INIT_LIST_HEAD(&hctx->dispatch);
 	hctx->queue = q;
 	hctx->flags = set->flags & ~BLK_MQ_F_TAG_QUEUE_SHARED;
+	hctx->poll_sleep = BLK_MQ_POLL_SLEEP_INIT;
 
 	INIT_LIST_HEAD(&hctx->hctx_list);
 
@@ -4828,10 +4844,24 @@ static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb)
 	}
 }
 
+/* Record the completion time of a polled request on its hardware queue */
+static void blk_mq_poll_lat_add(struct request *rq, u64 now)
+{
+	unsigned long *lat = &rq->mq_hctx->poll_lat[rq_data_dir(rq)];
+	unsigned long value, old = READ_ONCE(*lat);
+
+	value = now >= rq->io_start_time_ns ? now - rq->io_start_time_ns : 0;
+	if (old)
+		value = old - old / BLK_MQ_POLL_LAT_WEIGHT +
+			value / BLK_MQ_POLL_LAT_WEIGHT;
+	WRITE_ONCE(*lat, value);
+}
+
 static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
+				       struct blk_mq_hw_ctx *hctx,
 				       struct request *rq)
 {
-	unsigned long ret = 0;
+	unsigned long lat;
 	int bucket;
 
 	/*
@@ -4842,60 +4872,78 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 		return 0;
 
 	/*
-	 * As an optimistic guess, use half of the mean service time
-	 * for this type of request. We can (and should) make this smarter.
-	 * For instance, if the completion latencies are tight, we can
-	 * get closer than just half the mean. This is especially
-	 * important on devices where the completion latencies are longer
-	 * than ~10 usec. We do use the stats for the relevant IO size
-	 * if available which does lead to better estimates.
+	 * Sleep for the learned fraction of the average completion time
+	 * on this hardware queue. Until the queue has completed a polled
+	 * request of this direction, go by the device wide mean for the
+	 * request size.
 	 */
-	bucket = blk_mq_poll_stats_bkt(rq);
-	if (bucket < 0)
-		return ret;
+	lat = READ_ONCE(hctx->poll_lat[rq_data_dir(rq)]);
+	if (!lat) {
+		bucket = blk_mq_poll_stats_bkt(rq);
+		if (bucket < 0 || !q->poll_stat[bucket].nr_samples)
+			return 0;
+		lat = q->poll_stat[bucket].mean;
+	}
 
-	if (q->poll_stat[bucket].nr_samples)
-		ret = (q->poll_stat[bucket].mean + 1) / 2;
+	return (lat * READ_ONCE(hctx->poll_sleep)) >> BLK_MQ_POLL_SLEEP_SHIFT;
+}
 
-	return ret;
+/*
+ * Adapt the sleep fraction to what the wakeup found. Completions already
+ * waiting mean we may have slept past them, so back off quickly; none
+ * mean we woke early and are about to spin, so sleep a little longer
+ * next time. This keeps the spin after most wakeups short while rarely
+ * sleeping through a completion.
+ */
+static void blk_mq_poll_sleep_adjust(struct blk_mq_hw_ctx *hctx, bool late)
+{
+	unsigned int sleep = READ_ONCE(hctx->poll_sleep);
+
+	if (late)
+		sleep -= sleep / BLK_MQ_POLL_SLEEP_DEC;
+	else
+		sleep += BLK_MQ_POLL_SLEEP_INC;
+	WRITE_ONCE(hctx->poll_sleep,
+		   clamp_t(unsigned int, sleep, BLK_MQ_POLL_SLEEP_MIN,
+			   BLK_MQ_POLL_SLEEP_MAX));
 }
 
-static bool blk_mq_poll_hybrid(struct request_queue *q, blk_qc_t qc)
+static int blk_mq_poll_hybrid(struct request_queue *q, blk_qc_t qc,
+			      struct io_comp_batch *iob)
 {
 	struct blk_mq_hw_ctx *hctx = blk_qc_to_hctx(q, qc);
 	struct request *rq = blk_qc_to_rq(hctx, qc);
 	struct hrtimer_sleeper hs;
 	enum hrtimer_mode mode;
 	unsigned int nsecs;
+	bool adaptive;
 	ktime_t kt;
+	int ret;
 
 	/*
 	 * If a request has completed on queue that uses an I/O scheduler, we
 	 * won't get back a request from blk_qc_to_rq.
 	 */
 	if (!rq || (rq->rq_flags & RQF_MQ_POLL_SLEPT))
-		return false;
+		return 0;
 
 	/*
 	 * If we get here, hybrid polling is enabled. Hence poll_nsec can be:
 	 *
-	 *  0:	use half of prev avg
+	 *  0:	use the learned fraction of the queue's avg
 	 * >0:	use this specific value
 	 */
-	if (q->poll_nsec > 0)
+	adaptive = q->poll_nsec == 0;
+	if (!adaptive)
 		nsecs = q->poll_nsec;
 	else
-		nsecs = blk_mq_poll_nsecs(q, rq);
+		nsecs = blk_mq_poll_nsecs(q, hctx, rq);
 
 	if (!nsecs)
-		return false;
+		return 0;
 
 	rq->rq_flags |= RQF_MQ_POLL_SLEPT;
 
-	/*
-	 * This will be replaced with the stats tracking code, using
-	 * 'avg_completion_time / 2' as the pre-sleep target.
-	 */
 	kt = nsecs;
 
 	mode = HRTIMER_MODE_REL;
@@ -4916,6 +4964,11 @@ static bool blk_mq_poll_hybrid(struct request_queue *q, blk_qc_t qc)
 	__set_current_state(TASK_RUNNING);
 	destroy_hrtimer_on_stack(&hs.timer);
 
+	/* See what the wakeup finds, and learn from it */
+	ret = q->mq_ops->poll(hctx, iob);
+	if (adaptive)
+		blk_mq_poll_sleep_adjust(hctx, ret > 0);
+
 	/*
 	 * If we sleep, have the caller restart the poll loop to reset the
 	 * state.  Like for the other success return cases, the caller is
@@ -4923,7 +4976,7 @@ static bool blk_mq_poll_hybrid(struct request_queue *q, blk_qc_t qc)
 	 * complete, we'll get called again and will go straight to the busy
 	 * poll loop.
 	 */
-	return true;
+	return ret > 0 ? ret : 1;
 }
 
 static int blk_mq_poll_classic(struct request_queue *q, blk_qc_t cookie,
@@ -4959,8 +5012,10 @@ int blk_mq_poll(struct request_queue *q, blk_qc_t cookie, struct io_comp_batch *
 {
 	if (!(flags & BLK_POLL_NOSLEEP) &&
 	    q->poll_nsec != BLK_MQ_POLL_CLASSIC) {
-		if (blk_mq_poll_hybrid(q, cookie))
-			return 1;
+		int ret = blk_mq_poll_hybrid(q, cookie, iob);
+
+		if (ret)
+			return ret;
 	}
 	return blk_mq_poll_classic(q, cookie, iob, flags);
 }
@@ -338,39 +338,50 @@ static inline void blk_mq_free_requests(struct list_head *list)
  * For shared tag users, we track the number of currently active users
  * and attempt to provide a fair share of the tag depth for each of them.
  */
-static inline bool hctx_may_queue(struct blk_mq_hw_ctx *hctx,
-				  struct sbitmap_queue *bt)
+/*
+ * Number of tags @hctx may still take from its share of a shared tag set,
+ * UINT_MAX if it is not limited.
+ */
+static inline unsigned int hctx_tags_left(struct blk_mq_hw_ctx *hctx,
+					  struct sbitmap_queue *bt)
 {
-	unsigned int depth, users;
+	unsigned int depth, users, active;
 
 	if (!hctx || !(hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED))
-		return true;
+		return UINT_MAX;
 
 	/*
 	 * Don't try dividing an ant
 	 */
 	if (bt->sb.depth == 1)
-		return true;
+		return UINT_MAX;
 
 	if (blk_mq_is_shared_tags(hctx->flags)) {
 		struct request_queue *q = hctx->queue;
 
 		if (!test_bit(QUEUE_FLAG_HCTX_ACTIVE, &q->queue_flags))
-			return true;
+			return UINT_MAX;
 	} else {
 		if (!test_bit(BLK_MQ_S_TAG_ACTIVE, &hctx->state))
-			return true;
+			return UINT_MAX;
 	}
 
 	users = READ_ONCE(hctx->tags->active_queues);
 	if (!users)
-		return true;
+		return UINT_MAX;
 
 	/*
 	 * Allow at least some tags
 	 */
 	depth = max((bt->sb.depth + users - 1) / users, 4U);
-	return __blk_mq_active_requests(hctx) < depth;
+	active = __blk_mq_active_requests(hctx);
+	return active < depth ? depth - active : 0;
+}
+
+static inline bool hctx_may_queue(struct blk_mq_hw_ctx *hctx,
+				  struct sbitmap_queue *bt)
+{
+	return hctx_tags_left(hctx, bt) > 0;
 }
 
 /* run the code block in @dispatch_ops with rcu/srcu read lock held */
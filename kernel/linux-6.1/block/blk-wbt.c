@@ -15,6 +15,9 @@
  *   scaling step of 0 if reads show up or the heavy writers finish. Unlike
  *   positive scaling steps where we shrink the monitoring window, a negative
  *   scaling step retains the default step==0 window size.
+ * - The depth is shared between cgroups: writes are accounted to the cgroup
+ *   the bio was issued for, which for writeback is the cgroup owning the
+ *   inode, and cgroups writing at the same time each get an even share.
  *
  * Copyright (C) 2016 Jens Axboe
  *
@@ -23,8 +26,10 @@
 #include <linux/blk_types.h>
 #include <linux/slab.h>
 #include <linux/backing-dev.h>
+#include <linux/hash.h>
 #include <linux/swap.h>
 
+#include "blk-cgroup.h"
 #include "blk-wbt.h"
 #include "blk-rq-qos.h"
 
@@ -110,7 +115,46 @@ static inline struct rq_wait *get_rq_wait(struct rq_wb *rwb,
 	else if (wb_acct & WBT_DISCARD)
 		return &rwb->rq_wait[WBT_RWQ_DISCARD];
 
-	return &rwb->rq_wait[WBT_RWQ_BG];
+	return &rwb->rq_wait[WBT_RWQ_BG + (wb_acct >> WBT_NR_BITS)];
+}
+
+static inline bool wbt_is_cg_rqw(struct rq_wb *rwb, struct rq_wait *rqw)
+{
+	return rqw < &rwb->rq_wait[WBT_RWQ_BG + WBT_NR_CG_RWQ];
+}
+
+/*
+ * Writes from several cgroups split the limit evenly between the cgroups
+ * with writes in flight or waiting, so one streaming writer only fills
+ * its own share and the writes and fsyncs of the others do not queue up
+ * behind it. A cgroup writing alone gets the whole limit.
+ */
+static unsigned int wbt_cg_limit(struct rq_wb *rwb, struct rq_wait *rqw,
+				 unsigned int limit)
+{
+	unsigned int i, active = 1;
+
+	if (limit == UINT_MAX)
+		return limit;
+
+	for (i = WBT_RWQ_BG; i < WBT_RWQ_BG + WBT_NR_CG_RWQ; i++) {
+		struct rq_wait *other = &rwb->rq_wait[i];
+
+		if (other != rqw && (atomic_read(&other->inflight) ||
+				     wq_has_sleeper(&other->wait)))
+			active++;
+	}
+
+	return DIV_ROUND_UP(limit, active);
+}
+
+static unsigned int wbt_cg_bucket(struct bio *bio)
+{
+#ifdef CONFIG_BLK_CGROUP
+	if (bio->bi_blkg)
+		return hash_32(bio->bi_blkg->blkcg->css.id, WBT_CG_BITS);
+#endif
+	return 0;
 }
 
 static void rwb_wake_all(struct rq_wb *rwb)
@@ -132,6 +176,15 @@ static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
 
 	inflight = atomic_dec_return(&rqw->inflight);
 
+	/*
+	 * A cgroup going idle grows the share of the others, see
+	 * wbt_cg_limit(); give their waiters a chance at it.
+	 */
+	if (!inflight && wbt_is_cg_rqw(rwb, rqw)) {
+		rwb_wake_all(rwb);
+		return;
+	}
+
 	/*
 	 * wbt got disabled with IO in flight. Wake up any potential
 	 * waiters, we don't have to do more than that.
@@ -496,7 +549,11 @@ struct wbt_wait_data {
 static bool wbt_inflight_cb(struct rq_wait *rqw, void *private_data)
 {
 	struct wbt_wait_data *data = private_data;
-	return rq_wait_inc_below(rqw, get_limit(data->rwb, data->opf));
+	unsigned int limit = get_limit(data->rwb, data->opf);
+
+	if (wbt_is_cg_rqw(data->rwb, rqw))
+		limit = wbt_cg_limit(data->rwb, rqw, limit);
+	return rq_wait_inc_below(rqw, limit);
 }
 
 static void wbt_cleanup_cb(struct rq_wait *rqw, void *private_data)
@@ -554,6 +611,8 @@ static enum wbt_flags bio_to_wbt_flags(struct rq_wb *rwb, struct bio *bio)
 			flags |= WBT_KSWAPD;
 		if (bio_op(bio) == REQ_OP_DISCARD)
 			flags |= WBT_DISCARD;
+		else if (!(flags & WBT_KSWAPD))
+			flags |= wbt_cg_bucket(bio) << WBT_NR_BITS;
 		flags |= WBT_TRACKED;
 	}
 	return flags;
@@ -20,9 +20,17 @@ enum wbt_flags {
 	WBT_NR_BITS		= 4,	/* number of bits */
 };
 
+/*
+ * Writes are throttled per cgroup: cgroups are hashed into WBT_NR_CG_RWQ
+ * buckets of their own, and the bucket a write was accounted to is kept
+ * in the wbt_flags bits above WBT_NR_BITS.
+ */
+#define WBT_CG_BITS		3
+#define WBT_NR_CG_RWQ		(1 << WBT_CG_BITS)
+
 enum {
-	WBT_RWQ_BG		= 0,
-	WBT_RWQ_KSWAPD,
+	WBT_RWQ_BG		= 0,	/* first of WBT_NR_CG_RWQ */
+	WBT_RWQ_KSWAPD		= WBT_RWQ_BG + WBT_NR_CG_RWQ,
 	WBT_RWQ_DISCARD,
 	WBT_NUM_RWQ,
 };
@@ -262,6 +262,12 @@ bool blk_bio_list_merge(struct request_queue *q, struct list_head *list,
 #define BLK_MAX_REQUEST_COUNT	32
 #define BLK_PLUG_FLUSH_SIZE	(128 * 1024)
 
+/*
+ * Requests a plug allocates up front, see blk_start_plug_nr_ios(). One
+ * batch comes from a single sbitmap word.
+ */
+#define BLK_MAX_TAG_BATCH	BITS_PER_LONG
+
 /*
  * Internal elevator interface
  */
@@ -448,6 +454,7 @@ long blkdev_ioctl(struct file *file, unsigned cmd, unsigned long arg);
 long compat_blkdev_ioctl(struct file *file, unsigned cmd, unsigned long arg);
 
 extern const struct address_space_operations def_blk_aops;
+extern const struct address_space_operations blkdev_iomap_aops;
 
 int disk_register_independent_access_ranges(struct gendisk *disk);
 void disk_unregister_independent_access_ranges(struct gendisk *disk);
@@ -8,6 +8,7 @@
 #include <linux/mm.h>
 #include <linux/blkdev.h>
 #include <linux/buffer_head.h>
+#include <linux/iomap.h>
 #include <linux/mpage.h>
 #include <linux/uio.h>
 #include <linux/namei.h>
@@ -440,6 +441,88 @@ const struct address_space_operations def_blk_aops = {
 	.is_dirty_writeback = buffer_check_dirty_writeback,
 };
 
+/*
+ * Unless a filesystem or another holder has claimed it, a block device's
+ * page cache uses iomap instead of buffer heads: the device maps 1:1, so
+ * there are no blocks to look up, and the mapping can use large folios,
+ * which makes large sequential IO to the raw device much cheaper than
+ * one buffer head page at a time. See bdev_set_aops().
+ */
+static int blkdev_iomap_begin(struct inode *inode, loff_t offset, loff_t length,
+		unsigned int flags, struct iomap *iomap, struct iomap *srcmap)
+{
+	struct block_device *bdev = I_BDEV(inode);
+	loff_t isize = i_size_read(inode);
+
+	iomap->bdev = bdev;
+	iomap->offset = ALIGN_DOWN(offset, bdev_logical_block_size(bdev));
+	if (iomap->offset >= isize)
+		return -EIO;
+	iomap->type = IOMAP_MAPPED;
+	iomap->addr = iomap->offset;
+	iomap->length = isize - iomap->offset;
+	return 0;
+}
+
+static const struct iomap_ops blkdev_iomap_ops = {
+	.iomap_begin		= blkdev_iomap_begin,
+};
+
+static int blkdev_iomap_read_folio(struct file *file, struct folio *folio)
+{
+	return iomap_read_folio(folio, &blkdev_iomap_ops);
+}
+
+static void blkdev_iomap_readahead(struct readahead_control *rac)
+{
+	iomap_readahead(rac, &blkdev_iomap_ops);
+}
+
+static int blkdev_map_blocks(struct iomap_writepage_ctx *wpc,
+		struct inode *inode, loff_t offset)
+{
+	loff_t isize = i_size_read(inode);
+
+	if (WARN_ON_ONCE(offset >= isize))
+		return -EIO;
+	if (offset >= wpc->iomap.offset &&
+	    offset < wpc->iomap.offset + wpc->iomap.length)
+		return 0;
+	return blkdev_iomap_begin(inode, offset, isize - offset,
+				  IOMAP_WRITE, &wpc->iomap, NULL);
+}
+
+static const struct iomap_writeback_ops blkdev_writeback_ops = {
+	.map_blocks		= blkdev_map_blocks,
+};
+
+static int blkdev_iomap_writepages(struct address_space *mapping,
+		struct writeback_control *wbc)
+{
+	struct iomap_writepage_ctx wpc = { };
+
+	return iomap_writepages(mapping, wbc, &wpc, &blkdev_writeback_ops);
+}
+
+const struct address_space_operations blkdev_iomap_aops = {
+	.dirty_folio	= filemap_dirty_folio,
+	.release_folio	= iomap_release_folio,
+	.invalidate_folio = iomap_invalidate_folio,
+	.read_folio	= blkdev_iomap_read_folio,
+	.readahead	= blkdev_iomap_readahead,
+	.writepages	= blkdev_iomap_writepages,
+	.direct_IO	= blkdev_direct_IO,
+	.is_partially_uptodate = iomap_is_partially_uptodate,
+	.error_remove_page = generic_error_remove_page,
+	.migrate_folio	= filemap_migrate_folio,
+};
+
+/* Whether buffer heads may be attached to @bdev's page cache */
+bool bdev_buffer_heads(struct block_device *bdev)
+{
+	return READ_ONCE(bdev->bd_inode->i_mapping->a_ops) == &def_blk_aops;
+}
+
 /*
  * for a block special file file_inode(file)->i_size is zero
  * so we compute the size by hand (just as in block_read/write above)
@@ -515,12 +598,42 @@ static int blkdev_close(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/*
+ * __generic_file_write_iter() for the iomap page cache. A direct write that
+ * comes up short does not fall back to a buffered one: on a block device
+ * that only happens on an IO error.
+ */
+static ssize_t blkdev_iomap_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *bd_inode = bdev_file_inode(file);
+	ssize_t ret;
+
+	current->backing_dev_info = inode_to_bdi(bd_inode);
+	ret = file_remove_privs(file);
+	if (!ret)
+		ret = file_update_time(file);
+	if (ret)
+		goto out;
+
+	if (iocb->ki_flags & IOCB_DIRECT) {
+		ret = generic_file_direct_write(iocb, from);
+	} else {
+		ret = iomap_file_buffered_write(iocb, from, &blkdev_iomap_ops);
+		if (ret > 0)
+			iocb->ki_pos += ret;
+	}
+out:
+	current->backing_dev_info = NULL;
+	return ret;
+}
+
 /*
  * Write data to the block device.  Only intended for the block device itself
  * and the raw driver which basically is a fake block device.
  *
- * Does not take i_mutex for the write and thus is not for general purpose
- * use.
+ * Only takes i_mutex shared, to keep the page cache mode stable, and thus is
+ * not for general purpose use.
  */
 static ssize_t blkdev_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
@@ -552,8 +665,19 @@ static ssize_t blkdev_write_iter(struct kiocb *iocb, struct iov_iter *from)
 		iov_iter_truncate(from, size);
 	}
 
+	if (iocb->ki_flags & IOCB_NOWAIT) {
+		if (!inode_trylock_shared(bd_inode))
+			return -EAGAIN;
+	} else {
+		inode_lock_shared(bd_inode);
+	}
+
 	blk_start_plug(&plug);
-	ret = __generic_file_write_iter(iocb, from);
+	if (bdev_buffer_heads(bdev))
+		ret = __generic_file_write_iter(iocb, from);
+	else
+		ret = blkdev_iomap_write_iter(iocb, from);
+	inode_unlock_shared(bd_inode);
 	if (ret > 0)
 		ret = generic_write_sync(iocb, ret);
 	iov_iter_reexpand(from, iov_iter_count(from) + shorted);
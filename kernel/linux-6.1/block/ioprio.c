@@ -139,8 +139,8 @@ out:
 }
 
 /*
- * If the task has set an I/O priority, use that. Otherwise, return
- * the default I/O priority.
+ * If the task has set an I/O priority, use that. Otherwise, use the hint
+ * from set_task_ioprio_hint() or, failing that, the default I/O priority.
  *
  * Expected to be called for current task or with task_lock() held to keep
  * io_context stable.
@@ -153,7 +153,7 @@ int __get_task_ioprio(struct task_struct *p)
 	if (p != current)
 		lockdep_assert_held(&p->alloc_lock);
 	if (ioc)
-		prio = ioc->ioprio;
+		prio = ioc_ioprio(ioc);
 	else
 		prio = IOPRIO_DEFAULT;
 
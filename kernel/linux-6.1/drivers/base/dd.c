@@ -60,7 +60,15 @@ static bool initcalls_done;
 /* Save the async probe drivers' name from kernel cmdline */
 #define ASYNC_DRV_NAMES_MAX_LEN	256
 static char async_probe_drv_names[ASYNC_DRV_NAMES_MAX_LEN];
-static bool async_probe_default;
+static bool async_probe_default = IS_ENABLED(CONFIG_DRIVER_ASYNC_PROBE_DEFAULT);
+
+/* Drivers known not to cope with asynchronous probing */
+#ifdef CONFIG_DRIVER_SYNC_PROBE_LIST
+static const char sync_probe_builtin_names[] = CONFIG_DRIVER_SYNC_PROBE_LIST;
+#else
+static const char sync_probe_builtin_names[] = "";
+#endif
+static char sync_probe_drv_names[ASYNC_DRV_NAMES_MAX_LEN];
 
 /*
  * In some cases, like suspend to RAM or hibernation, It might be reasonable
@@ -850,6 +858,24 @@ static int __init save_async_options(char *buf)
 }
 __setup("driver_async_probe=", save_async_options);
 
+static inline bool cmdline_requested_sync_probing(const char *drv_name)
+{
+	return parse_option_str(sync_probe_builtin_names, drv_name) ||
+	       parse_option_str(sync_probe_drv_names, drv_name);
+}
+
+/* The option format is "driver_sync_probe=drv_name1,drv_name2,..." */
+static int __init save_sync_options(char *buf)
+{
+	if (strlen(buf) >= ASYNC_DRV_NAMES_MAX_LEN)
+		pr_warn("Too long list of driver names for 'driver_sync_probe'!\n");
+
+	strscpy(sync_probe_drv_names, buf, ASYNC_DRV_NAMES_MAX_LEN);
+
+	return 1;
+}
+__setup("driver_sync_probe=", save_sync_options);
+
 bool driver_allows_async_probing(struct device_driver *drv)
 {
 	switch (drv->probe_type) {
@@ -860,6 +886,10 @@ bool driver_allows_async_probing(struct device_driver *drv)
 		return false;
 
 	default:
+		/* the fallback list wins over any async default */
+		if (cmdline_requested_sync_probing(drv->name))
+			return false;
+
 		if (cmdline_requested_async_probing(drv->name))
 			return true;
 
@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Deduplication of zram objects.
+ *
+ * Every object stored while dedup is enabled gets a zram_entry, indexed
+ * by the xxh64 checksum of its uncompressed page. A write whose checksum
+ * matches an entry with the same content takes a reference on it instead
+ * of compressing and allocating again; the object is freed when the last
+ * slot referencing it is.
+ */
+
+#include <linux/highmem.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/xxhash.h>
+
+#include "zram_drv.h"
+#include "zram_dedup.h"
+
+/* One bucket for this many pages of the device */
+#define ZRAM_HASH_PAGES_PER_BUCKET	16
+
+static struct zram_hash *zram_dedup_bucket(struct zram *zram, u64 checksum)
+{
+	return &zram->hash[checksum & (zram->hash_size - 1)];
+}
+
+u64 zram_dedup_checksum(struct page *page)
+{
+	void *mem;
+	u64 checksum;
+
+	mem = kmap_atomic(page);
+	checksum = xxh64(mem, PAGE_SIZE, 0);
+	kunmap_atomic(mem);
+
+	return checksum;
+}
+
+/*
+ * A checksum match is only a candidate; compare the content, decompressing
+ * into the stream buffer unless the object is stored uncompressed.
+ */
+static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
+			     struct page *page)
+{
+	struct zcomp_strm *zstrm;
+	void *cmem, *mem;
+	bool match = false;
+
+	if (entry->len != PAGE_SIZE)
+		zstrm = zcomp_stream_get(zram->comps[ZRAM_PRIMARY_COMP]);
+
+	cmem = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	mem = kmap_atomic(page);
+	if (entry->len == PAGE_SIZE) {
+		match = !memcmp(mem, cmem, PAGE_SIZE);
+	} else {
+		if (!zcomp_decompress(zstrm, cmem, entry->len, zstrm->buffer))
+			match = !memcmp(mem, zstrm->buffer, PAGE_SIZE);
+	}
+	kunmap_atomic(mem);
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	if (entry->len != PAGE_SIZE)
+		zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+
+	return match;
+}
+
+/*
+ * Find an entry holding the content of @page and take a reference on it.
+ * Only the first entry with a matching checksum is compared: xxh64
+ * collisions between different pages are rare enough that storing the
+ * page on its own is the better deal than walking the duplicates.
+ */
+struct zram_entry *zram_dedup_find(struct zram *zram, struct page *page,
+				   u64 checksum)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, checksum);
+	struct zram_entry *entry = NULL;
+	struct rb_node *node;
+
+	spin_lock(&hash->lock);
+	node = hash->rb_root.rb_node;
+	while (node) {
+		struct zram_entry *cur = rb_entry(node, struct zram_entry, rb_node);
+
+		if (checksum == cur->checksum) {
+			cur->refcount++;
+			entry = cur;
+			break;
+		}
+		node = checksum < cur->checksum ? node->rb_left : node->rb_right;
+	}
+	spin_unlock(&hash->lock);
+
+	if (!entry)
+		return NULL;
+
+	if (zram_dedup_match(zram, entry, page)) {
+		atomic64_add(entry->len, &zram->stats.dup_data_size);
+		return entry;
+	}
+
+	zram_dedup_put(zram, entry);
+	return NULL;
+}
+
+/*
+ * Wrap a newly stored object in an entry with one reference. Returns NULL
+ * if the entry cannot be allocated, in which case the caller stores
+ * @handle as a plain, unshared object.
+ */
+struct zram_entry *zram_dedup_insert(struct zram *zram, unsigned long handle,
+				     unsigned int len, u64 checksum)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, checksum);
+	struct rb_node **link, *parent = NULL;
+	struct zram_entry *entry;
+
+	entry = kzalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->handle = handle;
+	entry->checksum = checksum;
+	entry->len = len;
+	entry->refcount = 1;
+
+	spin_lock(&hash->lock);
+	link = &hash->rb_root.rb_node;
+	while (*link) {
+		struct zram_entry *cur;
+
+		parent = *link;
+		cur = rb_entry(parent, struct zram_entry, rb_node);
+		link = checksum < cur->checksum ? &parent->rb_left : &parent->rb_right;
+	}
+	rb_link_node(&entry->rb_node, parent, link);
+	rb_insert_color(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+	return entry;
+}
+
+void zram_dedup_put(struct zram *zram, struct zram_entry *entry)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, entry->checksum);
+	unsigned long refcount;
+
+	spin_lock(&hash->lock);
+	refcount = --entry->refcount;
+	if (!refcount)
+		rb_erase(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	if (refcount) {
+		atomic64_sub(entry->len, &zram->stats.dup_data_size);
+		return;
+	}
+
+	zs_free(zram->mem_pool, entry->handle);
+	atomic64_sub(entry->len, &zram->stats.compr_data_size);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	kfree(entry);
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	zram->hash_size = roundup_pow_of_two(max_t(size_t, 1,
+				num_pages / ZRAM_HASH_PAGES_PER_BUCKET));
+	zram->hash = kvcalloc(zram->hash_size, sizeof(*zram->hash), GFP_KERNEL);
+	if (!zram->hash)
+		return -ENOMEM;
+
+	for (i = 0; i < zram->hash_size; i++) {
+		spin_lock_init(&zram->hash[i].lock);
+		zram->hash[i].rb_root = RB_ROOT;
+	}
+	return 0;
+}
+
+/* All slots must have been freed, which drops every entry */
+void zram_dedup_fini(struct zram *zram)
+{
+	kvfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
@@ -15,7 +15,9 @@
 #ifndef _ZRAM_DRV_H_
 #define _ZRAM_DRV_H_
 
+#include <linux/rbtree.h>
 #include <linux/rwsem.h>
+#include <linux/spinlock.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
 
@@ -49,10 +51,30 @@ enum zram_pageflags {
 	ZRAM_UNDER_WB,	/* page is under writeback */
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
+	ZRAM_INCOMPRESSIBLE, /* none of the algorithms could compress it */
+	ZRAM_DEDUP,	/* handle is a struct zram_entry shared with other pages */
+
+	ZRAM_COMP_PRIORITY_BIT1, /* First bit of comp priority index */
+	ZRAM_COMP_PRIORITY_BIT2, /* Second bit of comp priority index */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
 
+/*
+ * Index of the algorithm in zram->comps[] that compressed a page, stored
+ * in the ZRAM_COMP_PRIORITY bits of its flags. The primary algorithm
+ * compresses every write; the secondary ones only recompress pages from
+ * the recompress attr.
+ */
+#define ZRAM_COMP_PRIORITY_MASK	0x3
+#define ZRAM_PRIMARY_COMP	0U
+#define ZRAM_SECONDARY_COMP	1U
+#ifdef CONFIG_ZRAM_MULTI_COMP
+#define ZRAM_MAX_COMPS	4
+#else
+#define ZRAM_MAX_COMPS	1
+#endif
+
 /*-- Data structures */
 
 /* Allocated for each disk page */
@@ -67,6 +89,25 @@ struct zram_table_entry {
 #endif
 };
 
+/*
+ * A compressed object that several identical pages can share, see
+ * zram_dedup.c. The slots referencing it hold its address as their
+ * handle and have ZRAM_DEDUP set.
+ */
+struct zram_entry {
+	struct rb_node rb_node;
+	unsigned long handle;	/* zsmalloc handle of the object */
+	u64 checksum;		/* xxh64 of the uncompressed page */
+	unsigned int len;	/* compressed size, PAGE_SIZE if huge */
+	unsigned long refcount;	/* protected by zram_hash->lock */
+};
+
+/* One bucket of the dedup index, entries sorted by checksum */
+struct zram_hash {
+	spinlock_t lock;
+	struct rb_root rb_root;
+};
+
 struct zram_stats {
 	atomic64_t compr_data_size;	/* compressed size of pages stored */
 	atomic64_t num_reads;	/* failed + successful */
@@ -82,6 +123,10 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dup_data_size;	/* compressed bytes saved by dedup */
+	atomic64_t meta_data_size;	/* size of the dedup entries */
+#endif
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
@@ -92,7 +137,7 @@ struct zram_stats {
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
-	struct zcomp *comp;
+	struct zcomp *comps[ZRAM_MAX_COMPS];
 	struct gendisk *disk;
 	/* Prevent concurrent execution of device init */
 	struct rw_semaphore init_lock;
@@ -107,7 +152,7 @@ struct zram {
 	 * we can store in a disk.
 	 */
 	u64 disksize;	/* bytes */
-	char compressor[CRYPTO_MAX_ALG_NAME];
+	const char *comp_algs[ZRAM_MAX_COMPS];
 	/*
 	 * zram is claimed so open request will be failed
 	 */
@@ -124,5 +169,10 @@ struct zram {
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	struct dentry *debugfs_dir;
 #endif
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+	struct zram_hash *hash;
+	size_t hash_size;
+#endif
 };
 #endif
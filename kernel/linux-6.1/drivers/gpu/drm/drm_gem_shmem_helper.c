@@ -6,6 +6,7 @@
 #include <linux/dma-buf.h>
 #include <linux/export.h>
 #include <linux/module.h>
+#include <linux/mount.h>
 #include <linux/mutex.h>
 #include <linux/shmem_fs.h>
 #include <linux/slab.h>
@@ -25,6 +26,17 @@
 
 MODULE_IMPORT_NS(DMA_BUF);
 
+static bool huge_pages;
+module_param(huge_pages, bool, 0444);
+MODULE_PARM_DESC(huge_pages, "Back GEM objects with transparent huge pages");
+
+static bool lazy_mmap = true;
+module_param(lazy_mmap, bool, 0644);
+MODULE_PARM_DESC(lazy_mmap, "Allocate backing pages on the first CPU fault instead of at mmap()");
+
+/* tmpfs mounted huge=within_size when huge_pages is set, else NULL */
+static struct vfsmount *drm_gem_shmem_mnt;
+
 /**
  * DOC: overview
  *
@@ -35,6 +47,12 @@ MODULE_IMPORT_NS(DMA_BUF);
  * For GEM callback helpers in struct &drm_gem_object functions, see likewise
  * named functions with an _object_ infix (e.g., drm_gem_shmem_object_vmap() wraps
  * drm_gem_shmem_vmap()). These helpers perform the necessary type conversion.
+ *
+ * With the huge_pages module parameter set, objects are created in a private
+ * tmpfs mount with huge=within_size, so large buffers get transparent huge
+ * pages. Unless lazy_mmap is cleared, mmap() only takes a reference on the
+ * pages and the first CPU fault allocates them; buffers that are mapped but
+ * only ever touched by the GPU get populated when the driver first needs them.
  */
 
 static const struct drm_gem_object_funcs drm_gem_shmem_funcs = {
@@ -77,7 +95,8 @@ __drm_gem_shmem_create(struct drm_device *dev, size_t size, bool private)
 		drm_gem_private_object_init(dev, obj, size);
 		shmem->map_wc = false; /* dma-buf mappings use always writecombine */
 	} else {
-		ret = drm_gem_object_init(dev, obj, size);
+		ret = drm_gem_object_init_with_mnt(dev, obj, size,
+						   drm_gem_shmem_mnt);
 	}
 	if (ret)
 		goto err_free;
@@ -163,18 +182,21 @@ void drm_gem_shmem_free(struct drm_gem_shmem_object *shmem)
 }
 EXPORT_SYMBOL_GPL(drm_gem_shmem_free);
 
-static int drm_gem_shmem_get_pages_locked(struct drm_gem_shmem_object *shmem)
+/*
+ * Allocate the page table. A (lazy) mmap() holds a use count without pages,
+ * so this is separate from taking a reference.
+ */
+static int drm_gem_shmem_populate_locked(struct drm_gem_shmem_object *shmem)
 {
 	struct drm_gem_object *obj = &shmem->base;
 	struct page **pages;
 
-	if (shmem->pages_use_count++ > 0)
+	if (shmem->pages)
 		return 0;
 
 	pages = drm_gem_get_pages(obj);
 	if (IS_ERR(pages)) {
 		DRM_DEBUG_KMS("Failed to get pages (%ld)\n", PTR_ERR(pages));
-		shmem->pages_use_count = 0;
 		return PTR_ERR(pages);
 	}
 
@@ -193,6 +215,19 @@ static int drm_gem_shmem_get_pages_locked(struct drm_gem_shmem_object *shmem)
 	return 0;
 }
 
+static int drm_gem_shmem_get_pages_locked(struct drm_gem_shmem_object *shmem)
+{
+	int ret;
+
+	ret = drm_gem_shmem_populate_locked(shmem);
+	if (ret)
+		return ret;
+
+	shmem->pages_use_count++;
+
+	return 0;
+}
+
 /*
  * drm_gem_shmem_get_pages - Allocate backing pages for a shmem GEM object
  * @shmem: shmem GEM object
@@ -229,6 +264,10 @@ static void drm_gem_shmem_put_pages_locked(struct drm_gem_shmem_object *shmem)
 	if (--shmem->pages_use_count > 0)
 		return;
 
+	/* Only ever mapped lazily and never faulted in */
+	if (!shmem->pages)
+		return;
+
 #ifdef CONFIG_X86
 	if (shmem->map_wc)
 		set_pages_array_wb(shmem->pages, obj->size >> PAGE_SHIFT);
@@ -546,6 +585,7 @@ static vm_fault_t drm_gem_shmem_fault(struct vm_fault *vmf)
 	vm_fault_t ret;
 	struct page *page;
 	pgoff_t page_offset;
+	int err;
 
 	/* We don't use vmf->pgoff since that has the fake offset */
 	page_offset = (vmf->address - vma->vm_start) >> PAGE_SHIFT;
@@ -553,9 +593,11 @@ static vm_fault_t drm_gem_shmem_fault(struct vm_fault *vmf)
 	mutex_lock(&shmem->pages_lock);
 
 	if (page_offset >= num_pages ||
-	    WARN_ON_ONCE(!shmem->pages) ||
+	    WARN_ON_ONCE(!shmem->pages_use_count) ||
 	    shmem->madv < 0) {
 		ret = VM_FAULT_SIGBUS;
+	} else if ((err = drm_gem_shmem_populate_locked(shmem))) {
+		ret = vmf_error(err);
 	} else {
 		page = shmem->pages[page_offset];
 
@@ -641,9 +683,18 @@ int drm_gem_shmem_mmap(struct drm_gem_shmem_object *shmem, struct vm_area_struct
 	if (is_cow_mapping(vma->vm_flags))
 		return -EINVAL;
 
-	ret = drm_gem_shmem_get_pages(shmem);
-	if (ret)
-		return ret;
+	if (lazy_mmap) {
+		/* drm_gem_shmem_fault() populates the pages */
+		ret = mutex_lock_interruptible(&shmem->pages_lock);
+		if (ret)
+			return ret;
+		shmem->pages_use_count++;
+		mutex_unlock(&shmem->pages_lock);
+	} else {
+		ret = drm_gem_shmem_get_pages(shmem);
+		if (ret)
+			return ret;
+	}
 
 	vma->vm_flags |= VM_PFNMAP | VM_DONTEXPAND | VM_DONTDUMP;
 	vma->vm_page_prot = vm_get_page_prot(vma->vm_flags);
@@ -796,6 +847,43 @@ drm_gem_shmem_prime_import_sg_table(struct drm_device *dev,
 }
 EXPORT_SYMBOL_GPL(drm_gem_shmem_prime_import_sg_table);
 
+static int __init drm_gem_shmem_init(void)
+{
+	char huge_opt[] = "huge=within_size"; /* r/w */
+	struct file_system_type *type;
+	struct vfsmount *mnt;
+
+	if (!huge_pages)
+		return 0;
+
+	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE)) {
+		pr_notice("drm_shmem_helper: huge_pages needs CONFIG_TRANSPARENT_HUGEPAGE\n");
+		return 0;
+	}
+
+	type = get_fs_type("tmpfs");
+	if (!type)
+		return 0;
+
+	/* Falling back to the regular shmem mount is not fatal */
+	mnt = vfs_kern_mount(type, SB_KERNMOUNT, type->name, huge_opt);
+	if (IS_ERR(mnt)) {
+		pr_notice("drm_shmem_helper: no huge tmpfs mount (%ld)\n",
+			  PTR_ERR(mnt));
+		return 0;
+	}
+
+	drm_gem_shmem_mnt = mnt;
+	return 0;
+}
+module_init(drm_gem_shmem_init);
+
+static void __exit drm_gem_shmem_exit(void)
+{
+	kern_unmount(drm_gem_shmem_mnt);
+}
+module_exit(drm_gem_shmem_exit);
+
 MODULE_DESCRIPTION("DRM SHMEM memory-management helpers");
 MODULE_IMPORT_NS(DMA_BUF);
 MODULE_LICENSE("GPL v2");
@@ -11,6 +11,7 @@
 #define EVDEV_MINORS		32
 #define EVDEV_MIN_BUFFER_SIZE	64U
 #define EVDEV_BUF_PACKETS	8
+#define EVDEV_RING_MAX_EVENTS	65536U
 
 #include <linux/poll.h>
 #include <linux/sched.h>
@@ -49,6 +50,15 @@ struct evdev_client {
 	enum input_clock_type clk_type;
 	bool revoked;
 	unsigned long *evmasks[EV_CNT];
+	struct input_ring_header *ring; /* mmap()ed ring, replaces buffer */
+	unsigned long ring_bytes;
+	unsigned int ring_size;
+	unsigned int ring_head; /* next slot to fill */
+	unsigned int ring_published; /* head as last published */
+	unsigned int ring_seq;
+	unsigned int ring_dropped;
+	bool ring_overflow; /* current packet did not fit */
+	bool ring_resync; /* start next packet with SYN_DROPPED */
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
@@ -241,6 +251,110 @@ static void __pass_event(struct evdev_client *client,
 	}
 }
 
+static bool evdev_ring_put(struct evdev_client *client, u16 type, u16 code,
+			   s32 value, const struct timespec64 *ts)
+{
+	struct input_ring_event *ev;
+
+	/* Pairs with the release store of tail by the reader */
+	if (client->ring_head - smp_load_acquire(&client->ring->tail) >=
+	    client->ring_size)
+		return false;
+
+	ev = (void *)client->ring + PAGE_SIZE;
+	ev += client->ring_head & (client->ring_size - 1);
+	ev->sec = ts->tv_sec;
+	ev->usec = ts->tv_nsec / NSEC_PER_USEC;
+	ev->type = type;
+	ev->code = code;
+	ev->value = value;
+	ev->reserved = 0;
+	client->ring_head++;
+
+	return true;
+}
+
+/*
+ * Ring counterpart of the buffer path below. Only the kernel's private
+ * copies of size and head are trusted; userspace owns tail and can at
+ * worst make its own packets drop. Pollers are only woken when a packet
+ * lands in a ring the reader had drained: a reader that is still behind
+ * will find the packet without sleeping, so bursts cost one wakeup.
+ */
+static void evdev_ring_pass_values(struct evdev_client *client,
+				   const struct input_value *vals,
+				   unsigned int count,
+				   const struct timespec64 *ts)
+{
+	struct input_ring_header *ring = client->ring;
+	const struct input_value *v;
+	unsigned int published;
+	bool wakeup = false;
+
+	/* Interrupts are disabled, just acquire the lock. */
+	spin_lock(&client->buffer_lock);
+
+	for (v = vals; v != vals + count; v++) {
+		if (__evdev_is_filtered(client, v->type, v->code))
+			continue;
+
+		if (v->type == EV_SYN && v->code == SYN_REPORT) {
+			/* drop empty SYN_REPORT */
+			if (!client->ring_overflow &&
+			    client->ring_head == client->ring_published)
+				continue;
+
+			if (client->ring_overflow ||
+			    !evdev_ring_put(client, v->type, v->code,
+					    v->value, ts)) {
+				client->ring_head = client->ring_published;
+				client->ring_overflow = false;
+				client->ring_resync = true;
+				WRITE_ONCE(ring->dropped, ++client->ring_dropped);
+				continue;
+			}
+
+			published = client->ring_published;
+			client->ring_published = client->ring_head;
+			WRITE_ONCE(ring->seq, ++client->ring_seq);
+			smp_store_release(&ring->head, client->ring_head);
+
+			/*
+			 * Order the head store against the tail load; the
+			 * reader's poll() orders its tail store against its
+			 * head load, so one of the two sides sees the other.
+			 */
+			smp_mb();
+			if (READ_ONCE(ring->tail) == published)
+				wakeup = true;
+			continue;
+		}
+
+		if (client->ring_overflow)
+			continue;
+
+		if (client->ring_resync &&
+		    client->ring_head == client->ring_published) {
+			if (!evdev_ring_put(client, EV_SYN, SYN_DROPPED, 0, ts)) {
+				client->ring_overflow = true;
+				continue;
+			}
+			client->ring_resync = false;
+		}
+
+		if (!evdev_ring_put(client, v->type, v->code, v->value, ts))
+			client->ring_overflow = true;
+	}
+
+	spin_unlock(&client->buffer_lock);
+
+	if (wakeup) {
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		wake_up_interruptible_poll(&client->wait,
+			EPOLLIN | EPOLLOUT | EPOLLRDNORM | EPOLLWRNORM);
+	}
+}
+
 static void evdev_pass_values(struct evdev_client *client,
 			const struct input_value *vals, unsigned int count,
 			ktime_t *ev_time)
@@ -254,6 +368,13 @@ static void evdev_pass_values(struct evdev_client *client,
 		return;
 
 	ts = ktime_to_timespec64(ev_time[client->clk_type]);
+
+	/* Set once by evdev_mmap() and kept until the client is freed */
+	if (READ_ONCE(client->ring)) {
+		evdev_ring_pass_values(client, vals, count, &ts);
+		return;
+	}
+
 	event.input_event_sec = ts.tv_sec;
 	event.input_event_usec = ts.tv_nsec / NSEC_PER_USEC;
 
@@ -451,6 +572,7 @@ static int evdev_release(struct inode *inode, struct file *file)
 	for (i = 0; i < EV_CNT; ++i)
 		bitmap_free(client->evmasks[i]);
 
+	vfree(client->ring);
 	kvfree(client);
 
 	evdev_close_device(evdev);
@@ -567,6 +689,10 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 	if (count != 0 && count < input_event_size())
 		return -EINVAL;
 
+	/* Events go to the mmap()ed ring instead */
+	if (READ_ONCE(client->ring))
+		return -EBUSY;
+
 	for (;;) {
 		if (!evdev->exist || client->revoked)
 			return -ENODEV;
@@ -620,12 +746,80 @@ static __poll_t evdev_poll(struct file *file, poll_table *wait)
 	else
 		mask = EPOLLHUP | EPOLLERR;
 
-	if (client->packet_head != client->tail)
+	if (READ_ONCE(client->ring)) {
+		if (READ_ONCE(client->ring_published) !=
+		    READ_ONCE(client->ring->tail))
+			mask |= EPOLLIN | EPOLLRDNORM;
+	} else if (client->packet_head != client->tail) {
 		mask |= EPOLLIN | EPOLLRDNORM;
+	}
 
 	return mask;
 }
 
+/*
+ * Mapping the device hands the client a shared event ring (see struct
+ * input_ring_header) so readers can consume events without a read() per
+ * packet. The ring is sized from the first mapping; later mappings share
+ * it. Events still queued in the read() buffer are discarded.
+ */
+static int evdev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct evdev_client *client = file->private_data;
+	struct evdev *evdev = client->evdev;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	struct input_ring_header *ring;
+	unsigned long nr;
+	int retval;
+
+	if (vma->vm_pgoff || size <= PAGE_SIZE)
+		return -EINVAL;
+
+	retval = mutex_lock_interruptible(&evdev->mutex);
+	if (retval)
+		return retval;
+
+	if (!evdev->exist || client->revoked) {
+		retval = -ENODEV;
+		goto out;
+	}
+
+	if (!client->ring) {
+		nr = (size - PAGE_SIZE) / sizeof(struct input_ring_event);
+		if (!nr || nr > EVDEV_RING_MAX_EVENTS) {
+			retval = -EINVAL;
+			goto out;
+		}
+		nr = rounddown_pow_of_two(nr);
+
+		ring = vmalloc_user(size);
+		if (!ring) {
+			retval = -ENOMEM;
+			goto out;
+		}
+		ring->size = nr;
+
+		spin_lock_irq(&client->buffer_lock);
+		client->ring_bytes = size;
+		client->ring_size = nr;
+		client->head = client->tail = client->packet_head = 0;
+		/* Publish the ring only once it is set up */
+		smp_store_release(&client->ring, ring);
+		spin_unlock_irq(&client->buffer_lock);
+	}
+
+	if (size > client->ring_bytes) {
+		retval = -EINVAL;
+		goto out;
+	}
+
+	retval = remap_vmalloc_range(vma, client->ring, 0);
+
+ out:
+	mutex_unlock(&evdev->mutex);
+	return retval;
+}
+
 #ifdef CONFIG_COMPAT
 
 #define BITS_PER_LONG_COMPAT (sizeof(compat_long_t) * 8)
@@ -1294,6 +1488,7 @@ static const struct file_operations evdev_fops = {
 	.read		= evdev_read,
 	.write		= evdev_write,
 	.poll		= evdev_poll,
+	.mmap		= evdev_mmap,
 	.open		= evdev_open,
 	.release	= evdev_release,
 	.unlocked_ioctl	= evdev_ioctl,
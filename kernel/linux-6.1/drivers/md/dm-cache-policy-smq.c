@@ -11,8 +11,10 @@
 
 #include <linux/hash.h>
 #include <linux/jiffies.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/overflow.h>
 #include <linux/vmalloc.h>
 #include <linux/math64.h>
 
@@ -571,6 +573,121 @@ static enum performance stats_assess(struct stats *s)
 
 /*----------------------------------------------------------------*/
 
+/*
+ * The tinylfu variant admits blocks to the cache based on how often they
+ * have been seen recently, estimated by a count-min sketch of 4-bit
+ * counters.  Each origin block hashes to one 64 byte group of the table,
+ * and its SKETCH_DEPTH counters all live in that group, so an update
+ * touches a single cache line.  Once sample_size increments have been
+ * counted every counter is halved, so the sketch follows a changing
+ * working set rather than the whole history of the device.
+ *
+ * The table has one 64 bit word (16 counters) per cache block, rounded
+ * up to a power of two.
+ */
+#define SKETCH_DEPTH 4u
+#define SKETCH_GROUP_WORDS 8u
+#define SKETCH_COUNTER_MAX 15u
+#define SKETCH_SAMPLE_FACTOR 10u
+#define SKETCH_HALVE_MASK 0x7777777777777777ull
+
+struct cm_sketch {
+	u64 *table;
+	unsigned int nr_words;
+	unsigned int group_mask;
+	unsigned int nr_samples;
+	unsigned int sample_size;
+};
+
+static int sketch_init(struct cm_sketch *cs, unsigned int nr_entries)
+{
+	cs->nr_words = roundup_pow_of_two(max(nr_entries, SKETCH_GROUP_WORDS));
+	cs->group_mask = cs->nr_words / SKETCH_GROUP_WORDS - 1u;
+	cs->nr_samples = 0u;
+	cs->sample_size = SKETCH_SAMPLE_FACTOR * max(nr_entries, SKETCH_GROUP_WORDS);
+
+	cs->table = vzalloc(array_size(cs->nr_words, sizeof(*cs->table)));
+	return cs->table ? 0 : -ENOMEM;
+}
+
+static void sketch_exit(struct cm_sketch *cs)
+{
+	vfree(cs->table);
+}
+
+static u64 sketch_hash(dm_oblock_t b)
+{
+	u64 h = hash_64(from_oblock(b), 64);
+
+	/* the low bits of a multiplicative hash are weak; fold in the high */
+	return h ^ (h >> 32);
+}
+
+/*
+ * Row i of the sketch uses word 2i or 2i + 1 of the group, picked by one
+ * bit of the hash, and one of its 16 counters, picked by the next four.
+ */
+static u64 *sketch_word(struct cm_sketch *cs, u64 h, unsigned int row)
+{
+	unsigned int group = (h >> 32) & cs->group_mask;
+
+	return cs->table + group * SKETCH_GROUP_WORDS + 2u * row + ((h >> (8u * row)) & 1u);
+}
+
+static unsigned int sketch_shift(u64 h, unsigned int row)
+{
+	return ((h >> (8u * row + 1u)) & 15u) * 4u;
+}
+
+static unsigned int sketch_estimate(struct cm_sketch *cs, dm_oblock_t b)
+{
+	unsigned int row, count, freq = SKETCH_COUNTER_MAX;
+	u64 h = sketch_hash(b);
+
+	for (row = 0; row < SKETCH_DEPTH; row++) {
+		count = (*sketch_word(cs, h, row) >> sketch_shift(h, row)) & SKETCH_COUNTER_MAX;
+		freq = min(freq, count);
+	}
+
+	return freq;
+}
+
+/*
+ * Halving is a plain pass over the words that the compiler can
+ * vectorise; it runs once every sample_size increments.
+ */
+static void sketch_halve(struct cm_sketch *cs)
+{
+	unsigned int i;
+
+	for (i = 0; i < cs->nr_words; i++)
+		cs->table[i] = (cs->table[i] >> 1) & SKETCH_HALVE_MASK;
+
+	cs->nr_samples /= 2u;
+}
+
+static void sketch_increment(struct cm_sketch *cs, dm_oblock_t b)
+{
+	unsigned int row, shift;
+	bool added = false;
+	u64 h = sketch_hash(b);
+	u64 *w;
+
+	for (row = 0; row < SKETCH_DEPTH; row++) {
+		w = sketch_word(cs, h, row);
+		shift = sketch_shift(h, row);
+		if (((*w >> shift) & SKETCH_COUNTER_MAX) != SKETCH_COUNTER_MAX) {
+			*w += 1ull << shift;
+			added = true;
+		}
+	}
+
+	if (added && ++cs->nr_samples >= cs->sample_size)
+		sketch_halve(cs);
+}
+
+/*----------------------------------------------------------------*/
+
 struct smq_hash_table {
 	struct entry_space *es;
 	unsigned long long hash_bits;
@@ -841,6 +958,14 @@ struct smq_policy {
 	struct smq_hash_table table;
 	struct smq_hash_table hotspot_table;
 
+	/*
+	 * Access frequencies for the tinylfu variant, which uses these
+	 * rather than the hotspot queue to decide on promotions.
+	 * last_oblock filters out runs of bios to the same block.
+	 */
+	struct cm_sketch sketch;
+	dm_oblock_t last_oblock;
+
 	bool current_writeback_sentinels;
 	unsigned long next_writeback_period;
 
@@ -862,6 +987,8 @@ struct smq_policy {
 	 * even if the device is not idle.
 	 */
 	bool cleaner:1;
+
+	bool tinylfu:1;
 };
 
 /*----------------------------------------------------------------*/
@@ -1298,6 +1425,52 @@ static enum promote_result should_promote(struct smq_policy *mq, struct entry *h
 		return maybe_promote(hs_e->level >= mq->read_promote_level);
 }
 
+/*
+ * A block seen this often within the sketch window is worth a free cblock.
+ * Writes need one more hit, as smq prioritises reads.
+ */
+#define TINYLFU_ADMIT_FREQ 2u
+
+static void tinylfu_record(struct smq_policy *mq, dm_oblock_t oblock)
+{
+	if (from_oblock(oblock) == from_oblock(mq->last_oblock))
+		return;
+
+	mq->last_oblock = oblock;
+	sketch_increment(&mq->sketch, oblock);
+}
+
+/*
+ * Once the cache is full a promotion means a demotion, so the candidate
+ * is only admitted if it has been used more often than the block
+ * queue_demotion() would evict for it.
+ */
+static enum promote_result tinylfu_should_promote(struct smq_policy *mq, dm_oblock_t oblock,
+						  int data_dir, bool fast_promote)
+{
+	unsigned int freq = sketch_estimate(&mq->sketch, oblock);
+	struct entry *victim;
+
+	if (data_dir == WRITE) {
+		if (!allocator_empty(&mq->cache_alloc) && fast_promote)
+			return PROMOTE_TEMPORARY;
+
+		freq = freq ? freq - 1u : 0u;
+	}
+
+	if (freq < TINYLFU_ADMIT_FREQ)
+		return PROMOTE_NOT;
+
+	if (!allocator_empty(&mq->cache_alloc))
+		return PROMOTE_PERMANENT;
+
+	victim = q_peek(&mq->clean, mq->clean.nr_levels / 2, true);
+	if (!victim)
+		return PROMOTE_PERMANENT;
+
+	return maybe_promote(freq > sketch_estimate(&mq->sketch, victim->oblock));
+}
+
 static dm_oblock_t to_hblock(struct smq_policy *mq, dm_oblock_t b)
 {
 	sector_t r = from_oblock(b);
@@ -1363,6 +1536,7 @@ static void smq_destroy(struct dm_cache_policy *p)
 	btracker_destroy(mq->bg_work);
 	h_exit(&mq->hotspot_table);
 	h_exit(&mq->table);
+	sketch_exit(&mq->sketch);
 	free_bitset(mq->hotspot_hit_bits);
 	free_bitset(mq->cache_hit_bits);
 	space_exit(&mq->es);
@@ -1380,6 +1554,9 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 
 	*background_work = false;
 
+	if (mq->tinylfu)
+		tinylfu_record(mq, oblock);
+
 	e = h_lookup(&mq->table, oblock);
 	if (e) {
 		stats_level_accessed(&mq->cache_stats, e->level);
@@ -1391,12 +1568,16 @@ static int __lookup(struct smq_policy *mq, dm_oblock_t oblock, dm_cblock_t *cblo
 	} else {
 		stats_miss(&mq->cache_stats);
 
-		/*
-		 * The hotspot queue only gets updated with misses.
-		 */
-		hs_e = update_hotspot_queue(mq, oblock);
+		if (mq->tinylfu)
+			pr = tinylfu_should_promote(mq, oblock, data_dir, fast_copy);
+		else {
+			/*
+			 * The hotspot queue only gets updated with misses.
+			 */
+			hs_e = update_hotspot_queue(mq, oblock);
+			pr = should_promote(mq, hs_e, data_dir, fast_copy);
+		}
 
-		pr = should_promote(mq, hs_e, data_dir, fast_copy);
 		if (pr != PROMOTE_NOT) {
 			queue_promotion(mq, oblock, work);
 			*background_work = true;
@@ -1727,7 +1908,7 @@ static void calc_hotspot_params(sector_t origin_size,
 
 static struct dm_cache_policy *
 __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_size,
-	     bool mimic_mq, bool migrations_allowed, bool cleaner)
+	     bool mimic_mq, bool migrations_allowed, bool cleaner, bool tinylfu)
 {
 	unsigned int i;
 	unsigned int nr_sentinels_per_queue = 2u * NR_CACHE_LEVELS;
@@ -1803,6 +1984,14 @@ __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_
 	if (h_init(&mq->hotspot_table, &mq->es, mq->nr_hotspot_blocks))
 		goto bad_alloc_hotspot_table;
 
+	if (tinylfu) {
+		if (sketch_init(&mq->sketch, from_cblock(cache_size))) {
+			DMERR("couldn't allocate frequency sketch");
+			goto bad_sketch;
+		}
+		mq->last_oblock = to_oblock(-1);
+	}
+
 	sentinels_init(mq);
 	mq->write_promote_level = mq->read_promote_level = NR_HOTSPOT_LEVELS;
 
@@ -1815,10 +2004,13 @@ __smq_create(dm_cblock_t cache_size, sector_t origin_size, sector_t cache_block_
 
 	mq->migrations_allowed = migrations_allowed;
 	mq->cleaner = cleaner;
+	mq->tinylfu = tinylfu;
 
 	return &mq->policy;
 
 bad_btracker:
+	sketch_exit(&mq->sketch);
+bad_sketch:
 	h_exit(&mq->hotspot_table);
 bad_alloc_hotspot_table:
 	h_exit(&mq->table);
@@ -1839,7 +2031,7 @@ static struct dm_cache_policy *smq_create(dm_cblock_t cache_size,
 					  sector_t cache_block_size)
 {
 	return __smq_create(cache_size, origin_size, cache_block_size,
-			    false, true, false);
+			    false, true, false, false);
 }
 
 static struct dm_cache_policy *mq_create(dm_cblock_t cache_size,
@@ -1847,7 +2039,7 @@ static struct dm_cache_policy *mq_create(dm_cblock_t cache_size,
 					 sector_t cache_block_size)
 {
 	return __smq_create(cache_size, origin_size, cache_block_size,
-			    true, true, false);
+			    true, true, false, false);
 }
 
 static struct dm_cache_policy *cleaner_create(dm_cblock_t cache_size,
@@ -1855,7 +2047,15 @@ static struct dm_cache_policy *cleaner_create(dm_cblock_t cache_size,
 					      sector_t cache_block_size)
 {
 	return __smq_create(cache_size, origin_size, cache_block_size,
-			    false, false, true);
+			    false, false, true, false);
+}
+
+static struct dm_cache_policy *tinylfu_create(dm_cblock_t cache_size,
+					      sector_t origin_size,
+					      sector_t cache_block_size)
+{
+	return __smq_create(cache_size, origin_size, cache_block_size,
+			    false, true, false, true);
 }
 
 /*----------------------------------------------------------------*/
@@ -1884,6 +2084,14 @@ static struct dm_cache_policy_type cleaner_policy_type = {
 	.create = cleaner_create,
 };
 
+static struct dm_cache_policy_type tinylfu_policy_type = {
+	.name = "tinylfu",
+	.version = {1, 0, 0},
+	.hint_size = 4,
+	.owner = THIS_MODULE,
+	.create = tinylfu_create,
+};
+
 static struct dm_cache_policy_type default_policy_type = {
 	.name = "default",
 	.version = {2, 0, 0},
@@ -1915,6 +2123,12 @@ static int __init smq_init(void)
 		goto out_cleaner;
 	}
 
+	r = dm_cache_policy_register(&tinylfu_policy_type);
+	if (r) {
+		DMERR("register failed (as tinylfu) %d", r);
+		goto out_tinylfu;
+	}
+
 	r = dm_cache_policy_register(&default_policy_type);
 	if (r) {
 		DMERR("register failed (as default) %d", r);
@@ -1924,6 +2138,8 @@ static int __init smq_init(void)
 	return 0;
 
 out_default:
+	dm_cache_policy_unregister(&tinylfu_policy_type);
+out_tinylfu:
 	dm_cache_policy_unregister(&cleaner_policy_type);
 out_cleaner:
 	dm_cache_policy_unregister(&mq_policy_type);
@@ -1935,6 +2151,7 @@ out_mq:
 
 static void __exit smq_exit(void)
 {
+	dm_cache_policy_unregister(&tinylfu_policy_type);
 	dm_cache_policy_unregister(&cleaner_policy_type);
 	dm_cache_policy_unregister(&smq_policy_type);
 	dm_cache_policy_unregister(&mq_policy_type);
@@ -1951,3 +2168,4 @@ MODULE_DESCRIPTION("smq cache policy");
 MODULE_ALIAS("dm-cache-default");
 MODULE_ALIAS("dm-cache-mq");
 MODULE_ALIAS("dm-cache-cleaner");
+MODULE_ALIAS("dm-cache-tinylfu");
@@ -31,6 +31,13 @@ module_param(csum, bool, 0444);
 module_param(gso, bool, 0444);
 module_param(napi_tx, bool, 0644);
 
+/* Most buffers a busy TX ring may queue before the device is kicked */
+static unsigned int tx_kick_batch = 16;
+module_param(tx_kick_batch, uint, 0644);
+
+static bool rss_rebalance = true;
+module_param(rss_rebalance, bool, 0644);
+
 /* FIXME: MTU in config. */
 #define GOOD_PACKET_LEN (ETH_HLEN + VLAN_HLEN + ETH_DATA_LEN)
 #define GOOD_COPY_LEN	128
@@ -55,6 +62,10 @@ DECLARE_EWMA(pkt_len, 0, 64)
 
 #define VIRTNET_DRIVER_VERSION "1.0.0"
 
+/* Interval and minimum receive rate of the RSS rebalancing work */
+#define VIRTNET_RSS_REBALANCE_INTERVAL	HZ
+#define VIRTNET_RSS_REBALANCE_MIN_PKTS	10000
+
 static const unsigned long guest_offloads[] = {
 	VIRTIO_NET_F_GUEST_TSO4,
 	VIRTIO_NET_F_GUEST_TSO6,
@@ -80,6 +91,7 @@ struct virtnet_sq_stats {
 	u64 xdp_tx;
 	u64 xdp_tx_drops;
 	u64 kicks;
+	u64 kicks_deferred;
 	u64 tx_timeouts;
 };
 
@@ -104,6 +116,7 @@ static const struct virtnet_stat_desc virtnet_sq_stats_desc[] = {
 	{ "xdp_tx",		VIRTNET_SQ_STAT(xdp_tx) },
 	{ "xdp_tx_drops",	VIRTNET_SQ_STAT(xdp_tx_drops) },
 	{ "kicks",		VIRTNET_SQ_STAT(kicks) },
+	{ "kicks_deferred",	VIRTNET_SQ_STAT(kicks_deferred) },
 	{ "tx_timeouts",	VIRTNET_SQ_STAT(tx_timeouts) },
 };
 
@@ -136,6 +149,9 @@ struct send_queue {
 
 	struct napi_struct napi;
 
+	/* Buffers added since the device was last kicked. */
+	unsigned int kick_pending;
+
 	/* Record whether sq is in reset state. */
 	bool reset;
 };
@@ -170,6 +186,9 @@ struct receive_queue {
 	char name[40];
 
 	struct xdp_rxq_info xdp_rxq;
+
+	/* Packets received as of the last RSS rebalancing pass. */
+	u64 rss_last_packets;
 };
 
 /* This structure can contain rss message with maximum settings for indirection table and keysize
@@ -241,6 +260,15 @@ struct virtnet_info {
 	u32 rss_hash_types_supported;
 	u32 rss_hash_types_saved;
 
+	/* Work struct for moving RSS indirection entries to idle queues */
+	struct delayed_work rss_work;
+
+	/* Next indirection entry the rebalancing looks at */
+	u16 rss_rebalance_pos;
+
+	/* Indirection table was set through ethtool, leave it alone */
+	bool rss_user_table;
+
 	/* Has control virtqueue */
 	bool has_cvq;
 
@@ -1749,6 +1777,10 @@ static int virtnet_open(struct net_device *dev)
 			goto err_enable_qp;
 	}
 
+	if (vi->has_rss)
+		schedule_delayed_work(&vi->rss_work,
+				      VIRTNET_RSS_REBALANCE_INTERVAL);
+
 	return 0;
 
 err_enable_qp:
@@ -1780,6 +1812,10 @@ static int virtnet_poll_tx(struct napi_struct *napi, int budget)
 	virtqueue_disable_cb(sq->vq);
 	free_old_xmit_skbs(sq, !!budget);
 
+	/* Flush buffers start_xmit() queued without a kick. */
+	if (sq->kick_pending)
+		virtnet_sq_kick(sq);
+
 	if (sq->vq->num_free >= 2 + MAX_SKB_FRAGS)
 		netif_tx_wake_queue(txq);
 
@@ -1853,6 +1889,40 @@ static int xmit_skb(struct send_queue *sq, struct sk_buff *skb)
 	return virtqueue_add_outbuf(sq->vq, sq->sg, num_sg, skb, GFP_ATOMIC);
 }
 
+static void virtnet_sq_kick(struct send_queue *sq)
+{
+	sq->kick_pending = 0;
+	if (virtqueue_kick_prepare(sq->vq) && virtqueue_notify(sq->vq)) {
+		u64_stats_update_begin(&sq->stats.syncp);
+		sq->stats.kicks++;
+		u64_stats_update_end(&sq->stats.syncp);
+	}
+}
+
+/*
+ * A kick costs a VM exit.  While at least half of the ring is still in
+ * flight the device is busy anyway, so let a few more buffers pile up
+ * and leave the kick to the next packet or to TX NAPI, which the
+ * delayed callback enabled in start_xmit() schedules once three quarters
+ * of the outstanding buffers are used.  That is why the batch is capped
+ * at an eighth of the ring: the buffers kicked before it always reach
+ * the callback threshold on their own.
+ */
+static bool virtnet_sq_defer_kick(struct send_queue *sq)
+{
+	unsigned int size = virtqueue_get_vring_size(sq->vq);
+	unsigned int batch = min(tx_kick_batch, size / 8);
+
+	if (sq->kick_pending >= batch || sq->vq->num_free > size / 2)
+		return false;
+
+	sq->kick_pending++;
+	u64_stats_update_begin(&sq->stats.syncp);
+	sq->stats.kicks_deferred++;
+	u64_stats_update_end(&sq->stats.syncp);
+	return true;
+}
+
 static netdev_tx_t start_xmit(struct sk_buff *skb, struct net_device *dev)
 {
 	struct virtnet_info *vi = netdev_priv(dev);
@@ -1922,13 +1992,9 @@ static netdev_tx_t start_xmit(struct sk_buff *skb, struct net_device *dev)
 		}
 	}
 
-	if (kick || netif_xmit_stopped(txq)) {
-		if (virtqueue_kick_prepare(sq->vq) && virtqueue_notify(sq->vq)) {
-			u64_stats_update_begin(&sq->stats.syncp);
-			sq->stats.kicks++;
-			u64_stats_update_end(&sq->stats.syncp);
-		}
-	}
+	if (netif_xmit_stopped(txq) ||
+	    (kick && !(use_napi && virtnet_sq_defer_kick(sq))))
+		virtnet_sq_kick(sq);
 
 	return NETDEV_TX_OK;
 }
@@ -2188,6 +2254,7 @@ static int virtnet_close(struct net_device *dev)
 	disable_delayed_refill(vi);
 	/* Make sure refill_work doesn't re-enable napi! */
 	cancel_delayed_work_sync(&vi->refill);
+	cancel_delayed_work_sync(&vi->rss_work);
 
 	for (i = 0; i < vi->max_queue_pairs; i++)
 		virtnet_disable_queue_pair(vi, i);
@@ -2510,6 +2577,77 @@ static void virtnet_init_default_rss(struct virtnet_info *vi)
 	netdev_rss_key_fill(vi->ctrl->rss.key, vi->rss_key_size);
 }
 
+/*
+ * The device hashes flows to queues through the indirection table, but
+ * does not tell which entries carry the traffic.  So when one queue
+ * receives more than twice as many packets as the quietest one, hand
+ * one of its entries to that queue and look again an interval later;
+ * repeated passes converge on a table that spreads the actual load.
+ */
+static void virtnet_rss_rebalance_work(struct work_struct *work)
+{
+	struct virtnet_info *vi =
+		container_of(work, struct virtnet_info, rss_work.work);
+	u16 *table = vi->ctrl->rss.indirection_table;
+	u64 delta, total = 0, max_delta = 0, min_delta = U64_MAX;
+	int i, pos = 0, max_q = 0, min_q = 0, entries = 0;
+
+	if (!rtnl_trylock())
+		goto resched;
+
+	if (!rss_rebalance || vi->rss_user_table || vi->curr_queue_pairs < 2)
+		goto unlock;
+
+	for (i = 0; i < vi->curr_queue_pairs; i++) {
+		struct receive_queue *rq = &vi->rq[i];
+		unsigned int start;
+		u64 packets;
+
+		do {
+			start = u64_stats_fetch_begin_irq(&rq->stats.syncp);
+			packets = rq->stats.packets;
+		} while (u64_stats_fetch_retry_irq(&rq->stats.syncp, start));
+
+		delta = packets - rq->rss_last_packets;
+		rq->rss_last_packets = packets;
+		total += delta;
+		if (delta > max_delta) {
+			max_delta = delta;
+			max_q = i;
+		}
+		if (delta < min_delta) {
+			min_delta = delta;
+			min_q = i;
+		}
+	}
+
+	if (total < VIRTNET_RSS_REBALANCE_MIN_PKTS ||
+	    max_delta <= 2 * min_delta)
+		goto unlock;
+
+	/* Never take the last entry away from a queue. */
+	for (i = 0; i < vi->rss_indir_table_size; i++)
+		entries += table[i] == max_q;
+	if (entries < 2)
+		goto unlock;
+
+	for (i = 0; i < vi->rss_indir_table_size; i++) {
+		pos = (vi->rss_rebalance_pos + i) % vi->rss_indir_table_size;
+		if (table[pos] == max_q)
+			break;
+	}
+	vi->rss_rebalance_pos = pos + 1;
+
+	table[pos] = min_q;
+	if (!virtnet_commit_rss_command(vi))
+		table[pos] = max_q;
+
+unlock:
+	rtnl_unlock();
+resched:
+	schedule_delayed_work(&vi->rss_work, VIRTNET_RSS_REBALANCE_INTERVAL);
+}
+
 static void virtnet_get_hashflow(const struct virtnet_info *vi, struct ethtool_rxnfc *info)
 {
 	info->data = 0;
@@ -2960,6 +3098,7 @@ static int virtnet_set_rxfh(struct net_device *dev, const u32 *indir, const u8 *
 
 		for (i = 0; i < vi->rss_indir_table_size; ++i)
 			vi->ctrl->rss.indirection_table[i] = indir[i];
+		vi->rss_user_table = true;
 		update = true;
 	}
 
@@ -3590,6 +3729,7 @@ static int virtnet_alloc_queues(struct virtnet_info *vi)
 		goto err_rq;
 
 	INIT_DELAYED_WORK(&vi->refill, refill_work);
+	INIT_DELAYED_WORK(&vi->rss_work, virtnet_rss_rebalance_work);
 	for (i = 0; i < vi->max_queue_pairs; i++) {
 		vi->rq[i].pages = NULL;
 		netif_napi_add_weight(vi->dev, &vi->rq[i].napi, virtnet_poll,
@@ -90,7 +90,7 @@ static struct request *nvme_alloc_user_request(struct request_queue *q,
 static int nvme_map_user_request(struct request *req, u64 ubuffer,
 		unsigned bufflen, void __user *meta_buffer, unsigned meta_len,
 		u32 meta_seed, void **metap, struct io_uring_cmd *ioucmd,
-		bool vec)
+		bool vec, unsigned int iou_issue_flags)
 {
 	struct request_queue *q = req->q;
 	struct nvme_ns *ns = q->queuedata;
@@ -102,11 +102,14 @@ static int nvme_map_user_request(struct request *req, u64 ubuffer,
 	if (ioucmd && (ioucmd->flags & IORING_URING_CMD_FIXED)) {
 		struct iov_iter iter;
 
-		/* fixedbufs is only for non-vectored io */
-		if (WARN_ON_ONCE(vec))
-			return -EINVAL;
-		ret = io_uring_cmd_import_fixed(ubuffer, bufflen,
-				rq_data_dir(req), &iter, ioucmd);
+		/* for vectored io, each iovec must lie in the fixed buffer */
+		if (vec)
+			ret = io_uring_cmd_import_fixed_vec(nvme_to_user_ptr(ubuffer),
+					bufflen, rq_data_dir(req), &iter, ioucmd,
+					iou_issue_flags);
+		else
+			ret = io_uring_cmd_import_fixed(ubuffer, bufflen,
+					rq_data_dir(req), &iter, ioucmd);
 		if (ret < 0)
 			goto out;
 		ret = blk_rq_map_user_iov(q, req, NULL, &iter, GFP_KERNEL);
@@ -162,7 +165,7 @@ static int nvme_submit_user_cmd(struct request_queue *q,
 	req->timeout = timeout;
 	if (ubuffer && bufflen) {
 		ret = nvme_map_user_request(req, ubuffer, bufflen, meta_buffer,
-				meta_len, meta_seed, &meta, NULL, vec);
+				meta_len, meta_seed, &meta, NULL, vec, 0);
 		if (ret)
 			return ret;
 	}
@@ -539,7 +542,7 @@ retry:
 	if (d.addr && d.data_len) {
 		ret = nvme_map_user_request(req, d.addr,
 			d.data_len, nvme_to_user_ptr(d.metadata),
-			d.metadata_len, 0, &meta, ioucmd, vec);
+			d.metadata_len, 0, &meta, ioucmd, vec, issue_flags);
 		if (ret)
 			return ret;
 	}
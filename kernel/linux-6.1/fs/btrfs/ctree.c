@@ -1936,6 +1936,117 @@ static int search_leaf(struct btrfs_trans_handle *trans,
 	return ret;
 }
 
+/*
+ * Walk through the root node of a read-only search without locking it.
+ *
+ * Every search of a tree starts by locking its root, so plain lookups from
+ * many CPUs all bounce the root's lock around even though they never
+ * modify it.  Instead, read the child pointer for @key out of the root
+ * with btrfs_tree_read_seq_begin(), lock the child, and check that the
+ * root was not write locked in the meantime: re-pointing or COWing the
+ * child, or replacing the root, all need the root's write lock, so the
+ * child is then the right one and the search can go on from it as if the
+ * root had been unlocked by unlock_up().
+ *
+ * Returns the child, read locked and set up in @p, or NULL if the search
+ * has to start from a locked root, e.g. because a writer got in the way,
+ * the child is not cached or the root is the only level to search.
+ */
+static struct extent_buffer *search_root_optimistic(struct btrfs_root *root,
+						     const struct btrfs_key *key,
+						     struct btrfs_path *p,
+						     int *prev_cmp)
+{
+	struct btrfs_fs_info *fs_info = root->fs_info;
+	struct extent_buffer *b;
+	struct extent_buffer *child = NULL;
+	struct btrfs_key first_key;
+	struct btrfs_key node_key;
+	unsigned int seq;
+	u32 nritems;
+	u64 blocknr;
+	u64 gen;
+	int level;
+	int low = 0;
+	int high;
+	int slot = 0;
+	int cmp = 1;
+
+	b = btrfs_root_node(root);
+	seq = btrfs_tree_read_seq_begin(b);
+	if (seq & 1)
+		goto out;
+
+	level = btrfs_header_level(b);
+	nritems = btrfs_header_nritems(b);
+	if (level <= p->lowest_level || level >= BTRFS_MAX_LEVEL || !nritems ||
+	    nritems > BTRFS_NODEPTRS_PER_BLOCK(fs_info) ||
+	    !extent_buffer_uptodate(b))
+		goto out;
+
+	/* Same result as search_for_key_slot(), but bounded by nritems above */
+	high = nritems;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+
+		btrfs_node_key_to_cpu(b, &node_key, mid);
+		cmp = btrfs_comp_cpu_keys(&node_key, key);
+		if (cmp < 0) {
+			low = mid + 1;
+		} else if (cmp > 0) {
+			high = mid;
+		} else {
+			low = mid;
+			break;
+		}
+	}
+	slot = low;
+	if (cmp) {
+		cmp = 1;
+		if (slot > 0)
+			slot--;
+	}
+
+	blocknr = btrfs_node_blockptr(b, slot);
+	gen = btrfs_node_ptr_generation(b, slot);
+	btrfs_node_key_to_cpu(b, &first_key, slot);
+	if (btrfs_tree_read_seq_retry(b, seq))
+		goto out;
+
+	child = find_extent_buffer(fs_info, blocknr);
+	if (!child)
+		goto out;
+	if (btrfs_buffer_uptodate(child, gen, 1) <= 0)
+		goto out_free;
+
+	btrfs_maybe_reset_lockdep_class(root, child);
+	if (p->nowait) {
+		if (!btrfs_try_tree_read_lock(child))
+			goto out_free;
+	} else {
+		btrfs_tree_read_lock(child);
+	}
+	if (btrfs_tree_read_seq_retry(b, seq) ||
+	    btrfs_verify_level_key(child, level - 1, &first_key, gen)) {
+		btrfs_tree_read_unlock(child);
+		goto out_free;
+	}
+
+	p->nodes[level] = b;
+	p->slots[level] = slot;
+	p->nodes[level - 1] = child;
+	p->locks[level - 1] = BTRFS_READ_LOCK;
+	*prev_cmp = cmp;
+	return child;
+
+out_free:
+	free_extent_buffer(child);
+	child = NULL;
+out:
+	free_extent_buffer(b);
+	return child;
+}
+
 /*
  * btrfs_search_slot - look for a key in a tree and perform necessary
  * modifications to preserve tree invariants.
@@ -2032,7 +2143,11 @@ int btrfs_search_slot(struct btrfs_trans_handle *trans, struct btrfs_root *root,
 
 again:
 	prev_cmp = -1;
-	b = btrfs_search_slot_get_root(root, p, write_lock_level);
+	b = NULL;
+	if (!cow && !p->skip_locking && !p->keep_locks)
+		b = search_root_optimistic(root, key, p, &prev_cmp);
+	if (!b)
+		b = btrfs_search_slot_get_root(root, p, write_lock_level);
 	if (IS_ERR(b)) {
 		ret = PTR_ERR(b);
 		goto done;
@@ -4276,6 +4276,7 @@ __alloc_extent_buffer(struct btrfs_fs_info *fs_info, u64 start,
 	eb->fs_info = fs_info;
 	eb->bflags = 0;
 	init_rwsem(&eb->lock);
+	seqcount_init(&eb->lock_seq);
 
 	btrfs_leak_debug_add_eb(eb);
 	INIT_LIST_HEAD(&eb->release_list);
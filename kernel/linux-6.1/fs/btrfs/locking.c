@@ -163,6 +163,7 @@ int btrfs_try_tree_read_lock(struct extent_buffer *eb)
 int btrfs_try_tree_write_lock(struct extent_buffer *eb)
 {
 	if (down_write_trylock(&eb->lock)) {
+		raw_write_seqcount_begin(&eb->lock_seq);
 		eb->lock_owner = current->pid;
 		trace_btrfs_try_tree_write_lock(eb);
 		return 1;
@@ -195,6 +196,7 @@ void __btrfs_tree_lock(struct extent_buffer *eb, enum btrfs_lock_nesting nest)
 		start_ns = ktime_get_ns();
 
 	down_write_nested(&eb->lock, nest);
+	raw_write_seqcount_begin(&eb->lock_seq);
 	eb->lock_owner = current->pid;
 	trace_btrfs_tree_lock(eb, start_ns);
 }
@@ -211,6 +213,7 @@ void btrfs_tree_unlock(struct extent_buffer *eb)
 {
 	trace_btrfs_tree_unlock(eb);
 	eb->lock_owner = 0;
+	raw_write_seqcount_end(&eb->lock_seq);
 	up_write(&eb->lock);
 }
 
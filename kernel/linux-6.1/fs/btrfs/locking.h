@@ -96,6 +96,28 @@ struct extent_buffer *btrfs_lock_root_node(struct btrfs_root *root);
 struct extent_buffer *btrfs_read_lock_root_node(struct btrfs_root *root);
 struct extent_buffer *btrfs_try_read_lock_root_node(struct btrfs_root *root);
 
+/*
+ * Optimistic reads of a tree block without taking its lock.
+ *
+ * The content of a tree block in use only changes under its write lock,
+ * and lock_seq is odd for as long as that is held.  A reader samples the
+ * sequence, reads what it needs, and trusts the result only if
+ * btrfs_tree_read_seq_retry() then says no writer came in between.  The
+ * reader must cope with reading garbage before that check, e.g. bound any
+ * slot it derives by the size of the block.  An odd sequence, i.e. a
+ * writer in progress, is returned as is so that the retry always fails.
+ */
+static inline unsigned int btrfs_tree_read_seq_begin(const struct extent_buffer *eb)
+{
+	return raw_read_seqcount(&eb->lock_seq);
+}
+
+static inline bool btrfs_tree_read_seq_retry(const struct extent_buffer *eb,
+					     unsigned int seq)
+{
+	return (seq & 1) || read_seqcount_retry(&eb->lock_seq, seq);
+}
+
 #ifdef CONFIG_BTRFS_DEBUG
 static inline void btrfs_assert_tree_write_locked(struct extent_buffer *eb)
 {
@@ -1007,6 +1007,10 @@ grow_buffers(struct block_device *bdev, sector_t block, int size, gfp_t gfp)
 		return -EIO;
 	}
 
+	/* Buffer heads need the page cache of a claimed device */
+	if (WARN_ON_ONCE(!bdev_buffer_heads(bdev)))
+		return -EIO;
+
 	/* Create a page with the proper size buffers.. */
 	return grow_dev_page(bdev, block, index, size, sizebits, gfp);
 }
@@ -37,6 +37,7 @@
 #include <linux/seq_file.h>
 #include <linux/compat.h>
 #include <linux/rculist.h>
+#include <linux/vmalloc.h>
 #include <net/busy_poll.h>
 
 /*
@@ -98,6 +99,9 @@
 /* Maximum number of nesting allowed inside epoll sets */
 #define EP_MAX_NESTS 4
 
+/* Largest ready event ring, see EPIOCSRING */
+#define EP_RING_MAX_ENTRIES (1U << 16)
+
 #define EP_MAX_EVENTS (INT_MAX / sizeof(struct epoll_event))
 
 #define EP_UNACTIVE_PTR ((void *) -1L)
@@ -217,9 +221,26 @@ struct eventpoll {
 	u64 gen;
 	struct hlist_head refs;
 
+	/*
+	 * Ready event ring shared with userspace, see EPIOCSRING. ring_mask
+	 * and ring_tail are the kernel's copies of what userspace could
+	 * scribble over in the ring; producers in ep_poll_callback()
+	 * serialize on ring_lock.
+	 */
+	struct epoll_ring *ring;
+	unsigned int ring_size;
+	u32 ring_mask;
+	u32 ring_tail;
+	spinlock_t ring_lock;
+
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	/* used to track busy poll napi_id */
 	unsigned int napi_id;
+	/* busy poll timeout, 0 for the net.core.busy_poll sysctl */
+	u32 busy_poll_usecs;
+	/* busy poll packet budget, 0 for BUSY_POLL_BUDGET */
+	u16 busy_poll_budget;
+	bool prefer_busy_poll;
 #endif
 
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
@@ -376,46 +397,99 @@ static inline struct epitem *ep_item_from_wait(wait_queue_entry_t *p)
  * Return: a value different than %zero if ready events are available,
  *          or %zero otherwise.
  */
+static inline bool ep_ring_pending(struct eventpoll *ep)
+{
+	struct epoll_ring *ring = READ_ONCE(ep->ring);
+
+	return ring && READ_ONCE(ep->ring_tail) != READ_ONCE(ring->head);
+}
+
 static inline int ep_events_available(struct eventpoll *ep)
 {
 	return !list_empty_careful(&ep->rdllist) ||
-		READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR;
+		READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR ||
+		ep_ring_pending(ep);
 }
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
+static bool ep_busy_loop_on(struct eventpoll *ep)
+{
+	return READ_ONCE(ep->busy_poll_usecs) || net_busy_loop_on();
+}
+
+static bool ep_busy_loop_timeout(struct eventpoll *ep, unsigned long start_time)
+{
+	unsigned long bp_usec = READ_ONCE(ep->busy_poll_usecs);
+
+	if (bp_usec) {
+		unsigned long end_time = start_time + bp_usec;
+		unsigned long now = busy_loop_current_time();
+
+		return time_after(now, end_time);
+	}
+	return busy_loop_timeout(start_time);
+}
+
 static bool ep_busy_loop_end(void *p, unsigned long start_time)
 {
 	struct eventpoll *ep = p;
 
-	return ep_events_available(ep) || busy_loop_timeout(start_time);
+	return ep_events_available(ep) || ep_busy_loop_timeout(ep, start_time);
 }
 
 /*
- * Busy poll if globally on and supporting sockets found && no events,
- * busy loop will return if need_resched or ep_events_available.
+ * Busy poll if on for this instance or globally and supporting sockets
+ * found && no events, busy loop will return if need_resched or
+ * ep_events_available.
  *
  * we must do our busy polling with irqs enabled
  */
 static bool ep_busy_loop(struct eventpoll *ep, int nonblock)
 {
 	unsigned int napi_id = READ_ONCE(ep->napi_id);
+	u16 budget = READ_ONCE(ep->busy_poll_budget) ?: BUSY_POLL_BUDGET;
+	bool prefer_busy_poll = READ_ONCE(ep->prefer_busy_poll);
 
-	if ((napi_id >= MIN_NAPI_ID) && net_busy_loop_on()) {
-		napi_busy_loop(napi_id, nonblock ? NULL : ep_busy_loop_end, ep, false,
-			       BUSY_POLL_BUDGET);
+	if ((napi_id >= MIN_NAPI_ID) && ep_busy_loop_on(ep)) {
+		napi_busy_loop(napi_id, nonblock ? NULL : ep_busy_loop_end, ep,
+			       prefer_busy_poll, budget);
 		if (ep_events_available(ep))
 			return true;
 		/*
-		 * Busy poll timed out.  Drop NAPI ID for now, we can add
-		 * it back in when we have moved a socket with a valid NAPI
-		 * ID onto the ready list.
+		 * Busy poll timed out.  Give the device its interrupts back
+		 * if they were suspended, and drop NAPI ID for now, we can
+		 * add it back in when we have moved a socket with a valid
+		 * NAPI ID onto the ready list.
 		 */
+		if (prefer_busy_poll)
+			napi_resume_irqs(napi_id);
 		ep->napi_id = 0;
 		return false;
 	}
 	return false;
 }
 
+/*
+ * Events were found, so the application is busy with them and will come
+ * back to poll again: keep the device interrupts off in the meantime, up
+ * to the irq_suspend_timeout of the device.
+ */
+static void ep_suspend_napi_irqs(struct eventpoll *ep)
+{
+	unsigned int napi_id = READ_ONCE(ep->napi_id);
+
+	if (napi_id >= MIN_NAPI_ID && READ_ONCE(ep->prefer_busy_poll))
+		napi_suspend_irqs(napi_id);
+}
+
+static void ep_resume_napi_irqs(struct eventpoll *ep)
+{
+	unsigned int napi_id = READ_ONCE(ep->napi_id);
+
+	if (napi_id >= MIN_NAPI_ID && READ_ONCE(ep->prefer_busy_poll))
+		napi_resume_irqs(napi_id);
+}
+
 /*
  * Set epoll busy poll NAPI ID from sk.
  */
@@ -426,7 +500,8 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 	struct socket *sock;
 	struct sock *sk;
 
-	if (!net_busy_loop_on())
+	ep = epi->ep;
+	if (!ep_busy_loop_on(ep))
 		return;
 
 	sock = sock_from_file(epi->ffd.file);
@@ -438,7 +513,6 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 		return;
 
 	napi_id = READ_ONCE(sk->sk_napi_id);
-	ep = epi->ep;
 
 	/* Non-NAPI IDs can be rejected
 	 *	or
@@ -462,6 +536,14 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 {
 }
 
+static inline void ep_suspend_napi_irqs(struct eventpoll *ep)
+{
+}
+
+static inline void ep_resume_napi_irqs(struct eventpoll *ep)
+{
+}
+
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 /*
@@ -742,6 +824,8 @@ static void ep_free(struct eventpoll *ep)
 	struct rb_node *rbp;
 	struct epitem *epi;
 
+	ep_resume_napi_irqs(ep);
+
 	/* We need to release all tasks waiting for these file */
 	if (waitqueue_active(&ep->poll_wait))
 		ep_poll_safewake(ep, NULL, 0);
@@ -786,6 +870,7 @@ static void ep_free(struct eventpoll *ep)
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
+	vfree(ep->ring);
 	kfree(ep);
 }
 
@@ -814,6 +899,9 @@ static __poll_t __ep_eventpoll_poll(struct file *file, poll_table *wait, int dep
 	/* Insert inside our poll wait queue */
 	poll_wait(file, &ep->poll_wait, wait);
 
+	if (ep_ring_pending(ep))
+		return EPOLLIN | EPOLLRDNORM;
+
 	/*
 	 * Proceed to find out if wanted events are really available inside
 	 * the ready list.
@@ -923,6 +1011,128 @@ static void ep_show_fdinfo(struct seq_file *m, struct file *f)
 }
 #endif
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	struct eventpoll *ep = file->private_data;
+	void __user *uarg = (void __user *)arg;
+	struct epoll_params epoll_params;
+
+	switch (cmd) {
+	case EPIOCSPARAMS:
+		if (copy_from_user(&epoll_params, uarg, sizeof(epoll_params)))
+			return -EFAULT;
+
+		/* pad byte must be zero */
+		if (epoll_params.__pad)
+			return -EINVAL;
+
+		if (epoll_params.busy_poll_usecs > S32_MAX)
+			return -EINVAL;
+
+		if (epoll_params.prefer_busy_poll > 1)
+			return -EINVAL;
+
+		if (epoll_params.busy_poll_budget > NAPI_POLL_WEIGHT &&
+		    !capable(CAP_NET_ADMIN))
+			return -EPERM;
+
+		WRITE_ONCE(ep->busy_poll_usecs, epoll_params.busy_poll_usecs);
+		WRITE_ONCE(ep->busy_poll_budget, epoll_params.busy_poll_budget);
+		WRITE_ONCE(ep->prefer_busy_poll, epoll_params.prefer_busy_poll);
+		return 0;
+	case EPIOCGPARAMS:
+		memset(&epoll_params, 0, sizeof(epoll_params));
+		epoll_params.busy_poll_usecs = READ_ONCE(ep->busy_poll_usecs);
+		epoll_params.busy_poll_budget = READ_ONCE(ep->busy_poll_budget);
+		epoll_params.prefer_busy_poll = READ_ONCE(ep->prefer_busy_poll);
+		if (copy_to_user(uarg, &epoll_params, sizeof(epoll_params)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -ENOIOCTLCMD;
+	}
+}
+#else
+static inline long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
+					 unsigned long arg)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+static long ep_ring_setup(struct eventpoll *ep, void __user *uarg)
+{
+	struct epoll_ring_params params;
+	struct epoll_ring *ring;
+	size_t size;
+	int error;
+
+	if (copy_from_user(&params, uarg, sizeof(params)))
+		return -EFAULT;
+
+	if (params.entries < 2 || params.entries > EP_RING_MAX_ENTRIES ||
+	    !is_power_of_2(params.entries))
+		return -EINVAL;
+
+	size = PAGE_ALIGN(struct_size(ring, events, params.entries));
+	params.size = size;
+	if (copy_to_user(uarg, &params, sizeof(params)))
+		return -EFAULT;
+
+	mutex_lock(&ep->mtx);
+	error = -EBUSY;
+	if (ep->ring)
+		goto out_unlock;
+
+	error = -ENOMEM;
+	ring = vmalloc_user(size);
+	if (!ring)
+		goto out_unlock;
+	ring->mask = params.entries - 1;
+
+	write_lock_irq(&ep->lock);
+	ep->ring_size = size;
+	ep->ring_mask = params.entries - 1;
+	ep->ring_tail = 0;
+	WRITE_ONCE(ep->ring, ring);
+	write_unlock_irq(&ep->lock);
+	error = 0;
+
+out_unlock:
+	mutex_unlock(&ep->mtx);
+	return error;
+}
+
+static long ep_eventpoll_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	switch (cmd) {
+	case EPIOCSPARAMS:
+	case EPIOCGPARAMS:
+		return ep_eventpoll_bp_ioctl(file, cmd, arg);
+	case EPIOCSRING:
+		return ep_ring_setup(file->private_data, (void __user *)arg);
+	default:
+		return -EINVAL;
+	}
+}
+
+static int ep_eventpoll_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct eventpoll *ep = file->private_data;
+	int error = -EINVAL;
+
+	mutex_lock(&ep->mtx);
+	if (ep->ring && !vma->vm_pgoff &&
+	    vma->vm_end - vma->vm_start == ep->ring_size)
+		error = remap_vmalloc_range(vma, ep->ring, 0);
+	mutex_unlock(&ep->mtx);
+
+	return error;
+}
+
 /* File callbacks that implement the eventpoll file behaviour */
 static const struct file_operations eventpoll_fops = {
 #ifdef CONFIG_PROC_FS
@@ -931,6 +1141,9 @@ static const struct file_operations eventpoll_fops = {
 	.release	= ep_eventpoll_release,
 	.poll		= ep_eventpoll_poll,
 	.llseek		= noop_llseek,
+	.unlocked_ioctl	= ep_eventpoll_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
+	.mmap		= ep_eventpoll_mmap,
 };
 
 /*
@@ -985,6 +1198,7 @@ static int ep_alloc(struct eventpoll **pep)
 
 	mutex_init(&ep->mtx);
 	rwlock_init(&ep->lock);
+	spin_lock_init(&ep->ring_lock);
 	init_waitqueue_head(&ep->wq);
 	init_waitqueue_head(&ep->poll_wait);
 	INIT_LIST_HEAD(&ep->rdllist);
@@ -1169,6 +1383,43 @@ static inline bool chain_epi_lockless(struct epitem *epi)
  * queues are used should be detected accordingly.  This is detected using
  * cmpxchg() operation.
  */
+/*
+ * Deliver an event of @epi through the ready event ring, if it is for the
+ * ring at all: see "struct epoll_ring" for which are. Called with ep->lock
+ * read locked and interrupts disabled.
+ */
+static bool ep_ring_push(struct eventpoll *ep, struct epitem *epi,
+			 __poll_t pollflags)
+{
+	struct epoll_ring *ring = ep->ring;
+	struct epoll_ring_event *ev;
+	bool pushed = false;
+	u32 tail;
+
+	if (!ring || !pollflags || (pollflags & POLLFREE) ||
+	    (epi->event.events & (EPOLLET | EPOLLONESHOT | EPOLLWAKEUP)) != EPOLLET ||
+	    ep_is_linked(epi))
+		return false;
+
+	spin_lock(&ep->ring_lock);
+	tail = ep->ring_tail;
+	/* Also catches a head userspace moved past the tail */
+	if (tail - READ_ONCE(ring->head) > ep->ring_mask) {
+		WRITE_ONCE(ring->overflow, 1);
+		goto out;
+	}
+
+	ev = &ring->events[tail & ep->ring_mask];
+	WRITE_ONCE(ev->data, epi->event.data);
+	WRITE_ONCE(ev->events, pollflags & epi->event.events & ~EP_PRIVATE_BITS);
+	WRITE_ONCE(ep->ring_tail, tail + 1);
+	smp_store_release(&ring->tail, tail + 1);
+	pushed = true;
+out:
+	spin_unlock(&ep->ring_lock);
+	return pushed;
+}
+
 static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, void *key)
 {
 	int pwake = 0;
@@ -1206,7 +1457,9 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * semantics). All the events that happen during that period of time are
 	 * chained in ep->ovflist and requeued later on.
 	 */
-	if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
+	if (ep_ring_push(ep, epi, pollflags)) {
+		/* Nothing to queue, userspace picks it up from the ring */
+	} else if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
 		if (chain_epi_lockless(epi))
 			ep_pm_stay_awake_rcu(epi);
 	} else if (!ep_is_linked(epi)) {
@@ -1861,8 +2114,15 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			 * trying again in search of more luck.
 			 */
 			res = ep_send_events(ep, events, maxevents);
-			if (res)
+			if (res) {
+				if (res > 0)
+					ep_suspend_napi_irqs(ep);
 				return res;
+			}
+
+			/* The events are in the ring, none for the array */
+			if (ep_ring_pending(ep))
+				return 0;
 		}
 
 		if (timed_out)
@@ -1617,9 +1617,8 @@ struct ext4_sb_info {
 	unsigned int s_mb_group_prealloc;
 	unsigned int s_mb_max_inode_prealloc;
 	unsigned int s_max_dir_size_kb;
-	/* where last allocation was done - for stream allocation */
-	unsigned long s_mb_last_group;
-	unsigned long s_mb_last_start;
+	/* where the last stream allocation on each CPU was done */
+	ext4_group_t __percpu *s_mb_last_groups;
 	unsigned int s_mb_prefetch;
 	unsigned int s_mb_prefetch_limit;
 
@@ -3489,6 +3488,20 @@ static inline void ext4_lock_group(struct super_block *sb, ext4_group_t group)
 	}
 }
 
+/*
+ * Take the group lock only if nobody holds it; the contention counter is
+ * left alone, as a failed attempt does not wait.
+ */
+static inline bool ext4_try_lock_group(struct super_block *sb, ext4_group_t group)
+{
+	return spin_trylock(ext4_group_lock_ptr(sb, group));
+}
+
+static inline bool ext4_group_is_locked(struct super_block *sb, ext4_group_t group)
+{
+	return spin_is_locked(ext4_group_lock_ptr(sb, group));
+}
+
 static inline void ext4_unlock_group(struct super_block *sb,
 					ext4_group_t group)
 {
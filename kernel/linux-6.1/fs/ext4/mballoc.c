@@ -169,6 +169,17 @@
  * If "mb_optimize_scan" mount option is not set, mballoc traverses groups in
  * linear order which requires O(N) search time for each CR 0 and CR 1 phase.
  *
+ * At CR 0 and 1 parallel allocators would otherwise all pick the first
+ * suitable group of a list, or walk into the same group linearly, and then
+ * queue on its group lock. Instead, a group whose lock is held is passed
+ * over: the list walks prefer a suitable group nobody is working on, falling
+ * back to a busy one only if there is no other, and the linear scan skips
+ * groups it cannot lock right away. CR 2 and 3 still wait for every group.
+ *
+ * Stream allocations start from where the last one on the same CPU ended,
+ * so that parallel streaming writers do not share (and serialize on) one
+ * global goal; the per-CPU goals start out spread over the filesystem.
+ *
  * The regular allocator (using the buddy cache) supports a few tunables.
  *
  * /sys/fs/ext4/<partition>/mb_min_to_scan
@@ -863,7 +874,7 @@ static void ext4_mb_choose_next_group_cr0(struct ext4_allocation_context *ac,
 			int *new_cr, ext4_group_t *group, ext4_group_t ngroups)
 {
 	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
-	struct ext4_group_info *iter, *grp;
+	struct ext4_group_info *iter, *grp, *busy;
 	int i;
 
 	if (ac->ac_status == AC_STATUS_FOUND)
@@ -873,6 +884,7 @@ static void ext4_mb_choose_next_group_cr0(struct ext4_allocation_context *ac,
 		atomic_inc(&sbi->s_bal_cr0_bad_suggestions);
 
 	grp = NULL;
+	busy = NULL;
 	for (i = ac->ac_2order; i < MB_NUM_ORDERS(ac->ac_sb); i++) {
 		if (list_empty(&sbi->s_mb_largest_free_orders[i]))
 			continue;
@@ -881,14 +893,17 @@ static void ext4_mb_choose_next_group_cr0(struct ext4_allocation_context *ac,
 			read_unlock(&sbi->s_mb_largest_free_orders_locks[i]);
 			continue;
 		}
-		grp = NULL;
 		list_for_each_entry(iter, &sbi->s_mb_largest_free_orders[i],
 				    bb_largest_free_order_node) {
 			if (sbi->s_mb_stats)
 				atomic64_inc(&sbi->s_bal_cX_groups_considered[0]);
 			if (likely(ext4_mb_good_group(ac, iter->bb_group, 0))) {
-				grp = iter;
-				break;
+				if (!ext4_group_is_locked(ac->ac_sb, iter->bb_group)) {
+					grp = iter;
+					break;
+				}
+				if (!busy)
+					busy = iter;
 			}
 		}
 		read_unlock(&sbi->s_mb_largest_free_orders_locks[i]);
@@ -896,6 +911,11 @@ static void ext4_mb_choose_next_group_cr0(struct ext4_allocation_context *ac,
 			break;
 	}
 
+	if (!grp && busy) {
+		grp = busy;
+		ac->ac_wait_busy = 1;
+	}
+
 	if (!grp) {
 		/* Increment cr and search again */
 		*new_cr = 1;
@@ -913,7 +933,7 @@ static void ext4_mb_choose_next_group_cr1(struct ext4_allocation_context *ac,
 		int *new_cr, ext4_group_t *group, ext4_group_t ngroups)
 {
 	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
-	struct ext4_group_info *grp = NULL, *iter;
+	struct ext4_group_info *grp = NULL, *busy = NULL, *iter;
 	int i;
 
 	if (unlikely(ac->ac_flags & EXT4_MB_CR1_OPTIMIZED)) {
@@ -935,8 +955,12 @@ static void ext4_mb_choose_next_group_cr1(struct ext4_allocation_context *ac,
 			if (sbi->s_mb_stats)
 				atomic64_inc(&sbi->s_bal_cX_groups_considered[1]);
 			if (likely(ext4_mb_good_group(ac, iter->bb_group, 1))) {
-				grp = iter;
-				break;
+				if (!ext4_group_is_locked(ac->ac_sb, iter->bb_group)) {
+					grp = iter;
+					break;
+				}
+				if (!busy)
+					busy = iter;
 			}
 		}
 		read_unlock(&sbi->s_mb_avg_fragment_size_locks[i]);
@@ -944,6 +968,11 @@ static void ext4_mb_choose_next_group_cr1(struct ext4_allocation_context *ac,
 			break;
 	}
 
+	if (!grp && busy) {
+		grp = busy;
+		ac->ac_wait_busy = 1;
+	}
+
 	if (grp) {
 		*group = grp->bb_group;
 		ac->ac_flags |= EXT4_MB_CR1_OPTIMIZED;
@@ -1005,6 +1034,7 @@ static void ext4_mb_choose_next_group(struct ext4_allocation_context *ac,
 		int *new_cr, ext4_group_t *group, ext4_group_t ngroups)
 {
 	*new_cr = ac->ac_criteria;
+	ac->ac_wait_busy = 0;
 
 	if (!should_optimize_scan(ac) || ac->ac_groups_linear_remaining) {
 		*group = next_linear_group(ac, *group, ngroups);
@@ -2036,12 +2066,8 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	ac->ac_buddy_page = e4b->bd_buddy_page;
 	get_page(ac->ac_buddy_page);
 	/* store last allocated for subsequent stream allocation */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		this_cpu_write(*sbi->s_mb_last_groups, ac->ac_f_ex.fe_group);
 	/*
 	 * As we've just preallocated more space than
 	 * user requested originally, we store allocated
@@ -2685,13 +2711,10 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 							   MB_NUM_ORDERS(sb));
 	}
 
-	/* if stream allocation is enabled, use global goal */
+	/* if stream allocation is enabled, use this CPU's goal */
 	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
+		ac->ac_g_ex.fe_group = this_cpu_read(*sbi->s_mb_last_groups);
+		ac->ac_g_ex.fe_start = 0;
 	}
 
 	/* Let's just scan groups to find more-less suitable blocks */
@@ -2709,6 +2732,7 @@ repeat:
 		 */
 		group = ac->ac_g_ex.fe_group;
 		ac->ac_groups_linear_remaining = sbi->s_mb_max_linear_groups;
+		ac->ac_wait_busy = 0;
 		prefetch_grp = group;
 
 		for (i = 0, new_cr = cr; i < ngroups; i++,
@@ -2756,7 +2780,15 @@ repeat:
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
+			/* Busy groups are skipped, see the top of the file */
+			if (cr < 2 && !ac->ac_wait_busy) {
+				if (!ext4_try_lock_group(sb, group)) {
+					ext4_mb_unload_buddy(&e4b);
+					continue;
+				}
+			} else {
+				ext4_lock_group(sb, group);
+			}
 
 			/*
 			 * We need to check again after locking the
@@ -3514,6 +3546,17 @@ int ext4_mb_init(struct super_block *sb)
 		spin_lock_init(&lg->lg_prealloc_lock);
 	}
 
+	sbi->s_mb_last_groups = alloc_percpu(ext4_group_t);
+	if (sbi->s_mb_last_groups == NULL) {
+		ret = -ENOMEM;
+		goto out_free_locality_groups;
+	}
+	j = 0;
+	for_each_possible_cpu(i)
+		*per_cpu_ptr(sbi->s_mb_last_groups, i) =
+			div_u64((u64)ext4_get_groups_count(sb) * j++,
+				num_possible_cpus());
+
 	if (bdev_nonrot(sb->s_bdev))
 		sbi->s_mb_max_linear_groups = 0;
 	else
@@ -3521,10 +3564,13 @@ int ext4_mb_init(struct super_block *sb)
 	/* init file for buddy data */
 	ret = ext4_mb_init_backend(sb);
 	if (ret != 0)
-		goto out_free_locality_groups;
+		goto out_free_last_groups;
 
 	return 0;
 
+out_free_last_groups:
+	free_percpu(sbi->s_mb_last_groups);
+	sbi->s_mb_last_groups = NULL;
 out_free_locality_groups:
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
@@ -3632,6 +3678,7 @@ int ext4_mb_release(struct super_block *sb)
 	}
 
 	free_percpu(sbi->s_locality_groups);
+	free_percpu(sbi->s_mb_last_groups);
 
 	return 0;
 }
@@ -5553,9 +5600,15 @@ static int ext4_mb_release_context(struct ext4_allocation_context *ac)
 	return 0;
 }
 
+/*
+ * Writers that run out of space together all end up here. Each starts at
+ * the stream goal of its CPU rather than at group 0, so that they discard
+ * disjoint batches of groups instead of queueing on the same group locks
+ * and finding the preallocations there already gone.
+ */
 static int ext4_mb_discard_preallocations(struct super_block *sb, int needed)
 {
-	ext4_group_t i, ngroups = ext4_get_groups_count(sb);
+	ext4_group_t i, group, ngroups = ext4_get_groups_count(sb);
 	int ret;
 	int freed = 0, busy = 0;
 	int retry = 0;
@@ -5564,11 +5617,16 @@ static int ext4_mb_discard_preallocations(struct super_block *sb, int needed)
 
 	if (needed == 0)
 		needed = EXT4_CLUSTERS_PER_GROUP(sb) + 1;
+	group = this_cpu_read(*EXT4_SB(sb)->s_mb_last_groups);
+	if (group >= ngroups)
+		group = 0;
  repeat:
 	for (i = 0; i < ngroups && needed > 0; i++) {
-		ret = ext4_mb_discard_group_preallocations(sb, i, &busy);
+		ret = ext4_mb_discard_group_preallocations(sb, group, &busy);
 		freed += ret;
 		needed -= ret;
+		if (++group >= ngroups)
+			group = 0;
 		cond_resched();
 	}
 
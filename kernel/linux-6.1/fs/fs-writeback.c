@@ -156,6 +156,29 @@ static void finish_writeback_work(struct bdi_writeback *wb,
 	}
 }
 
+/*
+ * Work somebody waits for, sync(2), syncfs() or writeback_inodes_sb() on
+ * behalf of an fsync-heavy task, goes ahead of work nobody waits for, so
+ * it is not held up behind bulk writeback queued on the same wb earlier.
+ * Each kind stays in FIFO order.  Bulk work that is already running keeps
+ * going; background and kupdate writeback yield in wb_writeback().
+ */
+static void wb_insert_work(struct bdi_writeback *wb,
+			   struct wb_writeback_work *work)
+{
+	struct wb_writeback_work *pos;
+
+	if (work->done) {
+		list_for_each_entry(pos, &wb->work_list, list) {
+			if (!pos->done) {
+				list_add_tail(&work->list, &pos->list);
+				return;
+			}
+		}
+	}
+	list_add_tail(&work->list, &wb->work_list);
+}
+
 static void wb_queue_work(struct bdi_writeback *wb,
 			  struct wb_writeback_work *work)
 {
@@ -167,7 +190,7 @@ static void wb_queue_work(struct bdi_writeback *wb,
 	spin_lock_irq(&wb->work_lock);
 
 	if (test_bit(WB_registered, &wb->state)) {
-		list_add_tail(&work->list, &wb->work_list);
+		wb_insert_work(wb, work);
 		mod_delayed_work(bdi_wq, &wb->dwork, 0);
 	} else
 		finish_writeback_work(wb, work);
@@ -230,9 +230,49 @@ __releases(fiq->lock)
 		fuse_len_args(req->args->in_numargs,
 			      (struct fuse_arg *) req->args->in_args);
 	list_add_tail(&req->list, &fiq->pending);
+	req->iq = fiq;
 	fiq->ops->wake_pending_and_unlock(fiq);
 }
 
+/*
+ * Lock the input queue for a new request: the per-CPU queue of this CPU if
+ * a device is bound to it, fc->iq otherwise.
+ */
+static struct fuse_iqueue *fuse_lock_iqueue(struct fuse_conn *fc)
+{
+	/* Paired with smp_store_release() in fuse_dev_bind_cpu() */
+	struct fuse_iqueue **cpu_iqs = smp_load_acquire(&fc->cpu_iqs);
+	struct fuse_iqueue *fiq;
+
+	if (cpu_iqs) {
+		fiq = smp_load_acquire(&cpu_iqs[raw_smp_processor_id()]);
+		if (fiq) {
+			spin_lock(&fiq->lock);
+			if (fiq->nr_devs)
+				return fiq;
+			spin_unlock(&fiq->lock);
+		}
+	}
+
+	fiq = &fc->iq;
+	spin_lock(&fiq->lock);
+	return fiq;
+}
+
+/* Lock the queue @req is pending on; it may move off an unbound queue */
+static struct fuse_iqueue *fuse_lock_req_iqueue(struct fuse_req *req)
+{
+	struct fuse_iqueue *fiq;
+
+	for (;;) {
+		fiq = READ_ONCE(req->iq);
+		spin_lock(&fiq->lock);
+		if (likely(fiq == req->iq))
+			return fiq;
+		spin_unlock(&fiq->lock);
+	}
+}
+
 void fuse_queue_forget(struct fuse_conn *fc, struct fuse_forget_link *forget,
 		       u64 nodeid, u64 nlookup)
 {
@@ -254,7 +294,7 @@ void fuse_queue_forget(struct fuse_conn *fc, struct fuse_forget_link *forget,
 
 static void flush_bg_queue(struct fuse_conn *fc)
 {
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq;
 
 	while (fc->active_background < fc->max_background &&
 	       !list_empty(&fc->bg_queue)) {
@@ -263,7 +303,7 @@ static void flush_bg_queue(struct fuse_conn *fc)
 		req = list_first_entry(&fc->bg_queue, struct fuse_req, list);
 		list_del(&req->list);
 		fc->active_background++;
-		spin_lock(&fiq->lock);
+		fiq = fuse_lock_iqueue(fc);
 		req->in.h.unique = fuse_get_unique(fiq);
 		queue_request_and_unlock(fiq, req);
 	}
@@ -364,7 +404,7 @@ static int queue_interrupt(struct fuse_req *req)
 static void request_wait_answer(struct fuse_req *req)
 {
 	struct fuse_conn *fc = req->fm->fc;
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq;
 	int err;
 
 	if (!fc->no_interrupt) {
@@ -388,7 +428,7 @@ static void request_wait_answer(struct fuse_req *req)
 		if (!err)
 			return;
 
-		spin_lock(&fiq->lock);
+		fiq = fuse_lock_req_iqueue(req);
 		/* Request is not yet in userspace, bail out */
 		if (test_bit(FR_PENDING, &req->flags)) {
 			list_del(&req->list);
@@ -409,10 +449,10 @@ static void request_wait_answer(struct fuse_req *req)
 
 static void __fuse_request_send(struct fuse_req *req)
 {
-	struct fuse_iqueue *fiq = &req->fm->fc->iq;
+	struct fuse_iqueue *fiq;
 
 	BUG_ON(test_bit(FR_BACKGROUND, &req->flags));
-	spin_lock(&fiq->lock);
+	fiq = fuse_lock_iqueue(req->fm->fc);
 	if (!fiq->connected) {
 		spin_unlock(&fiq->lock);
 		req->out.h.error = -ENOTCONN;
@@ -1205,7 +1245,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 {
 	ssize_t err;
 	struct fuse_conn *fc = fud->fc;
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq = READ_ONCE(fud->iq);
 	struct fuse_pqueue *fpq = &fud->pq;
 	struct fuse_req *req;
 	struct fuse_args *args;
@@ -2064,7 +2104,7 @@ static __poll_t fuse_dev_poll(struct file *file, poll_table *wait)
 	if (!fud)
 		return EPOLLERR;
 
-	fiq = &fud->fc->iq;
+	fiq = READ_ONCE(fud->iq);
 	poll_wait(file, &fiq->waitq, wait);
 
 	spin_lock(&fiq->lock);
@@ -2123,10 +2163,25 @@ static void end_polls(struct fuse_conn *fc)
  * is OK, the request will in that case be removed from the list before we touch
  * it.
  */
-void fuse_abort_conn(struct fuse_conn *fc)
+/* Disconnect @fiq and move its pending requests to @to_end */
+static void fuse_iqueue_abort(struct fuse_iqueue *fiq, struct list_head *to_end)
 {
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_req *req;
+
+	spin_lock(&fiq->lock);
+	fiq->connected = 0;
+	list_for_each_entry(req, &fiq->pending, list)
+		clear_bit(FR_PENDING, &req->flags);
+	list_splice_tail_init(&fiq->pending, to_end);
+	while (forget_pending(fiq))
+		kfree(fuse_dequeue_forget(fiq, 1, NULL));
+	wake_up_all(&fiq->waitq);
+	spin_unlock(&fiq->lock);
+	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
+}
 
+void fuse_abort_conn(struct fuse_conn *fc)
+{
 	spin_lock(&fc->lock);
 	if (fc->connected) {
 		struct fuse_dev *fud;
@@ -2167,16 +2222,14 @@ void fuse_abort_conn(struct fuse_conn *fc)
 		flush_bg_queue(fc);
 		spin_unlock(&fc->bg_lock);
 
-		spin_lock(&fiq->lock);
-		fiq->connected = 0;
-		list_for_each_entry(req, &fiq->pending, list)
-			clear_bit(FR_PENDING, &req->flags);
-		list_splice_tail_init(&fiq->pending, &to_end);
-		while (forget_pending(fiq))
-			kfree(fuse_dequeue_forget(fiq, 1, NULL));
-		wake_up_all(&fiq->waitq);
-		spin_unlock(&fiq->lock);
-		kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
+		fuse_iqueue_abort(&fc->iq, &to_end);
+		if (fc->cpu_iqs) {
+			for_each_possible_cpu(i) {
+				if (fc->cpu_iqs[i])
+					fuse_iqueue_abort(fc->cpu_iqs[i],
+							  &to_end);
+			}
+		}
 		end_polls(fc);
 		wake_up_all(&fc->blocked_waitq);
 		spin_unlock(&fc->lock);
@@ -2195,6 +2248,33 @@ void fuse_wait_aborted(struct fuse_conn *fc)
 	wait_event(fc->blocked_waitq, atomic_read(&fc->num_waiting) == 0);
 }
 
+/*
+ * The last device bound to a per-CPU queue is going away: new requests from
+ * that CPU go to fc->iq again, and so do the ones still pending.
+ */
+static void fuse_dev_unbind(struct fuse_dev *fud)
+{
+	struct fuse_iqueue *fiq = fud->iq;
+	struct fuse_iqueue *main_fiq = &fud->fc->iq;
+	struct fuse_req *req;
+
+	if (fiq == main_fiq)
+		return;
+
+	spin_lock(&fiq->lock);
+	if (--fiq->nr_devs) {
+		spin_unlock(&fiq->lock);
+		return;
+	}
+
+	spin_lock_nested(&main_fiq->lock, SINGLE_DEPTH_NESTING);
+	list_for_each_entry(req, &fiq->pending, list)
+		req->iq = main_fiq;
+	list_splice_tail_init(&fiq->pending, &main_fiq->pending);
+	spin_unlock(&fiq->lock);
+	main_fiq->ops->wake_pending_and_unlock(main_fiq);
+}
+
 int fuse_dev_release(struct inode *inode, struct file *file)
 {
 	struct fuse_dev *fud = fuse_get_dev(file);
@@ -2213,6 +2293,8 @@ int fuse_dev_release(struct inode *inode, struct file *file)
 
 		end_requests(&to_end);
 
+		fuse_dev_unbind(fud);
+
 		/* Are we the last open device? */
 		if (atomic_dec_and_test(&fc->dev_count)) {
 			WARN_ON(fc->iq.fasync != NULL);
@@ -2232,7 +2314,7 @@ static int fuse_dev_fasync(int fd, struct file *file, int on)
 		return -EPERM;
 
 	/* No locking - fasync_helper does its own locking */
-	return fasync_helper(fd, file, on, &fud->fc->iq.fasync);
+	return fasync_helper(fd, file, on, &READ_ONCE(fud->iq)->fasync);
 }
 
 static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
@@ -2252,6 +2334,109 @@ static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
 	return 0;
 }
 
+/*
+ * FUSE_DEV_IOC_BIND_CPU: read requests sent from @cpu on this device.
+ *
+ * A server thread per CPU, each with its own cloned device bound to its
+ * CPU, gets the requests of that CPU without sharing a queue, lock and
+ * wait queue with the other threads.  Forgets and interrupts are only
+ * queued on the unbound devices, so at least one must still be read.
+ */
+static int fuse_dev_bind_cpu(struct fuse_dev *fud, u32 cpu)
+{
+	struct fuse_conn *fc = fud->fc;
+	struct fuse_iqueue **cpu_iqs;
+	struct fuse_iqueue *fiq;
+	int err = 0;
+
+	if (cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return -EINVAL;
+
+	if (fc->iq.ops != &fuse_dev_fiq_ops)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&fuse_mutex);
+	if (fud->iq != &fc->iq) {
+		err = -EBUSY;
+		goto out;
+	}
+
+	cpu_iqs = fc->cpu_iqs;
+	if (!cpu_iqs) {
+		err = -ENOMEM;
+		cpu_iqs = kcalloc(nr_cpu_ids, sizeof(*cpu_iqs), GFP_KERNEL);
+		if (!cpu_iqs)
+			goto out;
+
+		spin_lock(&fc->lock);
+		smp_store_release(&fc->cpu_iqs, cpu_iqs);
+		spin_unlock(&fc->lock);
+		err = 0;
+	}
+
+	fiq = cpu_iqs[cpu];
+	if (!fiq) {
+		err = -ENOMEM;
+		fiq = kzalloc_node(sizeof(*fiq), GFP_KERNEL, cpu_to_node(cpu));
+		if (!fiq)
+			goto out;
+
+		fuse_iqueue_init(fiq, fc->iq.ops, fc->iq.priv);
+		/* Keep request ids unique across the queues of fc */
+		fiq->reqctr = (u64)(cpu + 1) << 48;
+
+		/* fuse_abort_conn() disconnects the queues under fc->lock */
+		spin_lock(&fc->lock);
+		fiq->connected = fc->connected;
+		smp_store_release(&cpu_iqs[cpu], fiq);
+		spin_unlock(&fc->lock);
+		err = 0;
+	}
+
+	spin_lock(&fiq->lock);
+	fiq->nr_devs++;
+	spin_unlock(&fiq->lock);
+	WRITE_ONCE(fud->iq, fiq);
+out:
+	mutex_unlock(&fuse_mutex);
+	return err;
+}
+
+static long fuse_dev_ioctl_backing_open(struct file *file,
+					struct fuse_backing_map __user *argp)
+{
+	struct fuse_dev *fud = fuse_get_dev(file);
+	struct fuse_backing_map map;
+
+	if (!fud)
+		return -EPERM;
+
+	if (!IS_ENABLED(CONFIG_FUSE_PASSTHROUGH))
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&map, argp, sizeof(map)))
+		return -EFAULT;
+
+	return fuse_backing_open(fud->fc, &map);
+}
+
+static long fuse_dev_ioctl_backing_close(struct file *file, __u32 __user *argp)
+{
+	struct fuse_dev *fud = fuse_get_dev(file);
+	int backing_id;
+
+	if (!fud)
+		return -EPERM;
+
+	if (!IS_ENABLED(CONFIG_FUSE_PASSTHROUGH))
+		return -EOPNOTSUPP;
+
+	if (get_user(backing_id, argp))
+		return -EFAULT;
+
+	return fuse_backing_close(fud->fc, backing_id);
+}
+
 static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
@@ -2284,6 +2469,25 @@ static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			}
 		}
 		break;
+	case FUSE_DEV_IOC_BACKING_OPEN:
+		res = fuse_dev_ioctl_backing_open(file, (void __user *)arg);
+		break;
+	case FUSE_DEV_IOC_BACKING_CLOSE:
+		res = fuse_dev_ioctl_backing_close(file, (__u32 __user *)arg);
+		break;
+	case FUSE_DEV_IOC_BIND_CPU: {
+		u32 cpu;
+
+		res = -EFAULT;
+		if (get_user(cpu, (__u32 __user *)arg))
+			break;
+
+		res = -EPERM;
+		fud = fuse_get_dev(file);
+		if (fud)
+			res = fuse_dev_bind_cpu(fud, cpu);
+		break;
+	}
 	default:
 		res = -ENOTTY;
 		break;
@@ -30,6 +30,7 @@
 #include <linux/xattr.h>
 #include <linux/pid_namespace.h>
 #include <linux/refcount.h>
+#include <linux/idr.h>
 #include <linux/user_namespace.h>
 
 /** Default max number of pages that can be used in a single read request */
@@ -125,6 +126,10 @@ struct fuse_inode {
 
 			/* List of writepage requestst (pending or sent) */
 			struct rb_root writepages;
+
+			/* Number of opens using the page cache (positive)
+			 * or passthrough (negative).  Protected by fi->lock */
+			int iocachectr;
 		};
 
 		/* readdir cache (directory only) */
@@ -241,6 +246,16 @@ struct fuse_file {
 
 	/** Has flock been performed on this file? */
 	bool flock:1;
+
+	/** Is this open counted in fi->iocachectr as a page cache user? */
+	bool io_cached:1;
+
+	/** Backing file given in the open reply, until the open completes */
+	struct fuse_backing *backing;
+
+	/** FOPEN_PASSTHROUGH: file that reads and writes go to, and creds */
+	struct file *passthrough;
+	const struct cred *cred;
 };
 
 /** One input argument of a request */
@@ -391,6 +406,9 @@ struct fuse_req {
 
 	/** fuse_mount this request belongs to */
 	struct fuse_mount *fm;
+
+	/** Input queue the request was queued on, protected by its lock */
+	struct fuse_iqueue *iq;
 };
 
 struct fuse_iqueue;
@@ -465,6 +483,9 @@ struct fuse_iqueue {
 
 	/** Device-specific state */
 	void *priv;
+
+	/** Devices bound to this queue, if it is one of fc->cpu_iqs */
+	unsigned int nr_devs;
 };
 
 #define FUSE_PQ_HASH_BITS 8
@@ -496,6 +517,9 @@ struct fuse_dev {
 
 	/** list entry on fc->devices */
 	struct list_head entry;
+
+	/** Input queue read by this device: fc->iq, or a per-CPU queue */
+	struct fuse_iqueue *iq;
 };
 
 enum fuse_dax_mode {
@@ -592,6 +616,14 @@ struct fuse_conn {
 	/** Input queue */
 	struct fuse_iqueue iq;
 
+	/**
+	 * Per-CPU input queues, indexed by CPU and allocated on the first
+	 * FUSE_DEV_IOC_BIND_CPU.  A request goes to the queue of the CPU
+	 * it is sent from, if a device is bound to it, and to iq otherwise.
+	 * Forgets and interrupts always go to iq.
+	 */
+	struct fuse_iqueue **cpu_iqs;
+
 	/** The next unique kernel file handle */
 	atomic64_t khctr;
 
@@ -804,6 +836,12 @@ struct fuse_conn {
 	/* Is tmpfile not implemented by fs? */
 	unsigned int no_tmpfile:1;
 
+	/* May opens use FOPEN_PASSTHROUGH? */
+	unsigned int passthrough:1;
+
+	/* Maximum stacking depth of passthrough backing files */
+	int max_stack_depth;
+
 	/** The number of requests waiting for completion */
 	atomic_t num_waiting;
 
@@ -853,6 +891,9 @@ struct fuse_conn {
 
 	/* New writepages go into this bucket */
 	struct fuse_sync_bucket __rcu *curr_bucket;
+
+	/** Backing files by id, for FOPEN_PASSTHROUGH.  Updated under lock */
+	struct idr backing_files_map;
 };
 
 /*
@@ -1131,6 +1172,12 @@ void fuse_change_entry_timeout(struct dentry *entry, struct fuse_entry_out *o);
  */
 struct fuse_conn *fuse_conn_get(struct fuse_conn *fc);
 
+/**
+ * Initialize an input queue
+ */
+void fuse_iqueue_init(struct fuse_iqueue *fiq,
+		      const struct fuse_iqueue_ops *ops, void *priv);
+
 /**
  * Initialize fuse_conn
  */
@@ -1336,4 +1383,33 @@ struct fuse_file *fuse_file_open(struct fuse_mount *fm, u64 nodeid,
 void fuse_file_release(struct inode *inode, struct fuse_file *ff,
 		       unsigned int open_flags, fl_owner_t id, bool isdir);
 
+/* passthrough.c */
+
+/* A file registered with FUSE_DEV_IOC_BACKING_OPEN */
+struct fuse_backing {
+	struct file *file;
+	const struct cred *cred;
+
+	refcount_t count;
+	struct rcu_head rcu;
+};
+
+void fuse_backing_files_init(struct fuse_conn *fc);
+void fuse_backing_files_free(struct fuse_conn *fc);
+int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map);
+int fuse_backing_close(struct fuse_conn *fc, int backing_id);
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_file *ff,
+			    struct fuse_open_out *openarg);
+void fuse_file_io_open(struct file *file, struct inode *inode);
+void fuse_file_io_release(struct fuse_file *ff, struct fuse_inode *fi);
+void fuse_passthrough_release(struct fuse_file *ff);
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to);
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from);
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma);
+
+static inline struct file *fuse_file_passthrough(struct fuse_file *ff)
+{
+	return IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) ? ff->passthrough : NULL;
+}
+
 #endif /* _FS_FUSE_I_H */
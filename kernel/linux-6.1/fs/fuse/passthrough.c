@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * FUSE passthrough: reads, writes and mmap of an open file served by a
+ * backing file that the server registered, without going through the
+ * server.
+ *
+ * The server registers an open file with FUSE_DEV_IOC_BACKING_OPEN and
+ * gets back a backing id.  An OPEN or CREATE reply with FOPEN_PASSTHROUGH
+ * names that id; the kernel then opens the same path with the flags of the
+ * fuse open and the credentials of the server at registration time, and
+ * sends I/O on the fuse file straight to it.  Everything else, including
+ * fsync and release, still goes to the server.
+ *
+ * Passthrough writes bypass the page cache of the fuse inode, so an inode
+ * is never open for passthrough and through the page cache at the same
+ * time: fi->iocachectr counts cached opens up and passthrough opens down,
+ * and an open that would mix the two falls back to the mode already in use
+ * (direct I/O through the server, for a cached open of a passthrough
+ * inode).
+ */
+
+#include "fuse_i.h"
+
+#include <linux/cred.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/idr.h>
+#include <linux/uio.h>
+
+static void fuse_backing_put(struct fuse_backing *fb)
+{
+	if (refcount_dec_and_test(&fb->count)) {
+		fput(fb->file);
+		put_cred(fb->cred);
+		kfree_rcu(fb, rcu);
+	}
+}
+
+static struct fuse_backing *fuse_backing_lookup(struct fuse_conn *fc,
+						int backing_id)
+{
+	struct fuse_backing *fb;
+
+	rcu_read_lock();
+	fb = idr_find(&fc->backing_files_map, backing_id);
+	if (fb && !refcount_inc_not_zero(&fb->count))
+		fb = NULL;
+	rcu_read_unlock();
+
+	return fb;
+}
+
+void fuse_backing_files_init(struct fuse_conn *fc)
+{
+	idr_init(&fc->backing_files_map);
+}
+
+static int fuse_backing_id_free(int id, void *p, void *data)
+{
+	fuse_backing_put(p);
+	return 0;
+}
+
+void fuse_backing_files_free(struct fuse_conn *fc)
+{
+	idr_for_each(&fc->backing_files_map, fuse_backing_id_free, NULL);
+	idr_destroy(&fc->backing_files_map);
+}
+
+/*
+ * FUSE_DEV_IOC_BACKING_OPEN: returns a positive backing id for map->fd.
+ * Backing files do not show up anywhere the owner of the mount could see
+ * them, which is why registering one takes CAP_SYS_ADMIN.
+ */
+int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map)
+{
+	struct fuse_backing *fb;
+	struct super_block *backing_sb;
+	struct file *file;
+	int res;
+
+	if (!fc->passthrough || !capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (map->flags || map->padding)
+		return -EINVAL;
+
+	file = fget(map->fd);
+	if (!file)
+		return -EBADF;
+
+	res = -EOPNOTSUPP;
+	if (!file->f_op->read_iter || !file->f_op->write_iter)
+		goto out_fput;
+
+	backing_sb = file_inode(file)->i_sb;
+	res = -ELOOP;
+	if (backing_sb->s_stack_depth >= fc->max_stack_depth)
+		goto out_fput;
+
+	res = -ENOMEM;
+	fb = kmalloc(sizeof(*fb), GFP_KERNEL);
+	if (!fb)
+		goto out_fput;
+
+	fb->file = file;
+	fb->cred = prepare_creds();
+	if (!fb->cred) {
+		kfree(fb);
+		goto out_fput;
+	}
+	refcount_set(&fb->count, 1);
+
+	idr_preload(GFP_KERNEL);
+	spin_lock(&fc->lock);
+	res = idr_alloc_cyclic(&fc->backing_files_map, fb, 1, 0, GFP_ATOMIC);
+	spin_unlock(&fc->lock);
+	idr_preload_end();
+
+	if (res < 0)
+		fuse_backing_put(fb);
+	return res;
+
+out_fput:
+	fput(file);
+	return res;
+}
+
+/* Files already opened with the id keep their backing file */
+int fuse_backing_close(struct fuse_conn *fc, int backing_id)
+{
+	struct fuse_backing *fb;
+
+	if (!fc->passthrough || !capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (backing_id <= 0)
+		return -EINVAL;
+
+	spin_lock(&fc->lock);
+	fb = idr_remove(&fc->backing_files_map, backing_id);
+	spin_unlock(&fc->lock);
+	if (!fb)
+		return -ENOENT;
+
+	fuse_backing_put(fb);
+	return 0;
+}
+
+/* Called with the OPEN or CREATE reply, before the file is set up */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_file *ff,
+			    struct fuse_open_out *openarg)
+{
+	if (!(ff->open_flags & FOPEN_PASSTHROUGH))
+		return;
+
+	if (fc->passthrough)
+		ff->backing = fuse_backing_lookup(fc, openarg->backing_id);
+	if (!ff->backing) {
+		pr_warn_ratelimited("fuse: invalid backing id %d, not using passthrough\n",
+				    openarg->backing_id);
+		ff->open_flags &= ~FOPEN_PASSTHROUGH;
+	}
+}
+
+/*
+ * Pick the I/O mode of a newly opened file, see the comment on top, and
+ * open the backing file if it is to be used.
+ */
+void fuse_file_io_open(struct file *file, struct inode *inode)
+{
+	struct fuse_file *ff = file->private_data;
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	struct fuse_backing *fb = ff->backing;
+	struct file *backing_file = NULL;
+
+	ff->backing = NULL;
+	if (!S_ISREG(inode->i_mode) || FUSE_IS_DAX(inode)) {
+		if (fb)
+			fuse_backing_put(fb);
+		ff->open_flags &= ~FOPEN_PASSTHROUGH;
+		return;
+	}
+
+	if (fb) {
+		backing_file = dentry_open(&fb->file->f_path,
+					   file->f_flags & ~(O_CREAT | O_EXCL |
+							     O_NOCTTY | O_TRUNC),
+					   fb->cred);
+		if (IS_ERR(backing_file)) {
+			pr_warn_ratelimited("fuse: failed to open backing file (%ld), not using passthrough\n",
+					    PTR_ERR(backing_file));
+			backing_file = NULL;
+		}
+	}
+
+	spin_lock(&fi->lock);
+	if (backing_file && fi->iocachectr <= 0) {
+		fi->iocachectr--;
+		ff->passthrough = backing_file;
+		ff->cred = get_cred(fb->cred);
+		backing_file = NULL;
+	} else if (!(ff->open_flags & FOPEN_DIRECT_IO)) {
+		if (fi->iocachectr >= 0) {
+			fi->iocachectr++;
+			ff->io_cached = true;
+		} else {
+			ff->open_flags |= FOPEN_DIRECT_IO;
+		}
+	}
+	spin_unlock(&fi->lock);
+
+	/* Other opens of the inode are using the page cache */
+	if (backing_file)
+		fput(backing_file);
+	if (fb)
+		fuse_backing_put(fb);
+
+	if (ff->passthrough)
+		invalidate_inode_pages2(inode->i_mapping);
+	else
+		ff->open_flags &= ~FOPEN_PASSTHROUGH;
+}
+
+void fuse_file_io_release(struct fuse_file *ff, struct fuse_inode *fi)
+{
+	if (!ff->io_cached && !ff->passthrough)
+		return;
+
+	spin_lock(&fi->lock);
+	if (ff->io_cached)
+		fi->iocachectr--;
+	else
+		fi->iocachectr++;
+	ff->io_cached = false;
+	spin_unlock(&fi->lock);
+}
+
+void fuse_passthrough_release(struct fuse_file *ff)
+{
+	if (ff->backing)
+		fuse_backing_put(ff->backing);
+	if (ff->passthrough)
+		fput(ff->passthrough);
+	if (ff->cred)
+		put_cred(ff->cred);
+}
+
+static rwf_t fuse_iocb_to_rwf(int ifl)
+{
+	rwf_t flags = 0;
+
+	if (ifl & IOCB_NOWAIT)
+		flags |= RWF_NOWAIT;
+	if (ifl & IOCB_HIPRI)
+		flags |= RWF_HIPRI;
+	if (ifl & IOCB_DSYNC)
+		flags |= RWF_DSYNC;
+	if (ifl & IOCB_SYNC)
+		flags |= RWF_SYNC;
+
+	return flags;
+}
+
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	if (!iov_iter_count(to))
+		return 0;
+
+	old_cred = override_creds(ff->cred);
+	ret = vfs_iter_read(ff->passthrough, to, &iocb->ki_pos,
+			    fuse_iocb_to_rwf(iocb->ki_flags));
+	revert_creds(old_cred);
+
+	fuse_invalidate_atime(file_inode(file));
+	return ret;
+}
+
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	struct inode *inode = file_inode(file);
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	if (!iov_iter_count(from))
+		return 0;
+
+	inode_lock(inode);
+	old_cred = override_creds(ff->cred);
+	file_start_write(ff->passthrough);
+	ret = vfs_iter_write(ff->passthrough, from, &iocb->ki_pos,
+			     fuse_iocb_to_rwf(iocb->ki_flags));
+	file_end_write(ff->passthrough);
+	revert_creds(old_cred);
+	if (ret > 0)
+		fuse_write_update_attr(inode, iocb->ki_pos, ret);
+	inode_unlock(inode);
+
+	return ret;
+}
+
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_file *ff = file->private_data;
+	const struct cred *old_cred;
+	int ret;
+
+	if (!ff->passthrough->f_op->mmap)
+		return -ENODEV;
+
+	if (WARN_ON(file != vma->vm_file))
+		return -EIO;
+
+	vma_set_file(vma, ff->passthrough);
+
+	old_cred = override_creds(ff->cred);
+	ret = call_mmap(vma->vm_file, vma);
+	revert_creds(old_cred);
+	fuse_invalidate_atime(file_inode(file));
+
+	return ret;
+}
@@ -172,6 +172,7 @@ extern struct dentry * d_alloc_pseudo(struct super_block *, const struct qstr *)
 extern char *simple_dname(struct dentry *, char *, int);
 extern void dput_to_list(struct dentry *, struct list_head *);
 extern void shrink_dentry_list(struct list_head *);
+extern void prune_negative_dentries(struct work_struct *work);
 
 /*
  * pipe.c
@@ -199,6 +200,16 @@ int sb_init_dio_done_wq(struct super_block *sb);
 int getname_statx_lookup_flags(int flags);
 int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	     unsigned int mask, struct statx __user *buffer);
+int do_statx_root(const struct path *root, struct filename *filename,
+		  unsigned int flags, unsigned int mask,
+		  struct statx __user *buffer);
+
+/*
+ * fs/readdir.c
+ */
+struct linux_dirent64;
+int vfs_getdents(struct file *file, struct linux_dirent64 __user *dirent,
+		 unsigned int count);
 
 /*
  * fs/splice.c:
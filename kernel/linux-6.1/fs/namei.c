@@ -1030,8 +1030,50 @@ static int sysctl_protected_hardlinks __read_mostly;
 static int sysctl_protected_fifos __read_mostly;
 static int sysctl_protected_regular __read_mostly;
 
+/*
+ * How lookups ended up being done: every walk starts in RCU mode, falls
+ * back to ref-walk when that returns -ECHILD, and revalidates everything
+ * from scratch on -ESTALE.  A high share of ref-walks points at something
+ * keeping RCU walk from completing (->d_revalidate or ->permission that
+ * cannot run in RCU mode, seqcount races with renames, ...).
+ */
+enum {
+	WALK_RCU,		/* walks started in RCU mode */
+	WALK_REF,		/* ... of which retried in ref-walk mode */
+	WALK_REVAL,		/* ... of which retried with LOOKUP_REVAL */
+	NR_WALK_STATS,
+};
+
+static DEFINE_PER_CPU(unsigned long, walk_stats[NR_WALK_STATS]);
+
+static inline void walk_stat_inc(int item)
+{
+	this_cpu_inc(walk_stats[item]);
+}
+
 #ifdef CONFIG_SYSCTL
+static unsigned long walk_state[NR_WALK_STATS];
+
+static int proc_walk_state(struct ctl_table *table, int write, void *buffer,
+			   size_t *lenp, loff_t *ppos)
+{
+	int cpu, i;
+
+	memset(walk_state, 0, sizeof(walk_state));
+	for_each_possible_cpu(cpu)
+		for (i = 0; i < NR_WALK_STATS; i++)
+			walk_state[i] += per_cpu(walk_stats[i], cpu);
+	return proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
+}
+
 static struct ctl_table namei_sysctls[] = {
+	{
+		.procname	= "path-walk-state",
+		.data		= &walk_state,
+		.maxlen		= sizeof(walk_state),
+		.mode		= 0444,
+		.proc_handler	= proc_walk_state,
+	},
 	{
 		.procname	= "protected_symlinks",
 		.data		= &sysctl_protected_symlinks,
@@ -2505,11 +2547,16 @@ int filename_lookup(int dfd, struct filename *name, unsigned flags,
 	if (IS_ERR(name))
 		return PTR_ERR(name);
 	set_nameidata(&nd, dfd, name, root);
+	walk_stat_inc(WALK_RCU);
 	retval = path_lookupat(&nd, flags | LOOKUP_RCU, path);
-	if (unlikely(retval == -ECHILD))
+	if (unlikely(retval == -ECHILD)) {
+		walk_stat_inc(WALK_REF);
 		retval = path_lookupat(&nd, flags, path);
-	if (unlikely(retval == -ESTALE))
+	}
+	if (unlikely(retval == -ESTALE)) {
+		walk_stat_inc(WALK_REVAL);
 		retval = path_lookupat(&nd, flags | LOOKUP_REVAL, path);
+	}
 
 	if (likely(!retval))
 		audit_inode(name, path->dentry,
@@ -2547,11 +2594,16 @@ static int __filename_parentat(int dfd, struct filename *name,
 	if (IS_ERR(name))
 		return PTR_ERR(name);
 	set_nameidata(&nd, dfd, name, root);
+	walk_stat_inc(WALK_RCU);
 	retval = path_parentat(&nd, flags | LOOKUP_RCU, parent);
-	if (unlikely(retval == -ECHILD))
+	if (unlikely(retval == -ECHILD)) {
+		walk_stat_inc(WALK_REF);
 		retval = path_parentat(&nd, flags, parent);
-	if (unlikely(retval == -ESTALE))
+	}
+	if (unlikely(retval == -ESTALE)) {
+		walk_stat_inc(WALK_REVAL);
 		retval = path_parentat(&nd, flags | LOOKUP_REVAL, parent);
+	}
 	if (likely(!retval)) {
 		*last = nd.last;
 		*type = nd.last_type;
@@ -3807,11 +3859,16 @@ struct file *do_filp_open(int dfd, struct filename *pathname,
 	struct file *filp;
 
 	set_nameidata(&nd, dfd, pathname, NULL);
+	walk_stat_inc(WALK_RCU);
 	filp = path_openat(&nd, op, flags | LOOKUP_RCU);
-	if (unlikely(filp == ERR_PTR(-ECHILD)))
+	if (unlikely(filp == ERR_PTR(-ECHILD))) {
+		walk_stat_inc(WALK_REF);
 		filp = path_openat(&nd, op, flags);
-	if (unlikely(filp == ERR_PTR(-ESTALE)))
+	}
+	if (unlikely(filp == ERR_PTR(-ESTALE))) {
+		walk_stat_inc(WALK_REVAL);
 		filp = path_openat(&nd, op, flags | LOOKUP_REVAL);
+	}
 	restore_nameidata();
 	return filp;
 }
@@ -3832,11 +3889,16 @@ struct file *do_file_open_root(const struct path *root,
 		return ERR_CAST(filename);
 
 	set_nameidata(&nd, -1, filename, root);
+	walk_stat_inc(WALK_RCU);
 	file = path_openat(&nd, op, flags | LOOKUP_RCU);
-	if (unlikely(file == ERR_PTR(-ECHILD)))
+	if (unlikely(file == ERR_PTR(-ECHILD))) {
+		walk_stat_inc(WALK_REF);
 		file = path_openat(&nd, op, flags);
-	if (unlikely(file == ERR_PTR(-ESTALE)))
+	}
+	if (unlikely(file == ERR_PTR(-ESTALE))) {
+		walk_stat_inc(WALK_REVAL);
 		file = path_openat(&nd, op, flags | LOOKUP_REVAL);
+	}
 	restore_nameidata();
 	putname(filename);
 	return file;
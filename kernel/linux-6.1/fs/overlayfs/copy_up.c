@@ -193,31 +193,22 @@ static int ovl_copy_fileattr(struct inode *inode, const struct path *old,
 	return ovl_real_fileattr_set(new, &newfa);
 }
 
-static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
-			    struct file *new_file, loff_t len)
+/* Copy [pos, pos + len) of old_file to the same range of new_file */
+static int ovl_copy_up_file_range(struct file *old_file, struct file *new_file,
+				  loff_t pos, loff_t len)
 {
-	struct path datapath;
-	struct file *old_file;
-	loff_t old_pos = 0;
-	loff_t new_pos = 0;
+	loff_t old_pos = pos;
+	loff_t new_pos = pos;
 	loff_t cloned;
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
 	int error = 0;
 
-	ovl_path_lowerdata(dentry, &datapath);
-	if (WARN_ON(datapath.dentry == NULL))
-		return -EIO;
-
-	old_file = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
-	if (IS_ERR(old_file))
-		return PTR_ERR(old_file);
-
 	/* Try to use clone_file_range to clone up within the same fs */
-	cloned = do_clone_file_range(old_file, 0, new_file, 0, len, 0);
+	cloned = do_clone_file_range(old_file, pos, new_file, pos, len, 0);
 	if (cloned == len)
-		goto out_fput;
+		return 0;
 	/* Couldn't clone, so now we try to copy the data */
 
 	/* Check if lower fs supports seek operation */
@@ -256,6 +247,8 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 			data_pos = vfs_llseek(old_file, old_pos, SEEK_DATA);
 			if (data_pos > old_pos) {
 				hole_len = data_pos - old_pos;
+				if (hole_len >= len)
+					break;
 				len -= hole_len;
 				old_pos = new_pos = data_pos;
 				continue;
@@ -277,9 +270,29 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 
 		len -= bytes;
 	}
+
+	return error;
+}
+
+static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
+			    struct file *new_file, loff_t len)
+{
+	struct path datapath;
+	struct file *old_file;
+	int error;
+
+	ovl_path_lowerdata(dentry, &datapath);
+	if (WARN_ON(datapath.dentry == NULL))
+		return -EIO;
+
+	old_file = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
+	if (IS_ERR(old_file))
+		return PTR_ERR(old_file);
+
+	error = ovl_copy_up_file_range(old_file, new_file, 0, len);
 	if (!error && ovl_should_sync(ofs))
 		error = vfs_fsync(new_file, 0);
-out_fput:
+
 	fput(old_file);
 	return error;
 }
@@ -507,6 +520,7 @@ struct ovl_copy_up_ctx {
 	bool origin;
 	bool indexed;
 	bool metacopy;
+	bool lazy;
 };
 
 static int ovl_link_up(struct ovl_copy_up_ctx *c)
@@ -908,11 +922,426 @@ static ssize_t ovl_getxattr_value(const struct path *path, char *name, char **va
 	return res;
 }
 
+/*
+ * Lazy data copy up (lazycopy=on).
+ *
+ * Opening a large metacopy file for write does not copy up its data.  The
+ * upper file gets a "partial" xattr instead, with one bit per chunk of the
+ * lower data, and from then on:
+ *  - a write first copies up the chunks it touches, see ovl_partial_copy_up();
+ *  - a read takes each chunk from upper if its bit is set, else from lower;
+ *  - a worker copies up the remaining chunks in the background.
+ * Once all chunks are in upper, the metacopy and partial xattrs go away and
+ * the file is a plain upper file.  A chunk is only recorded in the xattr
+ * after its data was copied (and synced, unless volatile), so a crash can
+ * never expose lower data over a chunk that was written in upper.
+ */
+#define OVL_PARTIAL_MIN_SIZE	(16 * OVL_COPY_UP_CHUNK_SIZE)
+#define OVL_PARTIAL_MAX_CHUNKS	8192
+/* Chunks copied by the worker each time it takes oi->lock */
+#define OVL_PARTIAL_BATCH	16
+
+static bool ovl_need_lazy_copy_up(struct dentry *dentry, struct kstat *stat,
+				  int flags)
+{
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+
+	return ofs->config.lazycopy && S_ISREG(stat->mode) &&
+	       !(flags & O_TRUNC) && stat->size >= OVL_PARTIAL_MIN_SIZE;
+}
+
+static size_t ovl_partial_xattr_size(unsigned long nr_chunks)
+{
+	return sizeof(struct ovl_partial_xattr) +
+	       DIV_ROUND_UP(nr_chunks, BITS_PER_BYTE);
+}
+
+static void ovl_partial_workfn(struct work_struct *work);
+
+static struct ovl_partial *ovl_partial_alloc(struct inode *inode, loff_t size,
+					     unsigned int chunk_shift)
+{
+	unsigned long nr_chunks = DIV_ROUND_UP_ULL(size, 1ULL << chunk_shift);
+	struct ovl_partial *p;
+
+	p = kvzalloc(sizeof(*p) + BITS_TO_LONGS(nr_chunks) * sizeof(long),
+		     GFP_KERNEL);
+	if (!p)
+		return NULL;
+
+	INIT_WORK(&p->work, ovl_partial_workfn);
+	p->inode = inode;
+	p->size = size;
+	p->nr_chunks = nr_chunks;
+	p->xattr.version = OVL_PARTIAL_VERSION;
+	p->xattr.chunk_shift = chunk_shift;
+	p->xattr.nr_chunks = cpu_to_le32(nr_chunks);
+
+	return p;
+}
+
+static void ovl_partial_publish(struct inode *inode, struct ovl_partial *p)
+{
+	/* Pairs with smp_load_acquire() in ovl_partial() */
+	smp_store_release(&OVL_I(inode)->partial, p);
+	queue_work(system_unbound_wq, &p->work);
+}
+
+void ovl_partial_free(struct ovl_partial *p)
+{
+	WRITE_ONCE(p->stop, true);
+	cancel_work_sync(&p->work);
+	if (p->lower)
+		fput(p->lower);
+	kvfree(p);
+}
+
+/*
+ * Pick up a lazy copy up started before this inode was instantiated.
+ * Caller holds oi->lock and has overridden creds.
+ */
+static int ovl_partial_load(struct dentry *dentry)
+{
+	struct inode *inode = d_inode(dentry);
+	struct ovl_fs *ofs = OVL_FS(dentry->d_sb);
+	struct ovl_partial_xattr *xattr = NULL;
+	struct ovl_partial *p = NULL;
+	struct path upperpath, datapath;
+	struct file *lower;
+	unsigned long nr_chunks, i;
+	ssize_t len, res;
+	loff_t size;
+
+	if (OVL_I(inode)->partial || ovl_test_flag(OVL_PARTIAL_CHECKED, inode))
+		return 0;
+
+	ovl_path_upper(dentry, &upperpath);
+	len = ovl_getxattr_value(&upperpath,
+				 (char *)ovl_xattr(ofs, OVL_XATTR_PARTIAL),
+				 (char **)&xattr);
+	if (len <= 0) {
+		if (!len)
+			ovl_set_flag(OVL_PARTIAL_CHECKED, inode);
+		return len;
+	}
+
+	ovl_path_lowerdata(dentry, &datapath);
+	if (WARN_ON(datapath.dentry == NULL)) {
+		res = -EIO;
+		goto out_free;
+	}
+
+	lower = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
+	res = PTR_ERR(lower);
+	if (IS_ERR(lower))
+		goto out_free;
+
+	size = i_size_read(file_inode(lower));
+	nr_chunks = len >= sizeof(*xattr) ? le32_to_cpu(xattr->nr_chunks) : 0;
+	res = -EIO;
+	if (!nr_chunks || xattr->version != OVL_PARTIAL_VERSION ||
+	    xattr->chunk_shift < ilog2(OVL_COPY_UP_CHUNK_SIZE) ||
+	    xattr->chunk_shift >= 63 ||
+	    nr_chunks != DIV_ROUND_UP_ULL(size, 1ULL << xattr->chunk_shift) ||
+	    len != ovl_partial_xattr_size(nr_chunks)) {
+		pr_warn_ratelimited("invalid partial xattr (%pd2, size=%lld)\n",
+				    upperpath.dentry, size);
+		goto out_fput;
+	}
+
+	res = -ENOMEM;
+	p = ovl_partial_alloc(inode, size, xattr->chunk_shift);
+	if (!p)
+		goto out_fput;
+
+	for (i = 0; i < nr_chunks; i++) {
+		if (test_bit_le(i, xattr->map)) {
+			__set_bit_le(i, p->xattr.map);
+			p->nr_copied++;
+		}
+	}
+	p->lower = lower;
+	ovl_partial_publish(inode, p);
+	res = 0;
+	goto out_free;
+
+out_fput:
+	fput(lower);
+out_free:
+	kfree(xattr);
+	return res;
+}
+
+/* Start a lazy copy up; caller holds oi->lock and has overridden creds */
+static int ovl_copy_up_partial(struct ovl_copy_up_ctx *c)
+{
+	struct inode *inode = d_inode(c->dentry);
+	struct ovl_fs *ofs = OVL_FS(c->dentry->d_sb);
+	unsigned int chunk_shift;
+	struct path datapath;
+	struct ovl_partial *p;
+	struct file *lower;
+	int err;
+
+	err = ovl_partial_load(c->dentry);
+	if (err || OVL_I(inode)->partial)
+		return err;
+
+	chunk_shift = max_t(unsigned int, ilog2(OVL_COPY_UP_CHUNK_SIZE),
+			    order_base_2(DIV_ROUND_UP_ULL(c->stat.size,
+						OVL_PARTIAL_MAX_CHUNKS)));
+	p = ovl_partial_alloc(inode, c->stat.size, chunk_shift);
+	if (!p)
+		return -ENOMEM;
+
+	ovl_path_lowerdata(c->dentry, &datapath);
+	lower = ovl_path_open(&datapath, O_LARGEFILE | O_RDONLY);
+	err = PTR_ERR(lower);
+	if (IS_ERR(lower))
+		goto out_free;
+
+	err = ovl_setxattr(ofs, ovl_dentry_upper(c->dentry), OVL_XATTR_PARTIAL,
+			   &p->xattr, ovl_partial_xattr_size(p->nr_chunks));
+	if (err) {
+		fput(lower);
+		goto out_free;
+	}
+
+	p->lower = lower;
+	ovl_partial_publish(inode, p);
+	return 0;
+
+out_free:
+	kvfree(p);
+	return err;
+}
+
+/*
+ * Copy up the chunks in [first, last) that are not in upper yet and record
+ * them in the partial xattr.  Caller holds oi->lock, write access to the
+ * upper mount and has overridden creds.
+ */
+static int ovl_partial_copy_chunks(struct ovl_partial *p, unsigned long first,
+				   unsigned long last)
+{
+	struct ovl_fs *ofs = OVL_FS(p->inode->i_sb);
+	struct path upperpath = {
+		.mnt = ovl_upper_mnt(ofs),
+		.dentry = ovl_i_dentry_upper(p->inode),
+	};
+	unsigned int shift = p->xattr.chunk_shift;
+	size_t xattr_size = ovl_partial_xattr_size(p->nr_chunks);
+	struct ovl_partial_xattr *xattr;
+	unsigned long chunk, nr = 0;
+	struct file *new_file;
+	char *capability = NULL;
+	ssize_t cap_size;
+	int err;
+
+	last = min(last, p->nr_chunks);
+	first = find_next_zero_bit_le(p->xattr.map, last, first);
+	if (first >= last)
+		return 0;
+
+	/* Writing to upper clears security.capability, keep it as copy up does */
+	err = cap_size = ovl_getxattr_value(&upperpath, XATTR_NAME_CAPS,
+					    &capability);
+	if (cap_size < 0)
+		return err;
+
+	err = -ENOMEM;
+	xattr = kmemdup(&p->xattr, xattr_size, GFP_KERNEL);
+	if (!xattr)
+		goto out_free_cap;
+
+	new_file = ovl_path_open(&upperpath, O_LARGEFILE | O_WRONLY);
+	err = PTR_ERR(new_file);
+	if (IS_ERR(new_file))
+		goto out_free;
+
+	for (chunk = first; chunk < last;
+	     chunk = find_next_zero_bit_le(p->xattr.map, last, chunk + 1)) {
+		loff_t pos = (loff_t)chunk << shift;
+
+		err = ovl_copy_up_file_range(p->lower, new_file, pos,
+					min_t(loff_t, 1LL << shift, p->size - pos));
+		if (err)
+			break;
+		__set_bit_le(chunk, xattr->map);
+		nr++;
+	}
+	if (!err && ovl_should_sync(ofs))
+		err = vfs_fsync(new_file, 1);
+	fput(new_file);
+
+	if (!err)
+		err = ovl_setxattr(ofs, upperpath.dentry, OVL_XATTR_PARTIAL,
+				   xattr, xattr_size);
+	if (!err) {
+		for (chunk = first; chunk < last; chunk++) {
+			if (test_bit_le(chunk, xattr->map))
+				__set_bit_le(chunk, p->xattr.map);
+		}
+		p->nr_copied += nr;
+	}
+
+	if (capability) {
+		int cap_err = ovl_do_setxattr(ofs, upperpath.dentry,
+					      XATTR_NAME_CAPS, capability,
+					      cap_size, 0);
+		if (!err)
+			err = cap_err;
+	}
+out_free:
+	kfree(xattr);
+out_free_cap:
+	kfree(capability);
+	return err;
+}
+
+/* All chunks are in upper: finish the copy up as for a full data copy up */
+static int ovl_partial_done(struct ovl_partial *p)
+{
+	struct ovl_fs *ofs = OVL_FS(p->inode->i_sb);
+	struct dentry *upper = ovl_i_dentry_upper(p->inode);
+	int err;
+
+	err = ovl_removexattr(ofs, upper, OVL_XATTR_METACOPY);
+	if (err)
+		return err;
+
+	/* A partial xattr left behind is ignored on a file with upper data */
+	ovl_removexattr(ofs, upper, OVL_XATTR_PARTIAL);
+	ovl_set_upperdata(p->inode);
+
+	return 0;
+}
+
+static void ovl_partial_workfn(struct work_struct *work)
+{
+	struct ovl_partial *p = container_of(work, struct ovl_partial, work);
+	struct inode *inode = p->inode;
+	struct vfsmount *upper_mnt = ovl_upper_mnt(OVL_FS(inode->i_sb));
+	const struct cred *old_cred;
+	unsigned long first;
+	bool more = false;
+	int err;
+
+	if (READ_ONCE(p->stop))
+		return;
+
+	err = mnt_want_write(upper_mnt);
+	if (err)
+		goto out;
+
+	ovl_inode_lock(inode);
+	old_cred = ovl_override_creds(inode->i_sb);
+	if (!ovl_has_upperdata(inode)) {
+		first = find_next_zero_bit_le(p->xattr.map, p->nr_chunks, 0);
+		err = ovl_partial_copy_chunks(p, first,
+					      first + OVL_PARTIAL_BATCH);
+		if (!err && p->nr_copied == p->nr_chunks)
+			err = ovl_partial_done(p);
+		more = !err && !ovl_has_upperdata(inode);
+	}
+	revert_creds(old_cred);
+	ovl_inode_unlock(inode);
+	mnt_drop_write(upper_mnt);
+
+	if (more)
+		queue_work(system_unbound_wq, &p->work);
+out:
+	/* Writes still copy up the chunks they need */
+	if (err)
+		pr_warn_ratelimited("background copy up of inode %lu failed (%i)\n",
+				    inode->i_ino, err);
+}
+
+/* Load lazy copy up state of a file being opened */
+int ovl_partial_init(struct dentry *dentry)
+{
+	struct inode *inode = d_inode(dentry);
+	const struct cred *old_cred;
+	int err;
+
+	if (!d_is_reg(dentry) || !ovl_dentry_upper(dentry) ||
+	    ovl_has_upperdata(inode) || READ_ONCE(OVL_I(inode)->partial) ||
+	    ovl_test_flag(OVL_PARTIAL_CHECKED, inode))
+		return 0;
+
+	err = ovl_inode_lock_interruptible(inode);
+	if (err)
+		return err;
+
+	old_cred = ovl_override_creds(dentry->d_sb);
+	err = ovl_partial_load(dentry);
+	revert_creds(old_cred);
+	ovl_inode_unlock(inode);
+
+	return err;
+}
+
+/**
+ * ovl_partial_copy_up() - copy up the data a write is about to modify
+ * @file: overlay file being written
+ * @pos: first byte written
+ * @len: number of bytes written
+ *
+ * No-op unless a lazy data copy up of @file is in progress.  A write that
+ * extends the file also copies up the last chunk, so that the lower data
+ * never shows up past its own end.
+ */
+int ovl_partial_copy_up(struct file *file, loff_t pos, u64 len)
+{
+	struct dentry *dentry = file_dentry(file);
+	struct inode *inode = d_inode(dentry);
+	struct ovl_partial *p = ovl_partial(inode);
+	const struct cred *old_cred;
+	unsigned int shift;
+	u64 first, last;
+	int err;
+
+	if (!p || !len || pos < 0)
+		return 0;
+
+	shift = p->xattr.chunk_shift;
+	len = min_t(u64, len, LLONG_MAX - pos);
+	first = pos >> shift;
+	last = min_t(u64, DIV_ROUND_UP_ULL(pos + len, 1ULL << shift),
+		     p->nr_chunks);
+	if (pos + len > p->size) {
+		first = min_t(u64, first, p->nr_chunks - 1);
+		last = p->nr_chunks;
+	}
+	if (find_next_zero_bit_le(p->xattr.map, last, first) >= last)
+		return 0;
+
+	err = ovl_want_write(dentry);
+	if (err)
+		return err;
+
+	err = ovl_inode_lock_interruptible(inode);
+	if (!err) {
+		old_cred = ovl_override_creds(inode->i_sb);
+		if (!ovl_has_upperdata(inode)) {
+			err = ovl_partial_copy_chunks(p, first, last);
+			if (!err && p->nr_copied == p->nr_chunks)
+				err = ovl_partial_done(p);
+		}
+		revert_creds(old_cred);
+		ovl_inode_unlock(inode);
+	}
+	ovl_drop_write(dentry);
+
+	return err;
+}
+
 /* Copy up data of an inode which was copied up metadata only in the past. */
 static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 {
 	struct ovl_fs *ofs = OVL_FS(c->dentry->d_sb);
 	struct path upperpath;
+	struct ovl_partial *p;
 	int err;
 	char *capability = NULL;
 	ssize_t cap_size;
@@ -921,6 +1350,12 @@ static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 	if (WARN_ON(upperpath.dentry == NULL))
 		return -EIO;
 
+	/* Chunks already copied up lazily may have been written since */
+	err = ovl_partial_load(c->dentry);
+	if (err)
+		return err;
+	p = OVL_I(d_inode(c->dentry))->partial;
+
 	if (c->stat.size) {
 		err = cap_size = ovl_getxattr_value(&upperpath, XATTR_NAME_CAPS,
 						    &capability);
@@ -928,7 +1363,10 @@ static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 			goto out;
 	}
 
-	err = ovl_copy_up_data(c, &upperpath);
+	if (!p)
+		err = ovl_copy_up_data(c, &upperpath);
+	else if (c->stat.size)
+		err = ovl_partial_copy_chunks(p, 0, p->nr_chunks);
 	if (err)
 		goto out_free;
 
@@ -948,6 +1386,8 @@ static int ovl_copy_up_meta_inode_data(struct ovl_copy_up_ctx *c)
 	if (err)
 		goto out_free;
 
+	if (p)
+		ovl_removexattr(ofs, upperpath.dentry, OVL_XATTR_PARTIAL);
 	ovl_set_upperdata(d_inode(c->dentry));
 out_free:
 	kfree(capability);
@@ -956,7 +1396,7 @@ out:
 }
 
 static int ovl_copy_up_one(struct dentry *parent, struct dentry *dentry,
-			   int flags)
+			   int flags, bool lazy)
 {
 	int err;
 	DEFINE_DELAYED_CALL(done);
@@ -980,7 +1420,9 @@ static int ovl_copy_up_one(struct dentry *parent, struct dentry *dentry,
 	    !kgid_has_mapping(current_user_ns(), ctx.stat.gid))
 		return -EOVERFLOW;
 
-	ctx.metacopy = ovl_need_meta_copy_up(dentry, ctx.stat.mode, flags);
+	ctx.lazy = lazy && ovl_need_lazy_copy_up(dentry, &ctx.stat, flags);
+	ctx.metacopy = ctx.lazy ||
+		       ovl_need_meta_copy_up(dentry, ctx.stat.mode, flags);
 
 	if (parent) {
 		ovl_path_upper(parent, &parentpath);
@@ -1014,8 +1456,12 @@ static int ovl_copy_up_one(struct dentry *parent, struct dentry *dentry,
 			err = ovl_do_copy_up(&ctx);
 		if (!err && parent && !ovl_dentry_has_upper_alias(dentry))
 			err = ovl_link_up(&ctx);
-		if (!err && ovl_dentry_needs_data_copy_up_locked(dentry, flags))
-			err = ovl_copy_up_meta_inode_data(&ctx);
+		if (!err && ovl_dentry_needs_data_copy_up_locked(dentry, flags)) {
+			if (ctx.lazy)
+				err = ovl_copy_up_partial(&ctx);
+			else
+				err = ovl_copy_up_meta_inode_data(&ctx);
+		}
 		ovl_copy_up_end(dentry);
 	}
 	do_delayed_call(&done);
@@ -1023,7 +1469,16 @@ static int ovl_copy_up_one(struct dentry *parent, struct dentry *dentry,
 	return err;
 }
 
-static int ovl_copy_up_flags(struct dentry *dentry, int flags)
+/* With @lazy, a write open may leave the data copy up to ovl_partial */
+static bool ovl_copied_up(struct dentry *dentry, int flags, bool lazy)
+{
+	if (lazy && ovl_partial(d_inode(dentry)))
+		flags = 0;
+
+	return ovl_already_copied_up(dentry, flags);
+}
+
+static int ovl_copy_up_flags(struct dentry *dentry, int flags, bool lazy)
 {
 	int err = 0;
 	const struct cred *old_cred;
@@ -1042,7 +1497,7 @@ static int ovl_copy_up_flags(struct dentry *dentry, int flags)
 		struct dentry *next;
 		struct dentry *parent = NULL;
 
-		if (ovl_already_copied_up(dentry, flags))
+		if (ovl_copied_up(dentry, flags, lazy))
 			break;
 
 		next = dget(dentry);
@@ -1057,7 +1512,7 @@ static int ovl_copy_up_flags(struct dentry *dentry, int flags)
 			next = parent;
 		}
 
-		err = ovl_copy_up_one(parent, next, flags);
+		err = ovl_copy_up_one(parent, next, flags, lazy);
 
 		dput(parent);
 		dput(next);
@@ -1070,7 +1525,7 @@ static int ovl_copy_up_flags(struct dentry *dentry, int flags)
 static bool ovl_open_need_copy_up(struct dentry *dentry, int flags)
 {
 	/* Copy up of disconnected dentry does not set upper alias */
-	if (ovl_already_copied_up(dentry, flags))
+	if (ovl_copied_up(dentry, flags, true))
 		return false;
 
 	if (special_file(d_inode(dentry)->i_mode))
@@ -1089,7 +1544,7 @@ int ovl_maybe_copy_up(struct dentry *dentry, int flags)
 	if (ovl_open_need_copy_up(dentry, flags)) {
 		err = ovl_want_write(dentry);
 		if (!err) {
-			err = ovl_copy_up_flags(dentry, flags);
+			err = ovl_copy_up_flags(dentry, flags, true);
 			ovl_drop_write(dentry);
 		}
 	}
@@ -1099,10 +1554,10 @@ int ovl_maybe_copy_up(struct dentry *dentry, int flags)
 
 int ovl_copy_up_with_data(struct dentry *dentry)
 {
-	return ovl_copy_up_flags(dentry, O_WRONLY);
+	return ovl_copy_up_flags(dentry, O_WRONLY, false);
 }
 
 int ovl_copy_up(struct dentry *dentry)
 {
-	return ovl_copy_up_flags(dentry, 0);
+	return ovl_copy_up_flags(dentry, 0, false);
 }
@@ -101,6 +101,15 @@ static int ovl_change_flags(struct file *file, unsigned int flags)
 	return 0;
 }
 
+/* Upper holds the data of a file with a data copy up in progress */
+static void ovl_path_realfile(struct dentry *dentry, struct path *path)
+{
+	if (ovl_partial(d_inode(dentry)))
+		ovl_path_upper(dentry, path);
+	else
+		ovl_path_realdata(dentry, path);
+}
+
 static int ovl_real_fdget_meta(const struct file *file, struct fd *real,
 			       bool allow_meta)
 {
@@ -113,7 +122,7 @@ static int ovl_real_fdget_meta(const struct file *file, struct fd *real,
 	if (allow_meta)
 		ovl_path_real(dentry, &realpath);
 	else
-		ovl_path_realdata(dentry, &realpath);
+		ovl_path_realfile(dentry, &realpath);
 
 	/* Has it been copied up since we'd opened it? */
 	if (unlikely(file_inode(real->file) != d_inode(realpath.dentry))) {
@@ -150,13 +159,15 @@ static int ovl_open(struct inode *inode, struct file *file)
 	int err;
 
 	err = ovl_maybe_copy_up(dentry, file->f_flags);
+	if (!err)
+		err = ovl_partial_init(dentry);
 	if (err)
 		return err;
 
 	/* No longer need these flags, so don't pass them on to underlying fs */
 	file->f_flags &= ~(O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC);
 
-	ovl_path_realdata(dentry, &realpath);
+	ovl_path_realfile(dentry, &realpath);
 	realfile = ovl_open_realfile(file, &realpath);
 	if (IS_ERR(realfile))
 		return PTR_ERR(realfile);
@@ -192,6 +203,12 @@ static loff_t ovl_llseek(struct file *file, loff_t offset, int whence)
 			return vfs_setpos(file, 0, 0);
 	}
 
+	/* Chunks not copied up yet are holes in upper, call it all data */
+	if ((whence == SEEK_DATA || whence == SEEK_HOLE) && ovl_partial(inode))
+		return generic_file_llseek_size(file, offset, whence,
+						inode->i_sb->s_maxbytes,
+						i_size_read(inode));
+
 	ret = ovl_real_fdget(file, &real);
 	if (ret)
 		return ret;
@@ -293,9 +310,51 @@ static void ovl_aio_rw_complete(struct kiocb *iocb, long res)
 	orig_iocb->ki_complete(orig_iocb, res);
 }
 
+/*
+ * Read from a file with a data copy up in progress: each run of chunks is
+ * read from upper if copied up, from lower if not.
+ */
+static ssize_t ovl_partial_read_iter(struct ovl_partial *p, struct file *upper,
+				     struct kiocb *iocb, struct iov_iter *iter)
+{
+	unsigned int shift = p->xattr.chunk_shift;
+	rwf_t flags = ovl_iocb_to_rwf(iocb->ki_flags);
+	ssize_t ret = 0, done = 0;
+
+	while (iov_iter_count(iter)) {
+		size_t count = iov_iter_count(iter), len = count;
+		unsigned long chunk = iocb->ki_pos >> shift, next;
+		struct file *realfile = upper;
+
+		if (!ovl_partial_copied(p, chunk)) {
+			realfile = p->lower;
+			next = find_next_bit_le(p->xattr.map, p->nr_chunks, chunk);
+		} else if (chunk < p->nr_chunks) {
+			next = find_next_zero_bit_le(p->xattr.map, p->nr_chunks,
+						     chunk);
+		} else {
+			next = ULONG_MAX;
+		}
+		if (next < p->nr_chunks || realfile == p->lower)
+			len = min_t(u64, len, ((u64)next << shift) - iocb->ki_pos);
+
+		iov_iter_truncate(iter, len);
+		ret = vfs_iter_read(realfile, iter, &iocb->ki_pos, flags);
+		iov_iter_reexpand(iter, count - max_t(ssize_t, ret, 0));
+		if (ret <= 0)
+			break;
+		done += ret;
+		if (ret < len)
+			break;
+	}
+
+	return done ?: ret;
+}
+
 static ssize_t ovl_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 {
 	struct file *file = iocb->ki_filp;
+	struct ovl_partial *p;
 	struct fd real;
 	const struct cred *old_cred;
 	ssize_t ret;
@@ -313,7 +372,11 @@ static ssize_t ovl_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 		goto out_fdput;
 
 	old_cred = ovl_override_creds(file_inode(file)->i_sb);
-	if (is_sync_kiocb(iocb)) {
+	p = ovl_partial(file_inode(file));
+	if (p && file_inode(real.file) == ovl_inode_upper(file_inode(file))) {
+		/* Split into reads from both layers, always synchronously */
+		ret = ovl_partial_read_iter(p, real.file, iocb, iter);
+	} else if (is_sync_kiocb(iocb)) {
 		ret = vfs_iter_read(real.file, iter, &iocb->ki_pos,
 				    ovl_iocb_to_rwf(iocb->ki_flags));
 	} else {
@@ -371,6 +434,12 @@ static ssize_t ovl_write_iter(struct kiocb *iocb, struct iov_iter *iter)
 	    !(real.file->f_mode & FMODE_CAN_ODIRECT))
 		goto out_fdput;
 
+	ret = ovl_partial_copy_up(file, (ifl & IOCB_APPEND) ?
+				  i_size_read(inode) : iocb->ki_pos,
+				  iov_iter_count(iter));
+	if (ret)
+		goto out_fdput;
+
 	if (!ovl_should_sync(OVL_FS(inode->i_sb)))
 		ifl &= ~(IOCB_DSYNC | IOCB_SYNC);
 
@@ -443,6 +512,12 @@ static ssize_t ovl_splice_write(struct pipe_inode_info *pipe, struct file *out,
 	if (ret)
 		goto out_unlock;
 
+	ret = ovl_partial_copy_up(out, *ppos, len);
+	if (ret) {
+		fdput(real);
+		goto out_unlock;
+	}
+
 	old_cred = ovl_override_creds(inode->i_sb);
 	file_start_write(real.file);
 
@@ -492,6 +567,13 @@ static int ovl_mmap(struct file *file, struct vm_area_struct *vma)
 	const struct cred *old_cred;
 	int ret;
 
+	/*
+	 * A mapping of upper would miss the chunks not copied up yet, and
+	 * finishing the copy up here would nest i_rwsem in mmap_lock.
+	 */
+	if (ovl_partial(file_inode(file)))
+		return -EAGAIN;
+
 	if (!realfile->f_op->mmap)
 		return -ENODEV;
 
@@ -526,6 +608,10 @@ static long ovl_fallocate(struct file *file, int mode, loff_t offset, loff_t len
 	if (ret)
 		goto out_unlock;
 
+	ret = ovl_partial_copy_up(file, offset, len);
+	if (ret)
+		goto out_fdput;
+
 	old_cred = ovl_override_creds(file_inode(file)->i_sb);
 	ret = vfs_fallocate(real.file, mode, offset, len);
 	revert_creds(old_cred);
@@ -533,6 +619,7 @@ static long ovl_fallocate(struct file *file, int mode, loff_t offset, loff_t len
 	/* Update size */
 	ovl_copyattr(inode);
 
+out_fdput:
 	fdput(real);
 
 out_unlock:
@@ -584,6 +671,13 @@ static loff_t ovl_copyfile(struct file *file_in, loff_t pos_in,
 			goto out_unlock;
 	}
 
+	/* Both ranges must be in upper before the real files see them */
+	ret = ovl_partial_copy_up(file_out, pos_out, len);
+	if (!ret)
+		ret = ovl_partial_copy_up(file_in, pos_in, len);
+	if (ret)
+		goto out_unlock;
+
 	ret = ovl_real_fdget(file_out, &real_out);
 	if (ret)
 		goto out_unlock;
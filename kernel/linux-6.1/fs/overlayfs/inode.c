@@ -572,6 +572,10 @@ static int ovl_fiemap(struct inode *inode, struct fiemap_extent_info *fieinfo,
 	struct inode *realinode = ovl_inode_realdata(inode);
 	const struct cred *old_cred;
 
+	/* The data is spread over both layers during a lazy data copy up */
+	if (ovl_partial(inode))
+		return -EOPNOTSUPP;
+
 	if (!realinode->i_op->fiemap)
 		return -EOPNOTSUPP;
 
@@ -8,6 +8,7 @@
 #include <linux/uuid.h>
 #include <linux/fs.h>
 #include <linux/namei.h>
+#include <linux/workqueue.h>
 #include "ovl_entry.h"
 
 #undef pr_fmt
@@ -36,6 +37,7 @@ enum ovl_xattr {
 	OVL_XATTR_UPPER,
 	OVL_XATTR_METACOPY,
 	OVL_XATTR_PROTATTR,
+	OVL_XATTR_PARTIAL,
 };
 
 enum ovl_inode_flag {
@@ -47,6 +49,8 @@ enum ovl_inode_flag {
 	OVL_UPPERDATA,
 	/* Inode number will remain constant over copy up. */
 	OVL_CONST_INO,
+	/* Upper has no partial xattr, see ovl_partial_load() */
+	OVL_PARTIAL_CHECKED,
 };
 
 enum ovl_entry_flag {
@@ -112,6 +116,34 @@ struct ovl_fh {
 	};
 } __packed;
 
+/*
+ * On-disk format for "partial" xattr, set on a metacopy upper file while
+ * its data is copied up chunk by chunk (lazycopy=on): map has one bit per
+ * chunk of the lower data, set once the chunk has been copied to upper.
+ */
+#define OVL_PARTIAL_VERSION	0
+
+struct ovl_partial_xattr {
+	u8 version;	/* 0 */
+	u8 chunk_shift;	/* log2 of the chunk size */
+	u8 padding[2];
+	__le32 nr_chunks;
+	u8 map[];	/* little endian bitmap */
+} __packed;
+
+/* In-memory state of a lazy data copy up, see copy_up.c */
+struct ovl_partial {
+	struct work_struct work;	/* copies the rest in the background */
+	struct inode *inode;
+	struct file *lower;		/* lower data, for chunks not copied */
+	loff_t size;			/* of the lower data */
+	unsigned long nr_chunks;
+	unsigned long nr_copied;
+	bool stop;
+	/* map must be long aligned for the bitops */
+	struct ovl_partial_xattr xattr __aligned(sizeof(long));
+};
+
 #define OVL_FH_WIRE_OFFSET	offsetof(struct ovl_fh, fb)
 #define OVL_FH_LEN(fh)		(OVL_FH_WIRE_OFFSET + (fh)->fb.len)
 #define OVL_FH_FID_OFFSET	(OVL_FH_WIRE_OFFSET + \
@@ -687,6 +719,25 @@ int ovl_fileattr_set(struct user_namespace *mnt_userns,
 int ovl_copy_up(struct dentry *dentry);
 int ovl_copy_up_with_data(struct dentry *dentry);
 int ovl_maybe_copy_up(struct dentry *dentry, int flags);
+int ovl_partial_init(struct dentry *dentry);
+int ovl_partial_copy_up(struct file *file, loff_t pos, u64 len);
+void ovl_partial_free(struct ovl_partial *p);
+
+/* Data copy up in progress? Caller reads chunks not copied from lower */
+static inline struct ovl_partial *ovl_partial(struct inode *inode)
+{
+	if (ovl_has_upperdata(inode))
+		return NULL;
+
+	/* Pairs with smp_store_release() in ovl_partial_publish() */
+	return smp_load_acquire(&OVL_I(inode)->partial);
+}
+
+static inline bool ovl_partial_copied(struct ovl_partial *p,
+				      unsigned long chunk)
+{
+	return chunk >= p->nr_chunks || test_bit_le(chunk, p->xattr.map);
+}
 int ovl_copy_xattr(struct super_block *sb, const struct path *path, struct dentry *new);
 int ovl_set_attr(struct ovl_fs *ofs, struct dentry *upper, struct kstat *stat);
 struct ovl_fh *ovl_encode_real_fh(struct ovl_fs *ofs, struct dentry *real,
@@ -18,6 +18,7 @@ struct ovl_config {
 	bool nfs_export;
 	int xino;
 	bool metacopy;
+	bool lazycopy;
 	bool userxattr;
 	bool ovl_volatile;
 };
@@ -144,6 +145,7 @@ struct ovl_inode {
 	struct inode vfs_inode;
 	struct dentry *__upperdentry;
 	struct ovl_path lowerpath;
+	struct ovl_partial *partial;	/* regular file, lazy copy up */
 
 	/* synchronize copy up and more */
 	struct mutex lock;
@@ -193,6 +193,7 @@ static struct inode *ovl_alloc_inode(struct super_block *sb)
 	oi->lowerpath.dentry = NULL;
 	oi->lowerpath.layer = NULL;
 	oi->lowerdata = NULL;
+	oi->partial = NULL;
 	mutex_init(&oi->lock);
 
 	return &oi->vfs_inode;
@@ -213,10 +214,13 @@ static void ovl_destroy_inode(struct inode *inode)
 
 	dput(oi->__upperdentry);
 	dput(oi->lowerpath.dentry);
-	if (S_ISDIR(inode->i_mode))
+	if (S_ISDIR(inode->i_mode)) {
 		ovl_dir_cache_free(inode);
-	else
+	} else {
+		if (oi->partial)
+			ovl_partial_free(oi->partial);
 		iput(oi->lowerdata);
+	}
 }
 
 static void ovl_free_fs(struct ovl_fs *ofs)
@@ -387,6 +391,8 @@ static int ovl_show_options(struct seq_file *m, struct dentry *dentry)
 	if (ofs->config.metacopy != ovl_metacopy_def)
 		seq_printf(m, ",metacopy=%s",
 			   ofs->config.metacopy ? "on" : "off");
+	if (ofs->config.lazycopy)
+		seq_puts(m, ",lazycopy=on");
 	if (ofs->config.ovl_volatile)
 		seq_puts(m, ",volatile");
 	if (ofs->config.userxattr)
@@ -445,6 +451,8 @@ enum {
 	OPT_XINO_AUTO,
 	OPT_METACOPY_ON,
 	OPT_METACOPY_OFF,
+	OPT_LAZYCOPY_ON,
+	OPT_LAZYCOPY_OFF,
 	OPT_VOLATILE,
 	OPT_ERR,
 };
@@ -467,6 +475,8 @@ static const match_table_t ovl_tokens = {
 	{OPT_XINO_AUTO,			"xino=auto"},
 	{OPT_METACOPY_ON,		"metacopy=on"},
 	{OPT_METACOPY_OFF,		"metacopy=off"},
+	{OPT_LAZYCOPY_ON,		"lazycopy=on"},
+	{OPT_LAZYCOPY_OFF,		"lazycopy=off"},
 	{OPT_VOLATILE,			"volatile"},
 	{OPT_ERR,			NULL}
 };
@@ -620,6 +630,14 @@ static int ovl_parse_opt(char *opt, struct ovl_config *config)
 			metacopy_opt = true;
 			break;
 
+		case OPT_LAZYCOPY_ON:
+			config->lazycopy = true;
+			break;
+
+		case OPT_LAZYCOPY_OFF:
+			config->lazycopy = false;
+			break;
+
 		case OPT_VOLATILE:
 			config->ovl_volatile = true;
 			break;
@@ -753,6 +771,12 @@ static int ovl_parse_opt(char *opt, struct ovl_config *config)
 		config->metacopy = false;
 	}
 
+	/* Lazy data copy up keeps the lower data of metacopy files */
+	if (config->lazycopy && !config->metacopy) {
+		pr_err("option \"lazycopy=on\" requires \"metacopy=on\"\n");
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -1439,6 +1463,7 @@ static int ovl_make_workdir(struct super_block *sb, struct ovl_fs *ofs,
 		if (ofs->config.index || ofs->config.metacopy) {
 			ofs->config.index = false;
 			ofs->config.metacopy = false;
+			ofs->config.lazycopy = false;
 			pr_warn("...falling back to index=off,metacopy=off.\n");
 		}
 		/*
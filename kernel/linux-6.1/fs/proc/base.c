@@ -3271,6 +3271,70 @@ static int proc_pid_ksm_stat(struct seq_file *m, struct pid_namespace *ns,
 
 	return 0;
 }
+
+static ssize_t proc_ksm_scan_interval_read(struct file *file, char __user *buf,
+					   size_t count, loff_t *ppos)
+{
+	struct task_struct *task = get_proc_task(file_inode(file));
+	struct mm_struct *mm;
+	char buffer[PROC_NUMBUF];
+	size_t len;
+	int ret;
+
+	if (!task)
+		return -ESRCH;
+
+	ret = 0;
+	mm = get_task_mm(task);
+	if (mm) {
+		len = snprintf(buffer, sizeof(buffer), "%u\n",
+			       max(READ_ONCE(mm->ksm_scan_interval), 1U));
+		mmput(mm);
+		ret = simple_read_from_buffer(buf, count, ppos, buffer, len);
+	}
+
+	put_task_struct(task);
+
+	return ret;
+}
+
+static ssize_t proc_ksm_scan_interval_write(struct file *file,
+					    const char __user *buf,
+					    size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	struct mm_struct *mm;
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint_from_user(buf, count, 0, &val);
+	if (ret < 0)
+		return ret;
+
+	task = get_proc_task(file_inode(file));
+	if (!task)
+		return -ESRCH;
+
+	mm = get_task_mm(task);
+	if (mm) {
+		WRITE_ONCE(mm->ksm_scan_interval, val);
+		mmput(mm);
+	} else {
+		ret = -ESRCH;
+	}
+
+	put_task_struct(task);
+
+	if (ret < 0)
+		return ret;
+	return count;
+}
+
+static const struct file_operations proc_ksm_scan_interval_operations = {
+	.read		= proc_ksm_scan_interval_read,
+	.write		= proc_ksm_scan_interval_write,
+	.llseek		= generic_file_llseek,
+};
 #endif /* CONFIG_KSM */
 
 #ifdef CONFIG_STACKLEAK_METRICS
@@ -3407,6 +3471,7 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_KSM
 	ONE("ksm_merging_pages",  S_IRUSR, proc_pid_ksm_merging_pages),
 	ONE("ksm_stat",  S_IRUSR, proc_pid_ksm_stat),
+	REG("ksm_scan_interval", S_IRUGO|S_IWUSR, proc_ksm_scan_interval_operations),
 #endif
 };
 
@@ -3746,6 +3811,7 @@ static const struct pid_entry tid_base_stuff[] = {
 #ifdef CONFIG_KSM
 	ONE("ksm_merging_pages",  S_IRUSR, proc_pid_ksm_merging_pages),
 	ONE("ksm_stat",  S_IRUSR, proc_pid_ksm_stat),
+	REG("ksm_scan_interval", S_IRUGO|S_IWUSR, proc_ksm_scan_interval_operations),
 #endif
 };
 
@@ -34,6 +34,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -533,6 +534,74 @@ out:
 	return error;
 }
 
+/* Decompress one datablock straight into its locked page cache pages */
+static void squashfs_readahead_read(struct inode *inode, u64 block, int bsize,
+	struct page **pages, unsigned int nr_pages, unsigned int expected)
+{
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	loff_t file_end = i_size_read(inode) >> msblk->block_log;
+	pgoff_t index = pages[0]->index >> (msblk->block_log - PAGE_SHIFT);
+	struct squashfs_page_actor *actor;
+	struct page *last_page;
+	int i, res;
+
+	actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
+						 expected);
+	if (!actor)
+		goto out;
+
+	res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
+
+	last_page = squashfs_page_actor_free(actor);
+
+	if (res == expected) {
+		int bytes;
+
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = res % PAGE_SIZE;
+		if (index == file_end && bytes && last_page)
+			memzero_page(last_page, bytes,
+				     PAGE_SIZE - bytes);
+
+		for (i = 0; i < nr_pages; i++) {
+			flush_dcache_page(pages[i]);
+			SetPageUptodate(pages[i]);
+		}
+	}
+
+out:
+	/* The inode may go away once the last page is unlocked */
+	for (i = 0; i < nr_pages; i++) {
+		unlock_page(pages[i]);
+		put_page(pages[i]);
+	}
+}
+
+/*
+ * With more than one decompressor, the datablocks of a readahead window
+ * after the first are decompressed by workers on other CPUs while the
+ * reader decompresses the first, which holds the page it is waiting for.
+ */
+struct squashfs_readahead_work {
+	struct work_struct	work;
+	struct inode		*inode;
+	u64			block;
+	int			bsize;
+	unsigned int		nr_pages;
+	unsigned int		expected;
+	struct page		*pages[];
+};
+
+static void squashfs_readahead_workfn(struct work_struct *work)
+{
+	struct squashfs_readahead_work *ra = container_of(work,
+		struct squashfs_readahead_work, work);
+
+	squashfs_readahead_read(ra->inode, ra->block, ra->bsize, ra->pages,
+				ra->nr_pages, ra->expected);
+	kfree(ra);
+}
+
 static void squashfs_readahead(struct readahead_control *ractl)
 {
 	struct inode *inode = ractl->mapping->host;
@@ -541,7 +610,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
 	loff_t start = readahead_pos(ractl) & ~mask;
 	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
+	struct squashfs_readahead_work *ra, *first = NULL;
+	bool parallel = squashfs_max_decompressors() > 1;
 	unsigned int nr_pages = 0;
 	struct page **pages;
 	int i;
@@ -559,7 +629,6 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		int res, bsize;
 		u64 block = 0;
 		unsigned int expected;
-		struct page *last_page;
 
 		expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
@@ -592,44 +661,38 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (bsize == 0)
 			goto skip_pages;
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							 expected);
-		if (!actor)
-			goto skip_pages;
-
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-
-		last_page = squashfs_page_actor_free(actor);
-
-		if (res == expected) {
-			int bytes;
-
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (index == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
-
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
+		ra = parallel ? kmalloc(struct_size(ra, pages, nr_pages),
+					GFP_KERNEL) : NULL;
+		if (!ra) {
+			squashfs_readahead_read(inode, block, bsize, pages,
+						nr_pages, expected);
+			continue;
 		}
 
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
-		}
+		INIT_WORK(&ra->work, squashfs_readahead_workfn);
+		ra->inode = inode;
+		ra->block = block;
+		ra->bsize = bsize;
+		ra->nr_pages = nr_pages;
+		ra->expected = expected;
+		memcpy(ra->pages, pages, nr_pages * sizeof(*pages));
+
+		if (first)
+			queue_work(system_unbound_wq, &ra->work);
+		else
+			first = ra;
 	}
 
-	kfree(pages);
-	return;
+	goto out;
 
 skip_pages:
 	for (i = 0; i < nr_pages; i++) {
 		unlock_page(pages[i]);
 		put_page(pages[i]);
 	}
+out:
+	if (first)
+		squashfs_readahead_workfn(&first->work);
 	kfree(pages);
 }
 
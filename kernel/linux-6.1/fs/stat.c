@@ -215,7 +215,7 @@ int getname_statx_lookup_flags(int flags)
  * 0 will be returned on success, and a -ve error code if unsuccessful.
  */
 static int vfs_statx(int dfd, struct filename *filename, int flags,
-	      struct kstat *stat, u32 request_mask)
+	      struct kstat *stat, u32 request_mask, const struct path *root)
 {
 	struct path path;
 	unsigned int lookup_flags = getname_statx_lookup_flags(flags);
@@ -226,7 +226,8 @@ static int vfs_statx(int dfd, struct filename *filename, int flags,
 		return -EINVAL;
 
 retry:
-	error = filename_lookup(dfd, filename, lookup_flags, &path, NULL);
+	error = filename_lookup(dfd, filename, lookup_flags, &path,
+				(struct path *)root);
 	if (error)
 		goto out;
 
@@ -264,7 +265,7 @@ int vfs_fstatat(int dfd, const char __user *filename,
 	struct filename *name;
 
 	name = getname_flags(filename, getname_statx_lookup_flags(statx_flags), NULL);
-	ret = vfs_statx(dfd, name, statx_flags, stat, STATX_BASIC_STATS);
+	ret = vfs_statx(dfd, name, statx_flags, stat, STATX_BASIC_STATS, NULL);
 	putname(name);
 
 	return ret;
@@ -629,8 +630,9 @@ cp_statx(const struct kstat *stat, struct statx __user *buffer)
 	return copy_to_user(buffer, &tmp, sizeof(tmp)) ? -EFAULT : 0;
 }
 
-int do_statx(int dfd, struct filename *filename, unsigned int flags,
-	     unsigned int mask, struct statx __user *buffer)
+static int __do_statx(int dfd, struct filename *filename, unsigned int flags,
+		      unsigned int mask, struct statx __user *buffer,
+		      const struct path *root)
 {
 	struct kstat stat;
 	int error;
@@ -640,13 +642,31 @@ int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	if ((flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
 		return -EINVAL;
 
-	error = vfs_statx(dfd, filename, flags, &stat, mask);
+	error = vfs_statx(dfd, filename, flags, &stat, mask, root);
 	if (error)
 		return error;
 
 	return cp_statx(&stat, buffer);
 }
 
+int do_statx(int dfd, struct filename *filename, unsigned int flags,
+	     unsigned int mask, struct statx __user *buffer)
+{
+	return __do_statx(dfd, filename, flags, mask, buffer, NULL);
+}
+
+/*
+ * statx() of @filename looked up beneath @root, which the caller holds
+ * a reference to. As with file_open_root(), the walk can't go above
+ * @root, absolute names and symlinks start from it.
+ */
+int do_statx_root(const struct path *root, struct filename *filename,
+		  unsigned int flags, unsigned int mask,
+		  struct statx __user *buffer)
+{
+	return __do_statx(AT_FDCWD, filename, flags, mask, buffer, root);
+}
+
 /**
  * sys_statx - System call to get enhanced stats
  * @dfd: Base directory to pathwalk from *or* fd to stat.
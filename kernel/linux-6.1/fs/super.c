@@ -161,6 +161,7 @@ static void destroy_super_work(struct work_struct *work)
 
 	for (i = 0; i < SB_FREEZE_LEVELS; i++)
 		percpu_free_rwsem(&s->s_writers.rw_sem[i]);
+	percpu_counter_destroy(&s->s_nr_dentry_negative);
 	kfree(s);
 }
 
@@ -271,6 +272,9 @@ static struct super_block *alloc_super(struct file_system_type *type, int flags,
 		goto fail;
 	if (list_lru_init_memcg(&s->s_inode_lru, &s->s_shrink))
 		goto fail;
+	if (percpu_counter_init(&s->s_nr_dentry_negative, 0, GFP_KERNEL))
+		goto fail;
+	INIT_WORK(&s->s_negative_work, prune_negative_dentries);
 	return s;
 
 fail:
@@ -336,6 +340,7 @@ void deactivate_locked_super(struct super_block *s)
 		 * put_super(), where we hold the sb_lock. Therefore we destroy
 		 * the lru lists right now.
 		 */
+		cancel_work_sync(&s->s_negative_work);
 		list_lru_destroy(&s->s_dentry_lru);
 		list_lru_destroy(&s->s_inode_lru);
 
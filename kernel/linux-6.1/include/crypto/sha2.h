@@ -115,6 +115,11 @@ static inline void sha256_init(struct sha256_state *sctx)
 void sha256_update(struct sha256_state *sctx, const u8 *data, unsigned int len);
 void sha256_final(struct sha256_state *sctx, u8 *out);
 void sha256(const u8 *data, unsigned int len, u8 *out);
+void sha256_mb(const u8 *const data[], unsigned int len, u8 *const out[],
+	       unsigned int nr);
+/* Hashes a prefix of the messages, returns how many; see sha256_mb() */
+unsigned int sha256_mb_arch(const u8 *const data[], unsigned int len,
+			    u8 *const out[], unsigned int nr);
 
 static inline void sha224_init(struct sha256_state *sctx)
 {
@@ -373,6 +373,17 @@ struct blk_mq_hw_ctx {
 	 */
 	unsigned int		dispatch_busy;
 
+	/**
+	 * @poll_lat: Average completion time of polled reads and writes on
+	 * this queue in ns, as an EWMA. Collected while hybrid polling is on.
+	 */
+	unsigned long		poll_lat[2];
+	/**
+	 * @poll_sleep: Fraction of @poll_lat that hybrid polling sleeps for
+	 * before it spins, in 1/1024 units. Learned from what the wakeups find.
+	 */
+	unsigned int		poll_sleep;
+
 	/** @type: HCTX_TYPE_* flags. Type of hardware queue. */
 	unsigned short		type;
 	/** @nr_ctx: Number of software queues. */
@@ -1512,6 +1512,7 @@ int sync_blockdev_nowait(struct block_device *bdev);
 void sync_bdevs(bool wait);
 void bdev_statx_dioalign(struct inode *inode, struct kstat *stat);
 void printk_all_partitions(void);
+bool bdev_buffer_heads(struct block_device *bdev);
 #else
 static inline void invalidate_bdev(struct block_device *bdev)
 {
@@ -7,6 +7,7 @@
 
 struct bpf_mem_cache;
 struct bpf_mem_caches;
+struct seq_file;
 
 struct bpf_mem_alloc {
 	struct bpf_mem_caches __percpu *caches;
@@ -16,6 +17,8 @@ struct bpf_mem_alloc {
 
 int bpf_mem_alloc_init(struct bpf_mem_alloc *ma, int size, bool percpu);
 void bpf_mem_alloc_destroy(struct bpf_mem_alloc *ma);
+void bpf_mem_alloc_show_fdinfo(struct bpf_mem_alloc *ma, const char *prefix,
+			       struct seq_file *m);
 
 /* kmalloc/kfree equivalent: */
 void *bpf_mem_alloc(struct bpf_mem_alloc *ma, size_t size);
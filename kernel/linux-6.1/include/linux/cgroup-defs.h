@@ -10,6 +10,7 @@
 
 #include <linux/limits.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/idr.h>
 #include <linux/wait.h>
 #include <linux/mutex.h>
@@ -74,6 +75,9 @@ enum {
 
 	/* Control group has to be killed. */
 	CGRP_KILL,
+
+	/* Queued for the deferred rstat flush, see cgroup_rstat_flush_bounded(). */
+	CGRP_RSTAT_DEFERRED,
 };
 
 /* cgroup_root->flags */
@@ -477,6 +481,13 @@ struct cgroup {
 	struct cgroup_rstat_cpu __percpu *rstat_cpu;
 	struct list_head rstat_css_list;
 
+	/*
+	 * jiffies_64 at the start of the last completed flush rooted here,
+	 * and the link on the deferred flush list.
+	 */
+	u64 rstat_flushed;
+	struct llist_node rstat_defer_node;
+
 	/* cgroup basic resource statistics */
 	struct cgroup_base_stat last_bstat;
 	struct cgroup_base_stat bstat;
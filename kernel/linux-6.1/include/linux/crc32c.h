@@ -6,6 +6,11 @@
 
 extern u32 crc32c(u32 crc, const void *address, unsigned int length);
 extern const char *crc32c_impl(void);
+extern void crc32c_mb(u32 crc[], const u8 *const data[], unsigned int length,
+		      unsigned int nr);
+/* Advances a prefix of the CRCs, returns how many; see crc32c_mb() */
+extern unsigned int crc32c_mb_arch(u32 crc[], const u8 *const data[],
+				   unsigned int length, unsigned int nr);
 
 /* This macro exists for backwards-compatibility. */
 #define crc32c_le crc32c
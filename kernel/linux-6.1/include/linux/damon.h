@@ -89,6 +89,10 @@ struct damon_target {
  * @DAMOS_NOHUGEPAGE:	Call ``madvise()`` for the region with MADV_NOHUGEPAGE.
  * @DAMOS_LRU_PRIO:	Prioritize the region on its LRU lists.
  * @DAMOS_LRU_DEPRIO:	Deprioritize the region on its LRU lists.
+ * @DAMOS_ZSWAP:	Page out the anonymous parts of the region while zswap
+ *			can take them, see zswap_can_store().
+ * @DAMOS_PROMOTE:	Migrate the region's lower tier pages to the closest
+ *			top tier node, within their cgroups' memory.promote.max.
  * @DAMOS_STAT:		Do nothing but count the stat.
  * @NR_DAMOS_ACTIONS:	Total number of DAMOS actions
  */
@@ -100,6 +104,8 @@ enum damos_action {
 	DAMOS_NOHUGEPAGE,
 	DAMOS_LRU_PRIO,
 	DAMOS_LRU_DEPRIO,
+	DAMOS_ZSWAP,
+	DAMOS_PROMOTE,
 	DAMOS_STAT,		/* Do nothing but only record the stat */
 	NR_DAMOS_ACTIONS,
 };
@@ -576,6 +582,11 @@ int damon_stop(struct damon_ctx **ctxs, int nr_ctxs);
 int damon_set_region_biggest_system_ram_default(struct damon_target *t,
 				unsigned long *start, unsigned long *end);
 
+#ifdef CONFIG_DAMON_VADDR
+unsigned int damon_va_sample_nids(struct damon_target *t, int *nids,
+		unsigned int nr);
+#endif
+
 #endif	/* CONFIG_DAMON */
 
 #endif	/* _DAMON_H */
@@ -7,6 +7,21 @@
 #include <linux/ftrace.h>
 #include <linux/rethook.h>
 
+struct fprobe;
+
+/**
+ * struct fprobe_site - one probe point of a multi-site fprobe.
+ * @ip: The ftrace location address of the site.
+ * @handler: The entry callback of this site, NULL for the fprobe's one.
+ * @data: Private data of the site, for @handler.
+ */
+struct fprobe_site {
+	unsigned long		ip;
+	void (*handler)(struct fprobe *fp, struct fprobe_site *site,
+			struct pt_regs *regs, void *entry_data);
+	void			*data;
+};
+
 /**
  * struct fprobe - ftrace based probe.
  * @ops: The ftrace_ops.
@@ -15,6 +30,8 @@
  * @rethook: The rethook data structure. (internal data)
  * @entry_data_size: The private data storage size.
  * @nr_maxactive: The max number of active functions.
+ * @sites: The probe points sorted by address, if registered by sites.
+ * @nr_sites: The number of entries of @sites.
  * @entry_handler: The callback function for function entry.
  * @exit_handler: The callback function for function exit.
  */
@@ -33,6 +50,8 @@ struct fprobe {
 	struct rethook		*rethook;
 	size_t			entry_data_size;
 	int			nr_maxactive;
+	struct fprobe_site	*sites;
+	int			nr_sites;
 
 	void (*entry_handler)(struct fprobe *fp, unsigned long entry_ip,
 			      struct pt_regs *regs, void *entry_data);
@@ -63,6 +82,8 @@ static inline bool fprobe_shared_with_kprobes(struct fprobe *fp)
 int register_fprobe(struct fprobe *fp, const char *filter, const char *notfilter);
 int register_fprobe_ips(struct fprobe *fp, unsigned long *addrs, int num);
 int register_fprobe_syms(struct fprobe *fp, const char **syms, int num);
+int register_fprobe_sites(struct fprobe *fp, struct fprobe_site *sites, int num);
+struct fprobe_site *fprobe_site_of(struct fprobe *fp, unsigned long ip);
 int unregister_fprobe(struct fprobe *fp);
 #else
 static inline int register_fprobe(struct fprobe *fp, const char *filter, const char *notfilter)
@@ -77,6 +98,14 @@ static inline int register_fprobe_syms(struct fprobe *fp, const char **syms, int
 {
 	return -EOPNOTSUPP;
 }
+static inline int register_fprobe_sites(struct fprobe *fp, struct fprobe_site *sites, int num)
+{
+	return -EOPNOTSUPP;
+}
+static inline struct fprobe_site *fprobe_site_of(struct fprobe *fp, unsigned long ip)
+{
+	return NULL;
+}
 static inline int unregister_fprobe(struct fprobe *fp)
 {
 	return -EOPNOTSUPP;
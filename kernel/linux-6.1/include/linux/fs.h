@@ -31,6 +31,7 @@
 #include <linux/uidgid.h>
 #include <linux/lockdep.h>
 #include <linux/percpu-rwsem.h>
+#include <linux/percpu_counter.h>
 #include <linux/workqueue.h>
 #include <linux/delayed_call.h>
 #include <linux/uuid.h>
@@ -917,6 +918,9 @@ struct fown_struct {
  * @ra_pages: Maximum size of a readahead request, copied from the bdi.
  * @mmap_miss: How many mmap accesses missed in the page cache.
  * @prev_pos: The last byte in the most recent read request.
+ * @stride_prev: Where the most recent small random read started.
+ * @stride: Number of pages between the last two small random reads.
+ * @stride_hits: How many times in a row @stride has repeated.
  *
  * When this structure is passed to ->readahead(), the "most recent"
  * readahead means the current readahead.
@@ -928,6 +932,9 @@ struct file_ra_state {
 	unsigned int ra_pages;
 	unsigned int mmap_miss;
 	loff_t prev_pos;
+	pgoff_t stride_prev;
+	unsigned int stride;
+	unsigned int stride_hits;
 };
 
 /*
@@ -1586,6 +1593,9 @@ struct super_block {
 	 */
 	struct list_lru		s_dentry_lru;
 	struct list_lru		s_inode_lru;
+	/* unused negative dentries on s_dentry_lru, and their pruning */
+	struct percpu_counter	s_nr_dentry_negative;
+	struct work_struct	s_negative_work;
 	struct rcu_head		rcu;
 	struct work_struct	destroy_work;
 
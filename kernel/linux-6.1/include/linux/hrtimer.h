@@ -138,6 +138,35 @@ struct hrtimer_sleeper {
 	struct task_struct *task;
 };
 
+struct hrtimer_coarse_slot;
+struct hrtimer_coarse_base;
+
+/**
+ * struct hrtimer_coarse - hrtimer for timeouts with generous slack
+ * @timer:	embedded hrtimer, used when no shared slot is available
+ * @entry:	list node in the slot the timer is queued on
+ * @slot:	slot the timer is queued on, NULL if none
+ * @cpu_base:	per cpu coarse base the timer belongs to
+ * @expires:	the absolute earliest expiry time (CLOCK_MONOTONIC)
+ * @slack:	slack in ns the timer was armed with
+ * @function:	timer expiry callback function, runs in softirq context
+ * @flags:	state bits, protected by the lock of @cpu_base
+ *
+ * Coarse timers whose slack allows the same rounded expiry share one
+ * hrtimer, so queueing them is O(1) and never reprograms the clock event
+ * device. The structure must be initialized by hrtimer_coarse_init().
+ */
+struct hrtimer_coarse {
+	struct hrtimer			timer;
+	struct hlist_node		entry;
+	struct hrtimer_coarse_slot	*slot;
+	struct hrtimer_coarse_base	*cpu_base;
+	ktime_t				expires;
+	u64				slack;
+	void				(*function)(struct hrtimer_coarse *);
+	u8				flags;
+};
+
 #ifdef CONFIG_64BIT
 # define __hrtimer_clock_base_align	____cacheline_aligned
 #else
@@ -423,6 +452,14 @@ static inline void hrtimer_start(struct hrtimer *timer, ktime_t tim,
 extern int hrtimer_cancel(struct hrtimer *timer);
 extern int hrtimer_try_to_cancel(struct hrtimer *timer);
 
+/* Slack coalesced timers: */
+extern void hrtimer_coarse_init(struct hrtimer_coarse *timer,
+				void (*function)(struct hrtimer_coarse *));
+extern void hrtimer_coarse_start(struct hrtimer_coarse *timer, ktime_t tim,
+				 u64 slack_ns, const enum hrtimer_mode mode);
+extern int hrtimer_coarse_cancel(struct hrtimer_coarse *timer);
+extern int hrtimer_coarse_try_to_cancel(struct hrtimer_coarse *timer);
+
 static inline void hrtimer_start_expires(struct hrtimer *timer,
 					 enum hrtimer_mode mode)
 {
@@ -608,6 +608,10 @@ generic_hugetlb_get_unmapped_area(struct file *file, unsigned long addr,
  * HPG_vmemmap_optimized - Set when the vmemmap pages of the page are freed.
  * HPG_raw_hwp_unreliable - Set when the hugetlb page has a hwpoison sub-page
  *     that is not tracked by raw_hwp_page list.
+ * HPG_zeroed - Set when a free page has been cleared in the background,
+ *	see hugetlb_prezero_page().  Cleared when the page is freed again.
+ *	Synchronization: hugetlb_lock held for examination and modification
+ *	while the page is on the free lists.
  */
 enum hugetlb_page_flags {
 	HPG_restore_reserve = 0,
@@ -616,6 +620,7 @@ enum hugetlb_page_flags {
 	HPG_freed,
 	HPG_vmemmap_optimized,
 	HPG_raw_hwp_unreliable,
+	HPG_zeroed,
 	__NR_HPAGEFLAGS,
 };
 
@@ -687,6 +692,7 @@ HPAGEFLAG(Temporary, temporary)
 HPAGEFLAG(Freed, freed)
 HPAGEFLAG(VmemmapOptimized, vmemmap_optimized)
 HPAGEFLAG(RawHwpUnreliable, raw_hwp_unreliable)
+HPAGEFLAG(Zeroed, zeroed)
 
 #ifdef CONFIG_HUGETLB_PAGE
 
@@ -38,6 +38,10 @@ struct io_uring_cmd {
 #if defined(CONFIG_IO_URING)
 int io_uring_cmd_import_fixed(u64 ubuf, unsigned long len, int rw,
 			      struct iov_iter *iter, void *ioucmd);
+int io_uring_cmd_import_fixed_vec(const struct iovec __user *uvec,
+				  unsigned long nr_segs, int rw,
+				  struct iov_iter *iter, void *ioucmd,
+				  unsigned int issue_flags);
 void io_uring_cmd_done(struct io_uring_cmd *cmd, ssize_t ret, ssize_t res2,
 			unsigned issue_flags);
 void io_uring_cmd_complete_in_task(struct io_uring_cmd *ioucmd,
@@ -71,6 +75,13 @@ static inline int io_uring_cmd_import_fixed(u64 ubuf, unsigned long len, int rw,
 {
 	return -EOPNOTSUPP;
 }
+static inline int io_uring_cmd_import_fixed_vec(const struct iovec __user *uvec,
+				  unsigned long nr_segs, int rw,
+				  struct iov_iter *iter, void *ioucmd,
+				  unsigned int issue_flags)
+{
+	return -EOPNOTSUPP;
+}
 static inline bool io_is_uring_fops(struct file *file)
 {
 	return false;
@@ -188,6 +188,13 @@ struct io_ev_fd {
 struct io_alloc_cache {
 	struct hlist_head	list;
 	unsigned int		nr_cached;
+	unsigned int		max_cached;
+};
+
+/* per opcode, under ->uring_lock */
+struct io_alloc_cache_stats {
+	unsigned long		hits;
+	unsigned long		misses;
 };
 
 struct io_ring_ctx {
@@ -250,6 +257,11 @@ struct io_ring_ctx {
 		struct list_head	cq_overflow_list;
 		struct io_alloc_cache	apoll_cache;
 		struct io_alloc_cache	netmsg_cache;
+		/* ->async_data of rw, uring_cmd and timeout requests */
+		struct io_alloc_cache	rw_cache;
+		struct io_alloc_cache	uring_cache;
+		struct io_alloc_cache	timeout_cache;
+		struct io_alloc_cache_stats *cache_stats;
 	} ____cacheline_aligned_in_smp;
 
 	/* IRQ completion list, under ->completion_lock */
@@ -352,6 +364,14 @@ struct io_ring_ctx {
 	unsigned			sq_thread_idle;
 	/* protected by ->completion_lock */
 	unsigned			evfd_last_cq_tail;
+
+	/* ring memory pinned from the application, IORING_SETUP_NO_MMAP */
+	struct page			**ring_pages;
+	struct page			**sqe_pages;
+	unsigned int			n_ring_pages;
+	unsigned int			n_sqe_pages;
+	/* serializes mmap() of the rings against resizing them */
+	struct mutex			mmap_lock;
 };
 
 enum {
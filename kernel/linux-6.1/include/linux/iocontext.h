@@ -101,6 +101,8 @@ struct io_context {
 	atomic_t active_ref;
 
 	unsigned short ioprio;
+	/* used while ioprio is IOPRIO_CLASS_NONE, see set_task_ioprio_hint() */
+	unsigned short ioprio_hint;
 
 #ifdef CONFIG_BLK_ICQ
 	/* all the fields below are protected by this lock */
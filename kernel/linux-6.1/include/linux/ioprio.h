@@ -46,6 +46,18 @@ static inline int task_nice_ioclass(struct task_struct *task)
 		return IOPRIO_CLASS_BE;
 }
 
+/*
+ * The priority the io context's IO is issued with. A priority set by
+ * ioprio_set() always wins; the hint only fills in for tasks that never
+ * chose a class.
+ */
+static inline unsigned short ioc_ioprio(struct io_context *ioc)
+{
+	if (IOPRIO_PRIO_CLASS(ioc->ioprio) == IOPRIO_CLASS_NONE)
+		return ioc->ioprio_hint;
+	return ioc->ioprio;
+}
+
 #ifdef CONFIG_BLOCK
 int __get_task_ioprio(struct task_struct *p);
 #else
@@ -61,6 +73,7 @@ static inline int get_current_ioprio(void)
 }
 
 extern int set_task_ioprio(struct task_struct *task, int ioprio);
+extern int set_task_ioprio_hint(struct task_struct *task, int ioprio);
 
 #ifdef CONFIG_BLOCK
 extern int ioprio_check_cap(int ioprio);
@@ -2,6 +2,7 @@
 #define KVM_DIRTY_RING_H
 
 #include <linux/kvm.h>
+#include <linux/mutex.h>
 
 /**
  * kvm_dirty_ring: KVM internal dirty ring structure
@@ -17,6 +18,8 @@
  *               to allow userspace to harvest all the dirty pages
  * @dirty_gfns:  the array to keep the dirty gfns
  * @index:       index of this dirty ring
+ * @reset_lock:  serializes resets of this ring, which may come from
+ *               several harvesting threads at once
  */
 struct kvm_dirty_ring {
 	u32 dirty_index;
@@ -25,8 +28,12 @@ struct kvm_dirty_ring {
 	u32 soft_limit;
 	struct kvm_dirty_gfn *dirty_gfns;
 	int index;
+	struct mutex reset_lock;
 };
 
+/* A dirty ring entry covers at most a PMD sized huge page */
+#define KVM_DIRTY_RING_MAX_GRANULE_SHIFT	(PMD_SHIFT - PAGE_SHIFT)
+
 #ifndef CONFIG_HAVE_KVM_DIRTY_RING
 /*
  * If CONFIG_HAVE_HVM_DIRTY_RING not defined, kvm_dirty_ring.o should
@@ -75,7 +82,7 @@ u32 kvm_dirty_ring_get_rsvd_entries(void);
 int kvm_dirty_ring_alloc(struct kvm_dirty_ring *ring, int index, u32 size);
 
 /*
- * called with kvm->slots_lock held, returns the number of
+ * called with kvm->slots_lock or kvm->srcu held, returns the number of
  * processed pages.
  */
 int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring);
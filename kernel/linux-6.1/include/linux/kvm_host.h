@@ -779,6 +779,13 @@ struct kvm {
 	bool override_halt_poll_ns;
 	unsigned int max_halt_poll_ns;
 	u32 dirty_ring_size;
+	/*
+	 * log2 of the pages each dirty ring entry stands for, see
+	 * KVM_CAP_DIRTY_LOG_RING_GRANULE.  With a non-zero shift the
+	 * memslot dirty_bitmap has one bit per granule, set while the
+	 * granule sits in a ring waiting to be reset.
+	 */
+	u32 dirty_ring_granule_shift;
 	bool vm_bugged;
 	bool vm_dead;
 
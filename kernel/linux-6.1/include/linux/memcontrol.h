@@ -226,6 +226,17 @@ struct mem_cgroup {
 
 #if defined(CONFIG_MEMCG_KMEM) && defined(CONFIG_ZSWAP)
 	unsigned long zswap_max;
+	/* compression time per second before proactive zswap backs off, ns */
+	u64 zswap_budget;
+	atomic64_t zswap_budget_used;
+	unsigned long zswap_budget_start;
+#endif
+
+#ifdef CONFIG_NUMA
+	/* pages promoted to the top memory tier per second, memory.promote.max */
+	unsigned long promote_max;
+	atomic_long_t promote_used;
+	unsigned long promote_start;
 #endif
 
 	unsigned long soft_limit;
@@ -328,6 +339,8 @@ struct mem_cgroup {
 #ifdef CONFIG_LRU_GEN
 	/* per-memcg mm_struct list */
 	struct lru_gen_mm_list mm_list;
+	/* aging hint, see lru_gen_set_hint() */
+	struct lru_gen_memcg_hint lru_gen_hint;
 #endif
 
 	struct mem_cgroup_per_node *nodeinfo[];
@@ -1853,15 +1866,39 @@ static inline void count_objcg_event(struct obj_cgroup *objcg,
 
 #endif /* CONFIG_MEMCG_KMEM */
 
+#if defined(CONFIG_MEMCG) && defined(CONFIG_NUMA)
+bool mem_cgroup_promote_charge(struct folio *folio);
+#else
+static inline bool mem_cgroup_promote_charge(struct folio *folio)
+{
+	return true;
+}
+#endif
+
 #if defined(CONFIG_MEMCG_KMEM) && defined(CONFIG_ZSWAP)
+bool mem_cgroup_may_zswap(struct mem_cgroup *memcg);
+bool mem_cgroup_zswap_budget_left(struct mem_cgroup *memcg);
 bool obj_cgroup_may_zswap(struct obj_cgroup *objcg);
 void obj_cgroup_charge_zswap(struct obj_cgroup *objcg, size_t size);
+void obj_cgroup_charge_zswap_time(struct obj_cgroup *objcg, u64 ns);
 void obj_cgroup_uncharge_zswap(struct obj_cgroup *objcg, size_t size);
 #else
+static inline bool mem_cgroup_may_zswap(struct mem_cgroup *memcg)
+{
+	return true;
+}
+static inline bool mem_cgroup_zswap_budget_left(struct mem_cgroup *memcg)
+{
+	return true;
+}
 static inline bool obj_cgroup_may_zswap(struct obj_cgroup *objcg)
 {
 	return true;
 }
+static inline void obj_cgroup_charge_zswap_time(struct obj_cgroup *objcg,
+						u64 ns)
+{
+}
 static inline void obj_cgroup_charge_zswap(struct obj_cgroup *objcg,
 					   size_t size)
 {
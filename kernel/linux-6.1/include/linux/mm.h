@@ -623,6 +623,92 @@ struct vm_operations_struct {
 					  unsigned long addr);
 };
 
+#ifdef CONFIG_PER_VMA_LOCK
+static inline void vma_lock_init(struct vm_area_struct *vma)
+{
+	init_rwsem(&vma->vm_lock);
+	vma->vm_lock_seq = -1;
+	vma->detached = false;
+}
+
+/*
+ * Try to read lock @vma for a page fault without taking mmap_lock. This
+ * fails whenever the VMA is, or may soon be, write locked: the caller
+ * then falls back to mmap_lock.
+ */
+static inline bool vma_start_read(struct vm_area_struct *vma)
+{
+	/* Check before locking, to not bounce the lock of a VMA being modified */
+	if (READ_ONCE(vma->vm_lock_seq) == READ_ONCE(vma->vm_mm->mm_lock_seq))
+		return false;
+
+	if (unlikely(!down_read_trylock(&vma->vm_lock)))
+		return false;
+
+	/*
+	 * vm_lock_seq only changes under vm_lock held for write, so this
+	 * check is stable; the acquire pairs with vma_end_write_all().
+	 */
+	if (unlikely(vma->vm_lock_seq == smp_load_acquire(&vma->vm_mm->mm_lock_seq))) {
+		up_read(&vma->vm_lock);
+		return false;
+	}
+	return true;
+}
+
+static inline void vma_end_read(struct vm_area_struct *vma)
+{
+	rcu_read_lock(); /* keeps the VMA around until up_read() returns */
+	up_read(&vma->vm_lock);
+	rcu_read_unlock();
+}
+
+/*
+ * Write lock @vma until mmap_write_unlock(), waiting for the page faults
+ * running under its VMA lock. Must be called with mmap_lock held for
+ * write before the VMA, or the page tables it covers, are modified.
+ */
+static inline void vma_start_write(struct vm_area_struct *vma)
+{
+	int mm_lock_seq;
+
+	mmap_assert_write_locked(vma->vm_mm);
+
+	/* mm_lock_seq cannot change under mmap_lock held for write */
+	mm_lock_seq = READ_ONCE(vma->vm_mm->mm_lock_seq);
+	if (vma->vm_lock_seq == mm_lock_seq)
+		return;
+
+	down_write(&vma->vm_lock);
+	WRITE_ONCE(vma->vm_lock_seq, mm_lock_seq);
+	up_write(&vma->vm_lock);
+}
+
+static inline void vma_assert_write_locked(struct vm_area_struct *vma)
+{
+	mmap_assert_write_locked(vma->vm_mm);
+	VM_BUG_ON_VMA(vma->vm_lock_seq != READ_ONCE(vma->vm_mm->mm_lock_seq), vma);
+}
+
+/* @vma is about to leave the VMA tree */
+static inline void vma_mark_detached(struct vm_area_struct *vma)
+{
+	vma_assert_write_locked(vma);
+	vma->detached = true;
+}
+
+struct vm_area_struct *lock_vma_under_rcu(struct mm_struct *mm,
+					  unsigned long address);
+#else
+static inline void vma_lock_init(struct vm_area_struct *vma) {}
+static inline bool vma_start_read(struct vm_area_struct *vma)
+		{ return false; }
+static inline void vma_end_read(struct vm_area_struct *vma) {}
+static inline void vma_start_write(struct vm_area_struct *vma) {}
+static inline void vma_assert_write_locked(struct vm_area_struct *vma) {}
+static inline void vma_mark_detached(struct vm_area_struct *vma) {}
+#endif /* CONFIG_PER_VMA_LOCK */
+
 static inline void vma_init(struct vm_area_struct *vma, struct mm_struct *mm)
 {
 	static const struct vm_operations_struct dummy_vm_ops = {};
@@ -631,6 +717,19 @@ static inline void vma_init(struct vm_area_struct *vma, struct mm_struct *mm)
 	vma->vm_mm = mm;
 	vma->vm_ops = &dummy_vm_ops;
 	INIT_LIST_HEAD(&vma->anon_vma_chain);
+	vma_lock_init(vma);
+}
+
+/*
+ * Drop the lock a page fault runs under, mmap_lock or the VMA lock, for
+ * handlers that wait for I/O and then return VM_FAULT_RETRY.
+ */
+static inline void release_fault_lock(struct vm_fault *vmf)
+{
+	if (vmf->flags & FAULT_FLAG_VMA_LOCK)
+		vma_end_read(vmf->vma);
+	else
+		mmap_read_unlock(vmf->vma->vm_mm);
 }
 
 static inline void vma_set_anonymous(struct vm_area_struct *vma)
@@ -1731,6 +1830,32 @@ static inline size_t folio_size(struct folio *folio)
 	return PAGE_SIZE << folio_order(folio);
 }
 
+/**
+ * page_span_contiguous - Does a byte range continue another in the folio.
+ * @page: The page the first range starts in.
+ * @offset: Offset of the first range from the start of @page.
+ * @len: Length of the first range.
+ * @next: The page the second range starts in.
+ * @next_offset: Offset of the second range from the start of @next.
+ *
+ * Used to merge page ranges into one pipe buffer or bio_vec; the offsets
+ * may point past the end of their page as long as they stay in the folio.
+ *
+ * Return: true if both ranges are in the same folio and the second one
+ * starts at the byte right after the end of the first.
+ */
+static inline bool page_span_contiguous(struct page *page, size_t offset,
+		size_t len, struct page *next, size_t next_offset)
+{
+	struct folio *folio = page_folio(page);
+
+	if (page_folio(next) != folio)
+		return false;
+
+	return folio_page_idx(folio, page) * PAGE_SIZE + offset + len ==
+	       folio_page_idx(folio, next) * PAGE_SIZE + next_offset;
+}
+
 /**
  * folio_estimated_sharers - Estimate the number of sharers of a folio.
  * @folio: The folio.
@@ -520,6 +520,19 @@ struct vm_area_struct {
 	struct mempolicy *vm_policy;	/* NUMA policy for the VMA */
 #endif
 	struct vm_userfaultfd_ctx vm_userfaultfd_ctx;
+#ifdef CONFIG_PER_VMA_LOCK
+	/*
+	 * Page faults may run under vm_lock instead of mmap_lock, see
+	 * lock_vma_under_rcu(). The VMA is write locked while vm_lock_seq
+	 * equals vm_mm->mm_lock_seq; mmap_write_unlock() bumps the latter,
+	 * unlocking all the VMAs locked since mmap_write_lock() at once.
+	 */
+	int vm_lock_seq;
+	struct rw_semaphore vm_lock;
+	/* Removed from the VMA tree, lock_vma_under_rcu() must not use it */
+	bool detached;
+	struct rcu_head vm_rcu;
+#endif
 } __randomize_layout;
 
 struct kioctx_table;
@@ -549,6 +562,20 @@ struct mm_struct {
 		 * cache-line, which needs to be touched by switch_mm().
 		 */
 		atomic_t membarrier_state;
+
+		/**
+		 * @membarrier_seq: Private expedited IPI waves sent for
+		 * this mm, odd while one is under way. Lets concurrent
+		 * callers share a wave.
+		 */
+		unsigned long membarrier_seq;
+
+		/**
+		 * @membarrier_scoped: Private expedited IPIs only go to
+		 * the calling thread's cpuset, see
+		 * MEMBARRIER_CMD_FLAG_CPUSET.
+		 */
+		bool membarrier_scoped;
 #endif
 
 		/**
@@ -592,6 +619,10 @@ struct mm_struct {
 		 * cacheline.
 		 */
 		struct rw_semaphore mmap_lock;
+#ifdef CONFIG_PER_VMA_LOCK
+		/* Bumped by mmap_write_unlock(), see vm_area_struct::vm_lock_seq */
+		int mm_lock_seq;
+#endif
 
 		struct list_head mmlist; /* List of maybe swapped mm's.	These
 					  * are globally strung together off
@@ -713,6 +744,11 @@ struct mm_struct {
 		 * including merged and not merged.
 		 */
 		unsigned long ksm_rmap_items;
+		/*
+		 * Scan this mm only every ksm_scan_interval passes of ksmd,
+		 * 0 and 1 both meaning every pass.
+		 */
+		unsigned int ksm_scan_interval;
 #endif
 #ifdef CONFIG_LRU_GEN
 		struct {
@@ -977,6 +1013,8 @@ typedef struct {
  *                      mapped R/O.
  * @FAULT_FLAG_ORIG_PTE_VALID: whether the fault has vmf->orig_pte cached.
  *                        We should only access orig_pte if this flag set.
+ * @FAULT_FLAG_VMA_LOCK: The fault is handled under the VMA lock rather than
+ *                       mmap_lock, see lock_vma_under_rcu().
  *
  * About @FAULT_FLAG_ALLOW_RETRY and @FAULT_FLAG_TRIED: we can specify
  * whether we would allow page faults to retry by specifying these two
@@ -1014,6 +1052,7 @@ enum fault_flag {
 	FAULT_FLAG_INTERRUPTIBLE =	1 << 9,
 	FAULT_FLAG_UNSHARE =		1 << 10,
 	FAULT_FLAG_ORIG_PTE_VALID =	1 << 11,
+	FAULT_FLAG_VMA_LOCK =		1 << 12,
 };
 
 typedef unsigned int __bitwise zap_flags_t;
@@ -367,6 +367,17 @@ struct page_vma_mapped_walk;
 #define LRU_GEN_MASK		((BIT(LRU_GEN_WIDTH) - 1) << LRU_GEN_PGOFF)
 #define LRU_REFS_MASK		((BIT(LRU_REFS_WIDTH) - 1) << LRU_REFS_PGOFF)
 
+/* what a memcg's working set is predicted to do, see lru_gen_set_hint() */
+enum lru_gen_hint {
+	/* aged and evicted as the global settings say */
+	LRU_GEN_HINT_NONE,
+	/* in use: keep the generations younger than min_ttl */
+	LRU_GEN_HINT_HOT,
+	/* idle: aged eagerly and evicted ahead of other memcgs */
+	LRU_GEN_HINT_COLD,
+	NR_LRU_GEN_HINTS
+};
+
 #ifdef CONFIG_LRU_GEN
 
 enum {
@@ -475,12 +486,23 @@ struct lru_gen_mm_walk {
 	bool force_scan;
 };
 
+struct lru_gen_memcg_hint {
+	/* enum lru_gen_hint */
+	unsigned int type;
+	/* for LRU_GEN_HINT_HOT, in jiffies */
+	unsigned long min_ttl;
+	/* when the hint lapses in jiffies, 0 for never */
+	unsigned long expires;
+};
+
 void lru_gen_init_lruvec(struct lruvec *lruvec);
 void lru_gen_look_around(struct page_vma_mapped_walk *pvmw);
 
 #ifdef CONFIG_MEMCG
 void lru_gen_init_memcg(struct mem_cgroup *memcg);
 void lru_gen_exit_memcg(struct mem_cgroup *memcg);
+int lru_gen_set_hint(struct mem_cgroup *memcg, enum lru_gen_hint type,
+		     unsigned long min_ttl, unsigned long timeout);
 #endif
 
 #else /* !CONFIG_LRU_GEN */
@@ -501,6 +523,13 @@ static inline void lru_gen_init_memcg(struct mem_cgroup *memcg)
 static inline void lru_gen_exit_memcg(struct mem_cgroup *memcg)
 {
 }
+
+static inline int lru_gen_set_hint(struct mem_cgroup *memcg,
+				   enum lru_gen_hint type,
+				   unsigned long min_ttl, unsigned long timeout)
+{
+	return -EOPNOTSUPP;
+}
 #endif
 
 #endif /* CONFIG_LRU_GEN */
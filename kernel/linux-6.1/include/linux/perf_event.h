@@ -750,6 +750,8 @@ struct perf_event {
 	struct perf_buffer		*rb;
 	struct list_head		rb_entry;
 	unsigned long			rcu_batches;
+	/* PERF_SAMPLE_STACK_ID: ids of the callchains already written */
+	u64				*stack_ids;
 	int				rcu_pending;
 
 	/* poll related */
@@ -1068,6 +1070,7 @@ struct perf_sample_data {
 		u32	reserved;
 	}				cpu_entry;
 	struct perf_callchain_entry	*callchain;
+	u64				stack_id;
 	u64				aux_size;
 
 	struct perf_regs		regs_user;
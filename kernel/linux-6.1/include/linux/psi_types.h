@@ -163,6 +163,13 @@ struct psi_group {
 	struct psi_group *parent;
 	bool enabled;
 
+	/*
+	 * Group the member tasks' states are accounted to: this one, or
+	 * outside the psi_levels= aggregation levels the nearest ancestor
+	 * inside them. parent likewise skips to such an ancestor.
+	 */
+	struct psi_group *account;
+
 	/* Protects data used by the aggregator */
 	struct mutex avgs_lock;
 
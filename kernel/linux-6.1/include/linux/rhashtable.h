@@ -61,11 +61,14 @@ struct rhash_lock_head {};
  */
 #define RHT_ELASTICITY	16u
 
+/* Buckets each insert migrates while a rehash is in progress. */
+#define RHT_REHASH_HELP	2u
+
 /**
  * struct bucket_table - Table of hash buckets
  * @size: Number of hash buckets
  * @nest: Number of bits of first-level nested table.
- * @rehash: Current bucket being rehashed
+ * @rehash: Next bucket to be claimed for rehashing
  * @hash_rnd: Random seed to fold into hash
  * @walkers: List of active walkers
  * @rcu: RCU structure for freeing the table
@@ -77,6 +80,7 @@ struct bucket_table {
 	unsigned int		size;
 	unsigned int		nest;
 	u32			hash_rnd;
+	atomic_t		rehash;
 	struct list_head	walkers;
 	struct rcu_head		rcu;
 
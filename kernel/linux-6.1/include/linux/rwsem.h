@@ -55,6 +55,7 @@ struct rw_semaphore {
 	atomic_long_t owner;
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	struct optimistic_spin_queue osq; /* spinner MCS lock */
+	unsigned int hold_avg;		  /* ns spinners wait for a writer */
 #endif
 	raw_spinlock_t wait_lock;
 	struct list_head wait_list;
@@ -466,6 +466,9 @@ int __sbitmap_queue_get(struct sbitmap_queue *sbq);
  * @nr_tags: number of tags requested
  * @offset: offset to add to returned bits
  *
+ * The tags come from a single word, so fewer than @nr_tags may be returned,
+ * and @nr_tags must not exceed BITS_PER_LONG.
+ *
  * Return: Mask of allocated tags, 0 if none are found. Each tag allocated is
  * a bit in the mask returned, and the caller must add @offset to the value to
  * get the absolute tag value.
@@ -598,6 +598,8 @@ struct sched_rt_entity {
 #endif
 } __randomize_layout;
 
+typedef struct task_struct *(*dl_server_pick_f)(struct sched_dl_entity *);
+
 struct sched_dl_entity {
 	struct rb_node			rb_node;
 
@@ -640,11 +642,20 @@ struct sched_dl_entity {
 	 *
 	 * @dl_overrun tells if the task asked to be informed about runtime
 	 * overruns.
+	 *
+	 * @dl_server tells if this is not a task but a deadline server,
+	 * which runs the tasks of a lower scheduling class when they have
+	 * not had their runtime by the end of the period, see
+	 * dl_server_init().
+	 *
+	 * @dl_server_active tells if the server's class has runnable tasks.
 	 */
 	unsigned int			dl_throttled      : 1;
 	unsigned int			dl_yielded        : 1;
 	unsigned int			dl_non_contending : 1;
 	unsigned int			dl_overrun	  : 1;
+	unsigned int			dl_server         : 1;
+	unsigned int			dl_server_active  : 1;
 
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
@@ -669,6 +680,15 @@ struct sched_dl_entity {
 	 */
 	struct sched_dl_entity *pi_se;
 #endif
+
+	/*
+	 * Deadline servers: the runqueue served, and the callbacks picking
+	 * the next task of the served class. server_pick() also sets it
+	 * up to run, server_pick_task() has no side effects.
+	 */
+	struct rq			*rq;
+	dl_server_pick_f		server_pick;
+	dl_server_pick_f		server_pick_task;
 };
 
 #ifdef CONFIG_UCLAMP_TASK
@@ -723,6 +743,14 @@ enum perf_event_task_context {
 	perf_nr_task_contexts,
 };
 
+/* A sampled lock wait, see kernel/locking/lock_contention.c */
+struct lock_contention_wait {
+	void				*lock;
+	unsigned long			ip;
+	unsigned int			flags;
+	u64				start;
+};
+
 struct wake_q_node {
 	struct wake_q_node *next;
 };
@@ -1150,6 +1178,11 @@ struct task_struct {
 	struct mutex_waiter		*blocked_on;
 #endif
 
+#ifdef CONFIG_LOCK_CONTENTION_PROFILE
+	/* Sampled wait of a sleeping lock: */
+	struct lock_contention_wait	lockprof_wait;
+#endif
+
 #ifdef CONFIG_DEBUG_ATOMIC_SLEEP
 	int				non_block_count;
 #endif
@@ -1484,6 +1517,10 @@ struct task_struct {
 	/* Used for BPF run context */
 	struct bpf_run_ctx		*bpf_ctx;
 #endif
+#ifdef CONFIG_SCHED_AURORA
+	/* Aurora module storage, see linux/sched/aurora.h */
+	void __rcu			*aurora_storage[2];
+#endif
 
 #ifdef CONFIG_GCC_PLUGIN_STACKLEAK
 	unsigned long			lowest_stack;
@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Aurora AI scheduler policy backend.
+ *
+ * A sched_aurora_ops implementation, normally a BPF struct_ops program,
+ * supplies scoring and placement decisions to the Aurora AI scheduler.
+ * At most one implementation is attached at a time; attaching and
+ * detaching is possible at runtime, which allows swapping policies
+ * without reloading the scheduler module.
+ */
+#ifndef _LINUX_SCHED_AURORA_H
+#define _LINUX_SCHED_AURORA_H
+
+#include <linux/errno.h>
+#include <linux/rcupdate.h>
+#include <linux/jump_label.h>
+#include <linux/sched.h>
+#include <linux/types.h>
+
+#define SCHED_AURORA_NAME_LEN	16
+
+/* Dispatch queue selectors returned by sched_aurora_ops::dsq() */
+enum sched_aurora_dsq {
+	SCHED_AURORA_DSQ_LOCAL	= 0,	/* queue on the task's CPU */
+	SCHED_AURORA_DSQ_LLC	= 1,	/* any CPU sharing the LLC */
+};
+
+struct sched_aurora_ops {
+	/*
+	 * Pick a CPU for a waking task. Return a CPU in p->cpus_ptr, or a
+	 * negative value to keep the built-in placement.
+	 */
+	s32 (*select_cpu)(struct task_struct *p, s32 prev_cpu, u64 wake_flags);
+
+	/* Return the ordering score for @p; @score is the built-in value */
+	s64 (*score)(struct task_struct *p, s64 score);
+
+	/* Choose the dispatch queue for @p, see enum sched_aurora_dsq */
+	u32 (*dsq)(struct task_struct *p);
+
+	/* @p starts or stops running on its CPU */
+	void (*running)(struct task_struct *p);
+	void (*stopping)(struct task_struct *p, bool runnable);
+
+	/* Called when the policy is attached and detached */
+	s32 (*init)(void);
+	void (*exit)(void);
+
+	char name[SCHED_AURORA_NAME_LEN];
+};
+
+/*
+ * Wakeup placement hints from the Aurora AI scheduler module, consulted
+ * by select_idle_sibling(). select_idle_hint() returns a preferred CPU
+ * for @p, or a negative value for no preference.
+ */
+struct sched_aurora_wake_ops {
+	int (*select_idle_hint)(struct task_struct *p, int prev, int target);
+};
+
+/*
+ * Runqueue events for the Aurora AI scheduler module, called by the fair
+ * class under the rq lock of @cpu. enqueue() and dequeue() see every
+ * fair enqueue and dequeue; @wakeup and @sleep are set when @p wakes up
+ * or blocks, as opposed to migrating or changing class. pick_hint() may
+ * return a task queued on @cpu to run next, or NULL; it is only made the
+ * next buddy, so CFS runs it only within the wakeup granularity of the
+ * leftmost entity. set_next() and put_prev() bracket each stint of a
+ * fair task on the CPU; @queued tells whether @p stays runnable.
+ * tick() is called from the scheduler tick while a fair task runs.
+ *
+ * fork(), exec() and dead() follow the life of every task, whatever its
+ * class: fork() once the child is fully set up, exec() after a
+ * successful exec, dead() after the task's final context switch. They
+ * run without the rq lock but under rcu_read_lock_sched(), so they must
+ * not sleep.
+ */
+struct sched_aurora_rq_ops {
+	void (*enqueue)(int cpu, struct task_struct *p, bool wakeup);
+	void (*dequeue)(int cpu, struct task_struct *p, bool sleep);
+	struct task_struct *(*pick_hint)(int cpu);
+	void (*set_next)(int cpu, struct task_struct *p);
+	void (*put_prev)(int cpu, struct task_struct *p, bool queued);
+	void (*tick)(int cpu, struct task_struct *curr);
+	void (*fork)(struct task_struct *p);
+	void (*exec)(struct task_struct *p);
+	void (*dead)(struct task_struct *p);
+};
+
+/*
+ * Frequency hints from the Aurora AI scheduler module, consulted by
+ * schedutil whenever it re-evaluates a CPU. util_hint() gets the
+ * utilization schedutil computed for @cpu, out of @max, and returns the
+ * one to select a frequency for: higher ahead of a burst the module
+ * predicts, lower when it expects the CPU to go idle, or @util for no
+ * opinion. schedutil bounds the result, see sugov_aurora_apply(). It
+ * may be called for a remote CPU of a shared policy, without that CPU's
+ * rq lock.
+ */
+struct sched_aurora_freq_ops {
+	unsigned long (*util_hint)(int cpu, unsigned long util, unsigned long max);
+};
+
+/*
+ * Per-task storage for the Aurora modules. Each slot is one pointer in
+ * task_struct owned by one module, in the manner of BPF task local
+ * storage: it is installed with sched_aurora_task_storage_set() and
+ * handed to the slot's registered free() callback when the task is
+ * freed. free() may be called from RCU callback context.
+ */
+enum sched_aurora_storage_slot {
+	SCHED_AURORA_STORAGE_CONTEXT,	/* ai_context_manager process context */
+	SCHED_AURORA_STORAGE_FEATURES,	/* aurora_core shared feature block */
+	SCHED_AURORA_NR_STORAGE,
+};
+
+struct sched_aurora_storage_ops {
+	void (*free)(struct task_struct *p, void *data);
+};
+
+#ifdef CONFIG_SCHED_AURORA
+int sched_aurora_register_wake_ops(struct sched_aurora_wake_ops *ops);
+void sched_aurora_unregister_wake_ops(struct sched_aurora_wake_ops *ops);
+int sched_aurora_register_rq_ops(struct sched_aurora_rq_ops *ops);
+void sched_aurora_unregister_rq_ops(struct sched_aurora_rq_ops *ops);
+void sched_aurora_task_fork(struct task_struct *p);
+void sched_aurora_task_exec(struct task_struct *p);
+void sched_aurora_task_dead(struct task_struct *p);
+
+int sched_aurora_register_storage_ops(enum sched_aurora_storage_slot slot,
+				      struct sched_aurora_storage_ops *ops);
+void sched_aurora_unregister_storage_ops(enum sched_aurora_storage_slot slot,
+					 struct sched_aurora_storage_ops *ops);
+void sched_aurora_task_storage_free(struct task_struct *p);
+
+/* Caller must hold rcu_read_lock() */
+static inline void *sched_aurora_task_storage(struct task_struct *p,
+					      enum sched_aurora_storage_slot slot)
+{
+	return rcu_dereference(p->aurora_storage[slot]);
+}
+
+/* Replace @old with @new; returns false if someone else got there first */
+static inline bool sched_aurora_task_storage_set(struct task_struct *p,
+						 enum sched_aurora_storage_slot slot,
+						 void *old, void *new)
+{
+	return cmpxchg((void **)&p->aurora_storage[slot], old, new) == old;
+}
+#else
+static inline void sched_aurora_task_fork(struct task_struct *p) { }
+static inline void sched_aurora_task_exec(struct task_struct *p) { }
+static inline void sched_aurora_task_dead(struct task_struct *p) { }
+
+static inline int
+sched_aurora_register_storage_ops(enum sched_aurora_storage_slot slot,
+				  struct sched_aurora_storage_ops *ops)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void
+sched_aurora_unregister_storage_ops(enum sched_aurora_storage_slot slot,
+				    struct sched_aurora_storage_ops *ops) { }
+
+static inline void sched_aurora_task_storage_free(struct task_struct *p) { }
+
+static inline void *sched_aurora_task_storage(struct task_struct *p,
+					      enum sched_aurora_storage_slot slot)
+{
+	return NULL;
+}
+
+static inline bool sched_aurora_task_storage_set(struct task_struct *p,
+						 enum sched_aurora_storage_slot slot,
+						 void *old, void *new)
+{
+	return false;
+}
+#endif
+
+#if defined(CONFIG_SCHED_AURORA) && defined(CONFIG_CPU_FREQ_GOV_SCHEDUTIL)
+int sched_aurora_register_freq_ops(struct sched_aurora_freq_ops *ops);
+void sched_aurora_unregister_freq_ops(struct sched_aurora_freq_ops *ops);
+#else
+static inline int sched_aurora_register_freq_ops(struct sched_aurora_freq_ops *ops)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void sched_aurora_unregister_freq_ops(struct sched_aurora_freq_ops *ops) { }
+#endif
+
+/*
+ * Core scheduling isolation for tasks the Aurora security module does
+ * not trust, see sched_aurora_core_isolate() in kernel/sched/core_sched.c.
+ */
+#if defined(CONFIG_SCHED_AURORA) && defined(CONFIG_SCHED_CORE)
+int sched_aurora_core_isolate(struct task_struct *p, bool isolate);
+#else
+static inline int sched_aurora_core_isolate(struct task_struct *p, bool isolate)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
+/*
+ * Interactive grouping from the Aurora context manager, in place of the
+ * TTY session autogroups, see sched_aurora_autogroup_move() in
+ * kernel/sched/autogroup.c. Processes in a shared group compete with
+ * other groups as one entity, like the members of a session autogroup.
+ */
+enum sched_aurora_group {
+	SCHED_AURORA_GROUP_OWN,		/* an autogroup of its own, as after setsid() */
+	SCHED_AURORA_GROUP_FOREGROUND,	/* the active application, boosted */
+	SCHED_AURORA_GROUP_BACKGROUND,	/* batch and indexing work, throttled */
+	SCHED_AURORA_NR_GROUPS,
+};
+
+#if defined(CONFIG_SCHED_AURORA) && defined(CONFIG_SCHED_AUTOGROUP)
+int sched_aurora_autogroup_move(struct task_struct *p, enum sched_aurora_group group);
+enum sched_aurora_group sched_aurora_autogroup_of(struct task_struct *p);
+#else
+static inline int sched_aurora_autogroup_move(struct task_struct *p,
+					      enum sched_aurora_group group)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline enum sched_aurora_group sched_aurora_autogroup_of(struct task_struct *p)
+{
+	return SCHED_AURORA_GROUP_OWN;
+}
+#endif
+
+#ifdef CONFIG_SCHED_AURORA_BPF
+DECLARE_STATIC_KEY_FALSE(sched_aurora_ops_enabled);
+extern struct sched_aurora_ops __rcu *sched_aurora_active_ops;
+
+int sched_aurora_register_ops(struct sched_aurora_ops *ops);
+void sched_aurora_unregister_ops(struct sched_aurora_ops *ops);
+
+/* Caller must hold rcu_read_lock() */
+static inline struct sched_aurora_ops *sched_aurora_ops(void)
+{
+	if (!static_branch_unlikely(&sched_aurora_ops_enabled))
+		return NULL;
+	return rcu_dereference(sched_aurora_active_ops);
+}
+#else
+static inline struct sched_aurora_ops *sched_aurora_ops(void)
+{
+	return NULL;
+}
+#endif
+
+#endif /* _LINUX_SCHED_AURORA_H */
@@ -128,6 +128,12 @@
 #define SLAB_SKIP_KFENCE	0
 #endif
 
+/*
+ * Keep a per cpu array of free objects in front of the slabs, for caches
+ * with a high allocation and free rate (SLUB only, ignored elsewhere).
+ */
+#define SLAB_MAGAZINE		((slab_flags_t __force)0x40000000U)
+
 /* The following flags affect the page allocator grouping pages by mobility */
 /* Objects are reclaimable */
 #define SLAB_RECLAIM_ACCOUNT	((slab_flags_t __force)0x00020000U)
@@ -39,6 +39,10 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_MAGAZINE,		/* Allocation from the cpu magazine */
+	FREE_MAGAZINE,		/* Free to the cpu magazine */
+	MAGAZINE_REFILL,	/* Bulk refill of an empty magazine */
+	MAGAZINE_FLUSH,		/* Bulk flush of a full magazine */
 	NR_SLUB_STAT_ITEMS };
 
 /*
@@ -58,6 +62,20 @@ struct kmem_cache_cpu {
 #endif
 };
 
+/*
+ * Per cpu stack of free objects for SLAB_MAGAZINE caches. Allocation and
+ * free only move a pointer in or out of it; a refill or a flush moves
+ * SLUB_MAGAZINE_BATCH objects from or to the slabs at a time.
+ */
+#define SLUB_MAGAZINE_SIZE	32
+#define SLUB_MAGAZINE_BATCH	(SLUB_MAGAZINE_SIZE / 2)
+
+struct kmem_cache_magazine {
+	local_lock_t lock;	/* Protects the fields below */
+	unsigned int size;	/* Number of objects in the magazine */
+	void *objects[SLUB_MAGAZINE_SIZE];
+};
+
 #ifdef CONFIG_SLUB_CPU_PARTIAL
 #define slub_percpu_partial(c)		((c)->partial)
 
@@ -89,6 +107,8 @@ struct kmem_cache_order_objects {
  */
 struct kmem_cache {
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	/* Only for SLAB_MAGAZINE caches without debugging */
+	struct kmem_cache_magazine __percpu *magazine;
 	/* Used for retrieving partial slabs, etc. */
 	slab_flags_t flags;
 	unsigned long min_partial;
@@ -143,6 +143,11 @@ static inline size_t iov_length(const struct iovec *iov, unsigned long nr_segs)
 
 static inline struct iovec iov_iter_iovec(const struct iov_iter *iter)
 {
+	if (iter_is_ubuf(iter))
+		return (struct iovec) {
+			.iov_base = iter->ubuf + iter->iov_offset,
+			.iov_len = iter->count,
+		};
 	return (struct iovec) {
 		.iov_base = iter->iov->iov_base + iter->iov_offset,
 		.iov_len = min(iter->count,
@@ -338,6 +343,7 @@ ssize_t import_iovec(int type, const struct iovec __user *uvec,
 ssize_t __import_iovec(int type, const struct iovec __user *uvec,
 		 unsigned nr_segs, unsigned fast_segs, struct iovec **iovp,
 		 struct iov_iter *i, bool compat);
+int import_ubuf(int type, void __user *buf, size_t len, struct iov_iter *i);
 int import_single_range(int type, void __user *buf, size_t len,
 		 struct iovec *iov, struct iov_iter *i);
 
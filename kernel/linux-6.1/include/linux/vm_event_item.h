@@ -55,6 +55,7 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		PGINODESTEAL, SLABS_SCANNED, KSWAPD_INODESTEAL,
 		KSWAPD_LOW_WMARK_HIT_QUICKLY, KSWAPD_HIGH_WMARK_HIT_QUICKLY,
 		PAGEOUTRUN, PGROTATED,
+		LRU_BATCH_LOCKS_SAVED, LRU_BATCH_WAIT_NS_SAVED,
 		DROP_PAGECACHE, DROP_SLAB,
 		OOM_KILL,
 #ifdef CONFIG_NUMA_BALANCING
@@ -116,6 +117,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_SWPOUT,
 		THP_SWPOUT_FALLBACK,
 #endif
+#ifdef CONFIG_HUGEPAGE_PREZERO
+		PREZERO_THP_FILL,	/* zeroed THPs added to the pool */
+		PREZERO_THP_FAULT,	/* THP faults served from the pool */
+		PREZERO_HTLB_ZEROED,	/* free hugetlb pages zeroed */
+		PREZERO_HTLB_FAULT,	/* hugetlb faults on a zeroed page */
+#endif
 #ifdef CONFIG_MEMORY_BALLOON
 		BALLOON_INFLATE,
 		BALLOON_DEFLATE,
@@ -146,6 +153,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 #ifdef CONFIG_X86
 		DIRECT_MAP_LEVEL2_SPLIT,
 		DIRECT_MAP_LEVEL3_SPLIT,
+#endif
+#ifdef CONFIG_PER_VMA_LOCK
+		VMA_LOCK_SUCCESS,	/* fault handled under the VMA lock */
+		VMA_LOCK_ABORT,		/* VMA not usable, fell back to mmap_lock */
+		VMA_LOCK_RETRY,		/* handler needed mmap_lock */
+		VMA_LOCK_MISS,		/* VMA changed under us */
 #endif
 		NR_VM_EVENT_ITEMS
 };
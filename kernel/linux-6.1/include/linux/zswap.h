@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_ZSWAP_H
+#define _LINUX_ZSWAP_H
+
+#include <linux/types.h>
+
+struct mem_cgroup;
+
+#ifdef CONFIG_ZSWAP
+bool zswap_can_store(struct mem_cgroup *memcg);
+#else
+static inline bool zswap_can_store(struct mem_cgroup *memcg)
+{
+	return false;
+}
+#endif
+
+#endif /* _LINUX_ZSWAP_H */
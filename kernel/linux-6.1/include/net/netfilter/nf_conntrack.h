@@ -15,6 +15,7 @@
 
 #include <linux/bitops.h>
 #include <linux/compiler.h>
+#include <linux/percpu_counter.h>
 
 #include <linux/netfilter/nf_conntrack_common.h>
 #include <linux/netfilter/nf_conntrack_tcp.h>
@@ -49,9 +50,12 @@ struct nf_conntrack_net_ecache {
 	struct hlist_nulls_head dying_list;
 };
 
+/* Per-cpu slack of nf_conntrack_net::count before it is folded */
+#define NF_CT_COUNT_BATCH	64
+
 struct nf_conntrack_net {
-	/* only used when new connection is allocated: */
-	atomic_t count;
+	/* only used when a connection is allocated or freed: */
+	struct percpu_counter count;
 	unsigned int expect_count;
 
 	/* only used from work queues, configuration plane, and so on: */
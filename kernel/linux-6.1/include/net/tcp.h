@@ -402,6 +402,8 @@ void tcp_cwnd_reduction(struct sock *sk, int newly_acked_sacked, int newly_lost,
 void tcp_clear_retrans(struct tcp_sock *tp);
 void tcp_update_metrics(struct sock *sk);
 void tcp_init_metrics(struct sock *sk);
+bool tcp_rate_cache_get(struct sock *sk, u64 *rate, u32 *min_rtt_us);
+void tcp_rate_cache_set(struct sock *sk, u64 rate, u32 min_rtt_us);
 void tcp_metrics_init(void);
 bool tcp_peer_is_proven(struct request_sock *req, struct dst_entry *dst);
 void __tcp_close(struct sock *sk, long timeout);
@@ -433,6 +435,8 @@ void tcp_data_ready(struct sock *sk);
 #ifdef CONFIG_MMU
 int tcp_mmap(struct file *file, struct socket *sock,
 	     struct vm_area_struct *vma);
+struct tcp_zerocopy_receive;
+int tcp_zerocopy_receive_kern(struct sock *sk, struct tcp_zerocopy_receive *zc);
 #endif
 void tcp_parse_options(const struct net *net, const struct sk_buff *skb,
 		       struct tcp_options_received *opt_rx,
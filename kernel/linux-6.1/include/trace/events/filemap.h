@@ -56,6 +56,47 @@ DEFINE_EVENT(mm_filemap_op_page_cache, mm_filemap_add_to_page_cache,
 	TP_ARGS(folio)
 	);
 
+/*
+ * A strided readahead stream was confirmed (hit) or broken (miss) at
+ * @index; @ra holds its stride and how often it has repeated.
+ */
+TRACE_EVENT(mm_filemap_readahead_stride,
+
+	TP_PROTO(struct address_space *mapping, pgoff_t index,
+		 struct file_ra_state *ra, bool hit),
+
+	TP_ARGS(mapping, index, ra, hit),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, i_ino)
+		__field(dev_t, s_dev)
+		__field(pgoff_t, index)
+		__field(unsigned int, stride)
+		__field(unsigned int, hits)
+		__field(bool, hit)
+	),
+
+	TP_fast_assign(
+		__entry->i_ino = mapping->host->i_ino;
+		if (mapping->host->i_sb)
+			__entry->s_dev = mapping->host->i_sb->s_dev;
+		else
+			__entry->s_dev = mapping->host->i_rdev;
+		__entry->index = index;
+		__entry->stride = ra->stride;
+		__entry->hits = ra->stride_hits;
+		__entry->hit = hit;
+	),
+
+	TP_printk("dev=%d:%d ino=0x%lx ofs=%lu stride=%u hits=%u %s",
+		MAJOR(__entry->s_dev), MINOR(__entry->s_dev),
+		__entry->i_ino,
+		__entry->index << PAGE_SHIFT,
+		__entry->stride,
+		__entry->hits,
+		__entry->hit ? "hit" : "miss")
+);
+
 TRACE_EVENT(filemap_set_wb_err,
 		TP_PROTO(struct address_space *mapping, errseq_t eseq),
 
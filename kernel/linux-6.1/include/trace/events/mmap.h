@@ -115,6 +115,42 @@ TRACE_EVENT(exit_mmap,
 	)
 );
 
+#ifdef CONFIG_PER_VMA_LOCK
+TRACE_DEFINE_ENUM(VMA_LOCK_SUCCESS);
+TRACE_DEFINE_ENUM(VMA_LOCK_ABORT);
+TRACE_DEFINE_ENUM(VMA_LOCK_RETRY);
+TRACE_DEFINE_ENUM(VMA_LOCK_MISS);
+
+/* How a page fault fared on the per-VMA lock path */
+TRACE_EVENT(vma_lock_fault,
+	TP_PROTO(struct mm_struct *mm, unsigned long address,
+		 enum vm_event_item result),
+
+	TP_ARGS(mm, address, result),
+
+	TP_STRUCT__entry(
+			__field(struct mm_struct *, mm)
+			__field(unsigned long, address)
+			__field(enum vm_event_item, result)
+	),
+
+	TP_fast_assign(
+		       __entry->mm		= mm;
+		       __entry->address		= address;
+		       __entry->result		= result;
+	),
+
+	TP_printk("mm=%p address=0x%lx result=%s",
+		  __entry->mm, __entry->address,
+		  __print_symbolic(__entry->result,
+				   { VMA_LOCK_SUCCESS,	"success" },
+				   { VMA_LOCK_ABORT,	"abort" },
+				   { VMA_LOCK_RETRY,	"retry" },
+				   { VMA_LOCK_MISS,	"miss" })
+	)
+);
+#endif
+
 #endif
 
 /* This part must be outside protection */
@@ -18,6 +18,7 @@
 /* For O_CLOEXEC */
 #include <linux/fcntl.h>
 #include <linux/types.h>
+#include <linux/ioctl.h>
 
 /* Flags for epoll_create1.  */
 #define EPOLL_CLOEXEC O_CLOEXEC
@@ -85,6 +86,64 @@ struct epoll_event {
 	__u64 data;
 } EPOLL_PACKED;
 
+/*
+ * Per epoll instance busy poll parameters, see EPIOCSPARAMS.  A zero
+ * busy_poll_usecs or busy_poll_budget falls back to the net.core.busy_poll
+ * sysctl and the default budget.
+ */
+struct epoll_params {
+	__u32 busy_poll_usecs;
+	__u16 busy_poll_budget;
+	__u8 prefer_busy_poll;
+
+	/* pad the struct to a multiple of 64bits */
+	__u8 __pad;
+};
+
+#define EPOLL_IOC_TYPE 0x8A
+#define EPIOCSPARAMS _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_params)
+#define EPIOCGPARAMS _IOR(EPOLL_IOC_TYPE, 0x02, struct epoll_params)
+
+/*
+ * Ready event ring, set up with EPIOCSRING and then mmap()ed from the
+ * epoll fd at offset 0 with the size EPIOCSRING returned.
+ *
+ * Edge triggered descriptors (EPOLLET, without EPOLLONESHOT or
+ * EPOLLWAKEUP) whose wakeup reports its events are delivered into the
+ * ring instead of the ready list, and userspace consumes them without a
+ * system call: load tail with acquire semantics, read the entries from
+ * head up to it, then store the new head with release semantics. Only
+ * the kernel writes tail and only userspace writes head.
+ *
+ * Everything else, and edge triggered events that find the ring full,
+ * goes through the ready list as before; the kernel sets overflow when the
+ * latter happens. epoll_wait() returns as soon as the ring is not empty,
+ * with only the ready list events copied to its array, so userspace looks
+ * at the ring whenever epoll_wait() returns, and calls it when the ring is
+ * empty or after clearing overflow.
+ */
+struct epoll_ring_event {
+	__u64 data;
+	__u32 events;
+	__u32 __pad;
+};
+
+struct epoll_ring {
+	__u32 head;
+	__u32 tail;
+	__u32 mask;		/* number of entries - 1 */
+	__u32 overflow;
+	__u64 __resv[6];
+	struct epoll_ring_event events[];
+};
+
+struct epoll_ring_params {
+	__u32 entries;		/* in: power of two */
+	__u32 size;		/* out: bytes to mmap() */
+};
+
+#define EPIOCSRING _IOWR(EPOLL_IOC_TYPE, 0x03, struct epoll_ring_params)
+
 #ifdef CONFIG_PM_SLEEP
 static inline void ep_take_care_of_epollwakeup(struct epoll_event *epev)
 {
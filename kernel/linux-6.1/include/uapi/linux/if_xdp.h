@@ -25,6 +25,12 @@
  * application.
  */
 #define XDP_USE_NEED_WAKEUP (1 << 3)
+/* By setting this option, userspace application indicates that it can
+ * handle frames spanning more than one buffer, chained with the
+ * XDP_PKT_CONTD descriptor option. Only supported in copy mode, and
+ * inherited by sockets sharing the umem.
+ */
+#define XDP_USE_SG	(1 << 4)
 
 /* Flags for xsk_umem_config flags */
 #define XDP_UMEM_UNALIGNED_CHUNK_FLAG (1 << 0)
@@ -87,6 +93,7 @@ struct xdp_options {
 
 /* Flags for the flags field of struct xdp_options */
 #define XDP_OPTIONS_ZEROCOPY (1 << 0)
+#define XDP_OPTIONS_SG (1 << 1)
 
 /* Pgoff for mmaping the rings */
 #define XDP_PGOFF_RX_RING			  0
@@ -106,6 +113,9 @@ struct xdp_desc {
 	__u32 options;
 };
 
+/* Flag indicating packet constitutes of multiple buffers*/
+#define XDP_PKT_CONTD (1 << 0)
+
 /* UMEM descriptor is __u64 */
 
 #endif /* _LINUX_IF_XDP_H */
@@ -242,6 +242,64 @@ struct input_mask {
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			/* Set clockid to be used for timestamps */
 
+/**
+ * struct input_ring_header - header page of an mmap()ed evdev event ring
+ * @size: number of event slots, a power of two
+ * @head: number of events published by the kernel, free running
+ * @tail: number of events consumed, free running, written by userspace
+ * @seq: number of packets published by the kernel
+ * @dropped: number of packets dropped because the ring was full
+ * @reserved: must be zero
+ *
+ * Mapping an evdev file descriptor (offset 0) switches the client from
+ * read() to a shared ring: the first page holds this header and the
+ * &struct input_ring_event slots follow at the start of the second page.
+ * The number of slots is the largest power of two that fits the mapping.
+ *
+ * The kernel publishes whole packets, up to and including their
+ * SYN_REPORT, by advancing @head with release semantics. Userspace reads
+ * slot (index & (@size - 1)) for every index from @tail to @head (load
+ * @head with acquire semantics) and then stores the new @tail with
+ * release semantics. While @tail lags @head the kernel does not wake
+ * pollers; poll() on the descriptor reports EPOLLIN until @tail catches
+ * up, so a reader that drains the ring before sleeping never misses a
+ * packet.
+ *
+ * Packets that do not fit are dropped whole and @dropped is bumped; the
+ * next packet that fits starts with a SYN_DROPPED event, and the reader
+ * resyncs device state with the EVIOCG* ioctls as it would on read().
+ * read() fails with EBUSY once the ring is mapped.
+ */
+struct input_ring_header {
+	__u32 size;
+	__u32 head;
+	__u32 tail;
+	__u32 seq;
+	__u32 dropped;
+	__u32 reserved[3];
+};
+
+/**
+ * struct input_ring_event - event slot of an mmap()ed evdev event ring
+ * @sec: seconds of the timestamp, in the client's clock
+ * @usec: microseconds of the timestamp
+ * @type: event type, as in &struct input_event
+ * @code: event code
+ * @value: event value
+ * @reserved: always zero
+ *
+ * Unlike &struct input_event the layout does not depend on the size of
+ * time_t, so 32-bit and 64-bit readers share it.
+ */
+struct input_ring_event {
+	__u64 sec;
+	__u32 usec;
+	__u16 type;
+	__u16 code;
+	__s32 value;
+	__u32 reserved;
+};
+
 /*
  * IDs.
  */
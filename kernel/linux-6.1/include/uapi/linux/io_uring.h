@@ -57,6 +57,7 @@ struct io_uring_sqe {
 		__u32		xattr_flags;
 		__u32		msg_ring_flags;
 		__u32		uring_cmd_flags;
+		__u32		futex_flags;
 	};
 	__u64	user_data;	/* data to be passed back at completion time */
 	/* pack this to avoid bogus arm OABI complaints */
@@ -165,6 +166,14 @@ enum {
  */
 #define IORING_SETUP_DEFER_TASKRUN	(1U << 13)
 
+/*
+ * Application provides the memory for the rings, in sq_off.user_addr for
+ * the SQE array and cq_off.user_addr for the rings, instead of mmap()ing
+ * them from the ring fd. Rings placed in a huge page are used through a
+ * single mapping and don't spread over the TLB.
+ */
+#define IORING_SETUP_NO_MMAP		(1U << 14)
+
 enum io_uring_op {
 	IORING_OP_NOP,
 	IORING_OP_READV,
@@ -215,6 +224,13 @@ enum io_uring_op {
 	IORING_OP_URING_CMD,
 	IORING_OP_SEND_ZC,
 	IORING_OP_SENDMSG_ZC,
+	IORING_OP_RECV_ZC,
+	IORING_OP_FUTEX_WAIT,
+	IORING_OP_FUTEX_WAKE,
+	IORING_OP_FUTEX_WAITV,
+	IORING_OP_GETDENTS,
+	IORING_OP_STATX_BATCH,
+	IORING_OP_OPENAT_BATCH,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -304,6 +320,12 @@ enum io_uring_op {
  *				0 is reported if zerocopy was actually possible.
  *				IORING_NOTIF_USAGE_ZC_COPIED if data was copied
  *				(at least partially).
+ *
+ * IORING_OP_RECV_ZC takes a struct tcp_zerocopy_receive in sqe->addr, as
+ * getsockopt(TCP_ZEROCOPY_RECEIVE) does, and maps the received pages into
+ * the tcp mmap() area it names. It is written back on completion, with
+ * cqe.res the number of bytes mapped plus those copied to the copybuf.
+ * Only IORING_RECVSEND_POLL_FIRST applies.
  */
 #define IORING_RECVSEND_POLL_FIRST	(1U << 0)
 #define IORING_RECV_MULTISHOT		(1U << 1)
@@ -319,6 +341,38 @@ enum io_uring_op {
  */
 #define IORING_NOTIF_USAGE_ZC_COPIED    (1U << 31)
 
+/*
+ * IORING_OP_FUTEX_WAIT and IORING_OP_FUTEX_WAKE take the futex address in
+ * sqe->addr, the expected value (wait) or the number of waiters to wake
+ * (wake) in sqe->addr2, the FUTEX_BITSET mask in sqe->addr3 and the
+ * futex_waitv flags, FUTEX_32 and optionally FUTEX_PRIVATE_FLAG, in
+ * sqe->fd. IORING_OP_FUTEX_WAITV takes an array of struct futex_waitv in
+ * sqe->addr and its length in sqe->len, and completes with the index of
+ * the futex that was woken. sqe->futex_flags is reserved and must be 0.
+ */
+
+/*
+ * IORING_OP_STATX_BATCH and IORING_OP_OPENAT_BATCH work on the directory
+ * open at sqe->fd, with an array of sqe->len struct io_uring_batch_entry
+ * in sqe->addr. Each name is resolved beneath the directory, as with
+ * RESOLVE_IN_ROOT: ".." and symlinks can't leave it. STATX_BATCH takes
+ * the statx mask in sqe->off and the AT_* flags in sqe->statx_flags;
+ * OPENAT_BATCH the mode in sqe->off and the open flags in
+ * sqe->open_flags. The result of each entry, 0 or the new fd, or a
+ * negative error, is stored in its res field, and the CQE res is the
+ * number of entries processed.
+ *
+ * IORING_OP_GETDENTS reads linux_dirent64 records from sqe->fd into
+ * sqe->addr, sqe->len bytes at most, starting at sqe->off, or at the
+ * file position if sqe->off is -1.
+ */
+struct io_uring_batch_entry {
+	__u64	name;		/* const char * */
+	__u64	statxbuf;	/* struct statx *, STATX_BATCH only */
+	__s32	res;
+	__u32	resv;
+};
+
 /*
  * accept flags stored in sqe->ioprio
  */
@@ -330,6 +384,7 @@ enum io_uring_op {
 enum {
 	IORING_MSG_DATA,	/* pass sqe->len as 'res' and off as user_data */
 	IORING_MSG_SEND_FD,	/* send a registered fd to another ring */
+	IORING_MSG_DATA_VEC,	/* post sqe->len struct io_uring_msg_cqe from addr3 */
 };
 
 /*
@@ -337,8 +392,23 @@ enum {
  *
  * IORING_MSG_RING_CQE_SKIP	Don't post a CQE to the target ring. Not
  *				applicable for IORING_MSG_DATA, obviously.
+ * IORING_MSG_RING_WAKE_IDLE	IORING_MSG_DATA_VEC only: wake the target
+ *				only if it had no CQEs left to reap. For
+ *				receivers that drain their CQ ring before
+ *				waiting for one more event.
  */
 #define IORING_MSG_RING_CQE_SKIP	(1U << 0)
+#define IORING_MSG_RING_WAKE_IDLE	(1U << 1)
+
+/*
+ * One CQE to post with IORING_MSG_DATA_VEC, the request completes with
+ * the number posted.
+ */
+struct io_uring_msg_cqe {
+	__u64	user_data;
+	__s32	res;
+	__u32	resv;
+};
 
 /*
  * IO completion data structure (Completion Queue Entry)
@@ -363,11 +433,16 @@ struct io_uring_cqe {
  * IORING_CQE_F_SOCK_NONEMPTY	If set, more data to read after socket recv
  * IORING_CQE_F_NOTIF	Set for notification CQEs. Can be used to distinct
  * 			them from sends.
+ * IORING_CQE_F_BUF_MORE	If set, the buffer ID set in the completion has
+ *			more space left, and the kernel will keep filling
+ *			it after this completion. Only for buffer rings
+ *			registered with IOU_PBUF_RING_INC.
  */
 #define IORING_CQE_F_BUFFER		(1U << 0)
 #define IORING_CQE_F_MORE		(1U << 1)
 #define IORING_CQE_F_SOCK_NONEMPTY	(1U << 2)
 #define IORING_CQE_F_NOTIF		(1U << 3)
+#define IORING_CQE_F_BUF_MORE		(1U << 4)
 
 enum {
 	IORING_CQE_BUFFER_SHIFT		= 16,
@@ -392,7 +467,7 @@ struct io_sqring_offsets {
 	__u32 dropped;
 	__u32 array;
 	__u32 resv1;
-	__u64 resv2;
+	__u64 user_addr;
 };
 
 /*
@@ -411,7 +486,7 @@ struct io_cqring_offsets {
 	__u32 cqes;
 	__u32 flags;
 	__u32 resv1;
-	__u64 resv2;
+	__u64 user_addr;
 };
 
 /*
@@ -508,6 +583,9 @@ enum {
 	/* register a range of fixed file slots for automatic slot allocation */
 	IORING_REGISTER_FILE_ALLOC_RANGE	= 25,
 
+	/* resize the SQ and CQ rings, argument is struct io_uring_params */
+	IORING_REGISTER_RESIZE_RINGS		= 26,
+
 	/* this goes last */
 	IORING_REGISTER_LAST
 };
@@ -621,12 +699,28 @@ struct io_uring_buf_ring {
 	};
 };
 
+/*
+ * Flags for IORING_REGISTER_PBUF_RING.
+ *
+ * IOU_PBUF_RING_INC:	Consume buffers incrementally. A completion only
+ *			uses up as much of a buffer as it transferred, the
+ *			kernel advances the entry's addr and shrinks its len
+ *			and later completions continue filling the same
+ *			buffer. IORING_CQE_F_BUF_MORE tells the application
+ *			the buffer isn't done yet; the data of a completion
+ *			starts where the previous one for that buffer ended,
+ *			and cqe->res is its length.
+ */
+enum {
+	IOU_PBUF_RING_INC	= 2,
+};
+
 /* argument for IORING_(UN)REGISTER_PBUF_RING */
 struct io_uring_buf_reg {
 	__u64	ring_addr;
 	__u32	ring_entries;
 	__u16	bgid;
-	__u16	pad;
+	__u16	flags;
 	__u64	resv[3];
 };
 
@@ -1178,6 +1178,8 @@ struct kvm_ppc_resize_hpt {
 #define KVM_CAP_S390_ZPCI_OP 221
 #define KVM_CAP_S390_CPU_TOPOLOGY 222
 #define KVM_CAP_DIRTY_LOG_RING_ACQ_REL 223
+#define KVM_CAP_DIRTY_LOG_RING_GRANULE 224
+#define KVM_CAP_DIRTY_LOG_RING_RESET_BATCH 225
 
 #ifdef KVM_CAP_IRQ_ROUTING
 
@@ -1759,6 +1761,8 @@ struct kvm_pv_cmd {
 
 /* Available with KVM_CAP_DIRTY_LOG_RING */
 #define KVM_RESET_DIRTY_RINGS		_IO(KVMIO, 0xc7)
+/* Available with KVM_CAP_DIRTY_LOG_RING_RESET_BATCH */
+#define KVM_RESET_DIRTY_RINGS_BATCH	_IOW(KVMIO, 0xd2, struct kvm_dirty_ring_reset)
 
 /* Per-VM Xen attributes */
 #define KVM_XEN_HVM_GET_ATTR	_IOWR(KVMIO, 0xc8, struct kvm_xen_hvm_attr)
@@ -2095,6 +2099,17 @@ struct kvm_hyperv_eventfd {
 #define KVM_DIRTY_GFN_F_RESET           _BITUL(1)
 #define KVM_DIRTY_GFN_F_MASK            0x3
 
+/*
+ * Argument of KVM_RESET_DIRTY_RINGS_BATCH: reset the rings of the
+ * listed vCPU ids only.  Batches covering different vCPUs may be reset
+ * concurrently from several threads.
+ */
+struct kvm_dirty_ring_reset {
+	__u32 nr_vcpus;
+	__u32 flags;
+	__u32 vcpu_ids[];
+};
+
 /*
  * KVM dirty rings should be mapped at KVM_DIRTY_LOG_PAGE_OFFSET of
  * per-vcpu mmaped regions as an array of struct kvm_dirty_gfn.  The
@@ -85,7 +85,13 @@
  * @MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED:
  *                          Register the process intent to use
  *                          MEMBARRIER_CMD_PRIVATE_EXPEDITED. Always
- *                          returns 0.
+ *                          returns 0. With @flags set to
+ *                          MEMBARRIER_CMD_FLAG_CPUSET, the private
+ *                          expedited commands of the process from then
+ *                          on only interrupt CPUs of the calling
+ *                          thread's cpuset: the process vouches for
+ *                          keeping all its threads within one cpuset.
+ *                          This lasts until exec.
  * @MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE:
  *                          In addition to provide memory ordering
  *                          guarantees described in
@@ -160,6 +166,7 @@ enum membarrier_cmd {
 
 enum membarrier_cmd_flag {
 	MEMBARRIER_CMD_FLAG_CPU		= (1 << 0),
+	MEMBARRIER_CMD_FLAG_CPUSET	= (1 << 1),
 };
 
 #endif /* _UAPI_LINUX_MEMBARRIER_H */
@@ -162,8 +162,9 @@ enum perf_event_sample_format {
 	PERF_SAMPLE_DATA_PAGE_SIZE		= 1U << 22,
 	PERF_SAMPLE_CODE_PAGE_SIZE		= 1U << 23,
 	PERF_SAMPLE_WEIGHT_STRUCT		= 1U << 24,
+	PERF_SAMPLE_STACK_ID			= 1U << 25,
 
-	PERF_SAMPLE_MAX = 1U << 25,		/* non-ABI */
+	PERF_SAMPLE_MAX = 1U << 26,		/* non-ABI */
 };
 
 #define PERF_SAMPLE_WEIGHT_TYPE	(PERF_SAMPLE_WEIGHT | PERF_SAMPLE_WEIGHT_STRUCT)
@@ -961,6 +962,9 @@ enum perf_event_type {
 	 *
 	 *	{ u64			nr,
 	 *	  u64			ips[nr];  } && PERF_SAMPLE_CALLCHAIN
+	 *				 && !PERF_SAMPLE_STACK_ID
+	 *
+	 *	{ u64			stack_id; } && PERF_SAMPLE_STACK_ID
 	 *
 	 *	#
 	 *	# The RAW record below is opaque data wrt the ABI
@@ -1204,6 +1208,23 @@ enum perf_event_type {
 	 */
 	PERF_RECORD_AUX_OUTPUT_HW_ID		= 21,
 
+	/*
+	 * With PERF_SAMPLE_STACK_ID, a sample carries only the id of its
+	 * callchain, in place of the callchain.  The callchain itself is
+	 * written once per id before the first sample that uses it, and
+	 * again only if the kernel has forgotten it was written.  The
+	 * consumer keeps the id -> callchain mapping for the whole stream.
+	 *
+	 * struct {
+	 *	struct perf_event_header	header;
+	 *	u64				stack_id;
+	 *	u64				nr;
+	 *	u64				ips[nr];
+	 *	struct sample_id		sample_id;
+	 * };
+	 */
+	PERF_RECORD_STACK_ID			= 22,
+
 	PERF_RECORD_MAX,			/* non-ABI */
 };
 
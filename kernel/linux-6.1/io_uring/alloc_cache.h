@@ -2,7 +2,8 @@
 #define IOU_ALLOC_CACHE_H
 
 /*
- * Don't allow the cache to grow beyond this size.
+ * Each cache holds at least this many entries. Rings with larger CQs
+ * get larger caches, up to the io_uring_alloc_cache_max sysctl.
  */
 #define IO_ALLOC_CACHE_MAX	512
 
@@ -13,7 +14,7 @@ struct io_cache_entry {
 static inline bool io_alloc_cache_put(struct io_alloc_cache *cache,
 				      struct io_cache_entry *entry)
 {
-	if (cache->nr_cached < IO_ALLOC_CACHE_MAX) {
+	if (cache->nr_cached < cache->max_cached) {
 		cache->nr_cached++;
 		hlist_add_head(&entry->node, &cache->list);
 		return true;
@@ -34,10 +35,23 @@ static inline struct io_cache_entry *io_alloc_cache_get(struct io_alloc_cache *c
 	return NULL;
 }
 
-static inline void io_alloc_cache_init(struct io_alloc_cache *cache)
+static inline void io_alloc_cache_init(struct io_alloc_cache *cache,
+				       unsigned int max_cached)
 {
 	INIT_HLIST_HEAD(&cache->list);
 	cache->nr_cached = 0;
+	cache->max_cached = max_cached;
+}
+
+/* count a lookup in @req's opcode stats, caller holds ->uring_lock */
+static inline void io_alloc_cache_account(struct io_kiocb *req, bool hit)
+{
+	struct io_alloc_cache_stats *stats = &req->ctx->cache_stats[req->opcode];
+
+	if (hit)
+		stats->hits++;
+	else
+		stats->misses++;
 }
 
 static inline void io_alloc_cache_free(struct io_alloc_cache *cache,
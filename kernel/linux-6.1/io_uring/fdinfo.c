@@ -14,6 +14,7 @@
 #include "fdinfo.h"
 #include "cancel.h"
 #include "rsrc.h"
+#include "tctx.h"
 
 #ifdef CONFIG_PROC_FS
 static __cold int io_uring_show_cred(struct seq_file *m, unsigned int id,
@@ -52,12 +53,9 @@ static __cold void __io_uring_show_fdinfo(struct io_ring_ctx *ctx,
 					  struct seq_file *m)
 {
 	struct io_overflow_cqe *ocqe;
-	struct io_rings *r = ctx->rings;
-	unsigned int sq_mask = ctx->sq_entries - 1, cq_mask = ctx->cq_entries - 1;
-	unsigned int sq_head = READ_ONCE(r->sq.head);
-	unsigned int sq_tail = READ_ONCE(r->sq.tail);
-	unsigned int cq_head = READ_ONCE(r->cq.head);
-	unsigned int cq_tail = READ_ONCE(r->cq.tail);
+	struct io_rings *r;
+	unsigned int sq_mask, cq_mask;
+	unsigned int sq_head, sq_tail, cq_head, cq_tail;
 	unsigned int cq_shift = 0;
 	unsigned int sq_shift = 0;
 	unsigned int sq_entries, cq_entries;
@@ -70,6 +68,16 @@ static __cold void __io_uring_show_fdinfo(struct io_ring_ctx *ctx,
 	if (ctx->flags & IORING_SETUP_SQE128)
 		sq_shift = 1;
 
+	/* keep the rings from being resized under us */
+	mutex_lock(&ctx->mmap_lock);
+	r = ctx->rings;
+	sq_mask = ctx->sq_entries - 1;
+	cq_mask = ctx->cq_entries - 1;
+	sq_head = READ_ONCE(r->sq.head);
+	sq_tail = READ_ONCE(r->sq.tail);
+	cq_head = READ_ONCE(r->cq.head);
+	cq_tail = READ_ONCE(r->cq.tail);
+
 	/*
 	 * we may get imprecise sqe and cqe info if uring is actively running
 	 * since we get cached_sq_head and cached_cq_tail without uring_lock
@@ -129,6 +137,7 @@ static __cold void __io_uring_show_fdinfo(struct io_ring_ctx *ctx,
 					cqe->big_cqe[0], cqe->big_cqe[1]);
 		seq_printf(m, "\n");
 	}
+	mutex_unlock(&ctx->mmap_lock);
 
 	/*
 	 * Avoid ABBA deadlock between the seq lock and the io_uring mutex,
@@ -177,6 +186,33 @@ static __cold void __io_uring_show_fdinfo(struct io_ring_ctx *ctx,
 			io_uring_show_cred(m, index, cred);
 	}
 
+	seq_printf(m, "AllocCache:\tapoll=%u netmsg=%u rw=%u uring_cmd=%u "
+		      "timeout=%u max=%u\n",
+		   ctx->apoll_cache.nr_cached, ctx->netmsg_cache.nr_cached,
+		   ctx->rw_cache.nr_cached, ctx->uring_cache.nr_cached,
+		   ctx->timeout_cache.nr_cached, ctx->rw_cache.max_cached);
+	for (i = 0; has_lock && i < IORING_OP_LAST; i++) {
+		struct io_alloc_cache_stats *stats = &ctx->cache_stats[i];
+
+		if (stats->hits || stats->misses)
+			seq_printf(m, "  %s: hits=%lu misses=%lu\n",
+				   io_uring_get_opcode(i), stats->hits,
+				   stats->misses);
+	}
+
+	/* nodes are removed under ->uring_lock before their io-wq goes away */
+	seq_puts(m, "IoWq:\n");
+	if (has_lock) {
+		struct io_tctx_node *node;
+
+		list_for_each_entry(node, &ctx->tctx_list, ctx_node) {
+			struct io_uring_task *tctx = node->task->io_uring;
+
+			if (tctx && tctx->io_wq)
+				io_wq_show_fdinfo(tctx->io_wq, m);
+		}
+	}
+
 	seq_puts(m, "PollList:\n");
 	for (i = 0; i < (1U << ctx->cancel_table.hash_bits); i++) {
 		struct io_hash_bucket *hb = &ctx->cancel_table.hbs[i];
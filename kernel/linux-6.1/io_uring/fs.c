@@ -38,6 +38,13 @@ struct io_mkdir {
 	struct filename			*filename;
 };
 
+struct io_getdents {
+	struct file			*file;
+	struct linux_dirent64 __user	*dirent;
+	unsigned int			count;
+	loff_t				pos;
+};
+
 struct io_link {
 	struct file			*file;
 	int				old_dfd;
@@ -291,3 +298,50 @@ void io_link_cleanup(struct io_kiocb *req)
 	putname(sl->oldpath);
 	putname(sl->newpath);
 }
+
+int io_getdents_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_getdents *gd = io_kiocb_to_cmd(req, struct io_getdents);
+
+	if (sqe->buf_index || sqe->splice_fd_in || sqe->addr2 || sqe->rw_flags)
+		return -EINVAL;
+
+	gd->dirent = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	gd->count = READ_ONCE(sqe->len);
+	gd->pos = READ_ONCE(sqe->off);
+	return 0;
+}
+
+int io_getdents(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_getdents *gd = io_kiocb_to_cmd(req, struct io_getdents);
+	struct file *file = req->file;
+	bool locked = false;
+	int ret;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	/* the same serialization fdget_pos() gives getdents64() */
+	if (file->f_mode & FMODE_ATOMIC_POS) {
+		mutex_lock(&file->f_pos_lock);
+		locked = true;
+	}
+
+	if (gd->pos != -1) {
+		loff_t pos = vfs_llseek(file, gd->pos, SEEK_SET);
+
+		if (pos < 0) {
+			ret = pos;
+			goto out;
+		}
+	}
+	ret = vfs_getdents(file, gd->dirent, gd->count);
+out:
+	if (locked)
+		mutex_unlock(&file->f_pos_lock);
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/io_uring.h>
+
+#include <uapi/linux/io_uring.h>
+
+#include "../kernel/futex/futex.h"
+#include "io_uring.h"
+#include "futex.h"
+
+#if defined(CONFIG_FUTEX)
+/*
+ * Futex wait and wake from the ring, so a thread can sleep on IO
+ * completions and futex wakeups with the one io_uring_enter().
+ *
+ * A wake completes inline.  A wait first checks the futex word inline and
+ * completes with -EAGAIN if it no longer holds the expected value, as
+ * FUTEX_WAIT would; otherwise it sleeps in io-wq until woken, or until
+ * cancelled, e.g. by a linked timeout.
+ */
+
+#define IO_FUTEX_FLAGS	(FUTEX_32 | FUTEX_PRIVATE_FLAG)
+
+struct io_futex {
+	struct file			*file;
+	union {
+		u32 __user			*uaddr;
+		struct futex_waitv __user	*uwaitv;
+	};
+	unsigned long			futex_val;	/* value, or nr to wake */
+	u32				futex_mask;
+	unsigned int			futex_flags;
+	unsigned int			futex_nr;
+};
+
+int io_futex_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	u64 mask;
+	u32 flags;
+
+	if (unlikely(sqe->len || sqe->futex_flags || sqe->buf_index ||
+		     sqe->file_index))
+		return -EINVAL;
+
+	iof->uaddr = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	iof->futex_val = READ_ONCE(sqe->addr2);
+	mask = READ_ONCE(sqe->addr3);
+	flags = READ_ONCE(sqe->fd);
+
+	if (flags & ~IO_FUTEX_FLAGS || !(flags & FUTEX_32))
+		return -EINVAL;
+	if (!mask || mask > U32_MAX)
+		return -EINVAL;
+	if (req->opcode == IORING_OP_FUTEX_WAIT && iof->futex_val > U32_MAX)
+		return -EINVAL;
+	if (req->opcode == IORING_OP_FUTEX_WAKE && iof->futex_val > INT_MAX)
+		return -EINVAL;
+
+	iof->futex_mask = mask;
+	iof->futex_flags = flags & FUTEX_PRIVATE_FLAG ? 0 : FLAGS_SHARED;
+	return 0;
+}
+
+int io_futexv_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+
+	if (unlikely(sqe->fd || sqe->addr2 || sqe->addr3 || sqe->futex_flags ||
+		     sqe->buf_index || sqe->file_index))
+		return -EINVAL;
+
+	iof->uwaitv = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	iof->futex_nr = READ_ONCE(sqe->len);
+	if (!iof->futex_nr || iof->futex_nr > FUTEX_WAITV_MAX)
+		return -EINVAL;
+	return 0;
+}
+
+static int io_futex_complete(struct io_kiocb *req, int ret)
+{
+	if (ret == -ERESTARTSYS)
+		ret = -EINTR;
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
+
+int io_futex_wait(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	u32 uval;
+	int ret;
+
+	if (issue_flags & IO_URING_F_NONBLOCK) {
+		/* Don't punt a wait that would not sleep */
+		if (get_user(uval, iof->uaddr))
+			return io_futex_complete(req, -EFAULT);
+		if (uval != iof->futex_val)
+			return io_futex_complete(req, -EAGAIN);
+		return -EAGAIN;
+	}
+
+	ret = futex_wait(iof->uaddr, iof->futex_flags, iof->futex_val, NULL,
+			 iof->futex_mask);
+	return io_futex_complete(req, ret);
+}
+
+/* As futex_parse_waitv() of sys_futex_waitv() */
+static int io_futex_parse_waitv(struct futex_vector *futexv,
+				struct futex_waitv __user *uwaitv,
+				unsigned int nr_futexes)
+{
+	struct futex_waitv aux;
+	unsigned int i;
+
+	for (i = 0; i < nr_futexes; i++) {
+		if (copy_from_user(&aux, &uwaitv[i], sizeof(aux)))
+			return -EFAULT;
+
+		if ((aux.flags & ~IO_FUTEX_FLAGS) || aux.__reserved)
+			return -EINVAL;
+		if (!(aux.flags & FUTEX_32))
+			return -EINVAL;
+
+		futexv[i].w.flags = aux.flags;
+		futexv[i].w.val = aux.val;
+		futexv[i].w.uaddr = aux.uaddr;
+		futexv[i].q = futex_q_init;
+	}
+	return 0;
+}
+
+/* cqe.res is the index of the futex that woke us */
+int io_futexv_wait(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	struct futex_vector *futexv;
+	int ret;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	futexv = kcalloc(iof->futex_nr, sizeof(*futexv), GFP_KERNEL);
+	if (!futexv)
+		return io_futex_complete(req, -ENOMEM);
+
+	ret = io_futex_parse_waitv(futexv, iof->uwaitv, iof->futex_nr);
+	if (!ret)
+		ret = futex_wait_multiple(futexv, iof->futex_nr, NULL);
+
+	kfree(futexv);
+	return io_futex_complete(req, ret);
+}
+
+int io_futex_wake(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_futex *iof = io_kiocb_to_cmd(req, struct io_futex);
+	int ret;
+
+	ret = futex_wake(iof->uaddr, iof->futex_flags, iof->futex_val,
+			 iof->futex_mask);
+	return io_futex_complete(req, ret);
+}
+#endif
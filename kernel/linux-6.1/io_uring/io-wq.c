@@ -16,6 +16,9 @@
 #include <linux/cpuset.h>
 #include <linux/task_work.h>
 #include <linux/audit.h>
+#include <linux/seq_file.h>
+#include <linux/sysctl.h>
+#include <linux/sched/clock.h>
 #include <uapi/linux/io_uring.h>
 
 #include "io-wq.h"
@@ -25,6 +28,14 @@
 #define WORKER_IDLE_TIMEOUT	(5 * HZ)
 #define WORKER_INIT_LIMIT	3
 
+/*
+ * Bounded workers each node keeps around once it has seen work, see
+ * io_wqe_reserve_short(). New ones are started ahead of the next burst
+ * instead of when work is already waiting for them, and the reserve
+ * doesn't exit on idle timeout.
+ */
+static int sysctl_io_uring_iowq_reserve __read_mostly;
+
 enum {
 	IO_WORKER_F_UP		= 1,	/* up and active */
 	IO_WORKER_F_RUNNING	= 2,	/* account as running */
@@ -61,6 +72,7 @@ struct io_worker {
 	struct callback_head create_work;
 	int create_index;
 	int init_retries;
+	u64 create_start;
 
 	union {
 		struct rcu_head rcu;
@@ -110,6 +122,12 @@ struct io_wqe {
 	struct io_wq_work *hash_tail[IO_WQ_NR_HASH_BUCKETS];
 
 	cpumask_var_t cpu_mask;
+
+	/* worker creation, under ->lock, see io_worker_note_started() */
+	unsigned long nr_created;
+	unsigned long nr_create_retries;
+	u64 create_ns_total;
+	u64 create_ns_max;
 };
 
 /*
@@ -298,6 +316,21 @@ static bool io_wqe_activate_free_worker(struct io_wqe *wqe,
 	return false;
 }
 
+static inline unsigned io_wqe_reserve(struct io_wqe_acct *acct)
+{
+	if (acct->index != IO_WQ_ACCT_BOUND)
+		return 0;
+	return min_t(unsigned, READ_ONCE(sysctl_io_uring_iowq_reserve),
+		     acct->max_workers);
+}
+
+static inline bool io_wqe_reserve_short(struct io_wqe *wqe,
+					struct io_wqe_acct *acct)
+	__must_hold(wqe->lock)
+{
+	return acct->nr_workers < io_wqe_reserve(acct);
+}
+
 /*
  * We need a worker. If we find a free one, we're good. If not, and we're
  * below the max number of workers, create one.
@@ -623,6 +656,31 @@ static void io_worker_handle_work(struct io_worker *worker)
 	} while (1);
 }
 
+/*
+ * Account the time from deciding to create @worker to it running, which
+ * is how long queued work may have waited for it. Returns true if the
+ * node's reserve is still short of workers.
+ */
+static bool io_worker_note_started(struct io_worker *worker)
+{
+	struct io_wqe_acct *acct = io_wqe_get_acct(worker);
+	struct io_wqe *wqe = worker->wqe;
+	u64 ns = local_clock() - worker->create_start;
+	bool short_reserve;
+
+	raw_spin_lock(&wqe->lock);
+	wqe->nr_created++;
+	if (worker->init_retries)
+		wqe->nr_create_retries++;
+	wqe->create_ns_total += ns;
+	if (ns > wqe->create_ns_max)
+		wqe->create_ns_max = ns;
+	short_reserve = io_wqe_reserve_short(wqe, acct);
+	raw_spin_unlock(&wqe->lock);
+
+	return short_reserve;
+}
+
 static int io_wqe_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -637,6 +695,13 @@ static int io_wqe_worker(void *data)
 	snprintf(buf, sizeof(buf), "iou-wrk-%d", wq->task->pid);
 	set_task_comm(current, buf);
 
+	/* grow towards the node's reserve, one worker starting the next */
+	if (io_worker_note_started(worker)) {
+		atomic_inc(&acct->nr_running);
+		atomic_inc(&wq->worker_refs);
+		io_queue_worker_create(worker, acct, create_worker_cb);
+	}
+
 	while (!test_bit(IO_WQ_BIT_EXIT, &wq->state)) {
 		long ret;
 
@@ -646,10 +711,11 @@ static int io_wqe_worker(void *data)
 
 		raw_spin_lock(&wqe->lock);
 		/*
-		 * Last sleep timed out. Exit if we're not the last worker,
-		 * or if someone modified our affinity.
+		 * Last sleep timed out. Exit if we're not the last worker or
+		 * part of the reserve, or if someone modified our affinity.
 		 */
-		if (last_timeout && (exit_mask || acct->nr_workers > 1)) {
+		if (last_timeout && (exit_mask || (acct->nr_workers > 1 &&
+		    acct->nr_workers > io_wqe_reserve(acct)))) {
 			acct->nr_workers--;
 			raw_spin_unlock(&wqe->lock);
 			__set_current_state(TASK_RUNNING);
@@ -832,6 +898,7 @@ fail:
 
 	refcount_set(&worker->ref, 1);
 	worker->wqe = wqe;
+	worker->create_start = local_clock();
 	raw_spin_lock_init(&worker->lock);
 	init_completion(&worker->ref_done);
 
@@ -1445,10 +1512,80 @@ int io_wq_max_workers(struct io_wq *wq, int *new_count)
 	return 0;
 }
 
+#ifdef CONFIG_PROC_FS
+static unsigned io_acct_nr_queued(struct io_wqe_acct *acct)
+{
+	struct io_wq_work_node *node, *prev;
+	unsigned nr = 0;
+
+	raw_spin_lock(&acct->lock);
+	wq_list_for_each(node, prev, &acct->work_list)
+		nr++;
+	raw_spin_unlock(&acct->lock);
+	return nr;
+}
+
+/*
+ * Per node queue depth and worker state, and how long workers took to
+ * start, for the fdinfo of the rings @wq serves.
+ */
+void io_wq_show_fdinfo(struct io_wq *wq, struct seq_file *m)
+{
+	int node;
+
+	for_each_node(node) {
+		struct io_wqe *wqe = wq->wqes[node];
+		struct io_wqe_acct *bound = &wqe->acct[IO_WQ_ACCT_BOUND];
+		struct io_wqe_acct *unbound = &wqe->acct[IO_WQ_ACCT_UNBOUND];
+		unsigned q_bound = io_acct_nr_queued(bound);
+		unsigned q_unbound = io_acct_nr_queued(unbound);
+		unsigned long created;
+		u64 avg_ns = 0;
+
+		raw_spin_lock(&wqe->lock);
+		created = wqe->nr_created;
+		if (!created && !bound->nr_workers && !unbound->nr_workers &&
+		    !q_bound && !q_unbound) {
+			raw_spin_unlock(&wqe->lock);
+			continue;
+		}
+		if (created)
+			avg_ns = div64_ul(wqe->create_ns_total, created);
+		seq_printf(m, "  pid=%d node=%d bound=%u/%u running=%d queued=%u"
+			      " unbound=%u/%u running=%d queued=%u\n",
+			   task_pid_nr(wq->task), node,
+			   bound->nr_workers, bound->max_workers,
+			   atomic_read(&bound->nr_running), q_bound,
+			   unbound->nr_workers, unbound->max_workers,
+			   atomic_read(&unbound->nr_running), q_unbound);
+		seq_printf(m, "    created=%lu retried=%lu start_avg_us=%llu"
+			      " start_max_us=%llu\n",
+			   created, wqe->nr_create_retries,
+			   div_u64(avg_ns, NSEC_PER_USEC),
+			   div_u64(wqe->create_ns_max, NSEC_PER_USEC));
+		raw_spin_unlock(&wqe->lock);
+	}
+}
+#endif
+
+static struct ctl_table io_wq_sysctl_table[] = {
+	{
+		.procname	= "io_uring_iowq_reserve",
+		.data		= &sysctl_io_uring_iowq_reserve,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+	{}
+};
+
 static __init int io_wq_init(void)
 {
 	int ret;
 
+	register_sysctl_init("kernel", io_wq_sysctl_table);
+
 	ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN, "io-wq/online",
 					io_wq_cpu_online, io_wq_cpu_offline);
 	if (ret < 0)
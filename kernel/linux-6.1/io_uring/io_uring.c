@@ -71,6 +71,8 @@
 #include <linux/io_uring.h>
 #include <linux/audit.h>
 #include <linux/security.h>
+#include <linux/sysctl.h>
+#include <linux/vmalloc.h>
 #include <asm/shmparam.h>
 
 #define CREATE_TRACE_POINTS
@@ -149,9 +151,14 @@ static void io_clean_op(struct io_kiocb *req);
 static void io_queue_sqe(struct io_kiocb *req);
 static void io_move_task_work_from_local(struct io_ring_ctx *ctx);
 static void __io_submit_flush_completions(struct io_ring_ctx *ctx);
+static void io_req_async_data_recycle(struct io_kiocb *req);
+static void io_async_cache_free(struct io_cache_entry *entry);
 
 static struct kmem_cache *req_cachep;
 
+/* upper bound for the per ring alloc caches, 0 disables them */
+static int sysctl_io_uring_alloc_cache_max __read_mostly = 8 * IO_ALLOC_CACHE_MAX;
+
 static inline void io_submit_flush_completions(struct io_ring_ctx *ctx)
 {
 	if (!wq_list_empty(&ctx->submit_state.compl_reqs))
@@ -257,9 +264,21 @@ static int io_alloc_hash_table(struct io_hash_table *table, unsigned bits)
 	return 0;
 }
 
+/*
+ * Size the alloc caches for as many requests as the CQ can have in flight
+ * completed, but no smaller than the old fixed size.
+ */
+static unsigned int io_alloc_cache_size(struct io_uring_params *p)
+{
+	unsigned int limit = READ_ONCE(sysctl_io_uring_alloc_cache_max);
+
+	return min(max_t(unsigned int, p->cq_entries, IO_ALLOC_CACHE_MAX), limit);
+}
+
 static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 {
 	struct io_ring_ctx *ctx;
+	unsigned int cache_max;
 	int hash_bits;
 
 	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
@@ -286,6 +305,11 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	/* set invalid range, so io_import_fixed() fails meeting it */
 	ctx->dummy_ubuf->ubuf = -1UL;
 
+	ctx->cache_stats = kcalloc(IORING_OP_LAST, sizeof(*ctx->cache_stats),
+				   GFP_KERNEL);
+	if (!ctx->cache_stats)
+		goto err;
+
 	if (percpu_ref_init(&ctx->refs, io_ring_ctx_ref_free,
 			    0, GFP_KERNEL))
 		goto err;
@@ -295,11 +319,16 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	INIT_LIST_HEAD(&ctx->sqd_list);
 	INIT_LIST_HEAD(&ctx->cq_overflow_list);
 	INIT_LIST_HEAD(&ctx->io_buffers_cache);
-	io_alloc_cache_init(&ctx->apoll_cache);
-	io_alloc_cache_init(&ctx->netmsg_cache);
+	cache_max = io_alloc_cache_size(p);
+	io_alloc_cache_init(&ctx->apoll_cache, cache_max);
+	io_alloc_cache_init(&ctx->netmsg_cache, cache_max);
+	io_alloc_cache_init(&ctx->rw_cache, cache_max);
+	io_alloc_cache_init(&ctx->uring_cache, cache_max);
+	io_alloc_cache_init(&ctx->timeout_cache, cache_max);
 	init_completion(&ctx->ref_comp);
 	xa_init_flags(&ctx->personalities, XA_FLAGS_ALLOC1);
 	mutex_init(&ctx->uring_lock);
+	mutex_init(&ctx->mmap_lock);
 	init_waitqueue_head(&ctx->cq_wait);
 	spin_lock_init(&ctx->completion_lock);
 	spin_lock_init(&ctx->timeout_lock);
@@ -321,6 +350,7 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	INIT_WQ_LIST(&ctx->submit_state.compl_reqs);
 	return ctx;
 err:
+	kfree(ctx->cache_stats);
 	kfree(ctx->dummy_ubuf);
 	kfree(ctx->cancel_table.hbs);
 	kfree(ctx->cancel_table_locked.hbs);
@@ -825,6 +855,32 @@ bool io_post_aux_cqe(struct io_ring_ctx *ctx,
 	return filled;
 }
 
+/*
+ * Post a batch of aux CQEs under one ->completion_lock hold and commit
+ * them at once. The caller wakes the ring when done, so that a vector
+ * posted in several batches causes one wakeup. @idle, if set, returns
+ * whether the CQ ring had nothing to reap before.
+ */
+unsigned int io_post_aux_cqes(struct io_ring_ctx *ctx,
+			      const struct io_uring_msg_cqe *cqes,
+			      unsigned int nr, bool *idle)
+{
+	unsigned int i;
+
+	io_cq_lock(ctx);
+	if (idle)
+		*idle = !__io_cqring_events(ctx);
+	for (i = 0; i < nr; i++) {
+		if (!io_fill_cqe_aux(ctx, cqes[i].user_data, cqes[i].res, 0,
+				     true))
+			break;
+	}
+	io_commit_cqring(ctx);
+	spin_unlock(&ctx->completion_lock);
+	io_commit_cqring_flush(ctx);
+	return i;
+}
+
 void io_req_complete_post(struct io_kiocb *req)
 {
 	struct io_ring_ctx *ctx = req->ctx;
@@ -874,7 +930,7 @@ void io_req_complete_failed(struct io_kiocb *req, s32 res)
 	lockdep_assert_held(&req->ctx->uring_lock);
 
 	req_set_fail(req);
-	io_req_set_res(req, res, io_put_kbuf(req, IO_URING_F_UNLOCKED));
+	io_req_set_res(req, res, io_put_kbuf(req, res, IO_URING_F_UNLOCKED));
 	if (def->fail)
 		def->fail(req);
 	io_req_complete_post(req);
@@ -1124,8 +1180,11 @@ static void io_req_local_work_add(struct io_kiocb *req)
 		return;
 	}
 
+	/* ctx->rings may be replaced by a resize, see io_register_resize_rings() */
+	rcu_read_lock();
 	if (ctx->flags & IORING_SETUP_TASKRUN_FLAG)
 		atomic_or(IORING_SQ_TASKRUN, &ctx->rings->sq_flags);
+	rcu_read_unlock();
 
 	if (ctx->has_evfd)
 		io_eventfd_signal(ctx);
@@ -1148,8 +1207,11 @@ void __io_req_task_work_add(struct io_kiocb *req, bool allow_local)
 	if (!llist_add(&req->io_task_work.node, &tctx->task_list))
 		return;
 
-	if (ctx->flags & IORING_SETUP_TASKRUN_FLAG)
+	if (ctx->flags & IORING_SETUP_TASKRUN_FLAG) {
+		rcu_read_lock();
 		atomic_or(IORING_SQ_TASKRUN, &ctx->rings->sq_flags);
+		rcu_read_unlock();
+	}
 
 	if (likely(!task_work_add(req->task, &tctx->task_work, ctx->notify_method)))
 		return;
@@ -1301,6 +1363,9 @@ void io_free_batch_list(struct io_ring_ctx *ctx, struct io_wq_work_node *node)
 					kfree(apoll);
 				req->flags &= ~REQ_F_POLLED;
 			}
+			if ((req->flags & (REQ_F_ASYNC_DATA | REQ_F_NEED_CLEANUP)) ==
+			    REQ_F_ASYNC_DATA)
+				io_req_async_data_recycle(req);
 			if (req->flags & IO_REQ_LINK_FLAGS)
 				io_queue_next(req);
 			if (unlikely(req->flags & IO_REQ_CLEAN_FLAGS))
@@ -1473,7 +1538,7 @@ void io_req_task_complete(struct io_kiocb *req, bool *locked)
 	if (req->flags & (REQ_F_BUFFER_SELECTED|REQ_F_BUFFER_RING)) {
 		unsigned issue_flags = *locked ? 0 : IO_URING_F_UNLOCKED;
 
-		req->cqe.flags |= io_put_kbuf(req, issue_flags);
+		req->cqe.flags |= io_put_kbuf(req, req->cqe.res, issue_flags);
 	}
 
 	if (*locked)
@@ -1599,6 +1664,59 @@ bool io_alloc_async_data(struct io_kiocb *req)
 	return true;
 }
 
+static struct io_alloc_cache *io_req_async_cache(struct io_kiocb *req)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+
+	switch (io_op_defs[req->opcode].async_cache) {
+	case IO_ASYNC_CACHE_RW:
+		return &ctx->rw_cache;
+	case IO_ASYNC_CACHE_URING_CMD:
+		return &ctx->uring_cache;
+	case IO_ASYNC_CACHE_TIMEOUT:
+		return &ctx->timeout_cache;
+	}
+	return NULL;
+}
+
+/*
+ * As io_alloc_async_data(), but reuse ->async_data of an earlier request
+ * of the same kind if the opcode has a cache and we hold ->uring_lock.
+ */
+bool io_alloc_async_data_cached(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_alloc_cache *cache = io_req_async_cache(req);
+	struct io_cache_entry *entry;
+
+	if (!cache || (issue_flags & IO_URING_F_UNLOCKED))
+		return io_alloc_async_data(req);
+
+	entry = io_alloc_cache_get(cache);
+	io_alloc_cache_account(req, entry);
+	if (!entry)
+		return io_alloc_async_data(req);
+	req->async_data = entry;
+	req->flags |= REQ_F_ASYNC_DATA;
+	return false;
+}
+
+/* ->async_data has the cache entry overlaid once it's free, see above */
+static void io_req_async_data_recycle(struct io_kiocb *req)
+	__must_hold(&req->ctx->uring_lock)
+{
+	struct io_alloc_cache *cache = io_req_async_cache(req);
+
+	if (cache && io_alloc_cache_put(cache, req->async_data)) {
+		req->async_data = NULL;
+		req->flags &= ~REQ_F_ASYNC_DATA;
+	}
+}
+
+static void io_async_cache_free(struct io_cache_entry *entry)
+{
+	kfree(entry);
+}
+
 int io_req_prep_async(struct io_kiocb *req)
 {
 	const struct io_op_def *def = &io_op_defs[req->opcode];
@@ -1611,7 +1729,8 @@ int io_req_prep_async(struct io_kiocb *req)
 	if (WARN_ON_ONCE(req_has_async_data(req)))
 		return -EFAULT;
 	if (!io_op_defs[req->opcode].manual_alloc) {
-		if (io_alloc_async_data(req))
+		/* ->prep_async is always called from the submission context */
+		if (io_alloc_async_data_cached(req, 0))
 			return -EAGAIN;
 	}
 	return def->prep_async(req);
@@ -2540,6 +2659,165 @@ static unsigned long rings_size(struct io_ring_ctx *ctx, unsigned int sq_entries
 	return off;
 }
 
+/* Memory backing the rings and SQEs of a ring, the ctx's or a resized one */
+struct io_ring_mem {
+	struct io_rings		*rings;
+	struct io_uring_sqe	*sq_sqes;
+	struct page		**ring_pages;
+	struct page		**sqe_pages;
+	unsigned int		n_ring_pages;
+	unsigned int		n_sqe_pages;
+};
+
+static void io_pages_unmap(void *ptr, struct page ***pages,
+			   unsigned int *npages)
+{
+	if (!ptr)
+		return;
+	if (is_vmalloc_addr(ptr))
+		vunmap(ptr);
+	unpin_user_pages(*pages, *npages);
+	kvfree(*pages);
+	*pages = NULL;
+	*npages = 0;
+}
+
+/*
+ * Pin application memory for the rings. If it is one physically
+ * contiguous folio, as a huge page is, use it through the direct map,
+ * otherwise map the pages virtually contiguous.
+ */
+static void *io_pages_map(unsigned long uaddr, size_t size,
+			  struct page ***pages, unsigned int *npages)
+{
+	struct page **page_array;
+	struct folio *folio;
+	int nr_pages, i;
+	void *ptr;
+
+	if (!uaddr || (uaddr & ~PAGE_MASK))
+		return ERR_PTR(-EINVAL);
+
+	page_array = io_pin_pages(uaddr, size, &nr_pages);
+	if (IS_ERR(page_array))
+		return ERR_CAST(page_array);
+
+	folio = page_folio(page_array[0]);
+	for (i = 1; i < nr_pages; i++) {
+		if (page_folio(page_array[i]) != folio ||
+		    page_array[i] != nth_page(page_array[0], i))
+			break;
+	}
+	if (i == nr_pages && !PageHighMem(page_array[0]))
+		ptr = page_address(page_array[0]);
+	else
+		ptr = vmap(page_array, nr_pages, VM_MAP, PAGE_KERNEL);
+	if (!ptr) {
+		unpin_user_pages(page_array, nr_pages);
+		kvfree(page_array);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	*pages = page_array;
+	*npages = nr_pages;
+	return ptr;
+}
+
+static void *io_ring_mem_map(struct io_ring_ctx *ctx, u64 uaddr, size_t size,
+			     struct page ***pages, unsigned int *npages)
+{
+	void *ptr;
+
+	if (!(ctx->flags & IORING_SETUP_NO_MMAP)) {
+		ptr = io_mem_alloc(size);
+		return ptr ?: ERR_PTR(-ENOMEM);
+	}
+
+	ptr = io_pages_map(uaddr, size, pages, npages);
+	if (!IS_ERR(ptr))
+		memset(ptr, 0, size);
+	return ptr;
+}
+
+static void io_ring_mem_free(struct io_ring_ctx *ctx, struct io_ring_mem *m)
+{
+	if (ctx->flags & IORING_SETUP_NO_MMAP) {
+		io_pages_unmap(m->rings, &m->ring_pages, &m->n_ring_pages);
+		io_pages_unmap(m->sq_sqes, &m->sqe_pages, &m->n_sqe_pages);
+	} else {
+		io_mem_free(m->rings);
+		io_mem_free(m->sq_sqes);
+	}
+	m->rings = NULL;
+	m->sq_sqes = NULL;
+}
+
+static __cold int io_ring_mem_alloc(struct io_ring_ctx *ctx,
+				    struct io_uring_params *p,
+				    struct io_ring_mem *m,
+				    size_t *sq_array_offset)
+{
+	struct io_rings *rings;
+	size_t size;
+	void *ptr;
+
+	memset(m, 0, sizeof(*m));
+	size = rings_size(ctx, p->sq_entries, p->cq_entries, sq_array_offset);
+	if (size == SIZE_MAX)
+		return -EOVERFLOW;
+
+	ptr = io_ring_mem_map(ctx, p->cq_off.user_addr, size,
+			      &m->ring_pages, &m->n_ring_pages);
+	if (IS_ERR(ptr))
+		return PTR_ERR(ptr);
+
+	rings = m->rings = ptr;
+	rings->sq_ring_mask = p->sq_entries - 1;
+	rings->cq_ring_mask = p->cq_entries - 1;
+	rings->sq_ring_entries = p->sq_entries;
+	rings->cq_ring_entries = p->cq_entries;
+
+	if (ctx->flags & IORING_SETUP_SQE128)
+		size = array_size(2 * sizeof(struct io_uring_sqe), p->sq_entries);
+	else
+		size = array_size(sizeof(struct io_uring_sqe), p->sq_entries);
+	if (size == SIZE_MAX) {
+		io_ring_mem_free(ctx, m);
+		return -EOVERFLOW;
+	}
+
+	ptr = io_ring_mem_map(ctx, p->sq_off.user_addr, size,
+			      &m->sqe_pages, &m->n_sqe_pages);
+	if (IS_ERR(ptr)) {
+		io_ring_mem_free(ctx, m);
+		return PTR_ERR(ptr);
+	}
+	m->sq_sqes = ptr;
+	return 0;
+}
+
+static void io_ring_mem_get(struct io_ring_ctx *ctx, struct io_ring_mem *m)
+{
+	m->rings = ctx->rings;
+	m->sq_sqes = ctx->sq_sqes;
+	m->ring_pages = ctx->ring_pages;
+	m->sqe_pages = ctx->sqe_pages;
+	m->n_ring_pages = ctx->n_ring_pages;
+	m->n_sqe_pages = ctx->n_sqe_pages;
+}
+
+static void io_ring_mem_install(struct io_ring_ctx *ctx, struct io_ring_mem *m,
+				size_t sq_array_offset)
+{
+	ctx->rings = m->rings;
+	ctx->sq_array = (u32 *)((char *)m->rings + sq_array_offset);
+	ctx->sq_sqes = m->sq_sqes;
+	ctx->ring_pages = m->ring_pages;
+	ctx->sqe_pages = m->sqe_pages;
+	ctx->n_ring_pages = m->n_ring_pages;
+	ctx->n_sqe_pages = m->n_sqe_pages;
+}
+
 static int io_eventfd_register(struct io_ring_ctx *ctx, void __user *arg,
 			       unsigned int eventfd_async)
 {
@@ -2615,6 +2893,8 @@ static void io_req_caches_free(struct io_ring_ctx *ctx)
 
 static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 {
+	struct io_ring_mem mem;
+
 	io_sq_thread_finish(ctx);
 	io_rsrc_refs_drop(ctx);
 	/* __io_rsrc_put_work() may need uring_lock to progress, wait w/o it */
@@ -2631,6 +2911,9 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 	io_eventfd_unregister(ctx);
 	io_alloc_cache_free(&ctx->apoll_cache, io_apoll_cache_free);
 	io_alloc_cache_free(&ctx->netmsg_cache, io_netmsg_cache_free);
+	io_alloc_cache_free(&ctx->rw_cache, io_async_cache_free);
+	io_alloc_cache_free(&ctx->uring_cache, io_async_cache_free);
+	io_alloc_cache_free(&ctx->timeout_cache, io_async_cache_free);
 	io_destroy_buffers(ctx);
 	mutex_unlock(&ctx->uring_lock);
 	if (ctx->sq_creds)
@@ -2655,8 +2938,8 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 		mmdrop(ctx->mm_account);
 		ctx->mm_account = NULL;
 	}
-	io_mem_free(ctx->rings);
-	io_mem_free(ctx->sq_sqes);
+	io_ring_mem_get(ctx, &mem);
+	io_ring_mem_free(ctx, &mem);
 
 	percpu_ref_exit(&ctx->refs);
 	free_uid(ctx->user);
@@ -2665,6 +2948,7 @@ static __cold void io_ring_ctx_free(struct io_ring_ctx *ctx)
 		io_wq_put_hash(ctx->hash_map);
 	kfree(ctx->cancel_table.hbs);
 	kfree(ctx->cancel_table_locked.hbs);
+	kfree(ctx->cache_stats);
 	kfree(ctx->dummy_ubuf);
 	kfree(ctx->io_bl);
 	xa_destroy(&ctx->io_bl_xa);
@@ -2682,6 +2966,8 @@ static __poll_t io_uring_poll(struct file *file, poll_table *wait)
 	 * io_commit_cqring
 	 */
 	smp_rmb();
+	/* ctx->rings may be replaced by a resize, see io_register_resize_rings() */
+	rcu_read_lock();
 	if (!io_sqring_full(ctx))
 		mask |= EPOLLOUT | EPOLLWRNORM;
 
@@ -2701,6 +2987,7 @@ static __poll_t io_uring_poll(struct file *file, poll_table *wait)
 
 	if (__io_cqring_events_user(ctx) || io_has_work(ctx))
 		mask |= EPOLLIN | EPOLLRDNORM;
+	rcu_read_unlock();
 
 	return mask;
 }
@@ -3085,6 +3372,10 @@ static void *io_uring_validate_mmap_request(struct file *file,
 	struct page *page;
 	void *ptr;
 
+	/* the application owns the memory, there is nothing to map */
+	if (ctx->flags & IORING_SETUP_NO_MMAP)
+		return ERR_PTR(-EINVAL);
+
 	switch (offset) {
 	case IORING_OFF_SQ_RING:
 	case IORING_OFF_CQ_RING:
@@ -3108,16 +3399,36 @@ static void *io_uring_validate_mmap_request(struct file *file,
 
 static __cold int io_uring_mmap(struct file *file, struct vm_area_struct *vma)
 {
+	struct io_ring_ctx *ctx = file->private_data;
 	size_t sz = vma->vm_end - vma->vm_start;
-	unsigned long pfn;
+	unsigned long i, nr_pages = sz >> PAGE_SHIFT;
+	struct page *page;
 	void *ptr;
+	int ret = 0;
 
+	mutex_lock(&ctx->mmap_lock);
 	ptr = io_uring_validate_mmap_request(file, vma->vm_pgoff, sz);
-	if (IS_ERR(ptr))
-		return PTR_ERR(ptr);
+	if (IS_ERR(ptr)) {
+		ret = PTR_ERR(ptr);
+		goto out;
+	}
 
-	pfn = virt_to_phys(ptr) >> PAGE_SHIFT;
-	return remap_pfn_range(vma, vma->vm_start, pfn, sz, vma->vm_page_prot);
+	/*
+	 * Insert the pages rather than their pfns, so the mapping holds a
+	 * reference: after a resize the application may still have the old
+	 * rings mapped, and they must stay around until it unmaps them.
+	 */
+	vma->vm_flags |= VM_DONTEXPAND;
+	page = virt_to_page(ptr);
+	for (i = 0; i < nr_pages; i++) {
+		ret = vm_insert_page(vma, vma->vm_start + (i << PAGE_SHIFT),
+				     page + i);
+		if (ret)
+			break;
+	}
+out:
+	mutex_unlock(&ctx->mmap_lock);
+	return ret;
 }
 
 static unsigned long io_uring_mmu_get_unmapped_area(struct file *filp,
@@ -3392,85 +3703,57 @@ bool io_is_uring_fops(struct file *file)
 }
 
 static __cold int io_allocate_scq_urings(struct io_ring_ctx *ctx,
-					 struct io_uring_params *p)
+					 struct io_uring_params *p,
+					 size_t *sq_array_offset)
 {
-	struct io_rings *rings;
-	size_t size, sq_array_offset;
+	struct io_ring_mem mem;
+	int ret;
 
 	/* make sure these are sane, as we already accounted them */
 	ctx->sq_entries = p->sq_entries;
 	ctx->cq_entries = p->cq_entries;
 
-	size = rings_size(ctx, p->sq_entries, p->cq_entries, &sq_array_offset);
-	if (size == SIZE_MAX)
-		return -EOVERFLOW;
-
-	rings = io_mem_alloc(size);
-	if (!rings)
-		return -ENOMEM;
-
-	ctx->rings = rings;
-	ctx->sq_array = (u32 *)((char *)rings + sq_array_offset);
-	rings->sq_ring_mask = p->sq_entries - 1;
-	rings->cq_ring_mask = p->cq_entries - 1;
-	rings->sq_ring_entries = p->sq_entries;
-	rings->cq_ring_entries = p->cq_entries;
-
-	if (p->flags & IORING_SETUP_SQE128)
-		size = array_size(2 * sizeof(struct io_uring_sqe), p->sq_entries);
-	else
-		size = array_size(sizeof(struct io_uring_sqe), p->sq_entries);
-	if (size == SIZE_MAX) {
-		io_mem_free(ctx->rings);
-		ctx->rings = NULL;
-		return -EOVERFLOW;
-	}
-
-	ctx->sq_sqes = io_mem_alloc(size);
-	if (!ctx->sq_sqes) {
-		io_mem_free(ctx->rings);
-		ctx->rings = NULL;
-		return -ENOMEM;
-	}
+	ret = io_ring_mem_alloc(ctx, p, &mem, sq_array_offset);
+	if (ret)
+		return ret;
 
+	io_ring_mem_install(ctx, &mem, *sq_array_offset);
 	return 0;
 }
 
-static int io_uring_install_fd(struct io_ring_ctx *ctx, struct file *file)
+static void io_fill_ring_offsets(struct io_uring_params *p,
+				 size_t sq_array_offset)
 {
-	int ret, fd;
+	u64 sq_user_addr = p->sq_off.user_addr;
+	u64 cq_user_addr = p->cq_off.user_addr;
 
-	fd = get_unused_fd_flags(O_RDWR | O_CLOEXEC);
-	if (fd < 0)
-		return fd;
+	memset(&p->sq_off, 0, sizeof(p->sq_off));
+	p->sq_off.head = offsetof(struct io_rings, sq.head);
+	p->sq_off.tail = offsetof(struct io_rings, sq.tail);
+	p->sq_off.ring_mask = offsetof(struct io_rings, sq_ring_mask);
+	p->sq_off.ring_entries = offsetof(struct io_rings, sq_ring_entries);
+	p->sq_off.flags = offsetof(struct io_rings, sq_flags);
+	p->sq_off.dropped = offsetof(struct io_rings, sq_dropped);
+	p->sq_off.array = sq_array_offset;
+	p->sq_off.user_addr = sq_user_addr;
 
-	ret = __io_uring_add_tctx_node(ctx);
-	if (ret) {
-		put_unused_fd(fd);
-		return ret;
-	}
-	fd_install(fd, file);
-	return fd;
+	memset(&p->cq_off, 0, sizeof(p->cq_off));
+	p->cq_off.head = offsetof(struct io_rings, cq.head);
+	p->cq_off.tail = offsetof(struct io_rings, cq.tail);
+	p->cq_off.ring_mask = offsetof(struct io_rings, cq_ring_mask);
+	p->cq_off.ring_entries = offsetof(struct io_rings, cq_ring_entries);
+	p->cq_off.overflow = offsetof(struct io_rings, cq_overflow);
+	p->cq_off.cqes = offsetof(struct io_rings, cqes);
+	p->cq_off.flags = offsetof(struct io_rings, cq_flags);
+	p->cq_off.user_addr = cq_user_addr;
 }
 
 /*
- * Allocate an anonymous fd, this is what constitutes the application
- * visible backing of an io_uring instance. The application mmaps this
- * fd to gain access to the SQ/CQ ring details.
+ * Size the SQ and CQ rings for @entries SQ entries and p->flags, for
+ * setup and for IORING_REGISTER_RESIZE_RINGS.
  */
-static struct file *io_uring_get_file(struct io_ring_ctx *ctx)
+static int io_uring_fill_entries(unsigned entries, struct io_uring_params *p)
 {
-	return anon_inode_getfile_secure("[io_uring]", &io_uring_fops, ctx,
-					 O_RDWR | O_CLOEXEC, NULL);
-}
-
-static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
-				  struct io_uring_params __user *params)
-{
-	struct io_ring_ctx *ctx;
-	struct file *file;
-	int ret;
-
 	if (!entries)
 		return -EINVAL;
 	if (entries > IORING_MAX_ENTRIES) {
@@ -3507,6 +3790,48 @@ static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
 	} else {
 		p->cq_entries = 2 * p->sq_entries;
 	}
+	return 0;
+}
+
+static int io_uring_install_fd(struct io_ring_ctx *ctx, struct file *file)
+{
+	int ret, fd;
+
+	fd = get_unused_fd_flags(O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return fd;
+
+	ret = __io_uring_add_tctx_node(ctx);
+	if (ret) {
+		put_unused_fd(fd);
+		return ret;
+	}
+	fd_install(fd, file);
+	return fd;
+}
+
+/*
+ * Allocate an anonymous fd, this is what constitutes the application
+ * visible backing of an io_uring instance. The application mmaps this
+ * fd to gain access to the SQ/CQ ring details.
+ */
+static struct file *io_uring_get_file(struct io_ring_ctx *ctx)
+{
+	return anon_inode_getfile_secure("[io_uring]", &io_uring_fops, ctx,
+					 O_RDWR | O_CLOEXEC, NULL);
+}
+
+static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
+				  struct io_uring_params __user *params)
+{
+	struct io_ring_ctx *ctx;
+	struct file *file;
+	size_t sq_array_offset;
+	int ret;
+
+	ret = io_uring_fill_entries(entries, p);
+	if (ret)
+		return ret;
 
 	ctx = io_ring_ctx_alloc(p);
 	if (!ctx)
@@ -3566,7 +3891,7 @@ static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
 	mmgrab(current->mm);
 	ctx->mm_account = current->mm;
 
-	ret = io_allocate_scq_urings(ctx, p);
+	ret = io_allocate_scq_urings(ctx, p, &sq_array_offset);
 	if (ret)
 		goto err;
 
@@ -3579,23 +3904,7 @@ static __cold int io_uring_create(unsigned entries, struct io_uring_params *p,
 		goto err;
 	io_rsrc_node_switch(ctx, NULL);
 
-	memset(&p->sq_off, 0, sizeof(p->sq_off));
-	p->sq_off.head = offsetof(struct io_rings, sq.head);
-	p->sq_off.tail = offsetof(struct io_rings, sq.tail);
-	p->sq_off.ring_mask = offsetof(struct io_rings, sq_ring_mask);
-	p->sq_off.ring_entries = offsetof(struct io_rings, sq_ring_entries);
-	p->sq_off.flags = offsetof(struct io_rings, sq_flags);
-	p->sq_off.dropped = offsetof(struct io_rings, sq_dropped);
-	p->sq_off.array = (char *)ctx->sq_array - (char *)ctx->rings;
-
-	memset(&p->cq_off, 0, sizeof(p->cq_off));
-	p->cq_off.head = offsetof(struct io_rings, cq.head);
-	p->cq_off.tail = offsetof(struct io_rings, cq.tail);
-	p->cq_off.ring_mask = offsetof(struct io_rings, cq_ring_mask);
-	p->cq_off.ring_entries = offsetof(struct io_rings, cq_ring_entries);
-	p->cq_off.overflow = offsetof(struct io_rings, cq_overflow);
-	p->cq_off.cqes = offsetof(struct io_rings, cqes);
-	p->cq_off.flags = offsetof(struct io_rings, cq_flags);
+	io_fill_ring_offsets(p, sq_array_offset);
 
 	p->features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP |
 			IORING_FEAT_SUBMIT_STABLE | IORING_FEAT_RW_CUR_POS |
@@ -3661,7 +3970,8 @@ static long io_uring_setup(u32 entries, struct io_uring_params __user *params)
 			IORING_SETUP_R_DISABLED | IORING_SETUP_SUBMIT_ALL |
 			IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG |
 			IORING_SETUP_SQE128 | IORING_SETUP_CQE32 |
-			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN))
+			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN |
+			IORING_SETUP_NO_MMAP))
 		return -EINVAL;
 
 	return io_uring_create(entries, &p, params);
@@ -3952,6 +4262,110 @@ err:
 	return ret;
 }
 
+#define IORING_RESIZE_FLAGS	(IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP)
+
+/*
+ * Replace the rings with ones sized as for io_uring_setup() with @arg,
+ * carrying over the CQEs not reaped yet. The application maps the new
+ * rings, or passes new memory in the user_addr fields for NO_MMAP, and
+ * switches to them once this returns.
+ */
+static __cold int io_register_resize_rings(struct io_ring_ctx *ctx,
+					   void __user *arg)
+{
+	struct io_ring_mem n, o;
+	struct io_uring_params p;
+	size_t sq_array_offset;
+	unsigned int i, head, tail, cqe_shift = 0;
+	int ret;
+
+	/* old mappings must pin the rings they map, see io_uring_mmap() */
+	if (!IS_ENABLED(CONFIG_MMU))
+		return -EOPNOTSUPP;
+	/*
+	 * Only DEFER_TASKRUN rings post all their CQEs under uring_lock or
+	 * ->completion_lock, which keeps the CQ ring still while copying it.
+	 */
+	if (!(ctx->flags & IORING_SETUP_DEFER_TASKRUN))
+		return -EINVAL;
+	if (copy_from_user(&p, arg, sizeof(p)))
+		return -EFAULT;
+	if (p.flags & ~IORING_RESIZE_FLAGS ||
+	    memchr_inv(p.resv, 0, sizeof(p.resv)))
+		return -EINVAL;
+
+	ret = io_uring_fill_entries(p.sq_entries, &p);
+	if (ret)
+		return ret;
+
+	if (p.sq_entries == ctx->sq_entries && p.cq_entries == ctx->cq_entries) {
+		io_fill_ring_offsets(&p, (char *)ctx->sq_array - (char *)ctx->rings);
+		return copy_to_user(arg, &p, sizeof(p)) ? -EFAULT : 0;
+	}
+
+	ret = io_ring_mem_alloc(ctx, &p, &n, &sq_array_offset);
+	if (ret)
+		return ret;
+	io_fill_ring_offsets(&p, sq_array_offset);
+	if (copy_to_user(arg, &p, sizeof(p))) {
+		io_ring_mem_free(ctx, &n);
+		return -EFAULT;
+	}
+
+	mutex_lock(&ctx->mmap_lock);
+	spin_lock(&ctx->completion_lock);
+
+	/* SQEs queued but not submitted yet aren't carried over */
+	ret = -EBUSY;
+	if (READ_ONCE(ctx->rings->sq.tail) != ctx->cached_sq_head)
+		goto out;
+
+	head = READ_ONCE(ctx->rings->cq.head);
+	tail = ctx->cached_cq_tail;
+	ret = -EOVERFLOW;
+	if (tail - head > p.cq_entries)
+		goto out;
+
+	if (ctx->flags & IORING_SETUP_CQE32)
+		cqe_shift = 1;
+	for (i = head; i != tail; i++) {
+		unsigned int src = (i & (ctx->cq_entries - 1)) << cqe_shift;
+		unsigned int dst = (i & (p.cq_entries - 1)) << cqe_shift;
+
+		memcpy(&n.rings->cqes[dst], &ctx->rings->cqes[src],
+		       sizeof(struct io_uring_cqe) << cqe_shift);
+	}
+	n.rings->sq.head = ctx->cached_sq_head;
+	n.rings->sq.tail = ctx->cached_sq_head;
+	n.rings->cq.head = head;
+	n.rings->cq.tail = tail;
+	n.rings->sq_dropped = READ_ONCE(ctx->rings->sq_dropped);
+	atomic_set(&n.rings->sq_flags, atomic_read(&ctx->rings->sq_flags));
+	n.rings->cq_flags = READ_ONCE(ctx->rings->cq_flags);
+	n.rings->cq_overflow = READ_ONCE(ctx->rings->cq_overflow);
+
+	/* the cached CQE pointers point into the old ring */
+	ctx->cqe_cached = ctx->cqe_sentinel = NULL;
+
+	io_ring_mem_get(ctx, &o);
+	ctx->sq_entries = p.sq_entries;
+	ctx->cq_entries = p.cq_entries;
+	io_ring_mem_install(ctx, &n, sq_array_offset);
+	ret = 0;
+out:
+	spin_unlock(&ctx->completion_lock);
+	mutex_unlock(&ctx->mmap_lock);
+	if (ret) {
+		io_ring_mem_free(ctx, &n);
+		return ret;
+	}
+
+	/* wait for lockless users of the old rings, io_uring_poll() and co */
+	synchronize_rcu();
+	io_ring_mem_free(ctx, &o);
+	return 0;
+}
+
 static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			       void __user *arg, unsigned nr_args)
 	__releases(ctx->uring_lock)
@@ -4110,6 +4524,12 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_register_file_alloc_range(ctx, arg);
 		break;
+	case IORING_REGISTER_RESIZE_RINGS:
+		ret = -EINVAL;
+		if (!arg || nr_args != 1)
+			break;
+		ret = io_register_resize_rings(ctx, arg);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -4149,6 +4569,18 @@ out_fput:
 	return ret;
 }
 
+static struct ctl_table io_uring_sysctl_table[] = {
+	{
+		.procname	= "io_uring_alloc_cache_max",
+		.data		= &sysctl_io_uring_alloc_cache_max,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+	{}
+};
+
 static int __init io_uring_init(void)
 {
 #define __BUILD_BUG_VERIFY_OFFSET_SIZE(stype, eoffset, esize, ename) do { \
@@ -4192,6 +4624,7 @@ static int __init io_uring_init(void)
 	BUILD_BUG_SQE_ELEM(28, __u32,  hardlink_flags);
 	BUILD_BUG_SQE_ELEM(28, __u32,  xattr_flags);
 	BUILD_BUG_SQE_ELEM(28, __u32,  msg_ring_flags);
+	BUILD_BUG_SQE_ELEM(28, __u32,  futex_flags);
 	BUILD_BUG_SQE_ELEM(32, __u64,  user_data);
 	BUILD_BUG_SQE_ELEM(40, __u16,  buf_index);
 	BUILD_BUG_SQE_ELEM(40, __u16,  buf_group);
@@ -4224,6 +4657,8 @@ static int __init io_uring_init(void)
 	BUILD_BUG_ON(sizeof(atomic_t) != sizeof(u32));
 
 	io_uring_optable_init();
+	io_sqpoll_sysctl_init();
+	register_sysctl_init("kernel", io_uring_sysctl_table);
 
 	req_cachep = KMEM_CACHE(io_kiocb, SLAB_HWCACHE_ALIGN | SLAB_PANIC |
 				SLAB_ACCOUNT);
@@ -13,6 +13,10 @@
 #include "filetable.h"
 #include "msg_ring.h"
 
+/* CQEs copied from userspace and posted at a time by IORING_MSG_DATA_VEC */
+#define IO_MSG_VEC_BATCH	16
+#define IO_MSG_VEC_MAX		4096
+
 struct io_msg {
 	struct file			*file;
 	struct file			*src_file;
@@ -22,6 +26,7 @@ struct io_msg {
 	u32 src_fd;
 	u32 dst_fd;
 	u32 flags;
+	u64 vec;
 };
 
 static void io_double_unlock_ctx(struct io_ring_ctx *octx)
@@ -83,6 +88,68 @@ static int io_msg_ring_data(struct io_kiocb *req, unsigned int issue_flags)
 	return ret;
 }
 
+/*
+ * Inject a vector of CQEs into the target ring. The target is woken once
+ * for the whole vector rather than once per message, or only when it was
+ * idle with IORING_MSG_RING_WAKE_IDLE.
+ */
+static int io_msg_ring_data_vec(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_ring_ctx *target_ctx = req->file->private_data;
+	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
+	struct io_uring_msg_cqe __user *ucqes = u64_to_user_ptr(msg->vec);
+	struct io_uring_msg_cqe cqes[IO_MSG_VEC_BATCH];
+	bool locked = false, idle = false;
+	unsigned int done = 0;
+	int ret = 0;
+
+	if (msg->dst_fd || msg->user_data || (msg->flags & IORING_MSG_RING_CQE_SKIP))
+		return -EINVAL;
+	if (!msg->len || msg->len > IO_MSG_VEC_MAX)
+		return -EINVAL;
+	if (target_ctx->flags & IORING_SETUP_R_DISABLED)
+		return -EBADFD;
+
+	if (target_ctx->flags & IORING_SETUP_IOPOLL) {
+		if (unlikely(io_double_lock_ctx(target_ctx, issue_flags)))
+			return -EAGAIN;
+		locked = true;
+	}
+
+	while (done < msg->len) {
+		unsigned int i, nr = min_t(unsigned int, msg->len - done,
+					   IO_MSG_VEC_BATCH);
+		unsigned int posted;
+
+		if (copy_from_user(cqes, &ucqes[done], nr * sizeof(cqes[0]))) {
+			ret = -EFAULT;
+			break;
+		}
+		for (i = 0; i < nr; i++) {
+			if (cqes[i].resv) {
+				ret = -EINVAL;
+				break;
+			}
+		}
+		if (ret)
+			break;
+
+		posted = io_post_aux_cqes(target_ctx, cqes, nr,
+					  done ? NULL : &idle);
+		done += posted;
+		if (posted < nr) {
+			ret = -EOVERFLOW;
+			break;
+		}
+	}
+
+	if (locked)
+		io_double_unlock_ctx(target_ctx);
+	if (done && (idle || !(msg->flags & IORING_MSG_RING_WAKE_IDLE)))
+		io_cqring_wake(target_ctx);
+	return done ?: ret;
+}
+
 static struct file *io_msg_grab_file(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
@@ -144,6 +211,8 @@ static int io_msg_send_fd(struct io_kiocb *req, unsigned int issue_flags)
 
 	if (target_ctx == ctx)
 		return -EINVAL;
+	if (msg->flags & ~IORING_MSG_RING_CQE_SKIP)
+		return -EINVAL;
 	if (!src_file) {
 		src_file = io_msg_grab_file(req, issue_flags);
 		if (!src_file)
@@ -168,7 +237,8 @@ int io_msg_ring_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	msg->src_fd = READ_ONCE(sqe->addr3);
 	msg->dst_fd = READ_ONCE(sqe->file_index);
 	msg->flags = READ_ONCE(sqe->msg_ring_flags);
-	if (msg->flags & ~IORING_MSG_RING_CQE_SKIP)
+	msg->vec = READ_ONCE(sqe->addr3);
+	if (msg->flags & ~(IORING_MSG_RING_CQE_SKIP | IORING_MSG_RING_WAKE_IDLE))
 		return -EINVAL;
 
 	return 0;
@@ -190,6 +260,9 @@ int io_msg_ring(struct io_kiocb *req, unsigned int issue_flags)
 	case IORING_MSG_SEND_FD:
 		ret = io_msg_send_fd(req, issue_flags);
 		break;
+	case IORING_MSG_DATA_VEC:
+		ret = io_msg_ring_data_vec(req, issue_flags);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -6,6 +6,7 @@
 #include <linux/net.h>
 #include <linux/compat.h>
 #include <net/compat.h>
+#include <net/tcp.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -70,6 +71,12 @@ struct io_sr_msg {
 	struct io_kiocb 		*notif;
 };
 
+struct io_recvzc {
+	struct file			*file;
+	struct tcp_zerocopy_receive __user *uzc;
+	u16				flags;
+};
+
 int io_shutdown_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_shutdown *shutdown = io_kiocb_to_cmd(req, struct io_shutdown);
@@ -130,6 +137,7 @@ static struct io_async_msghdr *io_msg_alloc_async(struct io_kiocb *req,
 
 	if (!(issue_flags & IO_URING_F_UNLOCKED)) {
 		entry = io_alloc_cache_get(&ctx->netmsg_cache);
+		io_alloc_cache_account(req, entry);
 		if (entry) {
 			hdr = container_of(entry, struct io_async_msghdr, cache);
 			hdr->free_iov = NULL;
@@ -863,7 +871,7 @@ retry_multishot:
 	else
 		io_kbuf_recycle(req, issue_flags);
 
-	cflags = io_put_kbuf(req, issue_flags);
+	cflags = io_put_kbuf(req, ret, issue_flags);
 	if (kmsg->msg.msg_inq)
 		cflags |= IORING_CQE_F_SOCK_NONEMPTY;
 
@@ -966,7 +974,7 @@ out_free:
 	else
 		io_kbuf_recycle(req, issue_flags);
 
-	cflags = io_put_kbuf(req, issue_flags);
+	cflags = io_put_kbuf(req, ret, issue_flags);
 	if (msg.msg_inq)
 		cflags |= IORING_CQE_F_SOCK_NONEMPTY;
 
@@ -976,6 +984,78 @@ out_free:
 	return ret;
 }
 
+int io_recvzc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_recvzc *zc = io_kiocb_to_cmd(req, struct io_recvzc);
+
+	if (!IS_ENABLED(CONFIG_INET) || !IS_ENABLED(CONFIG_MMU))
+		return -EOPNOTSUPP;
+	if (unlikely(sqe->file_index || sqe->addr2 || sqe->len ||
+		     sqe->msg_flags || sqe->buf_index))
+		return -EINVAL;
+
+	zc->uzc = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	zc->flags = READ_ONCE(sqe->ioprio);
+	if (zc->flags & ~IORING_RECVSEND_POLL_FIRST)
+		return -EINVAL;
+	return 0;
+}
+
+/*
+ * Zero copy receive: full pages of TCP payload are mapped into the user's
+ * tcp mmap() area instead of being copied, see tcp_zerocopy_receive().
+ * Mapping the next batch over the same range releases the pages of the
+ * previous one, which is how the buffers are recycled.
+ */
+int io_recvzc(struct io_kiocb *req, unsigned int issue_flags)
+{
+#if defined(CONFIG_INET) && defined(CONFIG_MMU)
+	struct io_recvzc *zc = io_kiocb_to_cmd(req, struct io_recvzc);
+	struct tcp_zerocopy_receive args;
+	unsigned int cflags = 0;
+	struct socket *sock;
+	int ret;
+
+	if (!(req->flags & REQ_F_POLLED) &&
+	    (zc->flags & IORING_RECVSEND_POLL_FIRST))
+		return -EAGAIN;
+
+	sock = sock_from_file(req->file);
+	if (unlikely(!sock))
+		return -ENOTSOCK;
+	if (!sk_is_tcp(sock->sk))
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&args, zc->uzc, sizeof(args)))
+		return -EFAULT;
+
+	ret = tcp_zerocopy_receive_kern(sock->sk, &args);
+	if (!ret && !args.err && !args.length && args.copybuf_len <= 0 &&
+	    !args.recv_skip_hint) {
+		/* Nothing queued yet, retry once the socket is readable */
+		if (issue_flags & IO_URING_F_NONBLOCK)
+			return -EAGAIN;
+		ret = -EAGAIN;
+	}
+
+	if (!ret) {
+		ret = args.length;
+		if (args.copybuf_len > 0)
+			ret += args.copybuf_len;
+		if (args.inq)
+			cflags |= IORING_CQE_F_SOCK_NONEMPTY;
+		if (copy_to_user(zc->uzc, &args, sizeof(args)))
+			ret = -EFAULT;
+	}
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, ret, cflags);
+	return IOU_OK;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
 void io_send_zc_cleanup(struct io_kiocb *req)
 {
 	struct io_sr_msg *zc = io_kiocb_to_cmd(req, struct io_sr_msg);
@@ -26,6 +26,7 @@
 #include "openclose.h"
 #include "uring_cmd.h"
 #include "epoll.h"
+#include "futex.h"
 #include "statx.h"
 #include "net.h"
 #include "msg_ring.h"
@@ -65,6 +66,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "READV",
 		.prep			= io_prep_rw,
 		.issue			= io_read,
@@ -83,6 +85,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "WRITEV",
 		.prep			= io_prep_rw,
 		.issue			= io_write,
@@ -107,6 +110,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "READ_FIXED",
 		.prep			= io_prep_rw,
 		.issue			= io_read,
@@ -123,6 +127,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "WRITE_FIXED",
 		.prep			= io_prep_rw,
 		.issue			= io_write,
@@ -189,6 +194,7 @@ const struct io_op_def io_op_defs[] = {
 	[IORING_OP_TIMEOUT] = {
 		.audit_skip		= 1,
 		.async_size		= sizeof(struct io_timeout_data),
+		.async_cache		= IO_ASYNC_CACHE_TIMEOUT,
 		.name			= "TIMEOUT",
 		.prep			= io_timeout_prep,
 		.issue			= io_timeout,
@@ -223,6 +229,7 @@ const struct io_op_def io_op_defs[] = {
 	[IORING_OP_LINK_TIMEOUT] = {
 		.audit_skip		= 1,
 		.async_size		= sizeof(struct io_timeout_data),
+		.async_cache		= IO_ASYNC_CACHE_TIMEOUT,
 		.name			= "LINK_TIMEOUT",
 		.prep			= io_link_timeout_prep,
 		.issue			= io_no_issue,
@@ -283,6 +290,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "READ",
 		.prep			= io_prep_rw,
 		.issue			= io_read,
@@ -299,6 +307,7 @@ const struct io_op_def io_op_defs[] = {
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
 		.async_size		= sizeof(struct io_async_rw),
+		.async_cache		= IO_ASYNC_CACHE_RW,
 		.name			= "WRITE",
 		.prep			= io_prep_rw,
 		.issue			= io_write,
@@ -489,10 +498,12 @@ const struct io_op_def io_op_defs[] = {
 		.name			= "URING_CMD",
 		.iopoll			= 1,
 		.iopoll_queue		= 1,
-		.async_size		= uring_cmd_pdu_size(1),
+		.async_size		= sizeof(struct io_async_cmd),
+		.async_cache		= IO_ASYNC_CACHE_URING_CMD,
 		.prep			= io_uring_cmd_prep,
 		.issue			= io_uring_cmd,
 		.prep_async		= io_uring_cmd_prep_async,
+		.cleanup		= io_uring_cmd_cleanup,
 	},
 	[IORING_OP_SEND_ZC] = {
 		.name			= "SEND_ZC",
@@ -531,6 +542,66 @@ const struct io_op_def io_op_defs[] = {
 		.prep			= io_eopnotsupp_prep,
 #endif
 	},
+	[IORING_OP_RECV_ZC] = {
+		.name			= "RECV_ZC",
+		.needs_file		= 1,
+		.unbound_nonreg_file	= 1,
+		.pollin			= 1,
+		.audit_skip		= 1,
+		.ioprio			= 1,
+#if defined(CONFIG_NET)
+		.prep			= io_recvzc_prep,
+		.issue			= io_recvzc,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
+	[IORING_OP_FUTEX_WAIT] = {
+		.name			= "FUTEX_WAIT",
+#if defined(CONFIG_FUTEX)
+		.prep			= io_futex_prep,
+		.issue			= io_futex_wait,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
+	[IORING_OP_FUTEX_WAKE] = {
+		.name			= "FUTEX_WAKE",
+#if defined(CONFIG_FUTEX)
+		.prep			= io_futex_prep,
+		.issue			= io_futex_wake,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
+	[IORING_OP_FUTEX_WAITV] = {
+		.name			= "FUTEX_WAITV",
+#if defined(CONFIG_FUTEX)
+		.prep			= io_futexv_prep,
+		.issue			= io_futexv_wait,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
+	[IORING_OP_GETDENTS] = {
+		.needs_file		= 1,
+		.name			= "GETDENTS",
+		.prep			= io_getdents_prep,
+		.issue			= io_getdents,
+	},
+	[IORING_OP_STATX_BATCH] = {
+		.needs_file		= 1,
+		.audit_skip		= 1,
+		.name			= "STATX_BATCH",
+		.prep			= io_statx_batch_prep,
+		.issue			= io_statx_batch,
+	},
+	[IORING_OP_OPENAT_BATCH] = {
+		.needs_file		= 1,
+		.name			= "OPENAT_BATCH",
+		.prep			= io_openat_batch_prep,
+		.issue			= io_openat_batch,
+	},
 };
 
 const char *io_uring_get_opcode(u8 opcode)
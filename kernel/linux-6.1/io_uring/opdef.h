@@ -29,6 +29,8 @@ struct io_op_def {
 	unsigned		iopoll_queue : 1;
 	/* opcode specific path will handle ->async_data allocation if needed */
 	unsigned		manual_alloc : 1;
+	/* ctx cache to recycle ->async_data through, see io_req_async_cache() */
+	unsigned		async_cache : 2;
 	/* size of async data needed, if any */
 	unsigned short		async_size;
 
@@ -41,6 +43,13 @@ struct io_op_def {
 	void (*fail)(struct io_kiocb *);
 };
 
+enum {
+	IO_ASYNC_CACHE_NONE,
+	IO_ASYNC_CACHE_RW,
+	IO_ASYNC_CACHE_URING_CMD,
+	IO_ASYNC_CACHE_TIMEOUT,
+};
+
 extern const struct io_op_def io_op_defs[];
 
 void io_uring_optable_init(void);
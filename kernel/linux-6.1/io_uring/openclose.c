@@ -7,6 +7,7 @@
 #include <linux/fsnotify.h>
 #include <linux/namei.h>
 #include <linux/io_uring.h>
+#include <linux/sched/signal.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -25,6 +26,17 @@ struct io_open {
 	unsigned long			nofile;
 };
 
+/* Entries per OPENAT_BATCH, to bound the time spent in one io-wq work item */
+#define IO_OPENAT_BATCH_MAX	1024
+
+struct io_open_batch {
+	struct file			*file;
+	struct io_uring_batch_entry __user *entries;
+	unsigned int			nr;
+	struct open_how			how;
+	unsigned long			nofile;
+};
+
 struct io_close {
 	struct file			*file;
 	int				fd;
@@ -175,6 +187,109 @@ void io_open_cleanup(struct io_kiocb *req)
 		putname(open->filename);
 }
 
+int io_openat_batch_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_open_batch *ob = io_kiocb_to_cmd(req, struct io_open_batch);
+	u64 mode = READ_ONCE(sqe->off);
+	u64 flags = READ_ONCE(sqe->open_flags);
+
+	if (sqe->buf_index || sqe->splice_fd_in || sqe->addr2)
+		return -EINVAL;
+	if (req->flags & REQ_F_FIXED_FILE)
+		return -EBADF;
+
+	ob->entries = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	ob->nr = READ_ONCE(sqe->len);
+	if (!ob->nr || ob->nr > IO_OPENAT_BATCH_MAX)
+		return -EINVAL;
+
+	ob->how = build_open_how(flags, mode);
+	if (!(ob->how.flags & O_PATH) && force_o_largefile())
+		ob->how.flags |= O_LARGEFILE;
+	ob->nofile = rlimit(RLIMIT_NOFILE);
+	return 0;
+}
+
+static int io_openat_batch_one(struct io_open_batch *ob, const struct path *root,
+			       const char __user *name, const struct open_flags *op)
+{
+	struct filename *filename;
+	struct file *file;
+	int fd;
+
+	filename = getname(name);
+	if (IS_ERR(filename))
+		return PTR_ERR(filename);
+
+	fd = __get_unused_fd_flags(ob->how.flags, ob->nofile);
+	if (fd < 0)
+		goto out;
+
+	file = do_file_open_root(root, filename->name, op);
+	if (IS_ERR(file)) {
+		put_unused_fd(fd);
+		fd = PTR_ERR(file);
+		goto out;
+	}
+	fsnotify_open(file);
+	fd_install(fd, file);
+out:
+	putname(filename);
+	return fd;
+}
+
+/*
+ * Open each entry beneath the directory the request holds. Entries are
+ * independent: one failing to open doesn't stop the others, its error
+ * is reported in its res instead.
+ */
+int io_openat_batch(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_open_batch *ob = io_kiocb_to_cmd(req, struct io_open_batch);
+	struct open_flags op;
+	unsigned int i;
+	int ret;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	ret = build_open_flags(&ob->how, &op);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < ob->nr; i++) {
+		struct io_uring_batch_entry __user *e = &ob->entries[i];
+		u64 name;
+		int fd;
+
+		if (get_user(name, &e->name)) {
+			ret = -EFAULT;
+			break;
+		}
+		fd = io_openat_batch_one(ob, &req->file->f_path,
+					 u64_to_user_ptr(name), &op);
+		if (put_user(fd, &e->res)) {
+			/* userspace can't learn about it, don't leak it */
+			if (fd >= 0)
+				close_fd(fd);
+			ret = -EFAULT;
+			break;
+		}
+		if (fatal_signal_pending(current)) {
+			i++;
+			break;
+		}
+		cond_resched();
+	}
+	if (i)
+		ret = i;
+err:
+	if (ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, ret, 0);
+	return IOU_OK;
+}
+
 int __io_close_fixed(struct io_ring_ctx *ctx, unsigned int issue_flags,
 		     unsigned int offset)
 {
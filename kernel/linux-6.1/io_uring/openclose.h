@@ -10,5 +10,8 @@ void io_open_cleanup(struct io_kiocb *req);
 int io_openat2_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_openat2(struct io_kiocb *req, unsigned int issue_flags);
 
+int io_openat_batch_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
+int io_openat_batch(struct io_kiocb *req, unsigned int issue_flags);
+
 int io_close_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_close(struct io_kiocb *req, unsigned int issue_flags);
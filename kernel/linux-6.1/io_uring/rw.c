@@ -336,7 +336,7 @@ static int kiocb_done(struct io_kiocb *req, ssize_t ret,
 			 */
 			io_req_io_end(req);
 			io_req_set_res(req, final_ret,
-				       io_put_kbuf(req, issue_flags));
+				       io_put_kbuf(req, final_ret, issue_flags));
 			return IOU_OK;
 		}
 	} else {
@@ -385,7 +385,7 @@ static struct iovec *__io_import_iovec(int ddir, struct io_kiocb *req,
 			rw->len = sqe_len;
 		}
 
-		ret = import_single_range(ddir, buf, sqe_len, s->fast_iov, iter);
+		ret = import_ubuf(ddir, buf, sqe_len, iter);
 		if (ret)
 			return ERR_PTR(ret);
 		return NULL;
@@ -489,7 +489,7 @@ static void io_req_map_rw(struct io_kiocb *req, const struct iovec *iovec,
 	io->free_iovec = iovec;
 	io->bytes_done = 0;
 	/* can only be fixed buffers, no need to do anything */
-	if (iov_iter_is_bvec(iter))
+	if (iov_iter_is_bvec(iter) || iter_is_ubuf(iter))
 		return;
 	if (!iovec) {
 		unsigned iov_off = 0;
@@ -508,14 +508,15 @@ static void io_req_map_rw(struct io_kiocb *req, const struct iovec *iovec,
 }
 
 static int io_setup_async_rw(struct io_kiocb *req, const struct iovec *iovec,
-			     struct io_rw_state *s, bool force)
+			     struct io_rw_state *s, bool force,
+			     unsigned int issue_flags)
 {
 	if (!force && !io_op_defs[req->opcode].prep_async)
 		return 0;
 	if (!req_has_async_data(req)) {
 		struct io_async_rw *iorw;
 
-		if (io_alloc_async_data(req)) {
+		if (io_alloc_async_data_cached(req, issue_flags)) {
 			kfree(iovec);
 			return -ENOMEM;
 		}
@@ -743,7 +744,7 @@ int io_read(struct io_kiocb *req, unsigned int issue_flags)
 	if (force_nonblock) {
 		/* If the file doesn't support async, just async punt */
 		if (unlikely(!io_file_supports_nowait(req))) {
-			ret = io_setup_async_rw(req, iovec, s, true);
+			ret = io_setup_async_rw(req, iovec, s, true, issue_flags);
 			return ret ?: -EAGAIN;
 		}
 		kiocb->ki_flags |= IOCB_NOWAIT;
@@ -791,7 +792,7 @@ int io_read(struct io_kiocb *req, unsigned int issue_flags)
 	 */
 	iov_iter_restore(&s->iter, &s->iter_state);
 
-	ret2 = io_setup_async_rw(req, iovec, s, true);
+	ret2 = io_setup_async_rw(req, iovec, s, true, issue_flags);
 	iovec = NULL;
 	if (ret2) {
 		ret = ret > 0 ? ret : ret2;
@@ -949,7 +950,7 @@ int io_write(struct io_kiocb *req, unsigned int issue_flags)
 			 * the bytes already written.
 			 */
 			iov_iter_save_state(&s->iter, &s->iter_state);
-			ret = io_setup_async_rw(req, iovec, s, true);
+			ret = io_setup_async_rw(req, iovec, s, true, issue_flags);
 
 			io = req->async_data;
 			if (io)
@@ -964,7 +965,7 @@ done:
 	} else {
 copy_iov:
 		iov_iter_restore(&s->iter, &s->iter_state);
-		ret = io_setup_async_rw(req, iovec, s, false);
+		ret = io_setup_async_rw(req, iovec, s, false, issue_flags);
 		if (!ret) {
 			if (kiocb->ki_flags & IOCB_WRITE)
 				kiocb_end_write(req);
@@ -996,16 +997,17 @@ void io_rw_fail(struct io_kiocb *req)
 int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 {
 	struct io_wq_work_node *pos, *start, *prev;
-	unsigned int poll_flags = BLK_POLL_NOSLEEP;
+	unsigned int poll_flags = 0;
 	DEFINE_IO_COMP_BATCH(iob);
 	int nr_events = 0;
 
 	/*
 	 * Only spin for completions if we don't have multiple devices hanging
-	 * off our complete list.
+	 * off our complete list. When we do spin, the oldest request may
+	 * first sleep if its queue does hybrid polling.
 	 */
 	if (ctx->poll_multi_queue || force_nonspin)
-		poll_flags |= BLK_POLL_ONESHOT;
+		poll_flags |= BLK_POLL_ONESHOT | BLK_POLL_NOSLEEP;
 
 	wq_list_for_each(pos, start, &ctx->iopoll_list) {
 		struct io_kiocb *req = container_of(pos, struct io_kiocb, comp_list);
@@ -1035,6 +1037,7 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 			return ret;
 		else if (ret)
 			poll_flags |= BLK_POLL_ONESHOT;
+		poll_flags |= BLK_POLL_NOSLEEP;
 
 		/* iopoll may have completed current req */
 		if (!rq_list_empty(iob.req_list) ||
@@ -1058,7 +1061,7 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		if (unlikely(req->flags & REQ_F_CQE_SKIP))
 			continue;
 
-		req->cqe.flags = io_put_kbuf(req, 0);
+		req->cqe.flags = io_put_kbuf(req, req->cqe.res, 0);
 		if (unlikely(!__io_fill_cqe_req(ctx, req))) {
 			spin_lock(&ctx->completion_lock);
 			io_req_cqe_overflow(req);
@@ -11,6 +11,8 @@
 #include <linux/audit.h>
 #include <linux/security.h>
 #include <linux/cpuset.h>
+#include <linux/sched/clock.h>
+#include <linux/sysctl.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -25,6 +27,31 @@ enum {
 	IO_SQ_THREAD_SHOULD_PARK,
 };
 
+/*
+ * System wide sqpoll tunables:
+ *
+ * io_uring_sqpoll_share: rings a process may place on one SQPOLL thread
+ * without asking for IORING_SETUP_ATTACH_WQ. A new ring joins the least
+ * busy of the process' eligible threads, 0 gives every ring its own.
+ *
+ * io_uring_sqpoll_spinners: SQPOLL threads allowed to busy poll idle
+ * rings at the same time. Threads over the budget go to sleep as soon as
+ * they run out of work, 0 means no limit.
+ *
+ * io_uring_sqpoll_adaptive_idle: spin for about twice the gap the rings
+ * usually leave between submissions, within sq_thread_idle, rather than
+ * always for the whole sq_thread_idle.
+ */
+static int sysctl_io_uring_sqpoll_share __read_mostly;
+static int sysctl_io_uring_sqpoll_spinners __read_mostly;
+static int sysctl_io_uring_sqpoll_adaptive_idle __read_mostly;
+
+static atomic_t io_sqpoll_nr_spinning = ATOMIC_INIT(0);
+
+/* sqds that automatically shared rings may join, under io_sqd_pool_lock */
+static LIST_HEAD(io_sqd_pool);
+static DEFINE_MUTEX(io_sqd_pool_lock);
+
 void io_sq_thread_unpark(struct io_sq_data *sqd)
 	__releases(&sqd->lock)
 {
@@ -70,6 +97,10 @@ void io_put_sq_data(struct io_sq_data *sqd)
 	if (refcount_dec_and_test(&sqd->refs)) {
 		WARN_ON_ONCE(atomic_read(&sqd->park_pending));
 
+		mutex_lock(&io_sqd_pool_lock);
+		list_del_init(&sqd->pool_node);
+		mutex_unlock(&io_sqd_pool_lock);
+
 		io_sq_thread_stop(sqd);
 		kfree(sqd);
 	}
@@ -92,6 +123,7 @@ void io_sq_thread_finish(struct io_ring_ctx *ctx)
 	if (sqd) {
 		io_sq_thread_park(sqd);
 		list_del_init(&ctx->sqd_list);
+		sqd->nr_ctx--;
 		io_sqd_update_thread_idle(sqd);
 		io_sq_thread_unpark(sqd);
 
@@ -130,6 +162,33 @@ static struct io_sq_data *io_attach_sq_data(struct io_uring_params *p)
 	return sqd;
 }
 
+/*
+ * Pick the thread of this process with the lowest submission rate that
+ * still has room for another ring, if automatic sharing is enabled.
+ */
+static struct io_sq_data *io_share_sq_data(void)
+{
+	int limit = READ_ONCE(sysctl_io_uring_sqpoll_share);
+	struct io_sq_data *sqd, *best = NULL;
+
+	if (limit <= 0)
+		return NULL;
+
+	mutex_lock(&io_sqd_pool_lock);
+	list_for_each_entry(sqd, &io_sqd_pool, pool_node) {
+		if (sqd->task_tgid != current->tgid || !READ_ONCE(sqd->thread))
+			continue;
+		if (READ_ONCE(sqd->nr_ctx) >= limit)
+			continue;
+		if (!best || READ_ONCE(sqd->sq_rate) < READ_ONCE(best->sq_rate))
+			best = sqd;
+	}
+	if (best && !refcount_inc_not_zero(&best->refs))
+		best = NULL;
+	mutex_unlock(&io_sqd_pool_lock);
+	return best;
+}
+
 static struct io_sq_data *io_get_sq_data(struct io_uring_params *p,
 					 bool *attached)
 {
@@ -145,6 +204,12 @@ static struct io_sq_data *io_get_sq_data(struct io_uring_params *p,
 		/* fall through for EPERM case, setup new sqd/task */
 		if (PTR_ERR(sqd) != -EPERM)
 			return sqd;
+	} else if (!(p->flags & IORING_SETUP_SQ_AFF)) {
+		sqd = io_share_sq_data();
+		if (sqd) {
+			*attached = true;
+			return sqd;
+		}
 	}
 
 	sqd = kzalloc(sizeof(*sqd), GFP_KERNEL);
@@ -154,6 +219,7 @@ static struct io_sq_data *io_get_sq_data(struct io_uring_params *p,
 	atomic_set(&sqd->park_pending, 0);
 	refcount_set(&sqd->refs, 1);
 	INIT_LIST_HEAD(&sqd->ctx_list);
+	INIT_LIST_HEAD(&sqd->pool_node);
 	mutex_init(&sqd->lock);
 	init_waitqueue_head(&sqd->wait);
 	init_completion(&sqd->exited);
@@ -203,6 +269,84 @@ static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 	return ret;
 }
 
+/* fold the submissions of the last second or more into ->sq_rate */
+static void io_sqd_update_rate(struct io_sq_data *sqd, int submitted)
+{
+	unsigned long elapsed = jiffies - sqd->sq_rate_stamp;
+	u64 rate;
+
+	sqd->sq_submitted += submitted;
+	if (elapsed < HZ)
+		return;
+
+	rate = div64_ul((u64)sqd->sq_submitted * HZ, elapsed);
+	WRITE_ONCE(sqd->sq_rate, (3 * (u64)sqd->sq_rate + rate) / 4);
+	sqd->sq_submitted = 0;
+	sqd->sq_rate_stamp = jiffies;
+}
+
+/*
+ * Called when work shows up after @idle_start, the time the thread last
+ * ran out of it. The gap between bursts tells how long spinning has to
+ * last to catch the next one, averaged over the last few bursts.
+ */
+static void io_sqd_note_gap(struct io_sq_data *sqd, u64 idle_start)
+{
+	u64 gap = local_clock() - idle_start;
+
+	if (!sqd->sq_idle_gap_ns)
+		sqd->sq_idle_gap_ns = gap;
+	else
+		sqd->sq_idle_gap_ns = (7 * sqd->sq_idle_gap_ns + gap) / 8;
+}
+
+/*
+ * How long to spin once the rings run dry. Twice the usual gap catches
+ * most bursts; if that's beyond sq_thread_idle, spinning rarely pays off
+ * and the thread only spins for a tick before going to sleep.
+ */
+static unsigned long io_sqd_spin_window(struct io_sq_data *sqd)
+{
+	u64 max_ns = jiffies_to_nsecs(sqd->sq_thread_idle);
+	u64 ns;
+
+	if (!READ_ONCE(sysctl_io_uring_sqpoll_adaptive_idle) ||
+	    !sqd->sq_idle_gap_ns)
+		return sqd->sq_thread_idle;
+
+	ns = 2 * sqd->sq_idle_gap_ns;
+	if (ns > max_ns)
+		return 1;
+	return max(nsecs_to_jiffies(ns), 1UL);
+}
+
+/*
+ * May the thread spin on idle rings? Takes a slot of the system wide
+ * budget if there is one, see io_uring_sqpoll_spinners, and notes it in
+ * @counted for io_sqd_spin_put().
+ */
+static bool io_sqd_spin_get(bool *counted)
+{
+	int budget = READ_ONCE(sysctl_io_uring_sqpoll_spinners);
+
+	if (*counted || budget <= 0)
+		return true;
+	if (atomic_inc_return(&io_sqpoll_nr_spinning) <= budget) {
+		*counted = true;
+		return true;
+	}
+	atomic_dec(&io_sqpoll_nr_spinning);
+	return false;
+}
+
+static void io_sqd_spin_put(bool *counted)
+{
+	if (*counted) {
+		atomic_dec(&io_sqpoll_nr_spinning);
+		*counted = false;
+	}
+}
+
 static bool io_sqd_handle_event(struct io_sq_data *sqd)
 {
 	bool did_sig = false;
@@ -224,6 +368,8 @@ static int io_sq_thread(void *data)
 	struct io_sq_data *sqd = data;
 	struct io_ring_ctx *ctx;
 	unsigned long timeout = 0;
+	bool idle = false, spin_ok = true, counted = false;
+	u64 idle_start = 0;
 	char buf[TASK_COMM_LEN];
 	DEFINE_WAIT(wait);
 
@@ -244,28 +390,45 @@ static int io_sq_thread(void *data)
 	audit_uring_exit(true, 0);
 
 	mutex_lock(&sqd->lock);
+	sqd->sq_rate_stamp = jiffies;
 	while (1) {
 		bool cap_entries, sqt_spin = false;
+		int submitted = 0;
 
 		if (io_sqd_events_pending(sqd) || signal_pending(current)) {
 			if (io_sqd_handle_event(sqd))
 				break;
-			timeout = jiffies + sqd->sq_thread_idle;
+			timeout = jiffies + io_sqd_spin_window(sqd);
 		}
 
 		cap_entries = !list_is_singular(&sqd->ctx_list);
 		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
 			int ret = __io_sq_thread(ctx, cap_entries);
 
+			if (ret > 0)
+				submitted += ret;
 			if (!sqt_spin && (ret > 0 || !wq_list_empty(&ctx->iopoll_list)))
 				sqt_spin = true;
 		}
 		if (io_run_task_work())
 			sqt_spin = true;
+		io_sqd_update_rate(sqd, submitted);
+
+		if (sqt_spin) {
+			if (idle)
+				io_sqd_note_gap(sqd, idle_start);
+			idle = false;
+			io_sqd_spin_put(&counted);
+		} else if (!idle) {
+			/* out of work, spin only within the CPU budget */
+			idle = true;
+			idle_start = local_clock();
+			spin_ok = io_sqd_spin_get(&counted);
+		}
 
-		if (sqt_spin || !time_after(jiffies, timeout)) {
+		if (sqt_spin || (spin_ok && !time_after(jiffies, timeout))) {
 			if (sqt_spin)
-				timeout = jiffies + sqd->sq_thread_idle;
+				timeout = jiffies + io_sqd_spin_window(sqd);
 			if (unlikely(need_resched())) {
 				mutex_unlock(&sqd->lock);
 				cond_resched();
@@ -274,6 +437,7 @@ static int io_sq_thread(void *data)
 			continue;
 		}
 
+		io_sqd_spin_put(&counted);
 		prepare_to_wait(&sqd->wait, &wait, TASK_INTERRUPTIBLE);
 		if (!io_sqd_events_pending(sqd) && !task_work_pending(current)) {
 			bool needs_sched = true;
@@ -310,9 +474,12 @@ static int io_sq_thread(void *data)
 		}
 
 		finish_wait(&sqd->wait, &wait);
-		timeout = jiffies + sqd->sq_thread_idle;
+		timeout = jiffies + io_sqd_spin_window(sqd);
+		if (idle)
+			spin_ok = io_sqd_spin_get(&counted);
 	}
 
+	io_sqd_spin_put(&counted);
 	io_uring_cancel_generic(true, sqd);
 	sqd->thread = NULL;
 	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
@@ -384,6 +551,7 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 
 		io_sq_thread_park(sqd);
 		list_add(&ctx->sqd_list, &sqd->ctx_list);
+		sqd->nr_ctx++;
 		io_sqd_update_thread_idle(sqd);
 		/* don't attach to a dying SQPOLL thread, would be racy */
 		ret = (attached && !sqd->thread) ? -ENXIO : 0;
@@ -429,6 +597,12 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 		wake_up_new_task(tsk);
 		if (ret)
 			goto err;
+
+		if (sqd->sq_cpu == -1) {
+			mutex_lock(&io_sqd_pool_lock);
+			list_add_tail(&sqd->pool_node, &io_sqd_pool);
+			mutex_unlock(&io_sqd_pool_lock);
+		}
 	} else if (p->flags & IORING_SETUP_SQ_AFF) {
 		/* Can't have SQ_AFF without SQPOLL */
 		ret = -EINVAL;
@@ -459,3 +633,37 @@ __cold int io_sqpoll_wq_cpu_affinity(struct io_ring_ctx *ctx,
 
 	return ret;
 }
+
+static struct ctl_table io_sqpoll_sysctl_table[] = {
+	{
+		.procname	= "io_uring_sqpoll_share",
+		.data		= &sysctl_io_uring_sqpoll_share,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+	{
+		.procname	= "io_uring_sqpoll_spinners",
+		.data		= &sysctl_io_uring_sqpoll_spinners,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+	{
+		.procname	= "io_uring_sqpoll_adaptive_idle",
+		.data		= &sysctl_io_uring_sqpoll_adaptive_idle,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
+	{}
+};
+
+void __init io_sqpoll_sysctl_init(void)
+{
+	register_sysctl_init("kernel", io_sqpoll_sysctl_table);
+}
@@ -7,11 +7,21 @@ struct io_sq_data {
 
 	/* ctx's that are using this sqd */
 	struct list_head	ctx_list;
+	unsigned		nr_ctx;
+
+	/* on io_sqd_pool, if the thread can be shared automatically */
+	struct list_head	pool_node;
 
 	struct task_struct	*thread;
 	struct wait_queue_head	wait;
 
 	unsigned		sq_thread_idle;
+	/* adaptive idle, see io_sqd_spin_window() */
+	u64			sq_idle_gap_ns;
+	/* submissions per second, averaged, see io_sqd_update_rate() */
+	unsigned		sq_rate;
+	unsigned		sq_submitted;
+	unsigned long		sq_rate_stamp;
 	int			sq_cpu;
 	pid_t			task_pid;
 	pid_t			task_tgid;
@@ -28,3 +38,4 @@ void io_sq_thread_unpark(struct io_sq_data *sqd);
 void io_put_sq_data(struct io_sq_data *sqd);
 int io_sqpoll_wait_sq(struct io_ring_ctx *ctx);
 int io_sqpoll_wq_cpu_affinity(struct io_ring_ctx *ctx, cpumask_var_t mask);
+void io_sqpoll_sysctl_init(void);
@@ -3,6 +3,7 @@
 #include <linux/errno.h>
 #include <linux/file.h>
 #include <linux/io_uring.h>
+#include <linux/sched/signal.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -64,6 +65,89 @@ int io_statx(struct io_kiocb *req, unsigned int issue_flags)
 	return IOU_OK;
 }
 
+/* Entries per STATX_BATCH, to bound the time spent in one io-wq work item */
+#define IO_STATX_BATCH_MAX	1024
+
+struct io_statx_batch {
+	struct file			*file;
+	struct io_uring_batch_entry __user *entries;
+	unsigned int			nr;
+	unsigned int			mask;
+	unsigned int			flags;
+};
+
+int io_statx_batch_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_statx_batch *sb = io_kiocb_to_cmd(req, struct io_statx_batch);
+
+	if (sqe->buf_index || sqe->splice_fd_in || sqe->addr2)
+		return -EINVAL;
+	if (req->flags & REQ_F_FIXED_FILE)
+		return -EBADF;
+
+	sb->entries = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	sb->nr = READ_ONCE(sqe->len);
+	sb->mask = READ_ONCE(sqe->off);
+	sb->flags = READ_ONCE(sqe->statx_flags);
+	if (!sb->nr || sb->nr > IO_STATX_BATCH_MAX)
+		return -EINVAL;
+	if (sb->flags & AT_EMPTY_PATH)
+		return -EINVAL;
+	return 0;
+}
+
+/*
+ * statx() each entry beneath the directory the request holds, so the walk
+ * starts from a pinned path instead of looking up the dirfd every time.
+ */
+int io_statx_batch(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_statx_batch *sb = io_kiocb_to_cmd(req, struct io_statx_batch);
+	int lookup_flags = getname_statx_lookup_flags(sb->flags);
+	unsigned int i;
+	int ret = 0;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	for (i = 0; i < sb->nr; i++) {
+		struct io_uring_batch_entry __user *e = &sb->entries[i];
+		struct statx __user *buffer;
+		struct filename *filename;
+		u64 name, statxbuf;
+		int res;
+
+		if (get_user(name, &e->name) || get_user(statxbuf, &e->statxbuf)) {
+			ret = -EFAULT;
+			break;
+		}
+		buffer = u64_to_user_ptr(statxbuf);
+
+		filename = getname_flags(u64_to_user_ptr(name), lookup_flags, NULL);
+		if (IS_ERR(filename)) {
+			res = PTR_ERR(filename);
+		} else {
+			res = do_statx_root(&req->file->f_path, filename,
+					    sb->flags, sb->mask, buffer);
+			putname(filename);
+		}
+		if (put_user(res, &e->res)) {
+			ret = -EFAULT;
+			break;
+		}
+		if (fatal_signal_pending(current)) {
+			i++;
+			break;
+		}
+		cond_resched();
+	}
+
+	if (!i && ret < 0)
+		req_set_fail(req);
+	io_req_set_res(req, i ?: ret, 0);
+	return IOU_OK;
+}
+
 void io_statx_cleanup(struct io_kiocb *req)
 {
 	struct io_statx *sx = io_kiocb_to_cmd(req, struct io_statx);
@@ -5,6 +5,7 @@
 #include <linux/io_uring.h>
 #include <linux/security.h>
 #include <linux/nospec.h>
+#include <linux/uio.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -65,6 +66,7 @@ EXPORT_SYMBOL_GPL(io_uring_cmd_done);
 int io_uring_cmd_prep_async(struct io_kiocb *req)
 {
 	struct io_uring_cmd *ioucmd = io_kiocb_to_cmd(req, struct io_uring_cmd);
+	struct io_async_cmd *ac = req->async_data;
 	size_t cmd_size;
 
 	BUILD_BUG_ON(uring_cmd_pdu_size(0) != 16);
@@ -72,10 +74,21 @@ int io_uring_cmd_prep_async(struct io_kiocb *req)
 
 	cmd_size = uring_cmd_pdu_size(req->ctx->flags & IORING_SETUP_SQE128);
 
-	memcpy(req->async_data, ioucmd->cmd, cmd_size);
+	memcpy(ac->sqe_cmd, ioucmd->cmd, cmd_size);
+	ac->vec = NULL;
 	return 0;
 }
 
+void io_uring_cmd_cleanup(struct io_kiocb *req)
+{
+	struct io_async_cmd *ac = req->async_data;
+
+	if (req_has_async_data(req)) {
+		kvfree(ac->vec);
+		ac->vec = NULL;
+	}
+}
+
 int io_uring_cmd_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_uring_cmd *ioucmd = io_kiocb_to_cmd(req, struct io_uring_cmd);
@@ -135,7 +148,7 @@ int io_uring_cmd(struct io_kiocb *req, unsigned int issue_flags)
 	ret = file->f_op->uring_cmd(ioucmd, issue_flags);
 	if (ret == -EAGAIN) {
 		if (!req_has_async_data(req)) {
-			if (io_alloc_async_data(req))
+			if (io_alloc_async_data_cached(req, issue_flags))
 				return -ENOMEM;
 			io_uring_cmd_prep_async(req);
 		}
@@ -160,3 +173,91 @@ int io_uring_cmd_import_fixed(u64 ubuf, unsigned long len, int rw,
 	return io_import_fixed(rw, iter, req->imu, ubuf, len);
 }
 EXPORT_SYMBOL_GPL(io_uring_cmd_import_fixed);
+
+/*
+ * Import an iovec array whose segments all lie in the registered buffer
+ * of the command, for vectored passthrough. The bvec array built for it
+ * is kept in ->async_data until the request is freed, since the bio
+ * mapped from @iter uses it directly.
+ */
+int io_uring_cmd_import_fixed_vec(const struct iovec __user *uvec,
+				  unsigned long nr_segs, int rw,
+				  struct iov_iter *iter, void *ioucmd,
+				  unsigned int issue_flags)
+{
+	struct io_kiocb *req = cmd_to_io_kiocb(ioucmd);
+	size_t max_vecs = 0, total = 0;
+	struct io_async_cmd *ac;
+	struct bio_vec *vec;
+	struct iovec *iov;
+	unsigned long i, nr = 0;
+	int ret;
+
+	if (!nr_segs)
+		return -EINVAL;
+	iov = iovec_from_user(uvec, nr_segs, 0, NULL, req->ctx->compat);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	for (i = 0; i < nr_segs; i++) {
+		total += iov[i].iov_len;
+		if (total > MAX_RW_COUNT) {
+			ret = -EINVAL;
+			goto out_free_iov;
+		}
+		/* a segment may start and end in partial pages */
+		max_vecs += (iov[i].iov_len >> PAGE_SHIFT) + 2;
+	}
+
+	vec = kvmalloc_array(max_vecs, sizeof(*vec), GFP_KERNEL);
+	if (!vec) {
+		ret = -ENOMEM;
+		goto out_free_iov;
+	}
+
+	for (i = 0; i < nr_segs; i++) {
+		struct iov_iter it;
+
+		ret = io_import_fixed(rw, &it, req->imu,
+				      (u64)(uintptr_t)iov[i].iov_base,
+				      iov[i].iov_len);
+		if (ret)
+			goto out_free_vec;
+		while (iov_iter_count(&it)) {
+			const struct bio_vec *bv = it.bvec;
+			size_t len = min_t(size_t, bv->bv_len - it.iov_offset,
+					   iov_iter_count(&it));
+
+			vec[nr].bv_page = bv->bv_page;
+			vec[nr].bv_offset = bv->bv_offset + it.iov_offset;
+			vec[nr].bv_len = len;
+			nr++;
+			iov_iter_advance(&it, len);
+		}
+	}
+
+	if (!req_has_async_data(req)) {
+		if (io_alloc_async_data_cached(req, issue_flags)) {
+			ret = -ENOMEM;
+			goto out_free_vec;
+		}
+		io_uring_cmd_prep_async(req);
+		((struct io_uring_cmd *)ioucmd)->cmd = req->async_data;
+	}
+	ac = req->async_data;
+	/* a retry from io-wq imports again */
+	kvfree(ac->vec);
+	ac->vec = vec;
+	req->flags |= REQ_F_NEED_CLEANUP;
+
+	kfree(iov);
+	iov_iter_bvec(iter, rw, vec, nr, total);
+	return 0;
+
+out_free_vec:
+	kvfree(vec);
+out_free_iov:
+	kfree(iov);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(io_uring_cmd_import_fixed_vec);
@@ -3,6 +3,7 @@
 int io_uring_cmd(struct io_kiocb *req, unsigned int issue_flags);
 int io_uring_cmd_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_uring_cmd_prep_async(struct io_kiocb *req);
+void io_uring_cmd_cleanup(struct io_kiocb *req);
 
 /*
  * The URING_CMD payload starts at 'cmd' in the first sqe, and continues into
@@ -11,3 +12,11 @@ int io_uring_cmd_prep_async(struct io_kiocb *req);
 #define uring_cmd_pdu_size(is_sqe128)				\
 	((1 + !!(is_sqe128)) * sizeof(struct io_uring_sqe) -	\
 		offsetof(struct io_uring_sqe, cmd))
+
+/* ->async_data of URING_CMD */
+struct io_async_cmd {
+	/* the command, copied out of the SQE; ioucmd->cmd points here */
+	u8			sqe_cmd[uring_cmd_pdu_size(1)];
+	/* segments of a vectored fixed buffer, io_uring_cmd_import_fixed_vec() */
+	struct bio_vec		*vec;
+};
@@ -1269,6 +1269,23 @@ static int __htab_percpu_map_update_elem(struct bpf_map *map, void *key,
 	b = __select_bucket(htab, hash);
 	head = &b->head;
 
+	/*
+	 * The value of an existing element is overwritten in place below
+	 * without anything the bucket lock protects, exactly as a program
+	 * does through the pointer bpf_map_lookup_elem() returns.  So counter
+	 * style updates of keys already in the map need not take the lock at
+	 * all; only inserts do.
+	 */
+	if (map_flags != BPF_NOEXIST) {
+		l_old = lookup_nulls_elem_raw(head, hash, key, key_size,
+					      htab->n_buckets);
+		if (l_old) {
+			pcpu_copy_value(htab, htab_elem_get_ptr(l_old, key_size),
+					value, onallcpus);
+			return 0;
+		}
+	}
+
 	ret = htab_lock_bucket(htab, b, hash, &flags);
 	if (ret)
 		return ret;
@@ -2198,6 +2215,19 @@ out:
 	return num_elems;
 }
 
+/* Element allocator statistics of BPF_F_NO_PREALLOC maps */
+static void htab_map_show_fdinfo(struct bpf_map *map, struct seq_file *m)
+{
+	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
+
+	if (htab_is_prealloc(htab))
+		return;
+
+	bpf_mem_alloc_show_fdinfo(&htab->ma, "elem", m);
+	if (htab_is_percpu(htab))
+		bpf_mem_alloc_show_fdinfo(&htab->pcpu_ma, "pcpu_value", m);
+}
+
 BTF_ID_LIST_SINGLE(htab_map_btf_ids, struct, bpf_htab)
 const struct bpf_map_ops htab_map_ops = {
 	.map_meta_equal = bpf_map_meta_equal,
@@ -2212,6 +2242,7 @@ const struct bpf_map_ops htab_map_ops = {
 	.map_delete_elem = htab_map_delete_elem,
 	.map_gen_lookup = htab_map_gen_lookup,
 	.map_seq_show_elem = htab_map_seq_show_elem,
+	.map_show_fdinfo = htab_map_show_fdinfo,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
 	BATCH_OPS(htab),
@@ -2384,6 +2415,7 @@ const struct bpf_map_ops htab_percpu_map_ops = {
 	.map_delete_elem = htab_map_delete_elem,
 	.map_lookup_percpu_elem = htab_percpu_map_lookup_percpu_elem,
 	.map_seq_show_elem = htab_percpu_map_seq_show_elem,
+	.map_show_fdinfo = htab_map_show_fdinfo,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
 	BATCH_OPS(htab_percpu),
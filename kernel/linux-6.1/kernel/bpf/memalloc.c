@@ -6,6 +6,7 @@
 #include <linux/irq_work.h>
 #include <linux/bpf_mem_alloc.h>
 #include <linux/memcontrol.h>
+#include <linux/seq_file.h>
 #include <asm/local.h>
 
 /* Any context (including NMI) BPF specific memory allocator.
@@ -32,9 +33,23 @@
  *
  * Every allocated objected is padded with extra 8 bytes that contains
  * struct llist_node.
+ *
+ * The watermarks adapt to the allocation rate of each cache. A refill
+ * cannot happen before the irq_work runs, so what a program allocates
+ * between irq_work_raise() and bpf_mem_refill() has to come from what is
+ * left below low_watermark. Each refill looks at how much that was, plus
+ * the allocations that found the cache empty, keeps an EWMA of it and
+ * sets low_watermark to twice the average, between the static watermarks
+ * and BPF_MA_MAX_SCALE times them. Bursty users get a deeper cache;
+ * quiet ones drift back to the static sizes and free_bulk() trims them.
  */
 #define LLIST_NODE_SZ sizeof(struct llist_node)
 
+#define BPF_MA_MAX_SCALE	8
+/* drain_ewma is kept in 1/BPF_MA_EWMA_ONE units */
+#define BPF_MA_EWMA_SHIFT	4
+#define BPF_MA_EWMA_ONE		(1 << BPF_MA_EWMA_SHIFT)
+
 /* similar to kmalloc, but sizeof == 8 bucket is gone */
 static u8 size_index[24] __ro_after_init = {
 	3,	/* 8 */
@@ -98,6 +113,15 @@ struct bpf_mem_cache {
 	int free_cnt;
 	int low_watermark, high_watermark, batch;
 	int percpu_size;
+	/* static watermarks and the EWMA the current ones are derived from */
+	int base_low_watermark, base_high_watermark;
+	int drain_ewma;
+
+	/* statistics for fdinfo; racy, like free_cnt outside of 'active' */
+	unsigned long nr_allocs;
+	unsigned long nr_empty;
+	unsigned long nr_empty_seen;
+	unsigned long nr_refills;
 
 	struct rcu_head rcu;
 	struct llist_head free_by_rcu;
@@ -287,6 +311,33 @@ static void free_bulk(struct bpf_mem_cache *c)
 	do_call_rcu(c);
 }
 
+static void set_watermarks(struct bpf_mem_cache *c, int low)
+{
+	c->low_watermark = low;
+	c->high_watermark = low * c->base_high_watermark / c->base_low_watermark;
+	c->batch = max((c->high_watermark - c->low_watermark) / 4 * 3, 1);
+}
+
+/* Called before a refill, see the comment on top */
+static void adapt_watermarks(struct bpf_mem_cache *c, int cnt)
+{
+	unsigned long empty = READ_ONCE(c->nr_empty);
+	int drained, low;
+
+	drained = max(c->low_watermark - cnt, 0) +
+		  min_t(unsigned long, empty - c->nr_empty_seen, INT_MAX / 4);
+	c->nr_empty_seen = empty;
+
+	/* weight 1/4 for the new sample */
+	c->drain_ewma += (drained * BPF_MA_EWMA_ONE - c->drain_ewma) / 4;
+
+	low = clamp(2 * c->drain_ewma >> BPF_MA_EWMA_SHIFT,
+		    c->base_low_watermark,
+		    c->base_low_watermark * BPF_MA_MAX_SCALE);
+	if (low != c->low_watermark)
+		set_watermarks(c, low);
+}
+
 static void bpf_mem_refill(struct irq_work *work)
 {
 	struct bpf_mem_cache *c = container_of(work, struct bpf_mem_cache, refill_work);
@@ -294,12 +345,14 @@ static void bpf_mem_refill(struct irq_work *work)
 
 	/* Racy access to free_cnt. It doesn't need to be 100% accurate */
 	cnt = c->free_cnt;
-	if (cnt < c->low_watermark)
+	if (cnt < c->low_watermark) {
+		adapt_watermarks(c, cnt);
+		c->nr_refills++;
 		/* irq_work runs on this cpu and kmalloc will allocate
 		 * from the current numa node which is what we want here.
 		 */
 		alloc_bulk(c, c->batch, NUMA_NO_NODE);
-	else if (cnt > c->high_watermark)
+	} else if (cnt > c->high_watermark)
 		free_bulk(c);
 }
 
@@ -338,7 +391,10 @@ static void prefill_mem_cache(struct bpf_mem_cache *c, int cpu)
 		c->low_watermark = max(32 * 256 / c->unit_size, 1);
 		c->high_watermark = max(96 * 256 / c->unit_size, 3);
 	}
-	c->batch = max((c->high_watermark - c->low_watermark) / 4 * 3, 1);
+	c->base_low_watermark = c->low_watermark;
+	c->base_high_watermark = c->high_watermark;
+	c->drain_ewma = c->low_watermark * BPF_MA_EWMA_ONE / 2;
+	set_watermarks(c, c->low_watermark);
 
 	/* To avoid consuming memory assume that 1st run of bpf
 	 * prog won't be doing more than 4 map_update_elem from
@@ -553,14 +609,19 @@ static void notrace *unit_alloc(struct bpf_mem_cache *c)
 	local_irq_save(flags);
 	if (local_inc_return(&c->active) == 1) {
 		llnode = __llist_del_first(&c->free_llist);
-		if (llnode)
+		if (llnode) {
 			cnt = --c->free_cnt;
+			c->nr_allocs++;
+		}
 	}
 	local_dec(&c->active);
 	local_irq_restore(flags);
 
 	WARN_ON(cnt < 0);
 
+	if (!llnode)
+		c->nr_empty++;
+
 	if (cnt < c->low_watermark)
 		irq_work_raise(c);
 	return llnode;
@@ -647,3 +708,41 @@ void notrace bpf_mem_cache_free(struct bpf_mem_alloc *ma, void *ptr)
 
 	unit_free(this_cpu_ptr(ma->cache), ptr);
 }
+
+struct bpf_mem_stats {
+	unsigned long allocs, empty, refills;
+	int low_watermark;
+};
+
+static void add_cache_stats(struct bpf_mem_cache *c, struct bpf_mem_stats *st)
+{
+	st->allocs += READ_ONCE(c->nr_allocs);
+	st->empty += READ_ONCE(c->nr_empty);
+	st->refills += READ_ONCE(c->nr_refills);
+	st->low_watermark = max(st->low_watermark, READ_ONCE(c->low_watermark));
+}
+
+/* Totals over all cpus and caches, as "<prefix>_<stat>:" fdinfo lines */
+void bpf_mem_alloc_show_fdinfo(struct bpf_mem_alloc *ma, const char *prefix,
+			       struct seq_file *m)
+{
+	struct bpf_mem_stats st = {};
+	int cpu, i;
+
+	if (ma->cache) {
+		for_each_possible_cpu(cpu)
+			add_cache_stats(per_cpu_ptr(ma->cache, cpu), &st);
+	}
+	if (ma->caches) {
+		for_each_possible_cpu(cpu) {
+			for (i = 0; i < NUM_CACHES; i++)
+				add_cache_stats(&per_cpu_ptr(ma->caches, cpu)->cache[i],
+						&st);
+		}
+	}
+
+	seq_printf(m, "%s_allocs:\t%lu\n", prefix, st.allocs);
+	seq_printf(m, "%s_alloc_empty:\t%lu\n", prefix, st.empty);
+	seq_printf(m, "%s_refills:\t%lu\n", prefix, st.refills);
+	seq_printf(m, "%s_max_low_watermark:\t%d\n", prefix, st.low_watermark);
+}
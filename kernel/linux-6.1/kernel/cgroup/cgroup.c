@@ -1761,6 +1761,14 @@ static int css_populate_dir(struct cgroup_subsys_state *css)
 							 cgroup_psi_files, true);
 				if (ret < 0)
 					return ret;
+
+				/* Outside the psi_levels= aggregation levels */
+				if (!cgroup_psi(cgrp)->enabled) {
+					int i;
+
+					for (i = 0; i < NR_PSI_RESOURCES; i++)
+						cgroup_file_show(&cgrp->psi_files[i], false);
+				}
 			}
 		} else {
 			cgroup_addrm_files(css, cgrp,
@@ -3862,6 +3870,12 @@ static ssize_t cgroup_pressure_write(struct kernfs_open_file *of,
 		return -ENOENT;
 
 	psi = cgroup_psi(cgrp);
+	if (psi->account != psi) {
+		/* Its tasks' states are accounted to an ancestor */
+		cgroup_kn_unlock(of->kn);
+		return -EOPNOTSUPP;
+	}
+
 	if (psi->enabled != enable) {
 		int i;
 
@@ -278,6 +278,7 @@ typedef enum {
 	CS_SCHED_LOAD_BALANCE,
 	CS_SPREAD_PAGE,
 	CS_SPREAD_SLAB,
+	CS_LLC_ALIGN,
 } cpuset_flagbits_t;
 
 /* convenient tests for these bits */
@@ -321,6 +322,11 @@ static inline int is_spread_slab(const struct cpuset *cs)
 	return test_bit(CS_SPREAD_SLAB, &cs->flags);
 }
 
+static inline int is_llc_aligned(const struct cpuset *cs)
+{
+	return test_bit(CS_LLC_ALIGN, &cs->flags);
+}
+
 static inline int is_partition_valid(const struct cpuset *cs)
 {
 	return cs->partition_root_state > 0;
@@ -1773,18 +1779,38 @@ static void update_sibling_cpumasks(struct cpuset *parent, struct cpuset *cs,
 	rcu_read_unlock();
 }
 
+/*
+ * Drop the CPUs of @mask whose last level cache is shared with CPUs
+ * outside of it, so that only whole LLCs are left. LLC spans partition
+ * the CPUs, hence dropping one never breaks up another and this can be
+ * done in place.
+ */
+static void cpuset_llc_round(struct cpumask *mask)
+{
+	int cpu;
+
+	lockdep_assert_cpus_held();
+
+	for_each_cpu(cpu, mask)
+		if (!cpumask_subset(sched_llc_cpumask(cpu), mask))
+			cpumask_clear_cpu(cpu, mask);
+}
+
+static int __update_cpumask(struct cpuset *cs, struct cpuset *trialcs);
+
 /**
  * update_cpumask - update the cpus_allowed mask of a cpuset and all tasks in it
  * @cs: the cpuset to consider
  * @trialcs: trial cpuset
  * @buf: buffer of cpu numbers written to this cpuset
+ *
+ * With cpus.llc_align set, the CPUs written are rounded down to whole
+ * last level caches.
  */
 static int update_cpumask(struct cpuset *cs, struct cpuset *trialcs,
 			  const char *buf)
 {
 	int retval;
-	struct tmpmasks tmp;
-	bool invalidate = false;
 
 	/* top_cpuset.cpus_allowed tracks cpu_online_mask; it's read-only */
 	if (cs == &top_cpuset)
@@ -1808,6 +1834,24 @@ static int update_cpumask(struct cpuset *cs, struct cpuset *trialcs,
 			return -EINVAL;
 	}
 
+	if (is_llc_aligned(cs))
+		cpuset_llc_round(trialcs->cpus_allowed);
+
+	return __update_cpumask(cs, trialcs);
+}
+
+/*
+ * __update_cpumask - apply the cpus_allowed of @trialcs to @cs
+ *
+ * The second half of update_cpumask(), for callers that build the new
+ * mask themselves.
+ */
+static int __update_cpumask(struct cpuset *cs, struct cpuset *trialcs)
+{
+	int retval;
+	struct tmpmasks tmp;
+	bool invalidate = false;
+
 	/* Nothing to do if the cpus didn't change */
 	if (cpumask_equal(cs->cpus_allowed, trialcs->cpus_allowed))
 		return 0;
@@ -1908,6 +1952,55 @@ static int update_cpumask(struct cpuset *cs, struct cpuset *trialcs,
 	return 0;
 }
 
+/*
+ * Round the cpus_allowed of @cs down to whole last level caches, for
+ * when cpus.llc_align is turned on or the cache topology changed.
+ */
+static int update_llc_align(struct cpuset *cs)
+{
+	struct cpuset *trialcs;
+	int retval;
+
+	trialcs = alloc_trial_cpuset(cs);
+	if (!trialcs)
+		return -ENOMEM;
+
+	cpuset_llc_round(trialcs->cpus_allowed);
+	retval = __update_cpumask(cs, trialcs);
+	free_cpuset(trialcs);
+	return retval;
+}
+
+/*
+ * A CPU coming online may join a cache domain partly owned by an LLC
+ * aligned cpuset. Drop that cache domain from the cpuset rather than
+ * let it straddle: its remaining CPUs go back to the parent.
+ */
+static void cpuset_llc_rebalance(void)
+{
+	struct cpuset *cs;
+	struct cgroup_subsys_state *pos_css;
+
+	cpus_read_lock();
+	mutex_lock(&cpuset_mutex);
+	rcu_read_lock();
+	cpuset_for_each_descendant_pre(cs, pos_css, &top_cpuset) {
+		if (!is_llc_aligned(cs) || !css_tryget_online(&cs->css))
+			continue;
+		rcu_read_unlock();
+
+		if (update_llc_align(cs))
+			pr_warn("cpuset: failed to LLC align %*pbl\n",
+				cpumask_pr_args(cs->cpus_allowed));
+
+		rcu_read_lock();
+		css_put(&cs->css);
+	}
+	rcu_read_unlock();
+	mutex_unlock(&cpuset_mutex);
+	cpus_read_unlock();
+}
+
 /*
  * Migrate memory region from one set of nodes to another.  This is
  * performed asynchronously as it can be called from process migration path
@@ -2712,6 +2805,7 @@ typedef enum {
 	FILE_MEMORY_PRESSURE,
 	FILE_SPREAD_PAGE,
 	FILE_SPREAD_SLAB,
+	FILE_LLC_ALIGN,
 } cpuset_filetype_t;
 
 static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
@@ -2753,6 +2847,11 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_SPREAD_SLAB:
 		retval = update_flag(CS_SPREAD_SLAB, cs, val);
 		break;
+	case FILE_LLC_ALIGN:
+		retval = update_flag(CS_LLC_ALIGN, cs, val);
+		if (!retval && val)
+			retval = update_llc_align(cs);
+		break;
 	default:
 		retval = -EINVAL;
 		break;
@@ -2920,6 +3019,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_spread_page(cs);
 	case FILE_SPREAD_SLAB:
 		return is_spread_slab(cs);
+	case FILE_LLC_ALIGN:
+		return is_llc_aligned(cs);
 	default:
 		BUG();
 	}
@@ -3166,6 +3267,14 @@ static struct cftype dfl_files[] = {
 		.flags = CFTYPE_DEBUG,
 	},
 
+	{
+		.name = "cpus.llc_align",
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_LLC_ALIGN,
+		.flags = CFTYPE_NOT_ON_ROOT,
+	},
+
 	{ }	/* terminate */
 };
 
@@ -3810,6 +3919,10 @@ static void cpuset_hotplug_workfn(struct work_struct *work)
 		rcu_read_unlock();
 	}
 
+	/* new CPUs may have joined the caches of LLC aligned cpusets */
+	if (cpus_updated && on_dfl)
+		cpuset_llc_rebalance();
+
 	/* rebuild sched domains if cpus_allowed has changed */
 	if (cpus_updated || force_rebuild) {
 		force_rebuild = false;
@@ -10,6 +10,17 @@
 static DEFINE_SPINLOCK(cgroup_rstat_lock);
 static DEFINE_PER_CPU(raw_spinlock_t, cgroup_rstat_cpu_lock);
 
+/*
+ * Subtrees whose readers found cgroup_rstat_lock busy, flushed together
+ * by the deferred flusher. The delay batches readers, so the lock is
+ * taken at most once per window for all of them.
+ */
+#define CGROUP_RSTAT_DEFER_DELAY	(HZ / 100 ?: 1)
+
+static void cgroup_rstat_deferred_workfn(struct work_struct *work);
+static LLIST_HEAD(cgroup_rstat_deferred);
+static DECLARE_DELAYED_WORK(cgroup_rstat_deferred_work, cgroup_rstat_deferred_workfn);
+
 static void cgroup_base_stat_flush(struct cgroup *cgrp, int cpu);
 
 static struct cgroup_rstat_cpu *cgroup_rstat_cpu(struct cgroup *cgrp, int cpu)
@@ -174,6 +185,7 @@ __diag_pop();
 static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 	__releases(&cgroup_rstat_lock) __acquires(&cgroup_rstat_lock)
 {
+	u64 start = get_jiffies_64();
 	int cpu;
 
 	lockdep_assert_held(&cgroup_rstat_lock);
@@ -216,6 +228,9 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 			spin_lock_irq(&cgroup_rstat_lock);
 		}
 	}
+
+	/* Everything updated before @start is in; see cgroup_rstat_flush_bounded() */
+	WRITE_ONCE(cgrp->rstat_flushed, start);
 }
 
 /**
@@ -255,6 +270,101 @@ void cgroup_rstat_flush_irqsafe(struct cgroup *cgrp)
 	spin_unlock_irqrestore(&cgroup_rstat_lock, flags);
 }
 
+/* Whether @cgrp or any of its descendants has updates not yet flushed */
+static bool cgroup_rstat_pending(struct cgroup *cgrp)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
+
+		/* Racy, like the test in cgroup_rstat_updated() */
+		if (data_race(rstatc->updated_children) != cgrp ||
+		    data_race(rstatc->updated_next))
+			return true;
+	}
+
+	return false;
+}
+
+/* Start of the latest flush covering @cgrp: rooted at it or an ancestor */
+static u64 cgroup_rstat_flushed(struct cgroup *cgrp)
+{
+	u64 flushed = 0;
+
+	for (; cgrp; cgrp = cgroup_parent(cgrp))
+		flushed = max(flushed, READ_ONCE(cgrp->rstat_flushed));
+
+	return flushed;
+}
+
+static void cgroup_rstat_flush_defer(struct cgroup *cgrp)
+{
+	if (test_and_set_bit(CGRP_RSTAT_DEFERRED, &cgrp->flags))
+		return;
+
+	cgroup_get(cgrp);
+	if (llist_add(&cgrp->rstat_defer_node, &cgroup_rstat_deferred))
+		queue_delayed_work(system_unbound_wq, &cgroup_rstat_deferred_work,
+				   CGROUP_RSTAT_DEFER_DELAY);
+}
+
+static void cgroup_rstat_deferred_workfn(struct work_struct *work)
+{
+	struct llist_node *list = llist_del_all(&cgroup_rstat_deferred);
+	struct cgroup *cgrp, *next;
+	u64 start = get_jiffies_64();
+
+	llist_for_each_entry_safe(cgrp, next, list, rstat_defer_node) {
+		clear_bit(CGRP_RSTAT_DEFERRED, &cgrp->flags);
+
+		/* An ancestor queued alongside may have covered it already */
+		if (cgroup_rstat_flushed(cgrp) < start && cgroup_rstat_pending(cgrp))
+			cgroup_rstat_flush(cgrp);
+
+		cgroup_put(cgrp);
+	}
+}
+
+/**
+ * cgroup_rstat_flush_bounded - flush stats in @cgrp's subtree, if stale
+ * @cgrp: target cgroup
+ * @max_age: staleness the caller tolerates, in jiffies
+ *
+ * Like cgroup_rstat_flush(), but leaves cgroup_rstat_lock alone when it
+ * can: when nothing in the subtree has pending updates, or when a flush
+ * covering it, rooted at @cgrp or an ancestor, started within @max_age.
+ * When the stats are older but still within twice @max_age and another
+ * flush holds the lock, the subtree is queued for the deferred flusher
+ * and the caller reads the stats as they are. Past that, the caller
+ * flushes the subtree itself. Readers thus see stats at most 2 * @max_age
+ * old, and only the subtree they read is ever flushed on their behalf.
+ *
+ * This function may block.
+ */
+void cgroup_rstat_flush_bounded(struct cgroup *cgrp, unsigned long max_age)
+{
+	u64 now = get_jiffies_64();
+	u64 flushed;
+
+	might_sleep();
+
+	if (!cgroup_rstat_pending(cgrp))
+		return;
+
+	flushed = cgroup_rstat_flushed(cgrp);
+	if (time_before_eq64(now, flushed + max_age))
+		return;
+
+	if (time_before_eq64(now, flushed + 2 * max_age) &&
+	    spin_is_locked(&cgroup_rstat_lock)) {
+		cgroup_rstat_flush_defer(cgrp);
+		return;
+	}
+
+	cgroup_rstat_flush(cgrp);
+}
+
 /**
  * cgroup_rstat_flush_hold - flush stats in @cgrp's subtree and hold
  * @cgrp: target cgroup
@@ -17,6 +17,7 @@
 #include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/hash.h>
+#include <linux/jhash.h>
 #include <linux/tick.h>
 #include <linux/sysfs.h>
 #include <linux/dcache.h>
@@ -4792,6 +4793,7 @@ static void free_event_rcu(struct rcu_head *head)
 	if (event->ns)
 		put_pid_ns(event->ns);
 	perf_event_free_filter(event);
+	kfree(event->stack_ids);
 	kmem_cache_free(perf_event_cache, event);
 }
 
@@ -7204,7 +7206,9 @@ void perf_output_sample(struct perf_output_handle *handle,
 	if (sample_type & PERF_SAMPLE_READ)
 		perf_output_read(handle, event);
 
-	if (sample_type & PERF_SAMPLE_CALLCHAIN) {
+	if (sample_type & PERF_SAMPLE_STACK_ID) {
+		perf_output_put(handle, data->stack_id);
+	} else if (sample_type & PERF_SAMPLE_CALLCHAIN) {
 		int size = 1;
 
 		size += data->callchain->nr;
@@ -7490,6 +7494,62 @@ perf_callchain(struct perf_event *event, struct pt_regs *regs)
 	return callchain ?: &__empty_callchain;
 }
 
+#define PERF_STACK_IDS_BITS	10
+
+/*
+ * PERF_SAMPLE_STACK_ID: return the id of @callchain, writing it out as
+ * a PERF_RECORD_STACK_ID first unless @event did so already.  A sampling
+ * profiler sees the same few thousand stacks over and over, and this is
+ * what keeps them out of every sample.
+ *
+ * event->stack_ids remembers the ids written, direct mapped; a stack
+ * that lost its slot to another one is simply written again.  The id is
+ * a 64-bit hash of the ips, collisions are not worth handling.  Only the
+ * NMI or interrupt of the one CPU the event runs on gets here.
+ */
+static u64 perf_stack_id(struct perf_event *event,
+			 struct perf_callchain_entry *callchain)
+{
+	struct perf_output_handle handle;
+	struct perf_sample_data sample;
+	struct perf_stack_event {
+		struct perf_event_header	header;
+		u64				stack_id;
+		u64				nr;
+	} rec;
+	u32 words = callchain->nr * (sizeof(u64) / sizeof(u32));
+	u64 id, *slot;
+
+	id = (u64)jhash2((u32 *)callchain->ip, words, 0) << 32 |
+	     jhash2((u32 *)callchain->ip, words, callchain->nr);
+	if (!id)
+		id = 1;		/* 0 is a free slot */
+
+	slot = &event->stack_ids[hash_64(id, PERF_STACK_IDS_BITS)];
+	if (READ_ONCE(*slot) == id)
+		return id;
+
+	rec.header.type	= PERF_RECORD_STACK_ID;
+	rec.header.misc	= 0;
+	rec.header.size	= sizeof(rec) + callchain->nr * sizeof(u64);
+	rec.stack_id	= id;
+	rec.nr		= callchain->nr;
+
+	perf_event_header__init_id(&rec.header, &sample, event);
+	/* Not remembered if lost, so the next sample tries again */
+	if (perf_output_begin(&handle, &sample, event, rec.header.size))
+		return id;
+
+	perf_output_put(&handle, rec);
+	__output_copy(&handle, callchain->ip, callchain->nr * sizeof(u64));
+	perf_event__output_id_sample(event, &handle, &sample);
+
+	perf_output_end(&handle);
+
+	WRITE_ONCE(*slot, id);
+	return id;
+}
+
 void perf_prepare_sample(struct perf_event_header *header,
 			 struct perf_sample_data *data,
 			 struct perf_event *event,
@@ -7520,7 +7580,10 @@ void perf_prepare_sample(struct perf_event_header *header,
 		if (filtered_sample_type & PERF_SAMPLE_CALLCHAIN)
 			data->callchain = perf_callchain(event, regs);
 
-		size += data->callchain->nr;
+		if (sample_type & PERF_SAMPLE_STACK_ID)
+			data->stack_id = perf_stack_id(event, data->callchain);
+		else
+			size += data->callchain->nr;
 
 		header->size += size * sizeof(u64);
 	}
@@ -11966,6 +12029,16 @@ perf_event_alloc(struct perf_event_attr *attr, int cpu,
 		}
 	}
 
+	/* Inherited events have their own, they may write to another buffer */
+	if (event->attr.sample_type & PERF_SAMPLE_STACK_ID) {
+		event->stack_ids = kcalloc(1 << PERF_STACK_IDS_BITS,
+					   sizeof(u64), GFP_KERNEL);
+		if (!event->stack_ids) {
+			err = -ENOMEM;
+			goto err_callchain_buffer;
+		}
+	}
+
 	err = security_perf_event_alloc(event);
 	if (err)
 		goto err_callchain_buffer;
@@ -12034,6 +12107,15 @@ static int perf_copy_attr(struct perf_event_attr __user *uattr,
 	if (attr->sample_type & ~(PERF_SAMPLE_MAX-1))
 		return -EINVAL;
 
+	/*
+	 * Stack ids refer to PERF_RECORD_STACK_IDs earlier in the buffer,
+	 * which an overwritable buffer may have lost.
+	 */
+	if ((attr->sample_type & PERF_SAMPLE_STACK_ID) &&
+	    (!(attr->sample_type & PERF_SAMPLE_CALLCHAIN) ||
+	     attr->write_backward))
+		return -EINVAL;
+
 	if (attr->read_format & ~(PERF_FORMAT_MAX-1))
 		return -EINVAL;
 
@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Sampling lock contention profiler
+ *
+ * Attaches to the lock:contention_begin and lock:contention_end
+ * tracepoints that all the sleeping and spinning lock slow paths already
+ * have, and for one in every sample_period contended acquisitions on a
+ * CPU records how long the waiter waited, keyed by the call site that
+ * took the lock. Nothing is traced: the samples go into per-CPU tables
+ * of call sites, each with a log2 histogram of the wait times, which
+ * are summed up when read. Unsampled contentions cost a per-CPU counter
+ * increment at begin and a compare at end, so this can stay enabled on
+ * production hosts, unlike lockdep's lock_stat.
+ *
+ * <debugfs>/lock_contention/
+ *   enable         0/1, or lock_contention=on on the command line
+ *   sample_period  sample one in this many contentions per CPU (100)
+ *   sites          call sites by total sampled wait; write to reset
+ *
+ * The call site is the first return address on the stack of the waiter
+ * outside the lock and scheduler text, i.e. the caller of spin_lock(),
+ * mutex_lock(), down_read() and friends.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/log2.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/debug.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/stacktrace.h>
+#include <linux/tracepoint.h>
+#include <linux/vmalloc.h>
+#include <trace/events/lock.h>
+
+#define LOCKPROF_DIR		"lock_contention"
+
+#define LOCKPROF_SITE_BITS	7
+#define LOCKPROF_SITES		(1 << LOCKPROF_SITE_BITS)	/* per CPU */
+#define LOCKPROF_PROBES		8
+#define LOCKPROF_BUCKETS	32	/* ilog2(ns), up to ~2s */
+#define LOCKPROF_STACK		16
+#define LOCKPROF_SPIN_DEPTH	4	/* task, softirq, hardirq, nmi */
+
+struct lockprof_site {
+	unsigned long	ip;
+	unsigned int	flags;		/* LCB_F_* of the lock */
+	unsigned int	count;
+	u64		total_ns;
+	u64		max_ns;
+	u32		hist[LOCKPROF_BUCKETS];
+};
+
+struct lockprof_cpu {
+	unsigned int			countdown;
+	/* Sampled spinning waits; spinners do not sleep or migrate */
+	int				depth;
+	struct lock_contention_wait	spin[LOCKPROF_SPIN_DEPTH];
+	unsigned long			dropped;
+	struct lockprof_site		sites[LOCKPROF_SITES];
+};
+
+static struct lockprof_cpu __percpu *lockprof_cpus;
+static DEFINE_MUTEX(lockprof_mutex);
+static bool lockprof_enabled;
+static bool lockprof_boot_on __initdata;
+static unsigned int lockprof_period = 100;
+/* Waits that started before this (re)enable are ignored */
+static u64 lockprof_epoch;
+
+static int __init lockprof_setup(char *str)
+{
+	return !kstrtobool(str, &lockprof_boot_on);
+}
+__setup("lock_contention=", lockprof_setup);
+
+/* Waiters that can sleep, and migrate, keep their sample in the task */
+static inline bool lockprof_sleeping(unsigned int flags)
+{
+	return !(flags & LCB_F_SPIN) || (flags & LCB_F_MUTEX);
+}
+
+static unsigned long lockprof_callsite(void)
+{
+	unsigned long entries[LOCKPROF_STACK];
+	bool in_lock = false;
+	unsigned int i, nr;
+
+	nr = stack_trace_save(entries, ARRAY_SIZE(entries), 0);
+	for (i = 0; i < nr; i++) {
+		if (in_sched_functions(entries[i]))
+			in_lock = true;
+		else if (in_lock)
+			return entries[i];
+	}
+	return nr ? entries[nr - 1] : 0;
+}
+
+static void lockprof_begin(void *data, void *lock, unsigned int flags)
+{
+	struct lockprof_cpu *pc;
+	struct lock_contention_wait *w;
+	unsigned long irqflags;
+
+	if (in_nmi())
+		return;
+
+	/* A mutex goes from spinning to sleeping without an end in between */
+	if (lockprof_sleeping(flags) && current->lockprof_wait.lock == lock)
+		return;
+
+	if (this_cpu_dec_return(lockprof_cpus->countdown))
+		return;
+	this_cpu_write(lockprof_cpus->countdown, READ_ONCE(lockprof_period));
+
+	local_irq_save(irqflags);
+	pc = this_cpu_ptr(lockprof_cpus);
+	if (lockprof_sleeping(flags)) {
+		w = &current->lockprof_wait;
+	} else if (pc->depth < LOCKPROF_SPIN_DEPTH) {
+		w = &pc->spin[pc->depth++];
+	} else {
+		local_irq_restore(irqflags);
+		return;
+	}
+	w->lock = lock;
+	w->flags = flags;
+	w->ip = lockprof_callsite();
+	w->start = local_clock();
+	local_irq_restore(irqflags);
+}
+
+static void lockprof_record(struct lockprof_cpu *pc,
+			    struct lock_contention_wait *w, u64 now)
+{
+	struct lockprof_site *site;
+	unsigned int i, h;
+	u64 ns;
+
+	if (w->start < READ_ONCE(lockprof_epoch))
+		return;
+
+	ns = now - w->start;
+	h = hash_long(w->ip, LOCKPROF_SITE_BITS);
+	for (i = 0; i < LOCKPROF_PROBES; i++) {
+		site = &pc->sites[(h + i) & (LOCKPROF_SITES - 1)];
+		if (site->ip == w->ip)
+			break;
+		if (!site->ip) {
+			site->ip = w->ip;
+			site->flags = w->flags;
+			break;
+		}
+	}
+	if (i == LOCKPROF_PROBES) {
+		pc->dropped++;
+		return;
+	}
+
+	site->count++;
+	site->total_ns += ns;
+	if (ns > site->max_ns)
+		site->max_ns = ns;
+	site->hist[min_t(unsigned int, ilog2(ns | 1), LOCKPROF_BUCKETS - 1)]++;
+}
+
+static void lockprof_end(void *data, void *lock, int ret)
+{
+	struct lock_contention_wait *w = &current->lockprof_wait;
+	struct lockprof_cpu *pc;
+	unsigned long irqflags;
+
+	if (in_nmi())
+		return;
+
+	/* Nothing sampled */
+	if (w->lock != lock && !raw_cpu_read(lockprof_cpus->depth))
+		return;
+
+	local_irq_save(irqflags);
+	pc = this_cpu_ptr(lockprof_cpus);
+	if (w->lock == lock) {
+		w->lock = NULL;
+	} else if (pc->depth && pc->spin[pc->depth - 1].lock == lock) {
+		w = &pc->spin[--pc->depth];
+	} else {
+		local_irq_restore(irqflags);
+		return;
+	}
+	lockprof_record(pc, w, local_clock());
+	local_irq_restore(irqflags);
+}
+
+static void lockprof_reset_cpu(void *unused)
+{
+	struct lockprof_cpu *pc = this_cpu_ptr(lockprof_cpus);
+
+	memset(pc->sites, 0, sizeof(pc->sites));
+	pc->dropped = 0;
+}
+
+static int lockprof_set_enabled(bool on)
+{
+	int ret = 0;
+
+	mutex_lock(&lockprof_mutex);
+	if (on == lockprof_enabled)
+		goto out;
+
+	if (!on) {
+		unregister_trace_contention_end(lockprof_end, NULL);
+		unregister_trace_contention_begin(lockprof_begin, NULL);
+		tracepoint_synchronize_unregister();
+		lockprof_enabled = false;
+		goto out;
+	}
+
+	if (!lockprof_cpus) {
+		unsigned int cpu;
+
+		lockprof_cpus = alloc_percpu(struct lockprof_cpu);
+		if (!lockprof_cpus) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		for_each_possible_cpu(cpu)
+			per_cpu_ptr(lockprof_cpus, cpu)->countdown = 1;
+	}
+
+	/* Drop waits left over from a previous enable */
+	WRITE_ONCE(lockprof_epoch, local_clock());
+
+	ret = register_trace_contention_begin(lockprof_begin, NULL);
+	if (ret)
+		goto out;
+	ret = register_trace_contention_end(lockprof_end, NULL);
+	if (ret) {
+		unregister_trace_contention_begin(lockprof_begin, NULL);
+		tracepoint_synchronize_unregister();
+		goto out;
+	}
+	lockprof_enabled = true;
+out:
+	mutex_unlock(&lockprof_mutex);
+	return ret;
+}
+
+/*
+ * Call sites summed over all CPUs
+ */
+struct lockprof_dump {
+	unsigned int		nr;
+	unsigned long		dropped;
+	struct lockprof_site	sites[];
+};
+
+static int lockprof_site_cmp(const void *a, const void *b)
+{
+	const struct lockprof_site *x = a, *y = b;
+
+	if (x->total_ns == y->total_ns)
+		return 0;
+	return x->total_ns < y->total_ns ? 1 : -1;
+}
+
+static void lockprof_merge(struct lockprof_dump *dump, unsigned int size,
+			   const struct lockprof_site *src)
+{
+	struct lockprof_site *dst = NULL;
+	unsigned int i;
+
+	for (i = 0; i < dump->nr; i++) {
+		if (dump->sites[i].ip == src->ip) {
+			dst = &dump->sites[i];
+			break;
+		}
+	}
+	if (!dst) {
+		if (dump->nr == size)
+			return;
+		dst = &dump->sites[dump->nr++];
+		dst->ip = src->ip;
+		dst->flags = src->flags;
+	}
+
+	dst->count += src->count;
+	dst->total_ns += src->total_ns;
+	dst->max_ns = max(dst->max_ns, src->max_ns);
+	for (i = 0; i < LOCKPROF_BUCKETS; i++)
+		dst->hist[i] += src->hist[i];
+}
+
+static const char *lockprof_type(unsigned int flags)
+{
+	if (flags & LCB_F_RT)
+		return "rtmutex";
+	if (flags & LCB_F_MUTEX)
+		return "mutex";
+	if (flags & LCB_F_PERCPU)
+		return "percpu-rwsem";
+	if (flags & LCB_F_SPIN)
+		return flags & (LCB_F_READ | LCB_F_WRITE) ? "rwlock" : "spinlock";
+	if (flags & (LCB_F_READ | LCB_F_WRITE))
+		return "rwsem";
+	return "semaphore";
+}
+
+static int lockprof_sites_show(struct seq_file *m, void *v)
+{
+	const unsigned int size = 4 * LOCKPROF_SITES;
+	struct lockprof_dump *dump;
+	unsigned int cpu, i, b;
+
+	if (!lockprof_cpus)
+		return 0;
+
+	dump = vzalloc(struct_size(dump, sites, size));
+	if (!dump)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct lockprof_cpu *pc = per_cpu_ptr(lockprof_cpus, cpu);
+
+		dump->dropped += data_race(pc->dropped);
+		for (i = 0; i < LOCKPROF_SITES; i++) {
+			struct lockprof_site site;
+
+			site = data_race(pc->sites[i]);
+			if (site.ip && site.count)
+				lockprof_merge(dump, size, &site);
+		}
+	}
+	sort(dump->sites, dump->nr, sizeof(dump->sites[0]),
+	     lockprof_site_cmp, NULL);
+
+	seq_printf(m, "# sample_period %u, dropped samples %lu\n",
+		   READ_ONCE(lockprof_period), dump->dropped);
+	seq_puts(m, "# type samples total_ns avg_ns max_ns call site\n");
+	seq_puts(m, "#   wait_ns>=2^n: samples ...\n");
+	for (i = 0; i < dump->nr; i++) {
+		struct lockprof_site *site = &dump->sites[i];
+
+		seq_printf(m, "%s %u %llu %llu %llu %pS\n",
+			   lockprof_type(site->flags), site->count,
+			   site->total_ns, div_u64(site->total_ns, site->count),
+			   site->max_ns, (void *)site->ip);
+		seq_puts(m, " ");
+		for (b = 0; b < LOCKPROF_BUCKETS; b++) {
+			if (site->hist[b])
+				seq_printf(m, " %u:%u", b, site->hist[b]);
+		}
+		seq_putc(m, '\n');
+	}
+
+	vfree(dump);
+	return 0;
+}
+
+static int lockprof_sites_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lockprof_sites_show, NULL);
+}
+
+static ssize_t lockprof_sites_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	mutex_lock(&lockprof_mutex);
+	if (lockprof_cpus) {
+		cpus_read_lock();
+		on_each_cpu(lockprof_reset_cpu, NULL, 1);
+		cpus_read_unlock();
+	}
+	mutex_unlock(&lockprof_mutex);
+	return count;
+}
+
+static const struct file_operations fops_lockprof_sites = {
+	.open		= lockprof_sites_open,
+	.read		= seq_read,
+	.write		= lockprof_sites_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int lockprof_enable_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(lockprof_enabled);
+	return 0;
+}
+
+static int lockprof_enable_set(void *data, u64 val)
+{
+	return lockprof_set_enabled(!!val);
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_lockprof_enable, lockprof_enable_get,
+			 lockprof_enable_set, "%llu\n");
+
+static int lockprof_period_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(lockprof_period);
+	return 0;
+}
+
+static int lockprof_period_set(void *data, u64 val)
+{
+	if (!val || val > UINT_MAX)
+		return -EINVAL;
+	WRITE_ONCE(lockprof_period, val);
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_lockprof_period, lockprof_period_get,
+			 lockprof_period_set, "%llu\n");
+
+static int __init init_lock_contention(void)
+{
+	struct dentry *dir = debugfs_create_dir(LOCKPROF_DIR, NULL);
+
+	/* Only root may read the profile or turn it on, as for lock_stat */
+	debugfs_create_file_unsafe("enable", 0600, dir, NULL,
+				   &fops_lockprof_enable);
+	debugfs_create_file_unsafe("sample_period", 0600, dir, NULL,
+				   &fops_lockprof_period);
+	debugfs_create_file("sites", 0600, dir, NULL, &fops_lockprof_sites);
+
+	if (lockprof_boot_on && lockprof_set_enabled(true))
+		pr_warn("lock_contention: could not enable profiling\n");
+	return 0;
+}
+late_initcall(init_lock_contention);
@@ -35,6 +35,14 @@ LOCK_EVENT(pv_wait_head)	/* # of vCPU wait's at the queue head	   */
 LOCK_EVENT(pv_wait_node)	/* # of vCPU wait's at non-head queue node */
 #endif /* CONFIG_PARAVIRT_SPINLOCKS */
 
+#ifdef CONFIG_NUMA_AWARE_SPINLOCKS
+/*
+ * Locking events for the NUMA-aware (CNA) qspinlock slow path.
+ */
+LOCK_EVENT(cna_splice_next)	/* # of remote waiters moved to 2nd queue  */
+LOCK_EVENT(cna_flush_secondary)	/* # of 2nd queue flushes on the threshold */
+#endif /* CONFIG_NUMA_AWARE_SPINLOCKS */
+
 /*
  * Locking events for qspinlock
  *
@@ -59,6 +67,9 @@ LOCK_EVENT(rwsem_wake_writer)	/* # of writer wakeups			*/
 LOCK_EVENT(rwsem_opt_lock)	/* # of opt-acquired write locks	*/
 LOCK_EVENT(rwsem_opt_fail)	/* # of failed optspins			*/
 LOCK_EVENT(rwsem_opt_nospin)	/* # of disabled optspins		*/
+LOCK_EVENT(rwsem_rspin)		/* # of reader spins on a writer	*/
+LOCK_EVENT(rwsem_rspin_fail)	/* # of reader spins that had to queue	*/
+LOCK_EVENT(rwsem_rspin_skip)	/* # of reader spins skipped, long holds */
 LOCK_EVENT(rwsem_rlock)		/* # of read locks acquired		*/
 LOCK_EVENT(rwsem_rlock_steal)	/* # of read locks by lock stealing	*/
 LOCK_EVENT(rwsem_rlock_fast)	/* # of fast read locks acquired	*/
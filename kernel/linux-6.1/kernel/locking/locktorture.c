@@ -187,6 +187,39 @@ static struct lock_torture_ops spin_lock_ops = {
 	.name		= "spin_lock"
 };
 
+/*
+ * spin_lock_numa: spin_lock, also counting how often the lock moves to a
+ * writer on another NUMA node.  With the NUMA-aware slow path
+ * (numa_spinlock=on) the lock should mostly stay on one node, while the
+ * Max/Min check of the writers still catches writers that starve.
+ */
+static int torture_numa_last_node = NUMA_NO_NODE;
+static long torture_numa_handoffs[2]; /* same node, other node */
+
+static int torture_spin_lock_numa_write_lock(int tid __maybe_unused)
+__acquires(torture_spinlock)
+{
+	int node;
+
+	spin_lock(&torture_spinlock);
+	node = numa_node_id();
+	if (torture_numa_last_node != NUMA_NO_NODE)
+		torture_numa_handoffs[node != torture_numa_last_node]++;
+	torture_numa_last_node = node;
+	return 0;
+}
+
+static struct lock_torture_ops spin_lock_numa_ops = {
+	.writelock	= torture_spin_lock_numa_write_lock,
+	.write_delay	= torture_spin_lock_write_delay,
+	.task_boost     = torture_boost_dummy,
+	.writeunlock	= torture_spin_lock_write_unlock,
+	.readlock       = NULL,
+	.read_delay     = NULL,
+	.readunlock     = NULL,
+	.name		= "spin_lock_numa"
+};
+
 static int torture_spin_lock_write_lock_irq(int tid __maybe_unused)
 __acquires(torture_spinlock)
 {
@@ -792,6 +825,11 @@ static void lock_torture_stats_print(void)
 	pr_alert("%s", buf);
 	kfree(buf);
 
+	if (cxt.cur_ops == &spin_lock_numa_ops)
+		pr_alert("NUMA handoffs:  Same node: %ld  Other node: %ld\n",
+			 data_race(torture_numa_handoffs[0]),
+			 data_race(torture_numa_handoffs[1]));
+
 	if (cxt.cur_ops->readlock) {
 		buf = kmalloc(size, GFP_KERNEL);
 		if (!buf) {
@@ -904,6 +942,7 @@ static int __init lock_torture_init(void)
 	static struct lock_torture_ops *torture_ops[] = {
 		&lock_busted_ops,
 		&spin_lock_ops, &spin_lock_irq_ops,
+		&spin_lock_numa_ops,
 		&rw_lock_ops, &rw_lock_irq_ops,
 		&mutex_lock_ops,
 		&ww_mutex_lock_ops,
@@ -329,6 +329,7 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	atomic_long_set(&sem->owner, 0L);
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
+	sem->hold_avg = 0;
 #endif
 }
 EXPORT_SYMBOL(__init_rwsem);
@@ -736,6 +737,30 @@ static inline bool rwsem_can_spin_on_owner(struct rw_semaphore *sem)
 
 #define OWNER_SPINNABLE		(OWNER_NULL | OWNER_WRITER | OWNER_READER)
 
+/*
+ * Writer hold time statistics
+ *
+ * sem->hold_avg is a moving average (1/8 weight per sample) of how long,
+ * in ns, optimistic spinners waited for a running writer to release the
+ * rwsem. A writer that went to sleep with the lock held, or a spin that
+ * ran out of time, is accounted as RWSEM_RSPIN_FAIL_NS. Readers only spin
+ * for a writer while the average is below RWSEM_RSPIN_MAX_NS, see
+ * rwsem_reader_spin().
+ */
+#define RWSEM_RSPIN_MAX_NS	(10 * NSEC_PER_USEC)
+#define RWSEM_RSPIN_FAIL_NS	(64 * RWSEM_RSPIN_MAX_NS)
+#define RWSEM_HOLD_AVG_SHIFT	3
+#define RWSEM_HOLD_DECAY_SHIFT	6
+
+static inline void rwsem_hold_sample(struct rw_semaphore *sem, u64 ns)
+{
+	unsigned int avg = READ_ONCE(sem->hold_avg);
+
+	ns = min_t(u64, ns, RWSEM_RSPIN_FAIL_NS);
+	avg += ((long)ns - (long)avg) >> RWSEM_HOLD_AVG_SHIFT;
+	WRITE_ONCE(sem->hold_avg, avg);
+}
+
 static inline enum owner_state
 rwsem_owner_state(struct task_struct *owner, unsigned long flags)
 {
@@ -754,6 +779,7 @@ rwsem_spin_on_owner(struct rw_semaphore *sem)
 	struct task_struct *new, *owner;
 	unsigned long flags, new_flags;
 	enum owner_state state;
+	u64 start;
 
 	lockdep_assert_preemption_disabled();
 
@@ -762,6 +788,7 @@ rwsem_spin_on_owner(struct rw_semaphore *sem)
 	if (state != OWNER_WRITER)
 		return state;
 
+	start = sched_clock();
 	for (;;) {
 		/*
 		 * When a waiting writer set the handoff flag, it may spin
@@ -772,6 +799,7 @@ rwsem_spin_on_owner(struct rw_semaphore *sem)
 		new = rwsem_owner_flags(sem, &new_flags);
 		if ((new != owner) || (new_flags != flags)) {
 			state = rwsem_owner_state(new, new_flags);
+			rwsem_hold_sample(sem, sched_clock() - start);
 			break;
 		}
 
@@ -785,7 +813,13 @@ rwsem_spin_on_owner(struct rw_semaphore *sem)
 		 */
 		barrier();
 
-		if (need_resched() || !owner_on_cpu(owner)) {
+		if (need_resched()) {
+			state = OWNER_NONSPINNABLE;
+			break;
+		}
+
+		if (!owner_on_cpu(owner)) {
+			rwsem_hold_sample(sem, RWSEM_RSPIN_FAIL_NS);
 			state = OWNER_NONSPINNABLE;
 			break;
 		}
@@ -942,6 +976,80 @@ done:
 	return taken;
 }
 
+/*
+ * Reader adaptive spinning
+ *
+ * Called by a reader that found the rwsem write-locked, with its
+ * RWSEM_READER_BIAS already in the count. Rather than queue, sleep and
+ * be woken up right away, it spins for the writer as long as writers
+ * have recently been seen to release the lock quickly. The spin stops
+ * once the writer is gone, stops running, a handoff is pending, or it
+ * has taken twice the average hold time.
+ *
+ * Readers that decide not to spin decay the average a little, so a long
+ * writer hold keeps them away for a while, but not for good.
+ *
+ * Return: true if the writer released the lock, with the new count in
+ * @cntp.
+ */
+static bool rwsem_reader_spin(struct rw_semaphore *sem, long *cntp)
+{
+	unsigned int avg = READ_ONCE(sem->hold_avg);
+	struct task_struct *owner;
+	unsigned long flags;
+	u64 start, deadline;
+	bool taken = false;
+	int loop = 0;
+	long count;
+
+	if (avg >= RWSEM_RSPIN_MAX_NS) {
+		WRITE_ONCE(sem->hold_avg, avg - (avg >> RWSEM_HOLD_DECAY_SHIFT));
+		lockevent_inc(rwsem_rspin_skip);
+		return false;
+	}
+
+	lockevent_inc(rwsem_rspin);
+	preempt_disable();
+	start = sched_clock();
+	deadline = start + 2 * avg + NSEC_PER_USEC;
+
+	for (;;) {
+		count = atomic_long_read(&sem->count);
+		if (!(count & RWSEM_WRITER_LOCKED)) {
+			taken = !(count & RWSEM_FLAG_HANDOFF);
+			rwsem_hold_sample(sem, sched_clock() - start);
+			break;
+		}
+
+		if ((count & RWSEM_FLAG_HANDOFF) || need_resched())
+			break;
+
+		/*
+		 * Disabled preemption keeps the task_struct of a writer
+		 * owner from going away, as in rwsem_can_spin_on_owner().
+		 */
+		owner = rwsem_owner_flags(sem, &flags);
+		if ((flags & RWSEM_NONSPINNABLE) ||
+		    (owner && !(flags & RWSEM_READER_OWNED) && !owner_on_cpu(owner))) {
+			rwsem_hold_sample(sem, RWSEM_RSPIN_FAIL_NS);
+			break;
+		}
+
+		/* Same sched_clock() rate limiting as the writer spin */
+		if (!(++loop & 0xf) && sched_clock() > deadline) {
+			rwsem_hold_sample(sem, RWSEM_RSPIN_FAIL_NS);
+			break;
+		}
+
+		cpu_relax();
+	}
+	preempt_enable();
+
+	lockevent_cond_inc(rwsem_rspin_fail, !taken);
+	*cntp = count;
+	return taken;
+}
+
 /*
  * Clear the owner's RWSEM_NONSPINNABLE bit if it is set. This should
  * only be called when the reader count reaches 0.
@@ -963,6 +1071,11 @@ static inline bool rwsem_optimistic_spin(struct rw_semaphore *sem)
 	return false;
 }
 
+static inline bool rwsem_reader_spin(struct rw_semaphore *sem, long *cntp)
+{
+	return false;
+}
+
 static inline void clear_nonspinnable(struct rw_semaphore *sem) { }
 
 static inline enum owner_state
@@ -1017,6 +1130,14 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	    (rcnt > 1) && !(count & RWSEM_WRITER_LOCKED))
 		goto queue;
 
+	/*
+	 * A writer that is about to release the lock is cheaper to spin
+	 * for than to sleep on.
+	 */
+	if ((count & RWSEM_WRITER_LOCKED) && !(count & RWSEM_FLAG_HANDOFF) &&
+	    rwsem_reader_spin(sem, &count))
+		rcnt = count >> RWSEM_READER_SHIFT;
+
 	/*
 	 * Reader optimistic lock stealing.
 	 */
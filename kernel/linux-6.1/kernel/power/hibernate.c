@@ -12,6 +12,7 @@
 #define pr_fmt(fmt) "PM: hibernation: " fmt
 
 #include <linux/export.h>
+#include <linux/moduleparam.h>
 #include <linux/suspend.h>
 #include <linux/reboot.h>
 #include <linux/string.h>
@@ -37,6 +38,8 @@
 
 
 static int nocompress;
+static bool hibernate_lz4 = IS_ENABLED(CONFIG_HIBERNATION_COMP_LZ4);
+static bool golden_image;
 static int noresume;
 static int nohibernate;
 static int resume_wait;
@@ -770,6 +773,10 @@ int hibernate(void)
 			flags |= SF_NOCOMPRESS_MODE;
 		else
 		        flags |= SF_CRC32_MODE;
+		if (!nocompress && hibernate_lz4)
+			flags |= SF_COMPRESSION_ALG_LZ4;
+		if (golden_image)
+			flags |= SF_GOLDEN_MODE;
 
 		pm_pr_dbg("Writing hibernation image.\n");
 		error = swsusp_write(flags);
@@ -784,6 +791,8 @@ int hibernate(void)
 		pm_restore_gfp_mask();
 	} else {
 		pm_pr_dbg("Hibernation image restored successfully.\n");
+		if (golden_image)
+			swsusp_reserve_golden();
 	}
 
  Free_bitmaps:
@@ -1320,6 +1329,8 @@ static int __init hibernate_setup(char *str)
 		noresume = 1;
 	} else if (!strncmp(str, "nocompress", 10)) {
 		nocompress = 1;
+	} else if (!strncmp(str, "golden", 6)) {
+		golden_image = true;
 	} else if (!strncmp(str, "no", 2)) {
 		noresume = 1;
 		nohibernate = 1;
@@ -1330,6 +1341,31 @@ static int __init hibernate_setup(char *str)
 	return 1;
 }
 
+static int hibernate_compressor_set(const char *val,
+				    const struct kernel_param *kp)
+{
+	if (sysfs_streq(val, "lzo"))
+		hibernate_lz4 = false;
+	else if (sysfs_streq(val, "lz4"))
+		hibernate_lz4 = true;
+	else
+		return -EINVAL;
+	return 0;
+}
+
+static int hibernate_compressor_get(char *buffer,
+				    const struct kernel_param *kp)
+{
+	return sprintf(buffer, "%s\n", hibernate_lz4 ? "lz4" : "lzo");
+}
+
+static const struct kernel_param_ops hibernate_compressor_ops = {
+	.set	= hibernate_compressor_set,
+	.get	= hibernate_compressor_get,
+};
+module_param_cb(compressor, &hibernate_compressor_ops, NULL, 0644);
+MODULE_PARM_DESC(compressor, "Compression algorithm for the hibernation image (lzo or lz4)");
+
 static int __init noresume_setup(char *str)
 {
 	noresume = 1;
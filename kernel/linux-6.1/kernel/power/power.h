@@ -172,6 +172,8 @@ extern int swsusp_swap_in_use(void);
 #define SF_NOCOMPRESS_MODE	2
 #define SF_CRC32_MODE	        4
 #define SF_HW_SIG		8
+#define SF_COMPRESSION_ALG_LZ4	16
+#define SF_GOLDEN_MODE		32
 
 /* kernel/power/hibernate.c */
 extern int swsusp_check(void);
@@ -179,6 +181,7 @@ extern void swsusp_free(void);
 extern int swsusp_read(unsigned int *flags_p);
 extern int swsusp_write(unsigned int flags);
 extern void swsusp_close(fmode_t);
+extern void swsusp_reserve_golden(void);
 #ifdef CONFIG_SUSPEND
 extern int swsusp_unmark(void);
 #endif
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * BPF struct_ops backend for the Aurora AI scheduler policy.
+ *
+ * A BPF program implementing struct sched_aurora_ops can be attached at
+ * runtime and replaces the built-in Aurora scoring and placement policy.
+ * Only one policy is active at a time; detaching falls back to the
+ * built-in policy after an RCU grace period.
+ */
+#include <linux/init.h>
+#include <linux/types.h>
+#include <linux/bpf_verifier.h>
+#include <linux/bpf.h>
+#include <linux/btf.h>
+#include <linux/filter.h>
+#include <linux/mutex.h>
+#include <linux/sched/aurora.h>
+
+/* "extern" is to avoid sparse warning.  It is only used in bpf_struct_ops.c. */
+extern struct bpf_struct_ops bpf_sched_aurora_ops;
+
+DEFINE_STATIC_KEY_FALSE(sched_aurora_ops_enabled);
+EXPORT_SYMBOL_GPL(sched_aurora_ops_enabled);
+
+struct sched_aurora_ops __rcu *sched_aurora_active_ops;
+EXPORT_SYMBOL_GPL(sched_aurora_active_ops);
+
+static DEFINE_MUTEX(sched_aurora_ops_mutex);
+
+int sched_aurora_register_ops(struct sched_aurora_ops *ops)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_aurora_ops_mutex);
+	if (rcu_access_pointer(sched_aurora_active_ops)) {
+		ret = -EEXIST;
+		goto out;
+	}
+
+	if (ops->init) {
+		ret = ops->init();
+		if (ret)
+			goto out;
+	}
+
+	rcu_assign_pointer(sched_aurora_active_ops, ops);
+	static_branch_enable(&sched_aurora_ops_enabled);
+	pr_info("sched_aurora: attached policy \"%s\"\n", ops->name);
+out:
+	mutex_unlock(&sched_aurora_ops_mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_register_ops);
+
+void sched_aurora_unregister_ops(struct sched_aurora_ops *ops)
+{
+	mutex_lock(&sched_aurora_ops_mutex);
+	if (rcu_access_pointer(sched_aurora_active_ops) != ops)
+		goto out;
+
+	static_branch_disable(&sched_aurora_ops_enabled);
+	RCU_INIT_POINTER(sched_aurora_active_ops, NULL);
+	/* Scheduler paths call the ops from RCU-sched read sections */
+	synchronize_rcu();
+
+	if (ops->exit)
+		ops->exit();
+	pr_info("sched_aurora: detached policy \"%s\"\n", ops->name);
+out:
+	mutex_unlock(&sched_aurora_ops_mutex);
+}
+EXPORT_SYMBOL_GPL(sched_aurora_unregister_ops);
+
+static int bpf_sched_aurora_init(struct btf *btf)
+{
+	return 0;
+}
+
+static bool bpf_sched_aurora_is_valid_access(int off, int size,
+					     enum bpf_access_type type,
+					     const struct bpf_prog *prog,
+					     struct bpf_insn_access_aux *info)
+{
+	return bpf_tracing_btf_ctx_access(off, size, type, prog, info);
+}
+
+static int bpf_sched_aurora_btf_struct_access(struct bpf_verifier_log *log,
+					      const struct btf *btf,
+					      const struct btf_type *t, int off,
+					      int size, enum bpf_access_type atype,
+					      u32 *next_btf_id,
+					      enum bpf_type_flag *flag)
+{
+	if (atype == BPF_READ)
+		return btf_struct_access(log, btf, t, off, size, atype,
+					 next_btf_id, flag);
+
+	/* Policies observe tasks; they never write scheduler state */
+	bpf_log(log, "only read is supported\n");
+	return -EACCES;
+}
+
+static const struct bpf_func_proto *
+bpf_sched_aurora_get_func_proto(enum bpf_func_id func_id,
+				const struct bpf_prog *prog)
+{
+	switch (func_id) {
+	case BPF_FUNC_task_storage_get:
+		return &bpf_task_storage_get_proto;
+	case BPF_FUNC_task_storage_delete:
+		return &bpf_task_storage_delete_proto;
+	case BPF_FUNC_get_smp_processor_id:
+		return &bpf_get_smp_processor_id_proto;
+	default:
+		return bpf_base_func_proto(func_id);
+	}
+}
+
+static const struct bpf_verifier_ops bpf_sched_aurora_verifier_ops = {
+	.get_func_proto		= bpf_sched_aurora_get_func_proto,
+	.is_valid_access	= bpf_sched_aurora_is_valid_access,
+	.btf_struct_access	= bpf_sched_aurora_btf_struct_access,
+};
+
+static int bpf_sched_aurora_init_member(const struct btf_type *t,
+					const struct btf_member *member,
+					void *kdata, const void *udata)
+{
+	const struct sched_aurora_ops *uops = udata;
+	struct sched_aurora_ops *ops = kdata;
+	u32 moff;
+
+	moff = __btf_member_bit_offset(t, member) / 8;
+	switch (moff) {
+	case offsetof(struct sched_aurora_ops, name):
+		if (bpf_obj_name_cpy(ops->name, uops->name,
+				     sizeof(ops->name)) <= 0)
+			return -EINVAL;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int bpf_sched_aurora_check_member(const struct btf_type *t,
+					 const struct btf_member *member)
+{
+	return 0;
+}
+
+static int bpf_sched_aurora_reg(void *kdata)
+{
+	return sched_aurora_register_ops(kdata);
+}
+
+static void bpf_sched_aurora_unreg(void *kdata)
+{
+	sched_aurora_unregister_ops(kdata);
+}
+
+struct bpf_struct_ops bpf_sched_aurora_ops = {
+	.verifier_ops = &bpf_sched_aurora_verifier_ops,
+	.reg = bpf_sched_aurora_reg,
+	.unreg = bpf_sched_aurora_unreg,
+	.check_member = bpf_sched_aurora_check_member,
+	.init_member = bpf_sched_aurora_init_member,
+	.init = bpf_sched_aurora_init,
+	.name = "sched_aurora_ops",
+};
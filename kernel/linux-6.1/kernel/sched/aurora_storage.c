@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Per-task storage for the Aurora modules.
+ *
+ * The modules attach their per-task state to the task itself rather
+ * than to a global pid index, so lookups touch only the task's own
+ * cache lines and a reused pid can never find stale state. When the
+ * task is freed, each slot's owner is handed its data through the
+ * free() callback, which removes the need for a periodic sweep.
+ */
+#include <linux/build_bug.h>
+#include <linux/export.h>
+#include <linux/mutex.h>
+#include <linux/sched/aurora.h>
+
+static_assert(ARRAY_SIZE(((struct task_struct *)NULL)->aurora_storage) ==
+	      SCHED_AURORA_NR_STORAGE);
+
+static struct sched_aurora_storage_ops __rcu *sched_aurora_storage[SCHED_AURORA_NR_STORAGE];
+static DEFINE_MUTEX(sched_aurora_storage_mutex);
+
+int sched_aurora_register_storage_ops(enum sched_aurora_storage_slot slot,
+				      struct sched_aurora_storage_ops *ops)
+{
+	int ret = 0;
+
+	if (slot >= SCHED_AURORA_NR_STORAGE)
+		return -EINVAL;
+
+	mutex_lock(&sched_aurora_storage_mutex);
+	if (rcu_access_pointer(sched_aurora_storage[slot]))
+		ret = -EBUSY;
+	else
+		rcu_assign_pointer(sched_aurora_storage[slot], ops);
+	mutex_unlock(&sched_aurora_storage_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_register_storage_ops);
+
+/*
+ * After this returns no free() callback of @slot is running. The owner
+ * must then reclaim the data still attached to tasks itself.
+ */
+void sched_aurora_unregister_storage_ops(enum sched_aurora_storage_slot slot,
+					 struct sched_aurora_storage_ops *ops)
+{
+	if (slot >= SCHED_AURORA_NR_STORAGE)
+		return;
+
+	mutex_lock(&sched_aurora_storage_mutex);
+	if (rcu_access_pointer(sched_aurora_storage[slot]) == ops) {
+		RCU_INIT_POINTER(sched_aurora_storage[slot], NULL);
+		synchronize_rcu();
+	}
+	mutex_unlock(&sched_aurora_storage_mutex);
+}
+EXPORT_SYMBOL_GPL(sched_aurora_unregister_storage_ops);
+
+/* Called from free_task() */
+void sched_aurora_task_storage_free(struct task_struct *p)
+{
+	struct sched_aurora_storage_ops *ops;
+	void *data;
+	int slot;
+
+	rcu_read_lock();
+	for (slot = 0; slot < SCHED_AURORA_NR_STORAGE; slot++) {
+		if (!rcu_access_pointer(p->aurora_storage[slot]))
+			continue;
+
+		data = xchg((void **)&p->aurora_storage[slot], NULL);
+		ops = rcu_dereference(sched_aurora_storage[slot]);
+		if (data && ops)
+			ops->free(p, data);
+	}
+	rcu_read_unlock();
+}
@@ -218,6 +218,121 @@ void sched_autogroup_exit(struct signal_struct *sig)
 	autogroup_kref_put(sig->autogroup);
 }
 
+/* Caller holds a reference on @ag */
+static int autogroup_set_nice(struct autogroup *ag, int nice)
+{
+	unsigned long shares;
+	int err, idx;
+
+	idx = array_index_nospec(nice + 20, 40);
+	shares = scale_load(sched_prio_to_weight[idx]);
+
+	down_write(&ag->lock);
+	err = sched_group_set_shares(ag->tg, shares);
+	if (!err)
+		ag->nice = nice;
+	up_write(&ag->lock);
+
+	return err;
+}
+
+#ifdef CONFIG_SCHED_AURORA
+/*
+ * Shared autogroups of the Aurora context manager, created on first use
+ * and never freed. Their nice can still be changed through
+ * /proc/<pid>/autogroup of any member.
+ */
+static const int aurora_autogroup_nice[SCHED_AURORA_NR_GROUPS] = {
+	[SCHED_AURORA_GROUP_FOREGROUND]	= -5,
+	[SCHED_AURORA_GROUP_BACKGROUND]	= 19,
+};
+
+static struct autogroup *aurora_autogroups[SCHED_AURORA_NR_GROUPS];
+static DEFINE_MUTEX(aurora_autogroup_mutex);
+
+static struct autogroup *aurora_autogroup_get(enum sched_aurora_group group)
+{
+	struct autogroup *ag;
+
+	mutex_lock(&aurora_autogroup_mutex);
+	ag = aurora_autogroups[group];
+	if (!ag) {
+		ag = autogroup_create();
+		if (ag == &autogroup_default) {
+			/* autogroup_create() already complained */
+			autogroup_kref_put(ag);
+			mutex_unlock(&aurora_autogroup_mutex);
+			return NULL;
+		}
+		autogroup_set_nice(ag, aurora_autogroup_nice[group]);
+		/* The table keeps the reference autogroup_create() returned */
+		WRITE_ONCE(aurora_autogroups[group], ag);
+	}
+	autogroup_kref_get(ag);
+	mutex_unlock(&aurora_autogroup_mutex);
+
+	return ag;
+}
+
+/**
+ * sched_aurora_autogroup_of - the Aurora group a process is in
+ * @p: any thread of the process
+ *
+ * Returns SCHED_AURORA_GROUP_OWN for a process in any autogroup other
+ * than the shared ones, including its session's.
+ */
+enum sched_aurora_group sched_aurora_autogroup_of(struct task_struct *p)
+{
+	enum sched_aurora_group group;
+	struct autogroup *ag = autogroup_task_get(p);
+
+	for (group = SCHED_AURORA_GROUP_FOREGROUND; group < SCHED_AURORA_NR_GROUPS; group++) {
+		if (ag == READ_ONCE(aurora_autogroups[group]))
+			break;
+	}
+	autogroup_kref_put(ag);
+
+	return group == SCHED_AURORA_NR_GROUPS ? SCHED_AURORA_GROUP_OWN : group;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_autogroup_of);
+
+/**
+ * sched_aurora_autogroup_move - move a process to an Aurora group
+ * @p: any thread of the process
+ * @group: the group to move it to
+ *
+ * Moving to SCHED_AURORA_GROUP_OWN gives a process in a shared group an
+ * autogroup of its own; its session's autogroup is not remembered. A
+ * process that is not in a shared group is left where it is. Children
+ * forked afterwards inherit the group, as they inherit a session's.
+ *
+ * Allocates GFP_KERNEL, cannot be called under any spinlock.
+ */
+int sched_aurora_autogroup_move(struct task_struct *p, enum sched_aurora_group group)
+{
+	struct autogroup *ag;
+
+	if (group >= SCHED_AURORA_NR_GROUPS)
+		return -EINVAL;
+
+	if (group == SCHED_AURORA_GROUP_OWN) {
+		if (sched_aurora_autogroup_of(p) != SCHED_AURORA_GROUP_OWN)
+			sched_autogroup_create_attach(p);
+		return 0;
+	}
+
+	ag = aurora_autogroup_get(group);
+	if (!ag)
+		return -ENOMEM;
+
+	autogroup_move_group(p, ag);
+	autogroup_kref_put(ag);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_autogroup_move);
+#endif /* CONFIG_SCHED_AURORA */
+
 static int __init setup_autogroup(char *str)
 {
 	sysctl_sched_autogroup_enabled = 0;
@@ -232,8 +347,7 @@ int proc_sched_autogroup_set_nice(struct task_struct *p, int nice)
 {
 	static unsigned long next = INITIAL_JIFFIES;
 	struct autogroup *ag;
-	unsigned long shares;
-	int err, idx;
+	int err;
 
 	if (nice < MIN_NICE || nice > MAX_NICE)
 		return -EINVAL;
@@ -251,16 +365,7 @@ int proc_sched_autogroup_set_nice(struct task_struct *p, int nice)
 
 	next = HZ / 10 + jiffies;
 	ag = autogroup_task_get(p);
-
-	idx = array_index_nospec(nice + 20, 40);
-	shares = scale_load(sched_prio_to_weight[idx]);
-
-	down_write(&ag->lock);
-	err = sched_group_set_shares(ag->tg, shares);
-	if (!err)
-		ag->nice = nice;
-	up_write(&ag->lock);
-
+	err = autogroup_set_nice(ag, nice);
 	autogroup_kref_put(ag);
 
 	return err;
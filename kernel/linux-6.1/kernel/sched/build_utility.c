@@ -9,6 +9,7 @@
  *   coalescing source files to amortize header inclusion
  *   cost. )
  */
+#include <linux/sched/aurora.h>
 #include <linux/sched/clock.h>
 #include <linux/sched/cputime.h>
 #include <linux/sched/debug.h>
@@ -6,6 +6,7 @@
  */
 struct sched_core_cookie {
 	refcount_t refcnt;
+	bool aurora;		/* set by sched_aurora_core_isolate() */
 };
 
 static unsigned long sched_core_alloc_cookie(void)
@@ -15,6 +16,7 @@ static unsigned long sched_core_alloc_cookie(void)
 		return 0;
 
 	refcount_set(&ck->refcnt, 1);
+	ck->aurora = false;
 	sched_core_get();
 
 	return (unsigned long)ck;
@@ -50,14 +52,10 @@ static unsigned long sched_core_get_cookie(unsigned long cookie)
  *
  * Returns: the old cookie
  */
-static unsigned long sched_core_update_cookie(struct task_struct *p,
-					      unsigned long cookie)
+static unsigned long __sched_core_update_cookie(struct rq *rq, struct task_struct *p,
+						unsigned long cookie)
 {
 	unsigned long old_cookie;
-	struct rq_flags rf;
-	struct rq *rq;
-
-	rq = task_rq_lock(p, &rf);
 
 	/*
 	 * Since creating a cookie implies sched_core_get(), and we cannot set
@@ -91,6 +89,18 @@ static unsigned long sched_core_update_cookie(struct task_struct *p,
 	if (task_on_cpu(rq, p))
 		resched_curr(rq);
 
+	return old_cookie;
+}
+
+static unsigned long sched_core_update_cookie(struct task_struct *p,
+					      unsigned long cookie)
+{
+	unsigned long old_cookie;
+	struct rq_flags rf;
+	struct rq *rq;
+
+	rq = task_rq_lock(p, &rf);
+	old_cookie = __sched_core_update_cookie(rq, p, cookie);
 	task_rq_unlock(rq, p, &rf);
 
 	return old_cookie;
@@ -234,6 +244,60 @@ out:
 	return err;
 }
 
+#ifdef CONFIG_SCHED_AURORA
+static inline bool sched_core_cookie_is_aurora(unsigned long cookie)
+{
+	return cookie && ((struct sched_core_cookie *)cookie)->aurora;
+}
+
+/**
+ * sched_aurora_core_isolate - give a task a core of its own, or take it back
+ * @p: the task
+ * @isolate: true to isolate @p, false to let it share again
+ *
+ * Isolating installs a fresh cookie on @p, as PR_SCHED_CORE_CREATE would,
+ * so @p only shares a core with the children and threads it creates from
+ * now on, which inherit the cookie. A task that already has a cookie is
+ * isolated already and keeps it. Releasing clears only cookies installed
+ * here, directly or by inheritance, never ones set through prctl().
+ *
+ * Must be called from process context. Returns -ENODEV without SMT.
+ */
+int sched_aurora_core_isolate(struct task_struct *p, bool isolate)
+{
+	unsigned long cookie = 0;
+	struct rq_flags rf;
+	struct rq *rq;
+	bool update;
+
+	if (!static_branch_likely(&sched_smt_present))
+		return -ENODEV;
+
+	if (isolate) {
+		/* Unlocked peek, to skip the allocation when already isolated */
+		if (READ_ONCE(p->core_cookie))
+			return 0;
+
+		cookie = sched_core_alloc_cookie();
+		if (!cookie)
+			return -ENOMEM;
+		((struct sched_core_cookie *)cookie)->aurora = true;
+	}
+
+	rq = task_rq_lock(p, &rf);
+	update = isolate ? !p->core_cookie : sched_core_cookie_is_aurora(p->core_cookie);
+	if (update)
+		cookie = __sched_core_update_cookie(rq, p, cookie);
+	task_rq_unlock(rq, p, &rf);
+
+	/* The replaced cookie, or the new one if it was not needed */
+	sched_core_put_cookie(cookie);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_core_isolate);
+#endif /* CONFIG_SCHED_AURORA */
+
 #ifdef CONFIG_SCHEDSTATS
 
 /* REQUIRES: rq->core's clock recently updated. */
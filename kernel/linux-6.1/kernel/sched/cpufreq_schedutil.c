@@ -54,6 +54,11 @@ struct sugov_cpu {
 #ifdef CONFIG_NO_HZ_COMMON
 	unsigned long		saved_idle_calls;
 #endif
+
+#ifdef CONFIG_SCHED_AURORA
+	/* The Aurora hint lowered util: let the frequency drop at once */
+	bool			aurora_drop;
+#endif
 };
 
 static DEFINE_PER_CPU(struct sugov_cpu, sugov_cpu);
@@ -164,6 +169,85 @@ static void sugov_get_util(struct sugov_cpu *sg_cpu)
 					  FREQUENCY_UTIL, NULL);
 }
 
+#ifdef CONFIG_SCHED_AURORA
+static DEFINE_STATIC_KEY_FALSE(sched_aurora_freq_enabled);
+static struct sched_aurora_freq_ops __rcu *sched_aurora_freq;
+static DEFINE_MUTEX(sched_aurora_freq_mutex);
+
+int sched_aurora_register_freq_ops(struct sched_aurora_freq_ops *ops)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_aurora_freq_mutex);
+	if (rcu_access_pointer(sched_aurora_freq)) {
+		ret = -EBUSY;
+	} else {
+		rcu_assign_pointer(sched_aurora_freq, ops);
+		static_branch_enable(&sched_aurora_freq_enabled);
+	}
+	mutex_unlock(&sched_aurora_freq_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_register_freq_ops);
+
+void sched_aurora_unregister_freq_ops(struct sched_aurora_freq_ops *ops)
+{
+	mutex_lock(&sched_aurora_freq_mutex);
+	if (rcu_access_pointer(sched_aurora_freq) == ops) {
+		static_branch_disable(&sched_aurora_freq_enabled);
+		RCU_INIT_POINTER(sched_aurora_freq, NULL);
+		synchronize_rcu();
+	}
+	mutex_unlock(&sched_aurora_freq_mutex);
+}
+EXPORT_SYMBOL_GPL(sched_aurora_unregister_freq_ops);
+
+/**
+ * sugov_aurora_apply() - Apply the Aurora frequency hint to a CPU.
+ * @sg_cpu: the sugov data for the CPU
+ *
+ * The hint may raise sg_cpu->util ahead of a burst, within the rq's uclamp
+ * bounds like the IO boost. It may also lower it when the CPU is expected
+ * to go idle, but never below the RT and DL demand, and only once the CPU
+ * has no other task queued, since the module only sees the tasks it tracks.
+ */
+static void sugov_aurora_apply(struct sugov_cpu *sg_cpu)
+{
+	struct rq *rq = cpu_rq(sg_cpu->cpu);
+	struct sched_aurora_freq_ops *ops;
+	unsigned long hint, floor;
+
+	sg_cpu->aurora_drop = false;
+
+	if (!static_branch_unlikely(&sched_aurora_freq_enabled))
+		return;
+
+	rcu_read_lock();
+	ops = rcu_dereference(sched_aurora_freq);
+	hint = ops ? ops->util_hint(sg_cpu->cpu, sg_cpu->util, sg_cpu->max) :
+		     sg_cpu->util;
+	rcu_read_unlock();
+
+	if (hint > sg_cpu->util) {
+		hint = uclamp_rq_util_with(rq, min(hint, sg_cpu->max), NULL);
+		sg_cpu->util = max(sg_cpu->util, hint);
+	} else if (hint < sg_cpu->util && rq->nr_running <= 1) {
+		floor = min(sg_cpu->bw_dl + cpu_util_rt(rq), sg_cpu->util);
+		sg_cpu->util = max(hint, floor);
+		sg_cpu->aurora_drop = true;
+	}
+}
+
+static inline bool sugov_aurora_drop(struct sugov_cpu *sg_cpu)
+{
+	return sg_cpu->aurora_drop;
+}
+#else
+static inline void sugov_aurora_apply(struct sugov_cpu *sg_cpu) { }
+static inline bool sugov_aurora_drop(struct sugov_cpu *sg_cpu) { return false; }
+#endif /* CONFIG_SCHED_AURORA */
+
 /**
  * sugov_iowait_reset() - Reset the IO boost status of a CPU.
  * @sg_cpu: the sugov data for the CPU to boost
@@ -322,6 +406,7 @@ static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 
 	sugov_get_util(sg_cpu);
 	sugov_iowait_apply(sg_cpu, time);
+	sugov_aurora_apply(sg_cpu);
 
 	return true;
 }
@@ -342,9 +427,10 @@ static void sugov_update_single_freq(struct update_util_data *hook, u64 time,
 	 * Do not reduce the frequency if the CPU has not been idle
 	 * recently, as the reduction is likely to be premature then.
 	 *
-	 * Except when the rq is capped by uclamp_max.
+	 * Except when the rq is capped by uclamp_max, or the Aurora hint
+	 * expects the CPU to go idle.
 	 */
-	if (!uclamp_rq_is_capped(cpu_rq(sg_cpu->cpu)) &&
+	if (!uclamp_rq_is_capped(cpu_rq(sg_cpu->cpu)) && !sugov_aurora_drop(sg_cpu) &&
 	    sugov_cpu_is_busy(sg_cpu) && next_f < sg_policy->next_freq &&
 	    !sg_policy->need_freq_update) {
 		next_f = sg_policy->next_freq;
@@ -393,9 +479,10 @@ static void sugov_update_single_perf(struct update_util_data *hook, u64 time,
 	 * Do not reduce the target performance level if the CPU has not been
 	 * idle recently, as the reduction is likely to be premature then.
 	 *
-	 * Except when the rq is capped by uclamp_max.
+	 * Except when the rq is capped by uclamp_max, or the Aurora hint
+	 * expects the CPU to go idle.
 	 */
-	if (!uclamp_rq_is_capped(cpu_rq(sg_cpu->cpu)) &&
+	if (!uclamp_rq_is_capped(cpu_rq(sg_cpu->cpu)) && !sugov_aurora_drop(sg_cpu) &&
 	    sugov_cpu_is_busy(sg_cpu) && sg_cpu->util < prev_util)
 		sg_cpu->util = prev_util;
 
@@ -418,6 +505,7 @@ static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
 
 		sugov_get_util(j_sg_cpu);
 		sugov_iowait_apply(j_sg_cpu, time);
+		sugov_aurora_apply(j_sg_cpu);
 		j_util = j_sg_cpu->util;
 		j_max = j_sg_cpu->max;
 
@@ -66,10 +66,13 @@ static inline struct rq *rq_of_dl_rq(struct dl_rq *dl_rq)
 
 static inline struct dl_rq *dl_rq_of_se(struct sched_dl_entity *dl_se)
 {
-	struct task_struct *p = dl_task_of(dl_se);
-	struct rq *rq = task_rq(p);
+	struct task_struct *p;
 
-	return &rq->dl;
+	if (dl_se->dl_server)
+		return &dl_se->rq->dl;
+
+	p = dl_task_of(dl_se);
+	return &task_rq(p)->dl;
 }
 
 static inline int on_dl_rq(struct sched_dl_entity *dl_se)
@@ -575,7 +578,13 @@ static void update_dl_migration(struct dl_rq *dl_rq)
 
 static void inc_dl_migration(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	struct task_struct *p = dl_task_of(dl_se);
+	struct task_struct *p;
+
+	/* Servers stay with their runqueue */
+	if (dl_se->dl_server)
+		return;
+
+	p = dl_task_of(dl_se);
 
 	if (p->nr_cpus_allowed > 1)
 		dl_rq->dl_nr_migratory++;
@@ -585,7 +594,12 @@ static void inc_dl_migration(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 
 static void dec_dl_migration(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	struct task_struct *p = dl_task_of(dl_se);
+	struct task_struct *p;
+
+	if (dl_se->dl_server)
+		return;
+
+	p = dl_task_of(dl_se);
 
 	if (p->nr_cpus_allowed > 1)
 		dl_rq->dl_nr_migratory--;
@@ -1507,12 +1521,14 @@ static inline void dec_dl_deadline(struct dl_rq *dl_rq, u64 deadline) {}
 static inline
 void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
 	u64 deadline = dl_se->deadline;
 
-	WARN_ON(!dl_prio(prio));
+	/* A server's tasks are already counted by their own class */
 	dl_rq->dl_nr_running++;
-	add_nr_running(rq_of_dl_rq(dl_rq), 1);
+	if (!dl_se->dl_server) {
+		WARN_ON(!dl_prio(dl_task_of(dl_se)->prio));
+		add_nr_running(rq_of_dl_rq(dl_rq), 1);
+	}
 
 	inc_dl_deadline(dl_rq, deadline);
 	inc_dl_migration(dl_se, dl_rq);
@@ -1521,12 +1537,12 @@ void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 static inline
 void dec_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
-
-	WARN_ON(!dl_prio(prio));
 	WARN_ON(!dl_rq->dl_nr_running);
 	dl_rq->dl_nr_running--;
-	sub_nr_running(rq_of_dl_rq(dl_rq), 1);
+	if (!dl_se->dl_server) {
+		WARN_ON(!dl_prio(dl_task_of(dl_se)->prio));
+		sub_nr_running(rq_of_dl_rq(dl_rq), 1);
+	}
 
 	dec_dl_deadline(dl_rq, dl_se->deadline);
 	dec_dl_migration(dl_se, dl_rq);
@@ -1669,6 +1685,204 @@ static void dequeue_dl_entity(struct sched_dl_entity *dl_se)
 	__dequeue_dl_entity(dl_se);
 }
 
+/*
+ * Deadline servers. A server is a -deadline entity that, rather than a
+ * task of its own, runs the tasks of a lower scheduling class, so far
+ * only the fair class: through the server those get dl_runtime out of
+ * every dl_period even while RT tasks would otherwise starve them, and
+ * unlike RT throttling this never leaves the CPU idle.
+ *
+ * The served class running on its own also consumes the server's
+ * runtime, see dl_server_update(). So the server stays off the dl_rq
+ * until the zero-laxity point of its period, deadline - runtime, after
+ * which the served class could no longer get its remaining runtime
+ * without help; other classes run undisturbed until then, and not at
+ * all once it had its runtime.
+ *
+ * Servers are not tasks: they hold no task references in their timer,
+ * are never pushed or pulled, and do not count towards rq->nr_running.
+ */
+static bool dl_server_start_timer(struct sched_dl_entity *dl_se, u64 expires)
+{
+	struct hrtimer *timer = &dl_se->dl_timer;
+	ktime_t now, act;
+
+	lockdep_assert_rq_held(dl_se->rq);
+
+	/* As in start_dl_timer(), @expires is in rq->clock */
+	now = hrtimer_cb_get_time(timer);
+	act = ktime_add_ns(ns_to_ktime(expires), ktime_to_ns(now) - rq_clock(dl_se->rq));
+	if (ktime_us_delta(act, now) < 0)
+		return false;
+
+	hrtimer_start(timer, act, HRTIMER_MODE_ABS_HARD);
+	return true;
+}
+
+/* Wait for the zero-laxity point, or step in if it has passed */
+static void dl_server_defer(struct sched_dl_entity *dl_se)
+{
+	struct rq *rq = dl_se->rq;
+	struct task_struct *curr = rq->curr;
+
+	if (dl_server_start_timer(dl_se, dl_se->deadline - dl_se->runtime))
+		return;
+
+	__enqueue_dl_entity(dl_se);
+
+	/* A served task already running keeps running, now on our budget */
+	if (dl_task(curr)) {
+		if (dl_entity_preempt(dl_se, &curr->dl))
+			resched_curr(rq);
+	} else if (curr->sched_class != &fair_sched_class) {
+		resched_curr(rq);
+	}
+}
+
+/* The served class had its runtime, wait for the next period */
+static void dl_server_throttle(struct sched_dl_entity *dl_se)
+{
+	struct rq *rq = dl_se->rq;
+
+	if (on_dl_rq(dl_se)) {
+		__dequeue_dl_entity(dl_se);
+		resched_curr(rq);
+	}
+
+	dl_se->dl_throttled = 1;
+	if (dl_server_start_timer(dl_se, dl_next_period(dl_se)))
+		return;
+
+	dl_se->dl_throttled = 0;
+	replenish_dl_new_period(dl_se, rq);
+	dl_server_defer(dl_se);
+}
+
+static enum hrtimer_restart dl_server_timer(struct hrtimer *timer)
+{
+	struct sched_dl_entity *dl_se = container_of(timer,
+						     struct sched_dl_entity,
+						     dl_timer);
+	struct rq *rq = dl_se->rq;
+	struct rq_flags rf;
+
+	rq_lock(rq, &rf);
+	sched_clock_tick();
+	update_rq_clock(rq);
+
+	/* Either a new period starts... */
+	if (dl_se->dl_throttled) {
+		dl_se->dl_throttled = 0;
+		replenish_dl_new_period(dl_se, rq);
+	}
+
+	/* ...or the zero-laxity point came; idle servers just wait */
+	if (dl_se->dl_server_active && !on_dl_rq(dl_se))
+		dl_server_defer(dl_se);
+
+	rq_unlock(rq, &rf);
+
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * dl_server_update - charge a server for time its class ran
+ * @dl_se: the server
+ * @delta_exec: time the served class ran, picked through the server or not
+ *
+ * Called with the server's rq lock held, from the served class's
+ * update_curr().
+ */
+void dl_server_update(struct sched_dl_entity *dl_se, s64 delta_exec)
+{
+	if (!dl_se->dl_server_active || dl_se->dl_throttled)
+		return;
+
+	dl_se->runtime -= delta_exec;
+	if (dl_se->runtime <= 0)
+		dl_server_throttle(dl_se);
+}
+
+/**
+ * dl_server_start - the served class has runnable tasks again
+ * @dl_se: the server
+ *
+ * Called with the server's rq lock held and its clock updated.
+ */
+void dl_server_start(struct sched_dl_entity *dl_se)
+{
+	struct rq *rq = dl_se->rq;
+
+	if (!dl_se->dl_server || dl_se->dl_server_active)
+		return;
+
+	dl_se->dl_server_active = 1;
+
+	/* The replenishment timer is armed and takes it from here */
+	if (dl_se->dl_throttled)
+		return;
+
+	/* CBS wakeup rule, as for a task in update_dl_entity() */
+	if (dl_time_before(dl_se->deadline, rq_clock(rq)) ||
+	    dl_entity_overflow(dl_se, rq_clock(rq)))
+		replenish_dl_new_period(dl_se, rq);
+
+	dl_server_defer(dl_se);
+}
+
+/**
+ * dl_server_stop - the served class has no runnable tasks left
+ * @dl_se: the server
+ *
+ * Called with the server's rq lock held. A pending timer is left to
+ * expire; it finds the server inactive.
+ */
+void dl_server_stop(struct sched_dl_entity *dl_se)
+{
+	if (!dl_se->dl_server_active)
+		return;
+
+	if (on_dl_rq(dl_se))
+		__dequeue_dl_entity(dl_se);
+	dl_se->dl_server_active = 0;
+}
+
+/**
+ * dl_server_init - set up a deadline server
+ * @dl_se: the server
+ * @rq: the runqueue it serves
+ * @runtime: runtime reserved out of every @period, 0 to leave it disabled
+ * @period: the period, which is also the relative deadline
+ * @pick: picks the next task of the served class and sets it up to run
+ * @pick_task: picks it without side effects, for core scheduling
+ *
+ * The bandwidth is added to the root domain by sched_init_dl_servers().
+ */
+void dl_server_init(struct sched_dl_entity *dl_se, struct rq *rq,
+		    u64 runtime, u64 period, dl_server_pick_f pick,
+		    dl_server_pick_f pick_task)
+{
+	RB_CLEAR_NODE(&dl_se->rb_node);
+	hrtimer_init(&dl_se->dl_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	dl_se->dl_timer.function = dl_server_timer;
+#ifdef CONFIG_RT_MUTEXES
+	dl_se->pi_se = dl_se;
+#endif
+
+	if (!runtime)
+		return;
+
+	dl_se->dl_runtime = runtime;
+	dl_se->dl_deadline = period;
+	dl_se->dl_period = period;
+	dl_se->dl_bw = to_ratio(period, runtime);
+	dl_se->dl_density = dl_se->dl_bw;
+	dl_se->rq = rq;
+	dl_se->server_pick = pick;
+	dl_se->server_pick_task = pick_task;
+	dl_se->dl_server = 1;
+}
+
 static void enqueue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 {
 	if (is_dl_boosted(&p->dl)) {
@@ -2014,28 +2228,44 @@ static struct sched_dl_entity *pick_next_dl_entity(struct dl_rq *dl_rq)
 	return __node_2_dle(left);
 }
 
-static struct task_struct *pick_task_dl(struct rq *rq)
+/* With @next, a server's pick is also set up to run */
+static struct task_struct *__pick_task_dl(struct rq *rq, bool next)
 {
 	struct sched_dl_entity *dl_se;
 	struct dl_rq *dl_rq = &rq->dl;
 	struct task_struct *p;
 
+again:
 	if (!sched_dl_runnable(rq))
 		return NULL;
 
 	dl_se = pick_next_dl_entity(dl_rq);
 	WARN_ON_ONCE(!dl_se);
-	p = dl_task_of(dl_se);
+
+	if (!dl_se->dl_server)
+		return dl_task_of(dl_se);
+
+	p = next ? dl_se->server_pick(dl_se) : dl_se->server_pick_task(dl_se);
+	if (!p) {
+		/* The served tasks are all throttled by CFS bandwidth control */
+		dl_server_stop(dl_se);
+		goto again;
+	}
 
 	return p;
 }
 
+static struct task_struct *pick_task_dl(struct rq *rq)
+{
+	return __pick_task_dl(rq, false);
+}
+
 static struct task_struct *pick_next_task_dl(struct rq *rq)
 {
 	struct task_struct *p;
 
-	p = pick_task_dl(rq);
-	if (p)
+	p = __pick_task_dl(rq, true);
+	if (p && p->sched_class == &dl_sched_class)
 		set_next_task_dl(rq, p, true);
 
 	return p;
@@ -2580,12 +2810,42 @@ void dl_add_task_root_domain(struct task_struct *p)
 void dl_clear_root_domain(struct root_domain *rd)
 {
 	unsigned long flags;
+	int i;
 
 	raw_spin_lock_irqsave(&rd->dl_bw.lock, flags);
 	rd->dl_bw.total_bw = 0;
+
+	/* Unlike tasks, servers are not added back by dl_add_task_root_domain() */
+	for_each_cpu(i, rd->span) {
+		struct sched_dl_entity *dl_se = &cpu_rq(i)->fair_server;
+
+		if (dl_se->dl_server)
+			__dl_add(&rd->dl_bw, dl_se->dl_bw, cpumask_weight(rd->span));
+	}
 	raw_spin_unlock_irqrestore(&rd->dl_bw.lock, flags);
 }
 
+/* Add the servers' bandwidth to the root domains built at boot */
+void __init sched_init_dl_servers(void)
+{
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		struct sched_dl_entity *dl_se = &cpu_rq(cpu)->fair_server;
+		struct dl_bw *dl_b;
+
+		if (!dl_se->dl_server)
+			continue;
+
+		rcu_read_lock_sched();
+		dl_b = dl_bw_of(cpu);
+		raw_spin_lock_irq(&dl_b->lock);
+		__dl_add(dl_b, dl_se->dl_bw, dl_bw_cpus(cpu));
+		raw_spin_unlock_irq(&dl_b->lock);
+		rcu_read_unlock_sched();
+	}
+}
+
 #endif /* CONFIG_SMP */
 
 static void switched_from_dl(struct rq *rq, struct task_struct *p)
@@ -37,9 +37,11 @@
 #include <linux/sched/cputime.h>
 #include <linux/sched/isolation.h>
 #include <linux/sched/nohz.h>
+#include <linux/sched/aurora.h>
 
 #include <linux/cpuidle.h>
 #include <linux/interrupt.h>
+#include <linux/memcontrol.h>
 #include <linux/memory-tiers.h>
 #include <linux/mempolicy.h>
 #include <linux/mutex_api.h>
@@ -139,6 +141,33 @@ static int __init setup_sched_thermal_decay_shift(char *str)
 }
 __setup("sched_thermal_decay_shift=", setup_sched_thermal_decay_shift);
 
+/*
+ * Runtime the fair server reserves for SCHED_NORMAL tasks out of every
+ * second on each CPU, however much RT work is queued, see
+ * fair_server_init(). 0 disables the server and leaves only RT
+ * throttling to limit RT tasks.
+ *
+ * (default: 50 msec, units: nanoseconds)
+ */
+static u64 fair_server_runtime = 50 * NSEC_PER_MSEC;
+#define FAIR_SERVER_PERIOD	NSEC_PER_SEC
+
+static int __init setup_fair_server_runtime(char *str)
+{
+	u64 runtime_us;
+
+	if (kstrtou64(str, 0, &runtime_us) ||
+	    runtime_us * NSEC_PER_USEC > FAIR_SERVER_PERIOD / 2) {
+		pr_warn("Unable to set fair server runtime, at most %llu usecs\n",
+			FAIR_SERVER_PERIOD / 2 / NSEC_PER_USEC);
+		return 1;
+	}
+
+	fair_server_runtime = runtime_us * NSEC_PER_USEC;
+	return 1;
+}
+__setup("fair_server_runtime_us=", setup_fair_server_runtime);
+
 #ifdef CONFIG_SMP
 /*
  * For asym packing, by default the lower numbered CPU has higher priority.
@@ -914,6 +943,7 @@ static void update_curr(struct cfs_rq *cfs_rq)
 		trace_sched_stat_runtime(curtask, delta_exec, curr->vruntime);
 		cgroup_account_cputime(curtask, delta_exec);
 		account_group_exec_runtime(curtask, delta_exec);
+		dl_server_update(&rq_of(cfs_rq)->fair_server, delta_exec);
 	}
 
 	account_cfs_rq_runtime(cfs_rq, delta_exec);
@@ -1587,8 +1617,11 @@ bool should_numa_migrate_memory(struct task_struct *p, struct page * page,
 		if (latency >= th)
 			return false;
 
-		return !numa_promotion_rate_limit(pgdat, rate_limit,
-						  thp_nr_pages(page));
+		if (numa_promotion_rate_limit(pgdat, rate_limit,
+					      thp_nr_pages(page)))
+			return false;
+
+		return mem_cgroup_promote_charge(page_folio(page));
 	}
 
 	this_cpupid = cpu_pid_to_cpupid(dst_cpu, current->pid);
@@ -4564,6 +4597,14 @@ static inline void update_misfit_status(struct task_struct *p, struct rq *rq)
 	rq->misfit_task_load = max_t(unsigned long, task_h_load(p), 1);
 }
 
+/* Clear this CPU's rd->overload_mask bit once it has stopped queueing */
+static inline void update_overload_mask(struct rq *rq)
+{
+	if (rq->nr_running < 2 &&
+	    cpumask_test_cpu(cpu_of(rq), rq->rd->overload_mask))
+		cpumask_clear_cpu(cpu_of(rq), rq->rd->overload_mask);
+}
+
 #else /* CONFIG_SMP */
 
 static inline bool cfs_rq_is_decayed(struct cfs_rq *cfs_rq)
@@ -4603,6 +4644,7 @@ static inline void
 util_est_update(struct cfs_rq *cfs_rq, struct task_struct *p,
 		bool task_sleep) {}
 static inline void update_misfit_status(struct task_struct *p, struct rq *rq) {}
+static inline void update_overload_mask(struct rq *rq) {}
 
 #endif /* CONFIG_SMP */
 
@@ -5381,6 +5423,8 @@ static bool throttle_cfs_rq(struct cfs_rq *cfs_rq)
 
 	/* At this point se is NULL and we are at root level*/
 	sub_nr_running(rq, task_delta);
+	if (!rq->cfs.h_nr_running)
+		dl_server_stop(&rq->fair_server);
 
 done:
 	/*
@@ -5466,6 +5510,8 @@ void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
 
 	/* At this point se is NULL and we are at root level*/
 	add_nr_running(rq, task_delta);
+	if (rq->cfs.h_nr_running)
+		dl_server_start(&rq->fair_server);
 
 unthrottle_throttle:
 	assert_list_leaf_cfs_rq(rq);
@@ -6082,6 +6128,153 @@ static int sched_idle_cpu(int cpu)
 }
 #endif
 
+static void set_next_buddy(struct sched_entity *se);
+
+#ifdef CONFIG_SCHED_AURORA
+static DEFINE_STATIC_KEY_FALSE(sched_aurora_rq_enabled);
+static struct sched_aurora_rq_ops __rcu *sched_aurora_rq;
+static DEFINE_MUTEX(sched_aurora_rq_mutex);
+
+int sched_aurora_register_rq_ops(struct sched_aurora_rq_ops *ops)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_aurora_rq_mutex);
+	if (rcu_access_pointer(sched_aurora_rq)) {
+		ret = -EBUSY;
+	} else {
+		rcu_assign_pointer(sched_aurora_rq, ops);
+		static_branch_enable(&sched_aurora_rq_enabled);
+	}
+	mutex_unlock(&sched_aurora_rq_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_register_rq_ops);
+
+void sched_aurora_unregister_rq_ops(struct sched_aurora_rq_ops *ops)
+{
+	mutex_lock(&sched_aurora_rq_mutex);
+	if (rcu_access_pointer(sched_aurora_rq) == ops) {
+		static_branch_disable(&sched_aurora_rq_enabled);
+		RCU_INIT_POINTER(sched_aurora_rq, NULL);
+		synchronize_rcu();
+	}
+	mutex_unlock(&sched_aurora_rq_mutex);
+}
+EXPORT_SYMBOL_GPL(sched_aurora_unregister_rq_ops);
+
+/* The registered rq ops, or NULL; callers hold the rq lock or RCU-sched */
+static inline struct sched_aurora_rq_ops *sched_aurora_rq_get(void)
+{
+	if (!static_branch_unlikely(&sched_aurora_rq_enabled))
+		return NULL;
+	return rcu_dereference_sched(sched_aurora_rq);
+}
+
+static void sched_aurora_enqueue(struct rq *rq, struct task_struct *p, bool wakeup)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+
+	if (ops)
+		ops->enqueue(cpu_of(rq), p, wakeup);
+}
+
+static void sched_aurora_dequeue(struct rq *rq, struct task_struct *p, bool sleep)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+
+	if (ops)
+		ops->dequeue(cpu_of(rq), p, sleep);
+}
+
+/*
+ * Make the module's choice the next buddy. pick_next_entity() still
+ * prefers the leftmost entity once the buddy is more than a wakeup
+ * granularity behind it, so the hint cannot starve anyone.
+ */
+static void sched_aurora_pick_hint(struct rq *rq)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+	struct task_struct *p;
+
+	if (!ops)
+		return;
+
+	p = ops->pick_hint(cpu_of(rq));
+	if (!p || task_rq(p) != rq || !task_on_rq_queued(p) ||
+	    p->sched_class != &fair_sched_class ||
+	    throttled_hierarchy(cfs_rq_of(&p->se)))
+		return;
+
+	set_next_buddy(&p->se);
+}
+
+static void sched_aurora_set_next(struct rq *rq, struct task_struct *p)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+
+	if (ops)
+		ops->set_next(cpu_of(rq), p);
+}
+
+static void sched_aurora_put_prev(struct rq *rq, struct task_struct *p)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+
+	if (ops)
+		ops->put_prev(cpu_of(rq), p, task_on_rq_queued(p));
+}
+
+static void sched_aurora_tick(struct rq *rq, struct task_struct *curr)
+{
+	struct sched_aurora_rq_ops *ops = sched_aurora_rq_get();
+
+	if (ops)
+		ops->tick(cpu_of(rq), curr);
+}
+
+void sched_aurora_task_fork(struct task_struct *p)
+{
+	struct sched_aurora_rq_ops *ops;
+
+	rcu_read_lock_sched();
+	ops = sched_aurora_rq_get();
+	if (ops)
+		ops->fork(p);
+	rcu_read_unlock_sched();
+}
+
+void sched_aurora_task_exec(struct task_struct *p)
+{
+	struct sched_aurora_rq_ops *ops;
+
+	rcu_read_lock_sched();
+	ops = sched_aurora_rq_get();
+	if (ops)
+		ops->exec(p);
+	rcu_read_unlock_sched();
+}
+
+void sched_aurora_task_dead(struct task_struct *p)
+{
+	struct sched_aurora_rq_ops *ops;
+
+	rcu_read_lock_sched();
+	ops = sched_aurora_rq_get();
+	if (ops)
+		ops->dead(p);
+	rcu_read_unlock_sched();
+}
+#else
+static inline void sched_aurora_enqueue(struct rq *rq, struct task_struct *p, bool wakeup) { }
+static inline void sched_aurora_dequeue(struct rq *rq, struct task_struct *p, bool sleep) { }
+static inline void sched_aurora_pick_hint(struct rq *rq) { }
+static inline void sched_aurora_set_next(struct rq *rq, struct task_struct *p) { }
+static inline void sched_aurora_put_prev(struct rq *rq, struct task_struct *p) { }
+static inline void sched_aurora_tick(struct rq *rq, struct task_struct *curr) { }
+#endif
+
 /*
  * The enqueue_task method is called before nr_running is
  * increased. Here we update the fair scheduling stats and
@@ -6094,6 +6287,7 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	struct sched_entity *se = &p->se;
 	int idle_h_nr_running = task_has_idle_policy(p);
 	int task_new = !(flags & ENQUEUE_WAKEUP);
+	unsigned int was_running = rq->cfs.h_nr_running;
 
 	/*
 	 * The code below (indirectly) updates schedutil which looks at
@@ -6103,6 +6297,12 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	 */
 	util_est_enqueue(&rq->cfs, p);
 
+	/*
+	 * Before any of the cpufreq updates below, so that schedutil sees
+	 * the Aurora burst boost of a waking task from its first update.
+	 */
+	sched_aurora_enqueue(rq, p, !task_new);
+
 	/*
 	 * If in_iowait is set, the code below may not trigger any cpufreq
 	 * utilization updates, so do it here explicitly with the IOWAIT flag
@@ -6171,11 +6371,12 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 enqueue_throttle:
 	assert_list_leaf_cfs_rq(rq);
 
+	if (!was_running && rq->cfs.h_nr_running)
+		dl_server_start(&rq->fair_server);
+
 	hrtick_update(rq);
 }
 
-static void set_next_buddy(struct sched_entity *se);
-
 /*
  * The dequeue_task method is called before nr_running is
  * decreased. We remove the task from the rbtree and
@@ -6188,9 +6389,20 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	int task_sleep = flags & DEQUEUE_SLEEP;
 	int idle_h_nr_running = task_has_idle_policy(p);
 	bool was_sched_idle = sched_idle_rq(rq);
+	unsigned int was_running = rq->cfs.h_nr_running;
 
 	util_est_dequeue(&rq->cfs, p);
 
+	/*
+	 * Likewise, let the load update below drop the frequency for idle.
+	 * Bring the sleeper's runtime up to date first, so that the burst
+	 * it ends is measured in full; dequeue_entity()'s own update_curr()
+	 * then has nothing left to add.
+	 */
+	if (task_sleep)
+		update_curr(cfs_rq_of(se));
+	sched_aurora_dequeue(rq, p, task_sleep);
+
 	for_each_sched_entity(se) {
 		cfs_rq = cfs_rq_of(se);
 		dequeue_entity(cfs_rq, se, flags);
@@ -6247,6 +6459,9 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 		rq->next_balance = jiffies;
 
 dequeue_throttle:
+	if (was_running && !rq->cfs.h_nr_running)
+		dl_server_stop(&rq->fair_server);
+
 	util_est_update(&rq->cfs, p, task_sleep);
 	hrtick_update(rq);
 }
@@ -6901,6 +7116,70 @@ static inline bool asym_fits_cpu(unsigned long util,
 	return true;
 }
 
+#ifdef CONFIG_SCHED_AURORA
+DEFINE_STATIC_KEY_FALSE(sched_aurora_wake_enabled);
+static struct sched_aurora_wake_ops __rcu *sched_aurora_wake;
+static DEFINE_MUTEX(sched_aurora_wake_mutex);
+
+int sched_aurora_register_wake_ops(struct sched_aurora_wake_ops *ops)
+{
+	int ret = 0;
+
+	mutex_lock(&sched_aurora_wake_mutex);
+	if (rcu_access_pointer(sched_aurora_wake)) {
+		ret = -EBUSY;
+	} else {
+		rcu_assign_pointer(sched_aurora_wake, ops);
+		static_branch_enable(&sched_aurora_wake_enabled);
+	}
+	mutex_unlock(&sched_aurora_wake_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_aurora_register_wake_ops);
+
+void sched_aurora_unregister_wake_ops(struct sched_aurora_wake_ops *ops)
+{
+	mutex_lock(&sched_aurora_wake_mutex);
+	if (rcu_access_pointer(sched_aurora_wake) == ops) {
+		static_branch_disable(&sched_aurora_wake_enabled);
+		RCU_INIT_POINTER(sched_aurora_wake, NULL);
+		synchronize_rcu();
+	}
+	mutex_unlock(&sched_aurora_wake_mutex);
+}
+EXPORT_SYMBOL_GPL(sched_aurora_unregister_wake_ops);
+
+/*
+ * Ask the Aurora wake ops for a preferred CPU. Called from
+ * select_task_rq_fair() under rcu_read_lock(). Returns -1 for no hint.
+ */
+static int sched_aurora_wake_hint(struct task_struct *p, int prev, int target)
+{
+	struct sched_aurora_wake_ops *ops;
+	int cpu;
+
+	if (!static_branch_unlikely(&sched_aurora_wake_enabled))
+		return -1;
+
+	ops = rcu_dereference(sched_aurora_wake);
+	if (!ops)
+		return -1;
+
+	cpu = ops->select_idle_hint(p, prev, target);
+	if ((unsigned int)cpu >= nr_cpumask_bits ||
+	    !cpumask_test_cpu(cpu, p->cpus_ptr) || !cpu_active(cpu))
+		return -1;
+
+	return cpu;
+}
+#else
+static inline int sched_aurora_wake_hint(struct task_struct *p, int prev, int target)
+{
+	return -1;
+}
+#endif
+
 /*
  * Try and locate an idle core/thread in the LLC cache domain.
  */
@@ -6927,6 +7206,20 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	 */
 	lockdep_assert_irqs_disabled();
 
+	/*
+	 * The Aurora hint is based on the task's learned behaviour. An idle
+	 * hinted CPU is taken directly; otherwise a hint into a different
+	 * LLC moves the idle search there.
+	 */
+	i = sched_aurora_wake_hint(p, prev, target);
+	if (i >= 0) {
+		if ((available_idle_cpu(i) || sched_idle_cpu(i)) &&
+		    asym_fits_cpu(task_util, util_min, util_max, i))
+			return i;
+		if (!cpus_share_cache(i, target))
+			target = i;
+	}
+
 	if ((available_idle_cpu(target) || sched_idle_cpu(target)) &&
 	    asym_fits_cpu(task_util, util_min, util_max, target))
 		return target;
@@ -7799,6 +8092,8 @@ again:
 	if (!sched_fair_runnable(rq))
 		goto idle;
 
+	sched_aurora_pick_hint(rq);
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	if (!prev || prev->sched_class != &fair_sched_class)
 		goto simple;
@@ -7872,6 +8167,10 @@ again:
 
 		put_prev_entity(cfs_rq, pse);
 		set_next_entity(cfs_rq, se);
+
+		/* put_prev_task_fair() was bypassed, so tell Aurora here */
+		sched_aurora_put_prev(rq, prev);
+		sched_aurora_set_next(rq, p);
 	}
 
 	goto done;
@@ -7887,6 +8186,7 @@ simple:
 	} while (cfs_rq);
 
 	p = task_of(se);
+	sched_aurora_set_next(rq, p);
 
 done: __maybe_unused;
 #ifdef CONFIG_SMP
@@ -7936,6 +8236,32 @@ static struct task_struct *__pick_next_task_fair(struct rq *rq)
 	return pick_next_task_fair(rq, NULL, NULL);
 }
 
+static struct task_struct *fair_server_pick(struct sched_dl_entity *dl_se)
+{
+	return pick_next_task_fair(dl_se->rq, NULL, NULL);
+}
+
+static struct task_struct *fair_server_pick_task(struct sched_dl_entity *dl_se)
+{
+#ifdef CONFIG_SMP
+	return pick_task_fair(dl_se->rq);
+#else
+	return NULL;
+#endif
+}
+
+/*
+ * The fair server runs CFS tasks from the deadline class once RT tasks
+ * kept them off the CPU for as long as fair_server_runtime still
+ * allows, see the deadline server comment in deadline.c.
+ */
+void fair_server_init(struct rq *rq)
+{
+	dl_server_init(&rq->fair_server, rq, fair_server_runtime,
+		       FAIR_SERVER_PERIOD, fair_server_pick,
+		       fair_server_pick_task);
+}
+
 /*
  * Account for a descheduled task:
  */
@@ -7948,6 +8274,8 @@ static void put_prev_task_fair(struct rq *rq, struct task_struct *prev)
 		cfs_rq = cfs_rq_of(se);
 		put_prev_entity(cfs_rq, se);
 	}
+
+	sched_aurora_put_prev(rq, prev);
 }
 
 /*
@@ -10966,6 +11294,7 @@ static void rebalance_domains(struct rq *rq, enum cpu_idle_type idle)
 	int update_next_balance = 0;
 	int need_serialize, need_decay = 0;
 	u64 max_cost = 0;
+	u64 t0 = sched_clock_cpu(cpu);
 
 	rcu_read_lock();
 	for_each_domain(cpu, sd) {
@@ -11007,6 +11336,14 @@ static void rebalance_domains(struct rq *rq, enum cpu_idle_type idle)
 			}
 			sd->last_balance = jiffies;
 			interval = get_sd_balance_interval(sd, busy);
+
+			/*
+			 * Cap the cost of one pass on wide machines: the
+			 * levels left are still due and get balanced on the
+			 * next tick instead.
+			 */
+			if (sched_clock_cpu(cpu) - t0 > sysctl_sched_migration_cost)
+				continue_balancing = 0;
 		}
 		if (need_serialize)
 			spin_unlock(&balancing);
@@ -11530,6 +11867,29 @@ static inline bool nohz_idle_balance(struct rq *this_rq, enum cpu_idle_type idle
 static inline void nohz_newidle_balance(struct rq *this_rq) { }
 #endif /* CONFIG_NO_HZ_COMMON */
 
+/*
+ * Whether a newidle balance at @sd can find anything to pull, going by
+ * the root domain's overload_mask: a CPU in the span with a queued task,
+ * leaving out the CPUs of @balanced, which were balanced already. Only
+ * asymmetric capacity and packing pull single running tasks, so their
+ * domains are always worth a look.
+ */
+static bool newidle_pullable(struct rq *this_rq, struct sched_domain *sd,
+			     const struct cpumask *balanced)
+{
+	int cpu;
+
+	if (sd->flags & (SD_ASYM_CPUCAPACITY | SD_ASYM_PACKING))
+		return true;
+
+	for_each_cpu_and(cpu, sched_domain_span(sd), this_rq->rd->overload_mask) {
+		if (!balanced || !cpumask_test_cpu(cpu, balanced))
+			return true;
+	}
+
+	return false;
+}
+
 /*
  * newidle_balance is called by schedule() if this_cpu is about to become
  * idle. Attempts to pull tasks from other CPUs.
@@ -11544,10 +11904,12 @@ static int newidle_balance(struct rq *this_rq, struct rq_flags *rf)
 	unsigned long next_balance = jiffies + HZ;
 	int this_cpu = this_rq->cpu;
 	u64 t0, t1, curr_cost = 0;
-	struct sched_domain *sd;
+	const struct cpumask *balanced = NULL;
+	struct sched_domain *sd, *llc;
 	int pulled_task = 0;
 
 	update_misfit_status(NULL, this_rq);
+	update_overload_mask(this_rq);
 
 	/*
 	 * There is a task waiting to run. No need to search for one.
@@ -11596,6 +11958,7 @@ static int newidle_balance(struct rq *this_rq, struct rq_flags *rf)
 	update_blocked_averages(this_cpu);
 
 	rcu_read_lock();
+	llc = rcu_dereference(per_cpu(sd_llc, this_cpu));
 	for_each_domain(this_cpu, sd) {
 		int continue_balancing = 1;
 		u64 domain_cost;
@@ -11605,6 +11968,13 @@ static int newidle_balance(struct rq *this_rq, struct rq_flags *rf)
 		if (this_rq->avg_idle < curr_cost + sd->max_newidle_lb_cost)
 			break;
 
+		/*
+		 * Skip levels with nothing queued to pull. Past the local
+		 * LLC, which is tried first, only CPUs outside of it count.
+		 */
+		if (!newidle_pullable(this_rq, sd, balanced))
+			goto next;
+
 		if (sd->flags & SD_BALANCE_NEWIDLE) {
 
 			pulled_task = load_balance(this_cpu, this_rq,
@@ -11626,6 +11996,9 @@ static int newidle_balance(struct rq *this_rq, struct rq_flags *rf)
 		if (pulled_task || this_rq->nr_running > 0 ||
 		    this_rq->ttwu_pending)
 			break;
+next:
+		if (sd == llc)
+			balanced = sched_domain_span(sd);
 	}
 	rcu_read_unlock();
 
@@ -11857,9 +12230,12 @@ static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 		task_tick_numa(rq, curr);
 
 	update_misfit_status(curr, rq);
+	update_overload_mask(rq);
 	check_update_overutilized_status(task_rq(curr));
 
 	task_tick_core(rq, curr);
+
+	sched_aurora_tick(rq, curr);
 }
 
 /*
@@ -12094,6 +12470,8 @@ static void set_next_task_fair(struct rq *rq, struct task_struct *p, bool first)
 		/* ensure bandwidth has been allocated on our new cfs_rq */
 		account_cfs_rq_runtime(cfs_rq, 0);
 	}
+
+	sched_aurora_set_next(rq, p);
 }
 
 void init_cfs_rq(struct cfs_rq *cfs_rq)
@@ -225,6 +225,7 @@ void membarrier_exec_mmap(struct mm_struct *mm)
 	 */
 	smp_mb();
 	atomic_set(&mm->membarrier_state, 0);
+	WRITE_ONCE(mm->membarrier_scoped, false);
 	/*
 	 * Keep the runqueue membarrier_state in sync with this mm
 	 * membarrier_state.
@@ -310,11 +311,30 @@ static int membarrier_global_expedited(void)
 	return 0;
 }
 
+/*
+ * Private expedited waves of an mm are numbered by mm->membarrier_seq
+ * like an RCU sequence, odd while one is under way. Any wave starting
+ * after a caller's entry barrier orders that caller's accesses just as
+ * its own wave would, so callers from the same mm queued up behind the
+ * IPI mutex are served by a single wave.
+ */
+static unsigned long membarrier_wave_snap(struct mm_struct *mm)
+{
+	return (READ_ONCE(mm->membarrier_seq) + 3) & ~0x1UL;
+}
+
+static bool membarrier_wave_done(struct mm_struct *mm, unsigned long snap)
+{
+	return ULONG_CMP_GE(READ_ONCE(mm->membarrier_seq), snap);
+}
+
 static int membarrier_private_expedited(int flags, int cpu_id)
 {
 	cpumask_var_t tmpmask;
 	struct mm_struct *mm = current->mm;
 	smp_call_func_t ipi_func = ipi_mb;
+	bool batch = !flags && cpu_id < 0;
+	unsigned long snap = 0;
 
 	if (flags == MEMBARRIER_FLAG_SYNC_CORE) {
 		if (!IS_ENABLED(CONFIG_ARCH_HAS_MEMBARRIER_SYNC_CORE))
@@ -347,12 +367,30 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 	 */
 	smp_mb();	/* system call entry is not a mb. */
 
+	if (batch)
+		snap = membarrier_wave_snap(mm);
+
 	if (cpu_id < 0 && !zalloc_cpumask_var(&tmpmask, GFP_KERNEL))
 		return -ENOMEM;
 
+	/* The process vouched for keeping its threads in one cpuset */
+	if (cpu_id < 0 && READ_ONCE(mm->membarrier_scoped))
+		cpuset_cpus_allowed(current, tmpmask);
+	else if (cpu_id < 0)
+		cpumask_copy(tmpmask, cpu_online_mask);
+
 	SERIALIZE_IPI();
 	cpus_read_lock();
 
+	if (batch) {
+		/* Someone else's wave started after our entry barrier */
+		if (membarrier_wave_done(mm, snap))
+			goto out;
+
+		WRITE_ONCE(mm->membarrier_seq, mm->membarrier_seq + 1);
+		smp_mb();	/* Start the wave before looking at rq->curr. */
+	}
+
 	if (cpu_id >= 0) {
 		struct task_struct *p;
 
@@ -369,12 +407,12 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 		int cpu;
 
 		rcu_read_lock();
-		for_each_online_cpu(cpu) {
+		for_each_cpu(cpu, tmpmask) {
 			struct task_struct *p;
 
 			p = rcu_dereference(cpu_rq(cpu)->curr);
-			if (p && p->mm == mm)
-				__cpumask_set_cpu(cpu, tmpmask);
+			if (!cpu_online(cpu) || !p || p->mm != mm)
+				__cpumask_clear_cpu(cpu, tmpmask);
 		}
 		rcu_read_unlock();
 	}
@@ -412,6 +450,10 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 		}
 	}
 
+	/* All IPIs of the wave have completed */
+	if (batch)
+		smp_store_release(&mm->membarrier_seq, mm->membarrier_seq + 1);
+
 out:
 	if (cpu_id < 0)
 		free_cpumask_var(tmpmask);
@@ -546,6 +588,18 @@ static int membarrier_register_private_expedited(int flags)
 	return 0;
 }
 
+static int membarrier_register_private_expedited_cpuset(void)
+{
+	int ret;
+
+	ret = membarrier_register_private_expedited(0);
+	if (ret)
+		return ret;
+	WRITE_ONCE(current->mm->membarrier_scoped, true);
+
+	return 0;
+}
+
 /**
  * sys_membarrier - issue memory barriers on a set of threads
  * @cmd:    Takes command values defined in enum membarrier_cmd.
@@ -553,7 +607,10 @@ static int membarrier_register_private_expedited(int flags)
  *          MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ: in the latter
  *          case it can be MEMBARRIER_CMD_FLAG_CPU, indicating that @cpu_id
  *          contains the CPU on which to interrupt (= restart)
- *          the RSEQ critical section.
+ *          the RSEQ critical section, and
+ *          MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, which takes
+ *          MEMBARRIER_CMD_FLAG_CPUSET to confine the process's
+ *          private expedited IPIs to the caller's cpuset.
  * @cpu_id: if @flags == MEMBARRIER_CMD_FLAG_CPU, indicates the cpu on which
  *          RSEQ CS should be interrupted (@cmd must be
  *          MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ).
@@ -589,6 +646,10 @@ SYSCALL_DEFINE3(membarrier, int, cmd, unsigned int, flags, int, cpu_id)
 		if (unlikely(flags && flags != MEMBARRIER_CMD_FLAG_CPU))
 			return -EINVAL;
 		break;
+	case MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED:
+		if (unlikely(flags && flags != MEMBARRIER_CMD_FLAG_CPUSET))
+			return -EINVAL;
+		break;
 	default:
 		if (unlikely(flags))
 			return -EINVAL;
@@ -620,6 +681,8 @@ SYSCALL_DEFINE3(membarrier, int, cmd, unsigned int, flags, int, cpu_id)
 	case MEMBARRIER_CMD_PRIVATE_EXPEDITED:
 		return membarrier_private_expedited(0, cpu_id);
 	case MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED:
+		if (flags & MEMBARRIER_CMD_FLAG_CPUSET)
+			return membarrier_register_private_expedited_cpuset();
 		return membarrier_register_private_expedited(0);
 	case MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE:
 		return membarrier_private_expedited(MEMBARRIER_FLAG_SYNC_CORE, cpu_id);
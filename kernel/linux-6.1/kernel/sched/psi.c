@@ -153,6 +153,29 @@ static int __init setup_psi(char *str)
 }
 __setup("psi=", setup_psi);
 
+/*
+ * cgroup levels that keep stall accounting of their own, as a list of
+ * depths for psi_levels=, the root being 0. A task state change only
+ * walks the task's groups at these levels, so its cost is bounded by
+ * their number rather than by how deep the hierarchy goes. Stall times
+ * of sibling groups overlap, so groups in between cannot be derived
+ * from their descendants and report no pressure.
+ */
+static unsigned long psi_levels __read_mostly = ~0UL;
+
+static int __init setup_psi_levels(char *str)
+{
+	unsigned long levels = 0;
+
+	if (bitmap_parselist(str, &levels, BITS_PER_LONG))
+		return 0;
+
+	/* The root is the system-wide group, always accounted */
+	psi_levels = levels | 1;
+	return 1;
+}
+__setup("psi_levels=", setup_psi_levels);
+
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
@@ -182,6 +205,7 @@ static void group_init(struct psi_group *group)
 	int cpu;
 
 	group->enabled = true;
+	group->account = group;
 	for_each_possible_cpu(cpu)
 		seqcount_init(&per_cpu_ptr(group->pcpu, cpu)->seq);
 	group->avg_last_update = sched_clock();
@@ -889,7 +913,7 @@ static inline struct psi_group *task_psi_group(struct task_struct *task)
 {
 #ifdef CONFIG_CGROUPS
 	if (static_branch_likely(&psi_cgroups_enabled))
-		return cgroup_psi(task_dfl_cgroup(task));
+		return cgroup_psi(task_dfl_cgroup(task))->account;
 #endif
 	return &psi_system;
 }
@@ -1111,6 +1135,8 @@ EXPORT_SYMBOL_GPL(psi_memstall_leave);
 #ifdef CONFIG_CGROUPS
 int psi_cgroup_alloc(struct cgroup *cgroup)
 {
+	struct psi_group *parent;
+
 	if (!static_branch_likely(&psi_cgroups_enabled))
 		return 0;
 
@@ -1124,7 +1150,14 @@ int psi_cgroup_alloc(struct cgroup *cgroup)
 		return -ENOMEM;
 	}
 	group_init(cgroup->psi);
-	cgroup->psi->parent = cgroup_psi(cgroup_parent(cgroup));
+	parent = cgroup_psi(cgroup_parent(cgroup));
+	cgroup->psi->parent = parent->account;
+
+	/* Not an aggregation level: hand the tasks to the one above */
+	if (!test_bit(min_t(int, cgroup->level, BITS_PER_LONG - 1), &psi_levels)) {
+		cgroup->psi->account = parent->account;
+		cgroup->psi->enabled = false;
+	}
 	return 0;
 }
 
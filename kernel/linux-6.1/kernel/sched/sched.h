@@ -339,6 +339,19 @@ struct rt_rq;
 
 extern struct list_head task_groups;
 
+#ifdef CONFIG_SCHEDSTATS
+/*
+ * Runqueue wait histogram of a task group, per CPU. Bucket 0 counts
+ * waits below 2us, bucket i waits of [2^i, 2^(i+1)) us, and the last
+ * one everything longer.
+ */
+#define SCHED_WAIT_HIST_BUCKETS	24
+
+struct sched_wait_hist {
+	u64			bucket[SCHED_WAIT_HIST_BUCKETS];
+};
+#endif
+
 struct cfs_bandwidth {
 #ifdef CONFIG_CFS_BANDWIDTH
 	raw_spinlock_t		lock;
@@ -418,6 +431,10 @@ struct task_group {
 	struct uclamp_se	uclamp[UCLAMP_CNT];
 #endif
 
+#ifdef CONFIG_SCHEDSTATS
+	/* Runqueue waits of the group's own tasks, see stats.c */
+	struct sched_wait_hist __percpu *wait_hist;
+#endif
 };
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -833,6 +850,15 @@ struct root_domain {
 	 */
 	int			overload;
 
+	/*
+	 * CPUs with more than one runnable task, kept per CPU unlike
+	 * overload so that a balancer can tell whether a domain has
+	 * anything queued to pull without walking its groups. Set on
+	 * enqueue and cleared lazily by the CPU itself, so a bit may be
+	 * stale only in the harmless direction.
+	 */
+	cpumask_var_t		overload_mask;
+
 	/* Indicate one or more cpus over-utilized (tipping point) */
 	int			overutilized;
 
@@ -990,6 +1016,7 @@ struct rq {
 	struct cfs_rq		cfs;
 	struct rt_rq		rt;
 	struct dl_rq		dl;
+	struct sched_dl_entity	fair_server;
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this CPU: */
@@ -2359,6 +2386,15 @@ extern void init_dl_bandwidth(struct dl_bandwidth *dl_b, u64 period, u64 runtime
 extern void init_dl_task_timer(struct sched_dl_entity *dl_se);
 extern void init_dl_inactive_task_timer(struct sched_dl_entity *dl_se);
 
+extern void dl_server_init(struct sched_dl_entity *dl_se, struct rq *rq,
+			   u64 runtime, u64 period, dl_server_pick_f pick,
+			   dl_server_pick_f pick_task);
+extern void dl_server_start(struct sched_dl_entity *dl_se);
+extern void dl_server_stop(struct sched_dl_entity *dl_se);
+extern void dl_server_update(struct sched_dl_entity *dl_se, s64 delta_exec);
+extern void sched_init_dl_servers(void);
+extern void fair_server_init(struct rq *rq);
+
 #define BW_SHIFT		20
 #define BW_UNIT			(1 << BW_SHIFT)
 #define RATIO_SHIFT		8
@@ -2408,6 +2444,8 @@ static inline void add_nr_running(struct rq *rq, unsigned count)
 	if (prev_nr < 2 && rq->nr_running >= 2) {
 		if (!READ_ONCE(rq->rd->overload))
 			WRITE_ONCE(rq->rd->overload, 1);
+		if (!cpumask_test_cpu(cpu_of(rq), rq->rd->overload_mask))
+			cpumask_set_cpu(cpu_of(rq), rq->rd->overload_mask);
 	}
 #endif
 
@@ -213,6 +213,79 @@ static const struct seq_operations schedstat_sops = {
 	.show  = show_schedstat,
 };
 
+#ifdef CONFIG_CGROUP_SCHED
+/*
+ * Runqueue wait histograms per task group. Unlike the rest of schedstats
+ * they are collected whether or not schedstats are enabled: recording
+ * is one per-CPU increment when a task gets on a CPU, done from
+ * sched_info_arrive() under the rq lock. Reading sums over CPUs and
+ * descendant groups.
+ */
+static DEFINE_PER_CPU(struct sched_wait_hist, root_wait_hist);
+
+void __init sched_wait_hist_init(void)
+{
+	root_task_group.wait_hist = &root_wait_hist;
+}
+
+int alloc_sched_wait_hist(struct task_group *tg)
+{
+	tg->wait_hist = alloc_percpu(struct sched_wait_hist);
+
+	return tg->wait_hist != NULL;
+}
+
+void free_sched_wait_hist(struct task_group *tg)
+{
+	free_percpu(tg->wait_hist);
+}
+
+void sched_wait_hist_account(struct task_struct *p, u64 delta)
+{
+	u64 usecs = div_u64(delta, NSEC_PER_USEC);
+	unsigned int idx = 0;
+
+	if (usecs)
+		idx = min_t(unsigned int, ilog2(usecs), SCHED_WAIT_HIST_BUCKETS - 1);
+
+	__this_cpu_inc(task_group(p)->wait_hist->bucket[idx]);
+}
+
+static void sched_wait_hist_add(u64 *sum, struct task_group *tg)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct sched_wait_hist *hist = per_cpu_ptr(tg->wait_hist, cpu);
+
+		for (i = 0; i < SCHED_WAIT_HIST_BUCKETS; i++)
+			sum[i] += READ_ONCE(hist->bucket[i]);
+	}
+}
+
+void sched_wait_hist_show(struct seq_file *sf, struct task_group *tg)
+{
+	u64 sum[SCHED_WAIT_HIST_BUCKETS] = { };
+	struct cgroup_subsys_state *css;
+	int i;
+
+	rcu_read_lock();
+	if (tg == &root_task_group) {
+		/* Also autogroups, which have no css of their own */
+		list_for_each_entry_rcu(tg, &task_groups, list)
+			sched_wait_hist_add(sum, tg);
+	} else {
+		css_for_each_descendant_pre(css, &tg->css)
+			sched_wait_hist_add(sum, container_of(css, struct task_group, css));
+	}
+	rcu_read_unlock();
+
+	for (i = 0; i < SCHED_WAIT_HIST_BUCKETS - 1; i++)
+		seq_printf(sf, "lt_%lu_usec %llu\n", 2UL << i, sum[i]);
+	seq_printf(sf, "ge_%lu_usec %llu\n", 1UL << i, sum[i]);
+}
+#endif /* CONFIG_CGROUP_SCHED */
+
 static int __init proc_schedstat_init(void)
 {
 	proc_create_seq("schedstat", 0, NULL, &schedstat_sops);
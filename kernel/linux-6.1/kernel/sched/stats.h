@@ -52,6 +52,16 @@ void __update_stats_wait_end(struct rq *rq, struct task_struct *p,
 void __update_stats_enqueue_sleeper(struct rq *rq, struct task_struct *p,
 				    struct sched_statistics *stats);
 
+#ifdef CONFIG_CGROUP_SCHED
+extern void sched_wait_hist_init(void);
+extern int alloc_sched_wait_hist(struct task_group *tg);
+extern void free_sched_wait_hist(struct task_group *tg);
+extern void sched_wait_hist_account(struct task_struct *p, u64 delta);
+extern void sched_wait_hist_show(struct seq_file *sf, struct task_group *tg);
+#else
+static inline void sched_wait_hist_account(struct task_struct *p, u64 delta) { }
+#endif
+
 static inline void
 check_schedstat_required(void)
 {
@@ -87,6 +97,11 @@ static inline void rq_sched_info_depart  (struct rq *rq, unsigned long long delt
 # define __update_stats_enqueue_sleeper(rq, p, stats)  do { } while (0)
 # define check_schedstat_required()                    do { } while (0)
 
+static inline void sched_wait_hist_init(void) { }
+static inline int alloc_sched_wait_hist(struct task_group *tg) { return 1; }
+static inline void free_sched_wait_hist(struct task_group *tg) { }
+static inline void sched_wait_hist_account(struct task_struct *p, u64 delta) { }
+
 #endif /* CONFIG_SCHEDSTATS */
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -255,6 +270,7 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 	t->sched_info.pcount++;
 
 	rq_sched_info_arrive(rq, delta);
+	sched_wait_hist_account(t, delta);
 }
 
 /*
@@ -476,6 +476,7 @@ static void free_rootdomain(struct rcu_head *rcu)
 	cpudl_cleanup(&rd->cpudl);
 	free_cpumask_var(rd->dlo_mask);
 	free_cpumask_var(rd->rto_mask);
+	free_cpumask_var(rd->overload_mask);
 	free_cpumask_var(rd->online);
 	free_cpumask_var(rd->span);
 	free_pd(rd->pd);
@@ -496,6 +497,7 @@ void rq_attach_root(struct rq *rq, struct root_domain *rd)
 			set_rq_offline(rq);
 
 		cpumask_clear_cpu(rq->cpu, old_rd->span);
+		cpumask_clear_cpu(rq->cpu, old_rd->overload_mask);
 
 		/*
 		 * If we dont want to free the old_rd yet then
@@ -510,6 +512,8 @@ void rq_attach_root(struct rq *rq, struct root_domain *rd)
 	rq->rd = rd;
 
 	cpumask_set_cpu(rq->cpu, rd->span);
+	if (rq->nr_running >= 2)
+		cpumask_set_cpu(rq->cpu, rd->overload_mask);
 	if (cpumask_test_cpu(rq->cpu, cpu_active_mask))
 		set_rq_online(rq);
 
@@ -538,8 +542,10 @@ static int init_rootdomain(struct root_domain *rd)
 		goto out;
 	if (!zalloc_cpumask_var(&rd->online, GFP_KERNEL))
 		goto free_span;
-	if (!zalloc_cpumask_var(&rd->dlo_mask, GFP_KERNEL))
+	if (!zalloc_cpumask_var(&rd->overload_mask, GFP_KERNEL))
 		goto free_online;
+	if (!zalloc_cpumask_var(&rd->dlo_mask, GFP_KERNEL))
+		goto free_overload_mask;
 	if (!zalloc_cpumask_var(&rd->rto_mask, GFP_KERNEL))
 		goto free_dlo_mask;
 
@@ -564,6 +570,8 @@ free_rto_mask:
 	free_cpumask_var(rd->rto_mask);
 free_dlo_mask:
 	free_cpumask_var(rd->dlo_mask);
+free_overload_mask:
+	free_cpumask_var(rd->overload_mask);
 free_online:
 	free_cpumask_var(rd->online);
 free_span:
@@ -1683,6 +1691,32 @@ void set_sched_topology(struct sched_domain_topology_level *tl)
 	sched_domain_topology_saved = NULL;
 }
 
+/**
+ * sched_llc_cpumask - CPUs sharing the last level cache with @cpu
+ * @cpu: the CPU in question
+ *
+ * Taken from the topology levels rather than from the sched domains
+ * built on them, so the span is neither clipped by cpuset partitions
+ * nor missing for isolated CPUs. It is the span of the widest level
+ * whose domains share package resources, MC where there is one.
+ *
+ * Return: the LLC span of @cpu, or just @cpu when no level shares a
+ * cache. Stable while CPU hotplug is held off.
+ */
+const struct cpumask *sched_llc_cpumask(int cpu)
+{
+	const struct cpumask *llc = cpumask_of(cpu);
+	struct sched_domain_topology_level *tl;
+
+	for_each_sd_topology(tl) {
+		if (!tl->sd_flags || !(tl->sd_flags() & SD_SHARE_PKG_RESOURCES))
+			break;
+		llc = tl->mask(cpu);
+	}
+
+	return llc;
+}
+
 #ifdef CONFIG_NUMA
 
 static const struct cpumask *sd_numa_mask(int cpu)
@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  Slack coalesced hrtimers
+ *
+ *  Network and application timeouts are armed by the million, usually
+ *  with milliseconds of slack, yet each plain hrtimer pays an rbtree
+ *  insertion and, whenever it becomes the first timer, a clock event
+ *  reprogram. A coarse timer instead rounds its expiry up to the largest
+ *  power of two granularity that fits into its slack and joins the per
+ *  CPU slot for that rounded expiry. Only the slot is an hrtimer, so all
+ *  timers of a slot share one rbtree node, one clock event programming
+ *  and one expiry run.
+ *
+ *  Slots are armed by their own CPU only and released by their own
+ *  expiry only, so adding a timer to a slot or removing it from one is a
+ *  list operation under the per CPU lock. When a CPU runs out of slots,
+ *  or the slack is too small for rounding to gain anything, the timer
+ *  falls back to its embedded hrtimer armed with the same slack.
+ *
+ *  Like hrtimers, a coarse timer whose callback is running is never
+ *  moved to another CPU, and the callback may free the timer.
+ */
+
+#include <linux/cpumask.h>
+#include <linux/export.h>
+#include <linux/hash.h>
+#include <linux/hrtimer.h>
+#include <linux/init.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+
+/* Slot granularity range: ~1ms, below that rounding buys nothing, to ~4s */
+#define COARSE_MIN_SHIFT	20
+#define COARSE_MAX_SHIFT	32
+
+#define COARSE_NR_SLOTS		32
+#define COARSE_HASH_BITS	4
+
+/* hrtimer_coarse::flags */
+#define COARSE_FALLBACK		0x01	/* queued on the embedded hrtimer */
+
+struct hrtimer_coarse_slot {
+	struct hrtimer			timer;
+	struct hlist_head		timers;
+	struct hlist_node		node;	/* hash chain or free list */
+	ktime_t				expires;
+	struct hrtimer_coarse_base	*cpu_base;
+};
+
+/*
+ * @running and @running_hrtimer track the callback in flight; @restart
+ * records that it was re-armed from another CPU meanwhile. The callback
+ * state lives here rather than in the timer so that the callback can
+ * free it.
+ */
+struct hrtimer_coarse_base {
+	raw_spinlock_t			lock;
+	struct hrtimer_coarse		*running;
+	struct hrtimer			*running_hrtimer;
+	bool				restart;
+	struct hlist_head		hash[1 << COARSE_HASH_BITS];
+	struct hlist_head		free;
+	struct hrtimer_coarse_slot	slots[COARSE_NR_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct hrtimer_coarse_base, hrtimer_coarse_bases);
+
+/*
+ * ->cpu_base is NULL while the timer moves between CPUs, see
+ * hrtimer_coarse_start().
+ */
+static struct hrtimer_coarse_base *
+lock_coarse_base(struct hrtimer_coarse *timer, unsigned long *flags)
+{
+	for (;;) {
+		struct hrtimer_coarse_base *base = READ_ONCE(timer->cpu_base);
+
+		if (likely(base)) {
+			raw_spin_lock_irqsave(&base->lock, *flags);
+			if (likely(base == timer->cpu_base))
+				return base;
+			raw_spin_unlock_irqrestore(&base->lock, *flags);
+		}
+		cpu_relax();
+	}
+}
+
+/* Take @timer off its slot or its fallback hrtimer. */
+static bool __coarse_dequeue(struct hrtimer_coarse_base *base,
+			     struct hrtimer_coarse *timer)
+{
+	bool queued = false;
+
+	if (timer->slot) {
+		hlist_del(&timer->entry);
+		WRITE_ONCE(timer->slot, NULL);
+		queued = true;
+	}
+	if (timer->flags & COARSE_FALLBACK) {
+		/*
+		 * A fallback callback which already started sees the flag
+		 * cleared once it gets the lock and leaves the timer alone.
+		 */
+		hrtimer_try_to_cancel(&timer->timer);
+		timer->flags &= ~COARSE_FALLBACK;
+		queued = true;
+	}
+	if (base->running == timer && base->restart) {
+		base->restart = false;
+		queued = true;
+	}
+	return queued;
+}
+
+static struct hrtimer_coarse_slot *
+coarse_get_slot(struct hrtimer_coarse_base *base, ktime_t expires)
+{
+	struct hlist_head *head;
+	struct hrtimer_coarse_slot *slot;
+
+	head = &base->hash[hash_64(expires, COARSE_HASH_BITS)];
+	hlist_for_each_entry(slot, head, node) {
+		if (slot->expires == expires)
+			return slot;
+	}
+
+	if (hlist_empty(&base->free))
+		return NULL;
+
+	slot = hlist_entry(base->free.first, struct hrtimer_coarse_slot, node);
+	hlist_del(&slot->node);
+	hlist_add_head(&slot->node, head);
+	slot->expires = expires;
+	hrtimer_start(&slot->timer, expires, HRTIMER_MODE_ABS_PINNED_SOFT);
+	return slot;
+}
+
+static void __coarse_enqueue(struct hrtimer_coarse_base *base,
+			     struct hrtimer_coarse *timer)
+{
+	struct hrtimer_coarse_slot *slot = NULL;
+	unsigned int shift;
+
+	/* Slots are armed by their own CPU only */
+	if (timer->slack >= (1ULL << COARSE_MIN_SHIFT) &&
+	    base == this_cpu_ptr(&hrtimer_coarse_bases)) {
+		shift = min_t(unsigned int, ilog2(timer->slack), COARSE_MAX_SHIFT);
+		slot = coarse_get_slot(base, round_up(timer->expires, 1LL << shift));
+	}
+
+	if (!slot) {
+		timer->flags |= COARSE_FALLBACK;
+		hrtimer_start_range_ns(&timer->timer, timer->expires, timer->slack,
+				       HRTIMER_MODE_ABS_PINNED_SOFT);
+		return;
+	}
+
+	hlist_add_head(&timer->entry, &slot->timers);
+	WRITE_ONCE(timer->slot, slot);
+}
+
+/* Called with @base->lock held, which is dropped around the callback. */
+static void __coarse_run(struct hrtimer_coarse_base *base,
+			 struct hrtimer_coarse *timer, struct hrtimer *hrtimer,
+			 unsigned long *flags)
+{
+	void (*fn)(struct hrtimer_coarse *) = timer->function;
+
+	base->running = timer;
+	base->running_hrtimer = hrtimer;
+	raw_spin_unlock_irqrestore(&base->lock, *flags);
+
+	fn(timer);
+
+	raw_spin_lock_irqsave(&base->lock, *flags);
+	/* Re-armed from another CPU while running, so still alive */
+	if (base->restart) {
+		base->restart = false;
+		__coarse_enqueue(base, timer);
+	}
+	base->running = NULL;
+	base->running_hrtimer = NULL;
+}
+
+static enum hrtimer_restart hrtimer_coarse_slot_expire(struct hrtimer *hrtimer)
+{
+	struct hrtimer_coarse_slot *slot =
+		container_of(hrtimer, struct hrtimer_coarse_slot, timer);
+	struct hrtimer_coarse_base *base = slot->cpu_base;
+	struct hrtimer_coarse *timer;
+	HLIST_HEAD(expired);
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&base->lock, flags);
+	hlist_move_list(&slot->timers, &expired);
+	hlist_del(&slot->node);
+	hlist_add_head(&slot->node, &base->free);
+
+	/*
+	 * The timers keep ->slot set while on @expired, so a concurrent
+	 * cancel still unlinks them.
+	 */
+	while (!hlist_empty(&expired)) {
+		timer = hlist_entry(expired.first, struct hrtimer_coarse, entry);
+		hlist_del(&timer->entry);
+		WRITE_ONCE(timer->slot, NULL);
+		__coarse_run(base, timer, hrtimer, &flags);
+	}
+	raw_spin_unlock_irqrestore(&base->lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+static enum hrtimer_restart hrtimer_coarse_fallback_expire(struct hrtimer *hrtimer)
+{
+	struct hrtimer_coarse *timer =
+		container_of(hrtimer, struct hrtimer_coarse, timer);
+	struct hrtimer_coarse_base *base;
+	unsigned long flags;
+
+	base = lock_coarse_base(timer, &flags);
+	/*
+	 * Skip if the timer was dequeued after this expiry started, or
+	 * dequeued and queued on the hrtimer again for a later time.
+	 */
+	if ((timer->flags & COARSE_FALLBACK) && !hrtimer_is_queued(hrtimer)) {
+		timer->flags &= ~COARSE_FALLBACK;
+		__coarse_run(base, timer, hrtimer, &flags);
+	}
+	raw_spin_unlock_irqrestore(&base->lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * hrtimer_coarse_init - initialize a slack coalesced timer
+ * @timer:	the timer to be initialized
+ * @function:	callback, invoked in softirq context
+ */
+void hrtimer_coarse_init(struct hrtimer_coarse *timer,
+			 void (*function)(struct hrtimer_coarse *))
+{
+	hrtimer_init(&timer->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+	timer->timer.function = hrtimer_coarse_fallback_expire;
+	INIT_HLIST_NODE(&timer->entry);
+	timer->slot = NULL;
+	timer->cpu_base = raw_cpu_ptr(&hrtimer_coarse_bases);
+	timer->expires = 0;
+	timer->slack = 0;
+	timer->function = function;
+	timer->flags = 0;
+}
+EXPORT_SYMBOL_GPL(hrtimer_coarse_init);
+
+/**
+ * hrtimer_coarse_start - (re)start a slack coalesced timer
+ * @timer:	the timer to be added
+ * @tim:	expiry time on CLOCK_MONOTONIC
+ * @slack_ns:	how much later than @tim the timer may expire
+ * @mode:	absolute (HRTIMER_MODE_ABS) or relative (HRTIMER_MODE_REL);
+ *		the timer is always queued on the current CPU
+ *
+ * The timer expires no earlier than @tim and, timer latency aside, no
+ * later than @tim + @slack_ns. Slack of a millisecond or more lets it
+ * share a slot with other coarse timers.
+ */
+void hrtimer_coarse_start(struct hrtimer_coarse *timer, ktime_t tim,
+			  u64 slack_ns, const enum hrtimer_mode mode)
+{
+	struct hrtimer_coarse_base *base, *new_base;
+	unsigned long flags;
+
+	if (mode & HRTIMER_MODE_REL)
+		tim = ktime_add_safe(tim, ktime_get());
+
+	base = lock_coarse_base(timer, &flags);
+	__coarse_dequeue(base, timer);
+	timer->expires = tim;
+	timer->slack = slack_ns;
+
+	new_base = this_cpu_ptr(&hrtimer_coarse_bases);
+	if (base != new_base) {
+		/*
+		 * A running timer stays with its CPU, which requeues it
+		 * once the callback returns. That keeps the callback
+		 * serialized against itself.
+		 */
+		if (base->running == timer) {
+			base->restart = true;
+			goto unlock;
+		}
+		WRITE_ONCE(timer->cpu_base, NULL);
+		raw_spin_unlock(&base->lock);
+		base = new_base;
+		raw_spin_lock(&base->lock);
+		WRITE_ONCE(timer->cpu_base, base);
+	}
+	__coarse_enqueue(base, timer);
+unlock:
+	raw_spin_unlock_irqrestore(&base->lock, flags);
+}
+EXPORT_SYMBOL_GPL(hrtimer_coarse_start);
+
+/**
+ * hrtimer_coarse_try_to_cancel - try to deactivate a slack coalesced timer
+ * @timer:	timer to stop
+ *
+ * Returns:
+ *
+ *  *  0 when the timer was not active
+ *  *  1 when the timer was active
+ *  * -1 when the timer is currently executing the callback function and
+ *    cannot be stopped
+ */
+int hrtimer_coarse_try_to_cancel(struct hrtimer_coarse *timer)
+{
+	struct hrtimer_coarse_base *base;
+	unsigned long flags;
+	int ret;
+
+	base = lock_coarse_base(timer, &flags);
+	if (base->running == timer)
+		ret = -1;
+	else
+		ret = __coarse_dequeue(base, timer);
+	raw_spin_unlock_irqrestore(&base->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_coarse_try_to_cancel);
+
+static void hrtimer_coarse_wait_running(struct hrtimer_coarse *timer)
+{
+	struct hrtimer_coarse_base *base = READ_ONCE(timer->cpu_base);
+	struct hrtimer *running = base ? READ_ONCE(base->running_hrtimer) : NULL;
+
+	if (running)
+		hrtimer_cancel_wait_running(running);
+	else
+		cpu_relax();
+}
+
+/**
+ * hrtimer_coarse_cancel - cancel a slack coalesced timer and wait for the
+ *			   callback to finish
+ * @timer:	the timer to be cancelled
+ *
+ * Returns:
+ *  0 when the timer was not active
+ *  1 when the timer was active
+ */
+int hrtimer_coarse_cancel(struct hrtimer_coarse *timer)
+{
+	int ret;
+
+	do {
+		ret = hrtimer_coarse_try_to_cancel(timer);
+
+		if (ret < 0)
+			hrtimer_coarse_wait_running(timer);
+	} while (ret < 0);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_coarse_cancel);
+
+static int __init hrtimer_coarse_init_bases(void)
+{
+	struct hrtimer_coarse_base *base;
+	struct hrtimer_coarse_slot *slot;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		base = per_cpu_ptr(&hrtimer_coarse_bases, cpu);
+		raw_spin_lock_init(&base->lock);
+		for (i = 0; i < COARSE_NR_SLOTS; i++) {
+			slot = &base->slots[i];
+			hrtimer_init(&slot->timer, CLOCK_MONOTONIC,
+				     HRTIMER_MODE_ABS_PINNED_SOFT);
+			slot->timer.function = hrtimer_coarse_slot_expire;
+			INIT_HLIST_HEAD(&slot->timers);
+			slot->cpu_base = base;
+			hlist_add_head(&slot->node, &base->free);
+		}
+	}
+	return 0;
+}
+early_initcall(hrtimer_coarse_init_bases);
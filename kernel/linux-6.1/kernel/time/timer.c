@@ -41,6 +41,7 @@
 #include <linux/sched/sysctl.h>
 #include <linux/sched/nohz.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/isolation.h>
 #include <linux/slab.h>
 #include <linux/compat.h>
 #include <linux/random.h>
@@ -530,13 +531,26 @@ static inline unsigned calc_index(unsigned long expires, unsigned lvl,
 	return LVL_OFFS(lvl) + (expires & LVL_MASK);
 }
 
+/*
+ * Deferrable timers already accept running late while their CPU idles.
+ * Those which would land in level 0 with at least one level 1 granule
+ * to go are put into level 1 instead, where timers armed close together
+ * share a bucket and get expired in one go rather than one softirq pass
+ * per jiffy. That costs them up to LVL_GRAN(1) jiffies even on a busy
+ * CPU, but never more than their own timeout; shorter ones stay exact.
+ */
+static inline bool timer_batch_expiry(u32 tflags)
+{
+	return IS_ENABLED(CONFIG_NO_HZ_COMMON) && (tflags & TIMER_DEFERRABLE);
+}
+
 static int calc_wheel_index(unsigned long expires, unsigned long clk,
-			    unsigned long *bucket_expiry)
+			    unsigned long *bucket_expiry, bool batch)
 {
 	unsigned long delta = expires - clk;
 	unsigned int idx;
 
-	if (delta < LVL_START(1)) {
+	if (delta < LVL_START(1) && !(batch && delta >= LVL_GRAN(1))) {
 		idx = calc_index(expires, 0, bucket_expiry);
 	} else if (delta < LVL_START(2)) {
 		idx = calc_index(expires, 1, bucket_expiry);
@@ -630,7 +644,8 @@ static void internal_add_timer(struct timer_base *base, struct timer_list *timer
 	unsigned long bucket_expiry;
 	unsigned int idx;
 
-	idx = calc_wheel_index(timer->expires, base->clk, &bucket_expiry);
+	idx = calc_wheel_index(timer->expires, base->clk, &bucket_expiry,
+			       timer_batch_expiry(timer->flags));
 	enqueue_timer(base, timer, idx, bucket_expiry);
 }
 
@@ -931,13 +946,51 @@ static inline struct timer_base *get_timer_base(u32 tflags)
 	return get_timer_cpu_base(tflags, tflags & TIMER_CPUMASK);
 }
 
+#if defined(CONFIG_SMP) && defined(CONFIG_NO_HZ_COMMON)
+/*
+ * A pending timer which gets re-armed stays on its base as long as that
+ * CPU is a busy housekeeping CPU. Moving it costs a second base lock and
+ * buys nothing, and a timer re-armed from many CPUs would otherwise keep
+ * bouncing between their bases. ->is_idle is read without the lock of
+ * the BASE_STD base, so it is only a hint: a timer kept on a CPU which
+ * just went idle is caught by trigger_dyntick_cpu() on enqueue.
+ */
+static inline bool timer_base_keep(struct timer_base *base)
+{
+	struct timer_base *std = per_cpu_ptr(&timer_bases[BASE_STD], base->cpu);
+
+	return !READ_ONCE(std->is_idle) && cpu_online(base->cpu) &&
+	       housekeeping_cpu(base->cpu, HK_TYPE_TIMER);
+}
+
+/*
+ * Deferrable timers never wake an idle CPU, so handing them to a busy
+ * one only adds a remote enqueue. Keep them local unless this CPU is
+ * isolated from timer work, in which case a housekeeping CPU gets them.
+ */
+static inline int get_deferrable_timer_target(void)
+{
+	int cpu = smp_processor_id();
+
+	if (housekeeping_cpu(cpu, HK_TYPE_TIMER))
+		return cpu;
+	return housekeeping_any_cpu(HK_TYPE_TIMER);
+}
+#endif
+
 static inline struct timer_base *
-get_target_base(struct timer_base *base, unsigned tflags)
+get_target_base(struct timer_base *base, unsigned tflags, bool pending)
 {
 #if defined(CONFIG_SMP) && defined(CONFIG_NO_HZ_COMMON)
 	if (static_branch_likely(&timers_migration_enabled) &&
-	    !(tflags & TIMER_PINNED))
+	    !(tflags & TIMER_PINNED)) {
+		if (pending && timer_base_keep(base))
+			return base;
+		if (tflags & TIMER_DEFERRABLE)
+			return get_timer_cpu_base(tflags,
+						  get_deferrable_timer_target());
 		return get_timer_cpu_base(tflags, get_nohz_timer_target());
+	}
 #endif
 	return get_timer_this_cpu_base(tflags);
 }
@@ -1053,7 +1106,8 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 		}
 
 		clk = base->clk;
-		idx = calc_wheel_index(expires, clk, &bucket_expiry);
+		idx = calc_wheel_index(expires, clk, &bucket_expiry,
+				       timer_batch_expiry(timer->flags));
 
 		/*
 		 * Retrieve and compare the array index of the pending
@@ -1077,7 +1131,7 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 	if (!ret && (options & MOD_TIMER_PENDING_ONLY))
 		goto out_unlock;
 
-	new_base = get_target_base(base, timer->flags);
+	new_base = get_target_base(base, timer->flags, ret);
 
 	if (base != new_base) {
 		/*
@@ -14,12 +14,50 @@
 
 #include "trace.h"
 
+/*
+ * Default rethook nodes per CPU: two per probed function, up to this many.
+ * A node is held from the entry of a probed function until it returns, so
+ * the cap only matters when more than that many probed calls are pending
+ * on one CPU, and those count as missed.
+ */
+#define FPROBE_RETHOOK_MAX_PER_CPU	256
+
 struct fprobe_rethook_node {
 	struct rethook_node node;
 	unsigned long entry_ip;
 	char data[];
 };
 
+/**
+ * fprobe_site_of() - Find the site of a multi-site fprobe
+ * @fp: A fprobe registered with register_fprobe_sites().
+ * @ip: The ftrace location address that was hit.
+ *
+ * This is a plain binary search of the sorted site table, without any
+ * indirect calls, so it can be used from the entry and exit handlers.
+ *
+ * Return the site at @ip, or NULL.
+ */
+struct fprobe_site *fprobe_site_of(struct fprobe *fp, unsigned long ip)
+{
+	int lo = 0, hi = fp->nr_sites;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		struct fprobe_site *site = &fp->sites[mid];
+
+		if (site->ip == ip)
+			return site;
+		if (site->ip < ip)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(fprobe_site_of);
+NOKPROBE_SYMBOL(fprobe_site_of);
+
 static void fprobe_handler(unsigned long ip, unsigned long parent_ip,
 			   struct ftrace_ops *ops, struct ftrace_regs *fregs)
 {
@@ -51,8 +89,16 @@ static void fprobe_handler(unsigned long ip, unsigned long parent_ip,
 			entry_data = fpr->data;
 	}
 
-	if (fp->entry_handler)
+	if (fp->sites) {
+		struct fprobe_site *site = fprobe_site_of(fp, ip);
+
+		if (site && site->handler)
+			site->handler(fp, site, ftrace_get_regs(fregs), entry_data);
+		else if (fp->entry_handler)
+			fp->entry_handler(fp, ip, ftrace_get_regs(fregs), entry_data);
+	} else if (fp->entry_handler) {
 		fp->entry_handler(fp, ip, ftrace_get_regs(fregs), entry_data);
+	}
 
 	if (rh)
 		rethook_hook(rh, ftrace_get_regs(fregs), true);
@@ -123,6 +169,8 @@ static unsigned long *get_ftrace_locations(const char **syms, int num)
 static void fprobe_init(struct fprobe *fp)
 {
 	fp->nmissed = 0;
+	fp->sites = NULL;
+	fp->nr_sites = 0;
 	if (fprobe_shared_with_kprobes(fp))
 		fp->ops.func = fprobe_kprobe_handler;
 	else
@@ -146,7 +194,7 @@ static int fprobe_init_rethook(struct fprobe *fp, int num)
 	if (fp->nr_maxactive)
 		size = fp->nr_maxactive;
 	else
-		size = num * num_possible_cpus() * 2;
+		size = min(num * 2, FPROBE_RETHOOK_MAX_PER_CPU) * num_possible_cpus();
 	if (size <= 0)
 		return -EINVAL;
 
@@ -175,6 +223,8 @@ static void fprobe_fail_cleanup(struct fprobe *fp)
 		fp->rethook = NULL;
 	}
 	ftrace_free_filter(&fp->ops);
+	fp->sites = NULL;
+	fp->nr_sites = 0;
 }
 
 /**
@@ -301,6 +351,76 @@ int register_fprobe_syms(struct fprobe *fp, const char **syms, int num)
 }
 EXPORT_SYMBOL_GPL(register_fprobe_syms);
 
+static int fprobe_site_cmp(const void *a, const void *b)
+{
+	const struct fprobe_site *site_a = a, *site_b = b;
+
+	if (site_a->ip < site_b->ip)
+		return -1;
+	return site_a->ip > site_b->ip;
+}
+
+/**
+ * register_fprobe_sites() - Register fprobe to ftrace by per-site handlers.
+ * @fp: A fprobe data structure to be registered.
+ * @sites: An array of probe points, see struct fprobe_site.
+ * @num: The number of entries of @sites.
+ *
+ * Register @fp on all the addresses of @sites at once: the filter of its
+ * single ftrace_ops is set in one update, so every site shares the same
+ * trampoline, and one code patching pass enables them all. On a hit, the
+ * site is looked up in @sites and its handler called, or
+ * @fp->entry_handler for sites without one. @sites is sorted here and must
+ * be kept, unchanged, until unregister_fprobe() returns. Its addresses
+ * must be ftrace location addresses, as for register_fprobe_ips(), and
+ * must be unique.
+ *
+ * Return 0 if @fp is registered successfully, -errno if not.
+ */
+int register_fprobe_sites(struct fprobe *fp, struct fprobe_site *sites, int num)
+{
+	unsigned long *addrs;
+	int i, ret;
+
+	if (!fp || !sites || num <= 0)
+		return -EINVAL;
+
+	sort(sites, num, sizeof(*sites), fprobe_site_cmp, NULL);
+
+	addrs = kcalloc(num, sizeof(*addrs), GFP_KERNEL);
+	if (!addrs)
+		return -ENOMEM;
+
+	for (i = 0; i < num; i++) {
+		if (i && sites[i].ip == sites[i - 1].ip) {
+			kfree(addrs);
+			return -EEXIST;
+		}
+		addrs[i] = sites[i].ip;
+	}
+
+	fprobe_init(fp);
+	fp->sites = sites;
+	fp->nr_sites = num;
+
+	ret = ftrace_set_filter_ips(&fp->ops, addrs, num, 0, 0);
+	kfree(addrs);
+	if (ret) {
+		fp->sites = NULL;
+		fp->nr_sites = 0;
+		return ret;
+	}
+
+	ret = fprobe_init_rethook(fp, num);
+	if (!ret)
+		ret = register_ftrace_function(&fp->ops);
+
+	if (ret)
+		fprobe_fail_cleanup(fp);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(register_fprobe_sites);
+
 /**
  * unregister_fprobe() - Unregister fprobe from ftrace
  * @fp: A fprobe data structure to be unregistered.
@@ -328,6 +448,8 @@ int unregister_fprobe(struct fprobe *fp)
 		rethook_free(fp->rethook);
 
 	ftrace_free_filter(&fp->ops);
+	fp->sites = NULL;
+	fp->nr_sites = 0;
 
 	return ret;
 }
@@ -313,6 +313,8 @@ struct trace_array {
 	 */
 	struct array_buffer	max_buffer;
 	bool			allocated_snapshot;
+	/* mmapped trace_pipe_raw files, no swap while set, under max_lock */
+	unsigned int		mapped;
 #endif
 #ifdef CONFIG_TRACER_MAX_TRACE
 	unsigned long		max_latency;
@@ -266,6 +266,76 @@ static inline void osn_var_reset(void)
 	}
 }
 
+/*
+ * Per-cpu histograms of the noise sources and of the timer latency.
+ *
+ * Every noise and latency value the tracers measure is also counted in a
+ * log-scale histogram of its CPU: bucket 0 counts values below 1 us, and
+ * bucket N values in [2^(N-1), 2^N) us, the last one everything above.
+ * Counting is a per-cpu increment, so it is cheap enough to be always on,
+ * and with osnoise/continuous set the histograms, read from osnoise/hist,
+ * are the only output.
+ */
+enum osnoise_hist_type {
+	OSN_HIST_HW,
+	OSN_HIST_NMI,
+	OSN_HIST_IRQ,
+	OSN_HIST_SOFTIRQ,
+	OSN_HIST_THREAD,
+	OSN_HIST_TIMERLAT_IRQ,
+	OSN_HIST_TIMERLAT_THREAD,
+	OSN_HIST_MAX
+};
+
+static const char * const osnoise_hist_names[OSN_HIST_MAX] = {
+	[OSN_HIST_HW]			= "hw",
+	[OSN_HIST_NMI]			= "nmi",
+	[OSN_HIST_IRQ]			= "irq",
+	[OSN_HIST_SOFTIRQ]		= "softirq",
+	[OSN_HIST_THREAD]		= "thread",
+	[OSN_HIST_TIMERLAT_IRQ]		= "timerlat_irq",
+	[OSN_HIST_TIMERLAT_THREAD]	= "timerlat_thread",
+};
+
+#define OSN_HIST_BUCKETS	32
+
+struct osnoise_hist {
+	u64	count[OSN_HIST_MAX][OSN_HIST_BUCKETS];
+	u64	max[OSN_HIST_MAX];		/* in ns */
+};
+
+static DEFINE_PER_CPU(struct osnoise_hist, per_cpu_osnoise_hist);
+
+/*
+ * osnoise_hist_add - Count a value of @duration ns in this CPU's histogram
+ *
+ * Can be called from any context, NMIs included. A racing NMI can lose an
+ * update of max, which is fine for statistics.
+ */
+static inline void osnoise_hist_add(enum osnoise_hist_type type, s64 duration)
+{
+	struct osnoise_hist *hist = this_cpu_ptr(&per_cpu_osnoise_hist);
+	int bucket;
+
+	if (duration < 0)
+		return;
+
+	bucket = min(fls64(div_u64(duration, NSEC_PER_USEC)), OSN_HIST_BUCKETS - 1);
+	this_cpu_inc(per_cpu_osnoise_hist.count[type][bucket]);
+
+	if (duration > hist->max[type])
+		hist->max[type] = duration;
+}
+
+static void osnoise_hist_reset(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(&per_cpu_osnoise_hist, cpu), 0,
+		       sizeof(struct osnoise_hist));
+}
+
 /*
  * osn_var_reset_all - Reset the value of all per-cpu osnoise_variables
  */
@@ -273,6 +343,7 @@ static inline void osn_var_reset_all(void)
 {
 	osn_var_reset();
 	tlat_var_reset();
+	osnoise_hist_reset();
 }
 
 /*
@@ -320,6 +391,7 @@ static struct osnoise_data {
 	u64	sample_runtime;		/* active sampling portion of period */
 	u64	stop_tracing;		/* stop trace in the internal operation (loop/irq) */
 	u64	stop_tracing_total;	/* stop trace in the final operation (report/thread) */
+	u64	continuous;		/* histograms only, no samples in the trace */
 #ifdef CONFIG_TIMERLAT_TRACER
 	u64	timerlat_period;	/* timerlat period */
 	u64	print_stack;		/* print IRQ stack if total > */
@@ -331,6 +403,7 @@ static struct osnoise_data {
 	.sample_runtime			= DEFAULT_SAMPLE_RUNTIME,
 	.stop_tracing			= 0,
 	.stop_tracing_total		= 0,
+	.continuous			= 0,
 #ifdef CONFIG_TIMERLAT_TRACER
 	.print_stack			= 0,
 	.timerlat_period		= DEFAULT_TIMERLAT_PERIOD,
@@ -499,6 +572,9 @@ static void trace_osnoise_sample(struct osnoise_sample *sample)
 	struct osnoise_instance *inst;
 	struct trace_buffer *buffer;
 
+	if (osnoise_data.continuous)
+		return;
+
 	rcu_read_lock();
 	list_for_each_entry_rcu(inst, &osnoise_instances, list) {
 		buffer = inst->tr->array_buffer.buffer;
@@ -573,6 +649,12 @@ static void trace_timerlat_sample(struct timerlat_sample *sample)
 	struct osnoise_instance *inst;
 	struct trace_buffer *buffer;
 
+	osnoise_hist_add(sample->context == IRQ_CONTEXT ? OSN_HIST_TIMERLAT_IRQ :
+			 OSN_HIST_TIMERLAT_THREAD, sample->timer_latency);
+
+	if (osnoise_data.continuous)
+		return;
+
 	rcu_read_lock();
 	list_for_each_entry_rcu(inst, &osnoise_instances, list) {
 		buffer = inst->tr->array_buffer.buffer;
@@ -870,6 +952,7 @@ void trace_osnoise_callback(bool enter)
 			duration = time_get() - osn_var->nmi.delta_start;
 
 			trace_nmi_noise(osn_var->nmi.delta_start, duration);
+			osnoise_hist_add(OSN_HIST_NMI, duration);
 
 			cond_move_irq_delta_start(osn_var, duration);
 			cond_move_softirq_delta_start(osn_var, duration);
@@ -923,6 +1006,7 @@ void osnoise_trace_irq_exit(int id, const char *desc)
 
 	duration = get_int_safe_duration(osn_var, &osn_var->irq.delta_start);
 	trace_irq_noise(id, desc, osn_var->irq.arrival_time, duration);
+	osnoise_hist_add(OSN_HIST_IRQ, duration);
 	osn_var->irq.arrival_time = 0;
 	cond_move_softirq_delta_start(osn_var, duration);
 	cond_move_thread_delta_start(osn_var, duration);
@@ -1058,6 +1142,7 @@ static void trace_softirq_exit_callback(void *data, unsigned int vec_nr)
 
 	duration = get_int_safe_duration(osn_var, &osn_var->softirq.delta_start);
 	trace_softirq_noise(vec_nr, osn_var->softirq.arrival_time, duration);
+	osnoise_hist_add(OSN_HIST_SOFTIRQ, duration);
 	cond_move_thread_delta_start(osn_var, duration);
 	osn_var->softirq.arrival_time = 0;
 }
@@ -1155,6 +1240,7 @@ thread_exit(struct osnoise_variables *osn_var, struct task_struct *t)
 	duration = get_int_safe_duration(osn_var, &osn_var->thread.delta_start);
 
 	trace_thread_noise(t, osn_var->thread.arrival_time, duration);
+	osnoise_hist_add(OSN_HIST_THREAD, duration);
 
 	osn_var->thread.arrival_time = 0;
 }
@@ -1375,8 +1461,10 @@ static int run_osnoise(void)
 			if (noise > max_noise)
 				max_noise = noise;
 
-			if (!interference)
+			if (!interference) {
 				hw_count++;
+				osnoise_hist_add(OSN_HIST_HW, noise);
+			}
 
 			sum_noise += noise;
 
@@ -2040,6 +2128,17 @@ static struct trace_min_max_param timerlat_period = {
 };
 #endif
 
+/*
+ * osnoise/continuous: 0 or 1.
+ */
+static u64 osnoise_continuous_max = 1;
+static struct trace_min_max_param osnoise_continuous = {
+	.lock	= &interface_lock,
+	.val	= &osnoise_data.continuous,
+	.max	= &osnoise_continuous_max,
+	.min	= NULL,
+};
+
 static const struct file_operations cpus_fops = {
 	.open		= tracing_open_generic,
 	.read		= osnoise_cpus_read,
@@ -2047,6 +2146,65 @@ static const struct file_operations cpus_fops = {
 	.llseek		= generic_file_llseek,
 };
 
+/*
+ * osnoise/hist: one line per CPU and noise source with samples, see
+ * struct osnoise_hist. Writing anything clears the histograms.
+ */
+static int osnoise_hist_show(struct seq_file *m, void *v)
+{
+	struct osnoise_hist *hist;
+	int cpu, type, b;
+
+	seq_puts(m, "# bucket 0: < 1 us, bucket N: [2^(N-1), 2^N) us\n");
+	seq_puts(m, "# cpu type            max_us buckets\n");
+
+	for_each_online_cpu(cpu) {
+		hist = per_cpu_ptr(&per_cpu_osnoise_hist, cpu);
+
+		for (type = 0; type < OSN_HIST_MAX; type++) {
+			if (!hist->max[type] && !hist->count[type][0])
+				continue;
+
+			seq_printf(m, "%5d %-15s %6llu", cpu, osnoise_hist_names[type],
+				   div_u64(hist->max[type], NSEC_PER_USEC));
+			for (b = 0; b < OSN_HIST_BUCKETS; b++)
+				seq_printf(m, " %llu", hist->count[type][b]);
+			seq_putc(m, '\n');
+		}
+	}
+
+	return 0;
+}
+
+static int osnoise_hist_open(struct inode *inode, struct file *file)
+{
+	int ret;
+
+	ret = tracing_check_open_get_tr(NULL);
+	if (ret)
+		return ret;
+
+	return single_open(file, osnoise_hist_show, NULL);
+}
+
+static ssize_t osnoise_hist_write(struct file *filp, const char __user *ubuf,
+				  size_t count, loff_t *ppos)
+{
+	mutex_lock(&interface_lock);
+	osnoise_hist_reset();
+	mutex_unlock(&interface_lock);
+
+	return count;
+}
+
+static const struct file_operations hist_fops = {
+	.open		= osnoise_hist_open,
+	.read		= seq_read,
+	.write		= osnoise_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 #ifdef CONFIG_TIMERLAT_TRACER
 #ifdef CONFIG_STACKTRACE
 static int init_timerlat_stack_tracefs(struct dentry *top_dir)
@@ -2133,6 +2291,15 @@ static int init_tracefs(void)
 	if (!tmp)
 		goto err;
 
+	tmp = tracefs_create_file("continuous", TRACE_MODE_WRITE, top_dir,
+				  &osnoise_continuous, &trace_min_max_fops);
+	if (!tmp)
+		goto err;
+
+	tmp = trace_create_file("hist", TRACE_MODE_WRITE, top_dir, NULL, &hist_fops);
+	if (!tmp)
+		goto err;
+
 	ret = init_timerlat_tracefs(top_dir);
 	if (ret)
 		goto err;
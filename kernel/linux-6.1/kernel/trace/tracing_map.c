@@ -459,6 +459,12 @@ static struct tracing_map_elt *get_free_elt(struct tracing_map *map)
 		elt = *(TRACING_MAP_ELT(map->elts, idx));
 		if (map->ops && map->ops->elt_init)
 			map->ops->elt_init(elt);
+
+		/* Exactly one inserter gets this index */
+		if (idx == map->max_elts / 4 * 3 &&
+		    map->level + 1 < TRACING_MAP_LEVELS_MAX &&
+		    !READ_ONCE(map->next))
+			irq_work_queue(&map->grow_irq_work);
 	}
 
 	return elt;
@@ -512,17 +518,16 @@ static inline bool keys_match(void *key, void *test_key, unsigned key_size)
 	return match;
 }
 
+/* Insertion into, or lookup in, one map of the chain */
 static inline struct tracing_map_elt *
-__tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
+tracing_map_insert_level(struct tracing_map *map, void *key, u32 key_hash,
+			 bool lookup_only)
 {
-	u32 idx, key_hash, test_key;
+	u32 idx, test_key;
 	int dup_try = 0;
 	struct tracing_map_entry *entry;
 	struct tracing_map_elt *val;
 
-	key_hash = jhash(key, map->key_size, 0);
-	if (key_hash == 0)
-		key_hash = 1;
 	idx = key_hash >> (32 - (map->map_bits + 1));
 
 	while (1) {
@@ -534,8 +539,6 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 			val = READ_ONCE(entry->val);
 			if (val &&
 			    keys_match(key, val->key, map->key_size)) {
-				if (!lookup_only)
-					atomic64_inc(&map->hits);
 				return val;
 			} else if (unlikely(!val)) {
 				/*
@@ -551,10 +554,8 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 				 */
 
 				dup_try++;
-				if (dup_try > map->map_size) {
-					atomic64_inc(&map->drops);
+				if (dup_try > map->map_size)
 					break;
-				}
 				continue;
 			}
 		}
@@ -568,7 +569,6 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 
 				elt = get_free_elt(map);
 				if (!elt) {
-					atomic64_inc(&map->drops);
 					entry->key = 0;
 					break;
 				}
@@ -580,7 +580,6 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 				 */
 				smp_wmb();
 				WRITE_ONCE(entry->val, elt);
-				atomic64_inc(&map->hits);
 
 				return entry->val;
 			} else {
@@ -599,6 +598,41 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 	return NULL;
 }
 
+static inline struct tracing_map_elt *
+__tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
+{
+	struct tracing_map_elt *val;
+	struct tracing_map *level;
+	u32 key_hash;
+
+	key_hash = jhash(key, map->key_size, 0);
+	if (key_hash == 0)
+		key_hash = 1;
+
+	/* An overflow map only gets keys the maps before it had no room for */
+	for (level = map; level; level = smp_load_acquire(&level->next)) {
+		val = tracing_map_insert_level(level, key, key_hash, true);
+		if (val)
+			goto hit;
+	}
+
+	if (lookup_only)
+		return NULL;
+
+	for (level = map; level; level = smp_load_acquire(&level->next)) {
+		val = tracing_map_insert_level(level, key, key_hash, false);
+		if (val)
+			goto hit;
+	}
+
+	atomic64_inc(&map->drops);
+	return NULL;
+ hit:
+	if (!lookup_only)
+		atomic64_inc(&map->hits);
+	return val;
+}
+
 /**
  * tracing_map_insert - Insert key and/or retrieve val from a tracing_map
  * @map: The tracing_map to insert into
@@ -613,8 +647,10 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
  * tracing_map_elts was created by tracing_map_init().  This is the
  * pre-allocated pool of tracing_map_elts that tracing_map_insert()
  * will allocate from when adding new keys.  Once that pool is
- * exhausted, tracing_map_insert() is useless and will return NULL to
- * signal that state.  There are two user-visible tracing_map
+ * exhausted, new keys go to an overflow map chained behind it, see
+ * tracing_map.h; once the last one is exhausted too,
+ * tracing_map_insert() returns NULL for new keys.  There are two
+ * user-visible tracing_map
  * variables, 'hits' and 'drops', which are updated by this function.
  * Every time an element is either successfully inserted or retrieved,
  * the 'hits' value is incremented.  Every time an element insertion
@@ -678,6 +714,10 @@ void tracing_map_destroy(struct tracing_map *map)
 	if (!map)
 		return;
 
+	irq_work_sync(&map->grow_irq_work);
+	cancel_work_sync(&map->grow_work);
+	tracing_map_destroy(map->next);
+
 	tracing_map_free_elts(map);
 
 	tracing_map_array_free(map->map);
@@ -699,20 +739,68 @@ void tracing_map_clear(struct tracing_map *map)
 {
 	unsigned int i;
 
-	atomic_set(&map->next_elt, 0);
-	atomic64_set(&map->hits, 0);
-	atomic64_set(&map->drops, 0);
+	/* Overflow maps stay allocated, they are likely to be needed again */
+	for (; map; map = map->next) {
+		atomic_set(&map->next_elt, 0);
+		atomic64_set(&map->hits, 0);
+		atomic64_set(&map->drops, 0);
 
-	tracing_map_array_clear(map->map);
+		tracing_map_array_clear(map->map);
 
-	for (i = 0; i < map->max_elts; i++)
-		tracing_map_elt_clear(*(TRACING_MAP_ELT(map->elts, i)));
+		for (i = 0; i < map->max_elts; i++)
+			tracing_map_elt_clear(*(TRACING_MAP_ELT(map->elts, i)));
+	}
 }
 
+/* The comparison functions find the sort key through elt->map */
 static void set_sort_key(struct tracing_map *map,
 			 struct tracing_map_sort_key *sort_key)
 {
-	map->sort_key = *sort_key;
+	for (; map; map = map->next)
+		map->sort_key = *sort_key;
+}
+
+static void tracing_map_grow_irq_work(struct irq_work *work)
+{
+	struct tracing_map *map = container_of(work, struct tracing_map,
+					       grow_irq_work);
+
+	schedule_work(&map->grow_work);
+}
+
+/*
+ * Create the overflow map of @map, see tracing_map.h.  The insertion
+ * path only ever sees it fully set up.
+ */
+static void tracing_map_grow(struct work_struct *work)
+{
+	struct tracing_map *map = container_of(work, struct tracing_map,
+					       grow_work);
+	struct tracing_map *next;
+
+	if (map->next)
+		return;
+
+	next = tracing_map_create(min_t(unsigned int, map->map_bits + 1,
+						 TRACING_MAP_BITS_MAX),
+				  map->key_size, map->ops, map->private_data);
+	if (IS_ERR(next))
+		return;
+
+	next->level = map->level + 1;
+	memcpy(next->fields, map->fields, sizeof(map->fields));
+	next->n_fields = map->n_fields;
+	memcpy(next->key_idx, map->key_idx, sizeof(map->key_idx));
+	next->n_keys = map->n_keys;
+	next->n_vars = map->n_vars;
+	next->sort_key = map->sort_key;
+
+	if (tracing_map_init(next)) {
+		tracing_map_destroy(next);
+		return;
+	}
+
+	smp_store_release(&map->next, next);
 }
 
 /**
@@ -787,6 +875,8 @@ struct tracing_map *tracing_map_create(unsigned int map_bits,
 
 	map->map_size = (1 << (map_bits + 1));
 	map->ops = ops;
+	init_irq_work(&map->grow_irq_work, tracing_map_grow_irq_work);
+	INIT_WORK(&map->grow_work, tracing_map_grow);
 
 	map->private_data = private_data;
 
@@ -1078,25 +1168,37 @@ int tracing_map_sort_entries(struct tracing_map *map,
 {
 	int (*cmp_entries_fn)(const void *, const void *);
 	struct tracing_map_sort_entry *sort_entry, **entries;
+	unsigned int max_elts = 0;
+	struct tracing_map *level;
 	int i, n_entries, ret;
 
-	entries = vmalloc(array_size(sizeof(sort_entry), map->max_elts));
+	for (level = map; level; level = smp_load_acquire(&level->next))
+		max_elts += level->max_elts;
+
+	entries = vmalloc(array_size(sizeof(sort_entry), max_elts));
 	if (!entries)
 		return -ENOMEM;
 
-	for (i = 0, n_entries = 0; i < map->map_size; i++) {
-		struct tracing_map_entry *entry;
+	n_entries = 0;
+	for (level = map; level; level = smp_load_acquire(&level->next)) {
+		for (i = 0; i < level->map_size; i++) {
+			struct tracing_map_entry *entry;
 
-		entry = TRACING_MAP_ENTRY(map->map, i);
+			entry = TRACING_MAP_ENTRY(level->map, i);
 
-		if (!entry->key || !entry->val)
-			continue;
+			if (!entry->key || !entry->val)
+				continue;
 
-		entries[n_entries] = create_sort_entry(entry->val->key,
-						       entry->val);
-		if (!entries[n_entries++]) {
-			ret = -ENOMEM;
-			goto free;
+			/* An overflow map created after the count above */
+			if (n_entries == max_elts)
+				break;
+
+			entries[n_entries] = create_sort_entry(entry->val->key,
+							       entry->val);
+			if (!entries[n_entries++]) {
+				ret = -ENOMEM;
+				goto free;
+			}
 		}
 	}
 
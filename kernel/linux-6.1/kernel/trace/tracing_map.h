@@ -2,9 +2,14 @@
 #ifndef __TRACING_MAP_H
 #define __TRACING_MAP_H
 
+#include <linux/irq_work.h>
+#include <linux/workqueue.h>
+
 #define TRACING_MAP_BITS_DEFAULT	11
 #define TRACING_MAP_BITS_MAX		17
 #define TRACING_MAP_BITS_MIN		7
+/* the map and up to this many overflow maps chained behind it */
+#define TRACING_MAP_LEVELS_MAX		4
 
 #define TRACING_MAP_KEYS_MAX		3
 #define TRACING_MAP_VALS_MAX		3
@@ -125,6 +130,17 @@ typedef int (*tracing_map_cmp_fn_t) (void *val_a, void *val_b);
  * user, tracing_map_sort_entry objects contain a number of additional
  * fields which are used for caching and internal purposes and can
  * safely be ignored.
+ *
+ * A tracing_map does not drop new keys once its pool runs out.  When
+ * three quarters of the pool is in use, an irq_work (insertion can
+ * happen in NMI) kicks a work item that creates an overflow map with
+ * the same fields and twice the size, and publishes it in the next field
+ * of the full one.  That is repeated up to TRACING_MAP_LEVELS_MAX maps
+ * in total.  tracing_map_insert() looks a key up in every map of the
+ * chain before inserting it into the first one with a free element, so
+ * a key lives in exactly one map, and everything that reads the map
+ * (sorting, clearing, destroying) walks the whole chain.  The hits and
+ * drops counters are only kept in the first map.
 */
 
 struct tracing_map_field {
@@ -198,6 +214,10 @@ struct tracing_map {
 	unsigned int			n_vars;
 	atomic64_t			hits;
 	atomic64_t			drops;
+	unsigned int			level;
+	struct tracing_map		*next;
+	struct irq_work			grow_irq_work;
+	struct work_struct		grow_work;
 };
 
 /**
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Multi-buffer SHA-256: hash independent messages of the same length
+ * together.
+ *
+ * The generic version hashes the messages one after the other; an
+ * architecture that selects CRYPTO_ARCH_HAVE_LIB_SHA256_MB provides
+ * sha256_mb_arch(), which runs several of them in the lanes of its SIMD
+ * registers and leaves whatever it does not handle to the loop below.
+ */
+
+#include <linux/export.h>
+#include <linux/module.h>
+#include <crypto/sha2.h>
+
+/**
+ * sha256_mb() - compute the SHA-256 digests of several messages
+ * @data: the @nr messages
+ * @len: length of every message in bytes
+ * @out: @nr buffers of SHA256_DIGEST_SIZE bytes for the digests
+ * @nr: number of messages
+ *
+ * Produces the same digests as calling sha256() on each message, at a
+ * higher aggregate rate on architectures with a multi-buffer
+ * implementation. Callers hashing many small buffers, such as the blocks
+ * of a Merkle tree, should batch them through this.
+ */
+void sha256_mb(const u8 *const data[], unsigned int len, u8 *const out[],
+	       unsigned int nr)
+{
+	unsigned int i = 0;
+
+	if (IS_ENABLED(CONFIG_CRYPTO_ARCH_HAVE_LIB_SHA256_MB))
+		i = sha256_mb_arch(data, len, out, nr);
+
+	for (; i < nr; i++)
+		sha256(data[i], len, out[i]);
+}
+EXPORT_SYMBOL(sha256_mb);
@@ -317,9 +317,11 @@ static size_t copy_page_to_iter_pipe(struct page *page, size_t offset, size_t by
 	if (!sanity(i))
 		return 0;
 
-	if (offset && i->last_offset == -offset) { // could we merge it?
+	if (i->last_offset < 0) { // could we merge it?
 		struct pipe_buffer *buf = pipe_buf(pipe, head - 1);
-		if (buf->page == page) {
+		// any page of the same folio, as long as it follows on
+		if (page_span_contiguous(buf->page, buf->offset, buf->len,
+					 page, offset)) {
 			buf->len += bytes;
 			i->last_offset -= bytes;
 			i->count -= bytes;
@@ -1848,13 +1850,31 @@ int import_single_range(int rw, void __user *buf, size_t len,
 	if (unlikely(!access_ok(buf, len)))
 		return -EFAULT;
 
+	/*
+	 * The iovec is no longer referenced by the iterator, but is still
+	 * filled in for callers that look at it.  A single range is set up
+	 * as ITER_UBUF so that copies take the one-segment path instead of
+	 * walking an iovec array.
+	 */
 	iov->iov_base = buf;
 	iov->iov_len = len;
-	iov_iter_init(i, rw, iov, 1, len);
+	iov_iter_ubuf(i, rw, buf, len);
 	return 0;
 }
 EXPORT_SYMBOL(import_single_range);
 
+int import_ubuf(int rw, void __user *buf, size_t len, struct iov_iter *i)
+{
+	if (len > MAX_RW_COUNT)
+		len = MAX_RW_COUNT;
+	if (unlikely(!access_ok(buf, len)))
+		return -EFAULT;
+
+	iov_iter_ubuf(i, rw, buf, len);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(import_ubuf);
+
 /**
  * iov_iter_restore() - Restore a &struct iov_iter to the same state as when
  *     iov_iter_save_state() was called.
@@ -54,6 +54,31 @@ u32 crc32c(u32 crc, const void *address, unsigned int length)
 
 EXPORT_SYMBOL(crc32c);
 
+/**
+ * crc32c_mb() - update the CRC32c of several buffers of the same length
+ * @crc: the @nr running CRCs, updated in place
+ * @data: the @nr buffers
+ * @length: length of every buffer in bytes
+ * @nr: number of buffers
+ *
+ * Equivalent to crc[i] = crc32c(crc[i], data[i], length) for each buffer.
+ * Architectures that select CRYPTO_ARCH_HAVE_LIB_CRC32C_MB overlap the
+ * independent CRCs, which is much faster than one at a time when the
+ * buffers are as small as filesystem blocks or network PDUs.
+ */
+void crc32c_mb(u32 crc[], const u8 *const data[], unsigned int length,
+	       unsigned int nr)
+{
+	unsigned int i = 0;
+
+	if (IS_ENABLED(CONFIG_CRYPTO_ARCH_HAVE_LIB_CRC32C_MB))
+		i = crc32c_mb_arch(crc, data, length, nr);
+
+	for (; i < nr; i++)
+		crc[i] = crc32c(crc[i], data[i], length);
+}
+EXPORT_SYMBOL(crc32c_mb);
+
 static int __init libcrc32c_mod_init(void)
 {
 	tfm = crypto_alloc_shash("crc32c", 0, 0);
@@ -4363,6 +4363,29 @@ static inline bool mas_wr_append(struct ma_wr_state *wr_mas)
 		return true;
 	}
 
+	/*
+	 * Storing inside the last range without touching either boundary, as
+	 * dup_mmap() does for every VMA after a gap.  Split the last range in
+	 * three instead of rewriting the node.
+	 */
+	new_end = end + 2;
+	if ((mas->index != wr_mas->r_min) && (mas->last < wr_mas->r_max) &&
+	    (new_end < mt_slots[wr_mas->type])) {
+		if (new_end < node_pivots)
+			wr_mas->pivots[new_end] = wr_mas->pivots[end];
+
+		if (new_end < node_pivots)
+			ma_set_meta(wr_mas->node, maple_leaf_64, 0, new_end);
+
+		rcu_assign_pointer(wr_mas->slots[new_end], wr_mas->content);
+		wr_mas->pivots[end + 1] = mas->last;
+		rcu_assign_pointer(wr_mas->slots[end + 1], wr_mas->entry);
+		wr_mas->pivots[end] = mas->index - 1;
+		mas->offset = end + 1;
+
+		return true;
+	}
+
 	return false;
 }
 
@@ -222,10 +222,10 @@ static struct bucket_table *rhashtable_last_table(struct rhashtable *ht,
 }
 
 static int rhashtable_rehash_one(struct rhashtable *ht,
+				 struct bucket_table *old_tbl,
 				 struct rhash_lock_head __rcu **bkt,
 				 unsigned int old_hash)
 {
-	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct bucket_table *new_tbl = rhashtable_last_table(ht, old_tbl);
 	int err = -EAGAIN;
 	struct rhash_head *head, *next, *entry;
@@ -272,9 +272,9 @@ out:
 }
 
 static int rhashtable_rehash_chain(struct rhashtable *ht,
-				    unsigned int old_hash)
+				   struct bucket_table *old_tbl,
+				   unsigned int old_hash)
 {
-	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct rhash_lock_head __rcu **bkt = rht_bucket_var(old_tbl, old_hash);
 	int err;
 
@@ -282,7 +282,7 @@ static int rhashtable_rehash_chain(struct rhashtable *ht,
 		return 0;
 	rht_lock(old_tbl, bkt);
 
-	while (!(err = rhashtable_rehash_one(ht, bkt, old_hash)))
+	while (!(err = rhashtable_rehash_one(ht, old_tbl, bkt, old_hash)))
 		;
 
 	if (err == -ENOENT)
@@ -292,6 +292,46 @@ static int rhashtable_rehash_chain(struct rhashtable *ht,
 	return err;
 }
 
+/*
+ * Buckets of a table being rehashed are claimed in order by the worker and
+ * by inserters helping it, so that they do not migrate the same chains.
+ */
+static bool rhashtable_rehash_claim(struct bucket_table *old_tbl,
+				    unsigned int *old_hash)
+{
+	/* Keep the counter from wrapping once everything is claimed */
+	if (atomic_read(&old_tbl->rehash) >= old_tbl->size)
+		return false;
+
+	*old_hash = atomic_inc_return(&old_tbl->rehash) - 1;
+	return *old_hash < old_tbl->size;
+}
+
+/*
+ * Called by inserters, under RCU, while @old_tbl is being rehashed: migrate
+ * a bounded number of chains so that the migration advances with the
+ * insert rate instead of waiting for the worker. Nothing is published
+ * here; the worker still sweeps every bucket before switching tables, so
+ * a chain that is skipped or fails is picked up there.
+ */
+static void rhashtable_rehash_help(struct rhashtable *ht,
+				   struct bucket_table *old_tbl)
+{
+	struct bucket_table *new_tbl;
+	unsigned int old_hash;
+	unsigned int n;
+
+	new_tbl = rht_dereference_rcu(old_tbl->future_tbl, ht);
+	if (!new_tbl || rhashtable_last_table(ht, new_tbl)->nest)
+		return;
+
+	for (n = 0; n < RHT_REHASH_HELP; n++) {
+		if (!rhashtable_rehash_claim(old_tbl, &old_hash) ||
+		    rhashtable_rehash_chain(ht, old_tbl, old_hash))
+			break;
+	}
+}
+
 static int rhashtable_rehash_attach(struct rhashtable *ht,
 				    struct bucket_table *old_tbl,
 				    struct bucket_table *new_tbl)
@@ -321,8 +361,21 @@ static int rhashtable_rehash_table(struct rhashtable *ht)
 	if (!new_tbl)
 		return 0;
 
+	/* Share the buckets with inserters in rhashtable_rehash_help()... */
+	while (rhashtable_rehash_claim(old_tbl, &old_hash)) {
+		err = rhashtable_rehash_chain(ht, old_tbl, old_hash);
+		if (err)
+			return err;
+		cond_resched();
+	}
+
+	/*
+	 * ...then make sure every chain did move. Buckets emptied by an
+	 * inserter are only locked and unlocked here; one an inserter is
+	 * still moving is waited for on its bucket lock.
+	 */
 	for (old_hash = 0; old_hash < old_tbl->size; old_hash++) {
-		err = rhashtable_rehash_chain(ht, old_hash);
+		err = rhashtable_rehash_chain(ht, old_tbl, old_hash);
 		if (err)
 			return err;
 		cond_resched();
@@ -588,12 +641,14 @@ static void *rhashtable_try_insert(struct rhashtable *ht, const void *key,
 				   struct rhash_head *obj)
 {
 	struct bucket_table *new_tbl;
+	struct bucket_table *old_tbl;
 	struct bucket_table *tbl;
 	struct rhash_lock_head __rcu **bkt;
 	unsigned int hash;
 	void *data;
 
-	new_tbl = rcu_dereference(ht->tbl);
+	old_tbl = rcu_dereference(ht->tbl);
+	new_tbl = old_tbl;
 
 	do {
 		tbl = new_tbl;
@@ -622,6 +677,8 @@ static void *rhashtable_try_insert(struct rhashtable *ht, const void *key,
 	if (PTR_ERR(data) == -EAGAIN)
 		data = ERR_PTR(rhashtable_insert_rehash(ht, tbl) ?:
 			       -EAGAIN);
+	else if (rcu_access_pointer(old_tbl->future_tbl))
+		rhashtable_rehash_help(ht, old_tbl);
 
 	return data;
 }
@@ -9,6 +9,31 @@
 #include <linux/sbitmap.h>
 #include <linux/seq_file.h>
 
+/*
+ * Pick a random starting bit for @cpu within the words that belong to its
+ * NUMA node.  The map is split into one run of whole words per node, so CPUs
+ * of a node start their searches in the same words and only move on to other
+ * nodes' words when theirs are busy.  That keeps the word cache lines, which
+ * every get and clear writes, mostly within one socket.
+ */
+static unsigned int sbitmap_node_hint(const struct sbitmap *sb,
+				      unsigned int depth, int cpu)
+{
+	unsigned int words = DIV_ROUND_UP(depth, 1U << sb->shift);
+	unsigned int per_node = words / nr_node_ids;
+	int node = cpu_to_node(cpu);
+	unsigned int start, len;
+
+	if (!depth)
+		return 0;
+	if (!per_node || node == NUMA_NO_NODE)
+		return prandom_u32_max(depth);
+
+	start = (node * per_node) << sb->shift;
+	len = min(per_node << sb->shift, depth - start);
+	return start + prandom_u32_max(len);
+}
+
 static int init_alloc_hint(struct sbitmap *sb, gfp_t flags)
 {
 	unsigned depth = sb->depth;
@@ -21,7 +46,8 @@ static int init_alloc_hint(struct sbitmap *sb, gfp_t flags)
 		int i;
 
 		for_each_possible_cpu(i)
-			*per_cpu_ptr(sb->alloc_hint, i) = prandom_u32_max(depth);
+			*per_cpu_ptr(sb->alloc_hint, i) =
+				sbitmap_node_hint(sb, depth, i);
 	}
 	return 0;
 }
@@ -33,7 +59,7 @@ static inline unsigned update_alloc_hint_before_get(struct sbitmap *sb,
 
 	hint = this_cpu_read(*sb->alloc_hint);
 	if (unlikely(hint >= depth)) {
-		hint = depth ? prandom_u32_max(depth) : 0;
+		hint = sbitmap_node_hint(sb, depth, raw_smp_processor_id());
 		this_cpu_write(*sb->alloc_hint, hint);
 	}
 
@@ -533,10 +559,17 @@ unsigned long __sbitmap_queue_get_batch(struct sbitmap_queue *sbq, int nr_tags,
 			goto next;
 
 		nr = find_first_zero_bit(&val, map_depth);
-		if (nr + nr_tags <= map_depth) {
+		if (nr < map_depth) {
 			atomic_long_t *ptr = (atomic_long_t *) &map->word;
+			/*
+			 * Take what is left of the word if the whole batch does
+			 * not fit: the callers fall back to one atomic per tag
+			 * when this returns nothing.
+			 */
+			unsigned int nr_get = min_t(unsigned int, nr_tags,
+						    map_depth - nr);
 
-			get_mask = ((1UL << nr_tags) - 1) << nr;
+			get_mask = GENMASK(nr + nr_get - 1, nr);
 			while (!atomic_long_try_cmpxchg(ptr, &val,
 							  get_mask | val))
 				;
@@ -544,7 +577,7 @@ unsigned long __sbitmap_queue_get_batch(struct sbitmap_queue *sbq, int nr_tags,
 			if (get_mask) {
 				*offset = nr + (index << sb->shift);
 				update_alloc_hint_after_get(sb, depth, hint,
-							*offset + nr_tags - 1);
+							*offset + nr_get - 1);
 				return get_mask;
 			}
 		}
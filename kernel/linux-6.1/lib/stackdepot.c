@@ -77,8 +77,25 @@ static void *stack_slabs[STACK_ALLOC_MAX_SLABS];
 static int depot_index;
 static int next_slab_inited;
 static size_t depot_offset;
+/* Protects the slab storage: depot_index, depot_offset and stack_slabs */
 static DEFINE_RAW_SPINLOCK(depot_lock);
 
+/*
+ * Inserts into the hash table are serialized per group of buckets, so new
+ * stacks with different hashes only meet on depot_lock for the storage
+ * reservation.  Lookups take no lock at all.
+ */
+#define STACK_INSERT_LOCKS	64
+
+static union {
+	raw_spinlock_t lock;
+	char pad[L1_CACHE_BYTES];
+} stack_insert_locks[STACK_INSERT_LOCKS] __cacheline_aligned_in_smp = {
+	[0 ... (STACK_INSERT_LOCKS - 1)] = {
+		.lock = __RAW_SPIN_LOCK_UNLOCKED(stack_insert_locks.lock),
+	},
+};
+
 unsigned int stack_depot_get_extra_bits(depot_stack_handle_t handle)
 {
 	union handle_parts parts = { .handle = handle };
@@ -115,9 +132,11 @@ static bool init_stack_slab(void **prealloc)
 	return true;
 }
 
-/* Allocation of a new stack in raw storage */
-static struct stack_record *
-depot_alloc_stack(unsigned long *entries, int size, u32 hash, void **prealloc)
+/*
+ * Allocation of a new stack in raw storage.  Only reserves the space and sets
+ * the handle; the caller fills in the record before publishing it.
+ */
+static struct stack_record *depot_alloc_stack(int size, void **prealloc)
 {
 	struct stack_record *stack;
 	size_t required_size = struct_size(stack, entries, size);
@@ -145,13 +164,10 @@ depot_alloc_stack(unsigned long *entries, int size, u32 hash, void **prealloc)
 
 	stack = stack_slabs[depot_index] + depot_offset;
 
-	stack->hash = hash;
-	stack->size = size;
 	stack->handle.slabindex = depot_index;
 	stack->handle.offset = depot_offset >> STACK_ALLOC_ALIGN;
 	stack->handle.valid = 1;
 	stack->handle.extra = 0;
-	memcpy(stack->entries, entries, flex_array_size(stack, entries, size));
 	depot_offset += required_size;
 
 	return stack;
@@ -423,6 +439,7 @@ depot_stack_handle_t __stack_depot_save(unsigned long *entries,
 {
 	struct stack_record *found = NULL, **bucket;
 	union handle_parts retval = { .handle = 0 };
+	raw_spinlock_t *insert_lock;
 	struct page *page = NULL;
 	void *prealloc = NULL;
 	unsigned long flags;
@@ -476,13 +493,23 @@ depot_stack_handle_t __stack_depot_save(unsigned long *entries,
 			prealloc = page_address(page);
 	}
 
-	raw_spin_lock_irqsave(&depot_lock, flags);
+	/* STACK_INSERT_LOCKS divides the table size, so a bucket has one lock */
+	insert_lock = &stack_insert_locks[hash % STACK_INSERT_LOCKS].lock;
+	raw_spin_lock_irqsave(insert_lock, flags);
 
 	found = find_stack(*bucket, entries, nr_entries, hash);
 	if (!found) {
-		struct stack_record *new = depot_alloc_stack(entries, nr_entries, hash, &prealloc);
+		struct stack_record *new;
+
+		raw_spin_lock(&depot_lock);
+		new = depot_alloc_stack(nr_entries, &prealloc);
+		raw_spin_unlock(&depot_lock);
 
 		if (new) {
+			new->hash = hash;
+			new->size = nr_entries;
+			memcpy(new->entries, entries,
+			       flex_array_size(new, entries, nr_entries));
 			new->next = *bucket;
 			/*
 			 * This smp_store_release() pairs with
@@ -496,10 +523,12 @@ depot_stack_handle_t __stack_depot_save(unsigned long *entries,
 		 * We didn't need to store this stack trace, but let's keep
 		 * the preallocated memory for the future.
 		 */
+		raw_spin_lock(&depot_lock);
 		WARN_ON(!init_stack_slab(&prealloc));
+		raw_spin_unlock(&depot_lock);
 	}
 
-	raw_spin_unlock_irqrestore(&depot_lock, flags);
+	raw_spin_unlock_irqrestore(insert_lock, flags);
 exit:
 	if (prealloc) {
 		/* Nobody used this memory, ok to free it. */
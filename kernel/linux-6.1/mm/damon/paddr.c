@@ -7,6 +7,9 @@
 
 #define pr_fmt(fmt) "damon-pa: " fmt
 
+#include <linux/memcontrol.h>
+#include <linux/memory-tiers.h>
+#include <linux/migrate.h>
 #include <linux/mmu_notifier.h>
 #include <linux/page_idle.h>
 #include <linux/pagemap.h>
@@ -260,6 +263,71 @@ static unsigned long damon_pa_deactivate_pages(struct damon_region *r)
 	return damon_pa_mark_accessed_or_deactivate(r, false);
 }
 
+#ifdef CONFIG_MIGRATION
+/*
+ * Promote the lower tier pages of a hot region. The scheme's quota limits
+ * how fast this goes; each page's cgroup further has to have promotion
+ * quota left, see mem_cgroup_promote_charge(). Like NUMA balancing
+ * promotion, the allocation does not reclaim on the target node: if it
+ * is full, demotion has to make room first.
+ */
+static unsigned long damon_pa_promote(struct damon_region *r)
+{
+	struct migration_target_control mtc = {
+		.nid = NUMA_NO_NODE,
+		.gfp_mask = (GFP_HIGHUSER_MOVABLE & ~__GFP_RECLAIM) |
+			__GFP_THISNODE | __GFP_NOWARN | __GFP_NOMEMALLOC |
+			__GFP_NORETRY,
+	};
+	unsigned int nr_succeeded = 0;
+	unsigned long addr;
+	LIST_HEAD(page_list);
+	int nid;
+
+	for (addr = r->ar.start; addr < r->ar.end; addr += PAGE_SIZE) {
+		struct page *page = damon_get_page(PHYS_PFN(addr));
+
+		if (!page)
+			continue;
+
+		nid = page_to_nid(page);
+		if (mtc.nid == NUMA_NO_NODE)
+			mtc.nid = next_promotion_node(nid);
+		if (mtc.nid == NUMA_NO_NODE || node_is_toptier(nid) ||
+		    !mem_cgroup_promote_charge(page_folio(page)) ||
+		    isolate_lru_page(page)) {
+			put_page(page);
+			continue;
+		}
+		mod_node_page_state(page_pgdat(page),
+				    NR_ISOLATED_ANON + page_is_file_lru(page),
+				    thp_nr_pages(page));
+		list_add(&page->lru, &page_list);
+		put_page(page);
+	}
+
+	if (list_empty(&page_list))
+		return 0;
+
+	migrate_pages(&page_list, alloc_migration_target, NULL,
+		      (unsigned long)&mtc, MIGRATE_ASYNC, MR_NUMA_MISPLACED,
+		      &nr_succeeded);
+	if (!list_empty(&page_list))
+		putback_movable_pages(&page_list);
+#ifdef CONFIG_NUMA_BALANCING
+	mod_node_page_state(NODE_DATA(mtc.nid), PGPROMOTE_SUCCESS,
+			    nr_succeeded);
+#endif
+	cond_resched();
+	return nr_succeeded * PAGE_SIZE;
+}
+#else
+static unsigned long damon_pa_promote(struct damon_region *r)
+{
+	return 0;
+}
+#endif
+
 static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		struct damon_target *t, struct damon_region *r,
 		struct damos *scheme)
@@ -271,6 +339,8 @@ static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		return damon_pa_mark_accessed(r);
 	case DAMOS_LRU_DEPRIO:
 		return damon_pa_deactivate_pages(r);
+	case DAMOS_PROMOTE:
+		return damon_pa_promote(r);
 	case DAMOS_STAT:
 		break;
 	default:
@@ -291,6 +361,8 @@ static int damon_pa_scheme_score(struct damon_ctx *context,
 		return damon_hot_score(context, r, scheme);
 	case DAMOS_LRU_DEPRIO:
 		return damon_cold_score(context, r, scheme);
+	case DAMOS_PROMOTE:
+		return damon_hot_score(context, r, scheme);
 	default:
 		break;
 	}
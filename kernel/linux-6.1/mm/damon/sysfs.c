@@ -750,6 +750,8 @@ static const char * const damon_sysfs_damos_action_strs[] = {
 	"nohugepage",
 	"lru_prio",
 	"lru_deprio",
+	"zswap",
+	"promote",
 	"stat",
 };
 
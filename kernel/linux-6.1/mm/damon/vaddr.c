@@ -14,6 +14,8 @@
 #include <linux/page_idle.h>
 #include <linux/pagewalk.h>
 #include <linux/sched/mm.h>
+#include <linux/memcontrol.h>
+#include <linux/zswap.h>
 
 #include "ops-common.h"
 
@@ -614,6 +616,12 @@ static unsigned long damos_madvise(struct damon_target *target,
 {
 	return 0;
 }
+
+static unsigned long damos_va_zswap(struct damon_target *target,
+		struct damon_region *r)
+{
+	return 0;
+}
 #else
 static unsigned long damos_madvise(struct damon_target *target,
 		struct damon_region *r, int behavior)
@@ -632,6 +640,53 @@ static unsigned long damos_madvise(struct damon_target *target,
 
 	return applied;
 }
+
+/*
+ * Page out the anonymous mappings in the region for as long as zswap takes
+ * the pages of the target's cgroup, so that cold memory is compressed rather
+ * than written to the swap device.  File pages are left alone, paging them
+ * out would just drop or write them back.
+ */
+static unsigned long damos_va_zswap(struct damon_target *target,
+		struct damon_region *r)
+{
+	unsigned long start = PAGE_ALIGN(r->ar.start);
+	unsigned long end = start + PAGE_ALIGN(damon_sz_region(r));
+	unsigned long applied = 0;
+	struct vm_area_struct *vma;
+	struct mem_cgroup *memcg;
+	struct mm_struct *mm;
+
+	mm = damon_get_mm(target);
+	if (!mm)
+		return 0;
+
+	memcg = get_mem_cgroup_from_mm(mm);
+	while (start < end && zswap_can_store(memcg)) {
+		unsigned long vstart, vend;
+		bool anon;
+
+		mmap_read_lock(mm);
+		vma = find_vma(mm, start);
+		if (!vma || vma->vm_start >= end) {
+			mmap_read_unlock(mm);
+			break;
+		}
+		vstart = max(start, vma->vm_start);
+		vend = min(end, vma->vm_end);
+		anon = vma_is_anonymous(vma);
+		mmap_read_unlock(mm);
+
+		/* madvise() looks the range up again under its own lock */
+		if (anon && !do_madvise(mm, vstart, vend - vstart, MADV_PAGEOUT))
+			applied += vend - vstart;
+		start = vend;
+	}
+	mem_cgroup_put(memcg);
+	mmput(mm);
+
+	return applied;
+}
 #endif	/* CONFIG_ADVISE_SYSCALLS */
 
 static unsigned long damon_va_apply_scheme(struct damon_ctx *ctx,
@@ -656,6 +711,8 @@ static unsigned long damon_va_apply_scheme(struct damon_ctx *ctx,
 	case DAMOS_NOHUGEPAGE:
 		madv_action = MADV_NOHUGEPAGE;
 		break;
+	case DAMOS_ZSWAP:
+		return damos_va_zswap(t, r);
 	case DAMOS_STAT:
 		return 0;
 	default:
@@ -675,6 +732,7 @@ static int damon_va_scheme_score(struct damon_ctx *context,
 
 	switch (scheme->action) {
 	case DAMOS_PAGEOUT:
+	case DAMOS_ZSWAP:
 		return damon_cold_score(context, r, scheme);
 	default:
 		break;
@@ -683,6 +741,54 @@ static int damon_va_scheme_score(struct damon_ctx *context,
 	return DAMOS_MAX_SCORE;
 }
 
+/**
+ * damon_va_sample_nids() - Find the nodes backing the sampled addresses.
+ * @t:		Monitoring target of a vaddr context.
+ * @nids:	Array of at least @nr entries to fill.
+ * @nr:		Number of leading regions of @t to resolve.
+ *
+ * Resolves the &damon_region.sampling_addr of each region to the node of the
+ * page currently mapped there, or NUMA_NO_NODE if no page is present.  Call
+ * it only from the monitoring thread's callbacks, where the regions of @t
+ * are stable.
+ *
+ * Return: the number of entries of @nids filled.
+ */
+unsigned int damon_va_sample_nids(struct damon_target *t, int *nids,
+		unsigned int nr)
+{
+	struct vm_area_struct *vma;
+	struct damon_region *r;
+	struct mm_struct *mm;
+	struct page *page;
+	unsigned int i = 0;
+
+	mm = damon_get_mm(t);
+	if (!mm)
+		return 0;
+
+	mmap_read_lock(mm);
+	damon_for_each_region(r, t) {
+		if (i == nr)
+			break;
+		nids[i] = NUMA_NO_NODE;
+		vma = vma_lookup(mm, r->sampling_addr);
+		if (vma) {
+			page = follow_page(vma, r->sampling_addr, FOLL_GET);
+			if (!IS_ERR_OR_NULL(page)) {
+				nids[i] = page_to_nid(page);
+				put_page(page);
+			}
+		}
+		i++;
+	}
+	mmap_read_unlock(mm);
+	mmput(mm);
+
+	return i;
+}
+EXPORT_SYMBOL_GPL(damon_va_sample_nids);
+
 static int __init damon_va_initcall(void)
 {
 	struct damon_operations ops = {
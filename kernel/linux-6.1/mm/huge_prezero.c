@@ -0,0 +1,465 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Zeroing huge pages ahead of the faults that use them.
+ *
+ * Clearing a 2MB page takes a good part of a millisecond and a 1GB one
+ * far longer, all of it in the fault path.  With prezeroing enabled a
+ * SCHED_IDLE thread per memory node, "kprezerod<nid>", does that work
+ * when the CPU has nothing better to do:
+ *
+ * - it keeps a small pool of zeroed THPs allocated from the node, which
+ *   do_huge_pmd_anonymous_page() takes before going to the allocator;
+ * - it clears the free pages of the node's hugetlb pools and marks them
+ *   HPG_zeroed, which hugetlb_no_page() then does not clear again.
+ *
+ * The THP pool is filled without reclaim or compaction and handed back
+ * to the allocator by a shrinker under memory pressure.  Faults under a
+ * memory policy keep using the allocator, which knows how to honour it.
+ * Nodes that come online after the pools were set up are not covered.
+ *
+ * Controls are in /sys/kernel/mm/prezero/.
+ */
+
+#define pr_fmt(fmt) "prezero: " fmt
+
+#include <linux/mm.h>
+#include <linux/cpuset.h>
+#include <linux/freezer.h>
+#include <linux/huge_mm.h>
+#include <linux/kthread.h>
+#include <linux/mempolicy.h>
+#include <linux/shrinker.h>
+#include <linux/slab.h>
+#include <linux/sysfs.h>
+#include <linux/wait.h>
+#include <uapi/linux/sched/types.h>
+
+#include "internal.h"
+
+struct prezero_node {
+	int nid;
+	spinlock_t lock;		/* protects the thp pool */
+	struct list_head thp_pool;
+	unsigned int nr_thp;
+	bool kick;			/* the pool was drawn from */
+	wait_queue_head_t wait;
+	struct task_struct *thread;
+};
+
+static struct prezero_node *prezero_nodes[MAX_NUMNODES];
+static DEFINE_MUTEX(prezero_mutex);	/* protects prezero_enabled */
+
+static bool prezero_enabled __read_mostly;
+static bool prezero_hugetlb __read_mostly = true;
+static unsigned int prezero_thp_pool_pages __read_mostly = 4;
+static unsigned int prezero_sleep_millisecs __read_mostly = 1000;
+
+static void prezero_kick(struct prezero_node *pn)
+{
+	WRITE_ONCE(pn->kick, true);
+	if (wq_has_sleeper(&pn->wait))
+		wake_up_interruptible(&pn->wait);
+}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/* Node to take a zeroed THP from for a fault in @vma, if any */
+static int prezero_fault_node(struct vm_area_struct *vma)
+{
+	int nid = numa_node_id();
+
+#ifdef CONFIG_NUMA
+	if (vma_policy(vma) || current->mempolicy)
+		return NUMA_NO_NODE;
+#endif
+	if (!node_isset(nid, cpuset_current_mems_allowed))
+		return NUMA_NO_NODE;
+	return nid;
+}
+
+/**
+ * prezero_thp_get - take a zeroed THP for an anonymous fault
+ * @vma: the faulting VMA
+ *
+ * Return: a PMD sized folio prepared like one from vma_alloc_folio(),
+ * already cleared, or NULL when the caller should allocate and clear
+ * one itself.
+ */
+struct folio *prezero_thp_get(struct vm_area_struct *vma)
+{
+	struct prezero_node *pn;
+	struct folio *folio = NULL;
+	int nid;
+
+	if (!READ_ONCE(prezero_enabled))
+		return NULL;
+
+	nid = prezero_fault_node(vma);
+	if (nid == NUMA_NO_NODE)
+		return NULL;
+
+	pn = prezero_nodes[nid];
+	if (!pn || !READ_ONCE(pn->nr_thp))
+		return NULL;
+
+	spin_lock(&pn->lock);
+	folio = list_first_entry_or_null(&pn->thp_pool, struct folio, lru);
+	if (folio) {
+		list_del(&folio->lru);
+		pn->nr_thp--;
+	}
+	spin_unlock(&pn->lock);
+
+	if (!folio)
+		return NULL;
+
+	count_vm_event(PREZERO_THP_FAULT);
+	prezero_kick(pn);
+	return folio;
+}
+
+static bool prezero_thp_wanted(struct prezero_node *pn)
+{
+	return READ_ONCE(pn->nr_thp) < READ_ONCE(prezero_thp_pool_pages);
+}
+
+/* Add one zeroed THP to the pool of @pn; false if none could be had */
+static bool prezero_thp_fill(struct prezero_node *pn)
+{
+	struct folio *folio;
+
+	if (!prezero_thp_wanted(pn))
+		return false;
+
+	/* Only what is free for the taking, without reclaim or compaction */
+	folio = __folio_alloc_node(GFP_TRANSHUGE_LIGHT | __GFP_THISNODE,
+				   HPAGE_PMD_ORDER, pn->nid);
+	if (!folio)
+		return false;
+
+	clear_huge_page(&folio->page, 0, HPAGE_PMD_NR);
+
+	spin_lock(&pn->lock);
+	list_add_tail(&folio->lru, &pn->thp_pool);
+	pn->nr_thp++;
+	spin_unlock(&pn->lock);
+
+	count_vm_event(PREZERO_THP_FILL);
+	return true;
+}
+
+/* Return up to @nr pooled THPs of @pn to the allocator */
+static unsigned long prezero_thp_drain(struct prezero_node *pn,
+				       unsigned long nr)
+{
+	struct folio *folio, *next;
+	unsigned long freed = 0;
+	LIST_HEAD(list);
+
+	spin_lock(&pn->lock);
+	list_for_each_entry_safe(folio, next, &pn->thp_pool, lru) {
+		if (freed == nr)
+			break;
+		list_move(&folio->lru, &list);
+		pn->nr_thp--;
+		freed++;
+	}
+	spin_unlock(&pn->lock);
+
+	list_for_each_entry_safe(folio, next, &list, lru) {
+		list_del(&folio->lru);
+		folio_put(folio);
+	}
+	return freed;
+}
+
+static unsigned long prezero_shrink_count(struct shrinker *shrink,
+					  struct shrink_control *sc)
+{
+	struct prezero_node *pn = prezero_nodes[sc->nid];
+	unsigned long nr = pn ? READ_ONCE(pn->nr_thp) : 0;
+
+	return nr ? nr * HPAGE_PMD_NR : SHRINK_EMPTY;
+}
+
+static unsigned long prezero_shrink_scan(struct shrinker *shrink,
+					 struct shrink_control *sc)
+{
+	struct prezero_node *pn = prezero_nodes[sc->nid];
+
+	if (!pn)
+		return SHRINK_STOP;
+
+	return prezero_thp_drain(pn, DIV_ROUND_UP(sc->nr_to_scan,
+						  HPAGE_PMD_NR)) * HPAGE_PMD_NR;
+}
+
+static struct shrinker prezero_shrinker = {
+	.count_objects = prezero_shrink_count,
+	.scan_objects = prezero_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+	.flags = SHRINKER_NUMA_AWARE,
+};
+#else
+static bool prezero_thp_wanted(struct prezero_node *pn)
+{
+	return false;
+}
+
+static bool prezero_thp_fill(struct prezero_node *pn)
+{
+	return false;
+}
+
+static unsigned long prezero_thp_drain(struct prezero_node *pn,
+				       unsigned long nr)
+{
+	return 0;
+}
+#endif /* CONFIG_TRANSPARENT_HUGEPAGE */
+
+static int prezero_thread(void *data)
+{
+	struct prezero_node *pn = data;
+	struct sched_param param = { .sched_priority = 0 };
+
+	/* Clearing pages is only worth it with CPU time to spare */
+	sched_setscheduler_nocheck(current, SCHED_IDLE, &param);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		bool progress;
+
+		progress = prezero_thp_fill(pn);
+		if (READ_ONCE(prezero_hugetlb) && hugetlb_prezero_node(pn->nid))
+			progress = true;
+
+		try_to_freeze();
+		if (progress) {
+			cond_resched();
+			continue;
+		}
+
+		/*
+		 * Faults drawing from the pool kick us; freed hugetlb pages
+		 * and memory becoming available are only seen on timeout.
+		 */
+		wait_event_freezable_timeout(pn->wait,
+				kthread_should_stop() || READ_ONCE(pn->kick),
+				msecs_to_jiffies(prezero_sleep_millisecs));
+		WRITE_ONCE(pn->kick, false);
+	}
+	return 0;
+}
+
+static int prezero_start(void)
+{
+	int nid, err = 0;
+
+	for_each_node_state(nid, N_MEMORY) {
+		struct prezero_node *pn = prezero_nodes[nid];
+		struct task_struct *thread;
+
+		if (!pn || pn->thread)
+			continue;
+
+		thread = kthread_create_on_node(prezero_thread, pn, nid,
+						"kprezerod%d", nid);
+		if (IS_ERR(thread)) {
+			pr_err("failed to start thread for node %d\n", nid);
+			err = PTR_ERR(thread);
+			continue;
+		}
+		set_cpus_allowed_ptr(thread, cpumask_of_node(nid));
+		pn->thread = thread;
+		wake_up_process(thread);
+	}
+	return err;
+}
+
+static void prezero_stop(void)
+{
+	int nid;
+
+	for_each_node(nid) {
+		struct prezero_node *pn = prezero_nodes[nid];
+
+		if (!pn)
+			continue;
+		if (pn->thread) {
+			kthread_stop(pn->thread);
+			pn->thread = NULL;
+		}
+		prezero_thp_drain(pn, ULONG_MAX);
+	}
+}
+
+#ifdef CONFIG_SYSFS
+#define PREZERO_ATTR(_name) \
+	static struct kobj_attribute _name##_attr = __ATTR_RW(_name)
+
+static ssize_t enabled_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%d\n", READ_ONCE(prezero_enabled));
+}
+
+static ssize_t enabled_store(struct kobject *kobj,
+			     struct kobj_attribute *attr,
+			     const char *buf, size_t count)
+{
+	bool enable;
+	int err;
+
+	err = kstrtobool(buf, &enable);
+	if (err)
+		return err;
+
+	mutex_lock(&prezero_mutex);
+	if (enable && !prezero_enabled) {
+		WRITE_ONCE(prezero_enabled, true);
+		err = prezero_start();
+	} else if (!enable && prezero_enabled) {
+		WRITE_ONCE(prezero_enabled, false);
+		prezero_stop();
+	}
+	mutex_unlock(&prezero_mutex);
+
+	return err ? err : count;
+}
+PREZERO_ATTR(enabled);
+
+static ssize_t hugetlb_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%d\n", READ_ONCE(prezero_hugetlb));
+}
+
+static ssize_t hugetlb_store(struct kobject *kobj,
+			     struct kobj_attribute *attr,
+			     const char *buf, size_t count)
+{
+	bool value;
+	int err;
+
+	err = kstrtobool(buf, &value);
+	if (err)
+		return err;
+
+	WRITE_ONCE(prezero_hugetlb, value);
+	return count;
+}
+PREZERO_ATTR(hugetlb);
+
+static ssize_t thp_pool_pages_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(prezero_thp_pool_pages));
+}
+
+static ssize_t thp_pool_pages_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	unsigned int nr;
+	int nid, err;
+
+	err = kstrtouint(buf, 10, &nr);
+	if (err)
+		return err;
+
+	WRITE_ONCE(prezero_thp_pool_pages, nr);
+	for_each_node(nid) {
+		struct prezero_node *pn = prezero_nodes[nid];
+
+		if (!pn)
+			continue;
+		if (READ_ONCE(pn->nr_thp) > nr)
+			prezero_thp_drain(pn, READ_ONCE(pn->nr_thp) - nr);
+		else
+			prezero_kick(pn);
+	}
+	return count;
+}
+PREZERO_ATTR(thp_pool_pages);
+
+static ssize_t scan_sleep_millisecs_show(struct kobject *kobj,
+					 struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(prezero_sleep_millisecs));
+}
+
+static ssize_t scan_sleep_millisecs_store(struct kobject *kobj,
+					  struct kobj_attribute *attr,
+					  const char *buf, size_t count)
+{
+	unsigned int msecs;
+	int err;
+
+	err = kstrtouint(buf, 10, &msecs);
+	if (err)
+		return err;
+
+	WRITE_ONCE(prezero_sleep_millisecs, msecs);
+	return count;
+}
+PREZERO_ATTR(scan_sleep_millisecs);
+
+static ssize_t thp_pooled_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	unsigned long nr = 0;
+	int nid;
+
+	for_each_node(nid)
+		if (prezero_nodes[nid])
+			nr += READ_ONCE(prezero_nodes[nid]->nr_thp);
+	return sysfs_emit(buf, "%lu\n", nr);
+}
+static struct kobj_attribute thp_pooled_attr = __ATTR_RO(thp_pooled);
+
+static struct attribute *prezero_attrs[] = {
+	&enabled_attr.attr,
+	&hugetlb_attr.attr,
+	&thp_pool_pages_attr.attr,
+	&scan_sleep_millisecs_attr.attr,
+	&thp_pooled_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group prezero_attr_group = {
+	.attrs = prezero_attrs,
+	.name = "prezero",
+};
+#endif /* CONFIG_SYSFS */
+
+static int __init prezero_init(void)
+{
+	int nid, err = 0;
+
+	for_each_node_state(nid, N_MEMORY) {
+		struct prezero_node *pn;
+
+		pn = kzalloc_node(sizeof(*pn), GFP_KERNEL, nid);
+		if (!pn)
+			return -ENOMEM;
+		pn->nid = nid;
+		spin_lock_init(&pn->lock);
+		INIT_LIST_HEAD(&pn->thp_pool);
+		init_waitqueue_head(&pn->wait);
+		prezero_nodes[nid] = pn;
+	}
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	err = register_shrinker(&prezero_shrinker, "prezero-thp");
+	if (err)
+		return err;
+#endif
+
+#ifdef CONFIG_SYSFS
+	err = sysfs_create_group(mm_kobj, &prezero_attr_group);
+	if (err)
+		pr_err("register sysfs failed\n");
+#endif
+	return err;
+}
+subsys_initcall(prezero_init);
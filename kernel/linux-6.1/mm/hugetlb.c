@@ -1325,6 +1325,7 @@ static void enqueue_huge_page(struct hstate *h, struct page *page)
 	h->free_huge_pages++;
 	h->free_huge_pages_node[nid]++;
 	SetHPageFreed(page);
+	ClearHPageZeroed(page);
 }
 
 static struct page *dequeue_huge_page_node_exact(struct hstate *h, int nid)
@@ -1392,6 +1393,90 @@ static unsigned long available_huge_pages(struct hstate *h)
 	return h->free_huge_pages - h->resv_huge_pages;
 }
 
+#ifdef CONFIG_HUGEPAGE_PREZERO
+/*
+ * Clear one free page of @h on node @nid, so that the fault which gets
+ * it can skip clear_huge_page().  The page is off the free list while
+ * it is cleared, which is only done while there are unreserved free
+ * pages, to not fail an allocation a reservation has promised.
+ */
+static bool hugetlb_prezero_page(struct hstate *h, int nid)
+{
+	struct page *page;
+	bool found = false;
+
+	spin_lock_irq(&hugetlb_lock);
+	if (!available_huge_pages(h))
+		goto unlock;
+
+	list_for_each_entry(page, &h->hugepage_freelists[nid], lru) {
+		if (HPageZeroed(page) || PageHWPoison(page))
+			continue;
+
+		/* As dequeue_huge_page_node_exact(), but left unreferenced */
+		list_del_init(&page->lru);
+		ClearHPageFreed(page);
+		h->free_huge_pages--;
+		h->free_huge_pages_node[nid]--;
+		found = true;
+		break;
+	}
+unlock:
+	spin_unlock_irq(&hugetlb_lock);
+	if (!found)
+		return false;
+
+	clear_huge_page(page, 0, pages_per_huge_page(h));
+
+	spin_lock_irq(&hugetlb_lock);
+	enqueue_huge_page(h, page);
+	SetHPageZeroed(page);
+	spin_unlock_irq(&hugetlb_lock);
+
+	count_vm_event(PREZERO_HTLB_ZEROED);
+	return true;
+}
+
+/**
+ * hugetlb_prezero_node - clear free hugetlb pages ahead of their faults
+ * @nid: node whose free lists to work on
+ *
+ * Called by the node's prezero thread, see mm/huge_prezero.c.  Clears
+ * at most one page of each hstate per call.
+ *
+ * Return: true if a page was cleared, false if there is nothing left to
+ * clear on @nid.
+ */
+bool hugetlb_prezero_node(int nid)
+{
+	struct hstate *h;
+	bool progress = false;
+
+	for_each_hstate(h) {
+		if (hugetlb_prezero_page(h, nid))
+			progress = true;
+		cond_resched();
+	}
+	return progress;
+}
+
+/* The fault owns @page, so the flag is stable without hugetlb_lock */
+static bool hugetlb_page_prezeroed(struct page *page)
+{
+	if (!HPageZeroed(page))
+		return false;
+
+	ClearHPageZeroed(page);
+	count_vm_event(PREZERO_HTLB_FAULT);
+	return true;
+}
+#else
+static inline bool hugetlb_page_prezeroed(struct page *page)
+{
+	return false;
+}
+#endif
+
 static struct page *dequeue_huge_page_vma(struct hstate *h,
 				struct vm_area_struct *vma,
 				unsigned long address, int avoid_reserve,
@@ -1676,6 +1761,7 @@ static void __remove_hugetlb_page(struct hstate *h, struct page *page,
 		h->free_huge_pages--;
 		h->free_huge_pages_node[nid]--;
 	}
+	ClearHPageZeroed(page);
 	if (adjust_surplus) {
 		h->surplus_huge_pages--;
 		h->surplus_huge_pages_node[nid]--;
@@ -5916,7 +6002,8 @@ static vm_fault_t hugetlb_no_page(struct mm_struct *mm,
 				ret = 0;
 			goto out;
 		}
-		clear_huge_page(page, address, pages_per_huge_page(h));
+		if (!hugetlb_page_prezeroed(page))
+			clear_huge_page(page, address, pages_per_huge_page(h));
 		__SetPageUptodate(page);
 		new_page = true;
 
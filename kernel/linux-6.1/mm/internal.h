@@ -99,6 +99,8 @@ void unmap_page_range(struct mmu_gather *tlb,
 void page_cache_ra_order(struct readahead_control *, struct file_ra_state *,
 		unsigned int order);
 void force_page_cache_ra(struct readahead_control *, unsigned long nr);
+void page_cache_ra_populate(struct file *, pgoff_t index,
+		unsigned long nr_pages);
 static inline void force_page_cache_readahead(struct address_space *mapping,
 		struct file *file, pgoff_t index, unsigned long nr_to_read)
 {
@@ -629,10 +631,29 @@ static inline struct file *maybe_unlock_mmap_for_io(struct vm_fault *vmf,
 	if (fault_flag_allow_retry_first(flags) &&
 	    !(flags & FAULT_FLAG_RETRY_NOWAIT)) {
 		fpin = get_file(vmf->vma->vm_file);
-		mmap_read_unlock(vmf->vma->vm_mm);
+		release_fault_lock(vmf);
 	}
 	return fpin;
 }
+
+/*
+ * anon_vma_prepare() for a page fault. It needs mmap_lock, so a fault
+ * under the VMA lock drops it and asks to be retried under mmap_lock.
+ */
+static inline vm_fault_t vmf_anon_prepare(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+
+	if (likely(vma->anon_vma))
+		return 0;
+	if (vmf->flags & FAULT_FLAG_VMA_LOCK) {
+		vma_end_read(vma);
+		return VM_FAULT_RETRY;
+	}
+	if (unlikely(anon_vma_prepare(vma)))
+		return VM_FAULT_OOM;
+	return 0;
+}
 #else /* !CONFIG_MMU */
 static inline void unmap_mapping_folio(struct folio *folio) { }
 static inline void mlock_vma_page(struct page *page,
@@ -732,6 +753,26 @@ extern unsigned long  __must_check vm_mmap_pgoff(struct file *, unsigned long,
         unsigned long, unsigned long);
 
 extern void set_pageblock_order(void);
+
+/* Huge pages zeroed in the background, see mm/huge_prezero.c */
+#ifdef CONFIG_HUGEPAGE_PREZERO
+struct folio *prezero_thp_get(struct vm_area_struct *vma);
+#else
+static inline struct folio *prezero_thp_get(struct vm_area_struct *vma)
+{
+	return NULL;
+}
+#endif
+
+#if defined(CONFIG_HUGEPAGE_PREZERO) && defined(CONFIG_HUGETLB_PAGE)
+bool hugetlb_prezero_node(int nid);
+#else
+static inline bool hugetlb_prezero_node(int nid)
+{
+	return false;
+}
+#endif
+
 unsigned int reclaim_clean_pages_from_list(struct zone *zone,
 					    struct list_head *page_list);
 /* The ALLOC_WMARK bits are used as an index to zone->watermark */
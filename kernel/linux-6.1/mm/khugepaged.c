@@ -61,7 +61,6 @@ enum scan_result {
 #define CREATE_TRACE_POINTS
 #include <trace/events/huge_memory.h>
 
-static struct task_struct *khugepaged_thread __read_mostly;
 static DEFINE_MUTEX(khugepaged_mutex);
 
 /* default scan 8*512 pte (or vmas) every 30 second */
@@ -71,7 +70,6 @@ static unsigned int khugepaged_full_scans;
 static unsigned int khugepaged_scan_sleep_millisecs __read_mostly = 10000;
 /* during fragmentation poll the hugepage allocator once every minute */
 static unsigned int khugepaged_alloc_sleep_millisecs __read_mostly = 60000;
-static unsigned long khugepaged_sleep_expire;
 static DEFINE_SPINLOCK(khugepaged_mm_lock);
 static DECLARE_WAIT_QUEUE_HEAD(khugepaged_wait);
 /*
@@ -107,9 +105,13 @@ struct collapse_control {
  * @slot: hash lookup from mm to mm_slot
  * @nr_pte_mapped_thp: number of pte mapped THP
  * @pte_mapped_thp: address array corresponding pte mapped THP
+ * @nid: node whose khugepaged worker scans this mm
+ * @hot: queued by khugepaged_prioritise_mm() and not yet fully scanned
  */
 struct khugepaged_mm_slot {
 	struct mm_slot slot;
+	int nid;
+	bool hot;
 
 	/* pte-mapped THP in this mm */
 	int nr_pte_mapped_thp;
@@ -121,20 +123,49 @@ struct khugepaged_mm_slot {
  * @mm_head: the head of the mm list to scan
  * @mm_slot: the current mm_slot we are scanning
  * @address: the next address inside that to be scanned
+ * @nr_hot: number of hot mm_slots on @mm_head
+ * @sleep_expire: end of the worker's current scan sleep
+ * @nid: node this cursor scans for
+ * @thread: the khugepaged worker of this node
+ * @cc: collapse state of the worker
  *
- * There is only the one khugepaged_scan instance of this cursor structure.
+ * There is one khugepaged_scan instance per possible node, each scanned
+ * by a worker bound to the node's CPUs. An mm is put on the list of the
+ * node it is first faulted from and moved to the node holding most of its
+ * hot memory by khugepaged_prioritise_mm(), so collapsing mostly copies
+ * node-local memory. Hot mm_slots are queued right behind the cursor and
+ * scanned back to back, without the scan sleep in between.
  */
 struct khugepaged_scan {
 	struct list_head mm_head;
 	struct khugepaged_mm_slot *mm_slot;
 	unsigned long address;
+	unsigned int nr_hot;
+	unsigned long sleep_expire;
+	int nid;
+	struct task_struct *thread;
+	struct collapse_control cc;
 };
 
-static struct khugepaged_scan khugepaged_scan = {
-	.mm_head = LIST_HEAD_INIT(khugepaged_scan.mm_head),
-};
+static struct khugepaged_scan *khugepaged_scan[MAX_NUMNODES] __read_mostly;
+
+static inline struct khugepaged_scan *
+khugepaged_scan_of(struct khugepaged_mm_slot *mm_slot)
+{
+	return khugepaged_scan[mm_slot->nid];
+}
 
 #ifdef CONFIG_SYSFS
+/* Cut the scan sleep of every worker short after a tunable changed */
+static void khugepaged_kick(void)
+{
+	int nid;
+
+	for_each_node(nid)
+		WRITE_ONCE(khugepaged_scan[nid]->sleep_expire, 0);
+	wake_up_interruptible(&khugepaged_wait);
+}
+
 static ssize_t scan_sleep_millisecs_show(struct kobject *kobj,
 					 struct kobj_attribute *attr,
 					 char *buf)
@@ -154,8 +185,7 @@ static ssize_t scan_sleep_millisecs_store(struct kobject *kobj,
 		return -EINVAL;
 
 	khugepaged_scan_sleep_millisecs = msecs;
-	khugepaged_sleep_expire = 0;
-	wake_up_interruptible(&khugepaged_wait);
+	khugepaged_kick();
 
 	return count;
 }
@@ -181,8 +211,7 @@ static ssize_t alloc_sleep_millisecs_store(struct kobject *kobj,
 		return -EINVAL;
 
 	khugepaged_alloc_sleep_millisecs = msecs;
-	khugepaged_sleep_expire = 0;
-	wake_up_interruptible(&khugepaged_wait);
+	khugepaged_kick();
 
 	return count;
 }
@@ -387,8 +416,21 @@ int hugepage_madvise(struct vm_area_struct *vma,
 	return 0;
 }
 
+static void __init khugepaged_free_scans(void)
+{
+	int nid;
+
+	for_each_node(nid) {
+		kfree(khugepaged_scan[nid]);
+		khugepaged_scan[nid] = NULL;
+	}
+}
+
 int __init khugepaged_init(void)
 {
+	struct khugepaged_scan *scan;
+	int nid;
+
 	mm_slot_cache = kmem_cache_create("khugepaged_mm_slot",
 					  sizeof(struct khugepaged_mm_slot),
 					  __alignof__(struct khugepaged_mm_slot),
@@ -396,6 +438,20 @@ int __init khugepaged_init(void)
 	if (!mm_slot_cache)
 		return -ENOMEM;
 
+	for_each_node(nid) {
+		scan = kzalloc_node(sizeof(*scan), GFP_KERNEL,
+				    node_state(nid, N_MEMORY) ? nid : NUMA_NO_NODE);
+		if (!scan) {
+			khugepaged_free_scans();
+			kmem_cache_destroy(mm_slot_cache);
+			return -ENOMEM;
+		}
+		INIT_LIST_HEAD(&scan->mm_head);
+		scan->nid = nid;
+		scan->cc.is_khugepaged = true;
+		khugepaged_scan[nid] = scan;
+	}
+
 	khugepaged_pages_to_scan = HPAGE_PMD_NR * 8;
 	khugepaged_max_ptes_none = HPAGE_PMD_NR - 1;
 	khugepaged_max_ptes_swap = HPAGE_PMD_NR / 8;
@@ -406,6 +462,7 @@ int __init khugepaged_init(void)
 
 void __init khugepaged_destroy(void)
 {
+	khugepaged_free_scans();
 	kmem_cache_destroy(mm_slot_cache);
 }
 
@@ -417,6 +474,7 @@ static inline int hpage_collapse_test_exit(struct mm_struct *mm)
 void __khugepaged_enter(struct mm_struct *mm)
 {
 	struct khugepaged_mm_slot *mm_slot;
+	struct khugepaged_scan *scan;
 	struct mm_slot *slot;
 	int wakeup;
 
@@ -433,14 +491,18 @@ void __khugepaged_enter(struct mm_struct *mm)
 		return;
 	}
 
+	/* Until told otherwise, the memory lives where it is faulted from */
+	mm_slot->nid = numa_mem_id();
+	scan = khugepaged_scan_of(mm_slot);
+
 	spin_lock(&khugepaged_mm_lock);
 	mm_slot_insert(mm_slots_hash, mm, slot);
 	/*
 	 * Insert just behind the scanning cursor, to let the area settle
 	 * down a little.
 	 */
-	wakeup = list_empty(&khugepaged_scan.mm_head);
-	list_add_tail(&slot->mm_node, &khugepaged_scan.mm_head);
+	wakeup = list_empty(&scan->mm_head);
+	list_add_tail(&slot->mm_node, &scan->mm_head);
 	spin_unlock(&khugepaged_mm_lock);
 
 	mmgrab(mm);
@@ -461,15 +523,19 @@ void khugepaged_enter_vma(struct vm_area_struct *vma,
 void __khugepaged_exit(struct mm_struct *mm)
 {
 	struct khugepaged_mm_slot *mm_slot;
+	struct khugepaged_scan *scan;
 	struct mm_slot *slot;
 	int free = 0;
 
 	spin_lock(&khugepaged_mm_lock);
 	slot = mm_slot_lookup(mm_slots_hash, mm);
 	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-	if (mm_slot && khugepaged_scan.mm_slot != mm_slot) {
+	scan = mm_slot ? khugepaged_scan_of(mm_slot) : NULL;
+	if (mm_slot && scan->mm_slot != mm_slot) {
 		hash_del(&slot->hash);
 		list_del(&slot->mm_node);
+		if (mm_slot->hot)
+			scan->nr_hot--;
 		free = 1;
 	}
 	spin_unlock(&khugepaged_mm_lock);
@@ -491,6 +557,68 @@ void __khugepaged_exit(struct mm_struct *mm)
 	}
 }
 
+/**
+ * khugepaged_prioritise_mm - scan an mm ahead of the others
+ * @mm: the mm with hot memory to collapse
+ * @nid: node holding most of that memory, or NUMA_NO_NODE to keep it
+ *
+ * Move @mm right behind the scan cursor of @nid's khugepaged worker and
+ * have the worker scan it without sleeping in between, so huge page
+ * coverage of a hot working set builds up within a few scan passes
+ * rather than one round robin over every mm. The mm stays on @nid's list
+ * afterwards, and its collapses are allocated there when that is where
+ * its pages are, see hpage_collapse_find_target_node().
+ *
+ * Return: 0 on success, -EINVAL for a node without memory, or -ENOENT
+ * when @mm is not registered with khugepaged, which it is only after it
+ * mapped a VMA eligible for THP.
+ */
+int khugepaged_prioritise_mm(struct mm_struct *mm, int nid)
+{
+	struct khugepaged_mm_slot *mm_slot;
+	struct khugepaged_scan *scan;
+	struct mm_slot *slot;
+	int ret = 0;
+
+	if (nid != NUMA_NO_NODE &&
+	    (nid < 0 || nid >= nr_node_ids || !node_state(nid, N_MEMORY)))
+		return -EINVAL;
+
+	spin_lock(&khugepaged_mm_lock);
+	slot = mm_slot_lookup(mm_slots_hash, mm);
+	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
+	if (!mm_slot) {
+		ret = -ENOENT;
+		goto out;
+	}
+	if (mm_slot->hot)
+		goto out;
+
+	scan = khugepaged_scan_of(mm_slot);
+	/* Being scanned right now, so it is not moved off its list */
+	if (scan->mm_slot != mm_slot) {
+		list_del(&slot->mm_node);
+		if (nid != NUMA_NO_NODE) {
+			mm_slot->nid = nid;
+			scan = khugepaged_scan_of(mm_slot);
+		}
+		if (scan->mm_slot)
+			list_add(&slot->mm_node, &scan->mm_slot->slot.mm_node);
+		else
+			list_add(&slot->mm_node, &scan->mm_head);
+	}
+	mm_slot->hot = true;
+	scan->nr_hot++;
+	WRITE_ONCE(scan->sleep_expire, 0);
+out:
+	spin_unlock(&khugepaged_mm_lock);
+
+	if (!ret)
+		wake_up_interruptible(&khugepaged_wait);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(khugepaged_prioritise_mm);
+
 static void release_pte_page(struct page *page)
 {
 	mod_node_page_state(page_pgdat(page),
@@ -737,10 +865,6 @@ static void khugepaged_alloc_sleep(void)
 	remove_wait_queue(&khugepaged_wait, &wait);
 }
 
-struct collapse_control khugepaged_collapse_control = {
-	.is_khugepaged = true,
-};
-
 static bool hpage_collapse_scan_abort(int nid, struct collapse_control *cc)
 {
 	int i;
@@ -1043,6 +1167,7 @@ static int collapse_huge_page(struct mm_struct *mm, unsigned long address,
 	if (result != SCAN_SUCCEED)
 		goto out_up_write;
 
+	vma_start_write(vma);
 	anon_vma_lock_write(vma->anon_vma);
 
 	mmu_notifier_range_init(&range, MMU_NOTIFY_CLEAR, 0, NULL, mm,
@@ -1314,6 +1439,8 @@ static void collect_mm_slot(struct khugepaged_mm_slot *mm_slot)
 		/* free mm_slot */
 		hash_del(&slot->hash);
 		list_del(&slot->mm_node);
+		if (mm_slot->hot)
+			khugepaged_scan_of(mm_slot)->nr_hot--;
 
 		/*
 		 * Not strictly needed because the mm exited already.
@@ -1415,6 +1542,7 @@ static void collapse_and_free_pmd(struct mm_struct *mm, struct vm_area_struct *v
 	struct mmu_notifier_range range;
 
 	mmap_assert_write_locked(mm);
+	vma_start_write(vma);
 	if (vma->vm_file)
 		lockdep_assert_held_write(&vma->vm_file->f_mapping->i_mmap_rwsem);
 	/*
@@ -2271,7 +2399,8 @@ static bool khugepaged_add_pte_mapped_thp(struct mm_struct *mm,
 }
 #endif
 
-static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
+static unsigned int khugepaged_scan_mm_slot(struct khugepaged_scan *scan,
+					    unsigned int pages, int *result,
 					    struct collapse_control *cc)
 	__releases(&khugepaged_mm_lock)
 	__acquires(&khugepaged_mm_lock)
@@ -2287,15 +2416,15 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	lockdep_assert_held(&khugepaged_mm_lock);
 	*result = SCAN_FAIL;
 
-	if (khugepaged_scan.mm_slot) {
-		mm_slot = khugepaged_scan.mm_slot;
+	if (scan->mm_slot) {
+		mm_slot = scan->mm_slot;
 		slot = &mm_slot->slot;
 	} else {
-		slot = list_entry(khugepaged_scan.mm_head.next,
+		slot = list_entry(scan->mm_head.next,
 				     struct mm_slot, mm_node);
 		mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-		khugepaged_scan.address = 0;
-		khugepaged_scan.mm_slot = mm_slot;
+		scan->address = 0;
+		scan->mm_slot = mm_slot;
 	}
 	spin_unlock(&khugepaged_mm_lock);
 	khugepaged_collapse_pte_mapped_thps(mm_slot);
@@ -2313,7 +2442,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	if (unlikely(hpage_collapse_test_exit(mm)))
 		goto breakouterloop;
 
-	vma_iter_init(&vmi, mm, khugepaged_scan.address);
+	vma_iter_init(&vmi, mm, scan->address);
 	for_each_vma(vmi, vma) {
 		unsigned long hstart, hend;
 
@@ -2329,36 +2458,36 @@ skip:
 		}
 		hstart = round_up(vma->vm_start, HPAGE_PMD_SIZE);
 		hend = round_down(vma->vm_end, HPAGE_PMD_SIZE);
-		if (khugepaged_scan.address > hend)
+		if (scan->address > hend)
 			goto skip;
-		if (khugepaged_scan.address < hstart)
-			khugepaged_scan.address = hstart;
-		VM_BUG_ON(khugepaged_scan.address & ~HPAGE_PMD_MASK);
+		if (scan->address < hstart)
+			scan->address = hstart;
+		VM_BUG_ON(scan->address & ~HPAGE_PMD_MASK);
 
-		while (khugepaged_scan.address < hend) {
+		while (scan->address < hend) {
 			bool mmap_locked = true;
 
 			cond_resched();
 			if (unlikely(hpage_collapse_test_exit(mm)))
 				goto breakouterloop;
 
-			VM_BUG_ON(khugepaged_scan.address < hstart ||
-				  khugepaged_scan.address + HPAGE_PMD_SIZE >
+			VM_BUG_ON(scan->address < hstart ||
+				  scan->address + HPAGE_PMD_SIZE >
 				  hend);
 			if (IS_ENABLED(CONFIG_SHMEM) && vma->vm_file) {
 				struct file *file = get_file(vma->vm_file);
 				pgoff_t pgoff = linear_page_index(vma,
-						khugepaged_scan.address);
+						scan->address);
 
 				mmap_read_unlock(mm);
 				*result = hpage_collapse_scan_file(mm,
-								   khugepaged_scan.address,
+								   scan->address,
 								   file, pgoff, cc);
 				mmap_locked = false;
 				fput(file);
 			} else {
 				*result = hpage_collapse_scan_pmd(mm, vma,
-								  khugepaged_scan.address,
+								  scan->address,
 								  &mmap_locked,
 								  cc);
 			}
@@ -2367,12 +2496,12 @@ skip:
 				pmd_t *pmd;
 
 				*result = find_pmd_or_thp_or_none(mm,
-								  khugepaged_scan.address,
+								  scan->address,
 								  &pmd);
 				if (*result != SCAN_SUCCEED)
 					break;
 				if (!khugepaged_add_pte_mapped_thp(mm,
-								   khugepaged_scan.address))
+								   scan->address))
 					break;
 			} fallthrough;
 			case SCAN_SUCCEED:
@@ -2383,7 +2512,7 @@ skip:
 			}
 
 			/* move to next address */
-			khugepaged_scan.address += HPAGE_PMD_SIZE;
+			scan->address += HPAGE_PMD_SIZE;
 			progress += HPAGE_PMD_NR;
 			if (!mmap_locked)
 				/*
@@ -2403,7 +2532,7 @@ breakouterloop:
 breakouterloop_mmap_lock:
 
 	spin_lock(&khugepaged_mm_lock);
-	VM_BUG_ON(khugepaged_scan.mm_slot != mm_slot);
+	VM_BUG_ON(scan->mm_slot != mm_slot);
 	/*
 	 * Release the current mm_slot if this mm is about to die, or
 	 * if we scanned all vmas of this mm.
@@ -2414,36 +2543,41 @@ breakouterloop_mmap_lock:
 		 * khugepaged runs here, khugepaged_exit will find
 		 * mm_slot not pointing to the exiting mm.
 		 */
-		if (slot->mm_node.next != &khugepaged_scan.mm_head) {
+		if (slot->mm_node.next != &scan->mm_head) {
 			slot = list_entry(slot->mm_node.next,
 					  struct mm_slot, mm_node);
-			khugepaged_scan.mm_slot =
+			scan->mm_slot =
 				mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-			khugepaged_scan.address = 0;
+			scan->address = 0;
 		} else {
-			khugepaged_scan.mm_slot = NULL;
+			scan->mm_slot = NULL;
 			khugepaged_full_scans++;
 		}
 
+		if (mm_slot->hot) {
+			mm_slot->hot = false;
+			scan->nr_hot--;
+		}
 		collect_mm_slot(mm_slot);
 	}
 
 	return progress;
 }
 
-static int khugepaged_has_work(void)
+static int khugepaged_has_work(struct khugepaged_scan *scan)
 {
-	return !list_empty(&khugepaged_scan.mm_head) &&
+	return !list_empty(&scan->mm_head) &&
 		hugepage_flags_enabled();
 }
 
-static int khugepaged_wait_event(void)
+static int khugepaged_wait_event(struct khugepaged_scan *scan)
 {
-	return !list_empty(&khugepaged_scan.mm_head) ||
+	return !list_empty(&scan->mm_head) ||
 		kthread_should_stop();
 }
 
-static void khugepaged_do_scan(struct collapse_control *cc)
+static void khugepaged_do_scan(struct khugepaged_scan *scan,
+			       struct collapse_control *cc)
 {
 	unsigned int progress = 0, pass_through_head = 0;
 	unsigned int pages = READ_ONCE(khugepaged_pages_to_scan);
@@ -2459,11 +2593,11 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 			break;
 
 		spin_lock(&khugepaged_mm_lock);
-		if (!khugepaged_scan.mm_slot)
+		if (!scan->mm_slot)
 			pass_through_head++;
-		if (khugepaged_has_work() &&
+		if (khugepaged_has_work(scan) &&
 		    pass_through_head < 2)
-			progress += khugepaged_scan_mm_slot(pages - progress,
+			progress += khugepaged_scan_mm_slot(scan, pages - progress,
 							    &result, cc);
 		else
 			progress = pages;
@@ -2485,47 +2619,53 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 	}
 }
 
-static bool khugepaged_should_wakeup(void)
+static bool khugepaged_should_wakeup(struct khugepaged_scan *scan)
 {
 	return kthread_should_stop() ||
-	       time_after_eq(jiffies, khugepaged_sleep_expire);
+	       time_after_eq(jiffies, READ_ONCE(scan->sleep_expire));
 }
 
-static void khugepaged_wait_work(void)
+static void khugepaged_wait_work(struct khugepaged_scan *scan)
 {
-	if (khugepaged_has_work()) {
+	if (khugepaged_has_work(scan)) {
 		const unsigned long scan_sleep_jiffies =
 			msecs_to_jiffies(khugepaged_scan_sleep_millisecs);
 
-		if (!scan_sleep_jiffies)
+		/* Hot mms are scanned back to back until covered */
+		if (!scan_sleep_jiffies || READ_ONCE(scan->nr_hot))
 			return;
 
-		khugepaged_sleep_expire = jiffies + scan_sleep_jiffies;
+		WRITE_ONCE(scan->sleep_expire, jiffies + scan_sleep_jiffies);
 		wait_event_freezable_timeout(khugepaged_wait,
-					     khugepaged_should_wakeup(),
+					     khugepaged_should_wakeup(scan),
 					     scan_sleep_jiffies);
 		return;
 	}
 
 	if (hugepage_flags_enabled())
-		wait_event_freezable(khugepaged_wait, khugepaged_wait_event());
+		wait_event_freezable(khugepaged_wait,
+				     khugepaged_wait_event(scan));
 }
 
-static int khugepaged(void *none)
+static int khugepaged(void *data)
 {
+	struct khugepaged_scan *scan = data;
+	const struct cpumask *cpumask = cpumask_of_node(scan->nid);
 	struct khugepaged_mm_slot *mm_slot;
 
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(current, cpumask);
 	set_freezable();
 	set_user_nice(current, MAX_NICE);
 
 	while (!kthread_should_stop()) {
-		khugepaged_do_scan(&khugepaged_collapse_control);
-		khugepaged_wait_work();
+		khugepaged_do_scan(scan, &scan->cc);
+		khugepaged_wait_work(scan);
 	}
 
 	spin_lock(&khugepaged_mm_lock);
-	mm_slot = khugepaged_scan.mm_slot;
-	khugepaged_scan.mm_slot = NULL;
+	mm_slot = scan->mm_slot;
+	scan->mm_slot = NULL;
 	if (mm_slot)
 		collect_mm_slot(mm_slot);
 	spin_unlock(&khugepaged_mm_lock);
@@ -2583,27 +2723,61 @@ update_wmarks:
 	setup_per_zone_wmarks();
 }
 
+static void khugepaged_stop_workers(void)
+{
+	struct khugepaged_scan *scan;
+	int nid;
+
+	for_each_node(nid) {
+		scan = khugepaged_scan[nid];
+		if (scan->thread) {
+			kthread_stop(scan->thread);
+			scan->thread = NULL;
+		}
+	}
+}
+
+static bool khugepaged_running(void)
+{
+	int nid;
+
+	for_each_node(nid)
+		if (khugepaged_scan[nid]->thread)
+			return true;
+	return false;
+}
+
 int start_stop_khugepaged(void)
 {
-	int err = 0;
+	struct khugepaged_scan *scan;
+	int nid, err = 0;
 
 	mutex_lock(&khugepaged_mutex);
 	if (hugepage_flags_enabled()) {
-		if (!khugepaged_thread)
-			khugepaged_thread = kthread_run(khugepaged, NULL,
-							"khugepaged");
-		if (IS_ERR(khugepaged_thread)) {
-			pr_err("khugepaged: kthread_run(khugepaged) failed\n");
-			err = PTR_ERR(khugepaged_thread);
-			khugepaged_thread = NULL;
-			goto fail;
+		for_each_node(nid) {
+			scan = khugepaged_scan[nid];
+			/*
+			 * mm_slots are entered on nodes with memory, but stay
+			 * where they are when that memory is offlined.
+			 */
+			if (scan->thread || (!node_state(nid, N_MEMORY) &&
+					     list_empty(&scan->mm_head)))
+				continue;
+			scan->thread = kthread_create_on_node(khugepaged, scan, nid,
+							      "khugepaged/%d", nid);
+			if (IS_ERR(scan->thread)) {
+				pr_err("khugepaged: kthread_run(khugepaged) failed\n");
+				err = PTR_ERR(scan->thread);
+				scan->thread = NULL;
+				khugepaged_stop_workers();
+				goto fail;
+			}
+			wake_up_process(scan->thread);
 		}
 
-		if (!list_empty(&khugepaged_scan.mm_head))
-			wake_up_interruptible(&khugepaged_wait);
-	} else if (khugepaged_thread) {
-		kthread_stop(khugepaged_thread);
-		khugepaged_thread = NULL;
+		wake_up_interruptible(&khugepaged_wait);
+	} else {
+		khugepaged_stop_workers();
 	}
 	set_recommended_min_free_kbytes();
 fail:
@@ -2614,7 +2788,7 @@ fail:
 void khugepaged_min_free_kbytes_update(void)
 {
 	mutex_lock(&khugepaged_mutex);
-	if (hugepage_flags_enabled() && khugepaged_thread)
+	if (hugepage_flags_enabled() && khugepaged_running())
 		set_recommended_min_free_kbytes();
 	mutex_unlock(&khugepaged_mutex);
 }
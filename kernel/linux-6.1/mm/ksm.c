@@ -186,6 +186,8 @@ struct ksm_stable_node {
  * @mm: the memory structure this rmap_item is pointing into
  * @address: the virtual address this rmap_item tracks (+ flags in low bits)
  * @oldchecksum: previous checksum of the page at that virtual address
+ * @age: number of scan passes the page went through without being merged
+ * @remaining_skips: how many more scan passes to skip this page for
  * @node: rb node of this rmap_item in the unstable tree
  * @head: pointer to stable_node heading this list in the stable tree
  * @hlist: link into hlist of rmap_items hanging off that stable_node
@@ -201,6 +203,8 @@ struct ksm_rmap_item {
 	struct mm_struct *mm;
 	unsigned long address;		/* + low bits used for flags below */
 	unsigned int oldchecksum;	/* when unstable */
+	unsigned char age;		/* passes without being merged */
+	unsigned char remaining_skips;	/* passes left to skip */
 	union {
 		struct rb_node node;	/* when node of unstable tree */
 		struct {		/* when listed from stable tree */
@@ -274,6 +278,12 @@ static unsigned int zero_checksum __read_mostly;
 /* Whether to merge empty (zeroed) pages with actual zero pages */
 static bool ksm_use_zero_pages __read_mostly;
 
+/* Skip pages whose content stayed the same without finding a match */
+static bool ksm_smart_scan __read_mostly = true;
+
+/* The number of pages skipped by ksm_smart_scan */
+static unsigned long ksm_pages_skipped;
+
 #ifdef CONFIG_NUMA
 /* Zeroed when merging across nodes is not allowed */
 static unsigned int ksm_merge_across_nodes = 1;
@@ -2101,6 +2111,9 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	checksum = calc_checksum(page);
 	if (rmap_item->oldchecksum != checksum) {
 		rmap_item->oldchecksum = checksum;
+		/* New content deserves a fresh look, see should_skip_rmap_item() */
+		rmap_item->age = 0;
+		rmap_item->remaining_skips = 0;
 		return;
 	}
 
@@ -2223,6 +2236,87 @@ static struct ksm_rmap_item *get_next_rmap_item(struct ksm_mm_slot *mm_slot,
 	return rmap_item;
 }
 
+/*
+ * Number of passes to skip a page for once it has gone through @age passes
+ * with the same checksum and without being merged.
+ */
+static unsigned char skip_age(unsigned char age)
+{
+	if (age <= 3)
+		return 1;
+	if (age <= 5)
+		return 2;
+	if (age <= 8)
+		return 4;
+	return 8;
+}
+
+/*
+ * Pages whose checksum stays the same from pass to pass, but which never
+ * find a match in either tree, are unlikely to find one in the next pass:
+ * skip them for an exponentially growing number of passes instead of
+ * searching the stable tree for them again. cmp_and_merge_page() resets
+ * the age whenever the checksum changes.
+ */
+static bool should_skip_rmap_item(struct page *page,
+				  struct ksm_rmap_item *rmap_item)
+{
+	unsigned char age;
+
+	if (!ksm_smart_scan)
+		return false;
+
+	/* Merged pages are cheap to check, let cmp_and_merge_page() do it */
+	if (PageKsm(page))
+		return false;
+
+	age = rmap_item->age;
+	if (age != U8_MAX)
+		rmap_item->age++;
+
+	/* Give young pages a chance to go through both trees */
+	if (age < 3)
+		return false;
+
+	if (!rmap_item->remaining_skips) {
+		rmap_item->remaining_skips = skip_age(age);
+		return false;
+	}
+
+	ksm_pages_skipped++;
+	rmap_item->remaining_skips--;
+	remove_rmap_item_from_tree(rmap_item);
+	return true;
+}
+
+/*
+ * Processes can ask for their memory to be scanned only every so many
+ * passes through /proc/<pid>/ksm_scan_interval, trading merge latency for
+ * less ksmd time spent on them. In a pass that skips over an mm, its
+ * rmap_items are taken out of the unstable tree like those of skipped
+ * pages: they would be too old to remove at the next pass otherwise.
+ */
+static bool ksm_skip_mm(struct ksm_mm_slot *mm_slot)
+{
+	struct mm_struct *mm = mm_slot->slot.mm;
+	unsigned int interval = READ_ONCE(mm->ksm_scan_interval);
+	struct ksm_rmap_item *rmap_item;
+
+	if (interval <= 1 || !(ksm_scan.seqnr % interval))
+		return false;
+
+	/* Let the scan notice an exiting mm and tear the slot down */
+	if (ksm_test_exit(mm))
+		return false;
+
+	for (rmap_item = mm_slot->rmap_list; rmap_item;
+	     rmap_item = rmap_item->rmap_list) {
+		if (rmap_item->address & UNSTABLE_FLAG)
+			remove_rmap_item_from_tree(rmap_item);
+	}
+	return true;
+}
+
 static struct ksm_rmap_item *scan_get_next_rmap_item(struct page **page)
 {
 	struct mm_struct *mm;
@@ -2288,6 +2382,9 @@ static struct ksm_rmap_item *scan_get_next_rmap_item(struct page **page)
 next_mm:
 		ksm_scan.address = 0;
 		ksm_scan.rmap_list = &mm_slot->rmap_list;
+
+		if (ksm_skip_mm(mm_slot))
+			goto skip_mm;
 	}
 
 	slot = &mm_slot->slot;
@@ -2325,6 +2422,9 @@ next_mm:
 				if (rmap_item) {
 					ksm_scan.rmap_list =
 							&rmap_item->rmap_list;
+					if (should_skip_rmap_item(*page,
+								  rmap_item))
+						goto next_page;
 					ksm_scan.address += PAGE_SIZE;
 				} else
 					put_page(*page);
@@ -2382,7 +2482,16 @@ no_vmas:
 		 */
 		spin_unlock(&ksm_mmlist_lock);
 	}
+	goto next;
+
+skip_mm:
+	spin_lock(&ksm_mmlist_lock);
+	slot = list_entry(mm_slot->slot.mm_node.next,
+			  struct mm_slot, mm_node);
+	ksm_scan.mm_slot = mm_slot_entry(slot, struct ksm_mm_slot, slot);
+	spin_unlock(&ksm_mmlist_lock);
 
+next:
 	/* Repeat until we've completed scanning the whole list */
 	mm_slot = ksm_scan.mm_slot;
 	if (mm_slot != &ksm_mm_head)
@@ -3031,6 +3140,35 @@ static ssize_t use_zero_pages_store(struct kobject *kobj,
 }
 KSM_ATTR(use_zero_pages);
 
+static ssize_t smart_scan_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", ksm_smart_scan);
+}
+
+static ssize_t smart_scan_store(struct kobject *kobj,
+				struct kobj_attribute *attr,
+				const char *buf, size_t count)
+{
+	int err;
+	bool value;
+
+	err = kstrtobool(buf, &value);
+	if (err)
+		return -EINVAL;
+
+	ksm_smart_scan = value;
+	return count;
+}
+KSM_ATTR(smart_scan);
+
+static ssize_t pages_skipped_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%lu\n", ksm_pages_skipped);
+}
+KSM_ATTR_RO(pages_skipped);
+
 static ssize_t max_page_sharing_show(struct kobject *kobj,
 				     struct kobj_attribute *attr, char *buf)
 {
@@ -3174,6 +3312,8 @@ static struct attribute *ksm_attrs[] = {
 	&stable_node_dups_attr.attr,
 	&stable_node_chains_prune_millisecs_attr.attr,
 	&use_zero_pages_attr.attr,
+	&smart_scan_attr.attr,
+	&pages_skipped_attr.attr,
 	NULL,
 };
 
@@ -182,6 +182,7 @@ success:
 	/*
 	 * vm_flags is protected by the mmap_lock held in write mode.
 	 */
+	vma_start_write(vma);
 	vma->vm_flags = new_flags;
 	if (!vma->vm_file) {
 		error = replace_anon_vma_name(vma, anon_name);
@@ -890,6 +891,17 @@ static long madvise_dontneed_free(struct vm_area_struct *vma,
 		return -EINVAL;
 }
 
+/*
+ * File mappings advised MADV_HUGEPAGE, such as model weights, are read
+ * into large folios by parallel workers before they are faulted in, so
+ * populating them is not one readahead window per fault.
+ */
+static bool madvise_populate_readahead(struct vm_area_struct *vma)
+{
+	return IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE) && vma->vm_file &&
+	       (vma->vm_flags & VM_HUGEPAGE) && !vma_is_dax(vma);
+}
+
 static long madvise_populate(struct vm_area_struct *vma,
 			     struct vm_area_struct **prev,
 			     unsigned long start, unsigned long end,
@@ -897,7 +909,8 @@ static long madvise_populate(struct vm_area_struct *vma,
 {
 	const bool write = behavior == MADV_POPULATE_WRITE;
 	struct mm_struct *mm = vma->vm_mm;
-	unsigned long tmp_end;
+	unsigned long tmp_end, ra_end = start;
+	struct file *file;
 	int locked = 1;
 	long pages;
 
@@ -915,6 +928,20 @@ static long madvise_populate(struct vm_area_struct *vma,
 		}
 
 		tmp_end = min_t(unsigned long, end, vma->vm_end);
+		if (tmp_end > ra_end && madvise_populate_readahead(vma)) {
+			pgoff_t pgoff = linear_page_index(vma, start);
+
+			file = get_file(vma->vm_file);
+			ra_end = tmp_end;
+			mmap_read_unlock(mm);
+			page_cache_ra_populate(file, pgoff,
+					       (tmp_end - start) >> PAGE_SHIFT);
+			fput(file);
+			mmap_read_lock(mm);
+			*prev = NULL;
+			vma = NULL;
+			continue;
+		}
 		/* Populate (prefault) page tables readable/writable. */
 		pages = faultin_vma_page_range(vma, start, tmp_end, write,
 					       &locked);
@@ -1367,7 +1394,8 @@ int madvise_set_anon_name(struct mm_struct *mm, unsigned long start,
  *  MADV_PAGEOUT - the application is not expected to use this memory soon,
  *		page out the pages in this range immediately.
  *  MADV_POPULATE_READ - populate (prefault) page tables readable by
- *		triggering read faults if required
+ *		triggering read faults if required. File ranges also advised
+ *		MADV_HUGEPAGE are first read into large folios in parallel.
  *  MADV_POPULATE_WRITE - populate (prefault) page tables writable by
  *		triggering write faults if required
  *
@@ -572,6 +572,11 @@ mem_cgroup_largest_soft_limit_node(struct mem_cgroup_tree_per_node *mctz)
  *    (MEMCG_CHARGE_BATCH * nr_cpus) update events. Though this optimization
  *    will let stats be out of sync by atmost (MEMCG_CHARGE_BATCH * nr_cpus) but
  *    only for 2 seconds due to (1).
+ *
+ * 3) Readers of one memcg's stat files flush only that memcg's subtree, and
+ *    not at all when a flush covering it ran within FLUSH_READ_AGE; see
+ *    cgroup_rstat_flush_bounded(). With thousands of memcgs polled by
+ *    monitoring agents this keeps readers off the root-wide flush.
  */
 static void flush_memcg_stats_dwork(struct work_struct *w);
 static DECLARE_DEFERRABLE_WORK(stats_flush_dwork, flush_memcg_stats_dwork);
@@ -581,6 +586,7 @@ static atomic_t stats_flush_threshold = ATOMIC_INIT(0);
 static u64 flush_next_time;
 
 #define FLUSH_TIME (2UL*HZ)
+#define FLUSH_READ_AGE (HZ/10)
 
 /*
  * Accessors to ensure that preemption is disabled on PREEMPT_RT because it can
@@ -649,6 +655,13 @@ void mem_cgroup_flush_stats_delayed(void)
 		mem_cgroup_flush_stats();
 }
 
+/* Sleepable flush for readers of @memcg's own stats */
+static void mem_cgroup_flush_stats_subtree(struct mem_cgroup *memcg)
+{
+	if (atomic_read(&stats_flush_threshold) > num_online_cpus())
+		cgroup_rstat_flush_bounded(memcg->css.cgroup, FLUSH_READ_AGE);
+}
+
 static void flush_memcg_stats_dwork(struct work_struct *w)
 {
 	__mem_cgroup_flush_stats();
@@ -1556,7 +1569,7 @@ static void memory_stat_format(struct mem_cgroup *memcg, char *buf, int bufsize)
 	 *
 	 * Current memory state:
 	 */
-	mem_cgroup_flush_stats();
+	mem_cgroup_flush_stats_subtree(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		u64 size;
@@ -4000,7 +4013,7 @@ static int memcg_numa_stat_show(struct seq_file *m, void *v)
 	int nid;
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
 
-	mem_cgroup_flush_stats();
+	mem_cgroup_flush_stats_subtree(memcg);
 
 	for (stat = stats; stat < stats + ARRAY_SIZE(stats); stat++) {
 		seq_printf(m, "%s=%lu", stat->name,
@@ -4076,7 +4089,7 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 
 	BUILD_BUG_ON(ARRAY_SIZE(memcg1_stat_names) != ARRAY_SIZE(memcg1_stats));
 
-	mem_cgroup_flush_stats();
+	mem_cgroup_flush_stats_subtree(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memcg1_stats); i++) {
 		unsigned long nr;
@@ -5359,6 +5372,10 @@ mem_cgroup_css_alloc(struct cgroup_subsys_state *parent_css)
 	memcg->soft_limit = PAGE_COUNTER_MAX;
 #if defined(CONFIG_MEMCG_KMEM) && defined(CONFIG_ZSWAP)
 	memcg->zswap_max = PAGE_COUNTER_MAX;
+	memcg->zswap_budget = U64_MAX;
+#endif
+#ifdef CONFIG_NUMA
+	memcg->promote_max = PAGE_COUNTER_MAX;
 #endif
 	page_counter_set_high(&memcg->swap, PAGE_COUNTER_MAX);
 	if (parent) {
@@ -6554,7 +6571,7 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 	int i;
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
 
-	mem_cgroup_flush_stats();
+	mem_cgroup_flush_stats_subtree(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		int nid;
@@ -6610,6 +6627,140 @@ static ssize_t memory_oom_group_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+#ifdef CONFIG_LRU_GEN
+static const char *const memory_lru_gen_hint_names[NR_LRU_GEN_HINTS] = {
+	[LRU_GEN_HINT_NONE]	= "none",
+	[LRU_GEN_HINT_HOT]	= "hot",
+	[LRU_GEN_HINT_COLD]	= "cold",
+};
+
+static int memory_lru_gen_hint_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	unsigned int type = READ_ONCE(memcg->lru_gen_hint.type);
+	unsigned long expires = READ_ONCE(memcg->lru_gen_hint.expires);
+
+	if (expires && time_is_before_eq_jiffies(expires))
+		type = LRU_GEN_HINT_NONE;
+
+	seq_puts(m, memory_lru_gen_hint_names[type]);
+	if (type == LRU_GEN_HINT_HOT)
+		seq_printf(m, " %u",
+			   jiffies_to_msecs(READ_ONCE(memcg->lru_gen_hint.min_ttl)));
+	seq_putc(m, '\n');
+
+	return 0;
+}
+
+/* "none", "cold" or "hot <min_ttl_ms>"; hints written here do not lapse */
+static ssize_t memory_lru_gen_hint_write(struct kernfs_open_file *of,
+					 char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned int msecs = 0;
+	char *name;
+	int type, err;
+
+	buf = strstrip(buf);
+	name = strsep(&buf, " ");
+
+	type = match_string(memory_lru_gen_hint_names, NR_LRU_GEN_HINTS, name);
+	if (type < 0)
+		return type;
+
+	if (type == LRU_GEN_HINT_HOT) {
+		if (!buf || kstrtouint(skip_spaces(buf), 0, &msecs))
+			return -EINVAL;
+	} else if (buf) {
+		return -EINVAL;
+	}
+
+	err = lru_gen_set_hint(memcg, type, msecs_to_jiffies(msecs), 0);
+
+	return err ?: nbytes;
+}
+#endif
+
+#ifdef CONFIG_NUMA
+/* Like the zswap budget, the promotion quota is accounted per second */
+static void mem_cgroup_promote_window(struct mem_cgroup *memcg)
+{
+	unsigned long start = READ_ONCE(memcg->promote_start);
+
+	if (time_before(jiffies, start + HZ))
+		return;
+	if (cmpxchg(&memcg->promote_start, start, jiffies) == start)
+		atomic_long_set(&memcg->promote_used, 0);
+}
+
+/**
+ * mem_cgroup_promote_charge - charge a promotion to the top memory tier
+ * @folio: the hot folio about to be promoted
+ *
+ * Check that promoting @folio keeps its cgroup, and each of its
+ * ancestors, within the memory.promote.max it was given for the current
+ * second, and charge the folio's pages if so. Cgroups with a small quota
+ * leave their pages in the lower tiers they were demoted or allocated
+ * to, which keeps the top tier for the hot sets of the others.
+ *
+ * Returns true when the folio may be promoted.
+ */
+bool mem_cgroup_promote_charge(struct folio *folio)
+{
+	long nr_pages = folio_nr_pages(folio);
+	struct mem_cgroup *memcg, *iter;
+	bool ret = true;
+
+	if (mem_cgroup_disabled())
+		return true;
+
+	rcu_read_lock();
+	memcg = folio_memcg_rcu(folio);
+	for (iter = memcg; iter; iter = parent_mem_cgroup(iter)) {
+		unsigned long max = READ_ONCE(iter->promote_max);
+
+		if (max == PAGE_COUNTER_MAX)
+			continue;
+		mem_cgroup_promote_window(iter);
+		if (atomic_long_read(&iter->promote_used) + nr_pages > max) {
+			ret = false;
+			goto out;
+		}
+	}
+	/* racing promotions may overshoot a little, the quota is a rate */
+	for (iter = memcg; iter; iter = parent_mem_cgroup(iter))
+		if (READ_ONCE(iter->promote_max) != PAGE_COUNTER_MAX)
+			atomic_long_add(nr_pages, &iter->promote_used);
+out:
+	rcu_read_unlock();
+	return ret;
+}
+
+static int memory_promote_max_show(struct seq_file *m, void *v)
+{
+	return seq_puts_memcg_tunable(m,
+		READ_ONCE(mem_cgroup_from_seq(m)->promote_max));
+}
+
+/* bytes promoted per second, or "max" */
+static ssize_t memory_promote_max_write(struct kernfs_open_file *of,
+					char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned long max;
+	int err;
+
+	buf = strstrip(buf);
+	err = page_counter_memparse(buf, "max", &max);
+	if (err)
+		return err;
+
+	WRITE_ONCE(memcg->promote_max, max);
+
+	return nbytes;
+}
+#endif
+
 static ssize_t memory_reclaim(struct kernfs_open_file *of, char *buf,
 			      size_t nbytes, loff_t off)
 {
@@ -6720,6 +6871,22 @@ static struct cftype memory_files[] = {
 		.flags = CFTYPE_NS_DELEGATABLE,
 		.write = memory_reclaim,
 	},
+#ifdef CONFIG_LRU_GEN
+	{
+		.name = "lru_gen_hint",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_lru_gen_hint_show,
+		.write = memory_lru_gen_hint_write,
+	},
+#endif
+#ifdef CONFIG_NUMA
+	{
+		.name = "promote.max",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_promote_max_show,
+		.write = memory_promote_max_write,
+	},
+#endif
 	{ }	/* terminate */
 };
 
@@ -7673,8 +7840,8 @@ static struct cftype memsw_files[] = {
 
 #if defined(CONFIG_MEMCG_KMEM) && defined(CONFIG_ZSWAP)
 /**
- * obj_cgroup_may_zswap - check if this cgroup can zswap
- * @objcg: the object cgroup
+ * mem_cgroup_may_zswap - check if this cgroup can zswap
+ * @memcg: the memory cgroup
  *
  * Check if the hierarchical zswap limit has been reached.
  *
@@ -7684,17 +7851,14 @@ static struct cftype memsw_files[] = {
  * spending cycles on compression when there is already no room left
  * or zswap is disabled altogether somewhere in the hierarchy.
  */
-bool obj_cgroup_may_zswap(struct obj_cgroup *objcg)
+bool mem_cgroup_may_zswap(struct mem_cgroup *memcg)
 {
-	struct mem_cgroup *memcg, *original_memcg;
 	bool ret = true;
 
 	if (!cgroup_subsys_on_dfl(memory_cgrp_subsys))
 		return true;
 
-	original_memcg = get_mem_cgroup_from_objcg(objcg);
-	for (memcg = original_memcg; memcg != root_mem_cgroup;
-	     memcg = parent_mem_cgroup(memcg)) {
+	for (; memcg != root_mem_cgroup; memcg = parent_mem_cgroup(memcg)) {
 		unsigned long max = READ_ONCE(memcg->zswap_max);
 		unsigned long pages;
 
@@ -7712,10 +7876,76 @@ bool obj_cgroup_may_zswap(struct obj_cgroup *objcg)
 		ret = false;
 		break;
 	}
-	mem_cgroup_put(original_memcg);
 	return ret;
 }
 
+/**
+ * obj_cgroup_may_zswap - check if this cgroup can zswap
+ * @objcg: the object cgroup
+ *
+ * See mem_cgroup_may_zswap().
+ */
+bool obj_cgroup_may_zswap(struct obj_cgroup *objcg)
+{
+	struct mem_cgroup *memcg;
+	bool ret;
+
+	memcg = get_mem_cgroup_from_objcg(objcg);
+	ret = mem_cgroup_may_zswap(memcg);
+	mem_cgroup_put(memcg);
+	return ret;
+}
+
+/* The compression budget is accounted in windows of one second */
+static void mem_cgroup_zswap_budget_window(struct mem_cgroup *memcg)
+{
+	unsigned long start = READ_ONCE(memcg->zswap_budget_start);
+
+	if (time_before(jiffies, start + HZ))
+		return;
+	/* one racing charge may land in the old window, the budget is a hint */
+	if (cmpxchg(&memcg->zswap_budget_start, start, jiffies) == start)
+		atomic64_set(&memcg->zswap_budget_used, 0);
+}
+
+/**
+ * mem_cgroup_zswap_budget_left - check the proactive compression budget
+ * @memcg: the memory cgroup
+ *
+ * Check if compressing this cgroup's pages took less time in the current
+ * second than its memory.zswap.budget. Unlike memory.zswap.max this is
+ * not hierarchical, and it only holds off proactive reclaim into zswap,
+ * see zswap_can_store(); other swap-outs are still compressed.
+ */
+bool mem_cgroup_zswap_budget_left(struct mem_cgroup *memcg)
+{
+	u64 budget = READ_ONCE(memcg->zswap_budget);
+
+	if (budget == U64_MAX)
+		return true;
+
+	mem_cgroup_zswap_budget_window(memcg);
+	return atomic64_read(&memcg->zswap_budget_used) < budget;
+}
+
+/**
+ * obj_cgroup_charge_zswap_time - charge compression time
+ * @objcg: the object cgroup
+ * @ns: time spent compressing one of its pages
+ */
+void obj_cgroup_charge_zswap_time(struct obj_cgroup *objcg, u64 ns)
+{
+	struct mem_cgroup *memcg;
+
+	rcu_read_lock();
+	memcg = obj_cgroup_memcg(objcg);
+	if (READ_ONCE(memcg->zswap_budget) != U64_MAX) {
+		mem_cgroup_zswap_budget_window(memcg);
+		atomic64_add(ns, &memcg->zswap_budget_used);
+	}
+	rcu_read_unlock();
+}
+
 /**
  * obj_cgroup_charge_zswap - charge compression backend memory
  * @objcg: the object cgroup
@@ -7797,6 +8027,43 @@ static ssize_t zswap_max_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int zswap_budget_show(struct seq_file *m, void *v)
+{
+	u64 budget = READ_ONCE(mem_cgroup_from_seq(m)->zswap_budget);
+
+	if (budget == U64_MAX)
+		seq_puts(m, "max\n");
+	else
+		seq_printf(m, "%llu\n", div_u64(budget, NSEC_PER_USEC));
+
+	return 0;
+}
+
+/* microseconds of compression per second, or "max" */
+static ssize_t zswap_budget_write(struct kernfs_open_file *of,
+				  char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	u64 budget;
+	int err;
+
+	buf = strstrip(buf);
+	if (!strcmp(buf, "max")) {
+		budget = U64_MAX;
+	} else {
+		err = kstrtou64(buf, 0, &budget);
+		if (err)
+			return err;
+		if (budget > USEC_PER_SEC)
+			return -EINVAL;
+		budget *= NSEC_PER_USEC;
+	}
+
+	WRITE_ONCE(memcg->zswap_budget, budget);
+
+	return nbytes;
+}
+
 static struct cftype zswap_files[] = {
 	{
 		.name = "zswap.current",
@@ -7809,6 +8076,12 @@ static struct cftype zswap_files[] = {
 		.seq_show = zswap_max_show,
 		.write = zswap_max_write,
 	},
+	{
+		.name = "zswap.budget",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = zswap_budget_show,
+		.write = zswap_budget_write,
+	},
 	{ }	/* terminate */
 };
 #endif /* CONFIG_MEMCG_KMEM && CONFIG_ZSWAP */
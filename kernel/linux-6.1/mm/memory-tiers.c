@@ -327,6 +327,32 @@ int next_demotion_node(int node)
 	return target;
 }
 
+/**
+ * next_promotion_node() - Get the node to promote hot pages of @node to
+ * @node: The node the pages are on
+ *
+ * Return: the closest top tier node with memory; NUMA_NO_NODE if @node is
+ * in the top tier itself or no top tier node has memory.  Like
+ * next_demotion_node(), this does not keep the returned node online.
+ */
+int next_promotion_node(int node)
+{
+	int nid, target = NUMA_NO_NODE;
+
+	if (node_is_toptier(node))
+		return NUMA_NO_NODE;
+
+	for_each_node_state(nid, N_MEMORY) {
+		if (!node_is_toptier(nid))
+			continue;
+		if (target == NUMA_NO_NODE ||
+		    node_distance(node, nid) < node_distance(node, target))
+			target = nid;
+	}
+
+	return target;
+}
+
 static void disable_all_demotion_targets(void)
 {
 	struct memory_tier *memtier;
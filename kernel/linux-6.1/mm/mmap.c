@@ -544,6 +544,10 @@ inline int vma_expand(struct ma_state *mas, struct vm_area_struct *vma,
 	if (mas_preallocate(mas, vma, GFP_KERNEL))
 		goto nomem;
 
+	vma_start_write(vma);
+	if (remove_next)
+		vma_start_write(next);
+
 	vma_adjust_trans_huge(vma, start, end, 0);
 
 	if (file) {
@@ -598,6 +602,7 @@ inline int vma_expand(struct ma_state *mas, struct vm_area_struct *vma,
 			anon_vma_merge(vma, next);
 		mm->map_count--;
 		mpol_put(vma_policy(next));
+		vma_mark_detached(next);
 		vm_area_free(next);
 	}
 
@@ -728,6 +733,12 @@ int __vma_adjust(struct vm_area_struct *vma, unsigned long start,
 		return -ENOMEM;
 	}
 
+	vma_start_write(vma);
+	if (next)
+		vma_start_write(next);
+	if (next_next)
+		vma_start_write(next_next);
+
 	vma_adjust_trans_huge(orig_vma, start, end, adjust_next);
 	if (file) {
 		mapping = file->f_mapping;
@@ -852,6 +863,7 @@ again:
 		mpol_put(vma_policy(next));
 		if (remove_next != 2)
 			BUG_ON(vma->vm_end < next->vm_end);
+		vma_mark_detached(next);
 		vm_area_free(next);
 
 		/*
@@ -2431,7 +2443,7 @@ do_mas_align_munmap(struct ma_state *mas, struct vm_area_struct *vma,
 		    struct mm_struct *mm, unsigned long start,
 		    unsigned long end, struct list_head *uf, bool downgrade)
 {
-	struct vm_area_struct *prev, *next = NULL;
+	struct vm_area_struct *prev, *next = NULL, *detached;
 	struct maple_tree mt_detach;
 	int count = 0;
 	int error = -ENOMEM;
@@ -2494,6 +2506,7 @@ do_mas_align_munmap(struct ma_state *mas, struct vm_area_struct *vma,
 
 			mas_set(mas, end);
 			split = mas_prev(mas, 0);
+			vma_start_write(split);
 			mas_set_range(&mas_detach, split->vm_start, split->vm_end - 1);
 			error = mas_store_gfp(&mas_detach, split, GFP_KERNEL);
 			if (error)
@@ -2506,6 +2519,7 @@ do_mas_align_munmap(struct ma_state *mas, struct vm_area_struct *vma,
 				vma = split;
 			break;
 		}
+		vma_start_write(next);
 		mas_set_range(&mas_detach, next->vm_start, next->vm_end - 1);
 		error = mas_store_gfp(&mas_detach, next, GFP_KERNEL);
 		if (error)
@@ -2562,6 +2576,9 @@ do_mas_align_munmap(struct ma_state *mas, struct vm_area_struct *vma,
 #endif
 	/* Point of no return */
 	mas_store_prealloc(mas, NULL);
+	mas_set(&mas_detach, start);
+	mas_for_each(&mas_detach, detached, ULONG_MAX)
+		vma_mark_detached(detached);
 
 	mm->locked_vm -= locked_vm;
 	mm->map_count -= count;
@@ -2831,6 +2848,8 @@ cannot_expand:
 	if (vma->vm_file)
 		i_mmap_lock_write(vma->vm_file->f_mapping);
 
+	/* Lock the VMA since it is modified after insertion into VMA tree */
+	vma_start_write(vma);
 	vma_mas_store(vma, &mas);
 	mm->map_count++;
 	if (vma->vm_file) {
@@ -3094,6 +3113,7 @@ static int do_brk_flags(struct ma_state *mas, struct vm_area_struct *vma,
 		if (mas_preallocate(mas, vma, GFP_KERNEL))
 			return -ENOMEM;
 
+		vma_start_write(vma);
 		vma_adjust_trans_huge(vma, vma->vm_start, addr + len, 0);
 		if (vma->anon_vma) {
 			anon_vma_lock_write(vma->anon_vma);
@@ -605,6 +605,8 @@ static unsigned long move_vma(struct vm_area_struct *vma,
 			return err;
 	}
 
+	vma_start_write(vma);
+
 	/*
 	 * Advise KSM to break any KSM pages in the area to be moved:
 	 * it would be confusing if they were to turn up at the new
@@ -631,6 +633,10 @@ static unsigned long move_vma(struct vm_area_struct *vma,
 		return -ENOMEM;
 	}
 
+	/* copy_vma() may have replaced vma, and new_vma can be a fresh one */
+	vma_start_write(vma);
+	vma_start_write(new_vma);
+
 	moved_len = move_page_tables(vma, old_addr, new_vma, new_addr, old_len,
 				     need_rmap_locks);
 	if (moved_len < old_len) {
@@ -194,7 +194,7 @@ static unsigned long pcpu_nr_populated;
 /*
  * Balance work is used to populate or destroy chunks asynchronously.  We
  * try to keep the number of populated free pages between
- * PCPU_EMPTY_POP_PAGES_LOW and HIGH for atomic allocations and at most one
+ * pcpu_empty_pop_pages_low and high for atomic allocations and at most one
  * empty chunk.
  */
 static void pcpu_balance_workfn(struct work_struct *work);
@@ -202,6 +202,13 @@ static DECLARE_WORK(pcpu_balance_work, pcpu_balance_workfn);
 static bool pcpu_async_enabled __read_mostly;
 static bool pcpu_atomic_alloc_failed;
 
+/*
+ * Raised with percpu_empty_pages= for workloads that make bursts of atomic
+ * allocations, such as per-cpu BPF map updates.
+ */
+static int pcpu_empty_pop_pages_low __read_mostly = PCPU_EMPTY_POP_PAGES_LOW;
+static int pcpu_empty_pop_pages_high __read_mostly = PCPU_EMPTY_POP_PAGES_HIGH;
+
 static void pcpu_schedule_balance_work(void)
 {
 	if (pcpu_async_enabled)
@@ -1874,7 +1881,7 @@ area_found:
 		mutex_unlock(&pcpu_alloc_mutex);
 	}
 
-	if (pcpu_nr_empty_pop_pages < PCPU_EMPTY_POP_PAGES_LOW)
+	if (pcpu_nr_empty_pop_pages < pcpu_empty_pop_pages_low)
 		pcpu_schedule_balance_work();
 
 	/* clear the areas and return address relative to base address */
@@ -2058,13 +2065,13 @@ static void pcpu_balance_populated(void)
 	 */
 retry_pop:
 	if (pcpu_atomic_alloc_failed) {
-		nr_to_pop = PCPU_EMPTY_POP_PAGES_HIGH;
+		nr_to_pop = pcpu_empty_pop_pages_high;
 		/* best effort anyway, don't worry about synchronization */
 		pcpu_atomic_alloc_failed = false;
 	} else {
-		nr_to_pop = clamp(PCPU_EMPTY_POP_PAGES_HIGH -
+		nr_to_pop = clamp(pcpu_empty_pop_pages_high -
 				  pcpu_nr_empty_pop_pages,
-				  0, PCPU_EMPTY_POP_PAGES_HIGH);
+				  0, pcpu_empty_pop_pages_high);
 	}
 
 	for (slot = pcpu_size_to_slot(PAGE_SIZE); slot <= pcpu_free_slot; slot++) {
@@ -2164,7 +2171,7 @@ static void pcpu_reclaim_populated(void)
 				break;
 
 			/* reintegrate chunk to prevent atomic alloc failures */
-			if (pcpu_nr_empty_pop_pages < PCPU_EMPTY_POP_PAGES_HIGH) {
+			if (pcpu_nr_empty_pop_pages < pcpu_empty_pop_pages_high) {
 				reintegrate = true;
 				goto end_chunk;
 			}
@@ -2811,6 +2818,24 @@ static int __init percpu_alloc_setup(char *str)
 }
 early_param("percpu_alloc", percpu_alloc_setup);
 
+static int __init percpu_empty_pages_setup(char *str)
+{
+	int low, high;
+
+	if (!str)
+		return -EINVAL;
+
+	if (sscanf(str, "%d,%d", &low, &high) != 2 || low < 1 || high < low) {
+		pr_warn("invalid percpu_empty_pages=%s, want <low>,<high>\n", str);
+		return -EINVAL;
+	}
+
+	pcpu_empty_pop_pages_low = low;
+	pcpu_empty_pop_pages_high = high;
+	return 0;
+}
+early_param("percpu_empty_pages", percpu_empty_pages_setup);
+
 /*
  * pcpu_embed_first_chunk() is used by the generic percpu setup.
  * Build it if needed by the arch config or the generic setup is going
@@ -128,7 +128,12 @@
 #include <linux/mm_inline.h>
 #include <linux/blk-cgroup.h>
 #include <linux/fadvise.h>
+#include <linux/kthread.h>
+#include <linux/memcontrol.h>
 #include <linux/sched/mm.h>
+#include <linux/workqueue.h>
+
+#include <trace/events/filemap.h>
 
 #include "internal.h"
 
@@ -564,6 +569,205 @@ fallback:
 	do_page_cache_ra(ractl, ra->size, ra->async_size);
 }
 
+/* Range each populate worker reads at a time, a multiple of the PMD size */
+#define RA_POPULATE_CHUNK	(SZ_8M / PAGE_SIZE)
+#define RA_POPULATE_MAX_WORKERS	16
+
+struct ra_populate {
+	struct file *file;
+	pgoff_t end;
+	atomic_long_t next;
+	struct mem_cgroup *memcg;
+	struct cgroup_subsys_state *blkcg_css;
+	atomic_t nr_running;
+	struct completion done;
+};
+
+struct ra_populate_worker {
+	struct work_struct work;
+	struct ra_populate *rp;
+};
+
+static void ra_populate_chunks(struct ra_populate *rp)
+{
+	struct address_space *mapping = rp->file->f_mapping;
+	struct file_ra_state ra = { };
+	pgoff_t index;
+
+	while ((index = atomic_long_fetch_add(RA_POPULATE_CHUNK,
+					      &rp->next)) < rp->end) {
+		DEFINE_READAHEAD(ractl, rp->file, &ra, mapping, index);
+
+		ra.size = min_t(pgoff_t, RA_POPULATE_CHUNK, rp->end - index);
+		ra.async_size = 0;
+		page_cache_ra_order(&ractl, &ra, MAX_PAGECACHE_ORDER);
+		cond_resched();
+	}
+}
+
+static void ra_populate_workfn(struct work_struct *work)
+{
+	struct ra_populate_worker *w =
+		container_of(work, struct ra_populate_worker, work);
+	struct ra_populate *rp = w->rp;
+	struct mem_cgroup *old_memcg;
+
+	/* Charge and throttle the reads like the caller's own */
+	old_memcg = set_active_memcg(rp->memcg);
+	kthread_associate_blkcg(rp->blkcg_css);
+	ra_populate_chunks(rp);
+	kthread_associate_blkcg(NULL);
+	set_active_memcg(old_memcg);
+
+	if (atomic_dec_and_test(&rp->nr_running))
+		complete(&rp->done);
+}
+
+/**
+ * page_cache_ra_populate - Read a file range into the page cache in parallel.
+ * @file: The file to read.
+ * @index: First page of the range.
+ * @nr_pages: Number of pages in the range.
+ *
+ * Splits the range into chunks and has unbound workers read them, with
+ * the caller taking its share, so that allocating folios, inserting them
+ * into the page cache and building bios for a multi-GiB mapping is not
+ * done one readahead window at a time from page faults. Folios are as
+ * large as the filesystem supports, up to PMD size, such that the mapping
+ * can then be faulted in with one PMD or a few PTE batches per folio.
+ *
+ * Folios already in the page cache are skipped, and the reads are only
+ * submitted: the caller waits for them under the folio locks when it
+ * faults the range in. Memory and IO are accounted to the caller's
+ * cgroups.
+ */
+void page_cache_ra_populate(struct file *file, pgoff_t index,
+		unsigned long nr_pages)
+{
+	pgoff_t isize = DIV_ROUND_UP(i_size_read(file_inode(file)), PAGE_SIZE);
+	struct ra_populate_worker *workers;
+	unsigned int i, nr_workers;
+	struct ra_populate rp = {
+		.file = file,
+		.end = min_t(pgoff_t, index + nr_pages, isize),
+		.next = ATOMIC_LONG_INIT(index),
+	};
+
+	if (index >= rp.end)
+		return;
+	if (unlikely(!file->f_mapping->a_ops->read_folio &&
+		     !file->f_mapping->a_ops->readahead))
+		return;
+
+	nr_workers = DIV_ROUND_UP(rp.end - index, RA_POPULATE_CHUNK) - 1;
+	nr_workers = min3(nr_workers, num_online_cpus() - 1,
+			  (unsigned int)RA_POPULATE_MAX_WORKERS);
+	workers = nr_workers ? kcalloc(nr_workers, sizeof(*workers),
+				       GFP_KERNEL) : NULL;
+	if (!workers) {
+		ra_populate_chunks(&rp);
+		return;
+	}
+
+	rp.memcg = get_mem_cgroup_from_mm(current->mm);
+#ifdef CONFIG_BLK_CGROUP
+	rp.blkcg_css = task_get_css(current, io_cgrp_id);
+#endif
+	atomic_set(&rp.nr_running, nr_workers);
+	init_completion(&rp.done);
+	for (i = 0; i < nr_workers; i++) {
+		INIT_WORK(&workers[i].work, ra_populate_workfn);
+		workers[i].rp = &rp;
+		queue_work(system_unbound_wq, &workers[i].work);
+	}
+
+	ra_populate_chunks(&rp);
+	wait_for_completion(&rp.done);
+
+	if (rp.blkcg_css)
+		css_put(rp.blkcg_css);
+	mem_cgroup_put(rp.memcg);
+	kfree(workers);
+}
+
+/*
+ * Read @nr_chunks chunks of @req_size pages, ractl->ra->stride apart,
+ * starting at @index. Each chunk is read like a readahead window of its
+ * own, in folios as large as it allows, so the chunks get a private
+ * window rather than disturbing the sequential state in ractl->ra.
+ */
+static void page_cache_ra_stride(struct readahead_control *ractl, pgoff_t index,
+		unsigned long req_size, unsigned long nr_chunks)
+{
+	struct file_ra_state *ra = ractl->ra;
+	loff_t isize = i_size_read(ractl->mapping->host);
+	struct file_ra_state chunk = { };
+	pgoff_t end_index;
+	struct blk_plug plug;
+
+	if (isize == 0)
+		return;
+	end_index = (isize - 1) >> PAGE_SHIFT;
+
+	ractl->ra = &chunk;
+	blk_start_plug(&plug);
+	while (nr_chunks-- && index <= end_index) {
+		chunk.size = req_size;
+		chunk.async_size = 0;
+		ractl->_index = index;
+		page_cache_ra_order(ractl, &chunk, ilog2(req_size));
+		index += ra->stride;
+	}
+	blk_finish_plug(&plug);
+	ractl->ra = ra;
+}
+
+/*
+ * Strided readahead. Small random reads that keep the same distance from
+ * one another, like a column scan or a loader walking fixed-size records,
+ * are read ahead by stride: once the distance has repeated
+ * RA_STRIDE_MIN_HITS times, the next chunks of the stream, each as large
+ * as the request, are read together with the current one, up to about
+ * one readahead window in total. The stream is then picked up again at
+ * the first chunk it misses.
+ */
+#define RA_STRIDE_MIN_HITS	2
+#define RA_STRIDE_MAX_CHUNKS	16
+
+static bool try_stride_readahead(struct readahead_control *ractl,
+				 pgoff_t index, unsigned long req_size,
+				 unsigned long max)
+{
+	struct file_ra_state *ra = ractl->ra;
+	unsigned long stride = index - ra->stride_prev;
+	unsigned long nr_chunks;
+
+	if (index <= ra->stride_prev || stride != ra->stride ||
+	    stride <= req_size) {
+		if (ra->stride_hits >= RA_STRIDE_MIN_HITS)
+			trace_mm_filemap_readahead_stride(ractl->mapping, index,
+							  ra, false);
+		ra->stride_prev = index;
+		ra->stride = min_t(unsigned long, stride, UINT_MAX);
+		ra->stride_hits = 0;
+		return false;
+	}
+
+	if (ra->stride_hits < UINT_MAX)
+		ra->stride_hits++;
+	if (ra->stride_hits < RA_STRIDE_MIN_HITS) {
+		ra->stride_prev = index;
+		return false;
+	}
+	trace_mm_filemap_readahead_stride(ractl->mapping, index, ra, true);
+
+	nr_chunks = clamp_t(unsigned long, max / req_size, 2,
+			    RA_STRIDE_MAX_CHUNKS);
+	page_cache_ra_stride(ractl, index, req_size, nr_chunks);
+	ra->stride_prev = index + (nr_chunks - 1) * stride;
+	return true;
+}
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -652,6 +856,12 @@ static void ondemand_readahead(struct readahead_control *ractl,
 			max_pages))
 		goto readit;
 
+	/*
+	 * Part of a strided stream: read its next chunks along.
+	 */
+	if (try_stride_readahead(ractl, index, req_size, max_pages))
+		return;
+
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
@@ -2695,12 +2695,22 @@ static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 	}
 }
 
+static void *magazine_alloc(struct kmem_cache *s, gfp_t gfpflags);
+static void flush_magazine(struct kmem_cache *s);
+static void __flush_magazine(struct kmem_cache *s, int cpu);
+
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
-	void *freelist = c->freelist;
-	struct slab *slab = c->slab;
+	void *freelist;
+	struct slab *slab;
 
+	/* The magazine may free objects to the cpu slab, so go first */
+	if (s->magazine)
+		__flush_magazine(s, cpu);
+
+	freelist = c->freelist;
+	slab = c->slab;
 	c->slab = NULL;
 	c->freelist = NULL;
 	c->tid = next_tid(c->tid);
@@ -2733,6 +2743,10 @@ static void flush_cpu_slab(struct work_struct *w)
 	sfw = container_of(w, struct slub_flush_work, work);
 
 	s = sfw->s;
+
+	if (s->magazine)
+		flush_magazine(s);
+
 	c = this_cpu_ptr(s->cpu_slab);
 
 	if (c->slab)
@@ -2745,6 +2759,9 @@ static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
+	if (s->magazine && READ_ONCE(per_cpu_ptr(s->magazine, cpu)->size))
+		return true;
+
 	return c->slab || slub_percpu_partial(c);
 }
 
@@ -3323,6 +3340,12 @@ static __always_inline void *slab_alloc_node(struct kmem_cache *s, struct list_l
 	if (unlikely(object))
 		goto out;
 
+	if (s->magazine && (node == NUMA_NO_NODE || node == numa_mem_id())) {
+		object = magazine_alloc(s, gfpflags);
+		if (likely(object))
+			goto got_object;
+	}
+
 redo:
 	/*
 	 * Must read kmem_cache cpu data via this cpu ptr. Preemption is
@@ -3391,6 +3414,7 @@ redo:
 		stat(s, ALLOC_FASTPATH);
 	}
 
+got_object:
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
 
@@ -3649,6 +3673,157 @@ redo:
 	stat(s, FREE_FASTPATH);
 }
 
+/*
+ * Per cpu magazines of SLAB_MAGAZINE caches.
+ *
+ * The objects in a magazine are free as far as the allocation and free
+ * hooks are concerned, but still allocated from their slabs: refilling
+ * and flushing a magazine bypasses the hooks. Only objects of the local
+ * node are kept, so that an allocation from the magazine has the same
+ * locality as one from the cpu slab.
+ */
+static void magazine_release(struct kmem_cache *s, void **p, unsigned int nr)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		do_slab_free(s, virt_to_slab(p[i]), p[i], NULL, 1, _RET_IP_);
+}
+
+/* Take up to @nr objects from the cpu slab, like kmem_cache_alloc_bulk() */
+static unsigned int magazine_refill(struct kmem_cache *s, gfp_t gfpflags,
+				    void **p, unsigned int nr)
+{
+	struct kmem_cache_cpu *c;
+	unsigned long flags;
+	unsigned int i;
+
+	c = slub_get_cpu_ptr(s->cpu_slab);
+	local_lock_irqsave(&s->cpu_slab->lock, flags);
+
+	for (i = 0; i < nr; i++) {
+		void *object = c->freelist;
+
+		if (unlikely(!object)) {
+			/* See kmem_cache_alloc_bulk() */
+			c->tid = next_tid(c->tid);
+
+			local_unlock_irqrestore(&s->cpu_slab->lock, flags);
+
+			p[i] = ___slab_alloc(s, gfpflags, NUMA_NO_NODE,
+					    _RET_IP_, c, s->object_size);
+			if (unlikely(!p[i]))
+				goto out;
+
+			c = this_cpu_ptr(s->cpu_slab);
+			local_lock_irqsave(&s->cpu_slab->lock, flags);
+			continue;
+		}
+		c->freelist = get_freepointer(s, object);
+		p[i] = object;
+	}
+	c->tid = next_tid(c->tid);
+	local_unlock_irqrestore(&s->cpu_slab->lock, flags);
+out:
+	slub_put_cpu_ptr(s->cpu_slab);
+	stat(s, MAGAZINE_REFILL);
+	return i;
+}
+
+static void *magazine_alloc(struct kmem_cache *s, gfp_t gfpflags)
+{
+	struct kmem_cache_magazine *mag;
+	void *batch[SLUB_MAGAZINE_BATCH];
+	unsigned int nr, keep;
+	unsigned long flags;
+	void *object;
+
+	local_lock_irqsave(&s->magazine->lock, flags);
+	mag = this_cpu_ptr(s->magazine);
+	if (likely(mag->size)) {
+		object = mag->objects[--mag->size];
+		local_unlock_irqrestore(&s->magazine->lock, flags);
+		stat(s, ALLOC_MAGAZINE);
+		return object;
+	}
+	local_unlock_irqrestore(&s->magazine->lock, flags);
+
+	nr = magazine_refill(s, gfpflags, batch, SLUB_MAGAZINE_BATCH);
+	if (!nr)
+		return NULL;
+	object = batch[--nr];
+
+	/* We may have moved to another cpu, or raced with frees on this one */
+	local_lock_irqsave(&s->magazine->lock, flags);
+	mag = this_cpu_ptr(s->magazine);
+	keep = min(nr, SLUB_MAGAZINE_SIZE - mag->size);
+	memcpy(mag->objects + mag->size, batch, keep * sizeof(void *));
+	mag->size += keep;
+	local_unlock_irqrestore(&s->magazine->lock, flags);
+
+	magazine_release(s, batch + keep, nr - keep);
+	stat(s, ALLOC_MAGAZINE);
+	return object;
+}
+
+static bool magazine_free(struct kmem_cache *s, struct slab *slab, void *object)
+{
+	struct kmem_cache_magazine *mag;
+	void *batch[SLUB_MAGAZINE_BATCH];
+	unsigned int nr = 0;
+	unsigned long flags;
+
+	if (IS_ENABLED(CONFIG_NUMA) && slab_nid(slab) != numa_mem_id())
+		return false;
+
+	local_lock_irqsave(&s->magazine->lock, flags);
+	mag = this_cpu_ptr(s->magazine);
+	if (unlikely(mag->size == SLUB_MAGAZINE_SIZE)) {
+		/* Flush the coldest objects, at the bottom of the stack */
+		nr = SLUB_MAGAZINE_BATCH;
+		memcpy(batch, mag->objects, nr * sizeof(void *));
+		memmove(mag->objects, mag->objects + nr,
+			(SLUB_MAGAZINE_SIZE - nr) * sizeof(void *));
+		mag->size -= nr;
+	}
+	mag->objects[mag->size++] = object;
+	local_unlock_irqrestore(&s->magazine->lock, flags);
+
+	if (nr) {
+		magazine_release(s, batch, nr);
+		stat(s, MAGAZINE_FLUSH);
+	}
+	stat(s, FREE_MAGAZINE);
+	return true;
+}
+
+/* Empty the magazine of the current cpu */
+static void flush_magazine(struct kmem_cache *s)
+{
+	struct kmem_cache_magazine *mag;
+	void *objects[SLUB_MAGAZINE_SIZE];
+	unsigned long flags;
+	unsigned int nr;
+
+	local_lock_irqsave(&s->magazine->lock, flags);
+	mag = this_cpu_ptr(s->magazine);
+	nr = mag->size;
+	memcpy(objects, mag->objects, nr * sizeof(void *));
+	mag->size = 0;
+	local_unlock_irqrestore(&s->magazine->lock, flags);
+
+	magazine_release(s, objects, nr);
+}
+
+/* Empty the magazine of a cpu that went offline */
+static void __flush_magazine(struct kmem_cache *s, int cpu)
+{
+	struct kmem_cache_magazine *mag = per_cpu_ptr(s->magazine, cpu);
+
+	magazine_release(s, mag->objects, mag->size);
+	mag->size = 0;
+}
+
 static __always_inline void slab_free(struct kmem_cache *s, struct slab *slab,
 				      void *head, void *tail, void **p, int cnt,
 				      unsigned long addr)
@@ -3658,8 +3833,11 @@ static __always_inline void slab_free(struct kmem_cache *s, struct slab *slab,
 	 * With KASAN enabled slab_free_freelist_hook modifies the freelist
 	 * to remove objects, whose reuse must be delayed.
 	 */
-	if (slab_free_freelist_hook(s, &head, &tail, &cnt))
+	if (slab_free_freelist_hook(s, &head, &tail, &cnt)) {
+		if (s->magazine && cnt == 1 && magazine_free(s, slab, head))
+			return;
 		do_slab_free(s, slab, head, tail, cnt, addr);
+	}
 }
 
 #ifdef CONFIG_KASAN_GENERIC
@@ -4031,6 +4209,17 @@ static inline int alloc_kmem_cache_cpus(struct kmem_cache *s)
 
 	init_kmem_cache_cpus(s);
 
+	if ((s->flags & SLAB_MAGAZINE) && !kmem_cache_debug(s)) {
+		int cpu;
+
+		s->magazine = alloc_percpu(struct kmem_cache_magazine);
+		if (!s->magazine)
+			return 0;
+
+		for_each_possible_cpu(cpu)
+			local_lock_init(&per_cpu_ptr(s->magazine, cpu)->lock);
+	}
+
 	return 1;
 }
 
@@ -4095,6 +4284,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
+	free_percpu(s->magazine);
 	free_percpu(s->cpu_slab);
 	free_kmem_cache_nodes(s);
 }
@@ -5429,6 +5619,19 @@ static ssize_t cpu_slabs_show(struct kmem_cache *s, char *buf)
 }
 SLAB_ATTR_RO(cpu_slabs);
 
+static ssize_t magazine_objects_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long objects = 0;
+	int cpu;
+
+	if (s->magazine) {
+		for_each_online_cpu(cpu)
+			objects += READ_ONCE(per_cpu_ptr(s->magazine, cpu)->size);
+	}
+	return sysfs_emit(buf, "%lu\n", objects);
+}
+SLAB_ATTR_RO(magazine_objects);
+
 static ssize_t objects_show(struct kmem_cache *s, char *buf)
 {
 	return show_slab_objects(s, buf, SO_ALL|SO_OBJECTS);
@@ -5712,6 +5915,10 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_MAGAZINE, alloc_magazine);
+STAT_ATTR(FREE_MAGAZINE, free_magazine);
+STAT_ATTR(MAGAZINE_REFILL, magazine_refill);
+STAT_ATTR(MAGAZINE_FLUSH, magazine_flush);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -5748,6 +5955,7 @@ static struct attribute *slab_attrs[] = {
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
 	&cpu_slabs_attr.attr,
+	&magazine_objects_attr.attr,
 	&ctor_attr.attr,
 	&aliases_attr.attr,
 	&align_attr.attr,
@@ -5799,6 +6007,10 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_magazine_attr.attr,
+	&free_magazine_attr.attr,
+	&magazine_refill_attr.attr,
+	&magazine_flush_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -16,6 +16,7 @@
 
 #include <linux/mm.h>
 #include <linux/sched.h>
+#include <linux/sched/clock.h>
 #include <linux/kernel_stat.h>
 #include <linux/swap.h>
 #include <linux/mman.h>
@@ -46,10 +47,72 @@
 /* How many pages do we try to swap or page in/out together? */
 int page_cluster;
 
+/*
+ * The per-cpu LRU batches start out at PAGEVEC_SIZE folios and grow up to
+ * LRU_FBATCH_MAX while draining them keeps finding lru_lock contended,
+ * that is waiting LRU_FBATCH_CONTENDED_NS or more on average to take it.
+ * They shrink back one folio per uncontended drain.
+ */
+#define LRU_FBATCH_MAX		63
+#define LRU_FBATCH_CONTENDED_NS	NSEC_PER_USEC
+
+struct lru_fbatch {
+	unsigned char nr;
+	unsigned char size;	/* current capacity, 0 for PAGEVEC_SIZE */
+	struct folio *folios[LRU_FBATCH_MAX];
+};
+
+static inline unsigned int lru_fbatch_count(struct lru_fbatch *fbatch)
+{
+	return fbatch->nr;
+}
+
+static inline unsigned int lru_fbatch_size(struct lru_fbatch *fbatch)
+{
+	return fbatch->size ?: PAGEVEC_SIZE;
+}
+
+/* Returns the number of slots still available */
+static inline unsigned int lru_fbatch_add(struct lru_fbatch *fbatch,
+		struct folio *folio)
+{
+	fbatch->folios[fbatch->nr++] = folio;
+	return lru_fbatch_size(fbatch) - fbatch->nr;
+}
+
+/*
+ * Resize @fbatch after draining @nr folios with @locks lru_lock
+ * acquisitions that waited @wait_ns in total, and account for the
+ * acquisitions saved over draining the same folios PAGEVEC_SIZE at a time.
+ */
+static void lru_fbatch_resize(struct lru_fbatch *fbatch, unsigned int nr,
+		unsigned int locks, u64 wait_ns)
+{
+	unsigned int size = lru_fbatch_size(fbatch);
+	unsigned int saved;
+
+	if (!locks)
+		return;
+
+	if (wait_ns >= (u64)locks * LRU_FBATCH_CONTENDED_NS)
+		size = min(size * 2 + 1, LRU_FBATCH_MAX);
+	else if (size > PAGEVEC_SIZE)
+		size--;
+	fbatch->size = size;
+
+	saved = DIV_ROUND_UP(nr, PAGEVEC_SIZE);
+	if (saved > locks) {
+		saved -= locks;
+		count_vm_events(LRU_BATCH_LOCKS_SAVED, saved);
+		count_vm_events(LRU_BATCH_WAIT_NS_SAVED,
+				div_u64(wait_ns * saved, locks));
+	}
+}
+
 /* Protecting only lru_rotate.fbatch which requires disabling interrupts */
 struct lru_rotate {
 	local_lock_t lock;
-	struct folio_batch fbatch;
+	struct lru_fbatch fbatch;
 };
 static DEFINE_PER_CPU(struct lru_rotate, lru_rotate) = {
 	.lock = INIT_LOCAL_LOCK(lock),
@@ -61,12 +124,12 @@ static DEFINE_PER_CPU(struct lru_rotate, lru_rotate) = {
  */
 struct cpu_fbatches {
 	local_lock_t lock;
-	struct folio_batch lru_add;
-	struct folio_batch lru_deactivate_file;
-	struct folio_batch lru_deactivate;
-	struct folio_batch lru_lazyfree;
+	struct lru_fbatch lru_add;
+	struct lru_fbatch lru_deactivate_file;
+	struct lru_fbatch lru_deactivate;
+	struct lru_fbatch lru_lazyfree;
 #ifdef CONFIG_SMP
-	struct folio_batch activate;
+	struct lru_fbatch activate;
 #endif
 };
 static DEFINE_PER_CPU(struct cpu_fbatches, cpu_fbatches) = {
@@ -229,20 +292,32 @@ static void lru_add_fn(struct lruvec *lruvec, struct folio *folio)
 	trace_mm_lru_insertion(folio);
 }
 
-static void folio_batch_move_lru(struct folio_batch *fbatch, move_fn_t move_fn)
+static void lru_fbatch_move(struct lru_fbatch *fbatch, move_fn_t move_fn)
 {
 	int i;
 	struct lruvec *lruvec = NULL;
 	unsigned long flags = 0;
+	unsigned int locks = 0;
+	u64 wait_ns = 0;
 
-	for (i = 0; i < folio_batch_count(fbatch); i++) {
+	for (i = 0; i < lru_fbatch_count(fbatch); i++) {
 		struct folio *folio = fbatch->folios[i];
 
 		/* block memcg migration while the folio moves between lru */
 		if (move_fn != lru_add_fn && !folio_test_clear_lru(folio))
 			continue;
 
-		lruvec = folio_lruvec_relock_irqsave(folio, lruvec, &flags);
+		/* folio_lruvec_relock_irqsave(), timing the acquisition */
+		if (!lruvec || !folio_matches_lruvec(folio, lruvec)) {
+			u64 start;
+
+			if (lruvec)
+				unlock_page_lruvec_irqrestore(lruvec, flags);
+			start = local_clock();
+			lruvec = folio_lruvec_lock_irqsave(folio, &flags);
+			wait_ns += local_clock() - start;
+			locks++;
+		}
 		move_fn(lruvec, folio);
 
 		folio_set_lru(folio);
@@ -250,17 +325,18 @@ static void folio_batch_move_lru(struct folio_batch *fbatch, move_fn_t move_fn)
 
 	if (lruvec)
 		unlock_page_lruvec_irqrestore(lruvec, flags);
-	folios_put(fbatch->folios, folio_batch_count(fbatch));
-	folio_batch_init(fbatch);
+	folios_put(fbatch->folios, lru_fbatch_count(fbatch));
+	lru_fbatch_resize(fbatch, lru_fbatch_count(fbatch), locks, wait_ns);
+	fbatch->nr = 0;
 }
 
-static void folio_batch_add_and_move(struct folio_batch *fbatch,
+static void lru_fbatch_add_and_move(struct lru_fbatch *fbatch,
 		struct folio *folio, move_fn_t move_fn)
 {
-	if (folio_batch_add(fbatch, folio) && !folio_test_large(folio) &&
+	if (lru_fbatch_add(fbatch, folio) && !folio_test_large(folio) &&
 	    !lru_cache_disabled())
 		return;
-	folio_batch_move_lru(fbatch, move_fn);
+	lru_fbatch_move(fbatch, move_fn);
 }
 
 static void lru_move_tail_fn(struct lruvec *lruvec, struct folio *folio)
@@ -284,13 +360,13 @@ void folio_rotate_reclaimable(struct folio *folio)
 {
 	if (!folio_test_locked(folio) && !folio_test_dirty(folio) &&
 	    !folio_test_unevictable(folio) && folio_test_lru(folio)) {
-		struct folio_batch *fbatch;
+		struct lru_fbatch *fbatch;
 		unsigned long flags;
 
 		folio_get(folio);
 		local_lock_irqsave(&lru_rotate.lock, flags);
 		fbatch = this_cpu_ptr(&lru_rotate.fbatch);
-		folio_batch_add_and_move(fbatch, folio, lru_move_tail_fn);
+		lru_fbatch_add_and_move(fbatch, folio, lru_move_tail_fn);
 		local_unlock_irqrestore(&lru_rotate.lock, flags);
 	}
 }
@@ -360,22 +436,22 @@ static void folio_activate_fn(struct lruvec *lruvec, struct folio *folio)
 #ifdef CONFIG_SMP
 static void folio_activate_drain(int cpu)
 {
-	struct folio_batch *fbatch = &per_cpu(cpu_fbatches.activate, cpu);
+	struct lru_fbatch *fbatch = &per_cpu(cpu_fbatches.activate, cpu);
 
-	if (folio_batch_count(fbatch))
-		folio_batch_move_lru(fbatch, folio_activate_fn);
+	if (lru_fbatch_count(fbatch))
+		lru_fbatch_move(fbatch, folio_activate_fn);
 }
 
 void folio_activate(struct folio *folio)
 {
 	if (folio_test_lru(folio) && !folio_test_active(folio) &&
 	    !folio_test_unevictable(folio)) {
-		struct folio_batch *fbatch;
+		struct lru_fbatch *fbatch;
 
 		folio_get(folio);
 		local_lock(&cpu_fbatches.lock);
 		fbatch = this_cpu_ptr(&cpu_fbatches.activate);
-		folio_batch_add_and_move(fbatch, folio, folio_activate_fn);
+		lru_fbatch_add_and_move(fbatch, folio, folio_activate_fn);
 		local_unlock(&cpu_fbatches.lock);
 	}
 }
@@ -400,7 +476,7 @@ void folio_activate(struct folio *folio)
 
 static void __lru_cache_activate_folio(struct folio *folio)
 {
-	struct folio_batch *fbatch;
+	struct lru_fbatch *fbatch;
 	int i;
 
 	local_lock(&cpu_fbatches.lock);
@@ -416,7 +492,7 @@ static void __lru_cache_activate_folio(struct folio *folio)
 	 * a folio is marked active just after it is added to the inactive
 	 * list causing accounting errors and BUG_ON checks to trigger.
 	 */
-	for (i = folio_batch_count(fbatch) - 1; i >= 0; i--) {
+	for (i = lru_fbatch_count(fbatch) - 1; i >= 0; i--) {
 		struct folio *batch_folio = fbatch->folios[i];
 
 		if (batch_folio == folio) {
@@ -517,7 +593,7 @@ EXPORT_SYMBOL(folio_mark_accessed);
  */
 void folio_add_lru(struct folio *folio)
 {
-	struct folio_batch *fbatch;
+	struct lru_fbatch *fbatch;
 
 	VM_BUG_ON_FOLIO(folio_test_active(folio) &&
 			folio_test_unevictable(folio), folio);
@@ -531,7 +607,7 @@ void folio_add_lru(struct folio *folio)
 	folio_get(folio);
 	local_lock(&cpu_fbatches.lock);
 	fbatch = this_cpu_ptr(&cpu_fbatches.lru_add);
-	folio_batch_add_and_move(fbatch, folio, lru_add_fn);
+	lru_fbatch_add_and_move(fbatch, folio, lru_add_fn);
 	local_unlock(&cpu_fbatches.lock);
 }
 EXPORT_SYMBOL(folio_add_lru);
@@ -663,33 +739,33 @@ static void lru_lazyfree_fn(struct lruvec *lruvec, struct folio *folio)
 void lru_add_drain_cpu(int cpu)
 {
 	struct cpu_fbatches *fbatches = &per_cpu(cpu_fbatches, cpu);
-	struct folio_batch *fbatch = &fbatches->lru_add;
+	struct lru_fbatch *fbatch = &fbatches->lru_add;
 
-	if (folio_batch_count(fbatch))
-		folio_batch_move_lru(fbatch, lru_add_fn);
+	if (lru_fbatch_count(fbatch))
+		lru_fbatch_move(fbatch, lru_add_fn);
 
 	fbatch = &per_cpu(lru_rotate.fbatch, cpu);
 	/* Disabling interrupts below acts as a compiler barrier. */
-	if (data_race(folio_batch_count(fbatch))) {
+	if (data_race(lru_fbatch_count(fbatch))) {
 		unsigned long flags;
 
 		/* No harm done if a racing interrupt already did this */
 		local_lock_irqsave(&lru_rotate.lock, flags);
-		folio_batch_move_lru(fbatch, lru_move_tail_fn);
+		lru_fbatch_move(fbatch, lru_move_tail_fn);
 		local_unlock_irqrestore(&lru_rotate.lock, flags);
 	}
 
 	fbatch = &fbatches->lru_deactivate_file;
-	if (folio_batch_count(fbatch))
-		folio_batch_move_lru(fbatch, lru_deactivate_file_fn);
+	if (lru_fbatch_count(fbatch))
+		lru_fbatch_move(fbatch, lru_deactivate_file_fn);
 
 	fbatch = &fbatches->lru_deactivate;
-	if (folio_batch_count(fbatch))
-		folio_batch_move_lru(fbatch, lru_deactivate_fn);
+	if (lru_fbatch_count(fbatch))
+		lru_fbatch_move(fbatch, lru_deactivate_fn);
 
 	fbatch = &fbatches->lru_lazyfree;
-	if (folio_batch_count(fbatch))
-		folio_batch_move_lru(fbatch, lru_lazyfree_fn);
+	if (lru_fbatch_count(fbatch))
+		lru_fbatch_move(fbatch, lru_lazyfree_fn);
 
 	folio_activate_drain(cpu);
 }
@@ -706,7 +782,7 @@ void lru_add_drain_cpu(int cpu)
  */
 void deactivate_file_folio(struct folio *folio)
 {
-	struct folio_batch *fbatch;
+	struct lru_fbatch *fbatch;
 
 	/* Deactivating an unevictable folio will not accelerate reclaim */
 	if (folio_test_unevictable(folio))
@@ -715,7 +791,7 @@ void deactivate_file_folio(struct folio *folio)
 	folio_get(folio);
 	local_lock(&cpu_fbatches.lock);
 	fbatch = this_cpu_ptr(&cpu_fbatches.lru_deactivate_file);
-	folio_batch_add_and_move(fbatch, folio, lru_deactivate_file_fn);
+	lru_fbatch_add_and_move(fbatch, folio, lru_deactivate_file_fn);
 	local_unlock(&cpu_fbatches.lock);
 }
 
@@ -733,12 +809,12 @@ void deactivate_page(struct page *page)
 
 	if (folio_test_lru(folio) && !folio_test_unevictable(folio) &&
 	    (folio_test_active(folio) || lru_gen_enabled())) {
-		struct folio_batch *fbatch;
+		struct lru_fbatch *fbatch;
 
 		folio_get(folio);
 		local_lock(&cpu_fbatches.lock);
 		fbatch = this_cpu_ptr(&cpu_fbatches.lru_deactivate);
-		folio_batch_add_and_move(fbatch, folio, lru_deactivate_fn);
+		lru_fbatch_add_and_move(fbatch, folio, lru_deactivate_fn);
 		local_unlock(&cpu_fbatches.lock);
 	}
 }
@@ -757,12 +833,12 @@ void mark_page_lazyfree(struct page *page)
 	if (folio_test_lru(folio) && folio_test_anon(folio) &&
 	    folio_test_swapbacked(folio) && !folio_test_swapcache(folio) &&
 	    !folio_test_unevictable(folio)) {
-		struct folio_batch *fbatch;
+		struct lru_fbatch *fbatch;
 
 		folio_get(folio);
 		local_lock(&cpu_fbatches.lock);
 		fbatch = this_cpu_ptr(&cpu_fbatches.lru_lazyfree);
-		folio_batch_add_and_move(fbatch, folio, lru_lazyfree_fn);
+		lru_fbatch_add_and_move(fbatch, folio, lru_lazyfree_fn);
 		local_unlock(&cpu_fbatches.lock);
 	}
 }
@@ -813,12 +889,12 @@ static bool cpu_needs_drain(unsigned int cpu)
 	struct cpu_fbatches *fbatches = &per_cpu(cpu_fbatches, cpu);
 
 	/* Check these in order of likelihood that they're not zero */
-	return folio_batch_count(&fbatches->lru_add) ||
-		data_race(folio_batch_count(&per_cpu(lru_rotate.fbatch, cpu))) ||
-		folio_batch_count(&fbatches->lru_deactivate_file) ||
-		folio_batch_count(&fbatches->lru_deactivate) ||
-		folio_batch_count(&fbatches->lru_lazyfree) ||
-		folio_batch_count(&fbatches->activate) ||
+	return lru_fbatch_count(&fbatches->lru_add) ||
+		data_race(lru_fbatch_count(&per_cpu(lru_rotate.fbatch, cpu))) ||
+		lru_fbatch_count(&fbatches->lru_deactivate_file) ||
+		lru_fbatch_count(&fbatches->lru_deactivate) ||
+		lru_fbatch_count(&fbatches->lru_lazyfree) ||
+		lru_fbatch_count(&fbatches->activate) ||
 		need_mlock_page_drain(cpu) ||
 		has_bh_in_lru(cpu, NULL);
 }
@@ -1063,7 +1139,7 @@ EXPORT_SYMBOL(release_pages);
  * cache-warm and we want to give them back to the page allocator ASAP.
  *
  * So __pagevec_release() will drain those queues here.
- * folio_batch_move_lru() calls folios_put() directly to avoid
+ * lru_fbatch_move() calls folios_put() directly to avoid
  * mutual recursion.
  */
 void __pagevec_release(struct pagevec *pvec)
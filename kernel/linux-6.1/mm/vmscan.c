@@ -3183,6 +3183,29 @@ static int get_swappiness(struct lruvec *lruvec, struct scan_control *sc)
 	return mem_cgroup_swappiness(memcg);
 }
 
+/* scan idle memcgs at four times the rate of the others */
+#define LRU_GEN_COLD_SHIFT	2
+
+static unsigned int get_memcg_hint(struct mem_cgroup *memcg, unsigned long *min_ttl)
+{
+#ifdef CONFIG_MEMCG
+	unsigned long expires;
+
+	if (!memcg)
+		return LRU_GEN_HINT_NONE;
+
+	expires = READ_ONCE(memcg->lru_gen_hint.expires);
+	if (expires && time_is_before_eq_jiffies(expires))
+		return LRU_GEN_HINT_NONE;
+
+	*min_ttl = READ_ONCE(memcg->lru_gen_hint.min_ttl);
+
+	return READ_ONCE(memcg->lru_gen_hint.type);
+#else
+	return LRU_GEN_HINT_NONE;
+#endif
+}
+
 static int get_nr_gens(struct lruvec *lruvec, int type)
 {
 	return lruvec->lrugen.max_seq - lruvec->lrugen.min_seq[type] + 1;
@@ -4454,8 +4477,10 @@ static bool should_run_aging(struct lruvec *lruvec, unsigned long max_seq, unsig
 	unsigned long old = 0;
 	unsigned long young = 0;
 	unsigned long total = 0;
+	unsigned long min_ttl = 0;
 	struct lru_gen_struct *lrugen = &lruvec->lrugen;
 	struct mem_cgroup *memcg = lruvec_memcg(lruvec);
+	unsigned int hint = get_memcg_hint(memcg, &min_ttl);
 
 	for (type = !can_swap; type < ANON_AND_FILE; type++) {
 		unsigned long seq;
@@ -4477,7 +4502,12 @@ static bool should_run_aging(struct lruvec *lruvec, unsigned long max_seq, unsig
 	}
 
 	/* try to scrape all its memory if this memcg was deleted */
-	*nr_to_scan = mem_cgroup_online(memcg) ? (total >> sc->priority) : total;
+	if (!mem_cgroup_online(memcg))
+		*nr_to_scan = total;
+	else if (hint == LRU_GEN_HINT_COLD)
+		*nr_to_scan = total >> max(sc->priority - LRU_GEN_COLD_SHIFT, 0);
+	else
+		*nr_to_scan = total >> sc->priority;
 
 	/*
 	 * The aging tries to be lazy to reduce the overhead, while the eviction
@@ -4489,6 +4519,10 @@ static bool should_run_aging(struct lruvec *lruvec, unsigned long max_seq, unsig
 	if (min_seq[!can_swap] + MIN_NR_GENS < max_seq)
 		return false;
 
+	/* an idle memcg has no hot pages worth spreading out */
+	if (hint == LRU_GEN_HINT_COLD)
+		return true;
+
 	/*
 	 * It's also ideal to spread pages out evenly, i.e., 1/(MIN_NR_GENS+1)
 	 * of the total number of pages for each generation. A reasonable range
@@ -5109,7 +5143,9 @@ static unsigned long get_nr_to_scan(struct lruvec *lruvec, struct scan_control *
 				    bool can_swap, bool *need_aging)
 {
 	unsigned long nr_to_scan;
+	unsigned long min_ttl = 0;
 	struct mem_cgroup *memcg = lruvec_memcg(lruvec);
+	unsigned int hint = get_memcg_hint(memcg, &min_ttl);
 	DEFINE_MAX_SEQ(lruvec);
 	DEFINE_MIN_SEQ(lruvec);
 
@@ -5117,12 +5153,26 @@ static unsigned long get_nr_to_scan(struct lruvec *lruvec, struct scan_control *
 	    (mem_cgroup_below_low(memcg) && !sc->memcg_low_reclaim))
 		return 0;
 
+	/*
+	 * Until global reclaim gets to low priorities, leave the working set of
+	 * a hot memcg alone while its oldest generation is younger than min_ttl.
+	 * Reclaim against the memcg's own limits is not held up.
+	 */
+	if (hint == LRU_GEN_HINT_HOT && !cgroup_reclaim(sc) &&
+	    sc->priority > DEF_PRIORITY - 2) {
+		int gen = lru_gen_from_seq(min_seq[!can_swap]);
+		unsigned long birth = READ_ONCE(lruvec->lrugen.timestamps[gen]);
+
+		if (time_is_after_jiffies(birth + min_ttl))
+			return 0;
+	}
+
 	*need_aging = should_run_aging(lruvec, max_seq, min_seq, sc, can_swap, &nr_to_scan);
 	if (!*need_aging)
 		return nr_to_scan;
 
-	/* skip the aging path at the default priority */
-	if (sc->priority == DEF_PRIORITY)
+	/* skip the aging path at the default priority, unless the memcg is idle */
+	if (sc->priority == DEF_PRIORITY && hint != LRU_GEN_HINT_COLD)
 		goto done;
 
 	/* leave the work to lru_gen_age_node() */
@@ -5856,6 +5906,32 @@ void lru_gen_init_memcg(struct mem_cgroup *memcg)
 	spin_lock_init(&memcg->mm_list.lock);
 }
 
+/**
+ * lru_gen_set_hint - tell the multi-gen LRU what a memcg's working set will do
+ * @memcg: the memcg, not the root
+ * @type: the prediction, see enum lru_gen_hint
+ * @min_ttl: for LRU_GEN_HINT_HOT, how long its pages stay protected, in jiffies
+ * @timeout: how long the hint holds in jiffies, 0 for until replaced
+ *
+ * Hints apply to the memcg itself and not to its descendants. Callers that
+ * refresh hints periodically should pass a @timeout so stale predictions
+ * lapse on their own.
+ */
+int lru_gen_set_hint(struct mem_cgroup *memcg, enum lru_gen_hint type,
+		     unsigned long min_ttl, unsigned long timeout)
+{
+	if (type >= NR_LRU_GEN_HINTS || mem_cgroup_is_root(memcg))
+		return -EINVAL;
+
+	/* readers may see a mix of the old and the new hint, which is harmless */
+	WRITE_ONCE(memcg->lru_gen_hint.type, type);
+	WRITE_ONCE(memcg->lru_gen_hint.min_ttl, min_ttl);
+	WRITE_ONCE(memcg->lru_gen_hint.expires, timeout ? (jiffies + timeout) ?: 1 : 0);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lru_gen_set_hint);
+
 void lru_gen_exit_memcg(struct mem_cgroup *memcg)
 {
 	int i;
@@ -1292,6 +1292,8 @@ const char * const vmstat_text[] = {
 	"pageoutrun",
 
 	"pgrotated",
+	"lru_batch_locks_saved",
+	"lru_batch_wait_ns_saved",
 
 	"drop_pagecache",
 	"drop_slab",
@@ -1364,6 +1366,12 @@ const char * const vmstat_text[] = {
 	"thp_swpout",
 	"thp_swpout_fallback",
 #endif
+#ifdef CONFIG_HUGEPAGE_PREZERO
+	"prezero_thp_fill",
+	"prezero_thp_fault",
+	"prezero_htlb_zeroed",
+	"prezero_htlb_fault",
+#endif
 #ifdef CONFIG_MEMORY_BALLOON
 	"balloon_inflate",
 	"balloon_deflate",
@@ -1396,6 +1404,12 @@ const char * const vmstat_text[] = {
 	"direct_map_level2_splits",
 	"direct_map_level3_splits",
 #endif
+#ifdef CONFIG_PER_VMA_LOCK
+	"vma_lock_success",
+	"vma_lock_abort",
+	"vma_lock_retry",
+	"vma_lock_miss",
+#endif
 #endif /* CONFIG_VM_EVENT_COUNTERS || CONFIG_MEMCG */
 };
 #endif /* CONFIG_PROC_FS || CONFIG_SYSFS || CONFIG_NUMA || CONFIG_MEMCG */
@@ -1339,6 +1339,31 @@ size_t zs_huge_class_size(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_huge_class_size);
 
+/**
+ * zs_lookup_class_index() - Returns index of the zsmalloc &size_class
+ *                           that holds objects of the provided size.
+ * @pool: zsmalloc pool to use
+ * @size: object size
+ *
+ * Two sizes that map to the same class take the same amount of pool
+ * memory, which lets callers tell whether a smaller object actually
+ * saves anything.
+ *
+ * Context: Any context.
+ *
+ * Return: the index of the zsmalloc &size_class that holds objects of the
+ * provided size.
+ */
+unsigned int zs_lookup_class_index(struct zs_pool *pool, unsigned int size)
+{
+	struct size_class *class;
+
+	class = pool->size_class[get_size_class_index(size)];
+
+	return class->index;
+}
+EXPORT_SYMBOL_GPL(zs_lookup_class_index);
+
 static unsigned long obj_malloc(struct zs_pool *pool,
 				struct zspage *zspage, unsigned long handle)
 {
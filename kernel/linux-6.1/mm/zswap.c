@@ -22,11 +22,14 @@
 #include <linux/atomic.h>
 #include <linux/frontswap.h>
 #include <linux/rbtree.h>
+#include <linux/sched/clock.h>
 #include <linux/swap.h>
 #include <linux/crypto.h>
 #include <linux/scatterlist.h>
 #include <linux/mempool.h>
 #include <linux/zpool.h>
+#include <linux/zswap.h>
+#include <linux/memcontrol.h>
 #include <crypto/acompress.h>
 
 #include <linux/mm_types.h>
@@ -252,6 +255,29 @@ static bool zswap_can_accept(void)
 			DIV_ROUND_UP(zswap_pool_total_size, PAGE_SIZE);
 }
 
+/**
+ * zswap_can_store - check if zswap would take more pages of a cgroup
+ * @memcg: the memory cgroup the pages are charged to, or NULL
+ *
+ * For proactive reclaim that is only worth it while the pages end up
+ * compressed: once this fails, swap-outs would go to the swap device,
+ * because zswap is off or full, @memcg is at its memory.zswap.max, or
+ * compressing its pages used up its memory.zswap.budget for now.
+ */
+bool zswap_can_store(struct mem_cgroup *memcg)
+{
+	if (!zswap_enabled || zswap_is_full())
+		return false;
+	if (READ_ONCE(zswap_pool_reached_full) && !zswap_can_accept())
+		return false;
+	if (!memcg)
+		return get_nr_swap_pages() > 0;
+
+	return mem_cgroup_get_nr_swap_pages(memcg) > 0 &&
+	       mem_cgroup_may_zswap(memcg) && mem_cgroup_zswap_budget_left(memcg);
+}
+EXPORT_SYMBOL_GPL(zswap_can_store);
+
 static void zswap_update_total_size(void)
 {
 	struct zswap_pool *pool;
@@ -1128,6 +1154,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	u8 *src, *dst;
 	struct zswap_header zhdr = { .swpentry = swp_entry(type, offset) };
 	gfp_t gfp;
+	u64 start;
 
 	/* THP isn't supported */
 	if (PageTransHuge(page)) {
@@ -1223,8 +1250,11 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	 * but in different threads running on different cpu, we have different
 	 * acomp instance, so multiple threads can do (de)compression in parallel.
 	 */
+	start = local_clock();
 	ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
 	dlen = acomp_ctx->req->dlen;
+	if (objcg)
+		obj_cgroup_charge_zswap_time(objcg, local_clock() - start);
 
 	if (ret) {
 		ret = -EINVAL;
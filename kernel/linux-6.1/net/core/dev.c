@@ -6298,6 +6298,60 @@ out:
 }
 EXPORT_SYMBOL(napi_busy_loop);
 
+/**
+ * napi_suspend_irqs - keep device interrupts off while busy polling
+ * @napi_id: NAPI instance being busy polled
+ *
+ * Called by a busy polling application that found events and is going to
+ * process them before polling again.  With prefer_busy_poll, the final
+ * poll of napi_busy_loop() deferred the device interrupts by the
+ * gro_flush_timeout; this stretches that deferral to the longer
+ * irq_suspend_timeout of the device, which acts as a safety net should
+ * the application not come back.  Does nothing if irq_suspend_timeout is
+ * zero.
+ */
+void napi_suspend_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi) {
+		unsigned long timeout = READ_ONCE(napi->dev->irq_suspend_timeout);
+
+		if (timeout)
+			hrtimer_start(&napi->timer, ns_to_ktime(timeout),
+				      HRTIMER_MODE_REL_PINNED);
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * napi_resume_irqs - end an interrupt suspension early
+ * @napi_id: NAPI instance being busy polled
+ *
+ * Called when busy polling ran out of work.  Schedules the NAPI instance
+ * so that its next napi_complete_done() re-enables the device interrupts.
+ */
+void napi_resume_irqs(unsigned int napi_id)
+{
+	struct napi_struct *napi;
+
+	rcu_read_lock();
+	napi = napi_by_id(napi_id);
+	if (napi) {
+		/* If irq_suspend_timeout was cleared since napi_suspend_irqs(),
+		 * the timer still runs out and napi_watchdog() resumes irqs.
+		 */
+		if (READ_ONCE(napi->dev->irq_suspend_timeout)) {
+			local_bh_disable();
+			napi_schedule(napi);
+			local_bh_enable();
+		}
+	}
+	rcu_read_unlock();
+}
+
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 static void napi_hash_add(struct napi_struct *napi)
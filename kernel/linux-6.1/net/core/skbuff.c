@@ -2630,14 +2630,20 @@ static struct page *linear_to_page(struct page *page, unsigned int *len,
 	return pfrag->page;
 }
 
+/*
+ * Frags of one folio that follow each other go into one pipe buffer even
+ * when they sit on different pages of it, as those of a page pool or a
+ * GRO'ed skb often do, so splice moves a large folio per buffer.
+ */
 static bool spd_can_coalesce(const struct splice_pipe_desc *spd,
 			     struct page *page,
 			     unsigned int offset)
 {
 	return	spd->nr_pages &&
-		spd->pages[spd->nr_pages - 1] == page &&
-		(spd->partial[spd->nr_pages - 1].offset +
-		 spd->partial[spd->nr_pages - 1].len == offset);
+		page_span_contiguous(spd->pages[spd->nr_pages - 1],
+				     spd->partial[spd->nr_pages - 1].offset,
+				     spd->partial[spd->nr_pages - 1].len,
+				     page, offset);
 }
 
 /*
@@ -4554,14 +4560,14 @@ void __init skb_init(void)
 	skbuff_head_cache = kmem_cache_create_usercopy("skbuff_head_cache",
 					      sizeof(struct sk_buff),
 					      0,
-					      SLAB_HWCACHE_ALIGN|SLAB_PANIC,
+					      SLAB_HWCACHE_ALIGN|SLAB_PANIC|SLAB_MAGAZINE,
 					      offsetof(struct sk_buff, cb),
 					      sizeof_field(struct sk_buff, cb),
 					      NULL);
 	skbuff_fclone_cache = kmem_cache_create("skbuff_fclone_cache",
 						sizeof(struct sk_buff_fclones),
 						0,
-						SLAB_HWCACHE_ALIGN|SLAB_PANIC,
+						SLAB_HWCACHE_ALIGN|SLAB_PANIC|SLAB_MAGAZINE,
 						NULL);
 	skb_extensions_init();
 }
@@ -115,6 +115,7 @@
 #include <linux/memcontrol.h>
 #include <linux/prefetch.h>
 #include <linux/compat.h>
+#include <linux/local_lock.h>
 
 #include <linux/uaccess.h>
 
@@ -2844,6 +2845,76 @@ static void sk_leave_memory_pressure(struct sock *sk)
 
 DEFINE_STATIC_KEY_FALSE(net_high_order_alloc_disable_key);
 
+/*
+ * Per-cpu recycling of the high order pages behind page frags, the
+ * transmit side counterpart of the page_pool rings drivers use on
+ * receive.  A page that skb_page_frag_refill() moves on from while skbs
+ * still reference it is parked here with its reference, instead of being
+ * released.  Once TX completion has freed those skbs the page count is
+ * back to our single reference, and the page is handed out again without
+ * a trip to the page allocator.  The oldest page is released when a slot
+ * is needed, which bounds the cache to SKB_FRAG_CACHE_SIZE pages per cpu.
+ */
+#define SKB_FRAG_CACHE_SIZE	8
+
+struct skb_frag_cache {
+	local_lock_t lock;
+	unsigned int next;
+	struct page *pages[SKB_FRAG_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct skb_frag_cache, skb_frag_cache) = {
+	.lock = INIT_LOCAL_LOCK(lock),
+};
+
+static struct page *skb_frag_cache_get(void)
+{
+	struct skb_frag_cache *fc;
+	struct page *page = NULL;
+	unsigned long flags;
+	unsigned int i;
+
+	local_lock_irqsave(&skb_frag_cache.lock, flags);
+	fc = this_cpu_ptr(&skb_frag_cache);
+	for (i = 0; i < SKB_FRAG_CACHE_SIZE; i++) {
+		struct page *p = fc->pages[i];
+
+		/* Only we can hold a reference once the count is one */
+		if (p && page_ref_count(p) == 1 && page_to_nid(p) == numa_mem_id()) {
+			fc->pages[i] = NULL;
+			page = p;
+			break;
+		}
+	}
+	local_unlock_irqrestore(&skb_frag_cache.lock, flags);
+
+	return page;
+}
+
+/* Takes over the caller's reference on @page */
+static void skb_frag_cache_put(struct page *page)
+{
+	struct skb_frag_cache *fc;
+	struct page *old;
+	unsigned long flags;
+
+	if (!SKB_FRAG_PAGE_ORDER || compound_order(page) != SKB_FRAG_PAGE_ORDER ||
+	    page_is_pfmemalloc(page)) {
+		put_page(page);
+		return;
+	}
+
+	local_lock_irqsave(&skb_frag_cache.lock, flags);
+	fc = this_cpu_ptr(&skb_frag_cache);
+	old = fc->pages[fc->next];
+	fc->pages[fc->next] = page;
+	fc->next = (fc->next + 1) % SKB_FRAG_CACHE_SIZE;
+	local_unlock_irqrestore(&skb_frag_cache.lock, flags);
+
+	if (old)
+		put_page(old);
+}
+
 /**
  * skb_page_frag_refill - check that a page_frag contains enough room
  * @sz: minimum size of the fragment we want to get
@@ -2863,12 +2934,18 @@ bool skb_page_frag_refill(unsigned int sz, struct page_frag *pfrag, gfp_t gfp)
 		}
 		if (pfrag->offset + sz <= pfrag->size)
 			return true;
-		put_page(pfrag->page);
+		skb_frag_cache_put(pfrag->page);
 	}
 
 	pfrag->offset = 0;
 	if (SKB_FRAG_PAGE_ORDER &&
 	    !static_branch_unlikely(&net_high_order_alloc_disable_key)) {
+		pfrag->page = skb_frag_cache_get();
+		if (pfrag->page) {
+			pfrag->size = PAGE_SIZE << SKB_FRAG_PAGE_ORDER;
+			return true;
+		}
+
 		/* Avoid direct reclaim but allow kswapd to wake */
 		pfrag->page = alloc_pages((gfp & ~__GFP_DIRECT_RECLAIM) |
 					  __GFP_COMP | __GFP_NOWARN |
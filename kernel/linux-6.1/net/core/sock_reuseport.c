@@ -20,6 +20,9 @@ DEFINE_SPINLOCK(reuseport_lock);
 static DEFINE_IDA(reuseport_ida);
 static int reuseport_resurrect(struct sock *sk, struct sock_reuseport *old_reuse,
 			       struct sock_reuseport *reuse, bool bind_inany);
+static int reuseport_sock_index(struct sock *sk,
+				const struct sock_reuseport *reuse,
+				bool closed);
 
 void reuseport_has_conns_set(struct sock *sk)
 {
@@ -61,6 +64,64 @@ static void reuseport_put_incoming_cpu(struct sock *sk, struct sock_reuseport *r
 		__reuseport_put_incoming_cpu(reuse);
 }
 
+/* Once a group has sockets with SO_INCOMING_CPU, cpu_socks points each CPU
+ * at one listening socket steered to it, so that selecting by CPU does not
+ * walk the group. A NULL slot means no listener asked for that CPU. If the
+ * array cannot be allocated, lookups keep walking the group.
+ */
+static void reuseport_steer_add(struct sock *sk, struct sock_reuseport *reuse)
+{
+	struct sock **cpu_socks = reuse->cpu_socks;
+	int cpu = sk->sk_incoming_cpu;
+	int i;
+
+	if (cpu < 0 || cpu >= nr_cpu_ids)
+		return;
+
+	if (cpu_socks) {
+		if (!cpu_socks[cpu])
+			WRITE_ONCE(cpu_socks[cpu], sk);
+		return;
+	}
+
+	cpu_socks = kcalloc(nr_cpu_ids, sizeof(*cpu_socks), GFP_ATOMIC);
+	if (!cpu_socks)
+		return;
+
+	for (i = 0; i < reuse->num_socks; i++) {
+		struct sock *sk2 = reuse->socks[i];
+
+		cpu = sk2->sk_incoming_cpu;
+		if (cpu >= 0 && cpu < nr_cpu_ids && !cpu_socks[cpu])
+			cpu_socks[cpu] = sk2;
+	}
+
+	/* Paired with smp_load_acquire() in reuseport_select_sock_by_hash(). */
+	smp_store_release(&reuse->cpu_socks, cpu_socks);
+}
+
+/* sk no longer listens for @cpu: hand its slot to another listener, if any */
+static void reuseport_steer_del(struct sock *sk, struct sock_reuseport *reuse,
+				int cpu)
+{
+	struct sock *next = NULL;
+	int i;
+
+	if (!reuse->cpu_socks || cpu < 0 || cpu >= nr_cpu_ids ||
+	    reuse->cpu_socks[cpu] != sk)
+		return;
+
+	for (i = 0; i < reuse->num_socks; i++) {
+		if (reuse->socks[i] != sk &&
+		    reuse->socks[i]->sk_incoming_cpu == cpu) {
+			next = reuse->socks[i];
+			break;
+		}
+	}
+
+	WRITE_ONCE(reuse->cpu_socks[cpu], next);
+}
+
 void reuseport_update_incoming_cpu(struct sock *sk, int val)
 {
 	struct sock_reuseport *reuse;
@@ -97,6 +158,11 @@ void reuseport_update_incoming_cpu(struct sock *sk, int val)
 	else if (old_sk_incoming_cpu >= 0 && val < 0)
 		__reuseport_put_incoming_cpu(reuse);
 
+	if (reuseport_sock_index(sk, reuse, false) >= 0) {
+		reuseport_steer_del(sk, reuse, old_sk_incoming_cpu);
+		reuseport_steer_add(sk, reuse);
+	}
+
 out:
 	spin_unlock_bh(&reuseport_lock);
 }
@@ -129,6 +195,7 @@ static void __reuseport_add_sock(struct sock *sk,
 	smp_wmb();
 	reuse->num_socks++;
 	reuseport_get_incoming_cpu(sk, reuse);
+	reuseport_steer_add(sk, reuse);
 }
 
 static bool __reuseport_detach_sock(struct sock *sk,
@@ -142,6 +209,7 @@ static bool __reuseport_detach_sock(struct sock *sk,
 	reuse->socks[i] = reuse->socks[reuse->num_socks - 1];
 	reuse->num_socks--;
 	reuseport_put_incoming_cpu(sk, reuse);
+	reuseport_steer_del(sk, reuse, sk->sk_incoming_cpu);
 
 	return true;
 }
@@ -235,6 +303,7 @@ int reuseport_alloc(struct sock *sk, bool bind_inany)
 	reuse->socks[0] = sk;
 	reuse->num_socks = 1;
 	reuseport_get_incoming_cpu(sk, reuse);
+	reuseport_steer_add(sk, reuse);
 	rcu_assign_pointer(sk->sk_reuseport_cb, reuse);
 
 out:
@@ -279,6 +348,7 @@ static struct sock_reuseport *reuseport_grow(struct sock_reuseport *reuse)
 	more_reuse->bind_inany = reuse->bind_inany;
 	more_reuse->has_conns = reuse->has_conns;
 	more_reuse->incoming_cpu = reuse->incoming_cpu;
+	more_reuse->cpu_socks = reuse->cpu_socks;
 
 	memcpy(more_reuse->socks, reuse->socks,
 	       reuse->num_socks * sizeof(struct sock *));
@@ -307,6 +377,7 @@ static void reuseport_free_rcu(struct rcu_head *head)
 	reuse = container_of(head, struct sock_reuseport, rcu);
 	sk_reuseport_prog_free(rcu_dereference_protected(reuse->prog, 1));
 	ida_free(&reuseport_ida, reuse->reuseport_id);
+	kfree(reuse->cpu_socks);
 	kfree(reuse);
 }
 
@@ -525,23 +596,43 @@ static struct sock *run_bpf_filter(struct sock_reuseport *reuse, u16 socks,
 	return reuse->socks[index];
 }
 
+/* Prefer a listener steered to @cpu with SO_INCOMING_CPU, then the hash */
 static struct sock *reuseport_select_sock_by_hash(struct sock_reuseport *reuse,
-						  u32 hash, u16 num_socks)
+						  u32 hash, u16 num_socks,
+						  int cpu)
 {
 	struct sock *first_valid_sk = NULL;
+	struct sock **cpu_socks;
+	bool steer;
 	int i, j;
 
+	/* Paired with WRITE_ONCE() in __reuseport_(get|put)_incoming_cpu(). */
+	steer = READ_ONCE(reuse->incoming_cpu);
+	if (steer) {
+		/* Paired with smp_store_release() in reuseport_steer_add(). */
+		cpu_socks = smp_load_acquire(&reuse->cpu_socks);
+		if (cpu_socks) {
+			struct sock *sk = NULL;
+
+			if (cpu >= 0 && cpu < nr_cpu_ids)
+				sk = READ_ONCE(cpu_socks[cpu]);
+			if (!sk)
+				steer = false;	/* nobody listens for this CPU */
+			else if (sk->sk_state != TCP_ESTABLISHED)
+				return sk;
+		}
+	}
+
 	i = j = reciprocal_scale(hash, num_socks);
 	do {
 		struct sock *sk = reuse->socks[i];
 
 		if (sk->sk_state != TCP_ESTABLISHED) {
-			/* Paired with WRITE_ONCE() in __reuseport_(get|put)_incoming_cpu(). */
-			if (!READ_ONCE(reuse->incoming_cpu))
+			if (!steer)
 				return sk;
 
 			/* Paired with WRITE_ONCE() in reuseport_update_incoming_cpu(). */
-			if (READ_ONCE(sk->sk_incoming_cpu) == raw_smp_processor_id())
+			if (READ_ONCE(sk->sk_incoming_cpu) == cpu)
 				return sk;
 
 			if (!first_valid_sk)
@@ -600,7 +691,8 @@ struct sock *reuseport_select_sock(struct sock *sk,
 select_by_hash:
 		/* no bpf or invalid bpf result: fall back to hash usage */
 		if (!sk2)
-			sk2 = reuseport_select_sock_by_hash(reuse, hash, socks);
+			sk2 = reuseport_select_sock_by_hash(reuse, hash, socks,
+							    raw_smp_processor_id());
 	}
 
 out:
@@ -628,6 +720,7 @@ struct sock *reuseport_migrate_sock(struct sock *sk,
 	struct bpf_prog *prog;
 	u16 socks;
 	u32 hash;
+	int cpu;
 
 	rcu_read_lock();
 
@@ -663,8 +756,15 @@ struct sock *reuseport_migrate_sock(struct sock *sk,
 		kfree_skb(skb);
 
 select_by_hash:
-	if (!nsk)
-		nsk = reuseport_select_sock_by_hash(reuse, hash, socks);
+	if (!nsk) {
+		/* Keep the child on the CPU its packets arrive on, rather
+		 * than the one running close() or shutdown() on sk.
+		 */
+		cpu = READ_ONCE(migrating_sk->sk_incoming_cpu);
+		if (cpu < 0)
+			cpu = raw_smp_processor_id();
+		nsk = reuseport_select_sock_by_hash(reuse, hash, socks, cpu);
+	}
 
 	if (IS_ERR_OR_NULL(nsk) || unlikely(!refcount_inc_not_zero(&nsk->sk_refcnt))) {
 		nsk = NULL;
@@ -2430,6 +2430,43 @@ static int tcp_inq_hint(struct sock *sk)
 	return inq;
 }
 
+#ifdef CONFIG_MMU
+/**
+ * tcp_zerocopy_receive_kern - TCP_ZEROCOPY_RECEIVE for in-kernel callers
+ * @sk: the TCP socket
+ * @zc: request, as for the socket option, updated with the result
+ *
+ * Maps received data into the tcp_mmap() area at zc->address of the
+ * current mm, and fills in every output field of @zc, as getsockopt()
+ * does when given all of struct tcp_zerocopy_receive.  Used by the
+ * io_uring IORING_OP_RECV_ZC opcode.
+ */
+int tcp_zerocopy_receive_kern(struct sock *sk, struct tcp_zerocopy_receive *zc)
+{
+	struct scm_timestamping_internal tss;
+	int err;
+
+	if (zc->reserved)
+		return -EINVAL;
+	if (zc->msg_flags & ~(TCP_VALID_ZC_MSG_FLAGS))
+		return -EINVAL;
+
+	lock_sock(sk);
+	err = tcp_zerocopy_receive(sk, zc, &tss);
+	release_sock(sk);
+
+	if (zc->msg_flags & TCP_CMSG_TS)
+		tcp_zc_finalize_rx_tstamp(sk, zc, &tss);
+	else
+		zc->msg_flags = 0;
+	if (!err)
+		zc->err = sock_error(sk);
+	zc->inq = tcp_inq_hint(sk);
+	return err;
+}
+EXPORT_SYMBOL_GPL(tcp_zerocopy_receive_kern);
+#endif
+
 /*
  *	This routine copies from a sock struct into the user buffer.
  *
@@ -1139,6 +1139,69 @@ static void bbr_set_state(struct sock *sk, u8 new_state)
 	}
 }
 
+/* bbr_history: BBR starting from the delivery rate that earlier connections
+ * to the same destination measured, kept in the TCP metrics cache, instead
+ * of the initial cwnd. Short flows then send at the path rate from the
+ * first round trip rather than spending several of them in STARTUP. The
+ * seed is only an opening bid: it enters the max bw filter like any other
+ * sample and ages out of it after bbr_bw_rtts rounds unless confirmed, and
+ * STARTUP still probes for more. A connection saves its estimate back once
+ * it has filled the pipe, and again when it is closed.
+ */
+static void bbr_history_save(struct sock *sk)
+{
+	struct bbr *bbr = inet_csk_ca(sk);
+	u64 rate;
+
+	if (!bbr_full_bw_reached(sk) || bbr->min_rtt_us == ~0U)
+		return;
+
+	rate = (u64)bbr_bw(sk) * tcp_sk(sk)->mss_cache * USEC_PER_SEC >> BW_SCALE;
+	if (rate)
+		tcp_rate_cache_set(sk, rate, bbr->min_rtt_us);
+}
+
+static void bbr_history_init(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bbr *bbr = inet_csk_ca(sk);
+	u32 min_rtt_us, cwnd;
+	u64 rate, bw;
+
+	bbr_init(sk);
+
+	if (!tp->mss_cache || !tcp_rate_cache_get(sk, &rate, &min_rtt_us))
+		return;
+
+	/* Bytes per second to packets per usec << BW_SCALE */
+	bw = div64_u64(rate << BW_SCALE, (u64)tp->mss_cache * USEC_PER_SEC);
+	bw = min_t(u64, bw, U32_MAX);
+	if (!bw)
+		return;
+
+	/* The handshake RTT, if there was one, is fresher than the cache */
+	if (bbr->min_rtt_us == ~0U)
+		bbr->min_rtt_us = min_rtt_us;
+
+	minmax_reset(&bbr->bw, bbr->rtt_cnt, bw);
+	bbr->full_bw = bw;
+
+	cwnd = bbr_bdp(sk, bw, BBR_UNIT);
+	tcp_snd_cwnd_set(tp, clamp(cwnd, tcp_snd_cwnd(tp), tp->snd_cwnd_clamp));
+	sk->sk_pacing_rate = bbr_bw_to_pacing_rate(sk, bw, BBR_UNIT);
+	bbr->has_seen_rtt = 1;
+}
+
+static void bbr_history_main(struct sock *sk, const struct rate_sample *rs)
+{
+	bool full_bw_reached = bbr_full_bw_reached(sk);
+
+	bbr_main(sk, rs);
+
+	if (!full_bw_reached && bbr_full_bw_reached(sk))
+		bbr_history_save(sk);
+}
+
 static struct tcp_congestion_ops tcp_bbr_cong_ops __read_mostly = {
 	.flags		= TCP_CONG_NON_RESTRICTED,
 	.name		= "bbr",
@@ -1154,6 +1217,22 @@ static struct tcp_congestion_ops tcp_bbr_cong_ops __read_mostly = {
 	.set_state	= bbr_set_state,
 };
 
+static struct tcp_congestion_ops tcp_bbr_history_cong_ops __read_mostly = {
+	.flags		= TCP_CONG_NON_RESTRICTED,
+	.name		= "bbr_history",
+	.owner		= THIS_MODULE,
+	.init		= bbr_history_init,
+	.release	= bbr_history_save,
+	.cong_control	= bbr_history_main,
+	.sndbuf_expand	= bbr_sndbuf_expand,
+	.undo_cwnd	= bbr_undo_cwnd,
+	.cwnd_event	= bbr_cwnd_event,
+	.ssthresh	= bbr_ssthresh,
+	.min_tso_segs	= bbr_min_tso_segs,
+	.get_info	= bbr_get_info,
+	.set_state	= bbr_set_state,
+};
+
 BTF_SET8_START(tcp_bbr_check_kfunc_ids)
 #ifdef CONFIG_X86
 #ifdef CONFIG_DYNAMIC_FTRACE
@@ -1183,11 +1262,18 @@ static int __init bbr_register(void)
 	ret = register_btf_kfunc_id_set(BPF_PROG_TYPE_STRUCT_OPS, &tcp_bbr_kfunc_set);
 	if (ret < 0)
 		return ret;
-	return tcp_register_congestion_control(&tcp_bbr_cong_ops);
+	ret = tcp_register_congestion_control(&tcp_bbr_cong_ops);
+	if (ret)
+		return ret;
+	ret = tcp_register_congestion_control(&tcp_bbr_history_cong_ops);
+	if (ret)
+		tcp_unregister_congestion_control(&tcp_bbr_cong_ops);
+	return ret;
 }
 
 static void __exit bbr_unregister(void)
 {
+	tcp_unregister_congestion_control(&tcp_bbr_history_cong_ops);
 	tcp_unregister_congestion_control(&tcp_bbr_cong_ops);
 }
 
@@ -1200,3 +1286,4 @@ MODULE_AUTHOR("Yuchung Cheng <ycheng@google.com>");
 MODULE_AUTHOR("Soheil Hassas Yeganeh <soheil@google.com>");
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("TCP BBR (Bottleneck Bandwidth and RTT)");
+MODULE_ALIAS("tcp_bbr_history");
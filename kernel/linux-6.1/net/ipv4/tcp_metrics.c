@@ -33,6 +33,11 @@ struct tcp_fastopen_metrics {
 	struct	tcp_fastopen_cookie	cookie;
 };
 
+struct tcp_rate_metrics {
+	u64	rate;			/* Delivery rate, bytes per second */
+	u32	min_rtt_us;		/* Min RTT it was measured with */
+};
+
 /* TCP_METRIC_MAX includes 2 extra fields for userspace compatibility
  * Kernel only stores RTT and RTTVAR in usec resolution
  */
@@ -47,6 +52,7 @@ struct tcp_metrics_block {
 	u32				tcpm_lock;
 	u32				tcpm_vals[TCP_METRIC_MAX_KERNEL + 1];
 	struct tcp_fastopen_metrics	tcpm_fastopen;
+	struct tcp_rate_metrics		tcpm_rate;
 
 	struct rcu_head			rcu_head;
 };
@@ -94,6 +100,7 @@ static unsigned int		tcp_metrics_hash_log __read_mostly;
 
 static DEFINE_SPINLOCK(tcp_metrics_lock);
 static DEFINE_SEQLOCK(fastopen_seqlock);
+static DEFINE_SEQLOCK(rate_seqlock);
 
 static void tcpm_suck_dst(struct tcp_metrics_block *tm,
 			  const struct dst_entry *dst,
@@ -129,6 +136,12 @@ static void tcpm_suck_dst(struct tcp_metrics_block *tm,
 		       dst_metric_raw(dst, RTAX_CWND));
 	tcp_metric_set(tm, TCP_METRIC_REORDERING,
 		       dst_metric_raw(dst, RTAX_REORDERING));
+
+	write_seqlock_bh(&rate_seqlock);
+	tm->tcpm_rate.rate = 0;
+	tm->tcpm_rate.min_rtt_us = 0;
+	write_sequnlock_bh(&rate_seqlock);
+
 	if (fastopen_clear) {
 		write_seqlock(&fastopen_seqlock);
 		tm->tcpm_fastopen.mss = 0;
@@ -613,6 +626,55 @@ void tcp_fastopen_cache_set(struct sock *sk, u16 mss,
 	rcu_read_unlock();
 }
 
+/* Delivery rate history, for congestion control to start a connection
+ * from what the previous ones to the same destination achieved.
+ */
+bool tcp_rate_cache_get(struct sock *sk, u64 *rate, u32 *min_rtt_us)
+{
+	struct dst_entry *dst = __sk_dst_get(sk);
+	struct tcp_metrics_block *tm;
+	bool ret = false;
+
+	if (!dst)
+		return false;
+	rcu_read_lock();
+	tm = tcp_get_metrics(sk, dst, false);
+	if (tm) {
+		struct tcp_rate_metrics *trm = &tm->tcpm_rate;
+		unsigned int seq;
+
+		do {
+			seq = read_seqbegin(&rate_seqlock);
+			*rate = trm->rate;
+			*min_rtt_us = trm->min_rtt_us;
+		} while (read_seqretry(&rate_seqlock, seq));
+		ret = *rate && *min_rtt_us;
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+
+void tcp_rate_cache_set(struct sock *sk, u64 rate, u32 min_rtt_us)
+{
+	struct dst_entry *dst = __sk_dst_get(sk);
+	struct tcp_metrics_block *tm;
+
+	if (READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_nometrics_save) || !dst)
+		return;
+	rcu_read_lock();
+	tm = tcp_get_metrics(sk, dst, true);
+	if (tm) {
+		struct tcp_rate_metrics *trm = &tm->tcpm_rate;
+
+		write_seqlock_bh(&rate_seqlock);
+		trm->rate = rate;
+		trm->min_rtt_us = min_rtt_us;
+		write_sequnlock_bh(&rate_seqlock);
+	}
+	rcu_read_unlock();
+}
+
 static struct genl_family tcp_metrics_nl_family;
 
 static const struct nla_policy tcp_metrics_nl_policy[TCP_METRICS_ATTR_MAX + 1] = {
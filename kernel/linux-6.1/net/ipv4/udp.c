@@ -2738,11 +2738,12 @@ int udp_lib_setsockopt(struct sock *sk, int level, int optname,
 
 	case UDP_GRO:
 
-		/* when enabling GRO, accept the related GSO packet type */
+		/* when enabling GRO, accept the related GSO packet types */
 		if (valbool)
 			udp_tunnel_encap_enable(sk);
 		udp_assign_bit(GRO_ENABLED, sk, valbool);
 		udp_assign_bit(ACCEPT_L4, sk, valbool);
+		udp_assign_bit(ACCEPT_FRAGLIST, sk, valbool);
 		break;
 
 	/*
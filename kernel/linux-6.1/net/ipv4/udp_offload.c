@@ -597,8 +597,15 @@ struct sk_buff *udp_gro_receive(struct list_head *head, struct sk_buff *skb,
 		if (skb->encapsulation)
 			goto out;
 
+		/* Sockets with UDP_GRO accept fraglist packets as they are.
+		 * Chaining the datagrams costs less than merging them into
+		 * frags and is not bound by MAX_SKB_FRAGS, which small QUIC
+		 * datagrams otherwise hit long before UDP_GRO_CNT_MAX.  The
+		 * length rules of udp_gro_receive_segment() still apply, so
+		 * the chain can be read back with the UDP_GRO gso_size.
+		 */
 		if (skb->dev->features & NETIF_F_GRO_FRAGLIST)
-			NAPI_GRO_CB(skb)->is_flist = sk ? !udp_test_bit(GRO_ENABLED, sk) : 1;
+			NAPI_GRO_CB(skb)->is_flist = 1;
 
 		if ((!sk && (skb->dev->features & NETIF_F_GRO_UDP_FWD)) ||
 		    (sk && udp_test_bit(GRO_ENABLED, sk)) || NAPI_GRO_CB(skb)->is_flist)
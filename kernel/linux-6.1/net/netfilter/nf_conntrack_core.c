@@ -1547,7 +1547,7 @@ static void gc_worker(struct work_struct *work)
 
 			net = nf_ct_net(tmp);
 			cnet = nf_ct_pernet(net);
-			if (atomic_read(&cnet->count) < nf_conntrack_max95)
+			if (percpu_counter_read_positive(&cnet->count) < nf_conntrack_max95)
 				continue;
 
 			/* need to take reference to avoid possible races */
@@ -1622,17 +1622,21 @@ __nf_conntrack_alloc(struct net *net,
 		     gfp_t gfp, u32 hash)
 {
 	struct nf_conntrack_net *cnet = nf_ct_pernet(net);
-	unsigned int ct_count;
 	struct nf_conn *ct;
 
-	/* We don't want any race condition at early drop stage */
-	ct_count = atomic_inc_return(&cnet->count);
+	/* Count first, we don't want any race condition at early drop
+	 * stage.  Far from the limit this only touches the local cpu's
+	 * counter, the exact sum is only taken close to it.
+	 */
+	percpu_counter_add_batch(&cnet->count, 1, NF_CT_COUNT_BATCH);
 
-	if (nf_conntrack_max && unlikely(ct_count > nf_conntrack_max)) {
+	if (nf_conntrack_max &&
+	    unlikely(__percpu_counter_compare(&cnet->count, nf_conntrack_max,
+					      NF_CT_COUNT_BATCH) > 0)) {
 		if (!early_drop(net, hash)) {
 			if (!conntrack_gc_work.early_drop)
 				conntrack_gc_work.early_drop = true;
-			atomic_dec(&cnet->count);
+			percpu_counter_add_batch(&cnet->count, -1, NF_CT_COUNT_BATCH);
 			net_warn_ratelimited("nf_conntrack: table full, dropping packet\n");
 			return ERR_PTR(-ENOMEM);
 		}
@@ -1665,7 +1669,7 @@ __nf_conntrack_alloc(struct net *net,
 	refcount_set(&ct->ct_general.use, 0);
 	return ct;
 out:
-	atomic_dec(&cnet->count);
+	percpu_counter_add_batch(&cnet->count, -1, NF_CT_COUNT_BATCH);
 	return ERR_PTR(-ENOMEM);
 }
 
@@ -1704,7 +1708,7 @@ void nf_conntrack_free(struct nf_conn *ct)
 	cnet = nf_ct_pernet(net);
 
 	smp_mb__before_atomic();
-	atomic_dec(&cnet->count);
+	percpu_counter_add_batch(&cnet->count, -1, NF_CT_COUNT_BATCH);
 }
 EXPORT_SYMBOL_GPL(nf_conntrack_free);
 
@@ -2454,7 +2458,7 @@ void nf_ct_iterate_cleanup_net(int (*iter)(struct nf_conn *i, void *data),
 
 	might_sleep();
 
-	if (atomic_read(&cnet->count) == 0)
+	if (percpu_counter_sum(&cnet->count) == 0)
 		return;
 
 	nf_ct_iterate_cleanup(iter, iter_data);
@@ -2482,7 +2486,7 @@ nf_ct_iterate_destroy(int (*iter)(struct nf_conn *i, void *data), void *data)
 	for_each_net(net) {
 		struct nf_conntrack_net *cnet = nf_ct_pernet(net);
 
-		if (atomic_read(&cnet->count) == 0)
+		if (percpu_counter_sum(&cnet->count) == 0)
 			continue;
 		nf_queue_nf_hook_drop(net);
 	}
@@ -2571,7 +2575,7 @@ i_see_dead_people:
 
 		iter_data.net = net;
 		nf_ct_iterate_cleanup_net(kill_all, &iter_data);
-		if (atomic_read(&cnet->count) != 0)
+		if (percpu_counter_sum(&cnet->count) != 0)
 			busy = 1;
 	}
 	if (busy) {
@@ -2580,9 +2584,12 @@ i_see_dead_people:
 	}
 
 	list_for_each_entry(net, net_exit_list, exit_list) {
+		struct nf_conntrack_net *cnet = nf_ct_pernet(net);
+
 		nf_conntrack_ecache_pernet_fini(net);
 		nf_conntrack_expect_pernet_fini(net);
 		free_percpu(net->ct.stat);
+		percpu_counter_destroy(&cnet->count);
 	}
 }
 
@@ -2809,11 +2816,14 @@ int nf_conntrack_init_net(struct net *net)
 
 	BUILD_BUG_ON(IP_CT_UNTRACKED == IP_CT_NUMBER);
 	BUILD_BUG_ON_NOT_POWER_OF_2(CONNTRACK_LOCKS);
-	atomic_set(&cnet->count, 0);
+	ret = percpu_counter_init(&cnet->count, 0, GFP_KERNEL);
+	if (ret)
+		return ret;
 
+	ret = -ENOMEM;
 	net->ct.stat = alloc_percpu(struct ip_conntrack_stat);
 	if (!net->ct.stat)
-		return ret;
+		goto err_stat;
 
 	ret = nf_conntrack_expect_pernet_init(net);
 	if (ret < 0)
@@ -2828,6 +2838,8 @@ int nf_conntrack_init_net(struct net *net)
 
 err_expect:
 	free_percpu(net->ct.stat);
+err_stat:
+	percpu_counter_destroy(&cnet->count);
 	return ret;
 }
 
@@ -518,9 +518,9 @@ static void nf_conntrack_standalone_fini_proc(struct net *net)
 
 u32 nf_conntrack_count(const struct net *net)
 {
-	const struct nf_conntrack_net *cnet = nf_ct_pernet(net);
+	struct nf_conntrack_net *cnet = nf_ct_pernet(net);
 
-	return atomic_read(&cnet->count);
+	return percpu_counter_sum_positive(&cnet->count);
 }
 EXPORT_SYMBOL_GPL(nf_conntrack_count);
 
@@ -551,6 +551,19 @@ nf_conntrack_hash_sysctl(struct ctl_table *table, int write,
 	return ret;
 }
 
+static int
+nf_conntrack_count_sysctl(struct ctl_table *table, int write,
+			  void *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct ctl_table tmp = *table;
+	int count;
+
+	count = percpu_counter_sum_positive(table->data);
+	tmp.data = &count;
+
+	return proc_dointvec(&tmp, write, buffer, lenp, ppos);
+}
+
 static struct ctl_table_header *nf_ct_netfilter_header;
 
 enum nf_ct_sysctl_index {
@@ -637,7 +650,7 @@ static struct ctl_table nf_ct_sysctl_table[] = {
 		.procname	= "nf_conntrack_count",
 		.maxlen		= sizeof(int),
 		.mode		= 0444,
-		.proc_handler	= proc_dointvec,
+		.proc_handler	= nf_conntrack_count_sysctl,
 	},
 	[NF_SYSCTL_CT_BUCKETS] = {
 		.procname       = "nf_conntrack_buckets",
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/* PIPAPO: PIle PAcket POlicies: NEON bucket intersection
+ *
+ * Built with the FP/SIMD registers enabled, so everything in this file must
+ * only ever run between kernel_neon_begin() and kernel_neon_end(), see
+ * nft_set_pipapo_neon.c.
+ */
+
+#include <asm/neon-intrinsics.h>
+
+void nft_pipapo_neon_and_buckets(unsigned long *dst,
+				 const unsigned long * const *buckets,
+				 unsigned int nbuckets, unsigned long bsize);
+
+/**
+ * nft_pipapo_neon_and_buckets() - AND lookup table buckets into a bitmap
+ * @dst:	Result bitmap from the previous field, updated in place
+ * @buckets:	Buckets selected by each bit group of the packet field
+ * @nbuckets:	Number of buckets, that is, of bit groups in the field
+ * @bsize:	Size of each bucket, in longs
+ *
+ * Instead of intersecting one whole bucket at a time, as the scalar version
+ * does, walk the bitmap 128 bits at a time and AND the matching words of all
+ * the buckets in registers: @dst is then read and written once per field,
+ * rather than once per group.
+ */
+void nft_pipapo_neon_and_buckets(unsigned long *dst,
+				 const unsigned long * const *buckets,
+				 unsigned int nbuckets, unsigned long bsize)
+{
+	unsigned long i;
+	unsigned int b;
+
+	for (i = 0; i + 2 <= bsize; i += 2) {
+		uint64x2_t acc = vld1q_u64((const uint64_t *)(dst + i));
+
+		for (b = 0; b < nbuckets; b++)
+			acc = vandq_u64(acc,
+					vld1q_u64((const uint64_t *)(buckets[b] + i)));
+
+		vst1q_u64((uint64_t *)(dst + i), acc);
+	}
+
+	for (; i < bsize; i++) {
+		unsigned long acc = dst[i];
+
+		for (b = 0; b < nbuckets; b++)
+			acc &= buckets[b][i];
+
+		dst[i] = acc;
+	}
+}
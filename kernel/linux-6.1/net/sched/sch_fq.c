@@ -28,6 +28,12 @@
  *  Note : When a flow becomes empty, we do not immediately remove it from
  *  rb trees, for performance reasons (its expected to send additional packets,
  *  or SLAB cache will reuse socket for another flow)
+ *
+ *  fq_pcpu is the same scheduler run without the qdisc root lock
+ *  (TCQ_F_NOLOCK) : enqueue() only pushes skbs on a per cpu lockless list,
+ *  and the single cpu running dequeue() moves them into the flows in batches
+ *  before serving them. Meant for mq + fq_pcpu on many TX queues, where
+ *  senders otherwise spin on the lock held by the pacing/dequeue path.
  */
 
 #include <linux/module.h>
@@ -44,6 +50,8 @@
 #include <linux/hash.h>
 #include <linux/prefetch.h>
 #include <linux/vmalloc.h>
+#include <linux/llist.h>
+#include <linux/percpu.h>
 #include <net/netlink.h>
 #include <net/pkt_sched.h>
 #include <net/sock.h>
@@ -93,6 +101,16 @@ struct fq_flow_head {
 	struct fq_flow *last;
 };
 
+/* fq_pcpu: skbs enqueued on one cpu, not yet seen by dequeue() */
+struct fq_stage {
+	struct llist_head	head;
+	atomic_t		len;
+	atomic_t		drops;
+};
+
+/* Minimum number of skbs one cpu may stage, whatever the limit */
+#define FQ_STAGE_MIN_LEN	64
+
 struct fq_sched_data {
 	struct fq_flow_head new_flows;
 
@@ -133,6 +151,10 @@ struct fq_sched_data {
 
 	u32		timer_slack; /* hrtimer slack in ns */
 	struct qdisc_watchdog watchdog;
+
+	struct fq_stage __percpu *stage;	/* fq_pcpu only */
+	cpumask_var_t	stage_mask;	/* cpus with skbs in their stage */
+	u32		stage_limit;	/* max skbs staged per cpu */
 };
 
 /*
@@ -496,6 +518,67 @@ static int fq_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 	return NET_XMIT_SUCCESS;
 }
 
+/* The lockless enqueue of fq_pcpu. Only a qdisc attached to a TX queue is
+ * run without the root lock; below a classful parent, enqueue() and
+ * dequeue() are serialized by the parent and skbs go to the flows directly.
+ */
+static int fq_pcpu_enqueue(struct sk_buff *skb, struct Qdisc *sch,
+			   struct sk_buff **to_free)
+{
+	struct fq_sched_data *q = qdisc_priv(sch);
+	struct fq_stage *stage;
+
+	if (rcu_access_pointer(sch->dev_queue->qdisc) != sch)
+		return fq_enqueue(skb, sch, to_free);
+
+	stage = this_cpu_ptr(q->stage);
+	if (unlikely(atomic_inc_return(&stage->len) > READ_ONCE(q->stage_limit))) {
+		atomic_dec(&stage->len);
+		atomic_inc(&stage->drops);
+		__qdisc_drop(skb, to_free);
+		return NET_XMIT_DROP;
+	}
+
+	/* Only the first skb of a batch touches the shared mask */
+	if (llist_add(&skb->ll_node, &stage->head))
+		cpumask_set_cpu(smp_processor_id(), q->stage_mask);
+
+	return NET_XMIT_SUCCESS;
+}
+
+/* Move the skbs staged by fq_pcpu_enqueue() into their flows, in order */
+static void fq_stage_drain(struct Qdisc *sch)
+{
+	struct fq_sched_data *q = qdisc_priv(sch);
+	struct sk_buff *to_free = NULL;
+	int cpu;
+
+	for_each_cpu(cpu, q->stage_mask) {
+		struct fq_stage *stage = per_cpu_ptr(q->stage, cpu);
+		struct llist_node *first;
+		struct sk_buff *skb, *tmp;
+		int n = 0;
+
+		/* Clear before emptying: an skb added after llist_del_all()
+		 * finds the list empty and sets the bit again.
+		 */
+		if (!cpumask_test_and_clear_cpu(cpu, q->stage_mask))
+			continue;
+
+		first = llist_reverse_order(llist_del_all(&stage->head));
+		llist_for_each_entry_safe(skb, tmp, first, ll_node) {
+			skb_mark_not_on_list(skb);
+			fq_enqueue(skb, sch, &to_free);
+			n++;
+		}
+		atomic_sub(n, &stage->len);
+		sch->qstats.drops += atomic_xchg(&stage->drops, 0);
+	}
+
+	if (unlikely(to_free))
+		kfree_skb_list_reason(to_free, SKB_DROP_REASON_QDISC_DROP);
+}
+
 static void fq_check_throttled(struct fq_sched_data *q, u64 now)
 {
 	unsigned long sample;
@@ -533,6 +616,9 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 	u32 plen;
 	u64 now;
 
+	if (q->stage)
+		fq_stage_drain(sch);
+
 	if (!sch->q.qlen)
 		return NULL;
 
@@ -666,10 +752,27 @@ static void fq_reset(struct Qdisc *sch)
 	struct rb_node *p;
 	struct fq_flow *f;
 	unsigned int idx;
+	int cpu;
 
 	sch->q.qlen = 0;
 	sch->qstats.backlog = 0;
 
+	if (q->stage) {
+		cpumask_clear(q->stage_mask);
+		for_each_possible_cpu(cpu) {
+			struct fq_stage *stage = per_cpu_ptr(q->stage, cpu);
+			struct llist_node *first = llist_del_all(&stage->head);
+			struct sk_buff *skb, *tmp;
+
+			llist_for_each_entry_safe(skb, tmp, first, ll_node) {
+				skb_mark_not_on_list(skb);
+				rtnl_kfree_skbs(skb, skb);
+			}
+			atomic_set(&stage->len, 0);
+			atomic_set(&stage->drops, 0);
+		}
+	}
+
 	fq_flow_purge(&q->internal);
 
 	if (!q->fq_root)
@@ -744,6 +847,25 @@ static void fq_free(void *addr)
 	kvfree(addr);
 }
 
+/* fq_pcpu dequeues under the qdisc seqlock only, see qdisc_run_begin() */
+static void fq_tree_lock(struct Qdisc *sch)
+{
+	if (sch->flags & TCQ_F_NOLOCK)
+		spin_lock_bh(&sch->seqlock);
+	sch_tree_lock(sch);
+}
+
+static void fq_tree_unlock(struct Qdisc *sch)
+{
+	sch_tree_unlock(sch);
+	if (sch->flags & TCQ_F_NOLOCK) {
+		spin_unlock_bh(&sch->seqlock);
+		/* Senders that found the seqlock taken left their skbs to us */
+		if (test_bit(__QDISC_STATE_MISSED, &sch->state))
+			__netif_schedule(sch);
+	}
+}
+
 static int fq_resize(struct Qdisc *sch, u32 log)
 {
 	struct fq_sched_data *q = qdisc_priv(sch);
@@ -763,7 +885,7 @@ static int fq_resize(struct Qdisc *sch, u32 log)
 	for (idx = 0; idx < (1U << log); idx++)
 		array[idx] = RB_ROOT;
 
-	sch_tree_lock(sch);
+	fq_tree_lock(sch);
 
 	old_fq_root = q->fq_root;
 	if (old_fq_root)
@@ -772,7 +894,7 @@ static int fq_resize(struct Qdisc *sch, u32 log)
 	q->fq_root = array;
 	q->fq_trees_log = log;
 
-	sch_tree_unlock(sch);
+	fq_tree_unlock(sch);
 
 	fq_free(old_fq_root);
 
@@ -817,7 +939,7 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	if (err < 0)
 		return err;
 
-	sch_tree_lock(sch);
+	fq_tree_lock(sch);
 
 	fq_log = q->fq_trees_log;
 
@@ -831,6 +953,8 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	}
 	if (tb[TCA_FQ_PLIMIT])
 		sch->limit = nla_get_u32(tb[TCA_FQ_PLIMIT]);
+	WRITE_ONCE(q->stage_limit, max_t(u32, sch->limit / num_possible_cpus(),
+					 FQ_STAGE_MIN_LEN));
 
 	if (tb[TCA_FQ_FLOW_PLIMIT])
 		q->flow_plimit = nla_get_u32(tb[TCA_FQ_FLOW_PLIMIT]);
@@ -896,9 +1020,9 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 
 	if (!err) {
 
-		sch_tree_unlock(sch);
+		fq_tree_unlock(sch);
 		err = fq_resize(sch, fq_log);
-		sch_tree_lock(sch);
+		fq_tree_lock(sch);
 	}
 	while (sch->q.qlen > sch->limit) {
 		struct sk_buff *skb = fq_dequeue(sch);
@@ -911,7 +1035,7 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	}
 	qdisc_tree_reduce_backlog(sch, drop_count, drop_len);
 
-	sch_tree_unlock(sch);
+	fq_tree_unlock(sch);
 	return err;
 }
 
@@ -922,6 +1046,8 @@ static void fq_destroy(struct Qdisc *sch)
 	fq_reset(sch);
 	fq_free(q->fq_root);
 	qdisc_watchdog_cancel(&q->watchdog);
+	free_percpu(q->stage);
+	free_cpumask_var(q->stage_mask);
 }
 
 static int fq_init(struct Qdisc *sch, struct nlattr *opt,
@@ -964,6 +1090,29 @@ static int fq_init(struct Qdisc *sch, struct nlattr *opt,
 	return err;
 }
 
+static int fq_pcpu_init(struct Qdisc *sch, struct nlattr *opt,
+			struct netlink_ext_ack *extack)
+{
+	struct fq_sched_data *q = qdisc_priv(sch);
+	int err, cpu;
+
+	err = fq_init(sch, opt, extack);
+	if (err)
+		return err;
+
+	if (!zalloc_cpumask_var(&q->stage_mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	q->stage = alloc_percpu(struct fq_stage);
+	if (!q->stage)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		init_llist_head(&per_cpu_ptr(q->stage, cpu)->head);
+
+	return 0;
+}
+
 static int fq_dump(struct Qdisc *sch, struct sk_buff *skb)
 {
 	struct fq_sched_data *q = qdisc_priv(sch);
@@ -1050,6 +1199,24 @@ static struct Qdisc_ops fq_qdisc_ops __read_mostly = {
 	.owner		=	THIS_MODULE,
 };
 
+/* Same options and statistics as fq */
+static struct Qdisc_ops fq_pcpu_qdisc_ops __read_mostly = {
+	.id		=	"fq_pcpu",
+	.priv_size	=	sizeof(struct fq_sched_data),
+	.static_flags	=	TCQ_F_NOLOCK,
+
+	.enqueue	=	fq_pcpu_enqueue,
+	.dequeue	=	fq_dequeue,
+	.peek		=	qdisc_peek_dequeued,
+	.init		=	fq_pcpu_init,
+	.reset		=	fq_reset,
+	.destroy	=	fq_destroy,
+	.change		=	fq_change,
+	.dump		=	fq_dump,
+	.dump_stats	=	fq_dump_stats,
+	.owner		=	THIS_MODULE,
+};
+
 static int __init fq_module_init(void)
 {
 	int ret;
@@ -1062,18 +1229,31 @@ static int __init fq_module_init(void)
 
 	ret = register_qdisc(&fq_qdisc_ops);
 	if (ret)
-		kmem_cache_destroy(fq_flow_cachep);
+		goto err_cache;
+
+	ret = register_qdisc(&fq_pcpu_qdisc_ops);
+	if (ret)
+		goto err_fq;
+
+	return 0;
+
+err_fq:
+	unregister_qdisc(&fq_qdisc_ops);
+err_cache:
+	kmem_cache_destroy(fq_flow_cachep);
 	return ret;
 }
 
 static void __exit fq_module_exit(void)
 {
+	unregister_qdisc(&fq_pcpu_qdisc_ops);
 	unregister_qdisc(&fq_qdisc_ops);
 	kmem_cache_destroy(fq_flow_cachep);
 }
 
 module_init(fq_module_init)
 module_exit(fq_module_exit)
+MODULE_ALIAS("sch_fq_pcpu");
 MODULE_AUTHOR("Eric Dumazet");
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Fair Queue Packet Scheduler");
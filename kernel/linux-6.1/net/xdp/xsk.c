@@ -32,6 +32,9 @@
 
 #define TX_BATCH_SIZE 32
 
+/* Most buffers a multi-buffer frame can span, one linear part plus frags */
+#define XSK_MAX_PKT_DESCS (MAX_SKB_FRAGS + 1)
+
 static DEFINE_PER_CPU(struct list_head, xskmap_flush_list);
 
 void xsk_set_rx_need_wakeup(struct xsk_buff_pool *pool)
@@ -134,14 +137,15 @@ int xsk_reg_pool_at_qid(struct net_device *dev, struct xsk_buff_pool *pool,
 	return 0;
 }
 
-static int __xsk_rcv_zc(struct xdp_sock *xs, struct xdp_buff *xdp, u32 len)
+static int __xsk_rcv_zc(struct xdp_sock *xs, struct xdp_buff *xdp, u32 len,
+			u32 flags)
 {
 	struct xdp_buff_xsk *xskb = container_of(xdp, struct xdp_buff_xsk, xdp);
 	u64 addr;
 	int err;
 
 	addr = xp_get_handle(xskb);
-	err = xskq_prod_reserve_desc(xs->rx, addr, len);
+	err = xskq_prod_reserve_desc(xs->rx, addr, len, flags);
 	if (err) {
 		xs->rx_queue_full++;
 		return err;
@@ -169,14 +173,106 @@ static void xsk_copy_xdp(struct xdp_buff *to, struct xdp_buff *from, u32 len)
 	memcpy(to_buf, from_buf, len + metalen);
 }
 
+/* Copy @len bytes of the frame in @from, starting @off bytes into it: the
+ * linear part first, then the fragments.
+ */
+static void xsk_copy_xdp_range(void *to, struct xdp_buff *from, u32 off,
+			       u32 len)
+{
+	u32 linear = from->data_end - from->data;
+	struct skb_shared_info *sinfo;
+	u32 copy, i;
+
+	if (off < linear) {
+		copy = min(len, linear - off);
+		memcpy(to, from->data + off, copy);
+		to += copy;
+		len -= copy;
+		off = 0;
+	} else {
+		off -= linear;
+	}
+
+	if (!len)
+		return;
+
+	sinfo = xdp_get_shared_info_from_buff(from);
+	for (i = 0; len && i < sinfo->nr_frags; i++) {
+		skb_frag_t *frag = &sinfo->frags[i];
+		u32 size = skb_frag_size(frag);
+
+		if (off >= size) {
+			off -= size;
+			continue;
+		}
+
+		copy = min(len, size - off);
+		memcpy(to, skb_frag_address(frag) + off, copy);
+		to += copy;
+		len -= copy;
+		off = 0;
+	}
+}
+
+/* Spread a frame larger than one buffer over as many as it takes, all but
+ * the last flagged XDP_PKT_CONTD. Buffers and Rx ring entries for the whole
+ * frame are secured up front, so that it is never delivered in part.
+ */
+static int __xsk_rcv_mb(struct xdp_sock *xs, struct xdp_buff *xdp, u32 len)
+{
+	u32 frame_size = xsk_pool_get_rx_frame_size(xs->pool);
+	struct xdp_buff *bufs[XSK_MAX_PKT_DESCS];
+	u32 num_desc, off, copy, i;
+
+	num_desc = DIV_ROUND_UP(len, frame_size);
+	if (num_desc > XSK_MAX_PKT_DESCS) {
+		xs->rx_dropped++;
+		return -ENOSPC;
+	}
+
+	if (xskq_prod_nb_free(xs->rx, num_desc) < num_desc) {
+		xs->rx_queue_full++;
+		return -ENOBUFS;
+	}
+
+	for (i = 0; i < num_desc; i++) {
+		bufs[i] = xsk_buff_alloc(xs->pool);
+		if (!bufs[i]) {
+			while (i--)
+				xsk_buff_free(bufs[i]);
+			xs->rx_dropped++;
+			return -ENOMEM;
+		}
+	}
+
+	if (!xdp_data_meta_unsupported(xdp)) {
+		u32 metalen = xdp->data - xdp->data_meta;
+
+		memcpy(bufs[0]->data - metalen, xdp->data_meta, metalen);
+	}
+
+	for (i = 0, off = 0; i < num_desc; i++, off += copy) {
+		copy = min(len - off, frame_size);
+		xsk_copy_xdp_range(bufs[i]->data, xdp, off, copy);
+		__xsk_rcv_zc(xs, bufs[i], copy,
+			     i < num_desc - 1 ? XDP_PKT_CONTD : 0);
+	}
+
+	return 0;
+}
+
 static int __xsk_rcv(struct xdp_sock *xs, struct xdp_buff *xdp)
 {
 	struct xdp_buff *xsk_xdp;
 	int err;
 	u32 len;
 
-	len = xdp->data_end - xdp->data;
-	if (len > xsk_pool_get_rx_frame_size(xs->pool)) {
+	len = xdp_get_buff_len(xdp);
+	if (len > xsk_pool_get_rx_frame_size(xs->pool) ||
+	    unlikely(xdp_buff_has_frags(xdp))) {
+		if (xs->pool->sg)
+			return __xsk_rcv_mb(xs, xdp, len);
+
 		xs->rx_dropped++;
 		return -ENOSPC;
 	}
@@ -188,7 +284,7 @@ static int __xsk_rcv(struct xdp_sock *xs, struct xdp_buff *xdp)
 	}
 
 	xsk_copy_xdp(xsk_xdp, xdp, len);
-	err = __xsk_rcv_zc(xs, xsk_xdp, len);
+	err = __xsk_rcv_zc(xs, xsk_xdp, len, 0);
 	if (err) {
 		xsk_buff_free(xsk_xdp);
 		return err;
@@ -258,7 +354,7 @@ static int xsk_rcv(struct xdp_sock *xs, struct xdp_buff *xdp)
 
 	if (xdp->rxq->mem.type == MEM_TYPE_XSK_BUFF_POOL) {
 		len = xdp->data_end - xdp->data;
-		return __xsk_rcv_zc(xs, xdp, len);
+		return __xsk_rcv_zc(xs, xdp, len, 0);
 	}
 
 	err = __xsk_rcv(xs, xdp);
@@ -420,8 +516,41 @@ static void xsk_destruct_skb(struct sk_buff *skb)
 	sock_wfree(skb);
 }
 
+/* Buffers to complete once a multi-buffer skb is freed */
+struct xsk_tx_addrs {
+	u32 num;
+	u64 addrs[];
+};
+
+static void xsk_destruct_skb_mb(struct sk_buff *skb)
+{
+	struct xsk_tx_addrs *addrs = skb_shinfo(skb)->destructor_arg;
+	struct xdp_sock *xs = xdp_sk(skb->sk);
+	unsigned long flags;
+	u32 i;
+
+	spin_lock_irqsave(&xs->pool->cq_lock, flags);
+	for (i = 0; i < addrs->num; i++)
+		xskq_prod_submit_addr(xs->pool->cq, addrs->addrs[i]);
+	spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
+
+	kfree(addrs);
+	sock_wfree(skb);
+}
+
+/* Free an skb that was not sent, without completing its buffers */
+static void xsk_consume_skb(struct sk_buff *skb)
+{
+	if (skb->destructor == xsk_destruct_skb_mb)
+		kfree(skb_shinfo(skb)->destructor_arg);
+	skb->destructor = sock_wfree;
+	/* Free skb without triggering the perf drop trace */
+	consume_skb(skb);
+}
+
 static struct sk_buff *xsk_build_skb_zerocopy(struct xdp_sock *xs,
-					      struct xdp_desc *desc)
+					      struct xdp_desc *descs,
+					      u32 nb_descs)
 {
 	struct xsk_buff_pool *pool = xs->pool;
 	u32 hr, len, ts, offset, copy, copied;
@@ -429,6 +558,7 @@ static struct sk_buff *xsk_build_skb_zerocopy(struct xdp_sock *xs,
 	struct page *page;
 	void *buffer;
 	int err, i;
+	u32 d;
 	u64 addr;
 
 	hr = max(NET_SKB_PAD, L1_CACHE_ALIGN(xs->dev->needed_headroom));
@@ -439,43 +569,55 @@ static struct sk_buff *xsk_build_skb_zerocopy(struct xdp_sock *xs,
 
 	skb_reserve(skb, hr);
 
-	addr = desc->addr;
-	len = desc->len;
-	ts = pool->unaligned ? len : pool->chunk_size;
+	for (d = 0, i = 0; d < nb_descs; d++) {
+		addr = descs[d].addr;
+		len = descs[d].len;
+		ts = pool->unaligned ? len : pool->chunk_size;
+
+		buffer = xsk_buff_raw_get_data(pool, addr);
+		offset = offset_in_page(buffer);
+		addr = buffer - pool->addrs;
 
-	buffer = xsk_buff_raw_get_data(pool, addr);
-	offset = offset_in_page(buffer);
-	addr = buffer - pool->addrs;
+		for (copied = 0; copied < len; i++) {
+			if (unlikely(i == MAX_SKB_FRAGS)) {
+				kfree_skb(skb);
+				return ERR_PTR(-EOVERFLOW);
+			}
 
-	for (copied = 0, i = 0; copied < len; i++) {
-		page = pool->umem->pgs[addr >> PAGE_SHIFT];
-		get_page(page);
+			page = pool->umem->pgs[addr >> PAGE_SHIFT];
+			get_page(page);
 
-		copy = min_t(u32, PAGE_SIZE - offset, len - copied);
-		skb_fill_page_desc(skb, i, page, offset, copy);
+			copy = min_t(u32, PAGE_SIZE - offset, len - copied);
+			skb_fill_page_desc(skb, i, page, offset, copy);
 
-		copied += copy;
-		addr += copy;
-		offset = 0;
-	}
+			copied += copy;
+			addr += copy;
+			offset = 0;
+		}
 
-	skb->len += len;
-	skb->data_len += len;
-	skb->truesize += ts;
+		skb->len += len;
+		skb->data_len += len;
+		skb->truesize += ts;
 
-	refcount_add(ts, &xs->sk.sk_wmem_alloc);
+		refcount_add(ts, &xs->sk.sk_wmem_alloc);
+	}
 
 	return skb;
 }
 
+/* Build an skb out of the @nb_descs descriptors of one packet: buffers
+ * past the first are copied into page frags, or attached as they are if
+ * the device takes non-linear skbs.
+ */
 static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
-				     struct xdp_desc *desc)
+				     struct xdp_desc *descs, u32 nb_descs)
 {
 	struct net_device *dev = xs->dev;
 	struct sk_buff *skb;
+	u32 d;
 
 	if (dev->priv_flags & IFF_TX_SKB_NO_LINEAR) {
-		skb = xsk_build_skb_zerocopy(xs, desc);
+		skb = xsk_build_skb_zerocopy(xs, descs, nb_descs);
 		if (IS_ERR(skb))
 			return skb;
 	} else {
@@ -485,7 +627,7 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 
 		hr = max(NET_SKB_PAD, L1_CACHE_ALIGN(dev->needed_headroom));
 		tr = dev->needed_tailroom;
-		len = desc->len;
+		len = descs[0].len;
 
 		skb = sock_alloc_send_skb(&xs->sk, hr + len + tr, 1, &err);
 		if (unlikely(!skb))
@@ -494,29 +636,65 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 		skb_reserve(skb, hr);
 		skb_put(skb, len);
 
-		buffer = xsk_buff_raw_get_data(xs->pool, desc->addr);
+		buffer = xsk_buff_raw_get_data(xs->pool, descs[0].addr);
 		err = skb_store_bits(skb, 0, buffer, len);
 		if (unlikely(err)) {
 			kfree_skb(skb);
 			return ERR_PTR(err);
 		}
+
+		for (d = 1; d < nb_descs; d++) {
+			struct page *page;
+
+			page = alloc_page(xs->sk.sk_allocation);
+			if (unlikely(!page)) {
+				kfree_skb(skb);
+				return ERR_PTR(-ENOMEM);
+			}
+
+			len = descs[d].len;
+			buffer = xsk_buff_raw_get_data(xs->pool, descs[d].addr);
+			memcpy(page_address(page), buffer, len);
+
+			skb_add_rx_frag(skb, d - 1, page, 0, len, PAGE_SIZE);
+			refcount_add(PAGE_SIZE, &xs->sk.sk_wmem_alloc);
+		}
 	}
 
 	skb->dev = dev;
 	skb->priority = xs->sk.sk_priority;
 	skb->mark = READ_ONCE(xs->sk.sk_mark);
-	skb_shinfo(skb)->destructor_arg = (void *)(long)desc->addr;
-	skb->destructor = xsk_destruct_skb;
+
+	if (nb_descs > 1) {
+		struct xsk_tx_addrs *addrs;
+
+		addrs = kmalloc(struct_size(addrs, addrs, nb_descs),
+				xs->sk.sk_allocation);
+		if (unlikely(!addrs)) {
+			kfree_skb(skb);
+			return ERR_PTR(-ENOMEM);
+		}
+
+		addrs->num = nb_descs;
+		for (d = 0; d < nb_descs; d++)
+			addrs->addrs[d] = descs[d].addr;
+
+		skb_shinfo(skb)->destructor_arg = addrs;
+		skb->destructor = xsk_destruct_skb_mb;
+	} else {
+		skb_shinfo(skb)->destructor_arg = (void *)(long)descs[0].addr;
+		skb->destructor = xsk_destruct_skb;
+	}
 
 	return skb;
 }
 
 static int __xsk_generic_xmit(struct sock *sk)
 {
+	struct xdp_desc descs[XSK_MAX_PKT_DESCS];
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
-	struct xdp_desc desc;
 	struct sk_buff *skb;
 	unsigned long flags;
 	int err = 0;
@@ -532,47 +710,71 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	while (xskq_cons_peek_desc(xs->tx, &descs[0], xs->pool)) {
+		u32 nb_descs = 1;
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
 			goto out;
 		}
 
+		if (xp_mb_desc(&descs[0])) {
+			bool valid;
+
+			nb_descs = xskq_cons_read_pkt_descs(xs->tx, xs->pool, descs,
+							    XSK_MAX_PKT_DESCS,
+							    &valid);
+			/* The rest of the packet is still to be submitted. */
+			if (!nb_descs)
+				goto out;
+
+			if (unlikely(!valid)) {
+				xs->tx->invalid_descs += nb_descs;
+				xskq_cons_release_n(xs->tx, nb_descs);
+				continue;
+			}
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
 		 * any buffering in the Tx path.
 		 */
 		spin_lock_irqsave(&xs->pool->cq_lock, flags);
-		if (xskq_prod_reserve(xs->pool->cq)) {
+		if (xskq_prod_reserve_n(xs->pool->cq, nb_descs)) {
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
 			goto out;
 		}
 		spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
 
-		skb = xsk_build_skb(xs, &desc);
+		skb = xsk_build_skb(xs, descs, nb_descs);
 		if (IS_ERR(skb)) {
 			err = PTR_ERR(skb);
 			spin_lock_irqsave(&xs->pool->cq_lock, flags);
-			xskq_prod_cancel(xs->pool->cq);
+			xskq_prod_cancel_n(xs->pool->cq, nb_descs);
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			goto out;
+			if (err != -EOVERFLOW)
+				goto out;
+
+			/* Too many frags for the skb: drop the packet. */
+			xs->tx->invalid_descs += nb_descs;
+			xskq_cons_release_n(xs->tx, nb_descs);
+			err = 0;
+			continue;
 		}
 
 		err = __dev_direct_xmit(skb, xs->queue_id);
 		if  (err == NETDEV_TX_BUSY) {
 			/* Tell user-space to retry the send */
-			skb->destructor = sock_wfree;
 			spin_lock_irqsave(&xs->pool->cq_lock, flags);
-			xskq_prod_cancel(xs->pool->cq);
+			xskq_prod_cancel_n(xs->pool->cq, nb_descs);
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			/* Free skb without triggering the perf drop trace */
-			consume_skb(skb);
+			xsk_consume_skb(skb);
 			err = -EAGAIN;
 			goto out;
 		}
 
-		xskq_cons_release(xs->tx);
+		xskq_cons_release_n(xs->tx, nb_descs);
 		/* Ignore NET_XMIT_CN as packet might have been sent */
 		if (err == NET_XMIT_DROP) {
 			/* SKB completed but not sent */
@@ -896,7 +1098,7 @@ static int xsk_bind(struct socket *sock, struct sockaddr *addr, int addr_len)
 
 	flags = sxdp->sxdp_flags;
 	if (flags & ~(XDP_SHARED_UMEM | XDP_COPY | XDP_ZEROCOPY |
-		      XDP_USE_NEED_WAKEUP))
+		      XDP_USE_NEED_WAKEUP | XDP_USE_SG))
 		return -EINVAL;
 
 	bound_dev_if = READ_ONCE(sk->sk_bound_dev_if);
@@ -928,7 +1130,7 @@ static int xsk_bind(struct socket *sock, struct sockaddr *addr, int addr_len)
 		struct socket *sock;
 
 		if ((flags & XDP_COPY) || (flags & XDP_ZEROCOPY) ||
-		    (flags & XDP_USE_NEED_WAKEUP)) {
+		    (flags & XDP_USE_NEED_WAKEUP) || (flags & XDP_USE_SG)) {
 			/* Cannot specify flags for shared sockets. */
 			err = -EINVAL;
 			goto out_unlock;
@@ -1285,6 +1487,8 @@ static int xsk_getsockopt(struct socket *sock, int level, int optname,
 		mutex_lock(&xs->mutex);
 		if (xs->zc)
 			opts.flags |= XDP_OPTIONS_ZEROCOPY;
+		if (xs->pool && xs->pool->sg)
+			opts.flags |= XDP_OPTIONS_SG;
 		mutex_unlock(&xs->mutex);
 
 		len = sizeof(opts);
@@ -1311,14 +1515,27 @@ static int xsk_mmap(struct file *file, struct socket *sock,
 	struct xsk_queue *q = NULL;
 	unsigned long pfn;
 	struct page *qpg;
+	bool bound;
 
-	if (READ_ONCE(xs->state) != XSK_READY)
+	/* A bound socket can still map its rings, including the fill and
+	 * completion rings of the pool it uses. That is how a socket bound
+	 * with XDP_SHARED_UMEM, in another process than the umem owner,
+	 * gets at the rings it shares: the pool, and with it the rings, is
+	 * kept alive until the last socket using it is gone.
+	 */
+	bound = xsk_is_bound(xs);
+	if (!bound && READ_ONCE(xs->state) != XSK_READY)
 		return -EBUSY;
 
 	if (offset == XDP_PGOFF_RX_RING) {
 		q = READ_ONCE(xs->rx);
 	} else if (offset == XDP_PGOFF_TX_RING) {
 		q = READ_ONCE(xs->tx);
+	} else if (bound) {
+		if (offset == XDP_UMEM_PGOFF_FILL_RING)
+			q = xs->pool->fq;
+		else if (offset == XDP_UMEM_PGOFF_COMPLETION_RING)
+			q = xs->pool->cq;
 	} else {
 		/* Matches the smp_wmb() in XDP_UMEM_REG */
 		smp_rmb();
@@ -155,6 +155,13 @@ int xp_assign_dev(struct xsk_buff_pool *pool,
 	if (force_zc && force_copy)
 		return -EINVAL;
 
+	if (flags & XDP_USE_SG) {
+		/* Drivers cannot chain zero-copy buffers yet. */
+		if (force_zc)
+			return -EOPNOTSUPP;
+		force_copy = true;
+	}
+
 	if (xsk_get_pool_from_qid(netdev, queue_id))
 		return -EBUSY;
 
@@ -166,6 +173,8 @@ int xp_assign_dev(struct xsk_buff_pool *pool,
 
 	if (flags & XDP_USE_NEED_WAKEUP)
 		pool->uses_need_wakeup = true;
+	if (flags & XDP_USE_SG)
+		pool->sg = true;
 	/* Tx needs to be explicitly woken up the first time.  Also
 	 * for supporting drivers that do not implement this
 	 * feature. They will always have to call sendto() or poll().
@@ -225,6 +234,8 @@ int xp_assign_dev_shared(struct xsk_buff_pool *pool, struct xdp_sock *umem_xs,
 	flags = umem->zc ? XDP_ZEROCOPY : XDP_COPY;
 	if (umem_xs->pool->uses_need_wakeup)
 		flags |= XDP_USE_NEED_WAKEUP;
+	if (umem_xs->pool->sg)
+		flags |= XDP_USE_SG;
 
 	return xp_assign_dev(pool, dev, queue_id, flags);
 }
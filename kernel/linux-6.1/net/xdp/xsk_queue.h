@@ -129,6 +129,17 @@ static inline bool xskq_cons_read_addr_unchecked(struct xsk_queue *q, u64 *addr)
 	return false;
 }
 
+static inline bool xp_mb_desc(struct xdp_desc *desc)
+{
+	return desc->options & XDP_PKT_CONTD;
+}
+
+static inline bool xp_valid_desc_options(struct xsk_buff_pool *pool,
+					 struct xdp_desc *desc)
+{
+	return !(desc->options & ~(pool->sg ? XDP_PKT_CONTD : 0));
+}
+
 static inline bool xp_aligned_validate_desc(struct xsk_buff_pool *pool,
 					    struct xdp_desc *desc)
 {
@@ -144,7 +155,7 @@ static inline bool xp_aligned_validate_desc(struct xsk_buff_pool *pool,
 	if (chunk >= pool->addrs_cnt)
 		return false;
 
-	if (desc->options)
+	if (!xp_valid_desc_options(pool, desc))
 		return false;
 	return true;
 }
@@ -165,7 +176,7 @@ static inline bool xp_unaligned_validate_desc(struct xsk_buff_pool *pool,
 	    xp_desc_crosses_non_contig_pg(pool, addr, desc->len))
 		return false;
 
-	if (desc->options)
+	if (!xp_valid_desc_options(pool, desc))
 		return false;
 	return true;
 }
@@ -290,6 +301,42 @@ static inline bool xskq_cons_peek_desc(struct xsk_queue *q,
 	return xskq_cons_read_desc(q, desc, pool);
 }
 
+/* Copy the descriptors of the multi-buffer packet starting at the consumer
+ * position into @descs, at most @max of them, and return how many there
+ * are. Returns 0 if user space has not produced the last descriptor of
+ * the packet yet. Nothing is released, so that the packet is consumed, or
+ * left in the ring, as a whole. *@valid is cleared if any descriptor fails
+ * validation or the packet does not fit in @max.
+ */
+static inline u32 xskq_cons_read_pkt_descs(struct xsk_queue *q,
+					   struct xsk_buff_pool *pool,
+					   struct xdp_desc *descs, u32 max,
+					   bool *valid)
+{
+	struct xdp_rxtx_ring *ring = (struct xdp_rxtx_ring *)q->ring;
+	u32 nb_entries = 0;
+
+	*valid = true;
+	while (nb_entries < max) {
+		struct xdp_desc *desc = &descs[nb_entries];
+
+		if (q->cached_cons + nb_entries == q->cached_prod) {
+			__xskq_cons_peek(q);
+			if (q->cached_cons + nb_entries == q->cached_prod)
+				return 0;
+		}
+
+		*desc = ring->desc[(q->cached_cons + nb_entries++) & q->ring_mask];
+		if (!xp_validate_desc(pool, desc))
+			*valid = false;
+		if (!xp_mb_desc(desc))
+			return nb_entries;
+	}
+
+	*valid = false;
+	return nb_entries;
+}
+
 /* To improve performance in the xskq_cons_release functions, only update local state here.
  * Reflect this to global state when we get new entries from the ring in
  * xskq_cons_get_entries() and whenever Rx or Tx processing are completed in the NAPI loop.
@@ -326,18 +373,18 @@ static inline bool xskq_prod_is_full(struct xsk_queue *q)
 	return xskq_prod_nb_free(q, 1) ? false : true;
 }
 
-static inline void xskq_prod_cancel(struct xsk_queue *q)
+static inline void xskq_prod_cancel_n(struct xsk_queue *q, u32 cnt)
 {
-	q->cached_prod--;
+	q->cached_prod -= cnt;
 }
 
-static inline int xskq_prod_reserve(struct xsk_queue *q)
+static inline int xskq_prod_reserve_n(struct xsk_queue *q, u32 cnt)
 {
-	if (xskq_prod_is_full(q))
+	if (xskq_prod_nb_free(q, cnt) < cnt)
 		return -ENOSPC;
 
 	/* A, matches D */
-	q->cached_prod++;
+	q->cached_prod += cnt;
 	return 0;
 }
 
@@ -367,7 +414,7 @@ static inline void xskq_prod_write_addr_batch(struct xsk_queue *q, struct xdp_de
 }
 
 static inline int xskq_prod_reserve_desc(struct xsk_queue *q,
-					 u64 addr, u32 len)
+					 u64 addr, u32 len, u32 flags)
 {
 	struct xdp_rxtx_ring *ring = (struct xdp_rxtx_ring *)q->ring;
 	u32 idx;
@@ -379,6 +426,7 @@ static inline int xskq_prod_reserve_desc(struct xsk_queue *q,
 	idx = q->cached_prod++ & q->ring_mask;
 	ring->desc[idx].addr = addr;
 	ring->desc[idx].len = len;
+	ring->desc[idx].options = flags;
 
 	return 0;
 }
@@ -335,6 +335,51 @@ int aa_path_perm(const char *op, struct aa_label *label,
 	return error;
 }
 
+/**
+ * aa_file_open_perm - do open permission check & audit for @file
+ * @op: operation being checked
+ * @label: label of the opening task  (NOT NULL)
+ * @file: file being opened  (NOT NULL)
+ * @request: requested permissions
+ * @cond: conditional info for this request  (NOT NULL)
+ *
+ * Like aa_path_perm() for @file's path, but on success caches everything
+ * every profile of @label grants on the path, not just @request, so that
+ * later file_perm checks for other accesses (mmap, lock, ...) are answered
+ * by aa_file_perm() without another path lookup and DFA walk. Permissions
+ * a profile audits are left out of the cache so their records are kept.
+ *
+ * Returns: %0 else error if access denied or other error
+ */
+int aa_file_open_perm(const char *op, struct aa_label *label,
+		      struct file *file, u32 request, struct path_cond *cond)
+{
+	struct aa_perms perms = {};
+	struct aa_profile *profile;
+	struct label_it i;
+	u32 allow = ALL_PERMS_MASK;
+	char *buffer;
+	int flags, error = 0;
+
+	flags = PATH_DELEGATE_DELETED | (S_ISDIR(cond->mode) ? PATH_IS_DIR :
+								0);
+	buffer = aa_get_buffer(false);
+	if (!buffer)
+		return -ENOMEM;
+	label_for_each_confined(i, label, profile) {
+		last_error(error, profile_path_perm(op, profile, &file->f_path,
+						    buffer, request, cond,
+						    flags, &perms));
+		allow &= perms.allow & ~perms.audit;
+	}
+	aa_put_buffer(buffer);
+
+	/* complain mode may pass @request without the dfa allowing it */
+	file_ctx(file)->allow = error ? request : request | allow;
+
+	return error;
+}
+
 /**
  * xindex_is_subset - helper for aa_path_link
  * @link: link permission set
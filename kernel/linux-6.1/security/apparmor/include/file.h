@@ -199,6 +199,9 @@ int aa_path_perm(const char *op, struct aa_label *label,
 int aa_path_link(struct aa_label *label, struct dentry *old_dentry,
 		 const struct path *new_dir, struct dentry *new_dentry);
 
+int aa_file_open_perm(const char *op, struct aa_label *label,
+		      struct file *file, u32 request, struct path_cond *cond);
+
 int aa_file_perm(const char *op, struct aa_label *label, struct file *file,
 		 u32 request, bool in_atomic);
 
@@ -452,10 +452,8 @@ static int apparmor_file_open(struct file *file)
 			inode->i_mode
 		};
 
-		error = aa_path_perm(OP_OPEN, label, &file->f_path, 0,
-				     aa_map_file_to_perms(file), &cond);
-		/* todo cache full allowed permissions set and state */
-		fctx->allow = aa_map_file_to_perms(file);
+		error = aa_file_open_perm(OP_OPEN, label, file,
+					  aa_map_file_to_perms(file), &cond);
 	}
 	aa_put_label(label);
 
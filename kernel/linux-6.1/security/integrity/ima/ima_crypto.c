@@ -18,6 +18,8 @@
 #include <linux/scatterlist.h>
 #include <linux/err.h>
 #include <linux/slab.h>
+#include <linux/fadvise.h>
+#include <linux/sizes.h>
 #include <crypto/hash.h>
 
 #include "ima.h"
@@ -27,6 +29,14 @@ static unsigned long ima_ahash_minsize;
 module_param_named(ahash_minsize, ima_ahash_minsize, ulong, 0644);
 MODULE_PARM_DESC(ahash_minsize, "Minimum file size for ahash use");
 
+/* shash look-ahead window, 0 - read on demand. */
+static unsigned long ima_shash_readahead = SZ_2M;
+module_param_named(shash_readahead, ima_shash_readahead, ulong, 0644);
+MODULE_PARM_DESC(shash_readahead, "Bytes read ahead of the shash cursor");
+
+/* shash read buffer, falls back to one page */
+#define IMA_SHASH_BUFSIZE	SZ_64K
+
 /* default is 0 - 1 page. */
 static int ima_maxorder;
 static unsigned int ima_bufsize = PAGE_SIZE;
@@ -457,7 +467,9 @@ static int ima_calc_file_hash_tfm(struct file *file,
 				  struct ima_digest_data *hash,
 				  struct crypto_shash *tfm)
 {
-	loff_t i_size, offset = 0;
+	loff_t i_size, offset = 0, ra_next = 0;
+	unsigned long ra_window = READ_ONCE(ima_shash_readahead);
+	size_t rbuf_size = IMA_SHASH_BUFSIZE;
 	char *rbuf;
 	int rc;
 	SHASH_DESC_ON_STACK(shash, tfm);
@@ -475,14 +487,34 @@ static int ima_calc_file_hash_tfm(struct file *file,
 	if (i_size == 0)
 		goto out;
 
-	rbuf = kzalloc(PAGE_SIZE, GFP_KERNEL);
+	if (i_size <= PAGE_SIZE)
+		rbuf_size = PAGE_SIZE;
+	rbuf = kzalloc(rbuf_size, GFP_KERNEL | __GFP_NOWARN | __GFP_NORETRY);
+	if (!rbuf && rbuf_size > PAGE_SIZE) {
+		rbuf_size = PAGE_SIZE;
+		rbuf = kzalloc(rbuf_size, GFP_KERNEL);
+	}
 	if (!rbuf)
 		return -ENOMEM;
 
+	if (i_size <= ra_window)
+		ra_window = 0;
+
 	while (offset < i_size) {
 		int rbuf_len;
 
-		rbuf_len = integrity_kernel_read(file, offset, rbuf, PAGE_SIZE);
+		/*
+		 * Keep the I/O for the next window in flight while this one
+		 * is hashed, so a cold large file is read at device speed
+		 * instead of one synchronous readahead per window.
+		 */
+		if (ra_window && offset >= ra_next) {
+			vfs_fadvise(file, offset, 2 * ra_window,
+				    POSIX_FADV_WILLNEED);
+			ra_next = offset + ra_window;
+		}
+
+		rbuf_len = integrity_kernel_read(file, offset, rbuf, rbuf_size);
 		if (rbuf_len < 0) {
 			rc = rbuf_len;
 			break;
@@ -11,8 +11,10 @@
 #include <linux/compiler_types.h>
 #include <linux/err.h>
 #include <linux/errno.h>
+#include <linux/hash.h>
 #include <linux/kernel.h>
 #include <linux/lockdep.h>
+#include <linux/log2.h>
 #include <linux/overflow.h>
 #include <linux/rbtree.h>
 #include <linux/refcount.h>
@@ -364,6 +366,7 @@ static void free_ruleset(struct landlock_ruleset *const ruleset)
 	rbtree_postorder_for_each_entry_safe(freeme, next, &ruleset->root, node)
 		free_rule(freeme);
 	put_hierarchy(ruleset->hierarchy);
+	kvfree(ruleset->rule_index);
 	kfree(ruleset);
 }
 
@@ -390,6 +393,39 @@ void landlock_put_ruleset_deferred(struct landlock_ruleset *const ruleset)
 	}
 }
 
+/*
+ * Indexes the rules of a complete, and from now on immutable, domain.  The
+ * index is only an accelerator: if it cannot be allocated, lookups fall back
+ * to walking the rb-tree.
+ */
+static void index_rules(struct landlock_ruleset *const domain)
+{
+	const struct landlock_rule **index;
+	const struct landlock_rule *rule;
+	struct rb_node *node;
+	u32 bits, i;
+
+	if (!domain->num_rules || domain->num_rules > BIT(30))
+		return;
+
+	bits = order_base_2(domain->num_rules) + 1;
+	index = kvcalloc(BIT(bits), sizeof(*index),
+			 GFP_KERNEL_ACCOUNT | __GFP_NOWARN);
+	if (!index)
+		return;
+
+	for (node = rb_first(&domain->root); node; node = rb_next(node)) {
+		rule = rb_entry(node, struct landlock_rule, node);
+		i = hash_ptr(rule->object, bits);
+		while (index[i])
+			i = (i + 1) & (BIT(bits) - 1);
+		index[i] = rule;
+	}
+
+	domain->rule_index_bits = bits;
+	domain->rule_index = index;
+}
+
 /**
  * landlock_merge_ruleset - Merge a ruleset with a domain
  *
@@ -441,6 +477,8 @@ landlock_merge_ruleset(struct landlock_ruleset *const parent,
 	if (err)
 		goto out_put_dom;
 
+	index_rules(new_dom);
+
 	return new_dom;
 
 out_put_dom:
@@ -459,6 +497,20 @@ landlock_find_rule(const struct landlock_ruleset *const ruleset,
 
 	if (!object)
 		return NULL;
+
+	if (ruleset->rule_index) {
+		const u32 mask = BIT(ruleset->rule_index_bits) - 1;
+		const struct landlock_rule *rule;
+		u32 i;
+
+		for (i = hash_ptr(object, ruleset->rule_index_bits);;
+		     i = (i + 1) & mask) {
+			rule = ruleset->rule_index[i];
+			if (!rule || rule->object == object)
+				return rule;
+		}
+	}
+
 	node = ruleset->root.rb_node;
 	while (node) {
 		struct landlock_rule *this =
@@ -104,6 +104,20 @@ struct landlock_ruleset {
 	 * domain vanishes.  This is needed for the ptrace protection.
 	 */
 	struct landlock_hierarchy *hierarchy;
+	/**
+	 * @rule_index: Open addressing hash table of the rules in @root, keyed
+	 * by object address.  Built once when a domain is created, so that
+	 * landlock_find_rule() costs one hash probe per path component
+	 * instead of an rb-tree walk that grows with the number of rules.
+	 * NULL for non-domain rulesets, in which case @root is walked.
+	 */
+	const struct landlock_rule **rule_index;
+	/**
+	 * @rule_index_bits: Log2 of the number of @rule_index slots, which is
+	 * at least twice @num_rules so that probing always ends on an empty
+	 * slot.
+	 */
+	u32 rule_index_bits;
 	union {
 		/**
 		 * @work_free: Enables to free a ruleset within a lockless
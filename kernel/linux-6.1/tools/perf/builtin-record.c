@@ -172,6 +172,7 @@ struct record {
 	bool			timestamp_filename;
 	bool			timestamp_boundary;
 	bool			off_cpu;
+	bool			stack_ids;
 	struct switch_output	switch_output;
 	unsigned long long	samples;
 	unsigned long		output_max_size;	/* = 0: unlimited */
@@ -1316,6 +1317,17 @@ static int record__open(struct record *rec)
 
 	evlist__config(evlist, opts, &callchain_param);
 
+	/*
+	 * Each distinct callchain is written once, as a PERF_RECORD_STACK_ID,
+	 * and samples carry its id.
+	 */
+	if (rec->stack_ids) {
+		evlist__for_each_entry(evlist, pos) {
+			if (pos->core.attr.sample_type & PERF_SAMPLE_CALLCHAIN)
+				evsel__set_sample_bit(pos, STACK_ID);
+		}
+	}
+
 	evlist__for_each_entry(evlist, pos) {
 try_again:
 		if (evsel__open(pos, pos->core.cpus, pos->core.threads) < 0) {
@@ -3468,6 +3480,8 @@ static struct option __record_options[] = {
 		    "collect kernel callchains"),
 	OPT_BOOLEAN(0, "user-callchains", &record.opts.user_callchains,
 		    "collect user callchains"),
+	OPT_BOOLEAN(0, "stack-ids", &record.stack_ids,
+		    "write each callchain once, samples refer to it by id"),
 	OPT_STRING(0, "clang-path", &llvm_param.clang_path, "clang path",
 		   "clang binary to use for compiling BPF scriptlets"),
 	OPT_STRING(0, "clang-opt", &llvm_param.clang_opt, "clang options",
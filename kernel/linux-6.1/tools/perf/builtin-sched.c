@@ -161,6 +161,14 @@ struct trace_sched_handler {
 				  struct evsel *evsel,
 				  struct perf_sample *sample,
 				  struct machine *machine);
+
+	/* sched_waking, when it was recorded instead of sched_wakeup */
+	int (*waking_event)(struct perf_sched *sched, struct evsel *evsel,
+			    struct perf_sample *sample, struct machine *machine);
+
+	/* aurora:aurora_sched_pick, from the Aurora AI scheduler module */
+	int (*aurora_pick_event)(struct perf_sched *sched, struct evsel *evsel,
+				 struct perf_sample *sample, struct machine *machine);
 };
 
 #define COLOR_PIDS PERF_COLOR_BLUE
@@ -178,6 +186,37 @@ struct perf_sched_map {
 	const char		*cpus_str;
 };
 
+/*
+ * Burst prediction classes of the Aurora AI scheduler, the class and
+ * cfs_class fields of aurora:aurora_sched_pick
+ */
+enum aurora_class {
+	AURORA_CLASS_INTERACTIVE,
+	AURORA_CLASS_CPU_BOUND,
+	AURORA_CLASS_IO_BOUND,
+	AURORA_CLASS_MIXED,
+	AURORA_NR_CLASSES
+};
+
+static const char * const aurora_class_names[AURORA_NR_CLASSES] = {
+	[AURORA_CLASS_INTERACTIVE] = "interactive",
+	[AURORA_CLASS_CPU_BOUND]   = "cpu_bound",
+	[AURORA_CLASS_IO_BOUND]    = "io_bound",
+	[AURORA_CLASS_MIXED]	   = "mixed",
+};
+
+/* per class totals of perf sched aurora */
+struct aurora_class_stats {
+	u64 nr_picks;
+	u64 nr_differ;		/* picks that were not the CFS candidate */
+	u64 nr_agree_lat;	/* wakeup latency of picks CFS agreed with */
+	u64 agree_lat;
+	u64 nr_differ_lat;	/* wakeup latency of picks CFS would not make */
+	u64 differ_lat;
+	u64 nr_passed;		/* CFS candidates an AI pick went past */
+	u64 passed_lat;		/* their wait from that pick until they ran */
+};
+
 struct perf_sched {
 	struct perf_tool tool;
 	const char	 *sort_order;
@@ -247,6 +286,10 @@ struct perf_sched {
 	struct perf_time_interval ptime;
 	struct perf_time_interval hist_time;
 	volatile bool   thread_funcs_exit;
+
+	/* aurora command */
+	struct aurora_class_stats aurora[AURORA_NR_CLASSES];
+	u64		aurora_bad_class;
 };
 
 /* per thread run time data */
@@ -272,6 +315,13 @@ struct thread_runtime {
 	bool comm_changed;
 
 	u64 migrations;
+
+	/* aurora command */
+	u64 aurora_passed;	/* time an AI pick first went past it, or 0 */
+	int aurora_passed_class;
+	int aurora_class;	/* class at its last pick */
+	bool aurora_picked;	/* picked, not switched in yet */
+	bool aurora_differs;	/* ... and CFS would have picked another task */
 };
 
 /* per event run time data */
@@ -1762,6 +1812,32 @@ static int process_sched_migrate_task_event(struct perf_tool *tool,
 	return 0;
 }
 
+static int process_sched_waking_event(struct perf_tool *tool,
+				      struct evsel *evsel,
+				      struct perf_sample *sample,
+				      struct machine *machine)
+{
+	struct perf_sched *sched = container_of(tool, struct perf_sched, tool);
+
+	if (sched->tp_handler->waking_event)
+		return sched->tp_handler->waking_event(sched, evsel, sample, machine);
+
+	return 0;
+}
+
+static int process_aurora_pick_event(struct perf_tool *tool,
+				     struct evsel *evsel,
+				     struct perf_sample *sample,
+				     struct machine *machine)
+{
+	struct perf_sched *sched = container_of(tool, struct perf_sched, tool);
+
+	if (sched->tp_handler->aurora_pick_event)
+		return sched->tp_handler->aurora_pick_event(sched, evsel, sample, machine);
+
+	return 0;
+}
+
 typedef int (*tracepoint_handler)(struct perf_tool *tool,
 				  struct evsel *evsel,
 				  struct perf_sample *sample,
@@ -1822,6 +1898,8 @@ static int perf_sched__read_events(struct perf_sched *sched)
 		{ "sched:sched_wakeup",	      process_sched_wakeup_event, },
 		{ "sched:sched_wakeup_new",   process_sched_wakeup_event, },
 		{ "sched:sched_migrate_task", process_sched_migrate_task_event, },
+		{ "sched:sched_waking",	      process_sched_waking_event, },
+		{ "aurora:aurora_sched_pick", process_aurora_pick_event, },
 	};
 	struct perf_session *session;
 	struct perf_data data = {
@@ -3272,6 +3350,211 @@ out_free_cpus_switch_event:
 	return rc;
 }
 
+/*
+ * perf sched aurora: what the AI ordering of the Aurora scheduler changed.
+ * Every aurora:aurora_sched_pick names the task picked and the one CFS
+ * would have run from the same queue. Joined with the wakeups and
+ * sched_switch, each pick's wakeup latency is accounted to its class,
+ * split by whether CFS would have made the same pick, and every CFS
+ * candidate passed over is charged the time until it did run.
+ */
+static int aurora_wakeup_event(struct perf_sched *sched __maybe_unused,
+			       struct evsel *evsel,
+			       struct perf_sample *sample,
+			       struct machine *machine)
+{
+	const u32 pid = evsel__intval(evsel, sample, "pid");
+	struct thread_runtime *tr;
+	struct thread *thread;
+
+	thread = machine__findnew_thread(machine, -1, pid);
+	if (thread == NULL)
+		return -1;
+
+	tr = thread__get_runtime(thread);
+	if (tr && !tr->ready_to_run)
+		tr->ready_to_run = sample->time;
+
+	thread__put(thread);
+	return 0;
+}
+
+static int aurora_switch_event(struct perf_sched *sched,
+			       struct evsel *evsel,
+			       struct perf_sample *sample,
+			       struct machine *machine)
+{
+	const u32 prev_pid = evsel__intval(evsel, sample, "prev_pid"),
+		  next_pid = evsel__intval(evsel, sample, "next_pid");
+	const u64 prev_state = evsel__intval(evsel, sample, "prev_state");
+	struct aurora_class_stats *st;
+	struct thread_runtime *tr;
+	struct thread *thread;
+	u64 t = sample->time;
+
+	if (prev_pid) {
+		thread = machine__findnew_thread(machine, -1, prev_pid);
+		if (thread == NULL)
+			return -1;
+
+		/* a preempted task is runnable again right away */
+		tr = thread__get_runtime(thread);
+		if (tr)
+			tr->ready_to_run = prev_state == TASK_RUNNING ? t : 0;
+		thread__put(thread);
+	}
+
+	if (!next_pid)
+		return 0;
+
+	thread = machine__findnew_thread(machine, -1, next_pid);
+	if (thread == NULL)
+		return -1;
+
+	tr = thread__get_runtime(thread);
+	if (tr == NULL)
+		goto out_put;
+
+	if (tr->aurora_picked && tr->ready_to_run && t >= tr->ready_to_run) {
+		st = &sched->aurora[tr->aurora_class];
+		if (tr->aurora_differs) {
+			st->nr_differ_lat++;
+			st->differ_lat += t - tr->ready_to_run;
+		} else {
+			st->nr_agree_lat++;
+			st->agree_lat += t - tr->ready_to_run;
+		}
+	}
+
+	if (tr->aurora_passed && t >= tr->aurora_passed) {
+		st = &sched->aurora[tr->aurora_passed_class];
+		st->nr_passed++;
+		st->passed_lat += t - tr->aurora_passed;
+	}
+
+	tr->aurora_picked = false;
+	tr->aurora_passed = 0;
+	tr->ready_to_run = 0;
+out_put:
+	thread__put(thread);
+	return 0;
+}
+
+static int aurora_pick_event(struct perf_sched *sched,
+			     struct evsel *evsel,
+			     struct perf_sample *sample,
+			     struct machine *machine)
+{
+	const u32 pid = evsel__intval(evsel, sample, "pid"),
+		  cfs_pid = evsel__intval(evsel, sample, "cfs_pid");
+	const u32 class = evsel__intval(evsel, sample, "class"),
+		  cfs_class = evsel__intval(evsel, sample, "cfs_class");
+	struct thread_runtime *tr;
+	struct thread *thread;
+	bool differs = pid != cfs_pid;
+
+	if (class >= AURORA_NR_CLASSES || cfs_class >= AURORA_NR_CLASSES) {
+		sched->aurora_bad_class++;
+		return 0;
+	}
+
+	sched->aurora[class].nr_picks++;
+	if (differs)
+		sched->aurora[class].nr_differ++;
+
+	thread = machine__findnew_thread(machine, -1, pid);
+	if (thread == NULL)
+		return -1;
+
+	tr = thread__get_runtime(thread);
+	if (tr) {
+		tr->aurora_picked = true;
+		tr->aurora_differs = differs;
+		tr->aurora_class = class;
+	}
+	thread__put(thread);
+
+	if (!differs)
+		return 0;
+
+	thread = machine__findnew_thread(machine, -1, cfs_pid);
+	if (thread == NULL)
+		return -1;
+
+	/* charged from the first pick that went past it */
+	tr = thread__get_runtime(thread);
+	if (tr && !tr->aurora_passed) {
+		tr->aurora_passed = sample->time;
+		tr->aurora_passed_class = cfs_class;
+	}
+	thread__put(thread);
+
+	return 0;
+}
+
+static double aurora_avg_ms(u64 total, u64 nr)
+{
+	return nr ? (double)total / nr / NSEC_PER_MSEC : 0.0;
+}
+
+static int perf_sched__aurora(struct perf_sched *sched)
+{
+	u64 nr_picks = 0;
+	int rc = -1, c;
+
+	setup_pager();
+
+	if (setup_cpus_switch_event(sched))
+		return rc;
+
+	if (perf_sched__read_events(sched))
+		goto out_free_cpus_switch_event;
+
+	for (c = 0; c < AURORA_NR_CLASSES; c++)
+		nr_picks += sched->aurora[c].nr_picks;
+
+	if (!nr_picks) {
+		pr_err("No aurora:aurora_sched_pick events, was ai_scheduler loaded during perf sched record?\n");
+		goto out_free_cpus_switch_event;
+	}
+
+	printf("\n ------------------------------------------------------------------------------------------------------------------\n");
+	printf("  Class        |    Picks |  Not CFS | Avg delay ms    | Avg delay ms    | Delta ms   |   Passed | Avg extra wait ms |\n");
+	printf("               |          |          | (as CFS)        | (AI only)       |            |          | (CFS candidate)   |\n");
+	printf(" ------------------------------------------------------------------------------------------------------------------\n");
+
+	for (c = 0; c < AURORA_NR_CLASSES; c++) {
+		struct aurora_class_stats *st = &sched->aurora[c];
+		double agree = aurora_avg_ms(st->agree_lat, st->nr_agree_lat);
+		double differ = aurora_avg_ms(st->differ_lat, st->nr_differ_lat);
+
+		if (!st->nr_picks && !st->nr_passed)
+			continue;
+
+		printf("  %-12s | %8" PRIu64 " | %7.2f%% | %13.3f   | %13.3f   | %+10.3f | %8" PRIu64 " | %15.3f   |\n",
+		       aurora_class_names[c], st->nr_picks,
+		       st->nr_picks ? 100.0 * st->nr_differ / st->nr_picks : 0.0,
+		       agree, differ,
+		       st->nr_agree_lat && st->nr_differ_lat ? differ - agree : 0.0,
+		       st->nr_passed,
+		       aurora_avg_ms(st->passed_lat, st->nr_passed));
+	}
+
+	printf(" ------------------------------------------------------------------------------------------------------------------\n");
+
+	if (sched->aurora_bad_class)
+		printf("  INFO: %" PRIu64 " picks with an unknown class skipped\n",
+		       sched->aurora_bad_class);
+	print_bad_events(sched);
+	printf("\n");
+
+	rc = 0;
+
+out_free_cpus_switch_event:
+	free_cpus_switch_event(sched);
+	return rc;
+}
+
 static int setup_map_cpus(struct perf_sched *sched)
 {
 	sched->max_cpu.cpu  = sysconf(_SC_NPROCESSORS_CONF);
@@ -3487,6 +3770,13 @@ static int __cmd_record(int argc, const char **argv)
 	unsigned int schedstat_argc = schedstat_events_exposed() ?
 		ARRAY_SIZE(schedstat_args) : 0;
 
+	/* Aurora AI scheduler decisions, for perf sched aurora */
+	const char * const aurora_args[] = {
+		"-e", "aurora:aurora_sched_pick",
+	};
+	struct tep_event *aurora_event = trace_event__tp_format("aurora", "aurora_sched_pick");
+	unsigned int aurora_argc = !IS_ERR(aurora_event) ? ARRAY_SIZE(aurora_args) : 0;
+
 	struct tep_event *waking_event;
 	int ret;
 
@@ -3494,7 +3784,7 @@ static int __cmd_record(int argc, const char **argv)
 	 * +2 for either "-e", "sched:sched_wakeup" or
 	 * "-e", "sched:sched_waking"
 	 */
-	rec_argc = ARRAY_SIZE(record_args) + 2 + schedstat_argc + argc - 1;
+	rec_argc = ARRAY_SIZE(record_args) + 2 + schedstat_argc + aurora_argc + argc - 1;
 	rec_argv = calloc(rec_argc + 1, sizeof(char *));
 	if (rec_argv == NULL)
 		return -ENOMEM;
@@ -3517,6 +3807,9 @@ static int __cmd_record(int argc, const char **argv)
 	for (j = 0; j < schedstat_argc; j++)
 		rec_argv[i++] = strdup(schedstat_args[j]);
 
+	for (j = 0; j < aurora_argc; j++)
+		rec_argv[i++] = strdup(aurora_args[j]);
+
 	for (j = 1; j < (unsigned int)argc; j++, i++)
 		rec_argv[i] = strdup(argv[j]);
 
@@ -3638,9 +3931,13 @@ int cmd_sched(int argc, const char **argv)
 		"perf sched timehist [<options>]",
 		NULL
 	};
+	const char * const aurora_usage[] = {
+		"perf sched aurora [<options>]",
+		NULL
+	};
 	const char *const sched_subcommands[] = { "record", "latency", "map",
 						  "replay", "script",
-						  "timehist", NULL };
+						  "timehist", "aurora", NULL };
 	const char *sched_usage[] = {
 		NULL,
 		NULL
@@ -3659,6 +3956,12 @@ int cmd_sched(int argc, const char **argv)
 		.switch_event	    = replay_switch_event,
 		.fork_event	    = replay_fork_event,
 	};
+	struct trace_sched_handler aurora_ops  = {
+		.wakeup_event	    = aurora_wakeup_event,
+		.waking_event	    = aurora_wakeup_event,
+		.switch_event	    = aurora_switch_event,
+		.aurora_pick_event  = aurora_pick_event,
+	};
 	int ret;
 
 	argc = parse_options_subcommand(argc, argv, sched_options, sched_subcommands,
@@ -3721,6 +4024,14 @@ int cmd_sched(int argc, const char **argv)
 			return ret;
 
 		return perf_sched__timehist(&sched);
+	} else if (!strcmp(argv[0], "aurora")) {
+		sched.tp_handler = &aurora_ops;
+		if (argc) {
+			argc = parse_options(argc, argv, sched_options, aurora_usage, 0);
+			if (argc)
+				usage_with_options(aurora_usage, sched_options);
+		}
+		return perf_sched__aurora(&sched);
 	} else {
 		usage_with_options(sched_usage, sched_options);
 	}
@@ -36,6 +36,39 @@ static bool kvm_dirty_ring_full(struct kvm_dirty_ring *ring)
 	return kvm_dirty_ring_used(ring) >= ring->size;
 }
 
+/*
+ * Each bit of @mask is the first page of a granule.  Clear the granules'
+ * pending bits before write protecting them again: a write that slips in
+ * between pushes a new entry instead of being lost.
+ */
+static void kvm_reset_dirty_granules(struct kvm *kvm,
+				     struct kvm_memory_slot *memslot,
+				     u64 offset, unsigned long mask)
+{
+	u32 shift = kvm->dirty_ring_granule_shift;
+	unsigned long bit;
+
+	if (memslot->dirty_bitmap) {
+		for_each_set_bit(bit, &mask, BITS_PER_LONG)
+			clear_bit((offset + bit) >> shift, memslot->dirty_bitmap);
+		smp_mb__after_atomic();
+	}
+
+	KVM_MMU_LOCK(kvm);
+	for_each_set_bit(bit, &mask, BITS_PER_LONG) {
+		u64 gfn = offset + bit;
+		u64 end = min_t(u64, gfn + (1ULL << shift), memslot->npages);
+
+		for (; gfn < end; gfn += BITS_PER_LONG) {
+			u64 n = end - gfn;
+
+			kvm_arch_mmu_enable_log_dirty_pt_masked(kvm, memslot, gfn,
+				n >= BITS_PER_LONG ? ~0UL : (1UL << n) - 1);
+		}
+	}
+	KVM_MMU_UNLOCK(kvm);
+}
+
 static void kvm_reset_dirty_gfn(struct kvm *kvm, u32 slot, u64 offset, u64 mask)
 {
 	struct kvm_memory_slot *memslot;
@@ -52,6 +85,11 @@ static void kvm_reset_dirty_gfn(struct kvm *kvm, u32 slot, u64 offset, u64 mask)
 	if (!memslot || (offset + __fls(mask)) >= memslot->npages)
 		return;
 
+	if (kvm->dirty_ring_granule_shift) {
+		kvm_reset_dirty_granules(kvm, memslot, offset, mask);
+		return;
+	}
+
 	KVM_MMU_LOCK(kvm);
 	kvm_arch_mmu_enable_log_dirty_pt_masked(kvm, memslot, offset, mask);
 	KVM_MMU_UNLOCK(kvm);
@@ -68,6 +106,7 @@ int kvm_dirty_ring_alloc(struct kvm_dirty_ring *ring, int index, u32 size)
 	ring->dirty_index = 0;
 	ring->reset_index = 0;
 	ring->index = index;
+	mutex_init(&ring->reset_lock);
 
 	return 0;
 }
@@ -99,6 +138,8 @@ int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 	/* This is only needed to make compilers happy */
 	cur_slot = cur_offset = mask = 0;
 
+	mutex_lock(&ring->reset_lock);
+
 	while (true) {
 		entry = &ring->dirty_gfns[ring->reset_index & (ring->size - 1)];
 
@@ -144,6 +185,8 @@ int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 
 	trace_kvm_dirty_ring_reset(ring);
 
+	mutex_unlock(&ring->reset_lock);
+
 	return count;
 }
 
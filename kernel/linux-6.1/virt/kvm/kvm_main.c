@@ -1409,6 +1409,22 @@ static int kvm_alloc_dirty_bitmap(struct kvm_memory_slot *memslot)
 	return 0;
 }
 
+/* One bit per dirty ring granule, see kvm->dirty_ring_granule_shift. */
+static int kvm_alloc_dirty_granule_bitmap(struct kvm *kvm,
+					  struct kvm_memory_slot *memslot)
+{
+	unsigned long granules = DIV_ROUND_UP(memslot->npages,
+					      1UL << kvm->dirty_ring_granule_shift);
+
+	memslot->dirty_bitmap = __vcalloc(BITS_TO_LONGS(granules),
+					  sizeof(unsigned long),
+					  GFP_KERNEL_ACCOUNT);
+	if (!memslot->dirty_bitmap)
+		return -ENOMEM;
+
+	return 0;
+}
+
 static struct kvm_memslots *kvm_get_inactive_memslots(struct kvm *kvm, int as_id)
 {
 	struct kvm_memslots *active = __kvm_memslots(kvm, as_id);
@@ -1626,7 +1642,8 @@ static int kvm_prepare_memory_region(struct kvm *kvm,
 	 * will be freed on "commit".  If logging is enabled in both old and
 	 * new, reuse the existing bitmap.  If logging is enabled only in the
 	 * new and KVM isn't using a ring buffer, allocate and initialize a
-	 * new bitmap.
+	 * new bitmap.  A ring buffer with a dirty granule gets a bitmap of
+	 * the granules that are pending in the rings.
 	 */
 	if (change != KVM_MR_DELETE) {
 		if (!(new->flags & KVM_MEM_LOG_DIRTY_PAGES))
@@ -1640,6 +1657,10 @@ static int kvm_prepare_memory_region(struct kvm *kvm,
 
 			if (kvm_dirty_log_manual_protect_and_init_set(kvm))
 				bitmap_set(new->dirty_bitmap, 0, new->npages);
+		} else if (kvm->dirty_ring_granule_shift) {
+			r = kvm_alloc_dirty_granule_bitmap(kvm, new);
+			if (r)
+				return r;
 		}
 	}
 
@@ -3329,11 +3350,25 @@ void mark_page_dirty_in_slot(struct kvm *kvm,
 		unsigned long rel_gfn = gfn - memslot->base_gfn;
 		u32 slot = (memslot->as_id << 16) | memslot->id;
 
-		if (kvm->dirty_ring_size)
+		if (kvm->dirty_ring_size) {
+			u32 shift = kvm->dirty_ring_granule_shift;
+
+			/*
+			 * Push a granule once; pages dirtied until userspace
+			 * resets it are covered by the entry already queued.
+			 */
+			if (shift) {
+				if (memslot->dirty_bitmap &&
+				    test_and_set_bit(rel_gfn >> shift,
+						     memslot->dirty_bitmap))
+					return;
+				rel_gfn &= ~((1UL << shift) - 1);
+			}
 			kvm_dirty_ring_push(&vcpu->dirty_ring,
 					    slot, rel_gfn);
-		else
+		} else {
 			set_bit_le(rel_gfn, memslot->dirty_bitmap);
+		}
 	}
 }
 EXPORT_SYMBOL_GPL(mark_page_dirty_in_slot);
@@ -4541,6 +4576,14 @@ static long kvm_vm_ioctl_check_extension_generic(struct kvm *kvm, long arg)
 #else
 		return 0;
 #endif
+	case KVM_CAP_DIRTY_LOG_RING_GRANULE:
+#ifdef CONFIG_HAVE_KVM_DIRTY_RING
+		return KVM_DIRTY_RING_MAX_GRANULE_SHIFT;
+#else
+		return 0;
+#endif
+	case KVM_CAP_DIRTY_LOG_RING_RESET_BATCH:
+		return IS_ENABLED(CONFIG_HAVE_KVM_DIRTY_RING);
 	case KVM_CAP_BINARY_STATS_FD:
 	case KVM_CAP_SYSTEM_EVENT_DATA:
 		return 1;
@@ -4588,6 +4631,32 @@ static int kvm_vm_ioctl_enable_dirty_log_ring(struct kvm *kvm, u32 size)
 	return r;
 }
 
+/*
+ * Make each dirty ring entry stand for 2^@shift pages, at most a huge
+ * page.  Migration then sees one entry, and one write fault, per
+ * granule and iteration instead of one per page.
+ */
+static int kvm_vm_ioctl_set_dirty_ring_granule(struct kvm *kvm, u64 shift)
+{
+	int r;
+
+	if (shift > KVM_DIRTY_RING_MAX_GRANULE_SHIFT)
+		return -EINVAL;
+
+	mutex_lock(&kvm->lock);
+
+	/* Like the ring size, this is fixed once vcpus exist */
+	if (kvm->created_vcpus) {
+		r = -EINVAL;
+	} else {
+		kvm->dirty_ring_granule_shift = shift;
+		r = 0;
+	}
+
+	mutex_unlock(&kvm->lock);
+	return r;
+}
+
 static int kvm_vm_ioctl_reset_dirty_pages(struct kvm *kvm)
 {
 	unsigned long i;
@@ -4610,6 +4679,53 @@ static int kvm_vm_ioctl_reset_dirty_pages(struct kvm *kvm)
 	return cleared;
 }
 
+/*
+ * Unlike KVM_RESET_DIRTY_RINGS this only holds kvm->srcu, so harvesting
+ * threads that each own a set of vcpus can reset their rings in parallel.
+ */
+static int kvm_vm_ioctl_reset_dirty_rings_batch(struct kvm *kvm,
+				struct kvm_dirty_ring_reset __user *argp)
+{
+	struct kvm_dirty_ring_reset batch;
+	struct kvm_vcpu *vcpu;
+	int r = 0, cleared = 0;
+	u32 i, id;
+	int idx;
+
+	if (!kvm->dirty_ring_size)
+		return -EINVAL;
+
+	if (copy_from_user(&batch, argp, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.flags || batch.nr_vcpus > KVM_MAX_VCPUS)
+		return -EINVAL;
+
+	idx = srcu_read_lock(&kvm->srcu);
+
+	for (i = 0; i < batch.nr_vcpus; i++) {
+		if (get_user(id, &argp->vcpu_ids[i])) {
+			r = -EFAULT;
+			break;
+		}
+
+		vcpu = kvm_get_vcpu_by_id(kvm, id);
+		if (!vcpu) {
+			r = -ENOENT;
+			break;
+		}
+
+		cleared += kvm_dirty_ring_reset(kvm, &vcpu->dirty_ring);
+	}
+
+	srcu_read_unlock(&kvm->srcu, idx);
+
+	if (cleared)
+		kvm_flush_remote_tlbs(kvm);
+
+	return r ? r : cleared;
+}
+
 int __attribute__((weak)) kvm_vm_ioctl_enable_cap(struct kvm *kvm,
 						  struct kvm_enable_cap *cap)
 {
@@ -4656,6 +4772,12 @@ static int kvm_vm_ioctl_enable_cap_generic(struct kvm *kvm,
 			return -EINVAL;
 
 		return kvm_vm_ioctl_enable_dirty_log_ring(kvm, cap->args[0]);
+	case KVM_CAP_DIRTY_LOG_RING_GRANULE:
+		if (!kvm_vm_ioctl_check_extension_generic(kvm, cap->cap) ||
+		    cap->flags)
+			return -EINVAL;
+
+		return kvm_vm_ioctl_set_dirty_ring_granule(kvm, cap->args[0]);
 	default:
 		return kvm_vm_ioctl_enable_cap(kvm, cap);
 	}
@@ -4891,6 +5013,9 @@ static long kvm_vm_ioctl(struct file *filp,
 	case KVM_RESET_DIRTY_RINGS:
 		r = kvm_vm_ioctl_reset_dirty_pages(kvm);
 		break;
+	case KVM_RESET_DIRTY_RINGS_BATCH:
+		r = kvm_vm_ioctl_reset_dirty_rings_batch(kvm, argp);
+		break;
 	case KVM_GET_STATS_FD:
 		r = kvm_vm_ioctl_get_stats_fd(kvm);
 		break;
@@ -75,6 +75,15 @@
  * task's fpsimd_cpu are still mutually in sync. If this is the case, we
  * can omit the FPSIMD restore.
  *
+ * The restore is deferred to userland resume but not beyond it: EL0 FPSIMD
+ * accesses are not trapped, so a task that does not touch the registers in
+ * its next slice still pays for loading them. Restoring on first use instead
+ * would leave another task's values in the registers behind the trap, the
+ * pattern behind the lazy FPU state leak (CVE-2018-3665) that made x86 give
+ * up lazy switching. SVE, where the state is large, already avoids most of
+ * the cost: only the FPSIMD subset is loaded until the task takes an SVE
+ * access trap, and syscalls discard the rest lazily.
+ *
  * As an optimization, we use the thread_info flag TIF_FOREIGN_FPSTATE to
  * indicate whether or not the userland FPSIMD state of the current task is
  * present in the registers. The flag is set unless the FPSIMD registers of this
@@ -858,6 +858,75 @@ static int get_user_mapping_size(struct kvm *kvm, u64 addr)
 	return BIT(ARM64_HW_PGTABLE_LEVEL_SHIFT(level));
 }
 
+struct user_folio_walk_data {
+	kvm_pfn_t	pfn;		/* pfn the next PTE must map */
+	bool		writable;	/* PTEs must allow writes */
+};
+
+static int user_folio_walker(const struct kvm_pgtable_visit_ctx *ctx,
+			     enum kvm_pgtable_walk_flags visit)
+{
+	struct user_folio_walk_data *data = ctx->arg;
+
+	if (ctx->level != KVM_PGTABLE_LAST_LEVEL || !kvm_pte_valid(ctx->old))
+		return -EAGAIN;
+
+	if (__phys_to_pfn(kvm_pte_to_phys(ctx->old)) != data->pfn)
+		return -EAGAIN;
+
+	if (data->writable && !pte_write(__pte(ctx->old)))
+		return -EAGAIN;
+
+	data->pfn++;
+	return 0;
+}
+
+/*
+ * Userspace may map a PMD sized folio with PTEs: a large page cache folio,
+ * or a THP whose PMD got split.  Stage 2 can still use a block for it,
+ * as long as every PTE in the PMD range maps the matching page of the
+ * folio and permits what stage 2 is going to grant.
+ */
+static bool user_range_maps_huge_folio(struct kvm *kvm, u64 addr,
+				       kvm_pfn_t pfn, bool writable)
+{
+	struct kvm_pgtable pgt = {
+		.pgd		= (kvm_pteref_t)kvm->mm->pgd,
+		.ia_bits	= vabits_actual,
+		.start_level	= (KVM_PGTABLE_LAST_LEVEL -
+				   ARM64_HW_PGTABLE_LEVELS(pgt.ia_bits) + 1),
+		.mm_ops		= &kvm_user_mm_ops,
+	};
+	struct user_folio_walk_data data = {
+		.pfn		= pfn & ~(PTRS_PER_PMD - 1),
+		.writable	= writable,
+	};
+	struct kvm_pgtable_walker walker = {
+		.cb	= user_folio_walker,
+		.arg	= &data,
+		.flags	= KVM_PGTABLE_WALK_LEAF,
+	};
+	struct folio *folio;
+	unsigned long flags;
+	int ret;
+
+	if (!pfn_valid(pfn))
+		return false;
+
+	folio = page_folio(pfn_to_page(pfn));
+	if (folio_nr_pages(folio) < PTRS_PER_PMD ||
+	    data.pfn < folio_pfn(folio) ||
+	    data.pfn + PTRS_PER_PMD > folio_pfn(folio) + folio_nr_pages(folio))
+		return false;
+
+	/* Same hazard against page table teardown as get_user_mapping_size() */
+	local_irq_save(flags);
+	ret = kvm_pgtable_walk(&pgt, addr & PMD_MASK, PMD_SIZE, &walker);
+	local_irq_restore(flags);
+
+	return !ret;
+}
+
 static struct kvm_pgtable_mm_ops kvm_s2_mm_ops = {
 	.zalloc_page		= stage2_memcache_zalloc_page,
 	.zalloc_pages_exact	= kvm_s2_zalloc_pages_exact,
@@ -1358,17 +1427,18 @@ static bool fault_supports_stage2_huge_mapping(struct kvm_memory_slot *memslot,
 }
 
 /*
- * Check if the given hva is backed by a transparent huge page (THP) and
- * whether it can be mapped using block mapping in stage2. If so, adjust
- * the stage2 PFN and IPA accordingly. Only PMD_SIZE THPs are currently
- * supported. This will need to be updated to support other THP sizes.
+ * Check if the given hva is backed by a transparent huge page (THP), or
+ * by a PTE mapped folio of at least PMD size, and whether it can be mapped
+ * using block mapping in stage2. If so, adjust the stage2 PFN and IPA
+ * accordingly. Only PMD_SIZE blocks are currently supported. This will
+ * need to be updated to support other THP sizes.
  *
  * Returns the size of the mapping.
  */
 static long
 transparent_hugepage_adjust(struct kvm *kvm, struct kvm_memory_slot *memslot,
 			    unsigned long hva, kvm_pfn_t *pfnp,
-			    phys_addr_t *ipap)
+			    phys_addr_t *ipap, bool writable)
 {
 	kvm_pfn_t pfn = *pfnp;
 
@@ -1383,7 +1453,8 @@ transparent_hugepage_adjust(struct kvm *kvm, struct kvm_memory_slot *memslot,
 		if (sz < 0)
 			return sz;
 
-		if (sz < PMD_SIZE)
+		if (sz < PMD_SIZE &&
+		    !user_range_maps_huge_folio(kvm, hva, pfn, writable))
 			return PAGE_SIZE;
 
 		*ipap &= PMD_MASK;
@@ -1822,7 +1893,8 @@ static int user_mem_abort(struct kvm_vcpu *vcpu, phys_addr_t fault_ipa,
 		else
 			vma_pagesize = transparent_hugepage_adjust(kvm, memslot,
 								   hva, &pfn,
-								   &fault_ipa);
+								   &fault_ipa,
+								   writable);
 
 		if (vma_pagesize < 0) {
 			ret = vma_pagesize;
@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+"""
+Aurora OS - Boot Profile
+
+Turns the kernel log of a profiling boot (see tools/boot_profile.sh) into
+one timeline per build:
+
+- built-in initcalls, from initcall_debug in init/main.c
+- module init of the Aurora AI modules, from the same initcall_debug lines
+- daemon phases, from the "aurora_boot:" marks aurora_os_main.py writes
+  to /dev/kmsg when booted with aurora.boot_profile
+
+The timeline is written in Chrome trace format (open in Perfetto or
+chrome://tracing) together with folded stacks for flamegraph.pl and a
+summary. With --baseline the summary is checked against an earlier
+build's, and the exit status is 1 when boot regressed.
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+AURORA_MODULES = ("aurora_core", "ai_scheduler", "ai_context_manager", "ai_security")
+
+# Delimits the kernel log the daemon copies to the console after boot
+DUMP_BEGIN = "=== aurora boot profile begin ==="
+DUMP_END = "=== aurora boot profile end ==="
+
+# /dev/kmsg records: "prio,seq,usecs,flags;message"; console lines: "[ secs] message"
+KMSG_RE = re.compile(r"^\d+,\d+,(\d+),[^;]*;(.*)$")
+CONSOLE_RE = re.compile(r"^\[\s*(\d+)\.(\d+)\]\s?(.*)$")
+
+CALLING_RE = re.compile(r"^calling  (\S+?)(?:\+0x[0-9a-f]+/0x[0-9a-f]+)?(?: \[(\w+)\])? @ (\d+)$")
+RETURNED_RE = re.compile(r"^initcall (\S+?)(?:\+0x[0-9a-f]+/0x[0-9a-f]+)?(?: \[(\w+)\])? "
+                         r"returned (-?\d+) after (\d+) usecs$")
+INIT_RE = re.compile(r"^Run (\S+) as init process$")
+MARK_RE = re.compile(r"^aurora_boot: phase=(\S+) start=(\d+\.\d+) end=(\d+\.\d+)$")
+
+
+def read_log(path):
+    """(usecs, message) for each kernel log line, preferring the daemon's dump"""
+    lines = Path(path).read_text(errors="replace").splitlines()
+
+    # The dump holds the whole ring even when the console was quiet during boot
+    if DUMP_BEGIN in lines:
+        start = lines.index(DUMP_BEGIN) + 1
+        end = lines.index(DUMP_END, start) if DUMP_END in lines[start:] else len(lines)
+        entries = []
+        for line in lines[start:end]:
+            match = KMSG_RE.match(line.strip())
+            if match:
+                entries.append((int(match.group(1)), match.group(2)))
+        return entries
+
+    entries = []
+    for line in lines:
+        match = CONSOLE_RE.match(line.strip())
+        if match:
+            usecs = int(match.group(1)) * 1000000 + int(match.group(2).ljust(6, "0")[:6])
+            entries.append((usecs, match.group(3)))
+    return entries
+
+
+def parse(entries):
+    """Build the timeline events and the summary from the log entries"""
+    events = []
+    pending = {}
+    rows = {}
+    init_at = None
+    usable_at = None
+
+    for usecs, message in entries:
+        match = CALLING_RE.match(message)
+        if match:
+            fn, module, pid = match.groups()
+            pending[(fn, module)] = (usecs, int(pid))
+            continue
+
+        match = RETURNED_RE.match(message)
+        if match:
+            fn, module, ret, duration = match.groups()
+            start, pid = pending.pop((fn, module), (usecs - int(duration), 1))
+            if module:
+                track = "modules"
+                stack = ["boot", "modules", module, fn]
+            else:
+                track = "kernel"
+                stack = ["boot", "kernel", "initcalls", fn]
+            events.append({"name": fn, "track": track, "tid": pid, "ts": start,
+                           "dur": int(duration), "stack": stack,
+                           "args": {"ret": int(ret), "module": module or "built-in"}})
+            continue
+
+        match = INIT_RE.match(message)
+        if match and init_at is None:
+            init_at = usecs
+            continue
+
+        match = MARK_RE.match(message)
+        if match:
+            phase, start, end = match.groups()
+            start_us = int(float(start) * 1000000)
+            end_us = int(float(end) * 1000000)
+            if phase == "usable":
+                usable_at = end_us
+            # Components load concurrently, so each gets a row of its own
+            tid = rows.setdefault(phase, len(rows) + 2) if phase.startswith("component:") else 1
+            events.append({"name": phase, "track": "daemon", "tid": tid, "ts": start_us,
+                           "dur": max(end_us - start_us, 0),
+                           "stack": ["boot", "daemon"] + phase.split(":"), "args": {}})
+
+    kernel = [e for e in events if e["track"] == "kernel"]
+    modules = [e for e in events if e["track"] == "modules"]
+    summary = {
+        "kernel_initcalls_ms": sum(e["dur"] for e in kernel) / 1000,
+        "kernel_to_init_ms": init_at / 1000 if init_at is not None else None,
+        "usable_ms": usable_at / 1000 if usable_at is not None else None,
+        "modules_ms": {m: sum(e["dur"] for e in modules if e["args"]["module"] == m) / 1000
+                       for m in AURORA_MODULES
+                       if any(e["args"]["module"] == m for e in modules)},
+        "daemon_ms": {e["name"]: e["dur"] / 1000 for e in events if e["track"] == "daemon"},
+        "slowest_initcalls": [{"name": e["name"], "ms": e["dur"] / 1000}
+                              for e in sorted(kernel, key=lambda e: -e["dur"])[:10]],
+    }
+    return events, summary
+
+
+def chrome_trace(events, summary, build):
+    """Chrome trace events, one process per track"""
+    tracks = {"kernel": 1, "modules": 2, "daemon": 3}
+    trace = [{"name": "process_name", "ph": "M", "pid": pid, "args": {"name": name}}
+             for name, pid in tracks.items()]
+    for e in events:
+        trace.append({"name": e["name"], "cat": e["track"], "ph": "X", "ts": e["ts"],
+                      "dur": e["dur"], "pid": tracks[e["track"]], "tid": e["tid"],
+                      "args": e["args"]})
+    return {"traceEvents": trace, "displayTimeUnit": "ms",
+            "metadata": {"build": build, "summary": summary}}
+
+
+def folded(events):
+    """Folded stacks in microseconds, for flamegraph.pl"""
+    totals = {}
+    for e in events:
+        # The usable span covers the other daemon phases
+        if e["track"] == "daemon" and e["name"] == "usable":
+            continue
+        key = ";".join(e["stack"])
+        totals[key] = totals.get(key, 0) + e["dur"]
+    return "".join(f"{key} {value}\n" for key, value in sorted(totals.items()))
+
+
+def compare(summary, baseline, threshold, min_ms):
+    """Regressions of more than threshold percent and min_ms against baseline"""
+    regressions = []
+
+    def check(name, now, before):
+        if now is None or before is None:
+            return
+        if now - before > min_ms and now > before * (1 + threshold / 100):
+            regressions.append(f"{name}: {before:.1f} ms -> {now:.1f} ms")
+
+    for key in ("kernel_initcalls_ms", "kernel_to_init_ms", "usable_ms"):
+        check(key, summary.get(key), baseline.get(key))
+    for group in ("modules_ms", "daemon_ms"):
+        for name, now in summary.get(group, {}).items():
+            check(f"{group[:-3]} {name}", now, baseline.get(group, {}).get(name))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a boot timeline from a profiling boot log")
+    parser.add_argument("log", help="serial console log of the profiling boot")
+    parser.add_argument("--build", default="unknown", help="build identifier for the timeline")
+    parser.add_argument("--output", default="build/boot-profile", help="output directory")
+    parser.add_argument("--baseline", help="summary JSON of an earlier build to check against")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slowdown counted as a regression (default 10)")
+    parser.add_argument("--min-ms", type=float, default=20.0,
+                        help="ignore slowdowns smaller than this (default 20 ms)")
+    args = parser.parse_args()
+
+    entries = read_log(args.log)
+    events, summary = parse(entries)
+    if not events:
+        print(f"❌ No initcall_debug lines or daemon marks in {args.log}")
+        return 2
+
+    out = Path(args.output)
+    out.mkdir(parents=True, exist_ok=True)
+    stem = f"boot-{args.build}"
+    (out / f"{stem}.trace.json").write_text(json.dumps(chrome_trace(events, summary, args.build)))
+    (out / f"{stem}.folded").write_text(folded(events))
+    (out / f"{stem}.summary.json").write_text(json.dumps(summary, indent=2))
+
+    print(f"⏱️  Boot profile for {args.build}")
+    print(f"   Kernel initcalls: {summary['kernel_initcalls_ms']:.1f} ms")
+    if summary["kernel_to_init_ms"] is not None:
+        print(f"   Kernel to init:   {summary['kernel_to_init_ms']:.1f} ms")
+    for module, ms in summary["modules_ms"].items():
+        print(f"   Module {module}: {ms:.1f} ms")
+    for phase, ms in summary["daemon_ms"].items():
+        print(f"   Daemon {phase}: {ms:.1f} ms")
+    if summary["usable_ms"] is not None:
+        print(f"   Usable at:        {summary['usable_ms']:.1f} ms")
+    print(f"   Timeline: {out / (stem + '.trace.json')}")
+
+    if args.baseline:
+        baseline = json.loads(Path(args.baseline).read_text())
+        regressions = compare(summary, baseline, args.threshold, args.min_ms)
+        if regressions:
+            print("❌ Boot regressed:")
+            for line in regressions:
+                print(f"   {line}")
+            return 1
+        print("✅ No boot regressions against baseline")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
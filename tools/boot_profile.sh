@@ -0,0 +1,114 @@
+#!/bin/bash
+
+# Aurora OS Boot Profile
+# Boots an ISO in QEMU with initcall_debug and the daemon's boot marks on,
+# then turns the kernel log into a timeline with tools/boot_profile.py
+#
+# Usage: tools/boot_profile.sh [ISO] [BASELINE_SUMMARY]
+
+set -e
+
+ISO_FILE="${1:-aurora-os-complete-with-pytorch.iso}"
+BASELINE="${2:-${BOOT_PROFILE_BASELINE:-}}"
+OUT_DIR="${BOOT_PROFILE_DIR:-build/boot-profile}"
+BOOT_TIMEOUT="${BOOT_PROFILE_TIMEOUT:-180}"
+BUILD_ID="$(cat VERSION 2>/dev/null || echo unknown)-$(git rev-parse --short HEAD 2>/dev/null || echo local)"
+LOG_FILE="$OUT_DIR/boot-$BUILD_ID.log"
+
+# Quiet console: printing every initcall over the emulated UART would
+# itself dominate the timings, so the daemon dumps the log once usable
+PROFILE_ARGS="initcall_debug aurora.boot_profile log_buf_len=8M loglevel=4 console=ttyS0,115200"
+
+echo "╔══════════════════════════════════════════════╗"
+echo "║   Aurora OS Boot Profile                     ║"
+echo "╚══════════════════════════════════════════════╝"
+echo ""
+
+if [ ! -f "$ISO_FILE" ]; then
+    echo "❌ ERROR: $ISO_FILE not found"
+    exit 1
+fi
+
+if ! command -v qemu-system-x86_64 &> /dev/null; then
+    echo "❌ ERROR: QEMU not installed (sudo apt-get install qemu-system-x86)"
+    exit 1
+fi
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# Boot kernel and initrd directly so the command line can be extended
+extract() {
+    if command -v xorriso &> /dev/null; then
+        xorriso -osirrox on -indev "$ISO_FILE" -extract "$1" "$2" &> /dev/null
+    else
+        bsdtar -xOf "$ISO_FILE" "${1#/}" > "$2"
+    fi
+}
+
+extract /boot/grub/grub.cfg "$WORK_DIR/grub.cfg"
+KERNEL_PATH="$(awk '$1 == "linux" { print $2; exit }' "$WORK_DIR/grub.cfg")"
+INITRD_PATH="$(awk '$1 == "initrd" { print $2; exit }' "$WORK_DIR/grub.cfg")"
+CMDLINE="$(awk '$1 == "linux" { $1 = ""; $2 = ""; print; exit }' "$WORK_DIR/grub.cfg")"
+
+if [ -z "$KERNEL_PATH" ]; then
+    echo "❌ ERROR: No linux entry in the ISO's grub.cfg"
+    exit 1
+fi
+
+extract "$KERNEL_PATH" "$WORK_DIR/vmlinuz"
+INITRD_OPT=()
+if [ -n "$INITRD_PATH" ]; then
+    extract "$INITRD_PATH" "$WORK_DIR/initrd"
+    INITRD_OPT=(-initrd "$WORK_DIR/initrd")
+fi
+
+KVM_OPT=()
+if [ -w /dev/kvm ]; then
+    KVM_OPT=(-enable-kvm -cpu host)
+else
+    echo "⚠️  No KVM: timings are from TCG emulation, compare only like with like"
+fi
+
+mkdir -p "$OUT_DIR"
+: > "$LOG_FILE"
+
+echo "✓ Build: $BUILD_ID"
+echo "  Kernel: $KERNEL_PATH"
+echo "  Log file: $LOG_FILE"
+echo ""
+echo "Booting (up to ${BOOT_TIMEOUT}s)..."
+
+qemu-system-x86_64 \
+    "${KVM_OPT[@]}" \
+    -cdrom "$ISO_FILE" \
+    -kernel "$WORK_DIR/vmlinuz" \
+    "${INITRD_OPT[@]}" \
+    -append "$CMDLINE $PROFILE_ARGS" \
+    -m 4G \
+    -smp 2 \
+    -serial file:"$LOG_FILE" \
+    -display none \
+    -no-reboot &
+QEMU_PID=$!
+
+# Stop as soon as the daemon has dumped the log
+for _ in $(seq "$BOOT_TIMEOUT"); do
+    if grep -q "=== aurora boot profile end ===" "$LOG_FILE"; then
+        break
+    fi
+    if ! kill -0 "$QEMU_PID" 2> /dev/null; then
+        break
+    fi
+    sleep 1
+done
+kill "$QEMU_PID" 2> /dev/null || true
+wait "$QEMU_PID" 2> /dev/null || true
+
+if ! grep -q "=== aurora boot profile end ===" "$LOG_FILE"; then
+    echo "⚠️  The daemon never became usable; profiling the console log only"
+fi
+
+echo ""
+python3 "$(dirname "$0")/boot_profile.py" "$LOG_FILE" \
+    --build "$BUILD_ID" --output "$OUT_DIR" ${BASELINE:+--baseline "$BASELINE"}
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""
+Aurora OS - Performance Lab
+
+Collects the raw suite output of a lab run (see tools/perf_lab.sh) into
+one sample set per metric:
+
+- hooks: aurora_hooks_bench, ns per operation for every run
+- sched: aurora_sched_bench, p50 and p99 wakeup latency per workload and
+  policy, one sample per run
+- perf: perf bench sched messaging and pipe, seconds per run
+- io: fio 4k random reads on the scratch disk, IOPS and p99 latency
+- net: iperf3 over loopback, throughput
+- boot: tools/boot_profile.py summaries, one sample per boot
+
+The samples are written to perf-lab-<build>.json, which later runs take
+as --baseline. A metric regressed when its median moved the wrong way by
+more than --threshold percent and a two-sided Mann-Whitney U test says
+the shift is not noise (p below --alpha); both must hold, so neither a
+large swing on noisy samples nor a tiny but consistent one fails the run.
+"""
+
+import argparse
+import json
+import math
+import re
+import sys
+from pathlib import Path
+
+# "  hackbench-aurora:(40)  |  p50 |  p99 | p99.9 | switches/s | ops/s |"
+SCHED_ROW_RE = re.compile(r"^\s*(\S+):\(\d+\)\s*\|\s*([\d.]+)\s*\|\s*([\d.]+)\s*\|\s*([\d.]+)\s*\|")
+
+# Exact U distribution up to this many samples per side, normal beyond
+EXACT_MAX = 20
+
+
+def add(metrics, name, unit, better, value):
+    metric = metrics.setdefault(name, {"unit": unit, "better": better, "samples": []})
+    metric["samples"].append(value)
+
+
+def run_files(results, prefix, suffix):
+    """The per-run files of a suite, in run order"""
+    files = results.glob(f"{prefix}-*{suffix}")
+    return sorted(files, key=lambda f: int(f.name[len(prefix) + 1:-len(suffix)]))
+
+
+def collect(results, boots, build):
+    """Samples per metric from the raw output of every suite"""
+    metrics = {}
+
+    hooks = results / "hooks.json"
+    if hooks.exists():
+        for name, bench in json.loads(hooks.read_text())["benchmarks"].items():
+            for ns in bench["runs_ns"]:
+                add(metrics, f"hooks {name}", "ns/op", "lower", ns / bench["loops"])
+
+    for path in run_files(results, "sched", ".txt"):
+        for line in path.read_text().splitlines():
+            match = SCHED_ROW_RE.match(line)
+            if match:
+                task, p50, p99, _ = match.groups()
+                add(metrics, f"sched {task} p50", "usec", "lower", float(p50))
+                add(metrics, f"sched {task} p99", "usec", "lower", float(p99))
+
+    for bench in ("messaging", "pipe"):
+        for path in run_files(results, f"perf-{bench}", ".txt"):
+            add(metrics, f"perf sched {bench}", "s", "lower", float(path.read_text().split()[0]))
+
+    for path in run_files(results, "io", ".json"):
+        read = json.loads(path.read_text())["jobs"][0]["read"]
+        add(metrics, "io randread", "IOPS", "higher", read["iops"])
+        add(metrics, "io randread p99", "usec", "lower",
+            read["clat_ns"]["percentile"]["99.000000"] / 1000)
+
+    for path in run_files(results, "net", ".json"):
+        received = json.loads(path.read_text())["end"]["sum_received"]
+        add(metrics, "net tcp loopback", "Gbit/s", "higher", received["bits_per_second"] / 1e9)
+
+    for path in sorted(boots.glob(f"boot-{build}-*.summary.json")):
+        summary = json.loads(path.read_text())
+        for key in ("kernel_to_init_ms", "usable_ms"):
+            if summary.get(key) is not None:
+                add(metrics, f"boot {key[:-3]}", "ms", "lower", summary[key])
+        for module, ms in summary.get("modules_ms", {}).items():
+            add(metrics, f"boot module {module}", "ms", "lower", ms)
+
+    return metrics
+
+
+def median(samples):
+    ordered = sorted(samples)
+    mid = len(ordered) // 2
+    return ordered[mid] if len(ordered) % 2 else (ordered[mid - 1] + ordered[mid]) / 2
+
+
+def u_counts(m, n):
+    """Number of orderings of m against n samples giving each U, no ties"""
+    # counts[j][u] for the first i samples of one side against j of the other
+    counts = [[1] for _ in range(n + 1)]
+    for i in range(1, m + 1):
+        row = [[1]]
+        for j in range(1, n + 1):
+            # The largest sample is either from the first side, beating all j, or not
+            left, up = counts[j], row[j - 1]
+            size = i * j + 1
+            row.append([(left[u - j] if 0 <= u - j < len(left) else 0) +
+                        (up[u] if u < len(up) else 0) for u in range(size)])
+        counts = row
+    return counts[n]
+
+
+def mann_whitney(a, b):
+    """Two-sided p of a Mann-Whitney U test between samples a and b"""
+    m, n = len(a), len(b)
+    pooled = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(pooled)
+    ties = []
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        ties.append(j - i + 1)
+        i = j + 1
+
+    rank_a = sum(r for r, (_, side) in zip(ranks, pooled) if side == 0)
+    u = rank_a - m * (m + 1) / 2
+    u_min = min(u, m * n - u)
+
+    if max(ties) == 1 and m <= EXACT_MAX and n <= EXACT_MAX:
+        counts = u_counts(m, n)
+        p = 2 * sum(counts[:int(u_min) + 1]) / math.comb(m + n, m)
+        return min(p, 1.0)
+
+    mean = m * n / 2
+    total = m + n
+    var = m * n / 12 * (total + 1 - sum(t ** 3 - t for t in ties) / (total * (total - 1)))
+    if var <= 0:
+        return 1.0
+    z = (abs(u - mean) - 0.5) / math.sqrt(var)
+    return min(math.erfc(max(z, 0) / math.sqrt(2)), 1.0)
+
+
+def compare(metrics, baseline, threshold, alpha, min_samples):
+    """(regressions, improvements, skipped) against the baseline's metrics"""
+    regressions, improvements, skipped = [], [], []
+
+    for name, metric in sorted(metrics.items()):
+        before = baseline.get(name)
+        if before is None:
+            continue
+        now_s, before_s = metric["samples"], before["samples"]
+        if len(now_s) < min_samples or len(before_s) < min_samples:
+            skipped.append(f"{name}: {len(before_s)} and {len(now_s)} samples, "
+                           f"need {min_samples}")
+            continue
+
+        now_med, before_med = median(now_s), median(before_s)
+        if before_med == 0:
+            continue
+        change = (now_med - before_med) / before_med * 100
+        worse = change if metric["better"] == "lower" else -change
+        p = mann_whitney(now_s, before_s)
+        line = (f"{name}: {before_med:.4g} -> {now_med:.4g} {metric['unit']} "
+                f"({change:+.1f}%, p={p:.3g})")
+        if p < alpha and worse > threshold:
+            regressions.append(line)
+        elif p < alpha and -worse > threshold:
+            improvements.append(line)
+
+    return regressions, improvements, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Collect and check the results of a perf lab run")
+    parser.add_argument("results", help="results directory the guest wrote")
+    parser.add_argument("--boots", help="directory of the boot profile summaries")
+    parser.add_argument("--build", default="unknown", help="build identifier for the results")
+    parser.add_argument("--kvm", type=int, default=1, help="1 if the VM ran under KVM")
+    parser.add_argument("--output", default="build/perf-lab", help="output directory")
+    parser.add_argument("--baseline", help="perf-lab JSON of an earlier build to check against")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent change of the median counted as a regression (default 5)")
+    parser.add_argument("--alpha", type=float, default=0.01,
+                        help="significance level of the Mann-Whitney U test (default 0.01)")
+    parser.add_argument("--min-samples", type=int, default=5,
+                        help="samples needed on each side to compare a metric (default 5)")
+    args = parser.parse_args()
+
+    results = Path(args.results)
+    metrics = collect(results, Path(args.boots or results), args.build)
+    if not metrics:
+        print(f"❌ No suite results in {args.results}")
+        return 2
+
+    out = Path(args.output)
+    out.mkdir(parents=True, exist_ok=True)
+    kernel = results / "kernel"
+    report = {
+        "build": args.build,
+        "kernel": kernel.read_text().strip() if kernel.exists() else None,
+        "kvm": bool(args.kvm),
+        "metrics": metrics,
+    }
+    path = out / f"perf-lab-{args.build}.json"
+    path.write_text(json.dumps(report, indent=2))
+
+    print(f"📊 Performance lab for {args.build}")
+    for name, metric in metrics.items():
+        print(f"   {name}: {median(metric['samples']):.4g} {metric['unit']} "
+              f"(median of {len(metric['samples'])})")
+    skipped = results / "skipped"
+    if skipped.exists():
+        for line in skipped.read_text().splitlines():
+            print(f"   ⚠️  Skipped {line}")
+    print(f"   Results: {path}")
+
+    if args.baseline:
+        baseline = json.loads(Path(args.baseline).read_text())
+        if baseline.get("kvm") != report["kvm"]:
+            print("⚠️  Baseline and this run differ in KVM use; the comparison is meaningless")
+        regressions, improvements, not_compared = compare(
+            metrics, baseline["metrics"], args.threshold, args.alpha, args.min_samples)
+        for line in not_compared:
+            print(f"⚠️  Not compared, {line}")
+        if improvements:
+            print("✓ Improved:")
+            for line in improvements:
+                print(f"   {line}")
+        if regressions:
+            print("❌ Performance regressed:")
+            for line in regressions:
+                print(f"   {line}")
+            return 1
+        print("✅ No performance regressions against baseline")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,175 @@
+#!/bin/bash
+
+# Aurora OS Performance Lab
+# Boots an ISO's kernel in QEMU with the Aurora AI modules, runs the hook,
+# scheduler, perf bench, IO and network suites inside it, boots it a few
+# more times for the boot suite, and checks everything against a stored
+# baseline with tools/perf_lab.py
+#
+# Usage: tools/perf_lab.sh [ISO] [BASELINE_RESULTS]
+
+set -e
+
+ISO_FILE="${1:-aurora-os-complete-with-pytorch.iso}"
+BASELINE="${2:-${PERF_LAB_BASELINE:-}}"
+OUT_DIR="${PERF_LAB_DIR:-build/perf-lab}"
+RUNS="${PERF_LAB_RUNS:-7}"
+BOOTS="${PERF_LAB_BOOTS:-7}"
+SETTLE="${PERF_LAB_SETTLE:-30}"
+DURATION="${PERF_LAB_DURATION:-10}"
+BOOT_TIMEOUT="${BOOT_PROFILE_TIMEOUT:-180}"
+LAB_TIMEOUT="${PERF_LAB_TIMEOUT:-3600}"
+BUILD_ID="$(cat VERSION 2>/dev/null || echo unknown)-$(git rev-parse --short HEAD 2>/dev/null || echo local)"
+TOOLS_DIR="$(dirname "$0")"
+END_MARKER="=== aurora perf lab end ==="
+
+# As for boot_profile.sh; each boot adds aurora.perf_lab for the daemon
+PROFILE_ARGS="initcall_debug aurora.boot_profile log_buf_len=8M loglevel=4 console=ttyS0,115200"
+
+echo "╔══════════════════════════════════════════════╗"
+echo "║   Aurora OS Performance Lab                  ║"
+echo "╚══════════════════════════════════════════════╝"
+echo ""
+
+if [ ! -f "$ISO_FILE" ]; then
+    echo "❌ ERROR: $ISO_FILE not found"
+    exit 1
+fi
+
+if ! command -v qemu-system-x86_64 &> /dev/null; then
+    echo "❌ ERROR: QEMU not installed (sudo apt-get install qemu-system-x86)"
+    exit 1
+fi
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+SHARE="$WORK_DIR/share"
+mkdir -p "$SHARE/bin" "$SHARE/modules"
+
+extract() {
+    if command -v xorriso &> /dev/null; then
+        xorriso -osirrox on -indev "$ISO_FILE" -extract "$1" "$2" &> /dev/null
+    else
+        bsdtar -xOf "$ISO_FILE" "${1#/}" > "$2"
+    fi
+}
+
+extract /boot/grub/grub.cfg "$WORK_DIR/grub.cfg"
+KERNEL_PATH="$(awk '$1 == "linux" { print $2; exit }' "$WORK_DIR/grub.cfg")"
+INITRD_PATH="$(awk '$1 == "initrd" { print $2; exit }' "$WORK_DIR/grub.cfg")"
+CMDLINE="$(awk '$1 == "linux" { $1 = ""; $2 = ""; print; exit }' "$WORK_DIR/grub.cfg")"
+
+if [ -z "$KERNEL_PATH" ]; then
+    echo "❌ ERROR: No linux entry in the ISO's grub.cfg"
+    exit 1
+fi
+
+extract "$KERNEL_PATH" "$WORK_DIR/vmlinuz"
+INITRD_OPT=()
+if [ -n "$INITRD_PATH" ]; then
+    extract "$INITRD_PATH" "$WORK_DIR/initrd"
+    INITRD_OPT=(-initrd "$WORK_DIR/initrd")
+fi
+
+KVM_OPT=()
+KVM=1
+if [ -w /dev/kvm ]; then
+    KVM_OPT=(-enable-kvm -cpu host)
+else
+    KVM=0
+    echo "⚠️  No KVM: timings are from TCG emulation, compare only like with like"
+fi
+
+# Static, so they run whatever the image's libc is
+echo "Building benchmarks..."
+BENCH_SRC=kernel/ai_extensions/bench
+${CC:-cc} -O2 -Wall -Wextra -static -pthread -o "$SHARE/bin/aurora_sched_bench" \
+    "$BENCH_SRC/aurora_sched_bench.c"
+${CC:-cc} -O2 -Wall -Wextra -static -o "$SHARE/bin/aurora_hooks_bench" \
+    "$BENCH_SRC/aurora_hooks_bench.c"
+
+# The tree's perf knows the aurora tracepoints; fall back to the image's
+if [ -x kernel/linux-6.1/tools/perf/perf ]; then
+    cp kernel/linux-6.1/tools/perf/perf "$SHARE/bin/"
+fi
+
+# Modules from make build-kernel; without them the image's own are used
+if ls "build/kernel/"*.ko &> /dev/null; then
+    cp build/kernel/*.ko "$SHARE/modules/"
+else
+    echo "⚠️  No modules in build/kernel, using the image's"
+fi
+
+cp "$TOOLS_DIR/perf_lab_guest.sh" "$SHARE/"
+cat > "$SHARE/lab.conf" << EOF
+RUNS=$RUNS
+SETTLE=$SETTLE
+DURATION=$DURATION
+EOF
+
+# Raw and uncached, so the IO suite measures the block stack and not the
+# host's page cache; written out, since reads of holes never reach a disk
+dd if=/dev/zero of="$WORK_DIR/scratch.img" bs=1M count=1024 status=none
+
+mkdir -p "$OUT_DIR/boots"
+rm -f "$OUT_DIR/boots/boot-$BUILD_ID-"*
+
+echo "✓ Build: $BUILD_ID"
+echo "  Kernel: $KERNEL_PATH"
+echo "  Runs per suite: $RUNS, boots: $BOOTS"
+echo ""
+
+# boot N MODE TIMEOUT: one VM run, serial log in $OUT_DIR/boots
+boot() {
+    local log="$OUT_DIR/boots/boot-$BUILD_ID-$1.log"
+    : > "$log"
+
+    qemu-system-x86_64 \
+        "${KVM_OPT[@]}" \
+        -cdrom "$ISO_FILE" \
+        -kernel "$WORK_DIR/vmlinuz" \
+        "${INITRD_OPT[@]}" \
+        -append "$CMDLINE $PROFILE_ARGS $2" \
+        -m 4G \
+        -smp 4 \
+        -drive file="$WORK_DIR/scratch.img",if=virtio,format=raw,cache=none \
+        -virtfs local,path="$SHARE",mount_tag=aurora_perf_lab,security_model=none,id=perflab \
+        -serial file:"$log" \
+        -display none \
+        -no-reboot &
+    local qemu_pid=$!
+
+    # The guest powers off after the end marker; the timeout is for hangs
+    for _ in $(seq "$3"); do
+        if ! kill -0 "$qemu_pid" 2> /dev/null; then
+            break
+        fi
+        sleep 1
+    done
+    kill "$qemu_pid" 2> /dev/null || true
+    wait "$qemu_pid" 2> /dev/null || true
+
+    if ! grep -q "$END_MARKER" "$log"; then
+        echo "❌ ERROR: Run $1 did not finish, see $log"
+        exit 1
+    fi
+
+    python3 "$TOOLS_DIR/boot_profile.py" "$log" \
+        --build "$BUILD_ID-$1" --output "$OUT_DIR/boots" > /dev/null
+}
+
+echo "Running the suites (up to ${LAB_TIMEOUT}s)..."
+boot 1 aurora.perf_lab "$LAB_TIMEOUT"
+
+echo "Boot suite ($BOOTS boots)..."
+for i in $(seq 2 "$BOOTS"); do
+    boot "$i" aurora.perf_lab=boot "$BOOT_TIMEOUT"
+done
+
+rm -rf "$OUT_DIR/results-$BUILD_ID"
+cp -r "$SHARE/results" "$OUT_DIR/results-$BUILD_ID"
+
+echo ""
+python3 "$TOOLS_DIR/perf_lab.py" "$OUT_DIR/results-$BUILD_ID" \
+    --boots "$OUT_DIR/boots" --build "$BUILD_ID" --kvm "$KVM" \
+    --output "$OUT_DIR" ${BASELINE:+--baseline "$BASELINE"}
@@ -0,0 +1,104 @@
+#!/bin/sh
+
+# Aurora OS Performance Lab, guest side
+# Run by the daemon's PerfLab hook from the 9p share tools/perf_lab.sh
+# sets up; writes the raw output of every suite to results/ on the share
+# and powers the VM off. Suites whose tools the image lacks are skipped
+# and listed in results/skipped.
+#
+# Usage: perf_lab_guest.sh SHARE_DIR
+
+LAB="${1:-/run/aurora-perf-lab}"
+RESULTS="$LAB/results"
+END_MARKER="=== aurora perf lab end ==="
+
+# RUNS, SETTLE and DURATION, written by the host
+. "$LAB/lab.conf"
+
+say() {
+    echo "aurora_perf_lab: $*" > /dev/console
+}
+
+skip() {
+    say "skipping $1: $2"
+    echo "$1: $2" >> "$RESULTS/skipped"
+}
+
+finish() {
+    sync
+    echo "$END_MARKER" > /dev/console
+    echo o > /proc/sysrq-trigger
+    exit 0
+}
+
+# Boot-only runs just add a sample to the boot suite
+if grep -q "aurora.perf_lab=boot" /proc/cmdline; then
+    finish
+fi
+
+mkdir -p "$RESULTS"
+PATH="$LAB/bin:$PATH"
+
+# aurora_core first, the others register with it
+for module in aurora_core ai_security ai_context_manager ai_scheduler; do
+    grep -q "^$module " /proc/modules && continue
+    if [ -f "$LAB/modules/$module.ko" ]; then
+        insmod "$LAB/modules/$module.ko" || say "insmod $module failed"
+    else
+        modprobe "$module" || say "modprobe $module failed"
+    fi
+done
+cut -d' ' -f1 /proc/modules > "$RESULTS/modules"
+uname -r > "$RESULTS/kernel"
+
+# Let the daemon's deferred components finish loading behind us
+sleep "$SETTLE"
+
+say "hooks"
+aurora_hooks_bench --runs "$RUNS" > "$RESULTS/hooks.json"
+
+say "sched"
+for i in $(seq "$RUNS"); do
+    aurora_sched_bench --duration "$DURATION" > "$RESULTS/sched-$i.txt"
+done
+
+if command -v perf > /dev/null; then
+    say "perf bench"
+    for i in $(seq "$RUNS"); do
+        perf bench -f simple sched messaging > "$RESULTS/perf-messaging-$i.txt"
+        perf bench -f simple sched pipe > "$RESULTS/perf-pipe-$i.txt"
+    done
+else
+    skip perf "no perf in the image or the share"
+fi
+
+# The scratch disk is the only virtio-blk device
+if ! command -v fio > /dev/null; then
+    skip io "no fio"
+elif [ ! -b /dev/vda ]; then
+    skip io "no scratch disk at /dev/vda"
+else
+    say "io"
+    for i in $(seq "$RUNS"); do
+        fio --name=randread --filename=/dev/vda --direct=1 --rw=randread \
+            --bs=4k --iodepth=32 --ioengine=io_uring --runtime="$DURATION" \
+            --time_based --output-format=json > "$RESULTS/io-$i.json"
+    done
+fi
+
+# Loopback TCP: the protocol stack and the hooks on it, without the
+# host NIC's noise
+if command -v iperf3 > /dev/null; then
+    say "net"
+    iperf3 -s -D -I "$RESULTS/iperf3.pid"
+    sleep 1
+    for i in $(seq "$RUNS"); do
+        iperf3 -c 127.0.0.1 -t "$DURATION" -J > "$RESULTS/net-$i.json"
+    done
+    kill "$(cat "$RESULTS/iperf3.pid")" 2> /dev/null
+    rm -f "$RESULTS/iperf3.pid"
+else
+    skip net "no iperf3"
+fi
+
+finish